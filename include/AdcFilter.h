@@ -0,0 +1,120 @@
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Fixed-point filter chain between the raw ADC codes and the calibration.
+ *
+ * Three stages, each of which can be bypassed:
+ * - median of 3 or 5 consecutive codes (sorting network), rejects isolated spikes
+ * - CIC decimator of order 1 to 3 and a power-of-two ratio up to 16: integrators at
+ *   the input rate, combs at the output rate, gain removed with a shift. The
+ *   integrators wrap around in 32 bits, which the combs undo exactly.
+ * - first-order IIR smoother, y += (x - y) / 2^shift
+ *
+ * Outputs are codes with FRACTION_BITS fractional bits, so the resolution gained by
+ * the decimation is kept (see CalibrationTable::lookupFraction()).
+ *
+ * process() works on blocks: the median runs branch-free over the whole block
+ * (min/max only, laid out for the compiler to vectorize), then the recursive CIC and
+ * IIR stages run per sample on integers. push() filters a single code. Not
+ * thread-safe; no allocation.
+ */
+class AdcFilter {
+public:
+    static const int FRACTION_BITS = 8;         // Output codes are Q8
+    static const size_t BLOCK = 64;             // Codes per median pass
+    static const uint8_t MAX_MEDIAN = 5;
+    static const uint8_t MAX_DECIMATION = 16;
+    static const uint8_t MAX_CIC_ORDER = 3;
+    static const uint8_t MAX_SMOOTHING_SHIFT = 8;
+    static const int32_t SPIKE_CODES = 32;      // Median correction counted as a spike (~125 mV)
+
+    struct Config {
+        uint8_t medianSize;      // 1 (off), 3 or 5 codes
+        uint8_t decimation;      // 1 (off), 2, 4, 8 or 16
+        uint8_t cicOrder;        // 1 to 3 integrator/comb pairs
+        uint8_t smoothingShift;  // 0 (off) to 8: smoothing weight 1/2^shift
+    };
+
+    static const Config DEFAULT_CONFIG;      // Continuous mode: median 3, CIC 2 / 4 (860 -> 215 SPS), 1/4 smoothing
+    static const Config SINGLE_SHOT_CONFIG;  // Few slow samples: spike rejection only
+    static const Config PASS_THROUGH;        // No filtering
+
+private:
+    Config config_;                                 // Active configuration
+    int decimationShift_;                           // log2(decimation)
+    int16_t history_[MAX_MEDIAN - 1];               // Last codes of the previous block (median window)
+    bool historyValid_;                             // history_ holds codes since reset()
+    int32_t integrators_[MAX_CIC_ORDER];            // CIC integrators (wrap-around)
+    int32_t combs_[MAX_CIC_ORDER];                  // CIC comb delays
+    uint8_t phase_;                                 // Inputs since the last CIC output
+    uint8_t warmup_;                                // CIC outputs still to skip after reset()
+    int32_t smoothed_;                              // IIR state (Q8)
+    bool primed_;                                   // IIR state holds a value
+    uint32_t spikes_;                               // Codes moved by more than SPIKE_CODES by the median
+    int16_t window_[BLOCK + MAX_MEDIAN - 1];        // History followed by the block
+    int16_t medians_[BLOCK];                        // Median stage output
+
+    size_t medianBlock(const int16_t* in, size_t count);
+    bool decimate(int16_t code, int32_t& out);
+
+public:
+    /**
+     * @brief Construct a new AdcFilter object
+     * @param config Stage configuration
+     */
+    AdcFilter(const Config& config = DEFAULT_CONFIG);
+
+    /**
+     * @brief Replace the configuration and reset the state
+     * @return false if the configuration is invalid (the previous one is kept)
+     */
+    bool setConfig(const Config& config);
+
+    /**
+     * @brief Active configuration
+     */
+    const Config& config() const;
+
+    /**
+     * @brief Check a configuration
+     */
+    static bool valid(const Config& config);
+
+    /**
+     * @brief Forget the past samples
+     */
+    void reset();
+
+    /**
+     * @brief Filter a block of codes
+     * @param in Raw codes, oldest first
+     * @param count Number of codes
+     * @param out Receives the filtered codes (Q8), at least count / decimation + 1 entries
+     * @return Number of filtered codes written
+     */
+    size_t process(const int16_t* in, size_t count, int32_t* out);
+
+    /**
+     * @brief Filter one code
+     * @param code Raw code
+     * @param out Receives the filtered code (Q8) when one is ready
+     * @return true if out was written
+     */
+    bool push(int16_t code, int32_t& out);
+
+    /**
+     * @brief Output rate for an input rate
+     */
+    uint16_t outputRate(uint16_t inputRate) const;
+
+    /**
+     * @brief Codes moved by more than SPIKE_CODES by the median stage since reset()
+     */
+    uint32_t spikes() const;
+};
+
+#endif // ADC_FILTER_H
@@ -0,0 +1,121 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "AdcSource.h"
+#include "RtosTask.h"
+#include "SpscRing.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#endif
+
+/**
+ * @brief Continuous-mode acquisition into a ring buffer of raw codes.
+ *
+ * A reader context calls service() once per conversion; each call pulls the latest
+ * code from the AdcSource and pushes it into a fixed-size SPSC ring. The consumer
+ * (Anemometer::update()) drains whatever has accumulated.
+ *
+ * On the device, start() creates a high-priority reader task woken either by the
+ * ADS1115 ALERT/RDY pin (when wired) or by a periodic esp_timer at the data rate.
+ * On a host, start() runs a reader thread paced at the source data rate, or
+ * service() can simply be called from a loop (faster than real time).
+ */
+class AdcSampler {
+public:
+    static const size_t RING_SIZE = 2048;  // > 2 s of codes at 860 SPS
+    static const uint8_t READER_PRIORITY = 23; // Just below the FreeRTOS timer task
+
+private:
+    AdcSource& source_;                       // Converter to read from
+    SpscRing<int16_t, RING_SIZE> ring_;       // Raw codes waiting for the consumer
+    std::atomic<uint32_t> samplesAcquired_;   // Codes pushed into the ring
+    std::atomic<uint32_t> readErrors_;        // Failed conversion reads
+    RtosTask task_;                           // Reader task
+    std::atomic<bool> running_;               // Cleared to stop the reader
+    std::atomic<uint16_t> pendingRate_;       // Data rate the reader switches to, 0 if none
+
+#ifdef ARDUINO
+    esp_timer_handle_t timer_;       // Periodic wake-up when ALERT/RDY is not wired
+    int alertPin_;                   // GPIO with the ALERT/RDY interrupt attached, -1 for none
+    static void onTimer(void* arg);
+    static void IRAM_ATTR onAlert(void* arg);
+#endif
+
+    static void readerTask(void* arg);
+
+    /**
+     * @brief Switch the converter to a pending data rate, if any (reader context)
+     */
+    void applyRate();
+
+public:
+    /**
+     * @brief Construct a new AdcSampler object
+     * @param source Converter, already switched to continuous mode
+     * @param core CPU core the reader task is pinned to
+     */
+    AdcSampler(AdcSource& source, int core = 1);
+
+    /**
+     * @brief Stop the sampler: no interrupt or timer keeps a pointer to it
+     */
+    ~AdcSampler();
+
+    /**
+     * @brief Read one conversion and push it into the ring (reader context)
+     * @return true if a code was stored
+     */
+    bool service();
+
+    /**
+     * @brief Move accumulated codes out of the ring (consumer context)
+     * @param out Destination array
+     * @param maxCodes Size of the destination array
+     * @return Number of codes copied
+     */
+    size_t drain(int16_t* out, size_t maxCodes);
+
+    /**
+     * @brief Change the data rate without stopping the acquisition (any context)
+     *
+     * The reader task owns the bus: it restarts the conversions at the new rate (and
+     * re-arms its timer) at its next wake-up. Codes already in the ring keep the
+     * former rate.
+     * @param samplesPerSecond Requested data rate (rounded up by the source)
+     */
+    void setRate(uint16_t samplesPerSecond);
+
+    /**
+     * @brief Number of codes stored since construction
+     */
+    uint32_t samplesAcquired() const;
+
+    /**
+     * @brief Number of codes lost because the consumer fell behind
+     */
+    uint32_t overruns() const;
+
+    /**
+     * @brief Number of failed conversion reads
+     */
+    uint32_t readErrors() const;
+
+    /**
+     * @brief Start the reader task
+     * @param alertPin GPIO connected to ALERT/RDY, or -1 to poll with a timer (device only)
+     * @return true if the task (and timer or interrupt) were created
+     */
+    bool start(int alertPin = -1);
+
+    /**
+     * @brief Stop the reader task, delete its timer or detach its interrupt (on the device
+     *        the task exits at its next wake-up)
+     */
+    void stop();
+};
+
+#endif // ADC_SAMPLER_H
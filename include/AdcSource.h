@@ -0,0 +1,144 @@
+#ifndef ADC_SOURCE_H
+#define ADC_SOURCE_H
+
+#include <stdint.h>
+
+// Nominal scale of the M5Stack Unit VMeter at PGA 2048 (mV per code, before factory calibration)
+constexpr float VMETER_NOMINAL_MILLIVOLTS_PER_CODE = 0.0625f / 0.015918958f;
+
+/**
+ * @brief Scale parameters a converter reads from its own memory (factory calibration)
+ */
+struct AdcCalibration {
+    float resolution;   // mV per code before factory calibration
+    float factor;       // Factory calibration factor
+};
+
+/**
+ * @brief Abstract source of raw ADC conversion codes.
+ *
+ * Implemented by the ADS1115 VMeter backend on the device and by FakeAdcSource
+ * on a Linux host, so the acquisition chain can run without hardware.
+ *
+ * A converter with an input multiplexer can also start single-shot conversions of
+ * one input at a time (startConversion()) and return the result later
+ * (readResult()), which lets ChannelScheduler interleave several inputs.
+ */
+class AdcSource {
+public:
+    virtual ~AdcSource() {}
+
+    /**
+     * @brief Initialize the converter
+     * @return true if the converter answered
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * @brief Switch to single-shot mode at the given data rate
+     * @param samplesPerSecond Requested data rate (rounded up to a supported rate)
+     * @return true on success
+     */
+    virtual bool startSingleShot(uint16_t samplesPerSecond) = 0;
+
+    /**
+     * @brief Switch to continuous-conversion mode at the given data rate
+     * @param samplesPerSecond Requested data rate (rounded up to a supported rate)
+     * @return true on success
+     */
+    virtual bool startContinuous(uint16_t samplesPerSecond) = 0;
+
+    /**
+     * @brief Run one blocking single-shot conversion
+     * @return Raw conversion code
+     */
+    virtual int16_t readSingle() = 0;
+
+    /**
+     * @brief Read the latest conversion in continuous mode
+     * @param code Receives the raw conversion code
+     * @return true if a conversion was read
+     */
+    virtual bool readConversion(int16_t& code) = 0;
+
+    /**
+     * @brief Actual data rate after rounding to a supported rate
+     * @return Samples per second
+     */
+    virtual uint16_t sampleRate() const = 0;
+
+    /**
+     * @brief Signal each conversion on the converter's ready pin, if it has one
+     * @return true if supported and enabled
+     * @note Call after startContinuous().
+     */
+    virtual bool enableConversionReadyPin() {
+        return false;
+    }
+
+    /**
+     * @brief Number of multiplexer inputs startConversion() accepts, 0 without a multiplexer
+     */
+    virtual uint8_t inputCount() const {
+        return 0;
+    }
+
+    /**
+     * @brief Start one single-shot conversion of a multiplexer input and return at once
+     * @param input Multiplexer input, below inputCount()
+     * @return true if the conversion was started
+     * @note Call after startSingleShot(). The result of the previous conversion can
+     * still be read while this one runs.
+     */
+    virtual bool startConversion(uint8_t input) {
+        (void)input;
+        return false;
+    }
+
+    /**
+     * @brief Read the result of the last completed conversion, without starting one
+     * @param code Receives the raw conversion code
+     * @return true if the result was read
+     */
+    virtual bool readResult(int16_t& code) {
+        (void)code;
+        return false;
+    }
+
+    /**
+     * @brief Longest time one conversion can take at the current data rate (us)
+     *
+     * The nominal period plus the ADS1115 tolerance: internal oscillator within 10 %
+     * and about 25 us of power-up before a single-shot conversion.
+     */
+    virtual uint32_t conversionUs() const {
+        uint16_t rate = sampleRate();
+        return rate ? 1100000UL / rate + 25 : 0;
+    }
+
+    /**
+     * @brief Scale from one raw code to millivolts at the sensor input
+     * @return Millivolts per code, factory calibration included
+     */
+    virtual float millivoltsPerCode() const = 0;
+
+    /**
+     * @brief Factory calibration in use, to cache it across boots
+     * @param calibration Receives the calibration
+     * @return false if the converter has none, or begin() has not read it yet
+     */
+    virtual bool getCalibration(AdcCalibration& calibration) const {
+        (void)calibration;
+        return false;
+    }
+
+    /**
+     * @brief Use a cached factory calibration: begin() no longer reads it from the converter
+     * @param calibration Cached calibration, a zero factor to read it again at the next begin()
+     */
+    virtual void setCalibration(const AdcCalibration& calibration) {
+        (void)calibration;
+    }
+};
+
+#endif // ADC_SOURCE_H
@@ -0,0 +1,80 @@
+#ifndef ADS1115_SOURCE_H
+#define ADS1115_SOURCE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "M5_ADS1115.h"
+#include "AdcSource.h"
+
+/**
+ * @brief AdcSource backed by the ADS1115 of the M5Stack Unit VMeter.
+ *
+ * Supports the original single-shot mode and a continuous-conversion mode up to
+ * 860 SPS. When the ADS1115 ALERT/RDY pin is wired to a GPIO, the comparator is
+ * programmed as a conversion-ready signal so readers can be woken per conversion.
+ * The factory calibration is read from the unit EEPROM by begin(), unless a cached
+ * copy was given with setCalibration() (two EEPROM reads saved at boot).
+ * In single-shot mode, startConversion() selects one of the eight multiplexer
+ * settings and starts a conversion with a single register write.
+ */
+class Ads1115Source : public AdcSource {
+private:
+    ADS1115 voltmeter_;          // Voltmeter unit instance
+    TwoWire* wire_;              // I2C bus of the unit
+    uint8_t address_;            // I2C address of the ADS1115
+    uint8_t sdaPin_;             // I2C SDA pin
+    uint8_t sclPin_;             // I2C SCL pin
+    uint16_t sampleRate_;        // Current data rate (SPS)
+    float resolution_;           // mV per code before factory calibration
+    float calibration_factor_;   // Factory calibration read from the unit EEPROM
+    uint16_t singleShotConfig_;  // Config register in single-shot mode, multiplexer and OS bits cleared
+
+    /**
+     * @brief Map a requested rate to the closest supported ADS1115 rate (rounding up)
+     * @param samplesPerSecond Requested data rate
+     * @param rate Receives the ADS1115 rate code
+     * @return Supported data rate in SPS
+     */
+    static uint16_t selectRate(uint16_t samplesPerSecond, ads1115_rate_t& rate);
+
+    /**
+     * @brief Write a 16-bit ADS1115 register
+     */
+    bool writeRegister(uint8_t reg, uint16_t value);
+
+    /**
+     * @brief Read a 16-bit ADS1115 register
+     */
+    bool readRegister(uint8_t reg, uint16_t& value);
+
+public:
+    /**
+     * @brief Construct a new Ads1115Source object
+     * @param wire I2C bus the unit is connected to
+     * @param sdaPin I2C SDA pin
+     * @param sclPin I2C SCL pin
+     */
+    Ads1115Source(TwoWire& wire = Wire1, uint8_t sdaPin = 2, uint8_t sclPin = 1);
+
+    bool begin() override;
+    bool startSingleShot(uint16_t samplesPerSecond) override;
+    bool startContinuous(uint16_t samplesPerSecond) override;
+    int16_t readSingle() override;
+    bool readConversion(int16_t& code) override;
+    uint16_t sampleRate() const override;
+    float millivoltsPerCode() const override;
+    uint8_t inputCount() const override;
+    bool startConversion(uint8_t input) override;
+    bool readResult(int16_t& code) override;
+    bool getCalibration(AdcCalibration& calibration) const override;
+    void setCalibration(const AdcCalibration& calibration) override;
+
+    /**
+     * @brief Program ALERT/RDY as a conversion-ready pulse (continuous mode only)
+     * @return true on success
+     * @note Call after startContinuous(): the library rewrites the config register.
+     */
+    bool enableConversionReadyPin() override;
+};
+
+#endif // ADS1115_SOURCE_H
@@ -1,23 +1,137 @@
 #ifndef ANEMOMETER_H
 #define ANEMOMETER_H
 
-#include <Arduino.h>
-#include "M5_ADS1115.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "AdcFilter.h"
+#include "AdcSource.h"
+#include "AdcSampler.h"
+#include "CalibrationStore.h"
+#include "CalibrationTable.h"
+#include "Clock.h"
 #include "Logger.h"
+#include "SampleRecorder.h"
+#include "SampleStreamer.h"
+#include "TurbulenceAnalyzer.h"
+#include "WindStatistics.h"
+
+/**
+ * @brief How conversions are acquired from the voltmeter
+ */
+enum class AcquisitionMode : uint8_t {
+    SingleShot,   // One blocking conversion per update() (legacy behaviour)
+    Continuous,   // Free-running conversions collected into a ring buffer
+    Replay        // Conversions read from the source as the clock advances (host trace replay)
+};
 
 /**
  * @brief Anemometer class for wind speed measurement using M5Stack Voltmeter Unit.
  *
  * This class reads the voltage from the M5Stack Voltmeter Unit and converts it to wind speed.
+ * In continuous mode the ADS1115 free-runs (up to 860 SPS) and every conversion is kept
+ * in a ring buffer; update() consumes all the codes accumulated since the previous call.
+ * The codes go through an AdcFilter (spike-rejecting median, CIC decimator, IIR
+ * smoother) before the conversion; every filtered sample feeds the rolling
+ * gust/lull/mean statistics and, when one is attached, the turbulence analyzer.
+ * The recorder and the serial streamer still receive every raw code.
+ * Codes are converted with a fixed-point lookup table built once at setup from the
+ * calibration curve and the factory calibration factor (no float math per sample).
+ * The converter and the clock are interfaces (Ads1115Source/ArduinoClock on the
+ * device, FakeAdcSource/SystemClock on a host). In replay mode update() reads from
+ * the source the conversions the data rate puts in the time elapsed on the clock,
+ * and processes them as a continuous-mode drain: with a TraceAdcSource and a
+ * VirtualClock, recorded traces run through the same code faster than real time.
+ *
+ * setup() never waits for the converter: if it does not answer, update() retries
+ * with an exponential backoff and, meanwhile, returns with no samples
+ * (isSensorReady() false), so the rest of the node boots and broadcasts. With a
+ * CalibrationStore, the factory calibration cached at a previous boot gives the
+ * scale at once and spares the converter memory reads.
  */
 class Anemometer {
+public:
+    static const size_t CALIBRATION_TABLE_ENTRIES = 1024;  // Codes tabulated (about 4 V)
+    static constexpr float COEF_CORRECTION = 1.0051f;      // Correction a appliquer / mesures (on the converter scale)
+    static const uint32_t SENSOR_RETRY_FIRST_MS = 500;     // First retry delay when the converter does not answer
+    static const uint32_t SENSOR_RETRY_MAX_MS = 16000;     // Longest retry delay (doubles from the first)
+
 private:
-    ADS1115 voltmeter_;          // Voltmeter unit instance
-    float voltage_;             // Last measured voltage
+    AdcSource& voltmeter_;      // Voltmeter unit (or simulated converter)
+    Clock& clock_;              // Time source for sample timestamps
+    AdcSampler sampler_;        // Continuous-mode reader and ring buffer
+    AcquisitionMode mode_;      // Single-shot or continuous acquisition
+    uint16_t sampleRate_;       // Requested ADS1115 data rate (SPS)
+    int alertPin_;              // GPIO wired to ALERT/RDY, -1 to poll with a timer
+    uint32_t replayUs_;         // Replay mode: clock time of the last conversions read
+    uint64_t replayDue_;        // Replay mode: conversions due, in millionths
+    int16_t codes_[AdcSampler::RING_SIZE]; // Codes drained from the ring by update()
+    int32_t filtered_[AdcSampler::RING_SIZE]; // Filter output of one update() (Q8 codes)
+    AdcFilter filter_;          // Raw code -> filtered code
+    int32_t filteredCode_;      // Last filtered code (Q8)
+    float millivoltsPerCode_;   // Code -> mV scale, factory calibration and correction included
+    CalibrationCurve curve_;    // Active calibration curve (mV -> km/h)
+    CalibrationTable<CALIBRATION_TABLE_ENTRIES> table_; // Code -> mm/s lookup table
     float windSpeed_;           // Last calculated wind speed (m/s)
+    uint32_t samplesProcessed_; // Number of conversions converted to wind speed
+    uint32_t timestampUs_;      // Clock time of the last update (us)
+    WindStatistics statistics_; // Rolling 3 s gust/lull, 10 min mean, min/max
+    SampleRecorder* recorder_;  // Raw sample recording, nullptr when disabled
+    SampleStreamer* streamer_;  // Raw code streaming over serial, nullptr when disabled
+    TurbulenceAnalyzer* analyzer_; // Turbulence spectrum input, nullptr when disabled
+    CalibrationStore* calibrationStore_; // Factory calibration cache, nullptr for none
+    CalibrationSource calibrationSource_; // Where the factory calibration in use came from
+    bool sensorReady_;          // The converter answered and acquisition is running
+    uint32_t sensorAttempts_;   // Converter initialisations tried
+    uint32_t lastAttemptMs_;    // Time of the last attempt
+    uint32_t retryDelayMs_;     // Delay before the next attempt
+    uint32_t sensorReadyMs_;    // Time the converter answered
     static Logger* logger_;     // Pointer to Logger instance for logging (static class member)
-    float resolution_    = 0.0;
-    float calibration_factor_ = 0.0;
+
+    /**
+     * @brief Initialise the converter and start the acquisition mode
+     * @return false if the converter did not answer
+     */
+    bool startSensor();
+
+    /**
+     * @brief Try startSensor() again once the backoff delay has passed
+     * @param now Current time (ms)
+     */
+    void retrySensor(uint32_t now);
+
+    /**
+     * @brief Count one raw ADC code and record it
+     * @param code Raw ADS1115 conversion code
+     * @param timestampMs Acquisition time of the conversion
+     */
+    void processSample(int16_t code, uint32_t timestampMs);
+
+    /**
+     * @brief Convert one filtered code and store it as the latest reading
+     * @param code Filtered code (AdcFilter::FRACTION_BITS fractional bits)
+     * @param timestampMs Acquisition time of the last code it includes
+     */
+    void processFiltered(int32_t code, uint32_t timestampMs);
+
+    /**
+     * @brief Read the conversions due since the previous update() (replay mode)
+     * @param nowUs Current clock time
+     * @return Number of codes stored in codes_
+     */
+    size_t readReplay(uint32_t nowUs);
+
+    /**
+     * @brief Record, filter and convert the codes of one update (continuous and replay modes)
+     * @param count Codes in codes_, oldest first
+     * @param now Time of the last code (ms)
+     * @param nowUs Time of the last code (us)
+     */
+    void processBlock(size_t count, uint32_t now, uint32_t nowUs);
+
+    /**
+     * @brief Give the turbulence analyzer the filter output rate (continuous and replay modes)
+     */
+    void retuneAnalyzer();
     /**
      * @brief Convert voltage to wind speed (m/s)
      * @param voltage Voltage value from voltmeter
@@ -27,22 +141,33 @@ private:
     float voltageToWindSpeed(float voltage);
 
     /**
-     * @brief Get the last measured voltage
-     * @return Voltage in volts
+     * @brief Regenerate the lookup table from curve_ and millivoltsPerCode_, then check it
      */
-    float getVoltage() const;
+    void rebuildCalibrationTable();
 
     /**
-     * @brief Log a message using the class logger
-     * @param message The message to log
+     * @brief Log a message using the class logger (deferred once the logger is async)
+     * @param level Severity
+     * @param format printf-style string literal
+     * @param args Format arguments
      */
-    void log(const String& message);
+    template <typename... Args>
+    void log(LogLevel level, const char* format, Args... args) {
+        if (logger_) {
+            logger_->logf(LogModule::Anemometer, level, format, args...);
+        }
+    }
 
 public:
     /**
      * @brief Construct a new Anemometer object
+     * @param voltmeter Converter the anemometer is wired to
+     * @param clock Time source
+     * @param mode Acquisition mode
+     * @param sampleRate ADS1115 data rate in SPS (8 to 860)
+     * @param alertPin GPIO wired to the ADS1115 ALERT/RDY pin, -1 if not wired
      */
-    Anemometer();
+    Anemometer(AdcSource& voltmeter, Clock& clock, AcquisitionMode mode = AcquisitionMode::Continuous, uint16_t sampleRate = 860, int alertPin = -1);
 
     /**
      * @brief Set the logger instance for the class
@@ -51,21 +176,171 @@ public:
     static void setLogger(Logger& logger);
 
     /**
-     * @brief Initialize the anemometer
+     * @brief Cache the converter factory calibration across boots (call before setup())
+     * @param store Cache, nullptr to read the calibration from the converter at every boot
      */
-    void setup();
+    void setCalibrationStore(CalibrationStore* store);
+
+    /**
+     * @brief Initialize the anemometer, without waiting for the converter
+     * @return true if the converter answered; if not, update() keeps trying
+     */
+    bool setup();
 
     /**
      * @brief Update the voltage and wind speed readings
+     *
+     * In continuous mode, processes every conversion accumulated since the previous call.
+     * While the converter is unavailable, retries it when the backoff delay has passed.
      */
     void update();
 
+    /**
+     * @brief Stop the continuous-mode reader (host only; device readers run forever)
+     *
+     * The codes already in the ring are still returned by the next update().
+     */
+    void stop();
+
+    /**
+     * @brief Check that the converter answered and acquisition is running
+     * @return false while the readings are not measurements
+     */
+    bool isSensorReady() const;
+
+    /**
+     * @brief Get the number of converter initialisations tried (1 if it answered at setup)
+     */
+    uint32_t getSensorAttempts() const;
+
+    /**
+     * @brief Get the time the converter answered
+     * @return Clock time in ms, 0 while it has not
+     */
+    uint32_t getSensorReadyMs() const;
+
+    /**
+     * @brief Get where the factory calibration in use came from
+     */
+    CalibrationSource getCalibrationSource() const;
+
+    /**
+     * @brief Get the number of conversions processed since setup
+     * @return Sample count
+     */
+    uint32_t getSamplesProcessed() const;
+
+    /**
+     * @brief Get the number of conversions lost because update() was called too late
+     * @return Overrun count
+     */
+    uint32_t getOverruns() const;
+
+
+    /**
+     * @brief Replace the calibration curve (e.g. with a per-device curve)
+     * @param millivolts Abscissae in mV, strictly increasing
+     * @param kmh Wind speed at each abscissa in km/h
+     * @param size Number of points (2 to CalibrationCurve::MAX_POINTS)
+     * @return false if the curve is rejected (the previous curve is kept)
+     */
+    bool loadCalibrationCurve(const float* millivolts, const float* kmh, size_t size);
+
+    /**
+     * @brief Replace the filter configuration (restarts the filter)
+     *
+     * Call it from the context that calls update(); the turbulence analyzer follows
+     * the new output rate.
+     * @param config Filter stages
+     * @return false if the configuration is invalid (the previous one is kept)
+     */
+    bool setFilter(const AdcFilter::Config& config);
+
+    /**
+     * @brief Change the converter data rate without stopping the acquisition
+     *
+     * Call it from the context that calls update(). In continuous mode the reader
+     * task switches the converter at its next wake-up: the codes already in the
+     * ring were converted at the former rate. The turbulence analyzer follows the
+     * new filter output rate. Before the converter answered, the rate is only
+     * stored for the next attempt.
+     * @param rate Data rate (SPS), 8 to 860, rounded up to a supported rate
+     * @return false if the rate is out of range (nothing changes)
+     */
+    bool setSampleRate(uint16_t rate);
+
+    /**
+     * @brief Get the requested converter data rate (SPS)
+     */
+    uint16_t getSampleRate() const;
+
+    /**
+     * @brief Get the filter, for its configuration and spike count
+     */
+    const AdcFilter& getFilter() const;
+
+    /**
+     * @brief Get the last measured voltage
+     * @return Voltage in volts
+     */
+    float getVoltage() const;
 
     /**
      * @brief Get the last calculated wind speed
      * @return Wind speed in m/s
      */
     float getWindSpeed() const;
+
+    /**
+     * @brief Get the acquisition time of the last update
+     * @return Clock time (us) the newest conversion was read, within one conversion period
+     */
+    uint32_t getTimestampUs() const;
+
+    /**
+     * @brief Record every processed sample (call after setup())
+     * @param recorder Started recorder, nullptr to stop recording
+     */
+    void setRecorder(SampleRecorder* recorder);
+
+    /**
+     * @brief Stream every raw code over the serial port (call after setup())
+     * @param streamer Started streamer, nullptr to stop streaming
+     */
+    void setStreamer(SampleStreamer* streamer);
+
+    /**
+     * @brief Feed every filtered wind speed to a turbulence analyzer (call after setup())
+     * @param analyzer Analyzer, nullptr to stop; in continuous mode its input rate is set
+     *        to the filter output rate, in single-shot mode the caller sets it (one sample
+     *        per update())
+     */
+    void setAnalyzer(TurbulenceAnalyzer* analyzer);
+
+    /**
+     * @brief Get the code -> mV scale in use (factory calibration and correction included)
+     */
+    float getMillivoltsPerCode() const;
+
+    /**
+     * @brief Get the active calibration curve
+     */
+    const CalibrationCurve& getCalibrationCurve() const;
+
+    /**
+     * @brief Compare the lookup table with the float path (voltageToWindSpeed())
+     * @param firstCode First code compared (the table range and its surroundings by default)
+     * @param lastCode Last code compared
+     * @return Largest difference in mm/s
+     */
+    int32_t verifyCalibrationTable(int32_t firstCode = -64,
+                                   int32_t lastCode = static_cast<int32_t>(CALIBRATION_TABLE_ENTRIES) + 63);
+
+    /**
+     * @brief Get the rolling wind statistics
+     * @return Gust, lull, mean and min/max over the reporting window
+     */
+    WindStats getStatistics() const;
 };
 
 #endif // ANEMOMETER_H
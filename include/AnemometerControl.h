@@ -0,0 +1,79 @@
+#ifndef ANEMOMETER_CONTROL_H
+#define ANEMOMETER_CONTROL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "AdcFilter.h"
+#include "Anemometer.h"
+#include "Clock.h"
+#include "Communication.h"
+#include "ControlChannel.h"
+#include "Logger.h"
+#include "SpscRing.h"
+
+/**
+ * @brief The control channel target of the anemometer node.
+ *
+ * Settings are checked as a whole before anything changes. The transmit policy and
+ * the log levels belong to the context that handles the commands (the sending
+ * task, through Communication) and change at once. The sampling rate and the
+ * filter belong to the producer: they are handed over through a wait-free queue and
+ * applied together by applyPending(), between two Anemometer::update(), so the
+ * acquisition is never locked or stopped and never sees one without the other.
+ */
+class AnemometerControl : public ControlTarget {
+public:
+    static const size_t QUEUE_SIZE = 4;                 // Acquisition changes waiting for the producer
+    static const uint32_t MAX_HEARTBEAT_MS = 600000;    // Longest heartbeat accepted (a silent node looks dead)
+
+private:
+    struct AcquisitionChange {
+        uint8_t groups;              // SET_SAMPLING and/or SET_FILTER
+        uint16_t sampleRate;
+        AdcFilter::Config filter;
+    };
+
+    Anemometer& anemometer_;         // Producer side
+    Communication& comm_;            // Transmit policy and radio counters
+    Logger& logger_;                 // Log levels
+    Clock& clock_;                   // Uptime
+    DeviceSettings settings_;        // Settings in force, acquisition changes possibly still queued
+    SpscRing<AcquisitionChange, QUEUE_SIZE> changes_; // Command context -> producer
+    std::atomic<uint32_t> applied_;  // Acquisition changes applied by the producer
+
+public:
+    /**
+     * @brief Construct a new AnemometerControl object
+     */
+    AnemometerControl(Anemometer& anemometer, Communication& comm, Logger& logger, Clock& clock);
+
+    /**
+     * @brief Read the settings in force (after the anemometer and the policy are set up)
+     */
+    void begin();
+
+    /**
+     * @brief Check the groups of a settings change
+     * @return STATUS_OK or STATUS_INVALID
+     */
+    static uint8_t validate(const DeviceSettings& settings, uint8_t groups);
+
+    void getSettings(DeviceSettings& settings) override;
+    uint8_t applySettings(const DeviceSettings& settings, uint8_t groups) override;
+    void getStats(DeviceStats& stats) override;
+    void resetCounters() override;
+
+    /**
+     * @brief Apply the queued sampling and filter changes (producer context, before update())
+     * @return true if a change was applied
+     */
+    bool applyPending();
+
+    /**
+     * @brief Acquisition changes applied by the producer
+     */
+    uint32_t appliedChanges() const;
+};
+
+#endif // ANEMOMETER_CONTROL_H
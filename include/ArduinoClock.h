@@ -0,0 +1,18 @@
+#ifndef ARDUINO_CLOCK_H
+#define ARDUINO_CLOCK_H
+
+#include <Arduino.h>
+#include "Clock.h"
+
+/**
+ * @brief Clock backed by the Arduino millis()/micros()/delay()
+ */
+class ArduinoClock : public Clock {
+public:
+    uint32_t millis() override;
+    uint32_t micros() override;
+    void delayMs(uint32_t ms) override;
+    void delayUs(uint32_t us) override;
+};
+
+#endif // ARDUINO_CLOCK_H
@@ -0,0 +1,54 @@
+#ifndef BLOCK_STORAGE_H
+#define BLOCK_STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Abstract file storage for sequential, sector-sized writes
+ * (SD card on the device, a directory on a host).
+ *
+ * One file is open at a time. Files are pre-allocated when opened, so later writes
+ * only fill clusters that already exist and never extend the FAT chain.
+ */
+class BlockStorage {
+public:
+    virtual ~BlockStorage() {}
+
+    /**
+     * @brief Mount the storage
+     * @return true if the medium is usable
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * @brief Check whether a file exists
+     */
+    virtual bool exists(const char* path) = 0;
+
+    /**
+     * @brief Create (or truncate) a file, pre-allocate it and rewind to its start
+     * @param path File name
+     * @param size Bytes to pre-allocate
+     * @return true on success
+     */
+    virtual bool open(const char* path, uint32_t size) = 0;
+
+    /**
+     * @brief Write at the current position of the open file
+     * @return true if all bytes were written
+     */
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Commit written data to the medium (power-loss boundary)
+     */
+    virtual bool sync() = 0;
+
+    /**
+     * @brief Close the open file
+     */
+    virtual void close() = 0;
+};
+
+#endif // BLOCK_STORAGE_H
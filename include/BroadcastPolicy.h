@@ -0,0 +1,135 @@
+#ifndef BROADCAST_POLICY_H
+#define BROADCAST_POLICY_H
+
+#include <stdint.h>
+
+/**
+ * @brief Decides which measurements are worth a broadcast.
+ *
+ * A frame goes out as soon as the wind speed or the gust moved by more than a
+ * deadband since the last frame sent. While changes keep coming, the minimum gap
+ * between frames halves on each event, from rampStartMs down to minIntervalMs (the
+ * capped rate), and doubles back once a gap passes without a change. When the wind
+ * is steady only a heartbeat goes out every heartbeatMs, so receivers can still tell
+ * a quiet station from a lost one. A status change the deadbands cannot see (the
+ * sensor going away or coming back) asks for a frame with requestFrame().
+ *
+ * Counters compare the frames sent with the former fixed schedule (one frame every
+ * fixedIntervalMs). Pure logic, no clock or radio: the caller passes the time.
+ */
+class BroadcastPolicy {
+public:
+    struct Config {
+        float speedDeadband;       // Speed change that triggers a frame (m/s)
+        float gustDeadband;        // Gust change that triggers a frame (m/s)
+        uint32_t minIntervalMs;    // Shortest gap between frames (capped rate)
+        uint32_t rampStartMs;      // Gap allowed after the first change of a quiet spell
+        uint32_t heartbeatMs;      // Longest gap between frames
+        uint32_t fixedIntervalMs;  // Period of the fixed schedule the counters compare with
+    };
+
+    static const Config DEFAULT_CONFIG;   // 1 m/s speed, 0.5 m/s gust, 250 ms..1 s gap, 10 s heartbeat, 2 s reference
+
+    enum class Decision {
+        Hold,       // Nothing worth sending
+        Event,      // Speed or gust left the deadband
+        Heartbeat   // Steady wind, keep-alive frame
+    };
+
+private:
+    Config config_;            // Active configuration
+    bool started_;             // At least one evaluation
+    uint32_t startMs_;         // Time of the first evaluation
+    uint32_t lastEvaluationMs_; // Time of the latest evaluation
+    uint32_t lastSendMs_;      // Time of the last frame sent
+    uint32_t lastRelaxMs_;     // Last send or gap relaxation
+    uint32_t gapMs_;           // Current minimum gap between frames
+    float sentSpeed_;          // Speed of the last frame sent
+    float sentGust_;           // Gust of the last frame sent
+    bool requested_;           // requestFrame() called since the last frame sent
+
+    uint32_t evaluations_;     // Calls to evaluate()
+    uint32_t events_;          // Frames sent on a change
+    uint32_t heartbeats_;      // Frames sent on the heartbeat (first frame included)
+    uint32_t rateLimited_;     // Changes held back by the rate cap
+
+    Decision send(Decision decision, uint32_t nowMs, float speed, float gust);
+
+public:
+    /**
+     * @brief Construct a new BroadcastPolicy object
+     * @param config Deadbands and intervals
+     */
+    BroadcastPolicy(const Config& config = DEFAULT_CONFIG);
+
+    /**
+     * @brief Replace the configuration (inconsistent intervals are raised to fit) and reset
+     */
+    void setConfig(const Config& config);
+
+    /**
+     * @brief Active configuration
+     */
+    const Config& config() const;
+
+    /**
+     * @brief Forget the last frame and clear the counters
+     */
+    void reset();
+
+    /**
+     * @brief Decide whether the current measurement should be broadcast
+     * @param nowMs Time of the measurement (ms, monotonic)
+     * @param speed Wind speed (m/s)
+     * @param gust Wind gust (m/s)
+     * @return Hold, or the reason to send; a non-Hold decision counts as a frame sent
+     */
+    Decision evaluate(uint32_t nowMs, float speed, float gust);
+
+    /**
+     * @brief Send a frame at the next evaluation the rate cap allows, counted as an event
+     */
+    void requestFrame();
+
+    /**
+     * @brief Number of evaluations
+     */
+    uint32_t evaluations() const;
+
+    /**
+     * @brief Frames sent (events + heartbeats)
+     */
+    uint32_t sent() const;
+
+    /**
+     * @brief Frames sent because the speed or gust left the deadband
+     */
+    uint32_t events() const;
+
+    /**
+     * @brief Frames sent as a heartbeat
+     */
+    uint32_t heartbeats() const;
+
+    /**
+     * @brief Changes held back because the previous frame was too recent
+     */
+    uint32_t rateLimited() const;
+
+    /**
+     * @brief Frames the fixed schedule would have sent over the same time
+     */
+    uint32_t fixedScheduleFrames() const;
+
+    /**
+     * @brief Frames saved against the fixed schedule (negative when the wind is busy)
+     */
+    int32_t saved() const;
+
+    /**
+     * @brief Current minimum gap between frames (ms)
+     */
+    uint32_t currentGapMs() const;
+};
+
+#endif // BROADCAST_POLICY_H
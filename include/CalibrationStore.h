@@ -0,0 +1,58 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include "AdcSource.h"
+
+/**
+ * @brief Where the factory calibration in use came from
+ */
+enum class CalibrationSource : uint8_t {
+    None,       // Not read yet: nominal scale
+    Retained,   // Memory kept across deep sleep and soft resets
+    Flash,      // Non-volatile storage, written the first time the converter was read
+    Converter   // Read from the converter at this boot
+};
+
+/**
+ * @brief Name of a calibration source, for the logs
+ */
+inline const char* calibrationSourceName(CalibrationSource source) {
+    switch (source) {
+    case CalibrationSource::Retained:
+        return "retained memory";
+    case CalibrationSource::Flash:
+        return "flash";
+    case CalibrationSource::Converter:
+        return "converter";
+    default:
+        return "none";
+    }
+}
+
+/**
+ * @brief Persistent copy of the converter factory calibration, so a boot does not
+ * have to wait for the converter to read it.
+ *
+ * Implemented with RTC memory and NVS on the device (EspCalibrationStore); host
+ * builds run without one or with an in-memory stand-in.
+ */
+class CalibrationStore {
+public:
+    virtual ~CalibrationStore() {}
+
+    /**
+     * @brief Read the cached calibration
+     * @param calibration Receives the calibration
+     * @param source Receives where it was found (Retained or Flash)
+     * @return false if nothing valid is cached
+     */
+    virtual bool load(AdcCalibration& calibration, CalibrationSource& source) = 0;
+
+    /**
+     * @brief Cache a calibration read from the converter
+     * @return false if it could not be written
+     */
+    virtual bool save(const AdcCalibration& calibration) = 0;
+};
+
+#endif // CALIBRATION_STORE_H
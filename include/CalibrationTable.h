@@ -0,0 +1,194 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Anemometer calibration curve: sensor voltage (mV) -> wind speed (km/h)
+ *
+ * Piecewise linear, extrapolated from the first/last segment outside the points
+ * (same behaviour as calculerY()). Abscissae must be strictly increasing.
+ */
+struct CalibrationCurve {
+    static const size_t MAX_POINTS = 16;
+
+    float millivolts[MAX_POINTS];   // Abscissae (mV), strictly increasing
+    float kmh[MAX_POINTS];          // Wind speed at each abscissa (km/h)
+    size_t size;                    // Number of points used
+
+    /**
+     * @brief Check the point count and that abscissae are strictly increasing
+     */
+    constexpr bool valid() const {
+        if (size < 2 || size > MAX_POINTS) {
+            return false;
+        }
+        for (size_t i = 1; i < size; i++) {
+            if (!(millivolts[i] > millivolts[i - 1])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Interpolate the wind speed (km/h) at a voltage (mV)
+     */
+    constexpr float interpolate(float x) const {
+        size_t i = 0;
+        while (i + 2 < size) {
+            if (x < millivolts[i + 1]) break;
+            i++;
+        }
+        return ((x - millivolts[i]) * kmh[i + 1] + (millivolts[i + 1] - x) * kmh[i]) /
+               (millivolts[i + 1] - millivolts[i]);
+    }
+};
+
+/**
+ * @brief Lookup table from raw ADC code to wind speed in fixed point (mm/s).
+ *
+ * Entry i holds the wind speed for code i, computed with exactly the float
+ * expression of the legacy path (code * mV/code -> curve -> km/h / 3.6), then
+ * rounded to the nearest mm/s. Codes outside [0, Entries) are extrapolated with
+ * the slope of the first/last segment, like the curve itself, from end points and
+ * slopes kept in Q16 and computed in double: over the whole 16-bit code range the
+ * result stays within 1 mm/s of the curve, and of the float path over the VMeter
+ * input range (far beyond it the float path rounds by more). A lookup is one load
+ * (plus one multiply-add outside the table), with no float operation.
+ *
+ * build() is constexpr, so a table can be generated at compile time for the
+ * nominal VMeter scale and regenerated at setup with the factory calibration.
+ *
+ * @tparam Entries Number of tabulated codes; the last curve point must fall inside
+ */
+template <size_t Entries>
+class CalibrationTable {
+    static_assert(Entries >= 2, "CalibrationTable needs at least two entries");
+
+public:
+    static const int SLOPE_SHIFT = 16;     // Extrapolation slopes are Q16 mm/s per code
+
+private:
+    int32_t table_[Entries];       // Wind speed per code (mm/s)
+    int64_t baseLowQ16_;           // Wind speed at code 0, unrounded (mm/s, Q16)
+    int64_t baseHighQ16_;          // Wind speed at the last entry, unrounded (mm/s, Q16)
+    int32_t slopeLowQ16_;          // Slope below code 0 (mm/s per code, Q16)
+    int32_t slopeHighQ16_;         // Slope above the last entry (mm/s per code, Q16)
+    bool valid_;                   // Table successfully built
+
+    static constexpr int32_t round(float value) {
+        return static_cast<int32_t>(value >= 0.0f ? value + 0.5f : value - 0.5f);
+    }
+
+    static constexpr int32_t speedMm(const CalibrationCurve& curve, float millivolts) {
+        return round(curve.interpolate(millivolts) / 3.6f * 1000.0f);
+    }
+
+    static constexpr int64_t roundWide(double value) {
+        return static_cast<int64_t>(value >= 0.0 ? value + 0.5 : value - 0.5);
+    }
+
+    static constexpr int32_t roundShift(int64_t value) {
+        return static_cast<int32_t>((value + (static_cast<int64_t>(1) << (SLOPE_SHIFT - 1))) >> SLOPE_SHIFT);
+    }
+
+    static constexpr double kmhPerMillivolt(const CalibrationCurve& curve, size_t segment) {
+        return (static_cast<double>(curve.kmh[segment + 1]) - curve.kmh[segment]) /
+               (static_cast<double>(curve.millivolts[segment + 1]) - curve.millivolts[segment]);
+    }
+
+    static constexpr int64_t speedQ16(const CalibrationCurve& curve, size_t segment, double millivolts) {
+        double kmh = curve.kmh[segment] + (millivolts - curve.millivolts[segment]) * kmhPerMillivolt(curve, segment);
+        return roundWide(kmh / 3.6 * 1000.0 * (1 << SLOPE_SHIFT));
+    }
+
+    static constexpr int32_t slopeQ16(const CalibrationCurve& curve, size_t segment, float millivoltsPerCode) {
+        return static_cast<int32_t>(
+            roundWide(kmhPerMillivolt(curve, segment) * millivoltsPerCode / 3.6 * 1000.0 * (1 << SLOPE_SHIFT)));
+    }
+
+public:
+    constexpr CalibrationTable()
+        : table_(), baseLowQ16_(0), baseHighQ16_(0), slopeLowQ16_(0), slopeHighQ16_(0), valid_(false) {}
+
+    constexpr CalibrationTable(const CalibrationCurve& curve, float millivoltsPerCode)
+        : table_(), baseLowQ16_(0), baseHighQ16_(0), slopeLowQ16_(0), slopeHighQ16_(0), valid_(false) {
+        build(curve, millivoltsPerCode);
+    }
+
+    /**
+     * @brief (Re)generate the table
+     * @param curve Calibration curve
+     * @param millivoltsPerCode Scale from code to sensor mV (all calibration factors applied)
+     * @return false if the curve is invalid or does not fit in the table (table left invalid)
+     */
+    constexpr bool build(const CalibrationCurve& curve, float millivoltsPerCode) {
+        valid_ = false;
+        if (!curve.valid() || !(millivoltsPerCode > 0.0f) ||
+            curve.millivolts[curve.size - 1] / millivoltsPerCode > static_cast<float>(Entries - 1)) {
+            return false;
+        }
+        for (size_t code = 0; code < Entries; code++) {
+            table_[code] = speedMm(curve, static_cast<float>(code) * millivoltsPerCode);
+        }
+        size_t last = curve.size - 2;
+        baseLowQ16_ = speedQ16(curve, 0, 0.0);
+        baseHighQ16_ = speedQ16(curve, last, static_cast<double>(Entries - 1) * millivoltsPerCode);
+        slopeLowQ16_ = slopeQ16(curve, 0, millivoltsPerCode);
+        slopeHighQ16_ = slopeQ16(curve, last, millivoltsPerCode);
+        valid_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Wind speed for a raw code
+     * @return Wind speed in mm/s
+     */
+    constexpr int32_t lookup(int16_t code) const {
+        if (code < 0) {
+            return roundShift(baseLowQ16_ + static_cast<int64_t>(code) * slopeLowQ16_);
+        }
+        if (static_cast<size_t>(code) >= Entries) {
+            int32_t excess = code - static_cast<int32_t>(Entries - 1);
+            return roundShift(baseHighQ16_ + static_cast<int64_t>(excess) * slopeHighQ16_);
+        }
+        return table_[code];
+    }
+
+    /**
+     * @brief Wind speed for a fractional code (e.g. the output of a decimating filter)
+     * @param code Code in fixed point with fractionBits fractional bits
+     * @param fractionBits Number of fractional bits of code (< 16)
+     * @return Wind speed in mm/s, linearly interpolated between table entries
+     */
+    constexpr int32_t lookupFraction(int32_t code, int fractionBits) const {
+        int32_t whole = code >> fractionBits;
+        int32_t fraction = code & ((1 << fractionBits) - 1);
+        if (whole < 0 || whole + 1 >= static_cast<int32_t>(Entries)) {
+            int64_t scaled = static_cast<int64_t>(code) << (SLOPE_SHIFT - fractionBits);
+            if (whole < 0) {
+                return roundShift(baseLowQ16_ + ((scaled * slopeLowQ16_) >> SLOPE_SHIFT));
+            }
+            int64_t excess = scaled - (static_cast<int64_t>(Entries - 1) << SLOPE_SHIFT);
+            return roundShift(baseHighQ16_ + ((excess * slopeHighQ16_) >> SLOPE_SHIFT));
+        }
+        int32_t low = table_[whole];
+        int32_t high = table_[whole + 1];
+        return low + (((high - low) * fraction) >> fractionBits);
+    }
+
+    /**
+     * @brief true once build() succeeded
+     */
+    constexpr bool valid() const {
+        return valid_;
+    }
+
+    static constexpr size_t size() {
+        return Entries;
+    }
+};
+
+#endif // CALIBRATION_TABLE_H
@@ -0,0 +1,70 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Off-screen RGB565 drawing surface covering a window of the screen.
+ *
+ * The buffer only holds the window (e.g. one glyph cell or a band of rows), while
+ * drawing calls take screen coordinates and are clipped to the window. A region
+ * larger than the buffer is drawn band by band, re-running the same drawing code
+ * with the window moved down, so no full-screen frame buffer is needed.
+ *
+ * Text uses a built-in 5x7 font (digits, ". -/:" and a few letters), scaled by an
+ * integer factor; a character cell is 6 x 8 pixels at scale 1.
+ */
+class Canvas {
+public:
+    static const int16_t CHAR_WIDTH = 6;
+    static const int16_t CHAR_HEIGHT = 8;
+
+private:
+    uint16_t* pixels_;      // Window contents, row-major
+    size_t capacity_;       // Buffer size in pixels
+    int16_t x_;             // Window position and size on screen
+    int16_t y_;
+    int16_t width_;
+    int16_t height_;
+
+public:
+    /**
+     * @brief Construct a new Canvas object on a caller-provided buffer
+     */
+    Canvas(uint16_t* pixels, size_t capacity);
+
+    /**
+     * @brief Place the window on screen
+     * @return false if w * h exceeds the buffer
+     */
+    bool setWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * @brief Fill a rectangle (screen coordinates, clipped to the window)
+     */
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    /**
+     * @brief Set one pixel (screen coordinates, clipped to the window)
+     */
+    void drawPixel(int16_t x, int16_t y, uint16_t color);
+
+    /**
+     * @brief Draw one character, background included (the whole cell is painted)
+     */
+    void drawChar(int16_t x, int16_t y, char c, uint8_t scale, uint16_t color, uint16_t background);
+
+    /**
+     * @brief Draw a string of character cells
+     */
+    void drawText(int16_t x, int16_t y, const char* text, uint8_t scale, uint16_t color, uint16_t background);
+
+    const uint16_t* pixels() const { return pixels_; }
+    int16_t x() const { return x_; }
+    int16_t y() const { return y_; }
+    int16_t width() const { return width_; }
+    int16_t height() const { return height_; }
+};
+
+#endif // CANVAS_H
@@ -0,0 +1,205 @@
+#ifndef CHANNEL_SCHEDULER_H
+#define CHANNEL_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "AdcSource.h"
+#include "Clock.h"
+#include "RtosTask.h"
+#include "SpscRing.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#endif
+
+/**
+ * @brief One conversion of one channel
+ */
+struct ChannelSample {
+    uint32_t timeUs;   // Middle of the conversion, on the scheduler clock
+    int16_t code;      // Raw conversion code
+};
+
+/**
+ * @brief What to sample on one multiplexer input
+ */
+struct ChannelConfig {
+    const char* name;   // Channel name, for the reports
+    uint8_t input;      // Multiplexer input given to AdcSource::startConversion()
+    uint16_t rate;      // Samples per second wanted
+};
+
+/**
+ * @brief Interleaves single-shot conversions of several multiplexer inputs of one converter.
+ *
+ * Every channel falls due once per 1/rate; the due channel with the earliest
+ * deadline (the first added on a tie) gets the next conversion, and the converter
+ * stays idle while no channel is due. When a conversion ends, service() starts the
+ * next one first and only then reads the finished result: the ADS1115 keeps it in
+ * the conversion register until the new conversion ends, so the multiplexer switch
+ * and the conversion of the next input run during the I2C read instead of after it.
+ *
+ * Each sample is stamped with the middle of its conversion and pushed into the ring
+ * of its channel, drained by the consumer of that channel. A channel delayed by
+ * another one's conversion catches up with back-to-back conversions; one that falls
+ * more than CATCH_UP_PERIODS behind (converter oversubscribed) skips the periods it
+ * missed instead, and they are counted.
+ *
+ * service() runs in one reader context: a task woken by a one-shot esp_timer on the
+ * device (start()), a loop over a VirtualClock on a host. Counters can be read from
+ * any task.
+ */
+class ChannelScheduler {
+public:
+    static const size_t MAX_CHANNELS = 4;        // Channels sharing the converter
+    static const size_t RING_SIZE = 512;         // 0.85 s of samples at 600 SPS
+    static const uint8_t READER_PRIORITY = 23;   // Same as the continuous-mode reader
+    static const uint32_t CATCH_UP_PERIODS = 4;  // Periods a channel may lag before skipping
+
+private:
+    struct Channel {
+        ChannelConfig config;
+        uint32_t periodUs;                      // 1 / rate
+        uint32_t dueUs;                         // Next deadline
+        SpscRing<ChannelSample, RING_SIZE> ring; // Samples waiting for the consumer
+        std::atomic<uint32_t> samples;          // Samples pushed into the ring
+        std::atomic<uint32_t> skipped;          // Periods skipped because the converter was busy
+        std::atomic<uint32_t> maxLatenessUs;    // Worst delay between deadline and conversion start
+    };
+
+    AdcSource& source_;            // Converter, with a multiplexer
+    Clock& clock_;                 // Time stamps and deadlines
+    Channel channels_[MAX_CHANNELS];
+    size_t channelCount_;          // Channels added
+    bool pipelined_;               // Start the next conversion before reading the finished one
+    uint32_t conversionUs_;        // Worst-case conversion time at the converter rate
+    uint32_t halfConversionUs_;    // Nominal half conversion, start to time stamp
+    bool converting_;              // A conversion is running
+    size_t active_;                // Channel of the running conversion
+    uint32_t startUs_;             // Start of the running conversion
+    uint32_t readyUs_;             // Time its result can be read
+    std::atomic<uint32_t> conversions_;  // Conversions started
+    std::atomic<uint32_t> errors_;       // Failed starts and reads
+
+#ifdef ARDUINO
+    RtosTask task_;                // Reader task
+    esp_timer_handle_t timer_;     // One-shot wake-up at the next conversion end or deadline
+    static void onTimer(void* arg);
+    static void readerTask(void* arg);
+#endif
+
+    /**
+     * @brief Due channel with the earliest deadline
+     * @return Channel index, or channelCount_ if none is due
+     */
+    size_t nextDue(uint32_t nowUs) const;
+
+    /**
+     * @brief Start a conversion of a channel and move its deadline
+     */
+    void startChannel(size_t channel, uint32_t nowUs);
+
+    /**
+     * @brief Read the finished conversion and push it into its channel
+     */
+    void collect(size_t channel, uint32_t startUs);
+
+public:
+    /**
+     * @brief Construct a new ChannelScheduler object
+     * @param source Converter with a multiplexer (AdcSource::inputCount() > 0)
+     * @param clock Clock for the time stamps
+     * @param core CPU core the reader task is pinned to (device)
+     */
+    ChannelScheduler(AdcSource& source, Clock& clock, int core = 1);
+
+    /**
+     * @brief Add a channel (before begin())
+     * @return Channel index, -1 if the table is full, the rate is 0 or the input does not exist
+     */
+    int addChannel(const ChannelConfig& config);
+
+    /**
+     * @brief Read the finished conversion before starting the next one (the former, serial sequence)
+     * @param pipelined false to disable the overlap, for comparison
+     */
+    void setPipelined(bool pipelined);
+
+    /**
+     * @brief Switch the converter to single-shot mode and make every channel due now
+     * @param converterRate Converter data rate (SPS); conversions are 1/rate long
+     * @return false if the converter did not answer or has no multiplexer
+     */
+    bool begin(uint16_t converterRate);
+
+    /**
+     * @brief Collect a finished conversion and start the next one (reader context)
+     * @return Microseconds until the next call has work to do
+     */
+    uint32_t service();
+
+    /**
+     * @brief Move the samples of one channel out of its ring (consumer of that channel)
+     * @param channel Channel index
+     * @param out Destination array
+     * @param maxSamples Size of the destination array
+     * @return Number of samples copied, oldest first
+     */
+    size_t drain(size_t channel, ChannelSample* out, size_t maxSamples);
+
+    /**
+     * @brief Number of channels added
+     */
+    size_t channelCount() const;
+
+    /**
+     * @brief Configuration of one channel
+     */
+    const ChannelConfig& config(size_t channel) const;
+
+    /**
+     * @brief Samples pushed into the ring of one channel
+     */
+    uint32_t samples(size_t channel) const;
+
+    /**
+     * @brief Periods one channel skipped because the converter was oversubscribed
+     */
+    uint32_t skipped(size_t channel) const;
+
+    /**
+     * @brief Samples of one channel lost because its consumer fell behind
+     */
+    uint32_t overruns(size_t channel) const;
+
+    /**
+     * @brief Worst delay between a deadline of one channel and its conversion start (us)
+     */
+    uint32_t maxLatenessUs(size_t channel) const;
+
+    /**
+     * @brief Conversions started on all channels
+     */
+    uint32_t conversions() const;
+
+    /**
+     * @brief Conversion starts and result reads that failed
+     */
+    uint32_t errors() const;
+
+    /**
+     * @brief Fraction of the converter time the channel rates ask for (above 1: oversubscribed)
+     */
+    float load() const;
+
+#ifdef ARDUINO
+    /**
+     * @brief Start the reader task and its one-shot timer
+     * @return true if both were created
+     */
+    bool start();
+#endif
+};
+
+#endif // CHANNEL_SCHEDULER_H
@@ -0,0 +1,39 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Abstract time source.
+ *
+ * ArduinoClock on the device, SystemClock (real time) or VirtualClock (manually
+ * advanced) on a Linux host.
+ */
+class Clock {
+public:
+    virtual ~Clock() {}
+
+    /**
+     * @brief Milliseconds since start (wraps after ~49 days)
+     */
+    virtual uint32_t millis() = 0;
+
+    /**
+     * @brief Microseconds since start (wraps after ~71 minutes)
+     */
+    virtual uint32_t micros() = 0;
+
+    /**
+     * @brief Block the caller for a duration
+     * @param ms Duration in milliseconds
+     */
+    virtual void delayMs(uint32_t ms) = 0;
+
+    /**
+     * @brief Block the caller for a short, precise duration (may busy-wait)
+     * @param us Duration in microseconds
+     */
+    virtual void delayUs(uint32_t us) = 0;
+};
+
+#endif // CLOCK_H
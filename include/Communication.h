@@ -1,36 +1,109 @@
 #ifndef COMMUNICATION_H
 #define COMMUNICATION_H
 
-#include <Arduino.h>
-#include <esp_now.h>
-#include <WiFi.h>
+#include "BroadcastPolicy.h"
+#include "Clock.h"
+#include "ControlChannel.h"
 #include "Logger.h"
-
-/**
- * @brief Structure containing anemometer data for broadcast
- */
-typedef struct {
-    int8_t messageType;      // 1 = Boat, 2 = Anemometer
-    char anemometerId[18];   // MAC address as string (format: "AA:BB:CC:DD:EE:FF")
-    uint8_t macAddress[6];   // MAC address of the device
-    uint32_t sequenceNumber; // Sequence number for packet tracking
-    float windSpeed;         // Wind speed value
-    unsigned long timestamp; // Timestamp of the measurement
-} AnemometerData;
+#include "RadioTransport.h"
+#include "SlotScheduler.h"
+#include "SpscRing.h"
+#include "TimeSync.h"
+#include "TransmitEngine.h"
+#include "WireFormat.h"
+#include <atomic>
 
 /**
  * @brief Communication class for ESPNow broadcast
+ *
+ * Frames go through the RadioTransport interface (EspNowTransport on the device,
+ * SimRadio on a host) via a TransmitEngine, which tracks each frame until the
+ * driver reports it sent and refuses new ones while too many are in flight.
+ * offer() applies the adaptive BroadcastPolicy (deadband, capped rate,
+ * heartbeat); broadcast() sends unconditionally. A change of FIELD_NO_SENSOR between
+ * two offers is sent at once, whatever the deadbands.
+ *
+ * With a SlotScheduler attached, every frame waits for this device's TDMA slot.
+ * Frames heard from other anemometers are queued by the receive handler (radio
+ * driver context) and handed to the scheduler from the sending task.
+ *
+ * With a TimeSync attached, the reference node sends a time beacon from offer()
+ * once per second, and followers queue the beacons they hear the same way. Frames
+ * carrying FIELD_TIME have their acquisition time converted to the reference clock,
+ * or the field dropped while the node is not synchronised.
+ *
+ * With summary requests enabled, a MSG_SUMMARY_REQUEST addressed to this device
+ * (or to all) only raises a flag in the receive handler; the sending task polls
+ * summaryRequested() and answers with broadcastSummary().
+ *
+ * With a ControlChannel attached, control commands are copied into a queue by the
+ * receive handler; offer() hands one to the channel per call, when the radio has
+ * room, and broadcasts the signed reply. A lost reply is recovered by sending the
+ * command again with a new counter.
  */
 
 class Communication {
+public:
+    static const size_t OBSERVATION_QUEUE = 32; // Neighbour frames buffered between two offers
+    static const size_t BEACON_QUEUE = 8;       // Time beacons buffered between two offers
+    static const size_t CONTROL_QUEUE = 4;      // Control commands buffered between two offers
+
 private:
+    struct Observation {
+        uint8_t mac[RadioTransport::MAC_SIZE];
+        uint16_t sequence;
+        uint32_t rxUs;
+    };
+
+    struct ReceivedBeacon {
+        TimeBeacon beacon;
+        uint32_t rxUs;
+    };
+
+    struct ReceivedControl {
+        uint8_t frame[WireFormat::CONTROL_HEADER_SIZE + WireFormat::MAX_CONTROL_PAYLOAD + WireFormat::CONTROL_TAG_SIZE];
+        uint8_t length;
+    };
+
     static Logger* logger_; // Static pointer to logger instance
+    RadioTransport& radio_; // Radio used for broadcasting
+    BroadcastPolicy policy_; // Decides which measurements go out through offer()
+    uint16_t sequence_;     // Sequence number of the next frame sent by offer()
+    SlotScheduler* scheduler_; // TDMA slots, nullptr to send immediately
+    Clock& clock_;          // Clock used to wait for the slot and stamp the frames
+    TransmitEngine engine_; // In-flight tracking and delivery statistics
+    SpscRing<Observation, OBSERVATION_QUEUE> observations_; // Neighbour frames for the scheduler
+    TimeSync* timeSync_;    // Reference clock estimate, nullptr without time synchronisation
+    SpscRing<ReceivedBeacon, BEACON_QUEUE> beacons_; // Time beacons for timeSync_
+    bool pendingSample_;    // The frame being sent carries an acquisition time
+    uint32_t pendingSampleUs_; // Its local acquisition time
+    uint32_t sampleLatencyUs_; // Running average acquisition-to-queue latency (1/16 weight)
+    uint32_t maxSampleLatencyUs_; // Worst acquisition-to-queue latency
+    uint8_t statusFields_;  // Status flags (FIELD_NO_SENSOR) of the last data offered
+    bool summaries_;        // Summary requests are answered
+    uint8_t mac_[RadioTransport::MAC_SIZE]; // This device, to recognise the requests for it
+    std::atomic<bool> summaryRequested_; // A request arrived and was not answered yet
+    std::atomic<uint32_t> summaryRequests_; // Requests received for this device
+    ControlChannel* control_; // Command handler, nullptr without the control channel
+    SpscRing<ReceivedControl, CONTROL_QUEUE> controls_; // Commands for control_
+
+    static void onReceive(void* context, const uint8_t source[RadioTransport::MAC_SIZE], const uint8_t* data,
+                          size_t length, uint32_t rxUs);
+    void drainObservations();
+    void drainBeacons();
+    void handleControl();
+    void sendBeacon();
+    bool send(const uint8_t* frame, size_t length);
+    void sleepUntilUs(uint32_t targetUs);
+    void waitForSlot();
 
 public:
     /**
      * @brief Construct a new Communication object
+     * @param radio Radio used for broadcasting
+     * @param clock Clock whose micros() is the radio time base
      */
-    Communication();
+    Communication(RadioTransport& radio, Clock& clock);
 
     /**
      * @brief Set the logger instance for the class
@@ -44,17 +117,139 @@ public:
     void setup();
 
     /**
-     * @brief Log a message using the class logger
-     * @param message The message to log
+     * @brief Log a message using the class logger (deferred once the logger is async)
+     * @param level Severity
+     * @param format printf-style string literal
+     * @param args Format arguments
      */
-    void log(const String& message);
+    template <typename... Args>
+    void log(LogLevel level, const char* format, Args... args) {
+        if (logger_) {
+            logger_->logf(LogModule::Communication, level, format, args...);
+        }
+    }
 
     /**
      * @brief Broadcast anemometer data using ESPNow
-     * @param data Structure containing anemometer ID, MAC address, and wind speed
-     * @return true if broadcast was successful, false otherwise
+     * @param data Structure containing MAC address, sequence number, wind speed and optional fields
+     * @return true if the frame was queued; delivery is reported later to transmitter()
+     * @note The data is encoded with WireFormat (compact v2 frame), not sent as a raw struct.
      */
     bool broadcast(const AnemometerData& data);
+
+    /**
+     * @brief Broadcast the data only if the transmit policy asks for it
+     * @param data Frame content; its sequence number is assigned here, per frame sent
+     * @param nowMs Time of the measurement (ms, monotonic)
+     * @return true if a frame was queued, false if held back, refused (radio busy) or failed
+     * @note Sequence numbers count frames, not measurements, so receivers still see
+     * gaps only for lost frames.
+     */
+    bool offer(AnemometerData& data, uint32_t nowMs);
+
+    /**
+     * @brief Broadcast a hot-path timing summary (MSG_DIAGNOSTICS), in the TDMA slot if any
+     * @param data Summary, filled from Trace by tracing builds
+     * @return true if the frame was queued
+     */
+    bool broadcastDiagnostics(const DiagnosticsData& data);
+
+    /**
+     * @brief Answer the session summary requests of the receivers (call after setup())
+     * @return true if the radio reports received frames, which the requests need
+     */
+    bool enableSummaryRequests();
+
+    /**
+     * @brief A summary request is waiting for broadcastSummary()
+     */
+    bool summaryRequested() const;
+
+    /**
+     * @brief Summary requests received for this device
+     */
+    uint32_t summaryRequests() const;
+
+    /**
+     * @brief Broadcast the session statistics (MSG_SUMMARY), in the TDMA slot if any
+     * @param summary Session statistics; the MAC address is filled here
+     * @return true if the frame was queued, which answers the pending request
+     */
+    bool broadcastSummary(const SessionSummary& summary);
+
+    /**
+     * @brief Execute the control commands received (call after setup())
+     * @param control Command handler, begun with the fleet key and this device's MAC address
+     * @return true if the radio reports received frames, which the commands need
+     */
+    bool setControl(ControlChannel& control);
+
+    /**
+     * @brief Control commands dropped because the queue was full
+     */
+    uint32_t droppedControls() const;
+
+    /**
+     * @brief Clear the policy and delivery counters and the latencies (sending task)
+     * @note The policy forgets the last frame too: the next measurement is sent.
+     */
+    void resetCounters();
+
+    /**
+     * @brief Replace the transmit policy configuration (resets its counters)
+     * @param config Deadbands and intervals
+     */
+    void setPolicy(const BroadcastPolicy::Config& config);
+
+    /**
+     * @brief Transmit policy, for its configuration and counters
+     */
+    const BroadcastPolicy& policy() const;
+
+    /**
+     * @brief Send every frame in a TDMA slot instead of immediately (call after setup())
+     * @param scheduler Slot scheduler, begun with this device's MAC address
+     * @return true if the radio reports received frames, which refine the slot
+     * @note broadcast() then blocks until the slot, at most one superframe (131 ms).
+     */
+    bool setScheduler(SlotScheduler& scheduler);
+
+    /**
+     * @brief Synchronise the measurement times to a reference node (call after setup())
+     * @param timeSync Clock estimate, begun with this device's MAC address and its role
+     * @return true if the radio reports received frames, which followers need
+     */
+    bool setTimeSync(TimeSync& timeSync);
+
+    /**
+     * @brief Clock estimate given to setTimeSync(), nullptr if none
+     */
+    const TimeSync* timeSync() const;
+
+    /**
+     * @brief Running average time from acquisition to the radio queue (us), frames with FIELD_TIME
+     */
+    uint32_t averageSampleLatencyUs() const;
+
+    /**
+     * @brief Worst time from acquisition to the radio queue (us)
+     */
+    uint32_t maxSampleLatencyUs() const;
+
+    /**
+     * @brief Average time from acquisition to the end of the frame on air (us)
+     */
+    uint32_t sampleToAirUs() const;
+
+    /**
+     * @brief Transmit engine, for the delivery statistics
+     */
+    const TransmitEngine& transmitter() const;
+
+    /**
+     * @brief Neighbour frames dropped because the observation queue was full
+     */
+    uint32_t droppedObservations() const;
 };
 
 #endif // COMMUNICATION_H
@@ -0,0 +1,44 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Abstract text/binary console (USB serial on the device, stdio on a host)
+ */
+class Console {
+public:
+    virtual ~Console() {}
+
+    /**
+     * @brief Open the console
+     * @param baudRate Line speed (ignored where meaningless)
+     * @return true if the console is ready
+     */
+    virtual bool begin(uint32_t baudRate) = 0;
+
+    /**
+     * @brief Write text without line ending
+     */
+    virtual void print(const char* text) = 0;
+
+    /**
+     * @brief Write text followed by a line ending
+     */
+    virtual void println(const char* text) = 0;
+
+    /**
+     * @brief Write raw bytes
+     * @return Number of bytes accepted
+     */
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Read one received byte
+     * @return Byte value, or -1 if nothing is available
+     */
+    virtual int read() = 0;
+};
+
+#endif // CONSOLE_H
@@ -0,0 +1,139 @@
+#ifndef CONTROL_CHANNEL_H
+#define CONTROL_CHANNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "SettingsStore.h"
+#include "WireFormat.h"
+
+/**
+ * @brief What the control channel reads and changes on the node
+ */
+class ControlTarget {
+public:
+    virtual ~ControlTarget() {}
+
+    /**
+     * @brief Settings in force (including changes not applied by the acquisition yet)
+     */
+    virtual void getSettings(DeviceSettings& settings) = 0;
+
+    /**
+     * @brief Change some settings, all or none of them
+     * @param settings New values; only the groups given are read
+     * @param groups SET_* mask
+     * @return STATUS_OK, or STATUS_INVALID / STATUS_BUSY with nothing changed
+     */
+    virtual uint8_t applySettings(const DeviceSettings& settings, uint8_t groups) = 0;
+
+    /**
+     * @brief Node counters (the control counters are filled by the channel)
+     */
+    virtual void getStats(DeviceStats& stats) = 0;
+
+    /**
+     * @brief Clear the node counters
+     */
+    virtual void resetCounters() = 0;
+};
+
+/**
+ * @brief Authenticated command handler of the ESP-NOW control channel.
+ *
+ * Commands (WireFormat::MSG_CONTROL) are signed with a fleet key shared by the
+ * anemometers and the operator tool: a frame whose SipHash tag does not match is
+ * dropped without a reply and counted. Each command carries a counter that must be
+ * above every counter accepted before; an older one (a recorded command played
+ * again) is not executed and gets STATUS_STALE with the last counter, so an
+ * honest tool can catch up. The operator tool uses the Unix time in seconds, which
+ * keeps increasing across tool restarts.
+ *
+ * Commands that change something (CMD_SET_SETTINGS, CMD_RESET_COUNTERS) save the
+ * counter and the settings changed over the air in a SettingsStore; begin()
+ * restores both, so the settings survive power cycles and those commands cannot be
+ * replayed after one. Read-only commands do not write the flash: after a power
+ * cycle, a recorded read-only command newer than the last saved counter can be
+ * played again, and only reads.
+ *
+ * The key is never part of the sources: a node built without one does not call
+ * begin() and the channel ignores every frame.
+ *
+ * handle() runs in one context (the sending task, through Communication); the
+ * counters can be read from any task.
+ */
+class ControlChannel {
+private:
+    ControlTarget& target_;   // Node settings and counters
+    SettingsStore* store_;    // Persistent copy, nullptr for none
+    uint8_t key_[WireFormat::CONTROL_KEY_SIZE]; // Fleet key
+    uint8_t mac_[6];          // This node, to recognise the commands for it
+    bool keyed_;              // begin() called: frames are ignored before
+    std::atomic<uint32_t> lastCounter_; // Highest counter accepted
+    uint8_t groups_;          // SET_* groups changed over the air since the first boot
+    std::atomic<uint32_t> commands_;    // Commands accepted
+    std::atomic<uint32_t> rejected_;    // Frames with a bad tag or a stale counter
+    std::atomic<uint32_t> storeErrors_; // Failed writes of the persistent copy
+
+    /**
+     * @brief Save the counter, the groups changed and the settings in force
+     */
+    void persist();
+
+public:
+    /**
+     * @brief Construct a new ControlChannel object
+     * @param target Node settings and counters
+     * @param store Persistent copy of the settings, nullptr to forget them at power off
+     */
+    ControlChannel(ControlTarget& target, SettingsStore* store = nullptr);
+
+    /**
+     * @brief Set the key and the address, restore the saved counter and settings
+     * @param key Fleet key (CONTROL_KEY_SIZE bytes)
+     * @param mac This node's MAC address
+     * @return true if saved settings were found and applied again
+     */
+    bool begin(const uint8_t key[WireFormat::CONTROL_KEY_SIZE], const uint8_t mac[6]);
+
+    /**
+     * @brief Read a fleet key written as hexadecimal
+     * @param hex Exactly 2 * CONTROL_KEY_SIZE hex digits
+     * @param key Receives the key
+     * @return false if the text is not a key, or is the all-zero key
+     */
+    static bool parseKey(const char* hex, uint8_t key[WireFormat::CONTROL_KEY_SIZE]);
+
+    /**
+     * @brief Check and execute one received frame
+     * @param frame Frame bytes
+     * @param length Frame length
+     * @param reply Receives the signed reply (MSG_CONTROL_REPLY)
+     * @param capacity Size of reply, MAX_FRAME_SIZE is enough
+     * @return Reply length, 0 if the frame is ignored (not a command for this node,
+     *         bad tag, begin() not called)
+     */
+    size_t handle(const uint8_t* frame, size_t length, uint8_t* reply, size_t capacity);
+
+    /**
+     * @brief Highest command counter accepted
+     */
+    uint32_t lastCounter() const;
+
+    /**
+     * @brief Commands accepted since boot or the last CMD_RESET_COUNTERS
+     */
+    uint32_t commands() const;
+
+    /**
+     * @brief Frames refused since boot or the last CMD_RESET_COUNTERS (bad tag, stale counter)
+     */
+    uint32_t rejected() const;
+
+    /**
+     * @brief Failed writes of the persistent copy
+     */
+    uint32_t storeErrors() const;
+};
+
+#endif // CONTROL_CHANNEL_H
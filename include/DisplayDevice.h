@@ -0,0 +1,46 @@
+#ifndef DISPLAY_DEVICE_H
+#define DISPLAY_DEVICE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Abstract text display (AtomS3 LCD through M5GFX on the device, simulated on a host)
+ *
+ * Colors are RGB565.
+ */
+class DisplayDevice {
+public:
+    static const uint16_t COLOR_BLACK = 0x0000;
+    static const uint16_t COLOR_WHITE = 0xFFFF;
+
+    virtual ~DisplayDevice() {}
+
+    virtual int16_t width() = 0;
+    virtual int16_t height() = 0;
+    virtual void fillScreen(uint16_t color) = 0;
+    virtual void setTextSize(uint8_t size) = 0;
+    virtual void setTextColor(uint16_t color) = 0;
+    virtual void setCursor(int16_t x, int16_t y) = 0;
+    virtual void print(const char* text) = 0;
+    virtual void println(const char* text) = 0;
+
+    /**
+     * @brief Width in pixels of a text at the current text size
+     */
+    virtual int16_t textWidth(const char* text) = 0;
+
+    /**
+     * @brief Copy a block of RGB565 pixels (row-major, w * h) to the screen
+     *
+     * May return before the transfer ends (DMA): the pixels must stay untouched until
+     * the next pushImage() or waitPush() returns.
+     */
+    virtual void pushImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) = 0;
+
+    /**
+     * @brief Wait for the last pushImage() transfer to complete
+     */
+    virtual void waitPush() {}
+};
+
+#endif // DISPLAY_DEVICE_H
@@ -0,0 +1,127 @@
+#ifndef DISPLAY_RENDERER_H
+#define DISPLAY_RENDERER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Canvas.h"
+#include "Clock.h"
+#include "DisplayDevice.h"
+
+/**
+ * @brief Wind screen renderer that only pushes what changed.
+ *
+ * Layout (AtomS3, 128 x 128): wind speed in large digits, "m/s", gust and lull,
+ * and a scrolling sparkline of speed (bars) and gust (dots) at the bottom.
+ *
+ * Text fields are fixed-width rows of character cells. Each frame compares the new
+ * text with what is on screen and redraws only the cells whose character changed:
+ * a cell is drawn into a small off-screen canvas, then pushed as one rectangle.
+ * The sparkline moves every frame and is pushed in bands. Two staging buffers
+ * alternate, so with a DMA-capable display the next block is drawn while the
+ * previous one is still being sent. Nothing ever clears the whole screen after
+ * the first frame.
+ *
+ * Frame time and bytes pushed are kept per frame to check the savings against a
+ * full repaint (FULL_FRAME_BYTES).
+ */
+class DisplayRenderer {
+public:
+    static const int16_t SCREEN_SIZE = 128;
+    static const size_t SPARKLINE_POINTS = 128;         // One column per frame
+    static const size_t STAGING_PIXELS = 1024;          // Per staging buffer (2 KB)
+    static const uint32_t FULL_FRAME_BYTES = SCREEN_SIZE * SCREEN_SIZE * 2;
+
+    static const uint16_t COLOR_BACKGROUND = DisplayDevice::COLOR_WHITE;
+    static const uint16_t COLOR_TEXT = DisplayDevice::COLOR_BLACK;
+    static const uint16_t COLOR_SPEED = 0x041F;         // Blue
+    static const uint16_t COLOR_GUST = 0xF800;          // Red
+    static const uint16_t COLOR_AXIS = 0xC618;          // Light grey
+
+private:
+    /**
+     * @brief Fixed-width text field: one cell per character
+     */
+    struct TextField {
+        static const size_t MAX_CELLS = 6;
+        int16_t x;
+        int16_t y;
+        uint8_t scale;
+        uint8_t cells;
+        char shown[MAX_CELLS + 1];  // Characters on screen, NUL = unknown
+    };
+
+    DisplayDevice& display_;
+    Clock& clock_;
+    uint16_t staging_[2][STAGING_PIXELS];   // Ping-pong off-screen buffers
+    uint8_t nextStaging_;                   // Buffer to draw the next block into
+
+    TextField speed_;       // "12.3"
+    TextField unit_;        // "m/s" (static)
+    TextField gust_;        // "G12.3"
+    TextField lull_;        // "L 4.5"
+
+    float speedHistory_[SPARKLINE_POINTS];  // Ring of past speeds (m/s)
+    float gustHistory_[SPARKLINE_POINTS];   // Ring of past gusts (m/s)
+    size_t historyHead_;                    // Next slot to write
+    size_t historyCount_;                   // Valid points
+    bool fullRedraw_;                       // Next frame repaints everything
+
+    uint32_t frames_;
+    uint32_t lastFrameUs_;
+    uint32_t maxFrameUs_;
+    uint32_t lastFrameBytes_;
+    uint32_t totalBytes_;
+
+    Canvas nextCanvas();
+    void push(const Canvas& canvas);
+    void updateField(TextField& field, const char* text, uint16_t color);
+    void drawSparkline(Canvas& canvas, float scaleMax);
+
+public:
+    static const int16_t SPARKLINE_Y = 92;
+    static const int16_t SPARKLINE_HEIGHT = SCREEN_SIZE - SPARKLINE_Y;
+
+    /**
+     * @brief Construct a new DisplayRenderer object
+     * @param display Target screen
+     * @param clock Time source for frame timing
+     */
+    DisplayRenderer(DisplayDevice& display, Clock& clock);
+
+    /**
+     * @brief Draw one frame
+     * @param windSpeed Current wind speed (m/s)
+     * @param windGust Gust (m/s)
+     * @param windLull Lull (m/s)
+     */
+    void render(float windSpeed, float windGust, float windLull);
+
+    /**
+     * @brief Repaint the whole screen on the next frame (e.g. after something else drew on it)
+     */
+    void invalidate();
+
+    uint32_t frames() const;
+
+    /**
+     * @brief Duration of the last frame, drawing and pushes included (us)
+     */
+    uint32_t lastFrameUs() const;
+
+    /**
+     * @brief Longest frame so far (us)
+     */
+    uint32_t maxFrameUs() const;
+
+    /**
+     * @brief Pixel bytes sent to the display by the last frame
+     */
+    uint32_t lastFrameBytes() const;
+
+    /**
+     * @brief Mean pixel bytes per frame since construction
+     */
+    uint32_t averageFrameBytes() const;
+};
+
+#endif // DISPLAY_RENDERER_H
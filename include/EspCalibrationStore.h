@@ -0,0 +1,24 @@
+#ifndef ESP_CALIBRATION_STORE_H
+#define ESP_CALIBRATION_STORE_H
+
+#include <Arduino.h>
+#include "CalibrationStore.h"
+
+/**
+ * @brief CalibrationStore backed by the ESP32 RTC memory and NVS.
+ *
+ * load() tries the RTC copy first: it survives deep sleep and soft resets (panic,
+ * watchdog) and costs nothing to read. After a power-on it is garbage, rejected by
+ * its CRC, and the NVS copy is used and copied back to RTC memory. save() writes
+ * both, and leaves the flash alone when NVS already holds the same values.
+ */
+class EspCalibrationStore : public CalibrationStore {
+public:
+    static constexpr const char* NAMESPACE = "anemometer";  // NVS namespace
+    static constexpr const char* KEY = "adc_cal";           // NVS key
+
+    bool load(AdcCalibration& calibration, CalibrationSource& source) override;
+    bool save(const AdcCalibration& calibration) override;
+};
+
+#endif // ESP_CALIBRATION_STORE_H
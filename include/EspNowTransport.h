@@ -0,0 +1,44 @@
+#ifndef ESP_NOW_TRANSPORT_H
+#define ESP_NOW_TRANSPORT_H
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <WiFi.h>
+#include "RadioTransport.h"
+
+/**
+ * @brief RadioTransport backed by ESP-NOW in WiFi station mode
+ *
+ * ESP-NOW is initialized once and the broadcast peer registered once in begin();
+ * unicast peers are registered on their first frame. Send completions and received
+ * frames are forwarded from the WiFi task to the registered handlers. The station
+ * MAC address is read once in begin(); macAddress() then only copies it.
+ */
+class EspNowTransport : public RadioTransport {
+private:
+    // ESP-NOW callbacks carry no context: one transport per device
+    static ReceiveHandler receiveHandler_;
+    static void* receiveContext_;
+    static SendHandler sendHandler_;
+    static void* sendContext_;
+
+    static void onReceive(const uint8_t* mac, const uint8_t* data, int length);
+    static void onSent(const uint8_t* mac, esp_now_send_status_t status);
+
+    uint8_t mac_[MAC_SIZE];     // Station MAC address, read in begin()
+    bool macRead_;              // mac_ is valid
+
+public:
+    EspNowTransport();
+
+    /**
+     * @brief Initializes ESP-NOW and configures WiFi in station mode with maximum power
+     */
+    bool begin() override;
+    SendStatus send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) override;
+    void macAddress(uint8_t mac[MAC_SIZE]) override;
+    bool setReceiveHandler(ReceiveHandler handler, void* context) override;
+    bool setSendHandler(SendHandler handler, void* context) override;
+};
+
+#endif // ESP_NOW_TRANSPORT_H
@@ -0,0 +1,38 @@
+#ifndef ESP_POWER_CONTROL_H
+#define ESP_POWER_CONTROL_H
+
+#include <Arduino.h>
+#include "PowerControl.h"
+
+/**
+ * @brief PowerControl backed by the ESP32 light sleep and WiFi modem sleep.
+ *
+ * Light sleep wakes on the timer and, when the ADS1115 ALERT/RDY pin is wired, on
+ * that pin going low. The pin is level-triggered, so it is only armed while it is
+ * high: a conversion already signalled does not wake the CPU again. micros() keeps
+ * counting through light sleep.
+ */
+class EspPowerControl : public PowerControl {
+private:
+    int alertPin_;              // GPIO wired to ALERT/RDY, -1 if not wired
+
+public:
+    static const uint32_t ALERT_POLL_US = 100; // Pin polling step while idle
+
+    /**
+     * @brief Construct a new EspPowerControl object
+     * @param alertPin GPIO wired to the ADS1115 ALERT/RDY pin, -1 if not wired
+     */
+    EspPowerControl(int alertPin = -1);
+
+    /**
+     * @brief Configure the ALERT pin as a wake-up source
+     * @return true on success
+     */
+    bool begin();
+
+    WakeSource sleep(SleepMode mode, uint32_t durationUs) override;
+    bool setRadioPowerSave(bool enabled) override;
+};
+
+#endif // ESP_POWER_CONTROL_H
@@ -0,0 +1,24 @@
+#ifndef ESP_SESSION_STORE_H
+#define ESP_SESSION_STORE_H
+
+#include <Arduino.h>
+#include "SessionStore.h"
+
+/**
+ * @brief SessionStore backed by the ESP32 RTC memory and NVS.
+ *
+ * Same scheme as EspCalibrationStore: the RTC copy survives deep sleep and soft
+ * resets and is written at every save, the NVS copy survives power cycles and is
+ * written only when asked (an NVS write stalls both cores for milliseconds and
+ * wears the flash). load() prefers the RTC copy, the more recent of the two.
+ */
+class EspSessionStore : public SessionStore {
+public:
+    static constexpr const char* NAMESPACE = "anemometer";  // NVS namespace
+    static constexpr const char* KEY = "session";           // NVS key
+
+    bool load(SessionRecord& record) override;
+    bool save(const SessionRecord& record, bool flash) override;
+};
+
+#endif // ESP_SESSION_STORE_H
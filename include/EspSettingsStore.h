@@ -0,0 +1,22 @@
+#ifndef ESP_SETTINGS_STORE_H
+#define ESP_SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include "SettingsStore.h"
+
+/**
+ * @brief SettingsStore backed by the ESP32 NVS.
+ *
+ * One record with a magic number and a CRC, like EspCalibrationStore. No RTC copy:
+ * the record changes only with the commands, and must survive power cycles.
+ */
+class EspSettingsStore : public SettingsStore {
+public:
+    static constexpr const char* NAMESPACE = "anemometer";  // NVS namespace
+    static constexpr const char* KEY = "control";           // NVS key
+
+    bool load(ControlRecord& record) override;
+    bool save(const ControlRecord& record) override;
+};
+
+#endif // ESP_SETTINGS_STORE_H
@@ -0,0 +1,69 @@
+#ifndef FAKE_ADC_SOURCE_H
+#define FAKE_ADC_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "AdcSource.h"
+
+/**
+ * @brief Synthetic AdcSource for host builds and bench work.
+ *
+ * Produces one new conversion per read: offset + sine wave + pseudo-random noise,
+ * or a user supplied sequence of codes played in a loop. Output is deterministic
+ * for a given seed, so runs are reproducible.
+ */
+class FakeAdcSource : public AdcSource {
+private:
+    uint16_t sampleRate_;        // Simulated data rate (SPS)
+    float millivoltsPerCode_;    // Simulated scale
+    bool continuous_;            // Continuous mode active
+    int16_t offset_;             // Constant part of the signal (codes)
+    int16_t amplitude_;          // Sine amplitude (codes)
+    float periodSeconds_;        // Sine period
+    int16_t noise_;              // Peak noise amplitude (codes)
+    uint32_t seed_;              // Noise generator state
+    const int16_t* sequence_;    // Optional scripted codes (not owned)
+    size_t sequenceLength_;      // Length of the scripted sequence
+    uint32_t index_;             // Number of conversions produced
+
+    int16_t nextCode();
+
+public:
+    /**
+     * @brief Construct a new FakeAdcSource object
+     * @param millivoltsPerCode Scale reported to consumers (VMeter nominal by default)
+     */
+    FakeAdcSource(float millivoltsPerCode = VMETER_NOMINAL_MILLIVOLTS_PER_CODE);
+
+    /**
+     * @brief Configure the synthetic signal
+     * @param offset Constant part (codes)
+     * @param amplitude Sine amplitude (codes)
+     * @param periodSeconds Sine period in seconds of simulated time
+     * @param noise Peak uniform noise (codes)
+     * @param seed Noise seed
+     */
+    void setSignal(int16_t offset, int16_t amplitude, float periodSeconds, int16_t noise, uint32_t seed = 1);
+
+    /**
+     * @brief Replay a fixed sequence of codes in a loop instead of the synthetic signal
+     * @param codes Codes to replay (must outlive the source), nullptr to go back to the signal
+     * @param length Number of codes
+     */
+    void setSequence(const int16_t* codes, size_t length);
+
+    bool begin() override;
+    bool startSingleShot(uint16_t samplesPerSecond) override;
+    bool startContinuous(uint16_t samplesPerSecond) override;
+    int16_t readSingle() override;
+    bool readConversion(int16_t& code) override;
+    uint16_t sampleRate() const override;
+    float millivoltsPerCode() const override;
+
+    /**
+     * @brief Number of conversions produced since begin()
+     */
+    uint32_t conversions() const;
+};
+
+#endif // FAKE_ADC_SOURCE_H
@@ -0,0 +1,40 @@
+#ifndef FILE_BLOCK_STORAGE_H
+#define FILE_BLOCK_STORAGE_H
+
+#include <stdio.h>
+#include "BlockStorage.h"
+
+/**
+ * @brief BlockStorage on a host directory (stand-in for the SD card)
+ *
+ * sync() flushes the stdio buffer, and with durable set also waits for the kernel
+ * to reach the disk (fsync), which is closer to the cost of an SD card sync.
+ */
+class FileBlockStorage : public BlockStorage {
+private:
+    static const size_t MAX_PATH = 256;
+
+    char directory_[MAX_PATH];  // Prefix of every path
+    bool durable_;              // fsync() on sync()
+    FILE* file_;                // Open file, or nullptr
+
+    bool fullPath(const char* path, char* out, size_t capacity) const;
+
+public:
+    /**
+     * @brief Construct a new FileBlockStorage object
+     * @param directory Existing directory holding the files
+     * @param durable Call fsync() on every sync()
+     */
+    FileBlockStorage(const char* directory, bool durable = false);
+    ~FileBlockStorage();
+
+    bool begin() override;
+    bool exists(const char* path) override;
+    bool open(const char* path, uint32_t size) override;
+    bool write(const uint8_t* data, size_t length) override;
+    bool sync() override;
+    void close() override;
+};
+
+#endif // FILE_BLOCK_STORAGE_H
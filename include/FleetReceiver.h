@@ -0,0 +1,152 @@
+#ifndef FLEET_RECEIVER_H
+#define FLEET_RECEIVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "TimeSync.h"
+#include "WireFormat.h"
+
+/**
+ * @brief What a receiver knows about one anemometer
+ */
+struct SenderState {
+    uint8_t mac[6];          // Sender MAC address
+    bool online;             // A frame was heard within the timeout
+    uint16_t lastSequence;   // Highest sequence number heard
+    uint32_t received;       // Sequences heard (reordered ones included, duplicates not)
+    uint32_t lost;           // Sequences missing below lastSequence
+    uint32_t reordered;      // Frames that arrived after a later one
+    uint32_t duplicates;     // Frames heard twice
+    uint32_t timeouts;       // Times the sender went silent for the timeout
+    uint32_t restarts;       // Sequence jumps too large for losses (reboots)
+    uint32_t lastRxUs;       // Receive time of the newest frame (receiver clock)
+    uint32_t maxGapUs;       // Longest silence between two frames
+    uint32_t ageUs;          // Age of the newest measurement when received, with FIELD_TIME
+    uint32_t maxAgeUs;       // Oldest measurement received
+    uint64_t ageSumUs;       // Sum of the ages, for the average
+    uint32_t ages;           // Frames with an age
+    AnemometerData latest;   // Newest measurement
+};
+
+/**
+ * @brief Reference receiver for anemometer frames: the logic a display or boat needs.
+ *
+ * Decodes each frame with WireFormat and keeps per-sender state: losses from the
+ * sequence gaps, reordered and duplicate frames from a 32-frame window of sequences
+ * heard, the silence between frames, and a sender goes offline after timeoutUs
+ * without frames (poll()). Time beacons feed a follower TimeSync, so frames carrying
+ * FIELD_TIME give the age of the measurement at reception (acquisition to receiver).
+ *
+ * Fixed memory (MAX_SENDERS), no Arduino dependency: like WireFormat, it can be
+ * copied into receiver projects. Not thread-safe: queue the frames from the radio
+ * receive handler and call receive() from one task.
+ */
+class FleetReceiver {
+public:
+    static const size_t MAX_SENDERS = 64;                 // Anemometers tracked (a 50-node fleet)
+    static const uint32_t DEFAULT_TIMEOUT_US = 5000000;   // Silence before a sender counts as offline
+    static const int16_t MAX_SEQUENCE_GAP = 100;          // Larger jumps are reboots, not losses
+    static const size_t SEQUENCE_WINDOW = 32;             // Sequences remembered for reordering
+
+private:
+    uint32_t timeoutUs_;
+    TimeSync timeSync_;                  // Reference clock, from the time beacons
+    SenderState senders_[MAX_SENDERS];
+    uint32_t windows_[MAX_SENDERS];      // Bit n: sequence lastSequence - n heard
+    size_t senderCount_;
+    uint32_t frames_;                    // Anemometer frames decoded
+    uint32_t beacons_;                   // Time beacons decoded
+    uint32_t malformed_;                 // Frames that did not decode
+    uint32_t others_;                    // Other message types (boats, diagnostics)
+    uint32_t untracked_;                 // Frames from senders beyond MAX_SENDERS
+    uint32_t timeouts_;                  // Senders that went offline
+
+    SenderState* find(const uint8_t mac[6], bool create);
+    bool account(SenderState& sender, uint32_t& window, uint16_t sequence);
+
+public:
+    /**
+     * @brief Construct a new FleetReceiver object
+     * @param timeoutUs Silence before a sender counts as offline
+     */
+    FleetReceiver(uint32_t timeoutUs = DEFAULT_TIMEOUT_US);
+
+    /**
+     * @brief Forget the senders and the counters
+     * @param mac MAC address of the receiver (its identity in TimeSync)
+     */
+    void begin(const uint8_t mac[6]);
+
+    /**
+     * @brief Decode one frame and update its sender
+     * @param frame Frame bytes as received
+     * @param length Frame length
+     * @param rxUs Receiver clock at reception (us)
+     * @return true if it was an anemometer frame
+     */
+    bool receive(const uint8_t* frame, size_t length, uint32_t rxUs);
+
+    /**
+     * @brief Mark the senders silent for the timeout as offline
+     * @param nowUs Receiver clock (us), at least once per second
+     * @return Senders that went offline in this call
+     */
+    size_t poll(uint32_t nowUs);
+
+    /**
+     * @brief Number of senders heard
+     */
+    size_t senderCount() const;
+
+    /**
+     * @brief State of one sender, in the order they were first heard
+     */
+    const SenderState& sender(size_t index) const;
+
+    /**
+     * @brief Index of a sender, -1 if never heard
+     */
+    int indexOf(const uint8_t mac[6]) const;
+
+    /**
+     * @brief Senders currently online
+     */
+    size_t online() const;
+
+    /**
+     * @brief Anemometer frames decoded
+     */
+    uint32_t frames() const;
+
+    /**
+     * @brief Time beacons decoded
+     */
+    uint32_t beacons() const;
+
+    /**
+     * @brief Frames that did not decode
+     */
+    uint32_t malformed() const;
+
+    /**
+     * @brief Frames of other message types
+     */
+    uint32_t others() const;
+
+    /**
+     * @brief Frames from senders beyond MAX_SENDERS
+     */
+    uint32_t untracked() const;
+
+    /**
+     * @brief Senders that went offline, all senders together
+     */
+    uint32_t timeouts() const;
+
+    /**
+     * @brief Reference clock estimate, for the sync state
+     */
+    const TimeSync& timeSync() const;
+};
+
+#endif // FLEET_RECEIVER_H
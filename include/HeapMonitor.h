@@ -0,0 +1,89 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief State of the heap the allocator reports (device only)
+ */
+struct HeapInfo {
+    uint32_t freeBytes;          // Free heap
+    uint32_t largestFreeBlock;   // Largest allocation that can succeed
+    uint32_t minimumFreeBytes;   // Lowest free heap since boot
+};
+
+/**
+ * @brief Counts the heap allocations, to prove the steady state makes none.
+ *
+ * Allocation hooks call recordAllocation() and recordFree(): on the device the
+ * linker wraps malloc, calloc, realloc and free (-Wl,--wrap, see platformio.ini),
+ * on a glibc host the same functions are replaced (src/host/HeapHooks.cpp).
+ * operator new goes through malloc, so C++ allocations are counted as well. The
+ * ESP-IDF drivers that call heap_caps_malloc() directly (WiFi buffers) are not.
+ *
+ * Initialisation may allocate; markSteadyState() at its end starts the steady
+ * counters, which must stay at zero. Counters are atomic: any task, any time,
+ * even before the static constructors ran.
+ */
+class HeapMonitor {
+public:
+    /**
+     * @brief Count one allocation (allocation hooks)
+     * @param size Bytes requested
+     */
+    static void recordAllocation(size_t size);
+
+    /**
+     * @brief Count one free of a non-null pointer (allocation hooks)
+     */
+    static void recordFree();
+
+    /**
+     * @brief End of initialisation: allocations from now on are counted as steady
+     */
+    static void markSteadyState();
+
+    /**
+     * @brief true once markSteadyState() was called
+     */
+    static bool steady();
+
+    /**
+     * @brief Allocations since boot, 0 if the hooks are not linked in
+     */
+    static uint32_t allocations();
+
+    /**
+     * @brief Frees since boot
+     */
+    static uint32_t frees();
+
+    /**
+     * @brief Allocations since markSteadyState()
+     */
+    static uint32_t steadyAllocations();
+
+    /**
+     * @brief Bytes requested since markSteadyState()
+     */
+    static uint32_t steadyBytes();
+
+    /**
+     * @brief Size of the first allocation after markSteadyState() (a hint to find it), 0 if none
+     */
+    static uint32_t firstSteadySize();
+
+    /**
+     * @brief Read the allocator state
+     * @return false where the platform does not report it (host)
+     */
+    static bool heapInfo(HeapInfo& info);
+
+    /**
+     * @brief Fragmentation of the free heap: 1 - largest free block / free bytes
+     */
+    static float fragmentation(const HeapInfo& info);
+};
+
+#endif // HEAP_MONITOR_H
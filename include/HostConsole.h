@@ -0,0 +1,36 @@
+#ifndef HOST_CONSOLE_H
+#define HOST_CONSOLE_H
+
+#include "Console.h"
+
+/**
+ * @brief Console on the host standard streams (stdout for output, stdin for input)
+ *
+ * Output can be muted, for instance to time the logger without measuring the terminal.
+ */
+class HostConsole : public Console {
+private:
+    bool muted_;            // Discard output
+    uint32_t bytesWritten_; // Bytes received for output, muted or not
+
+public:
+    HostConsole(bool muted = false);
+
+    bool begin(uint32_t baudRate) override;
+    void print(const char* text) override;
+    void println(const char* text) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    int read() override;
+
+    /**
+     * @brief Mute or unmute the output
+     */
+    void setMuted(bool muted);
+
+    /**
+     * @brief Number of bytes written since construction
+     */
+    uint32_t bytesWritten() const;
+};
+
+#endif // HOST_CONSOLE_H
@@ -0,0 +1,80 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+/**
+ * @brief Severity of a log message (lower is more severe)
+ */
+enum class LogLevel : uint8_t {
+    Error = 0,
+    Warning = 1,
+    Info = 2,
+    Debug = 3
+};
+
+/**
+ * @brief Module a log message comes from, each with its own level threshold
+ */
+enum class LogModule : uint8_t {
+    Main = 0,
+    Anemometer = 1,
+    Communication = 2
+};
+
+static const size_t LOG_MODULE_COUNT = 3;
+
+/**
+ * @brief One captured argument of a deferred log message
+ *
+ * Integers are widened to 64 bits and floats to double, so the formatter can feed
+ * any printf conversion with the type it expects. Strings are kept by pointer: only
+ * pass strings that outlive the message (literals, names of static objects).
+ */
+union LogArg {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;
+    const void* p;
+
+    template <typename T>
+    static LogArg from(T value) {
+        LogArg arg;
+        if constexpr (std::is_floating_point<T>::value) {
+            arg.d = static_cast<double>(value);
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            arg.u = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_convertible<T, const char*>::value) {
+            arg.s = value;
+        } else {
+            static_assert(std::is_pointer<T>::value, "Unsupported log argument type");
+            arg.p = value;
+        }
+        return arg;
+    }
+};
+
+/**
+ * @brief A log message captured without formatting.
+ *
+ * The format string pointer doubles as the message id: formats must be string
+ * literals (they live in flash for the whole run). Formatting happens later, in the
+ * logger task, with Logger::format().
+ */
+struct LogRecord {
+    static const size_t MAX_ARGS = 6;
+
+    const char* format;         // printf-style format, string literal
+    uint32_t timestampMs;       // Capture time
+    LogModule module;           // Source module
+    LogLevel level;             // Severity
+    uint8_t argCount;           // Number of valid entries in args
+    LogArg args[MAX_ARGS];      // Captured arguments, in format order
+};
+
+#endif // LOG_RECORD_H
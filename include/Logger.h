@@ -1,39 +1,154 @@
-
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <mutex>
+#include "Console.h"
+#include "DisplayDevice.h"
+#include "LogRecord.h"
+#include "MpscRing.h"
+#include "RtosTask.h"
+#include "Trace.h"
+
+#ifdef ARDUINO
 #include <Arduino.h>
-#include <M5Unified.h>
+#endif
 
 /**
- * @brief Logger class for serial, screen, and SD card logging.
+ * @brief Logger class for serial and screen logging.
+ *
+ * This class provides logging functionalities for serial output and screen display
+ * (AtomS3). Logging channels can be enabled or disabled independently. Nothing is
+ * written to the SD card: the raw samples go there through SampleRecorder.
+ * log() is serialized with a mutex, so it can be called from several pipeline tasks.
+ * Output goes through the Console and DisplayDevice interfaces, so the logger also
+ * runs on a Linux host.
  *
- * This class provides logging functionalities for serial output, screen display (AtomS3),
- * and SD card file logging. Logging channels can be enabled or disabled independently.
+ * logf() is the deferred path: once startAsync() has been called, it only checks the
+ * module level and copies the format pointer and the binary arguments into a
+ * lock-free ring (no formatting, no allocation, no I/O). A low-priority task formats
+ * and emits the records, and reports how many were dropped when the ring was full.
+ * Before startAsync(), logf() formats and writes synchronously like log().
  */
 class Logger {
+public:
+    static const size_t QUEUE_SIZE = 64;        // Records waiting for the logger task
+    static const size_t MAX_MESSAGE = 128;      // Longest formatted message
+    static const uint8_t TASK_PRIORITY = 1;     // Just above idle
+    static const uint32_t DRAIN_PERIOD_MS = 50; // Logger task wake-up when not notified
+
 private:
-    bool sdLogging;        // Enable/disable SD card logging
+    Console* console_;          // Serial output (may be null)
+    DisplayDevice* display_;    // Screen output (may be null)
     bool serialLogging;    // Enable/disable serial logging
     bool screenLogging;    // Enable/disable screen logging
     int screenLine;        // Current line on the screen
     static const int MAX_LINES = 8;    // Maximum lines for AtomS3 screen
     static const int LINE_HEIGHT = 16; // Height of each line on screen
+    std::mutex mutex_;     // Serializes log() calls from different tasks
+
+    std::atomic<uint8_t> levels_[LOG_MODULE_COUNT];   // Per-module threshold
+    MpscRing<LogRecord, QUEUE_SIZE> queue_;           // Deferred records
+    RtosTask task_;                                   // Formats and emits deferred records
+    std::atomic<bool> async_;                         // logf() goes through queue_
+    uint32_t droppedReported_;                        // Drops already reported (logger task)
+
+    /**
+     * @brief Write a formatted message to the enabled outputs
+     */
+    void emit(const char* message);
+
+    /**
+     * @brief Queue a record, or format and emit it at once in synchronous mode
+     */
+    void submit(const LogRecord& record);
+
+    /**
+     * @brief Format and emit every queued record, then report new drops
+     */
+    void drain();
+
+    static void drainTask(void* arg);
 
 public:
     /**
      * @brief Construct a new Logger object
-     * @param enableSDLogging Enable SD card logging
+     * @param console Console used for serial logging
+     * @param display Display used for screen logging
      * @param enableSerialLogging Enable serial logging
      * @param enableScreenLogging Enable screen logging
      */
-    Logger(bool enableSDLogging = false, bool enableSerialLogging = true, bool enableScreenLogging = true);
+    Logger(Console* console, DisplayDevice* display, bool enableSerialLogging = true, bool enableScreenLogging = true);
 
     /**
      * @brief Log a message to enabled outputs
      * @param message The message to log
      */
-    void log(const String& message);
+    void log(const char* message);
+
+    /**
+     * @brief Log a printf-style message, deferred once startAsync() was called
+     * @param module Source module (selects the level threshold)
+     * @param level Severity
+     * @param format String literal; %s arguments must outlive the message
+     * @param args Up to LogRecord::MAX_ARGS integers, floats or static strings
+     */
+    template <typename... Args>
+    void logf(LogModule module, LogLevel level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "Too many log arguments");
+        if (!enabled(module, level)) {
+            return;
+        }
+        TRACE_SCOPE(TraceStage::Log);
+        LogRecord record;
+        record.format = format;
+        record.timestampMs = RtosTask::nowMs();
+        record.module = module;
+        record.level = level;
+        record.argCount = static_cast<uint8_t>(sizeof...(Args));
+        size_t index = 0;
+        ((record.args[index++] = LogArg::from(args)), ...);
+        (void)index;
+        submit(record);
+    }
+
+    /**
+     * @brief true if messages of this module and level pass the threshold
+     */
+    bool enabled(LogModule module, LogLevel level) const {
+        return static_cast<uint8_t>(level) <=
+               levels_[static_cast<size_t>(module)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Set the most verbose level logged for a module (default: Info)
+     */
+    void setLevel(LogModule module, LogLevel level);
+
+    /**
+     * @brief Start the logger task; logf() becomes asynchronous
+     * @return true if the task was created
+     */
+    bool startAsync();
+
+    /**
+     * @brief Emit what is still queued and go back to synchronous logf() (host only)
+     */
+    void stopAsync();
+
+    /**
+     * @brief Number of deferred records lost because the queue was full
+     */
+    uint32_t dropped() const;
+
+    /**
+     * @brief Format a captured record into text
+     * @param record Record to format
+     * @param out Destination buffer, always NUL-terminated
+     * @param capacity Size of the destination buffer
+     * @return Length of the text
+     */
+    static size_t format(const LogRecord& record, char* out, size_t capacity);
 
     /**
      * @brief Enable or disable serial logging
@@ -46,12 +161,6 @@ public:
      * @param enable True to enable, false to disable
      */
     void enableScreenLogging(bool enable);
-
-    /**
-     * @brief Enable or disable SD card logging
-     * @param enable True to enable, false to disable
-     */
-    void enableSDLogging(bool enable);
 };
 
 #endif // LOGGER_H
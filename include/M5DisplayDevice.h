@@ -0,0 +1,32 @@
+#ifndef M5_DISPLAY_DEVICE_H
+#define M5_DISPLAY_DEVICE_H
+
+#include <M5Unified.h>
+#include "DisplayDevice.h"
+
+/**
+ * @brief DisplayDevice backed by M5.Display (AtomS3 LCD)
+ *
+ * pushImage() uses SPI DMA, so the caller can prepare the next block while the
+ * previous one is being sent.
+ */
+class M5DisplayDevice : public DisplayDevice {
+public:
+    int16_t width() override;
+    int16_t height() override;
+    void fillScreen(uint16_t color) override;
+    void setTextSize(uint8_t size) override;
+    void setTextColor(uint16_t color) override;
+    void setCursor(int16_t x, int16_t y) override;
+    void print(const char* text) override;
+    void println(const char* text) override;
+    int16_t textWidth(const char* text) override;
+
+    /**
+     * @brief Start a DMA transfer, after waiting for the previous one
+     */
+    void pushImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) override;
+    void waitPush() override;
+};
+
+#endif // M5_DISPLAY_DEVICE_H
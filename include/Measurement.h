@@ -0,0 +1,23 @@
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include <stdint.h>
+
+/**
+ * @brief One processed measurement handed from the acquisition core to the output stages
+ */
+struct Measurement {
+    uint32_t sequenceNumber;   // Measurement counter
+    uint32_t timestampMs;      // Time the measurement was produced (ms since boot)
+    uint32_t timestampUs;      // Acquisition time of the newest conversion (local clock, us)
+    float voltage;             // Last voltage of the period (mV)
+    float windSpeed;           // Last wind speed of the period (m/s)
+    float windGust;            // Highest 3 s mean over the last 10 min (m/s)
+    float windLull;            // Lowest 3 s mean over the last 10 min (m/s)
+    float windMean;            // Mean over the last 10 min (m/s)
+    uint16_t sampleCount;      // Conversions consumed during the period
+    uint16_t overruns;         // Conversions lost during the period
+    bool sensorReady;          // The converter answered; the wind values are not measurements otherwise
+};
+
+#endif // MEASUREMENT_H
@@ -0,0 +1,70 @@
+#ifndef MONOTONIC_WINDOW_H
+#define MONOTONIC_WINDOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Sliding-window maximum (or minimum) with a fixed-capacity monotonic deque.
+ *
+ * Values are pushed with an increasing index; entries that can never become the
+ * extremum again are discarded from the back, expired entries from the front.
+ * Each push costs amortized O(1) whatever the window length, and nothing is
+ * allocated: the deque is a ring of Capacity entries.
+ *
+ * @tparam Capacity Longest window supported (in pushes)
+ * @tparam IsMax true for a sliding maximum, false for a sliding minimum
+ */
+template <size_t Capacity, bool IsMax>
+class MonotonicWindow {
+private:
+    float values_[Capacity];     // Candidate extrema, monotonic from front to back
+    uint32_t indices_[Capacity]; // Push index of each candidate
+    size_t front_;               // Ring position of the front entry
+    size_t count_;               // Number of entries
+
+    static bool dominates(float newer, float older) {
+        return IsMax ? newer >= older : newer <= older;
+    }
+
+public:
+    MonotonicWindow() : front_(0), count_(0) {}
+
+    /**
+     * @brief Add a value and drop entries older than the window
+     * @param index Increasing push index (e.g. tick number)
+     * @param value Value to add
+     * @param window Window length in pushes (1..Capacity)
+     */
+    void push(uint32_t index, float value, size_t window) {
+        while (count_ > 0 && dominates(value, values_[(front_ + count_ - 1) % Capacity])) {
+            count_--;
+        }
+        while (count_ > 0 && index - indices_[front_] >= window) {
+            front_ = (front_ + 1) % Capacity;
+            count_--;
+        }
+        size_t back = (front_ + count_) % Capacity;
+        values_[back] = value;
+        indices_[back] = index;
+        count_++;
+    }
+
+    /**
+     * @brief Current extremum over the window (0 when empty)
+     */
+    float value() const {
+        return count_ > 0 ? values_[front_] : 0.0f;
+    }
+
+    bool empty() const {
+        return count_ == 0;
+    }
+
+    void clear() {
+        front_ = 0;
+        count_ = 0;
+    }
+};
+
+#endif // MONOTONIC_WINDOW_H
@@ -0,0 +1,112 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Fixed-size multi-producer/single-consumer ring buffer.
+ *
+ * Any number of tasks push, one task pops. Each slot carries a sequence number
+ * (bounded queue of D. Vyukov): a producer claims a slot with one compare-and-swap
+ * on the head, fills it, then publishes it by advancing the slot sequence. No lock
+ * is taken, so a producer preempted mid-push never blocks the others. When the
+ * ring is full new items are rejected and counted as drops.
+ *
+ * @tparam T Element type (trivially copyable)
+ * @tparam N Capacity, must be a power of two
+ */
+template <typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRing capacity must be a power of two");
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;   // == position: free, == position + 1: published
+        T item;
+    };
+
+    Cell cells_[N];
+    std::atomic<uint32_t> head_;      // Next position to claim (producers)
+    std::atomic<uint32_t> tail_;      // Next position to read (written by the consumer only)
+    std::atomic<uint32_t> dropped_;   // Items rejected because the ring was full
+
+public:
+    MpscRing() : head_(0), tail_(0), dropped_(0) {
+        for (size_t i = 0; i < N; i++) {
+            cells_[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Push one item (any producer)
+     * @param item Item to store
+     * @return true if stored, false if the ring was full
+     */
+    bool push(const T& item) {
+        uint32_t position = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[position & (N - 1)];
+            uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = static_cast<int32_t>(sequence - position);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop one item (consumer side)
+     * @param item Receives the oldest published item
+     * @return true if an item was available
+     */
+    bool pop(T& item) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        Cell* cell = &cells_[tail & (N - 1)];
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(sequence - (tail + 1)) < 0) {
+            return false;
+        }
+        item = cell->item;
+        cell->sequence.store(tail + N, std::memory_order_release);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of claimed items not yet popped (any task; a snapshot that may
+     *        already be stale when a push or pop runs at the same time)
+     */
+    size_t size() const {
+        uint32_t tail = tail_.load(std::memory_order_relaxed); // First: the head read after is never behind it
+        return head_.load(std::memory_order_relaxed) - tail;
+    }
+
+    /**
+     * @brief Number of push attempts rejected since construction
+     */
+    uint32_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Capacity of the ring
+     */
+    static constexpr size_t capacity() {
+        return N;
+    }
+};
+
+#endif // MPSC_RING_H
@@ -0,0 +1,168 @@
+#ifndef P2_QUANTILE_H
+#define P2_QUANTILE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Streaming estimate of one quantile with five markers (Jain and Chlamtac P²).
+ *
+ * The markers hold the minimum, the quantile, the maximum and two points halfway
+ * between. Each sample moves the marker positions; a marker that drifts a whole
+ * position from where the quantile wants it is moved by one, its height adjusted
+ * on the parabola through its neighbours. O(1) time and 40 bytes whatever the
+ * number of samples, no sample is kept. The desired positions follow from the
+ * count, so heights, positions and count are the whole state (see State).
+ */
+class P2Quantile {
+public:
+    static const int MARKERS = 5;
+
+    /**
+     * @brief Complete estimator state, for persistence
+     */
+    struct State {
+        float heights[MARKERS];     // Marker heights (the first five samples, sorted, until count reaches 5)
+        int32_t positions[MARKERS]; // Marker positions, 1-based
+        uint32_t count;             // Samples seen
+    };
+
+private:
+    float p_;        // Quantile estimated, 0..1
+    State state_;    // Markers
+
+    /**
+     * @brief Position marker i should be at after count samples
+     */
+    float desired(int i) const {
+        static const float HALF = 0.5f;
+        float increments[MARKERS] = {0.0f, p_ * HALF, p_, (1.0f + p_) * HALF, 1.0f};
+        return 1.0f + (state_.count - 1) * increments[i];
+    }
+
+    /**
+     * @brief Height of marker i moved by d (+1 or -1) on the parabola through its neighbours
+     */
+    float parabolic(int i, int d) const {
+        const float* q = state_.heights;
+        const int32_t* n = state_.positions;
+        float span = static_cast<float>(n[i + 1] - n[i - 1]);
+        float right = (n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]);
+        float left = (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]);
+        return q[i] + d / span * (right + left);
+    }
+
+    /**
+     * @brief Height of marker i moved by d on the line to the neighbour in that direction
+     */
+    float linear(int i, int d) const {
+        const float* q = state_.heights;
+        const int32_t* n = state_.positions;
+        return q[i] + d * (q[i + d] - q[i]) / (n[i + d] - n[i]);
+    }
+
+public:
+    /**
+     * @brief Construct an estimator
+     * @param p Quantile to estimate, 0..1
+     */
+    explicit P2Quantile(float p = 0.5f) : p_(p), state_() {
+        reset();
+    }
+
+    /**
+     * @brief Forget all samples
+     */
+    void reset() {
+        for (int i = 0; i < MARKERS; i++) {
+            state_.heights[i] = 0.0f;
+            state_.positions[i] = i + 1;
+        }
+        state_.count = 0;
+    }
+
+    /**
+     * @brief Add one sample
+     */
+    void add(float x) {
+        float* q = state_.heights;
+        int32_t* n = state_.positions;
+        if (state_.count < MARKERS) {
+            // Insertion sort of the first samples: they become the initial markers
+            int i = static_cast<int>(state_.count++);
+            while (i > 0 && q[i - 1] > x) {
+                q[i] = q[i - 1];
+                i--;
+            }
+            q[i] = x;
+            return;
+        }
+
+        int k;
+        if (x < q[0]) {
+            q[0] = x;
+            k = 0;
+        } else if (x >= q[MARKERS - 1]) {
+            q[MARKERS - 1] = x;
+            k = MARKERS - 2;
+        } else {
+            k = 0;
+            while (x >= q[k + 1]) {
+                k++;
+            }
+        }
+        for (int i = k + 1; i < MARKERS; i++) {
+            n[i]++;
+        }
+        state_.count++;
+
+        for (int i = 1; i < MARKERS - 1; i++) {
+            float d = desired(i) - n[i];
+            if ((d >= 1.0f && n[i + 1] - n[i] > 1) || (d <= -1.0f && n[i - 1] - n[i] < -1)) {
+                int step = d > 0.0f ? 1 : -1;
+                float height = parabolic(i, step);
+                if (!(q[i - 1] < height && height < q[i + 1])) {
+                    height = linear(i, step);
+                }
+                q[i] = height;
+                n[i] += step;
+            }
+        }
+    }
+
+    /**
+     * @brief Current estimate (exact while fewer than five samples were seen), 0 without samples
+     */
+    float value() const {
+        if (state_.count == 0) {
+            return 0.0f;
+        }
+        if (state_.count < MARKERS) {
+            uint32_t index = static_cast<uint32_t>(p_ * (state_.count - 1) + 0.5f);
+            return state_.heights[index];
+        }
+        return state_.heights[2];
+    }
+
+    /**
+     * @brief Samples seen
+     */
+    uint32_t count() const {
+        return state_.count;
+    }
+
+    /**
+     * @brief Markers, to save them
+     */
+    const State& state() const {
+        return state_;
+    }
+
+    /**
+     * @brief Restore markers saved by state()
+     */
+    void setState(const State& state) {
+        state_ = state;
+    }
+};
+
+#endif // P2_QUANTILE_H
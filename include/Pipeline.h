@@ -0,0 +1,149 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "Measurement.h"
+#include "RtosTask.h"
+#include "SpscRing.h"
+
+/**
+ * @brief Produces one Measurement per pipeline period (runs on the acquisition core)
+ */
+class MeasurementProducer {
+public:
+    virtual ~MeasurementProducer() {}
+
+    /**
+     * @brief Build the next measurement
+     * @param measurement Receives the measurement (sequence number and timestamp are set by the pipeline)
+     * @return true if a measurement is available
+     */
+    virtual bool produce(Measurement& measurement) = 0;
+};
+
+/**
+ * @brief Consumes measurements in an output stage (display, logging, radio...)
+ */
+class MeasurementSink {
+public:
+    virtual ~MeasurementSink() {}
+
+    /**
+     * @brief Handle one measurement
+     * @param measurement Measurement taken from the stage queue
+     */
+    virtual void consume(const Measurement& measurement) = 0;
+};
+
+/**
+ * @brief Output stage: a wait-free SPSC queue drained by its own task.
+ *
+ * Each stage has its own queue and task, so a slow consumer (display redraw, serial
+ * write) only fills its own queue and never delays the producer or the other stages.
+ */
+class PipelineStage {
+public:
+    static const size_t QUEUE_SIZE = 8;  // Measurements buffered per stage
+
+private:
+    const char* name_;                              // Stage name for statistics
+    MeasurementSink& sink_;                         // Consumer
+    SpscRing<Measurement, QUEUE_SIZE> queue_;       // Producer -> stage hand-off
+    RtosTask task_;                                 // Task draining the queue
+    std::atomic<bool> running_;                     // Cleared to stop the task
+    std::atomic<uint32_t> processed_;               // Measurements consumed
+    std::atomic<uint32_t> maxServiceMs_;            // Longest single consume() call
+
+    static void run(void* arg);
+
+public:
+    /**
+     * @brief Construct a new PipelineStage object
+     * @param name Stage name
+     * @param sink Consumer called from the stage task
+     * @param priority Task priority
+     * @param core Core the stage task is pinned to
+     * @param stackSize Task stack size in bytes
+     */
+    PipelineStage(const char* name, MeasurementSink& sink, uint8_t priority, int core, uint32_t stackSize = 4096);
+
+    /**
+     * @brief Start the stage task
+     */
+    bool start();
+
+    /**
+     * @brief Stop the stage task once its queue is empty (host: waits for the thread)
+     */
+    void stop();
+
+    /**
+     * @brief Hand a measurement to the stage (producer side, never blocks)
+     * @return false if the queue was full and the measurement dropped
+     */
+    bool offer(const Measurement& measurement);
+
+    const char* name() const { return name_; }
+    uint32_t highWater() const { return queue_.highWater(); }
+    uint32_t dropped() const { return queue_.overruns(); }
+    uint32_t processed() const { return processed_.load(std::memory_order_relaxed); }
+    uint32_t maxServiceMs() const { return maxServiceMs_.load(std::memory_order_relaxed); }
+};
+
+/**
+ * @brief Periodic producer task feeding a set of output stages.
+ *
+ * The producer wakes on a fixed period (no drift from the consumers), builds one
+ * measurement and offers it to every stage.
+ */
+class Pipeline {
+public:
+    static const size_t MAX_STAGES = 4;
+
+private:
+    MeasurementProducer& producer_;                 // Measurement source
+    uint32_t periodMs_;                             // Measurement period
+    PipelineStage* stages_[MAX_STAGES];             // Output stages
+    size_t stageCount_;                             // Number of registered stages
+    RtosTask task_;                                 // Producer task
+    std::atomic<bool> running_;                     // Cleared to stop the producer
+    std::atomic<uint32_t> produced_;                // Measurements produced
+    std::atomic<uint32_t> lateWakeups_;             // Periods where produce() overran the period
+
+    static void run(void* arg);
+
+public:
+    /**
+     * @brief Construct a new Pipeline object
+     * @param producer Measurement source, called from the producer task
+     * @param periodMs Measurement period in milliseconds
+     * @param priority Producer task priority
+     * @param core Core the producer task is pinned to
+     */
+    Pipeline(MeasurementProducer& producer, uint32_t periodMs, uint8_t priority, int core);
+
+    /**
+     * @brief Register an output stage (before start())
+     * @return false if MAX_STAGES is reached
+     */
+    bool addStage(PipelineStage& stage);
+
+    /**
+     * @brief Start the stage tasks then the producer task
+     */
+    bool start();
+
+    /**
+     * @brief Stop the producer then drain and stop the stages (host: waits for the threads)
+     */
+    void stop();
+
+    size_t stageCount() const { return stageCount_; }
+    const PipelineStage& stage(size_t index) const { return *stages_[index]; }
+    uint32_t produced() const { return produced_.load(std::memory_order_relaxed); }
+    uint32_t lateWakeups() const { return lateWakeups_.load(std::memory_order_relaxed); }
+};
+
+#endif // PIPELINE_H
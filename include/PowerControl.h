@@ -0,0 +1,53 @@
+#ifndef POWER_CONTROL_H
+#define POWER_CONTROL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Abstract low-power states of the CPU and radio.
+ *
+ * EspPowerControl on the device (light sleep, WiFi modem sleep), SimPowerControl on
+ * a Linux host, where sleeping advances a VirtualClock with a modelled wake-up delay.
+ */
+class PowerControl {
+public:
+    /**
+     * @brief How deep to sleep
+     */
+    enum class SleepMode {
+        Idle,   // CPU waits, everything stays powered (short gaps)
+        Light   // Light sleep: clocks gated, RAM kept, timer and ALERT pin wake-up
+    };
+
+    /**
+     * @brief What ended a sleep
+     */
+    enum class WakeSource {
+        Timer,  // Duration elapsed
+        Alert,  // Converter ALERT/RDY pin
+        Other   // Anything else (sleep refused, other wake-up source)
+    };
+
+    virtual ~PowerControl() {}
+
+    /**
+     * @brief Sleep for at most a duration
+     * @param mode Idle or light sleep
+     * @param durationUs Longest time to sleep
+     * @return Wake-up reason
+     * @note The clock keeps counting through light sleep; the wake-up may come late.
+     */
+    virtual WakeSource sleep(SleepMode mode, uint32_t durationUs) = 0;
+
+    /**
+     * @brief Let the radio sleep between transmissions (WiFi modem sleep)
+     * @param enabled true to save power, false to keep the receiver on
+     * @return true if supported
+     */
+    virtual bool setRadioPowerSave(bool enabled) {
+        (void)enabled;
+        return false;
+    }
+};
+
+#endif // POWER_CONTROL_H
@@ -0,0 +1,193 @@
+#ifndef POWER_SCHEDULER_H
+#define POWER_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Clock.h"
+#include "PowerControl.h"
+
+/**
+ * @brief Periodic work run by the PowerScheduler (acquisition, transmit, display...)
+ */
+class PowerTask {
+public:
+    virtual ~PowerTask() {}
+
+    /**
+     * @brief Do the work due now
+     */
+    virtual void run() = 0;
+
+    /**
+     * @brief Work still going on outside run() (e.g. a frame in the radio): no light sleep
+     */
+    virtual bool busy() const {
+        return false;
+    }
+};
+
+/**
+ * @brief Time and charge spent by one task
+ */
+struct PowerLedger {
+    const char* name;           // Task name for reports
+    float activeMilliamps;      // Estimated current while the task runs
+    uint32_t runs;              // Calls to run()
+    uint32_t alertRuns;         // Runs triggered by the ALERT pin
+    uint32_t missed;            // Periods skipped because the task ran too late
+    uint32_t maxLatenessUs;     // Worst delay between the deadline and the run
+    uint64_t activeUs;          // Time spent in run()
+};
+
+/**
+ * @brief Deadline scheduler that sleeps between the periodic tasks.
+ *
+ * Each task has a period and a deadline; step() runs the tasks that are due, then
+ * sleeps until the earliest next deadline: light sleep when the gap is long enough
+ * to pay for the wake-up, idle otherwise or while a task reports itself busy. The
+ * light-sleep wake-up delay is measured and the sleep shortened by its running
+ * average; an early wake-up is finished in idle, so deadlines are met to within the
+ * idle accuracy. Tasks flagged for the ALERT pin also run when the converter wakes
+ * the CPU (with a period of 0 they run on ALERT only).
+ *
+ * A ledger keeps the active time of every task and the idle and sleep time, turned
+ * into a charge estimate with configured currents. Pure logic on Clock and
+ * PowerControl, so it runs against a VirtualClock on a host. Not thread-safe.
+ */
+class PowerScheduler {
+public:
+    static const size_t MAX_TASKS = 6;
+    static const uint32_t BUSY_POLL_US = 2000;     // Idle slice while a task is busy
+    static const uint32_t MAX_SLEEP_US = 1000000;  // Longest single sleep (ALERT-only tasks)
+
+    struct Config {
+        uint32_t lightSleepMinUs;   // Shortest gap worth a light sleep (break-even)
+        float idleMilliamps;        // Current while idle (CPU clocked, radio in modem sleep)
+        float sleepMilliamps;       // Current in light sleep
+    };
+
+    static const Config DEFAULT_CONFIG;   // 3 ms break-even, 28 mA idle, 2.5 mA light sleep (ESP32-S3 + LCD off)
+
+private:
+    struct Entry {
+        PowerTask* task;
+        uint32_t periodUs;
+        uint32_t deadlineUs;
+        bool wakeOnAlert;
+        PowerLedger ledger;
+    };
+
+    Clock& clock_;                 // Deadlines and accounting
+    PowerControl& power_;          // Sleep states
+    Config config_;                // Break-even and currents
+    Entry tasks_[MAX_TASKS];       // Registered tasks
+    size_t taskCount_;             // Number of registered tasks
+    bool started_;                 // Deadlines initialized
+    uint32_t markUs_;              // End of the last accounted interval
+    uint32_t leadUs_;              // Average light-sleep wake-up delay, taken off each sleep
+    uint32_t maxWakeDelayUs_;      // Worst light-sleep wake-up delay
+    uint64_t elapsedUs_;           // Time accounted since start()
+    uint64_t idleUs_;              // Time idle (or in scheduler overhead)
+    uint64_t sleepUs_;             // Time in light sleep
+    uint32_t lightSleeps_;         // Light sleeps entered
+    uint32_t alertWakes_;          // Light sleeps ended by the ALERT pin
+
+    uint32_t account();
+    void runTask(Entry& entry, bool alert);
+    bool anyBusy() const;
+    bool nextDeadline(uint32_t nowUs, uint32_t& deadlineUs) const;
+    void runAlertTasks();
+
+public:
+    /**
+     * @brief Construct a new PowerScheduler object
+     * @param clock Time source (keeps counting through light sleep)
+     * @param power Sleep states
+     * @param config Break-even and current estimates
+     */
+    PowerScheduler(Clock& clock, PowerControl& power, const Config& config = DEFAULT_CONFIG);
+
+    /**
+     * @brief Register a task (before start())
+     * @param name Task name for reports
+     * @param task Work to run
+     * @param periodUs Period, 0 for a task run on the ALERT pin only
+     * @param activeMilliamps Estimated current while the task runs
+     * @param wakeOnAlert Also run the task when the ALERT pin wakes the CPU
+     * @return false if MAX_TASKS is reached or the task could never run
+     */
+    bool add(const char* name, PowerTask& task, uint32_t periodUs, float activeMilliamps, bool wakeOnAlert = false);
+
+    /**
+     * @brief Make every periodic task due now and clear the ledger
+     */
+    void start();
+
+    /**
+     * @brief Run the tasks that are due, then sleep until the next deadline
+     */
+    void step();
+
+    /**
+     * @brief Number of registered tasks
+     */
+    size_t taskCount() const;
+
+    /**
+     * @brief Ledger of one task
+     * @param index Task index, below taskCount()
+     */
+    const PowerLedger& ledger(size_t index) const;
+
+    /**
+     * @brief Time accounted since start() (us)
+     */
+    uint64_t elapsedUs() const;
+
+    /**
+     * @brief Time idle, scheduler overhead included (us)
+     */
+    uint64_t idleUs() const;
+
+    /**
+     * @brief Time in light sleep (us)
+     */
+    uint64_t sleepUs() const;
+
+    /**
+     * @brief Fraction of the time spent in light sleep (0..1)
+     */
+    float sleepRatio() const;
+
+    /**
+     * @brief Light sleeps entered
+     */
+    uint32_t lightSleeps() const;
+
+    /**
+     * @brief Light sleeps ended by the ALERT pin
+     */
+    uint32_t alertWakes() const;
+
+    /**
+     * @brief Current compensation of the light-sleep wake-up delay (us)
+     */
+    uint32_t leadUs() const;
+
+    /**
+     * @brief Worst light-sleep wake-up delay seen (us)
+     */
+    uint32_t maxWakeDelayUs() const;
+
+    /**
+     * @brief Estimated average current since start() (mA)
+     */
+    float averageMilliamps() const;
+
+    /**
+     * @brief Estimated charge drawn since start() (mAh)
+     */
+    float chargeMilliampHours() const;
+};
+
+#endif // POWER_SCHEDULER_H
@@ -0,0 +1,91 @@
+#ifndef RADIO_TRANSPORT_H
+#define RADIO_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Abstract connectionless radio (ESP-NOW on the device, SimRadio on a host)
+ */
+class RadioTransport {
+public:
+    static const size_t MAC_SIZE = 6;
+
+    /**
+     * @brief Called for each frame received, in the radio driver context (keep it short)
+     * @param context Pointer given to setReceiveHandler()
+     * @param source Sender MAC address
+     * @param data Frame bytes (only valid during the call)
+     * @param length Frame length
+     * @param rxUs Local time of reception (micros())
+     */
+    typedef void (*ReceiveHandler)(void* context, const uint8_t source[MAC_SIZE], const uint8_t* data, size_t length,
+                                   uint32_t rxUs);
+
+    /**
+     * @brief Called when a queued frame left the radio, in the radio driver context
+     * @param context Pointer given to setSendHandler()
+     * @param delivered true if sent (and acknowledged, for unicast), false on failure
+     * @param doneUs Local time of completion (micros())
+     * @note Completions arrive in the order the frames were queued.
+     */
+    typedef void (*SendHandler)(void* context, bool delivered, uint32_t doneUs);
+
+    /**
+     * @brief Outcome of send()
+     */
+    enum class SendStatus {
+        Queued,  // Accepted; completion reported later through the send handler
+        Busy,    // Driver queue full, try again later
+        Failed   // Rejected (radio down, bad length, ...)
+    };
+
+    virtual ~RadioTransport() {}
+
+    /**
+     * @brief Bring the radio up
+     * @return true on success
+     */
+    virtual bool begin() = 0;
+
+    /**
+     * @brief Queue one frame for transmission
+     * @param destination Destination MAC address (broadcast: FF:FF:FF:FF:FF:FF)
+     * @param data Frame bytes
+     * @param length Frame length
+     * @return Queued, or why the frame was not accepted
+     */
+    virtual SendStatus send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief MAC address of this device
+     * @param mac Receives the 6-byte address
+     */
+    virtual void macAddress(uint8_t mac[MAC_SIZE]) = 0;
+
+    /**
+     * @brief Register the handler of received frames (call after begin())
+     * @param handler Handler, nullptr to stop receiving
+     * @param context Passed back to the handler
+     * @return true if the radio can receive
+     */
+    virtual bool setReceiveHandler(ReceiveHandler handler, void* context) {
+        (void)handler;
+        (void)context;
+        return false;
+    }
+
+    /**
+     * @brief Register the handler of send completions (call after begin())
+     * @param handler Handler, nullptr to stop
+     * @param context Passed back to the handler
+     * @return true if the radio reports completions
+     */
+    virtual bool setSendHandler(SendHandler handler, void* context) {
+        (void)handler;
+        (void)context;
+        return false;
+    }
+};
+
+#endif // RADIO_TRANSPORT_H
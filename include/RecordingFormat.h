@@ -0,0 +1,128 @@
+#ifndef RECORDING_FORMAT_H
+#define RECORDING_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "CalibrationTable.h"
+
+/**
+ * @brief One raw sample as stored in a recording
+ */
+struct SampleRecord {
+    uint32_t timestampMs;       // Conversion time (ms since boot)
+    int16_t code;               // Raw ADC code
+    uint16_t windSpeedCmS;      // Converted wind speed (0.01 m/s)
+};
+
+/**
+ * @brief Binary sample recording format (SD card), in 512-byte sectors.
+ *
+ * Sector 0 is the file header, every following sector holds up to 62 records.
+ * All values are little-endian.
+ *
+ * File header sector:
+ * | Offset | Size | Content                                        |
+ * |--------|------|------------------------------------------------|
+ * | 0      | 8    | Magic "OSRCREC\0"                              |
+ * | 8      | 2    | Format version                                 |
+ * | 10     | 2    | Sector size (512)                              |
+ * | 12     | 2    | Record size (8)                                |
+ * | 14     | 2    | ADC data rate (SPS)                            |
+ * | 16     | 4    | Session number (first file number of the boot) |
+ * | 20     | 4    | Part number within the session (0, 1, ...)     |
+ * | 24     | 4    | File start time (ms since boot)                |
+ * | 28     | 6    | MAC address                                    |
+ * | 36     | 4    | mV per ADC code (float)                        |
+ * | 40     | 1    | Calibration curve point count                  |
+ * | 44     | 64   | Curve abscissae, mV (16 floats)                |
+ * | 108    | 64   | Curve ordinates, km/h (16 floats)              |
+ * | 508    | 4    | CRC-32 of bytes 0..507                         |
+ *
+ * Data sector:
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 4    | Magic "OSRD"                                         |
+ * | 4      | 4    | Sector index in the file (1, 2, ...)                 |
+ * | 8      | 2    | Record count (0..62)                                 |
+ * | 10     | 2    | Records dropped just before this sector (saturating) |
+ * | 12     | 4    | CRC-32 of the sector (this field zeroed), session seed |
+ * | 16     | 496  | Records: timestamp u32, code i16, speed u16          |
+ *
+ * Files are pre-allocated, so the end of the written data is the first sector that
+ * fails the magic, index or CRC check. The CRC is seeded with the session number:
+ * stale sectors left by an older recording in the same clusters are rejected.
+ * This header and RecordingFormat.cpp have no dependency on Arduino.
+ */
+namespace RecordingFormat {
+
+static const uint16_t VERSION = 1;
+static const size_t SECTOR_SIZE = 512;
+static const size_t RECORD_SIZE = 8;
+static const size_t SECTOR_HEADER_SIZE = 16;
+static const size_t RECORDS_PER_SECTOR = (SECTOR_SIZE - SECTOR_HEADER_SIZE) / RECORD_SIZE;
+
+/**
+ * @brief Contents of the file header sector
+ */
+struct FileInfo {
+    uint32_t session;           // Session number
+    uint32_t part;              // Part number within the session
+    uint32_t startMs;           // File start time (ms since boot)
+    uint16_t sampleRate;        // ADC data rate (SPS)
+    uint8_t macAddress[6];      // Recording device
+    float millivoltsPerCode;    // Scale of the raw codes
+    CalibrationCurve curve;     // Curve used for windSpeedCmS
+};
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected), chainable
+ * @param data Bytes to add
+ * @param length Number of bytes
+ * @param crc Previous result, 0 to start
+ */
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief Fill a file header sector
+ */
+void encodeFileHeader(const FileInfo& info, uint8_t sector[SECTOR_SIZE]);
+
+/**
+ * @brief Parse a file header sector
+ * @return false if the magic, version or CRC is wrong
+ */
+bool decodeFileHeader(const uint8_t sector[SECTOR_SIZE], FileInfo& info);
+
+/**
+ * @brief Store a record in a data sector
+ * @param index Slot, 0..RECORDS_PER_SECTOR - 1
+ */
+void putRecord(uint8_t sector[SECTOR_SIZE], size_t index, const SampleRecord& record);
+
+/**
+ * @brief Read a record from a data sector
+ */
+SampleRecord getRecord(const uint8_t sector[SECTOR_SIZE], size_t index);
+
+/**
+ * @brief Write the record count and drop count of a data sector (producer side)
+ */
+void setSectorCounts(uint8_t sector[SECTOR_SIZE], uint16_t count, uint16_t dropped);
+
+/**
+ * @brief Stamp magic, index and CRC just before the sector is written
+ */
+void sealSector(uint8_t sector[SECTOR_SIZE], uint32_t session, uint32_t index);
+
+/**
+ * @brief Validate a data sector read back from a file
+ * @param count Receives the record count
+ * @param dropped Receives the drop count
+ * @return false at the end of the recorded data
+ */
+bool checkSector(const uint8_t sector[SECTOR_SIZE], uint32_t session, uint32_t index, uint16_t& count,
+                 uint16_t& dropped);
+
+} // namespace RecordingFormat
+
+#endif // RECORDING_FORMAT_H
@@ -0,0 +1,107 @@
+#ifndef RTOS_TASK_H
+#define RTOS_TASK_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+/**
+ * @brief Minimal task wrapper: a FreeRTOS task pinned to a core on the device,
+ * a std::thread on a Linux host.
+ *
+ * Only what the pipeline needs is exposed: start a task, wake it, let it wait for
+ * a wake-up, and sleep on a fixed period without drift.
+ */
+class RtosTask {
+public:
+    typedef void (*Entry)(void* arg);
+
+    static const int ANY_CORE = -1;
+
+private:
+    const char* name_;      // Task name (debugging only)
+    uint32_t stackSize_;    // Stack size in bytes (device only)
+    uint8_t priority_;      // FreeRTOS priority (device only)
+    int core_;              // Core the task is pinned to, ANY_CORE for no affinity
+    Entry entry_;           // Task function
+    void* arg_;             // Task function argument
+
+    static void trampoline(void* self);
+
+#ifdef ARDUINO
+    TaskHandle_t handle_;
+#else
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    uint32_t notifications_;
+#endif
+
+public:
+    /**
+     * @brief Construct a new RtosTask object (the task is not started)
+     * @param name Task name
+     * @param stackSize Stack size in bytes
+     * @param priority FreeRTOS priority
+     * @param core Core to pin the task to, or ANY_CORE
+     */
+    RtosTask(const char* name, uint32_t stackSize, uint8_t priority, int core = ANY_CORE);
+
+    ~RtosTask();
+
+    /**
+     * @brief Start the task
+     * @param entry Task function, must loop forever on the device
+     * @param arg Argument passed to the task function
+     * @return true if the task was created
+     */
+    bool start(Entry entry, void* arg);
+
+    /**
+     * @brief Wake the task (counts, so no wake-up is lost)
+     */
+    void notify();
+
+    /**
+     * @brief Wake the task from an interrupt handler
+     */
+    void notifyFromIsr();
+
+    /**
+     * @brief Wait until notified or until the timeout expires (call from the task itself)
+     * @param timeoutMs Maximum wait in milliseconds
+     * @return Number of notifications consumed, 0 on timeout
+     */
+    uint32_t wait(uint32_t timeoutMs);
+
+    /**
+     * @brief Wait for the task function to return (host only, no-op on the device)
+     */
+    void join();
+
+    /**
+     * @brief Milliseconds since boot (device) or since first call (host)
+     */
+    static uint32_t nowMs();
+
+    /**
+     * @brief Sleep the calling task
+     * @param ms Duration in milliseconds
+     */
+    static void sleepMs(uint32_t ms);
+
+    /**
+     * @brief Sleep until lastWakeMs + periodMs, then advance lastWakeMs (no cumulative drift)
+     * @param lastWakeMs Previous wake-up time, updated on return
+     * @param periodMs Period in milliseconds
+     */
+    static void sleepUntil(uint32_t& lastWakeMs, uint32_t periodMs);
+};
+
+#endif // RTOS_TASK_H
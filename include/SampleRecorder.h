@@ -0,0 +1,119 @@
+#ifndef SAMPLE_RECORDER_H
+#define SAMPLE_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "BlockStorage.h"
+#include "RecordingFormat.h"
+#include "RtosTask.h"
+
+/**
+ * @brief Records every raw sample to storage in the binary RecordingFormat.
+ *
+ * The producer (acquisition side) fills one of two sector-aligned buffers; flush()
+ * or a full buffer hands it to a background writer task, which stamps and writes
+ * whole sectors with one storage call, then syncs. The producer never waits: if
+ * the writer still owns the other buffer when a swap is needed, samples are
+ * dropped and the count is stored in the next sector.
+ *
+ * Each boot opens a new session (first free RECnnnnn.BIN). Files are pre-allocated
+ * to fileSectors sectors and rotated when full. After a power loss, at most the two
+ * buffers (the data since the last flush() plus the buffer being written) are lost.
+ */
+class SampleRecorder {
+public:
+    static const size_t BUFFER_SECTORS = 32;                // 16 KB per buffer, ~2.3 s at 860 SPS
+    static const uint32_t DEFAULT_FILE_SECTORS = 65536;     // 32 MB per file, ~75 min at 860 SPS
+    static const uint8_t WRITER_PRIORITY = 2;
+    static const uint32_t MAX_FILE_NUMBER = 99999;
+
+private:
+    static const size_t BUFFER_SIZE = BUFFER_SECTORS * RecordingFormat::SECTOR_SIZE;
+
+    BlockStorage& storage_;                 // Destination medium
+    uint32_t fileSectors_;                  // Pre-allocated size of each file (header included)
+    RecordingFormat::FileInfo info_;        // Header of the current file
+
+    alignas(4) uint8_t buffers_[2][BUFFER_SIZE];
+
+    // Producer side
+    uint8_t active_;                        // Buffer being filled
+    size_t sectorIndex_;                    // Sector being filled in the active buffer
+    size_t recordIndex_;                    // Next record slot in that sector
+    uint32_t unreportedDrops_;              // Drops not yet stamped in a sector
+
+    // Hand-off
+    std::atomic<int8_t> pending_;           // Buffer owned by the writer, -1 if none
+    size_t pendingSectors_;                 // Sectors to write from the pending buffer
+
+    // Writer side
+    RtosTask task_;
+    std::atomic<bool> running_;
+    uint32_t fileNumber_;                   // Number of the open file
+    uint32_t sectorInFile_;                 // Next sector to write in the open file
+
+    // Statistics
+    std::atomic<uint32_t> recordsAppended_;
+    std::atomic<uint32_t> recordsDropped_;
+    std::atomic<uint32_t> sectorsWritten_;
+    std::atomic<uint32_t> writeErrors_;
+    std::atomic<uint32_t> maxWriteMs_;
+
+    bool openNextFile();
+    void finishSector();
+    bool handOff();
+    void writeBuffer(uint8_t* buffer, size_t sectors);
+    static void writerTask(void* arg);
+
+public:
+    /**
+     * @brief Construct a new SampleRecorder object
+     * @param storage Medium to record to
+     * @param fileSectors Sectors per file before rotation (header included)
+     * @param core Core the writer task is pinned to
+     */
+    SampleRecorder(BlockStorage& storage, uint32_t fileSectors = DEFAULT_FILE_SECTORS,
+                   int core = RtosTask::ANY_CORE);
+
+    /**
+     * @brief Mount the storage, open the first file of the session and start the writer
+     * @param info Header contents; session, part and startMs are filled in here
+     * @return true if recording started
+     */
+    bool begin(const RecordingFormat::FileInfo& info);
+
+    /**
+     * @brief Add one sample (producer context, never blocks)
+     */
+    void append(uint32_t timestampMs, int16_t code, float windSpeed);
+
+    /**
+     * @brief Hand the samples appended so far to the writer (producer context)
+     * @return false if the writer was still busy (samples stay buffered)
+     */
+    bool flush();
+
+    /**
+     * @brief Flush, write what is pending and close the file (host only)
+     */
+    void stop();
+
+    /**
+     * @brief true when the writer has nothing pending
+     */
+    bool idle() const;
+
+    uint32_t session() const;
+    uint32_t recordsAppended() const;
+    uint32_t recordsDropped() const;
+    uint32_t sectorsWritten() const;
+    uint32_t writeErrors() const;
+
+    /**
+     * @brief Longest buffer write + sync, in ms
+     */
+    uint32_t maxWriteMs() const;
+};
+
+#endif // SAMPLE_RECORDER_H
@@ -0,0 +1,136 @@
+#ifndef SAMPLE_STREAMER_H
+#define SAMPLE_STREAMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "Console.h"
+#include "RtosTask.h"
+#include "SpscRing.h"
+#include "StreamFormat.h"
+
+/**
+ * @brief Streams every raw ADC code over the serial console as binary packets.
+ *
+ * The producer (acquisition side) packs codes into StreamFormat samples packets of
+ * up to MAX_CODES codes, timestamped in microseconds, and hands each full packet
+ * (or one older than MAX_PACKET_US) to a writer task through a wait-free ring. The
+ * writer frames them (CRC-32, COBS, zero delimiter) and writes them in batches, with
+ * an info packet first and every StreamFormat::INFO_EVERY packets.
+ *
+ * The producer never waits: when the ring is full the packet is dropped, counted,
+ * and the next packet carries the count; its sequence number still advances, so
+ * the host sees the gap. At 860 SPS the stream is about 2 KB/s, well within the
+ * USB serial port; serial text logging must be off while streaming.
+ */
+class SampleStreamer {
+public:
+    static const size_t QUEUE_PACKETS = 32;            // 2.4 s of codes at 860 SPS
+    static const uint32_t MAX_PACKET_US = 200000;      // Oldest code a partial packet may hold
+    static const size_t WRITE_BATCH = 1024;            // Bytes gathered into one console write
+    static const uint8_t WRITER_PRIORITY = 2;
+
+private:
+    struct Packet {
+        StreamFormat::SamplesHeader header;
+        int16_t codes[StreamFormat::MAX_CODES];
+    };
+
+    Console& console_;                      // Serial port the stream goes to
+    StreamFormat::StreamInfo info_;         // Contents of the info packets
+
+    // Producer side
+    Packet filling_;                        // Packet being filled
+    uint32_t nextIndex_;                    // Index of the next code
+    uint16_t sequence_;                     // Sequence number of the next packet
+    uint32_t unreportedDrops_;              // Codes dropped since the last packet queued
+
+    // Hand-off
+    SpscRing<Packet, QUEUE_PACKETS> queue_;
+
+    // Writer side
+    RtosTask task_;
+    std::atomic<bool> running_;
+    uint32_t packetsSinceInfo_;             // Samples packets written since the last info packet
+    uint8_t batch_[WRITE_BATCH];            // Frames waiting for the console write
+    size_t batchLength_;
+
+    // Statistics
+    std::atomic<uint32_t> codesAppended_;
+    std::atomic<uint32_t> codesDropped_;
+    std::atomic<uint32_t> packetsWritten_;
+    std::atomic<uint32_t> bytesWritten_;
+    std::atomic<uint32_t> shortWrites_;
+    std::atomic<uint32_t> maxWriteMs_;
+
+    void queuePacket();
+    void writeFrame(const uint8_t* frame, size_t length);
+    void writeBatch();
+    static void writerTask(void* arg);
+
+public:
+    /**
+     * @brief Construct a new SampleStreamer object
+     * @param console Serial port the stream is written to
+     * @param core Core the writer task is pinned to
+     */
+    SampleStreamer(Console& console, int core = RtosTask::ANY_CORE);
+
+    /**
+     * @brief Start the writer task
+     * @param info MAC address, data rate and scale for the info packets
+     * @return true if streaming started
+     */
+    bool begin(const StreamFormat::StreamInfo& info);
+
+    /**
+     * @brief Add evenly spaced codes (producer context, never blocks)
+     * @param codes Raw codes, oldest first
+     * @param count Number of codes
+     * @param lastUs Time of the last code (us)
+     * @param periodUs Time between two codes (us)
+     */
+    void append(const int16_t* codes, size_t count, uint32_t lastUs, uint32_t periodUs);
+
+    /**
+     * @brief Queue the partial packet now (producer context)
+     */
+    void flush();
+
+    /**
+     * @brief Flush, write what is queued and stop the writer (host only)
+     */
+    void stop();
+
+    /**
+     * @brief true when streaming
+     */
+    bool running() const;
+
+    uint32_t codesAppended() const;
+    uint32_t codesDropped() const;
+    uint32_t packetsWritten() const;
+    uint32_t bytesWritten() const;
+
+    /**
+     * @brief Console writes that took fewer bytes than offered (damaged frames)
+     */
+    uint32_t shortWrites() const;
+
+    /**
+     * @brief Longest console write, in ms
+     */
+    uint32_t maxWriteMs() const;
+
+    /**
+     * @brief Packets waiting for the writer
+     */
+    uint32_t queued() const;
+
+    /**
+     * @brief Highest number of packets waiting for the writer
+     */
+    uint32_t queueHighWater() const;
+};
+
+#endif // SAMPLE_STREAMER_H
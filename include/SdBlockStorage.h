@@ -0,0 +1,45 @@
+#ifndef SD_BLOCK_STORAGE_H
+#define SD_BLOCK_STORAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include <SPI.h>
+#include "BlockStorage.h"
+
+/**
+ * @brief BlockStorage on a microSD card over SPI (FAT, Arduino SD library)
+ *
+ * The AtomS3 has no card slot: pins are those of the SD adapter wired to the
+ * Grove/header pins and must be set to match the hardware.
+ */
+class SdBlockStorage : public BlockStorage {
+private:
+    SPIClass spi_;          // Dedicated SPI bus for the card
+    int8_t sckPin_;
+    int8_t misoPin_;
+    int8_t mosiPin_;
+    int8_t csPin_;
+    uint32_t frequency_;    // SPI clock in Hz
+    File file_;             // Open file
+
+public:
+    /**
+     * @brief Construct a new SdBlockStorage object
+     * @param sckPin SPI clock pin
+     * @param misoPin SPI MISO pin
+     * @param mosiPin SPI MOSI pin
+     * @param csPin Card chip-select pin
+     * @param frequency SPI clock in Hz
+     */
+    SdBlockStorage(int8_t sckPin, int8_t misoPin, int8_t mosiPin, int8_t csPin, uint32_t frequency = 20000000);
+
+    bool begin() override;
+    bool exists(const char* path) override;
+    bool open(const char* path, uint32_t size) override;
+    bool write(const uint8_t* data, size_t length) override;
+    bool sync() override;
+    void close() override;
+};
+
+#endif // SD_BLOCK_STORAGE_H
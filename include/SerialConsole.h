@@ -0,0 +1,22 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <Arduino.h>
+#include "Console.h"
+
+/**
+ * @brief Console backed by the Arduino Serial port (USB CDC on the AtomS3)
+ *
+ * begin() does not wait for a USB host (it returns false while none is connected),
+ * and writes never block on a missing host.
+ */
+class SerialConsole : public Console {
+public:
+    bool begin(uint32_t baudRate) override;
+    void print(const char* text) override;
+    void println(const char* text) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    int read() override;
+};
+
+#endif // SERIAL_CONSOLE_H
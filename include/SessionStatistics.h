@@ -0,0 +1,138 @@
+#ifndef SESSION_STATISTICS_H
+#define SESSION_STATISTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "P2Quantile.h"
+#include "WireFormat.h"
+
+/**
+ * @brief Everything SessionStatistics needs to resume a session, as persisted
+ */
+struct SessionRecord {
+    uint32_t samples;            // Measurements in the session
+    uint32_t durationMs;         // Time covered
+    double mean;                 // Welford running mean (m/s)
+    double m2;                   // Welford sum of squared deviations
+    float min;                   // Lowest speed (m/s)
+    float max;                   // Highest speed (m/s)
+    float weibullK;              // Last fit, 0 if none
+    float weibullC;
+    P2Quantile::State quantiles[3];   // p50, p90, p99 markers
+    uint32_t histogram[WireFormat::MAX_SUMMARY_BINS];
+};
+
+/**
+ * @brief Wind speed statistics of the whole session, updated in O(1) per sample.
+ *
+ * WindStatistics answers for the last 10 min; this class keeps what a receiver
+ * would otherwise have to accumulate itself from the 0.5 Hz frames, and lose when
+ * it reboots: Welford mean and variance (no cancellation over millions of
+ * samples), the extremes, a fixed-bin histogram and three percentiles estimated
+ * by P² markers. Nothing grows with the session: the state is a SessionRecord of
+ * about 360 bytes, exported as-is to survive a reboot of the anemometer.
+ *
+ * The Weibull fit is the only step that is not O(1): fitWeibull() solves the
+ * maximum-likelihood equation over the histogram bins, so its cost depends on the
+ * bin count, not on the session length. It is called periodically, not per sample.
+ */
+class SessionStatistics {
+public:
+    static constexpr float BIN_WIDTH = 0.5f;                   // Histogram bin width (m/s)
+    static const size_t BINS = WireFormat::MAX_SUMMARY_BINS;  // 0 to 24 m/s, the last bin open-ended
+    static const size_t QUANTILES = 3;                        // p50, p90, p99
+    static const uint32_t MAX_GAP_MS = 5000;                  // Longer gaps between samples are not session time
+    static const uint32_t MIN_FIT_SAMPLES = 100;              // Samples needed before fitting
+
+private:
+    static const float QUANTILE_P[QUANTILES];
+
+    uint32_t samples_;
+    uint32_t durationMs_;
+    bool started_;               // A sample was added since the construction, reset or import
+    uint32_t lastMs_;            // Its time stamp
+    double mean_;                // Welford running mean
+    double m2_;                  // Welford sum of squared deviations from the mean
+    float min_;
+    float max_;
+    float weibullK_;
+    float weibullC_;
+    P2Quantile quantiles_[QUANTILES];
+    uint32_t histogram_[BINS];
+
+public:
+    SessionStatistics();
+
+    /**
+     * @brief Start a new session
+     */
+    void reset();
+
+    /**
+     * @brief Add one wind speed sample
+     * @param windSpeed Wind speed (m/s)
+     * @param timestampMs Acquisition time (ms, monotonic)
+     */
+    void addSample(float windSpeed, uint32_t timestampMs);
+
+    /**
+     * @brief Fit the Weibull distribution to the histogram (maximum likelihood)
+     * @return false if there are too few samples or the speeds do not spread over two bins;
+     *         the previous fit is kept then
+     */
+    bool fitWeibull();
+
+    /**
+     * @brief Measurements in the session
+     */
+    uint32_t samples() const;
+
+    /**
+     * @brief Mean wind speed (m/s)
+     */
+    float mean() const;
+
+    /**
+     * @brief Sample standard deviation of the wind speed (m/s), 0 below two samples
+     */
+    float stddev() const;
+
+    /**
+     * @brief Weibull shape of the last fit, 0 if none
+     */
+    float weibullK() const;
+
+    /**
+     * @brief Weibull scale of the last fit (m/s), 0 if none
+     */
+    float weibullC() const;
+
+    /**
+     * @brief Estimated quantile
+     * @param index 0 for p50, 1 for p90, 2 for p99
+     */
+    float quantile(size_t index) const;
+
+    /**
+     * @brief Samples in one histogram bin
+     */
+    uint32_t binCount(size_t bin) const;
+
+    /**
+     * @brief Fill a summary frame (all but the MAC address)
+     */
+    void summary(SessionSummary& out) const;
+
+    /**
+     * @brief Copy the state, to persist it
+     */
+    void exportRecord(SessionRecord& record) const;
+
+    /**
+     * @brief Resume a session saved by exportRecord()
+     * @return false (and the session is left alone) if the record is not consistent
+     */
+    bool importRecord(const SessionRecord& record);
+};
+
+#endif // SESSION_STATISTICS_H
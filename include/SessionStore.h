@@ -0,0 +1,31 @@
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include "SessionStatistics.h"
+
+/**
+ * @brief Persistent copy of the session statistics, so a reboot of the anemometer
+ * does not start a new session.
+ *
+ * Implemented with RTC memory and NVS on the device (EspSessionStore).
+ */
+class SessionStore {
+public:
+    virtual ~SessionStore() {}
+
+    /**
+     * @brief Read the saved session
+     * @return false if nothing valid is saved
+     */
+    virtual bool load(SessionRecord& record) = 0;
+
+    /**
+     * @brief Save the session
+     * @param record Session state
+     * @param flash Also write the non-volatile copy (slow: do it rarely)
+     * @return false if it could not be written
+     */
+    virtual bool save(const SessionRecord& record, bool flash) = 0;
+};
+
+#endif // SESSION_STORE_H
@@ -0,0 +1,39 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <stdint.h>
+#include "WireFormat.h"
+
+/**
+ * @brief What the control channel keeps across power cycles
+ */
+struct ControlRecord {
+    uint32_t counter;          // Last command counter accepted, so old commands cannot be replayed
+    uint8_t groups;            // SET_* groups changed over the air, re-applied at boot
+    DeviceSettings settings;   // Settings in force when saved
+};
+
+/**
+ * @brief Persistent copy of the settings changed over the control channel.
+ *
+ * Implemented with NVS on the device (EspSettingsStore). Written only by commands
+ * that change something, so rarely.
+ */
+class SettingsStore {
+public:
+    virtual ~SettingsStore() {}
+
+    /**
+     * @brief Read the saved record
+     * @return false if nothing valid is saved
+     */
+    virtual bool load(ControlRecord& record) = 0;
+
+    /**
+     * @brief Save the record
+     * @return false if it could not be written
+     */
+    virtual bool save(const ControlRecord& record) = 0;
+};
+
+#endif // SETTINGS_STORE_H
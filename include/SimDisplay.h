@@ -0,0 +1,69 @@
+#ifndef SIM_DISPLAY_H
+#define SIM_DISPLAY_H
+
+#include "DisplayDevice.h"
+
+/**
+ * @brief Headless DisplayDevice for host builds.
+ *
+ * Text calls are only counted (the pixels they would write are estimated), while
+ * fillScreen() and pushImage() also update a frame buffer, so rendered frames can
+ * be checked or saved as an image. Counters compare rendering strategies.
+ */
+class SimDisplay : public DisplayDevice {
+public:
+    static const int16_t WIDTH = 128;   // AtomS3 LCD
+    static const int16_t HEIGHT = 128;
+    static const int16_t CHAR_WIDTH = 6; // Default font cell at text size 1
+    static const int16_t CHAR_HEIGHT = 8;
+
+private:
+    uint8_t textSize_;      // Current text size
+    uint32_t calls_;        // Drawing calls
+    uint32_t pixels_;       // Pixels written (estimate for text)
+    uint16_t frame_[WIDTH * HEIGHT]; // Screen contents (fillScreen and pushImage only)
+
+    void drawText(const char* text);
+
+public:
+    SimDisplay();
+
+    int16_t width() override;
+    int16_t height() override;
+    void fillScreen(uint16_t color) override;
+    void setTextSize(uint8_t size) override;
+    void setTextColor(uint16_t color) override;
+    void setCursor(int16_t x, int16_t y) override;
+    void print(const char* text) override;
+    void println(const char* text) override;
+    int16_t textWidth(const char* text) override;
+    void pushImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) override;
+
+    /**
+     * @brief Color of a screen pixel
+     */
+    uint16_t pixel(int16_t x, int16_t y) const;
+
+    /**
+     * @brief Save the frame buffer as a binary PPM image
+     * @return true if the file was written
+     */
+    bool writePpm(const char* path) const;
+
+    /**
+     * @brief Number of drawing calls since construction or reset()
+     */
+    uint32_t calls() const;
+
+    /**
+     * @brief Number of pixels written since construction or reset()
+     */
+    uint32_t pixels() const;
+
+    /**
+     * @brief Clear the counters
+     */
+    void reset();
+};
+
+#endif // SIM_DISPLAY_H
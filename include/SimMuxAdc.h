@@ -0,0 +1,101 @@
+#ifndef SIM_MUX_ADC_H
+#define SIM_MUX_ADC_H
+
+#include "AdcSource.h"
+#include "VirtualClock.h"
+
+/**
+ * @brief Simulated ADS1115 with its input multiplexer, for host builds.
+ *
+ * Single-shot conversions only, timed like the real part on a VirtualClock: each
+ * I2C register access advances the clock by its bus time, a conversion lasts the
+ * nominal period stretched by the oscillator error plus a power-up delay, and the
+ * conversion register only changes when a conversion ends. A start written while a
+ * conversion runs is ignored (the ADS1115 ignores OS then) and counted. The code of
+ * a conversion is the signal of its input at the middle of the conversion.
+ */
+class SimMuxAdc : public AdcSource {
+public:
+    /**
+     * @brief Value of one input
+     * @param input Multiplexer input
+     * @param timeUs Middle of the conversion (VirtualClock::micros() base)
+     * @param context Context given to setSignal()
+     * @return Conversion code
+     */
+    typedef int16_t (*Signal)(uint8_t input, uint32_t timeUs, void* context);
+
+    static const uint8_t INPUTS = 8;          // ADS1115 multiplexer settings
+    static const uint32_t POWER_UP_US = 25;   // Single-shot wake-up before the conversion
+
+private:
+    VirtualClock& clock_;       // Time advanced by the bus accesses
+    Signal signal_;             // Input values, nullptr for all zero
+    void* context_;             // Signal context
+    uint16_t sampleRate_;       // Data rate (SPS)
+    float oscillatorError_;     // Relative conversion time error (0.1 = 10 % slow)
+    uint32_t writeUs_;          // Register write on the bus
+    uint32_t readUs_;           // Register read on the bus (pointer write + 2 bytes)
+    bool singleShot_;           // Single-shot mode selected
+    bool converting_;           // A conversion runs until endUs_
+    uint8_t input_;             // Input of that conversion
+    uint64_t startUs_;          // Its start
+    uint64_t endUs_;            // Its end
+    int16_t register_;          // Conversion register
+    uint32_t conversions_;      // Conversions completed
+    uint32_t ignoredStarts_;    // Starts written while a conversion was running
+    uint64_t busyUs_;           // Time spent converting
+
+    /**
+     * @brief Latch the running conversion if it ended
+     */
+    void update();
+
+public:
+    /**
+     * @brief Construct a new SimMuxAdc object
+     * @param clock Virtual time source
+     * @param writeUs Bus time of a register write (4 bytes at 400 kHz)
+     * @param readUs Bus time of a register read (pointer write and 3 bytes at 400 kHz)
+     */
+    SimMuxAdc(VirtualClock& clock, uint32_t writeUs = 95, uint32_t readUs = 120);
+
+    /**
+     * @brief Set the input values
+     */
+    void setSignal(Signal signal, void* context);
+
+    /**
+     * @brief Stretch every conversion (internal oscillator error, within 10 % on the ADS1115)
+     * @param error Relative error, 0.1 for 10 % slow
+     */
+    void setOscillatorError(float error);
+
+    bool begin() override;
+    bool startSingleShot(uint16_t samplesPerSecond) override;
+    bool startContinuous(uint16_t samplesPerSecond) override;
+    int16_t readSingle() override;
+    bool readConversion(int16_t& code) override;
+    uint16_t sampleRate() const override;
+    float millivoltsPerCode() const override;
+    uint8_t inputCount() const override;
+    bool startConversion(uint8_t input) override;
+    bool readResult(int16_t& code) override;
+
+    /**
+     * @brief Conversions completed
+     */
+    uint32_t conversions() const;
+
+    /**
+     * @brief Starts ignored because a conversion was running
+     */
+    uint32_t ignoredStarts() const;
+
+    /**
+     * @brief Time spent converting (us)
+     */
+    uint64_t busyUs() const;
+};
+
+#endif // SIM_MUX_ADC_H
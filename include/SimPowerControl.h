@@ -0,0 +1,62 @@
+#ifndef SIM_POWER_CONTROL_H
+#define SIM_POWER_CONTROL_H
+
+#include "PowerControl.h"
+#include "VirtualClock.h"
+
+/**
+ * @brief Simulated sleep states for host builds.
+ *
+ * Sleeping advances a VirtualClock. A light sleep ends late by a fixed wake-up delay
+ * plus a reproducible random jitter, like the ESP32 restoring its clocks; an idle
+ * wait is exact. scheduleAlert() stands for the converter ALERT/RDY pin: it ends the
+ * current or next sleep at that time (plus the wake-up delay from light sleep).
+ */
+class SimPowerControl : public PowerControl {
+private:
+    VirtualClock& clock_;      // Time advanced by the sleeps
+    uint32_t wakeDelayUs_;     // Fixed part of the light-sleep wake-up delay
+    uint32_t jitterUs_;        // Random part of the light-sleep wake-up delay
+    uint32_t seed_;            // Jitter generator state
+    bool alertPending_;        // An ALERT is scheduled
+    uint64_t alertAtUs_;       // Virtual time of the scheduled ALERT
+    bool radioPowerSave_;      // Modem sleep requested
+    uint32_t lightSleeps_;     // Light sleeps entered
+    uint32_t idles_;           // Idle waits
+
+public:
+    /**
+     * @brief Construct a new SimPowerControl object
+     * @param clock Virtual time source
+     * @param wakeDelayUs Fixed light-sleep wake-up delay
+     * @param jitterUs Random extra delay, 0..jitterUs
+     * @param seed Seed of the jitter
+     */
+    SimPowerControl(VirtualClock& clock, uint32_t wakeDelayUs = 400, uint32_t jitterUs = 200, uint32_t seed = 1);
+
+    WakeSource sleep(SleepMode mode, uint32_t durationUs) override;
+    bool setRadioPowerSave(bool enabled) override;
+
+    /**
+     * @brief Raise the ALERT pin at a given time (one-shot)
+     * @param atUs Virtual time (VirtualClock::nowUs() base)
+     */
+    void scheduleAlert(uint64_t atUs);
+
+    /**
+     * @brief Modem sleep requested
+     */
+    bool radioPowerSave() const;
+
+    /**
+     * @brief Light sleeps entered
+     */
+    uint32_t lightSleeps() const;
+
+    /**
+     * @brief Idle waits
+     */
+    uint32_t idles() const;
+};
+
+#endif // SIM_POWER_CONTROL_H
@@ -0,0 +1,119 @@
+#ifndef SIM_RADIO_H
+#define SIM_RADIO_H
+
+#include "RadioTransport.h"
+
+/**
+ * @brief Simulated radio for host builds.
+ *
+ * Frames are kept in a small history instead of being transmitted, and a fraction of
+ * them can be dropped with a reproducible pseudo-random pattern to exercise the
+ * receiver side (sequence gaps). receive() injects frames from other stations.
+ *
+ * With a send handler registered, the radio behaves like the ESP-NOW driver: a queue
+ * of setDriver() depth, frames leaving one after the other with a fixed air time, and
+ * completions reported (lost frames as failures) when advance() passes their time.
+ */
+class SimRadio : public RadioTransport {
+public:
+    static const size_t HISTORY_SIZE = 16;   // Frames kept for inspection
+    static const size_t MAX_FRAME = 250;     // ESP-NOW payload limit
+    static const size_t MAX_QUEUE = 32;      // Largest simulated driver queue
+
+    struct Frame {
+        uint8_t destination[MAC_SIZE];
+        uint8_t data[MAX_FRAME];
+        size_t length;
+    };
+
+private:
+    uint8_t mac_[MAC_SIZE];         // Simulated station address
+    float lossRate_;                // Fraction of frames dropped, 0..1
+    uint32_t seed_;                 // Loss pattern generator state
+    Frame history_[HISTORY_SIZE];   // Most recent delivered frames
+    uint32_t sent_;                 // Frames accepted by send()
+    uint32_t lost_;                 // Frames dropped by the loss model
+    ReceiveHandler handler_;        // Handler of injected frames
+    void* context_;                 // Handler context
+    SendHandler sendHandler_;       // Handler of send completions
+    void* sendContext_;             // Completion handler context
+    size_t queueDepth_;             // Simulated driver queue depth
+    uint32_t airtimeUs_;            // Time each frame takes to leave
+    uint32_t nowUs_;                // Simulated time, set by advance()
+    uint32_t pendingDueUs_[MAX_QUEUE];     // Completion times of the queued frames
+    bool pendingDelivered_[MAX_QUEUE];     // Completion status of the queued frames
+    uint32_t pendingHead_;          // Frames queued
+    uint32_t pendingTail_;          // Frames completed
+
+public:
+    /**
+     * @brief Construct a new SimRadio object
+     * @param mac Simulated MAC address, nullptr for 02:00:00:00:00:01
+     */
+    SimRadio(const uint8_t mac[MAC_SIZE] = nullptr);
+
+    bool begin() override;
+    SendStatus send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) override;
+    void macAddress(uint8_t mac[MAC_SIZE]) override;
+    bool setReceiveHandler(ReceiveHandler handler, void* context) override;
+    bool setSendHandler(SendHandler handler, void* context) override;
+
+    /**
+     * @brief Shape the simulated driver queue
+     * @param queueDepth Frames the driver holds before refusing (Busy), up to MAX_QUEUE
+     * @param airtimeUs Time each frame takes to leave the radio
+     */
+    void setDriver(size_t queueDepth, uint32_t airtimeUs);
+
+    /**
+     * @brief Move the simulated time and report the completions due by then
+     * @param nowUs Local time (micros())
+     */
+    void advance(uint32_t nowUs);
+
+    /**
+     * @brief Frames queued in the simulated driver
+     */
+    size_t pending() const;
+
+    /**
+     * @brief Deliver a frame from another station to the receive handler
+     * @param source Sender MAC address
+     * @param data Frame bytes
+     * @param length Frame length
+     * @param rxUs Local time of reception
+     * @return true if a handler took it
+     */
+    bool receive(const uint8_t source[MAC_SIZE], const uint8_t* data, size_t length, uint32_t rxUs);
+
+    /**
+     * @brief Drop a fraction of the frames
+     * @param lossRate Probability of loss per frame, 0..1
+     * @param seed Seed of the loss pattern
+     */
+    void setLossRate(float lossRate, uint32_t seed = 1);
+
+    /**
+     * @brief Number of frames accepted by send()
+     */
+    uint32_t sent() const;
+
+    /**
+     * @brief Number of frames dropped by the loss model
+     */
+    uint32_t lost() const;
+
+    /**
+     * @brief Number of frames delivered (sent - lost)
+     */
+    uint32_t delivered() const;
+
+    /**
+     * @brief Access a delivered frame
+     * @param age 0 for the most recent, up to HISTORY_SIZE - 1
+     * @return Frame, or nullptr if fewer frames were delivered
+     */
+    const Frame* frame(size_t age) const;
+};
+
+#endif // SIM_RADIO_H
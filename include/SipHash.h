@@ -0,0 +1,31 @@
+#ifndef SIP_HASH_H
+#define SIP_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief SipHash-2-4 keyed hash (Aumasson and Bernstein), used as a message
+ * authentication code for the control frames.
+ *
+ * A 128-bit key and a 64-bit tag: made for short messages, a few hundred cycles
+ * for a control frame, no table and no dependency, so receivers and host tools
+ * compute the same tag as the firmware. Not a cipher: frames stay readable.
+ */
+namespace SipHash {
+
+static const size_t KEY_SIZE = 16;   // Key bytes
+static const size_t TAG_SIZE = 8;    // Hash bytes
+
+/**
+ * @brief SipHash-2-4 of a message
+ * @param key 16-byte key
+ * @param data Message bytes
+ * @param length Message length
+ * @return 64-bit tag (little-endian on the wire, as the reference implementation)
+ */
+uint64_t hash(const uint8_t key[KEY_SIZE], const uint8_t* data, size_t length);
+
+} // namespace SipHash
+
+#endif // SIP_HASH_H
@@ -0,0 +1,174 @@
+#ifndef SLOT_SCHEDULER_H
+#define SLOT_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Per-slot reception statistics seen from one node
+ */
+struct SlotStats {
+    uint32_t received;   // Neighbour frames heard starting in this slot
+    uint32_t missed;     // Neighbour frames missing from the sequence numbers heard in this slot
+    uint8_t occupants;   // Neighbours heard in this slot within the busy window
+};
+
+/**
+ * @brief Slotted (TDMA) transmit times for a fleet of anemometers on one channel.
+ *
+ * Time is cut into superframes of SLOT_COUNT slots, on the local microsecond clock.
+ * The superframe length is a power of two, so the slot phase survives the 32-bit
+ * micros() wrap-around. Each node starts in a slot derived from its MAC address and
+ * sends only inside it, at a random dither so two nodes sharing a slot cannot stay
+ * deaf to each other. The wake-up lateness is measured and the target moved earlier
+ * by its running average (jitter compensation).
+ *
+ * Neighbour frames refine the choice: their start phase marks the slots they use,
+ * and their sequence numbers give a per-slot loss estimate. When a neighbour is heard
+ * in our slot, the node with the higher MAC moves to a random free slot; the other
+ * keeps its slot, so a pair never chases each other. Clocks are not synchronized:
+ * slots are only meaningful relative to the local clock, which is enough because a
+ * neighbour overlapping us is seen overlapping whatever the time origin.
+ *
+ * Not thread-safe: observe() and the transmit calls must come from one task.
+ */
+class SlotScheduler {
+public:
+    static const size_t MAC_SIZE = 6;
+    static const uint16_t SLOT_COUNT = 64;                  // Slots per superframe
+    static const uint32_t SLOT_US = 2048;                   // Slot length
+    static const uint32_t SUPERFRAME_US = SLOT_COUNT * SLOT_US; // 131 ms, divides 2^32
+    static const uint32_t FRAME_AIRTIME_US = 800;           // ESP-NOW anemometer frame at 1 Mbps
+    static const uint32_t GUARD_US = 256;                   // Clear time kept before the next slot
+    static const uint32_t LATEST_START_US = SLOT_US - FRAME_AIRTIME_US - GUARD_US; // Last start offset
+    static const uint32_t DITHER_US = 512;                  // Random start offset range
+    static const uint32_t BUSY_SUPERFRAMES = 96;            // 12.6 s, longer than the 10 s heartbeat
+    static const size_t NEIGHBOUR_COUNT = 64;               // Neighbours tracked (a 50-node fleet)
+
+private:
+    struct Neighbour {
+        uint8_t mac[MAC_SIZE];
+        uint16_t lastSequence;
+        uint16_t slot;
+        uint16_t lastSuperframe;
+        bool valid;
+    };
+
+    uint8_t mac_[MAC_SIZE];            // This node
+    uint16_t slot_;                    // Current slot
+    uint32_t seed_;                    // Dither and reselection generator
+    uint32_t dither_;                  // Start offset of the next send within the slot
+    uint32_t leadUs_;                  // Average wake-up lateness, subtracted from the target
+    uint32_t maxLatenessUs_;           // Worst wake-up lateness
+    uint32_t sends_;                   // Frames sent in the slot
+    uint32_t missedSlots_;             // Slots missed because the wake-up was too late
+    uint32_t conflicts_;               // Neighbours heard in our slot
+    uint32_t reselections_;            // Slot changes
+    Neighbour neighbours_[NEIGHBOUR_COUNT];
+    SlotStats slots_[SLOT_COUNT];
+    uint16_t heardSuperframe_[SLOT_COUNT]; // Superframe a neighbour was last heard in each slot
+    bool heard_[SLOT_COUNT];               // heardSuperframe_ is valid
+
+    uint32_t random();
+    static uint16_t superframe(uint32_t us);
+    bool busy(uint16_t slot, uint16_t now) const;
+    void markHeard(uint16_t slot, uint16_t now);
+    Neighbour& neighbour(const uint8_t mac[MAC_SIZE], uint16_t now, bool& known);
+    void reselect(uint16_t now);
+
+public:
+    SlotScheduler();
+
+    /**
+     * @brief Derive the initial slot from the MAC address and clear the history
+     * @param mac MAC address of this node
+     */
+    void begin(const uint8_t mac[MAC_SIZE]);
+
+    /**
+     * @brief Initial slot of a MAC address (FNV-1a hash)
+     */
+    static uint16_t slotForMac(const uint8_t mac[MAC_SIZE]);
+
+    /**
+     * @brief Current slot
+     */
+    uint16_t slot() const;
+
+    /**
+     * @brief Time to wait before sending
+     * @param nowUs Local time (micros())
+     * @return 0 if the slot is open now, else the delay to this node's next send point
+     */
+    uint32_t delayUs(uint32_t nowUs) const;
+
+    /**
+     * @brief Check that a send starting now stays inside the slot
+     * @param nowUs Local time (micros())
+     */
+    bool maySend(uint32_t nowUs) const;
+
+    /**
+     * @brief Record a frame sent in the slot, for the jitter compensation
+     * @param nowUs Time the frame was handed to the radio
+     * @param targetUs Time the sender aimed at (nowUs + delayUs() when it started waiting)
+     */
+    void recordSend(uint32_t nowUs, uint32_t targetUs);
+
+    /**
+     * @brief Record a wake-up too late for the slot (the frame waits one superframe)
+     */
+    void recordMissedSlot();
+
+    /**
+     * @brief Account for a frame heard from another anemometer
+     * @param mac Sender MAC address
+     * @param sequence Sender sequence number
+     * @param rxUs Local time the frame was received (end of the frame)
+     */
+    void observe(const uint8_t mac[MAC_SIZE], uint16_t sequence, uint32_t rxUs);
+
+    /**
+     * @brief Statistics of one slot, occupants counted at the given time
+     * @param slot Slot index, below SLOT_COUNT
+     * @param nowUs Local time
+     */
+    SlotStats slotStats(uint16_t slot, uint32_t nowUs) const;
+
+    /**
+     * @brief Loss estimate of one slot from the neighbour sequence numbers (0..1)
+     */
+    float lossEstimate(uint16_t slot) const;
+
+    /**
+     * @brief Frames sent in the slot
+     */
+    uint32_t sends() const;
+
+    /**
+     * @brief Slots missed because the sender woke up too late
+     */
+    uint32_t missedSlots() const;
+
+    /**
+     * @brief Neighbour frames heard overlapping our slot
+     */
+    uint32_t conflicts() const;
+
+    /**
+     * @brief Slot changes after a conflict
+     */
+    uint32_t reselections() const;
+
+    /**
+     * @brief Current jitter compensation (average lateness, us)
+     */
+    uint32_t leadUs() const;
+
+    /**
+     * @brief Worst wake-up lateness seen (us)
+     */
+    uint32_t maxLatenessUs() const;
+};
+
+#endif // SLOT_SCHEDULER_H
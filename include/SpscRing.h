@@ -0,0 +1,120 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Fixed-size single-producer/single-consumer ring buffer.
+ *
+ * One context (timer callback, reader task or ISR-deferred task) pushes, one other
+ * context pops. Head and tail are only ever written by their owner, so no lock is
+ * needed. When the ring is full new items are rejected and counted as overruns.
+ * The producer also records the highest fill level seen (high-water mark), which
+ * tells how close each hand-off came to overflowing.
+ *
+ * @tparam T Element type (trivially copyable)
+ * @tparam N Capacity, must be a power of two
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    T items_[N];
+    std::atomic<uint32_t> head_;      // Next slot to write (producer owned)
+    std::atomic<uint32_t> tail_;      // Next slot to read (consumer owned)
+    std::atomic<uint32_t> overruns_;  // Items rejected because the ring was full
+    std::atomic<uint32_t> highWater_; // Highest fill level seen by the producer
+
+public:
+    SpscRing() : head_(0), tail_(0), overruns_(0), highWater_(0) {}
+
+    /**
+     * @brief Push one item (producer side)
+     * @param item Item to store
+     * @return true if stored, false if the ring was full
+     */
+    bool push(const T& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t tail = tail_.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        uint32_t fill = head + 1 - tail;
+        if (fill > highWater_.load(std::memory_order_relaxed)) {
+            highWater_.store(fill, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Pop one item (consumer side)
+     * @param item Receives the oldest item
+     * @return true if an item was available
+     */
+    bool pop(T& item) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t head = head_.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to maxItems items in one go (consumer side)
+     * @param out Destination array
+     * @param maxItems Size of the destination array
+     * @return Number of items copied
+     */
+    size_t popBulk(T* out, size_t maxItems) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t head = head_.load(std::memory_order_acquire);
+        size_t count = head - tail;
+        if (count > maxItems) {
+            count = maxItems;
+        }
+        for (size_t i = 0; i < count; i++) {
+            out[i] = items_[(tail + i) & (N - 1)];
+        }
+        tail_.store(tail + static_cast<uint32_t>(count), std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Number of items currently stored (approximate when called concurrently)
+     */
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of push attempts rejected since construction
+     */
+    uint32_t overruns() const {
+        return overruns_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Highest number of items held at once since construction
+     */
+    uint32_t highWater() const {
+        return highWater_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Capacity of the ring
+     */
+    static constexpr size_t capacity() {
+        return N;
+    }
+};
+
+#endif // SPSC_RING_H
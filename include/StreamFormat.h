@@ -0,0 +1,126 @@
+#ifndef STREAM_FORMAT_H
+#define STREAM_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Binary raw sample stream over the USB serial port.
+ *
+ * Every packet ends with a CRC-32 of its bytes, is COBS-encoded (no zero byte
+ * inside) and followed by a single 0x00 delimiter, so a reader can start anywhere,
+ * resynchronise on the next zero and skip any text that slipped in between.
+ * All values are little-endian.
+ *
+ * Samples packet (before COBS):
+ * | Offset | Size | Content                                                  |
+ * |--------|------|----------------------------------------------------------|
+ * | 0      | 1    | Packet type (TYPE_SAMPLES)                               |
+ * | 1      | 1    | Format version                                           |
+ * | 2      | 2    | Packet sequence number (dropped packets leave a gap)     |
+ * | 4      | 4    | Index of the first code (every conversion counted)       |
+ * | 8      | 4    | Time of the first code (us)                              |
+ * | 12     | 4    | Time of the last code (us), codes are evenly spaced      |
+ * | 16     | 2    | Codes dropped just before this packet (saturating)       |
+ * | 18     | 1    | Code count n (1..MAX_CODES)                              |
+ * | 19     | 2 n  | Raw codes (int16)                                        |
+ * | 19+2n  | 4    | CRC-32 of the bytes before                               |
+ *
+ * Info packet, sent when the stream starts and every INFO_EVERY packets:
+ * | Offset | Size | Content                                                  |
+ * |--------|------|----------------------------------------------------------|
+ * | 0      | 1    | Packet type (TYPE_INFO)                                  |
+ * | 1      | 1    | Format version                                           |
+ * | 2      | 2    | Sequence number of the next samples packet               |
+ * | 4      | 6    | MAC address                                              |
+ * | 10     | 2    | ADC data rate (SPS)                                      |
+ * | 12     | 4    | mV per ADC code (float)                                  |
+ * | 16     | 4    | CRC-32 of the bytes before                               |
+ *
+ * A sequence gap with no dropped count means packets were lost on the link; a
+ * dropped count means the device could not hand them to the serial writer.
+ * This header and StreamFormat.cpp have no dependency on Arduino.
+ */
+namespace StreamFormat {
+
+static const uint8_t VERSION = 1;
+static const uint8_t TYPE_SAMPLES = 1;
+static const uint8_t TYPE_INFO = 2;
+static const uint8_t DELIMITER = 0x00;
+
+static const size_t MAX_CODES = 64;                          // Codes per samples packet
+static const size_t SAMPLES_HEADER_SIZE = 19;
+static const size_t INFO_SIZE = 20;                          // Info packet, CRC included
+static const size_t CRC_SIZE = 4;
+static const size_t MAX_PACKET_SIZE = SAMPLES_HEADER_SIZE + 2 * MAX_CODES + CRC_SIZE;
+static const size_t MAX_FRAME_SIZE = MAX_PACKET_SIZE + MAX_PACKET_SIZE / 254 + 2; // COBS + delimiter
+static const uint32_t INFO_EVERY = 256;                      // Samples packets between two info packets
+
+/**
+ * @brief Header of a samples packet
+ */
+struct SamplesHeader {
+    uint16_t sequence;       // Packet sequence number
+    uint32_t firstIndex;     // Index of the first code since the stream started
+    uint32_t firstUs;        // Time of the first code
+    uint32_t lastUs;         // Time of the last code
+    uint16_t dropped;        // Codes dropped just before this packet
+    uint8_t count;           // Codes in the packet
+};
+
+/**
+ * @brief Contents of an info packet
+ */
+struct StreamInfo {
+    uint16_t nextSequence;   // Sequence number of the next samples packet
+    uint8_t macAddress[6];   // Streaming device
+    uint16_t sampleRate;     // ADC data rate (SPS)
+    float millivoltsPerCode; // Scale of the raw codes
+};
+
+/**
+ * @brief COBS-encode a packet and append the delimiter
+ * @param capacity Size of out, at least length + length / 254 + 2
+ * @return Frame length, delimiter included, 0 if out is too small
+ */
+size_t cobsEncode(const uint8_t* packet, size_t length, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode one COBS frame (delimiter excluded)
+ * @return Packet length, 0 if the frame is malformed or out is too small
+ */
+size_t cobsDecode(const uint8_t* frame, size_t length, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Build a framed samples packet (CRC, COBS and delimiter)
+ * @param out Output buffer of at least MAX_FRAME_SIZE bytes
+ * @return Frame length, 0 if count is 0 or above MAX_CODES
+ */
+size_t encodeSamples(const SamplesHeader& header, const int16_t* codes, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Build a framed info packet
+ * @return Frame length, 0 if out is too small
+ */
+size_t encodeInfo(const StreamInfo& info, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Packet type of a decoded packet whose CRC is correct
+ * @return TYPE_SAMPLES, TYPE_INFO, or 0 if the packet is damaged or unknown
+ */
+uint8_t checkPacket(const uint8_t* packet, size_t length);
+
+/**
+ * @brief Parse a checked samples packet
+ * @param codes Receives header.count codes (MAX_CODES room)
+ */
+bool decodeSamples(const uint8_t* packet, size_t length, SamplesHeader& header, int16_t* codes);
+
+/**
+ * @brief Parse a checked info packet
+ */
+bool decodeInfo(const uint8_t* packet, size_t length, StreamInfo& info);
+
+} // namespace StreamFormat
+
+#endif // STREAM_FORMAT_H
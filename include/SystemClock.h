@@ -0,0 +1,22 @@
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include "Clock.h"
+
+/**
+ * @brief Clock backed by std::chrono::steady_clock (host builds)
+ */
+class SystemClock : public Clock {
+public:
+    SystemClock();
+
+    uint32_t millis() override;
+    uint32_t micros() override;
+    void delayMs(uint32_t ms) override;
+    void delayUs(uint32_t us) override;
+
+private:
+    int64_t startUs_;   // steady_clock time at construction
+};
+
+#endif // SYSTEM_CLOCK_H
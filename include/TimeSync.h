@@ -0,0 +1,167 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WireFormat.h"
+
+/**
+ * @brief Offset and drift of the local microsecond clock against a reference node.
+ *
+ * One node (the reference) broadcasts a time beacon every BEACON_PERIOD_US. The
+ * queue delay before a frame reaches the air varies by milliseconds, so beacons are
+ * two-step: each one carries the reference time the previous beacon left the air,
+ * from the radio's send completion. Followers keep the receive time of the last
+ * beacon and pair it with that departure time when the next one arrives, which
+ * leaves only the completion and receive handler jitter. They fit a line through the
+ * last WINDOW pairs (least squares): the offset at the newest pair and the drift,
+ * which carries the conversion between beacons. Once synchronised, a pair far from
+ * the fit is discarded as an outlier; several in a row mean the reference clock
+ * jumped, and the fit restarts.
+ *
+ * Followers lock on the first reference heard and move to another one only after
+ * REFERENCE_TIMEOUT_US without its beacons. Pure logic, no clock or radio: the
+ * caller passes the times. Not thread-safe: one task (Communication's sending task).
+ */
+class TimeSync {
+public:
+    enum class Role : uint8_t {
+        Follower,   // Converts its time to the reference clock
+        Reference   // Sends the beacons; its clock is the reference
+    };
+
+    static const size_t MAC_SIZE = 6;
+    static const size_t WINDOW = 16;                      // Beacon pairs in the fit
+    static const size_t MIN_BEACONS = 3;                  // Pairs before the drift is trusted
+    static const uint32_t BEACON_PERIOD_US = 1000000;     // Reference beacon period
+    static const uint32_t REFERENCE_TIMEOUT_US = 10000000; // Silence before following another reference
+    static const uint32_t MAX_BEACON_AGE_US = 60000000;   // Longest time the fit is used without a beacon
+    static const uint32_t OUTLIER_US = 200;               // Smallest residual counted as an outlier
+    static const uint8_t MAX_OUTLIERS = 3;                // Outliers in a row that restart the fit
+    static const uint16_t MAX_ERROR_US = 0xFFFE;          // Error estimate saturation
+
+private:
+    struct Point {
+        uint32_t localUs;    // Receive time, local clock
+        uint32_t offsetUs;   // Reference minus local at that time (wrapping)
+    };
+
+    Role role_;
+    uint8_t mac_[MAC_SIZE];            // This node
+    uint8_t referenceMac_[MAC_SIZE];   // Reference followed
+    bool hasReference_;
+    uint16_t nextSequence_;            // Reference: next beacon; follower: expected beacon
+    uint32_t lastBeaconUs_;            // Reference: last beacon sent; follower: last beacon received
+    bool hasLastBeacon_;               // Follower: lastBeaconUs_ waits for its departure time
+    uint16_t lastSequence_;            // Follower: sequence of that beacon
+
+    Point points_[WINDOW];             // Newest pairs, circular
+    size_t count_;
+    size_t next_;
+    uint32_t originUs_;                // Local time the fit is expressed around (newest pair)
+    uint32_t baseOffsetUs_;            // Offset at the newest pair (integer part of the fit)
+    float interceptUs_;                // Fit: offset(origin + x) = base + intercept + slope * x
+    float slope_;
+    float slopeErrorPpm_;              // Standard error of the drift
+    float residualUs_;                 // RMS distance of the pairs to the fit
+    uint8_t outliersInRow_;
+
+    uint32_t beacons_;                 // Beacons sent (reference) or pairs used (follower)
+    uint32_t lostBeacons_;             // Gaps in the beacon sequence numbers
+    uint32_t outliers_;                // Pairs discarded as outliers
+    uint32_t resets_;                  // Fit restarts (reference change or clock jump)
+
+    void restart();
+    void fit();
+    int32_t predictUs(uint32_t localUs) const;
+
+public:
+    TimeSync();
+
+    /**
+     * @brief Set this node's MAC address and role, and forget the fit
+     */
+    void begin(const uint8_t mac[MAC_SIZE], Role role);
+
+    /**
+     * @brief Role given to begin()
+     */
+    Role role() const;
+
+    /**
+     * @brief Reference: check whether the next beacon is due
+     * @param nowUs Local time
+     */
+    bool beaconDue(uint32_t nowUs) const;
+
+    /**
+     * @brief Reference: fill the next beacon
+     * @param nowUs Local time (the beacon period counts from it)
+     * @param previousSent true if the previous beacon was reported sent
+     * @param previousAirUs Local time the radio reported it sent
+     */
+    void makeBeacon(TimeBeacon& beacon, uint32_t nowUs, bool previousSent, uint32_t previousAirUs);
+
+    /**
+     * @brief Follower: account for a beacon
+     * @param beacon Decoded beacon
+     * @param rxUs Local time the frame was received (end of the frame)
+     * @return true if it completed a pair used in the fit
+     */
+    bool observe(const TimeBeacon& beacon, uint32_t rxUs);
+
+    /**
+     * @brief true when toReference() gives reference time: always on the reference, after
+     *        MIN_BEACONS pairs, the newest within MAX_BEACON_AGE_US, on a follower
+     * @param nowUs Local time
+     */
+    bool synced(uint32_t nowUs) const;
+
+    /**
+     * @brief Convert a local time to the reference clock (unchanged before the first pair)
+     */
+    uint32_t toReference(uint32_t localUs) const;
+
+    /**
+     * @brief Estimated error of toReference() at the given time (us): fit residual plus
+     *        the drift uncertainty since the newest pair, MAX_ERROR_US when not synced
+     */
+    uint16_t errorUs(uint32_t nowUs) const;
+
+    /**
+     * @brief Reference minus local time at the newest pair (us)
+     */
+    int32_t offsetUs() const;
+
+    /**
+     * @brief Drift of the local clock against the reference (ppm, positive when slower)
+     */
+    float driftPpm() const;
+
+    /**
+     * @brief RMS distance of the pairs to the fit (us)
+     */
+    float residualUs() const;
+
+    /**
+     * @brief Beacons sent (reference) or pairs used (follower)
+     */
+    uint32_t beacons() const;
+
+    /**
+     * @brief Beacons missing from the sequence numbers
+     */
+    uint32_t lostBeacons() const;
+
+    /**
+     * @brief Pairs discarded as outliers
+     */
+    uint32_t outliers() const;
+
+    /**
+     * @brief Fit restarts after a reference change or a clock jump
+     */
+    uint32_t resets() const;
+};
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,182 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hot-path tracing, off unless the build sets -DTRACE_ENABLED=1 (see platformio.ini).
+// When off, the TRACE_* macros expand to nothing and Trace does not exist.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+/**
+ * @brief Traced hot-path stages (Update includes Filter and Convert)
+ */
+enum class TraceStage : uint8_t {
+    Update = 0,      // Anemometer::update(): ring drain, raw samples, filter, conversion
+    Filter = 1,      // AdcFilter::process() over the codes of one update()
+    Convert = 2,     // Filtered codes to wind speed, statistics and analyzer input
+    Log = 3,         // Logger::logf() capture (or formatting, before startAsync())
+    Display = 4,     // DisplayRenderer::render()
+    MacAddress = 5,  // Reading the MAC address into the frame
+    Offer = 6,       // Communication::offer(): policy, encoding, slot wait and send
+    Analysis = 7,    // TurbulenceAnalyzer::service()
+    Jitter = 8       // Deviation of the producer period from its nominal length
+};
+
+static const size_t TRACE_STAGE_COUNT = 9;
+
+#if TRACE_ENABLED
+
+#include <atomic>
+#ifdef ARDUINO
+#include <Arduino.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+class Logger;
+
+/**
+ * @brief Cycle-counter timing of the hot paths, in fixed log2 histograms.
+ *
+ * TRACE_SCOPE(stage) reads the CPU cycle counter (CCOUNT on the ESP32-S3, the TSC
+ * on an x86 host) on entry and exit and files the difference in the stage's
+ * histogram: bucket 0 counts durations below 2^MIN_BUCKET_BITS cycles, each next
+ * bucket doubles the bound, the last one is open-ended. TRACE_TICK(periodUs) marks
+ * one iteration of a periodic loop and files how far the interval strayed from the
+ * period under TraceStage::Jitter.
+ *
+ * Recording is a handful of relaxed atomic updates, safe from any task. The
+ * counter is 32 bits: durations must stay below about 17 s at 240 MHz. The cost of
+ * one scope is measured at begin() and reported with the dump.
+ */
+class Trace {
+public:
+    static const size_t BUCKETS = 20;              // < 128 cycles, < 256, ... < 2^25, more
+    static const uint8_t MIN_BUCKET_BITS = 7;      // Bound of the first bucket is 2^7 cycles
+
+    /**
+     * @brief Read the cycle counter
+     */
+    static inline uint32_t cycles() {
+#ifdef ARDUINO
+        return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+        return static_cast<uint32_t>(__rdtsc());
+#else
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#endif
+    }
+
+    /**
+     * @brief Measure the cycle rate and the cost of one scope, clear the histograms
+     */
+    static void begin();
+
+    /**
+     * @brief File one duration
+     */
+    static void record(TraceStage stage, uint32_t cycles);
+
+    /**
+     * @brief Mark one iteration of a periodic loop (single caller)
+     * @param periodUs Nominal period
+     */
+    static void tick(uint32_t periodUs);
+
+    /**
+     * @brief Clear the histograms (the jitter reference restarts at the next tick)
+     */
+    static void reset();
+
+    /**
+     * @brief Durations filed for a stage
+     */
+    static uint32_t count(TraceStage stage);
+
+    /**
+     * @brief Longest duration of a stage (cycles)
+     */
+    static uint32_t maxCycles(TraceStage stage);
+
+    /**
+     * @brief Running average duration of a stage (cycles, 1/16 weight)
+     */
+    static uint32_t averageCycles(TraceStage stage);
+
+    /**
+     * @brief Durations of a stage in one bucket
+     */
+    static uint32_t bucketCount(TraceStage stage, size_t bucket);
+
+    /**
+     * @brief Bucket holding a given fraction of the durations of a stage
+     * @param fraction 0.5 for the median, 0.99 for the 99th percentile
+     */
+    static size_t percentileBucket(TraceStage stage, float fraction);
+
+    /**
+     * @brief Upper bound of a bucket (cycles), 0 for the last, open-ended one
+     */
+    static uint32_t bucketLimit(size_t bucket);
+
+    /**
+     * @brief Cycle counter rate
+     */
+    static uint32_t cyclesPerMicrosecond();
+
+    /**
+     * @brief Cost of one TRACE_SCOPE, counter reads and recording included (cycles)
+     */
+    static uint32_t overheadCycles();
+
+    /**
+     * @brief Short stage name
+     */
+    static const char* name(TraceStage stage);
+
+    /**
+     * @brief Log one line per stage seen (histograms at debug level)
+     */
+    static void dump(Logger& logger);
+};
+
+/**
+ * @brief Times the enclosing scope
+ */
+class TraceScope {
+private:
+    TraceStage stage_;
+    uint32_t start_;
+
+public:
+    explicit TraceScope(TraceStage stage) : stage_(stage), start_(Trace::cycles()) {}
+
+    ~TraceScope() {
+        Trace::record(stage_, Trace::cycles() - start_);
+    }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(stage) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(stage)
+#define TRACE_TICK(periodUs) Trace::tick(periodUs)
+
+#else
+
+#define TRACE_SCOPE(stage) \
+    do {                   \
+    } while (0)
+#define TRACE_TICK(periodUs) \
+    do {                     \
+    } while (0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
@@ -0,0 +1,83 @@
+#ifndef TRACE_ADC_SOURCE_H
+#define TRACE_ADC_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "AdcSource.h"
+
+/**
+ * @brief AdcSource replaying a recorded trace of raw codes (host builds).
+ *
+ * load() reads, by content:
+ * - a binary recording (RECnnnnn.BIN, see RecordingFormat.h),
+ * - a binary serial capture (capture_stream.py --raw, see StreamFormat.h),
+ * - a CSV with a code column (decode_recording.py or capture_stream.py output),
+ *   or millivolts / voltage columns converted back to codes.
+ * The data rate and the scale come from the file when it has them (header, info
+ * packet, timestamps and millivolts columns), the VMeter defaults otherwise. Files
+ * store the anemometer scale, which includes Anemometer::COEF_CORRECTION: it is
+ * taken out so the replayed conversion matches the recorded one. Several
+ * files are played one after the other. Gaps in a trace (dropped samples) are not
+ * filled: the codes are played evenly spaced at the data rate.
+ *
+ * Each read returns the next code; at the end of the trace readConversion() fails
+ * and readSingle() repeats the last code.
+ */
+class TraceAdcSource : public AdcSource {
+private:
+    std::vector<int16_t> codes_;  // Whole trace
+    size_t position_;             // Next code to play
+    uint16_t sampleRate_;         // Data rate of the trace (SPS)
+    float millivoltsPerCode_;     // Scale of the trace
+
+    bool loadRecording(FILE* file);
+    bool loadStream(FILE* file);
+    bool loadCsv(FILE* file);
+    int16_t next();
+
+public:
+    TraceAdcSource();
+
+    /**
+     * @brief Append the codes of a trace file
+     * @return false if the file cannot be read or holds no code
+     */
+    bool load(const char* path);
+
+    /**
+     * @brief Force the data rate (traces without timestamps)
+     */
+    void setSampleRate(uint16_t samplesPerSecond);
+
+    /**
+     * @brief Play the trace again from its first code
+     */
+    void rewind();
+
+    /**
+     * @brief Codes in the trace
+     */
+    size_t size() const;
+
+    /**
+     * @brief Codes played so far
+     */
+    size_t position() const;
+
+    /**
+     * @brief true once every code was played
+     */
+    bool finished() const;
+
+    bool begin() override;
+    bool startSingleShot(uint16_t samplesPerSecond) override;
+    bool startContinuous(uint16_t samplesPerSecond) override;
+    int16_t readSingle() override;
+    bool readConversion(int16_t& code) override;
+    uint16_t sampleRate() const override;
+    float millivoltsPerCode() const override;
+};
+
+#endif // TRACE_ADC_SOURCE_H
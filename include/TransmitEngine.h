@@ -0,0 +1,176 @@
+#ifndef TRANSMIT_ENGINE_H
+#define TRANSMIT_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "Clock.h"
+#include "RadioTransport.h"
+
+/**
+ * @brief Tracks the frames queued to the radio until the driver reports them sent.
+ *
+ * send() stamps each frame into a small in-flight FIFO before handing it to the
+ * radio; the send-completion handler (radio driver context) pops the oldest stamp,
+ * since completions come back in order, and files the enqueue-to-completion latency
+ * in a histogram. Back-pressure: with MAX_IN_FLIGHT frames outstanding, or when the
+ * driver reports its queue full, nothing is sent and the caller is told to retry.
+ *
+ * One sending task and the completion handler may run concurrently; the counters
+ * can be read from any task. With a radio that does not report completions, frames
+ * count as completed as soon as they are queued.
+ *
+ * sendTimed() marks one frame whose completion time is kept, for the two-step time
+ * beacons: the reference learns when its beacon left the air. The completion time
+ * of the first frame sent is kept as well: the boot-to-first-packet metric.
+ */
+class TransmitEngine {
+public:
+    static const size_t MAX_IN_FLIGHT = 8;        // Frames outstanding (power of two)
+    static const size_t LATENCY_BUCKETS = 12;     // < 256 us, < 512 us, ... < 262 ms, more
+    static const uint32_t FIRST_BUCKET_US = 256;  // Upper bound of the first bucket
+
+private:
+    RadioTransport& radio_;                    // Radio frames are queued to
+    Clock& clock_;                             // Enqueue time stamps
+    bool tracking_;                            // Radio reports completions
+    uint32_t enqueueUs_[MAX_IN_FLIGHT];        // Enqueue time of the frames in flight
+    std::atomic<uint32_t> head_;               // Frames stamped (sender)
+    std::atomic<uint32_t> tail_;               // Frames completed (completion handler)
+
+    std::atomic<uint32_t> queued_;             // Frames accepted by the radio
+    std::atomic<uint32_t> completed_;          // Completions reported as sent
+    std::atomic<uint32_t> failed_;             // Completions reported as failed
+    std::atomic<uint32_t> busy_;               // Sends refused by back-pressure
+    std::atomic<uint32_t> errors_;             // Sends rejected by the radio
+    std::atomic<uint32_t> unexpected_;         // Completions with no frame in flight
+    std::atomic<uint32_t> maxInFlight_;        // Highest number of frames outstanding
+    std::atomic<uint32_t> maxLatencyUs_;       // Worst enqueue-to-completion latency
+    std::atomic<uint32_t> averageLatencyUs_;   // Running average latency (1/16 weight)
+    std::atomic<uint32_t> histogram_[2][LATENCY_BUCKETS]; // [failed, delivered][bucket]
+    std::atomic<uint32_t> timedFrame_;         // Index of the frame sent by sendTimed()
+    std::atomic<bool> timedPending_;           // That frame is in flight
+    std::atomic<bool> timedSent_;              // That frame was reported sent, at timedDoneUs_
+    uint32_t timedDoneUs_;                     // Completion time of the timed frame
+    std::atomic<bool> firstSent_;              // A frame was reported sent, at firstSentUs_
+    uint32_t firstSentUs_;                     // Completion time of the first frame sent
+
+    static void onSent(void* context, bool delivered, uint32_t doneUs);
+    void complete(bool delivered, uint32_t doneUs);
+
+public:
+    /**
+     * @brief Construct a new TransmitEngine object
+     * @param radio Radio frames are queued to
+     * @param clock Clock for the enqueue time (same time base as the radio completions)
+     */
+    TransmitEngine(RadioTransport& radio, Clock& clock);
+
+    /**
+     * @brief Register the completion handler (call after the radio begin())
+     * @return true if the radio reports completions
+     */
+    bool begin();
+
+    /**
+     * @brief Queue one frame, unless too many are already in flight
+     * @return Queued, Busy (retry later) or Failed
+     */
+    RadioTransport::SendStatus send(const uint8_t destination[RadioTransport::MAC_SIZE], const uint8_t* data,
+                                    size_t length);
+
+    /**
+     * @brief Queue one frame like send() and keep its completion time
+     * @return Queued, Busy (retry later) or Failed
+     */
+    RadioTransport::SendStatus sendTimed(const uint8_t destination[RadioTransport::MAC_SIZE], const uint8_t* data,
+                                         size_t length);
+
+    /**
+     * @brief Completion time of the last frame given to sendTimed()
+     * @param doneUs Receives the time the radio reported it sent
+     * @return false if it failed, was not queued or is still in flight
+     */
+    bool timedDoneUs(uint32_t& doneUs) const;
+
+    /**
+     * @brief Completion time of the first frame the radio reported sent
+     * @param doneUs Receives the time, on the clock given to the constructor
+     * @return false until a frame was sent
+     */
+    bool firstSentUs(uint32_t& doneUs) const;
+
+    /**
+     * @brief Check for room in flight; a refusal counts as busy
+     */
+    bool ready();
+
+    /**
+     * @brief Clear the delivery counters, latencies and histogram (frames in flight stay tracked)
+     */
+    void resetStatistics();
+
+    /**
+     * @brief Frames queued and not completed yet
+     */
+    uint32_t inFlight() const;
+
+    /**
+     * @brief Frames accepted by the radio
+     */
+    uint32_t queued() const;
+
+    /**
+     * @brief Frames the radio reported sent
+     */
+    uint32_t completed() const;
+
+    /**
+     * @brief Frames the radio reported failed
+     */
+    uint32_t failed() const;
+
+    /**
+     * @brief Sends refused because the radio was busy (back-pressure)
+     */
+    uint32_t busy() const;
+
+    /**
+     * @brief Sends rejected by the radio
+     */
+    uint32_t errors() const;
+
+    /**
+     * @brief Completions received with no frame in flight
+     */
+    uint32_t unexpected() const;
+
+    /**
+     * @brief Highest number of frames outstanding
+     */
+    uint32_t maxInFlight() const;
+
+    /**
+     * @brief Worst enqueue-to-completion latency (us)
+     */
+    uint32_t maxLatencyUs() const;
+
+    /**
+     * @brief Running average enqueue-to-completion latency (us)
+     */
+    uint32_t averageLatencyUs() const;
+
+    /**
+     * @brief Completions in one latency bucket
+     * @param delivered true for the frames sent, false for the failures
+     * @param bucket Bucket index, below LATENCY_BUCKETS
+     */
+    uint32_t latencyCount(bool delivered, size_t bucket) const;
+
+    /**
+     * @brief Upper bound of a latency bucket (us), 0 for the last, open-ended one
+     */
+    static uint32_t bucketLimitUs(size_t bucket);
+};
+
+#endif // TRANSMIT_ENGINE_H
@@ -0,0 +1,163 @@
+#ifndef TURBULENCE_ANALYZER_H
+#define TURBULENCE_ANALYZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "Clock.h"
+#include "SpscRing.h"
+
+/**
+ * @brief Turbulence figures of one analysis window
+ */
+struct TurbulenceResult {
+    uint32_t timestampMs;   // Time of the analysis
+    float mean;             // Mean speed over the window (m/s)
+    float stddev;           // Standard deviation of the speed (m/s)
+    float intensity;        // stddev / mean, 0 when the mean is below MIN_MEAN
+    float gustFrequency;    // Dominant frequency in the gust band (Hz), 0 if none or calm
+    float gustPeriod;       // 1 / gustFrequency (s), 0 if none
+};
+
+/**
+ * @brief Spectrum of the recent wind speed: turbulence intensity and dominant gust period.
+ *
+ * The producer feeds every filtered sample; they are averaged down to
+ * ANALYSIS_RATE_HZ and handed over through a wait-free ring. The analysis side
+ * (a low-priority stage) keeps the last FFT_SIZE samples (64 s) and, every HOP new
+ * samples, removes the linear trend, applies a Hann window and runs a real FFT
+ * (FFT_SIZE/2-point complex radix-2 FFT and a split step). The strongest bin
+ * between MIN_FREQUENCY_HZ and MAX_FREQUENCY_HZ, refined by parabolic
+ * interpolation, is the gust frequency. Intensity uses the raw (not detrended)
+ * standard deviation, as usual. Below MIN_MEAN both figures are reported as 0.
+ * The spectrum is a one-sided power spectral density ((m/s)^2/Hz).
+ *
+ * All buffers, the window and the twiddle factors are members computed once:
+ * nothing is allocated. Results go to one consumer through takeResult().
+ */
+class TurbulenceAnalyzer {
+public:
+    static const size_t FFT_SIZE = 512;                 // Samples per analysis (power of two)
+    static const size_t HOP = 128;                      // New samples between analyses (16 s)
+    static const size_t BINS = FFT_SIZE / 2 + 1;        // Power spectrum bins, DC to Nyquist
+    static constexpr float ANALYSIS_RATE_HZ = 8.0f;     // Rate the samples are averaged down to
+    static constexpr float MIN_FREQUENCY_HZ = 0.02f;    // Gust band: 50 s...
+    static constexpr float MAX_FREQUENCY_HZ = 1.0f;     // ...to 1 s periods
+    static constexpr float MIN_MEAN = 1.0f;             // No intensity below this mean speed (m/s)
+
+private:
+    static const size_t HALF = FFT_SIZE / 2;
+
+    Clock& clock_;                          // Analysis timing
+    float sampleRate_;                      // Rate of the analysed samples (Hz)
+    uint32_t averaging_;                    // Input samples per analysed sample
+    float accumulator_;                     // Producer: sum of the current average
+    uint32_t accumulated_;                  // Producer: samples in accumulator_
+    std::atomic<float> pendingRate_;        // Producer -> analysis: new analysed rate, 0 if none
+    SpscRing<float, 64> samples_;           // Producer -> analysis hand-off
+    SpscRing<TurbulenceResult, 4> results_; // Analysis -> consumer hand-off
+
+    float history_[FFT_SIZE];               // Last samples, circular
+    uint32_t historyCount_;                 // Samples received since reset
+    uint32_t sinceAnalysis_;                // Samples received since the last analysis
+    float window_[FFT_SIZE];                // Hann window
+    float windowEnergy_;                    // Sum of the squared window
+    float cos_[HALF];                       // cos(2 pi k / FFT_SIZE)
+    float sin_[HALF];                       // sin(2 pi k / FFT_SIZE)
+    uint16_t bitReverse_[HALF];             // Permutation of the half-size FFT
+    float re_[HALF];                        // Half-size FFT work buffers
+    float im_[HALF];
+    float power_[BINS];                     // Power spectrum of the last analysis
+
+    std::atomic<uint32_t> analyses_;        // Analyses run
+    std::atomic<uint32_t> lastAnalysisUs_;  // Duration of the last analysis
+    std::atomic<uint32_t> maxAnalysisUs_;   // Longest analysis
+
+    void fft();
+    void analyze(const float* samples, size_t start, TurbulenceResult& result);
+
+public:
+    /**
+     * @brief Construct a new TurbulenceAnalyzer object
+     * @param clock Time source for the analysis timing
+     * @param inputRate Rate of the samples given to addSample() (Hz)
+     */
+    TurbulenceAnalyzer(Clock& clock, float inputRate = ANALYSIS_RATE_HZ);
+
+    /**
+     * @brief Set the rate of the samples given to addSample() and restart (no task running)
+     * @param inputRate Samples per second, averaged down to about ANALYSIS_RATE_HZ
+     */
+    void setInputRate(float inputRate);
+
+    /**
+     * @brief Change the input rate while the analysis stage runs (producer context)
+     *
+     * The averaging changes at once; the analysis side restarts its history at its
+     * next service(), so no window mixes two rates (the few samples in transit aside).
+     * @param inputRate Samples per second, averaged down to about ANALYSIS_RATE_HZ
+     */
+    void changeInputRate(float inputRate);
+
+    /**
+     * @brief Add one wind speed sample (producer context, never blocks)
+     */
+    void addSample(float windSpeed);
+
+    /**
+     * @brief Take the handed-over samples and analyse when HOP new ones arrived (analysis context)
+     * @param nowMs Current time, stored in the result
+     * @return true if an analysis ran
+     */
+    bool service(uint32_t nowMs);
+
+    /**
+     * @brief Compute the power spectrum of a full window directly (tests and benchmarks)
+     * @param samples FFT_SIZE samples at sampleRate(), oldest first
+     * @param result Receives the figures
+     */
+    void analyzeBlock(const float* samples, TurbulenceResult& result);
+
+    /**
+     * @brief Oldest result not taken yet (single consumer)
+     * @return false if none
+     */
+    bool takeResult(TurbulenceResult& result);
+
+    /**
+     * @brief Power spectrum of the last analysis, BINS values, bin k at k * binWidth() Hz
+     */
+    const float* spectrum() const;
+
+    /**
+     * @brief Rate of the analysed samples (Hz)
+     */
+    float sampleRate() const;
+
+    /**
+     * @brief Frequency step between two bins (Hz)
+     */
+    float binWidth() const;
+
+    /**
+     * @brief Analyses run
+     */
+    uint32_t analyses() const;
+
+    /**
+     * @brief Samples lost because the analysis stage fell behind
+     */
+    uint32_t overruns() const;
+
+    /**
+     * @brief Duration of the last analysis (us)
+     */
+    uint32_t lastAnalysisUs() const;
+
+    /**
+     * @brief Longest analysis so far (us)
+     */
+    uint32_t maxAnalysisUs() const;
+};
+
+#endif // TURBULENCE_ANALYZER_H
@@ -0,0 +1,60 @@
+#ifndef UDP_RADIO_H
+#define UDP_RADIO_H
+
+#include <atomic>
+#include "Clock.h"
+#include "RadioTransport.h"
+#include "RtosTask.h"
+
+/**
+ * @brief Radio over UDP on the loopback interface, for host builds.
+ *
+ * Stands in for ESP-NOW between two host processes (a node and the operator tool):
+ * every frame sent goes to the peer port as one datagram, the sender MAC address
+ * followed by the frame bytes. A receive thread hands the datagrams of the local
+ * port to the receive handler, as the ESP-NOW driver task does. There is no send
+ * completion (setSendHandler() returns false), so TransmitEngine counts frames as
+ * soon as they are queued.
+ */
+class UdpRadio : public RadioTransport {
+public:
+    static const size_t MAX_FRAME = 250;   // ESP-NOW payload limit
+
+private:
+    Clock& clock_;                 // Reception time stamps
+    uint16_t localPort_;           // Port the frames are received on
+    uint16_t peerPort_;            // Port the frames are sent to
+    uint8_t mac_[MAC_SIZE];        // Simulated station address
+    int socket_;                   // UDP socket, -1 before begin()
+    std::atomic<ReceiveHandler> handler_; // Handler of the received frames, read by the receive thread
+    std::atomic<void*> context_;   // Handler context
+    RtosTask receiver_;            // Receive thread
+    std::atomic<bool> running_;    // Cleared to stop the receive thread
+
+    static void receiveTask(void* arg);
+
+public:
+    /**
+     * @brief Construct a new UdpRadio object
+     * @param clock Clock of the reception times
+     * @param localPort UDP port on 127.0.0.1 this station listens on
+     * @param peerPort UDP port on 127.0.0.1 the frames are sent to
+     * @param mac Simulated MAC address
+     */
+    UdpRadio(Clock& clock, uint16_t localPort, uint16_t peerPort, const uint8_t mac[MAC_SIZE]);
+
+    ~UdpRadio();
+
+    bool begin() override;
+    SendStatus send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) override;
+    void macAddress(uint8_t mac[MAC_SIZE]) override;
+    bool setReceiveHandler(ReceiveHandler handler, void* context) override;
+    bool setSendHandler(SendHandler handler, void* context) override;
+
+    /**
+     * @brief Stop the receive thread and close the socket
+     */
+    void stop();
+};
+
+#endif // UDP_RADIO_H
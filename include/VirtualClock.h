@@ -0,0 +1,40 @@
+#ifndef VIRTUAL_CLOCK_H
+#define VIRTUAL_CLOCK_H
+
+#include "Clock.h"
+
+/**
+ * @brief Clock that only moves when told to.
+ *
+ * delayMs() and delayUs() advance the time instead of blocking, so simulations and benchmarks
+ * run as fast as the host allows while the code under test sees a consistent time.
+ */
+class VirtualClock : public Clock {
+private:
+    uint64_t nowUs_;    // Current virtual time in microseconds
+
+public:
+    /**
+     * @brief Construct a new VirtualClock object
+     * @param startUs Initial time in microseconds
+     */
+    VirtualClock(uint64_t startUs = 0);
+
+    uint32_t millis() override;
+    uint32_t micros() override;
+    void delayMs(uint32_t ms) override;
+    void delayUs(uint32_t us) override;
+
+    /**
+     * @brief Advance the virtual time
+     * @param us Duration in microseconds
+     */
+    void advanceUs(uint64_t us);
+
+    /**
+     * @brief Current virtual time without wrap-around
+     */
+    uint64_t nowUs() const;
+};
+
+#endif // VIRTUAL_CLOCK_H
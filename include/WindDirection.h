@@ -0,0 +1,101 @@
+#ifndef WIND_DIRECTION_H
+#define WIND_DIRECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Snapshot of the vector-averaged wind direction
+ */
+struct DirectionStats {
+    float current;      // 3 s mean direction (degrees from north, clockwise, 0..360)
+    float mean;         // 2 min mean direction (degrees)
+    float steadiness;   // Length of the 2 min mean unit vector: 1 steady, 0 no prevailing direction
+    uint32_t ticks;     // Ticks currently covered by the 2 min window
+};
+
+/**
+ * @brief Incremental unit-vector mean of the wind vane direction (WMO 2 min mean).
+ *
+ * Directions cannot be averaged as numbers (350 and 10 degrees average to 0, not
+ * 180): each sample is turned into a unit vector, and the vectors are averaged.
+ * Like WindStatistics, samples are folded into 250 ms ticks and running sums over
+ * the last 3 s and the last 2 min give both means at the cost of a few additions
+ * per sample; the mean direction is the angle of the summed vector, its length the
+ * steadiness. Ticks with no sample repeat the previous tick.
+ *
+ * A potentiometer vane is read through the converter: setCalibration() maps its
+ * codes to degrees.
+ */
+class WindDirection {
+public:
+    static const uint32_t TICK_MS = 250;         // Aggregation tick, as WindStatistics
+    static const uint32_t CURRENT_MS = 3000;     // Current direction averaging time
+    static const uint32_t WINDOW_MS = 120000;    // Mean direction averaging time (WMO 2 min)
+    static const size_t CURRENT_TICKS = CURRENT_MS / TICK_MS;
+    static const size_t WINDOW_TICKS = WINDOW_MS / TICK_MS;
+
+private:
+    int16_t northCode_;         // Vane code pointing north
+    int32_t codesPerTurn_;      // Codes for one turn, negative if the vane turns the other way
+
+    bool started_;              // First sample received
+    uint32_t tickStartMs_;      // Start time of the current tick
+    float tickEast_;            // Sum of the east components of the current tick
+    float tickNorth_;           // Sum of the north components of the current tick
+    uint32_t tickCount_;        // Number of samples in the current tick
+    float lastEast_;            // Mean east component of the previous tick, repeated on empty ticks
+    float lastNorth_;           // Mean north component of the previous tick
+
+    uint32_t tickIndex_;                 // Number of ticks closed
+    float currentEast_[CURRENT_TICKS];   // Last 3 s of tick means
+    float currentNorth_[CURRENT_TICKS];
+    double currentEastSum_;              // Running sums over the 3 s rings
+    double currentNorthSum_;
+    float windowEast_[WINDOW_TICKS];     // Last 2 min of tick means
+    float windowNorth_[WINDOW_TICKS];
+    double windowEastSum_;               // Running sums over the 2 min rings
+    double windowNorthSum_;
+
+    void closeTick();
+
+public:
+    WindDirection();
+
+    /**
+     * @brief Map vane codes to degrees
+     * @param northCode Code read with the vane pointing north
+     * @param codesPerTurn Code change over one clockwise turn (negative if the code decreases)
+     */
+    void setCalibration(int16_t northCode, int32_t codesPerTurn);
+
+    /**
+     * @brief Direction of a vane code with the current calibration
+     * @return Degrees from north, clockwise, 0..360
+     */
+    float codeToDegrees(int16_t code) const;
+
+    /**
+     * @brief Forget all history (the calibration is kept)
+     */
+    void reset();
+
+    /**
+     * @brief Add one direction sample
+     * @param degrees Direction the wind comes from (degrees from north, clockwise)
+     * @param timestampMs Acquisition time of the sample (ms, monotonic)
+     */
+    void addSample(float degrees, uint32_t timestampMs);
+
+    /**
+     * @brief Add one vane code (converted with the calibration)
+     */
+    void addCode(int16_t code, uint32_t timestampMs);
+
+    /**
+     * @brief Current statistics (all zero until the first tick is closed)
+     */
+    DirectionStats get() const;
+};
+
+#endif // WIND_DIRECTION_H
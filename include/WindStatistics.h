@@ -0,0 +1,86 @@
+#ifndef WIND_STATISTICS_H
+#define WIND_STATISTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MonotonicWindow.h"
+
+/**
+ * @brief Snapshot of the rolling wind statistics
+ */
+struct WindStats {
+    float current;   // Latest 3 s running mean (m/s)
+    float gust;      // Highest 3 s running mean over the reporting window (m/s)
+    float lull;      // Lowest 3 s running mean over the reporting window (m/s)
+    float mean;      // Mean over the reporting window (m/s)
+    float min;       // Lowest single sample over the reporting window (m/s)
+    float max;       // Highest single sample over the reporting window (m/s)
+    uint32_t ticks;  // Ticks currently covered by the reporting window
+};
+
+/**
+ * @brief Incremental WMO-style wind statistics (3 s gust/lull, 10 min mean, min/max).
+ *
+ * Samples are folded into 250 ms ticks (sum, min, max). On each tick:
+ * - a running sum over the last 3 s gives the 3 s mean;
+ * - a running sum over the last 10 min gives the mean wind;
+ * - monotonic deques give the max/min 3 s mean (gust/lull) and the sample min/max.
+ *
+ * Per sample the cost is a few additions; per tick it is amortized O(1) whatever
+ * the window length. All storage is fixed-size, nothing is allocated.
+ * Ticks with no sample (slow single-shot acquisition) repeat the last tick value.
+ */
+class WindStatistics {
+public:
+    static const uint32_t TICK_MS = 250;         // Aggregation tick (WMO 0.25 s)
+    static const uint32_t GUST_MS = 3000;        // Gust/lull averaging time
+    static const uint32_t WINDOW_MS = 600000;    // Reporting window (10 min)
+    static const size_t GUST_TICKS = GUST_MS / TICK_MS;
+    static const size_t WINDOW_TICKS = WINDOW_MS / TICK_MS;
+
+private:
+    // Current tick accumulator
+    bool started_;              // First sample received
+    uint32_t tickStartMs_;      // Start time of the current tick
+    float tickSum_;             // Sum of the samples of the current tick
+    uint32_t tickCount_;        // Number of samples in the current tick
+    float tickMin_;             // Lowest sample of the current tick
+    float tickMax_;             // Highest sample of the current tick
+    float lastTickMean_;        // Mean of the previous tick, repeated on empty ticks
+
+    // Closed ticks
+    uint32_t tickIndex_;                // Number of ticks closed
+    float gustRing_[GUST_TICKS];        // Last 3 s of tick means
+    double gustSum_;                    // Running sum over gustRing_
+    float windowRing_[WINDOW_TICKS];    // Last 10 min of tick means
+    double windowSum_;                  // Running sum over windowRing_
+
+    MonotonicWindow<WINDOW_TICKS, true> gustMax_;   // Max of 3 s means
+    MonotonicWindow<WINDOW_TICKS, false> lullMin_;  // Min of 3 s means
+    MonotonicWindow<WINDOW_TICKS, true> sampleMax_; // Max of tick maxima
+    MonotonicWindow<WINDOW_TICKS, false> sampleMin_; // Min of tick minima
+
+    void closeTick();
+
+public:
+    WindStatistics();
+
+    /**
+     * @brief Forget all history
+     */
+    void reset();
+
+    /**
+     * @brief Add one wind speed sample
+     * @param windSpeed Wind speed (m/s)
+     * @param timestampMs Acquisition time of the sample (ms, monotonic)
+     */
+    void addSample(float windSpeed, uint32_t timestampMs);
+
+    /**
+     * @brief Current statistics (all zero until the first tick is closed)
+     */
+    WindStats get() const;
+};
+
+#endif // WIND_STATISTICS_H
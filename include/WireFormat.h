@@ -0,0 +1,417 @@
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SipHash.h"
+
+/**
+ * @brief Anemometer data carried over ESP-NOW (logical view, not the wire layout)
+ *
+ * Frames are built and parsed with WireFormat::encodeAnemometer() and
+ * WireFormat::decodeAnemometer(); the struct itself is never sent raw.
+ */
+typedef struct {
+    uint8_t version;         // Frame version the data was decoded from (1 = legacy struct)
+    uint8_t macAddress[6];   // MAC address of the device
+    uint16_t sequenceNumber; // Sequence number for packet tracking (wraps at 65536)
+    float windSpeed;         // Wind speed value (m/s, 0.01 resolution on the wire)
+    uint8_t fields;          // WireFormat::FIELD_* bits present in this frame
+    float windGust;          // Highest 3 s mean over the last 10 min (m/s)       [FIELD_STATS]
+    float windLull;          // Lowest 3 s mean over the last 10 min (m/s)        [FIELD_STATS]
+    float windMean;          // Mean over the last 10 min (m/s)                   [FIELD_STATS]
+    float turbulenceIntensity; // Speed stddev / mean over the last 64 s          [FIELD_TURBULENCE]
+    float gustFrequency;     // Dominant gust frequency (Hz), 0 if none           [FIELD_TURBULENCE]
+    uint32_t timestampUs;    // Acquisition time (us): local clock when given to   [FIELD_TIME]
+                             // Communication::offer(), reference clock on the wire
+    uint16_t timeErrorUs;    // Estimated sync error of timestampUs (us)           [FIELD_TIME]
+} AnemometerData;
+
+/**
+ * @brief Time beacon of the reference node (MSG_TIME)
+ *
+ * Two-step: the time a beacon left the air is only known once the radio reports
+ * it sent, so each beacon carries the departure time of the previous one.
+ */
+typedef struct {
+    uint8_t macAddress[6];   // MAC address of the reference
+    uint16_t sequence;       // Beacon counter, gaps mean lost beacons
+    bool hasPrevious;        // previousAirUs is valid (the previous beacon was sent)
+    uint32_t previousAirUs;  // Reference clock when beacon sequence - 1 left the air (us)
+} TimeBeacon;
+
+/**
+ * @brief Timing of one traced stage in a diagnostics frame
+ */
+typedef struct {
+    uint8_t stage;           // TraceStage value
+    uint16_t calls;          // Durations filed since the last reset (saturates at 65535)
+    uint8_t p99Bucket;       // Log2 histogram bucket holding the 99th percentile
+    uint32_t averageCycles;  // Running average duration (CPU cycles)
+    uint32_t maxCycles;      // Longest duration (CPU cycles)
+} DiagnosticsEntry;
+
+/**
+ * @brief Hot-path timing summary (MSG_DIAGNOSTICS), sent only by tracing builds
+ */
+typedef struct {
+    uint8_t macAddress[6];   // MAC address of the device
+    uint16_t cyclesPerUs;    // CPU cycle counter rate, to turn cycles into time
+    uint8_t count;           // Entries used
+    DiagnosticsEntry entries[12];
+} DiagnosticsData;
+
+/**
+ * @brief Session statistics of one anemometer (MSG_SUMMARY), sent on request
+ */
+typedef struct {
+    uint8_t macAddress[6];   // MAC address of the device
+    uint32_t samples;        // Measurements in the session
+    uint32_t durationS;      // Time covered by the session (s)
+    float mean;              // Mean wind speed (m/s)
+    float stddev;            // Standard deviation of the wind speed (m/s)
+    float min;               // Lowest wind speed (m/s)
+    float max;               // Highest wind speed (m/s)
+    float p50;               // Median wind speed (m/s)
+    float p90;               // 90th percentile (m/s)
+    float p99;               // 99th percentile (m/s)
+    float weibullK;          // Weibull shape, 0 until fitted
+    float weibullC;          // Weibull scale (m/s), 0 until fitted
+    float binWidth;          // Histogram bin width (m/s), first bin starts at 0
+    uint8_t binCount;        // Histogram bins present (the last bin is open-ended)
+    float histogram[48];     // Fraction of the samples in each bin
+} SessionSummary;
+
+/**
+ * @brief Session summary request (MSG_SUMMARY_REQUEST), sent by a receiver
+ */
+typedef struct {
+    uint8_t target[6];       // Anemometer asked, FF:FF:FF:FF:FF:FF for all
+} SummaryRequest;
+
+/**
+ * @brief Runtime settings of an anemometer, read and changed over the control channel
+ */
+typedef struct {
+    uint16_t sampleRate;     // ADS1115 data rate (SPS): 8, 16, 32, 64, 128, 250, 475 or 860  [SET_SAMPLING]
+    uint8_t medianSize;      // AdcFilter::Config: 1, 3 or 5                                  [SET_FILTER]
+    uint8_t decimation;      // 1, 2, 4, 8 or 16
+    uint8_t cicOrder;        // 1 to 3
+    uint8_t smoothingShift;  // 0 to 8
+    float speedDeadband;     // BroadcastPolicy::Config (m/s, 0.01 on the wire)              [SET_POLICY]
+    float gustDeadband;      // (m/s)
+    uint32_t minIntervalMs;  // Shortest gap between frames
+    uint32_t rampStartMs;    // Gap after the first change of a quiet spell
+    uint32_t heartbeatMs;    // Longest gap between frames
+    uint32_t fixedIntervalMs; // Fixed schedule the counters compare with
+    uint8_t logLevel;        // LogLevel of every module, 0 (errors) to 3 (debug)            [SET_LOGGING]
+} DeviceSettings;
+
+/**
+ * @brief Counters of an anemometer, read over the control channel
+ */
+typedef struct {
+    uint32_t uptimeS;        // Time since boot (s)
+    uint32_t samples;        // Conversions processed
+    uint32_t overruns;       // Conversions lost because the ring was full
+    uint32_t spikes;         // Codes corrected by the median filter
+    uint32_t framesSent;     // Frames sent by the broadcast policy
+    uint32_t radioQueued;    // Frames accepted by the radio driver
+    uint32_t radioFailed;    // Frames the driver reported as failed
+    uint32_t commands;       // Control commands accepted
+    uint32_t rejected;       // Control frames refused (bad tag, stale counter)
+} DeviceStats;
+
+/**
+ * @brief Control command (MSG_CONTROL) or its reply (MSG_CONTROL_REPLY)
+ */
+typedef struct {
+    uint8_t macAddress[6];   // Request: anemometer addressed (FF:FF:FF:FF:FF:FF for all);
+                             // reply: anemometer answering
+    uint32_t counter;        // Request: above every counter accepted before; reply: echoed
+    uint8_t command;         // CMD_* value
+    uint8_t status;          // Reply: STATUS_* value; request: 0
+    uint8_t length;          // Payload bytes used
+    uint8_t payload[48];     // Command arguments or reply data
+} ControlMessage;
+
+/**
+ * @brief Compact, versioned, little-endian ESP-NOW frame format.
+ *
+ * Frame v2 (12 bytes + optional fields):
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Header: message type (high nibble), version (low)    |
+ * | 1      | 6    | MAC address                                          |
+ * | 7      | 2    | Sequence number (uint16)                             |
+ * | 9      | 2    | Wind speed, 0.01 m/s (uint16)                        |
+ * | 11     | 1    | Optional field bitmap (FIELD_*)                      |
+ * | 12     | ...  | Optional fields, in bit order                        |
+ *
+ * Optional fields:
+ * - FIELD_STATS: gust, lull, mean, 3 x uint16 in 0.01 m/s
+ * - FIELD_TURBULENCE: turbulence intensity (uint16, 0.1 %), gust frequency (uint16, mHz);
+ *   sent with the frame that follows each spectrum analysis, about every 16 s
+ * - FIELD_TIME: acquisition time of the measurement on the reference clock (uint32, us,
+ *   wraps every 71 min) and the estimated sync error (uint16, us); only sent once the
+ *   node is synchronised to a reference
+ * - FIELD_NO_SENSOR: flag without payload, the converter does not answer (boot or
+ *   connector fault): the wind values are not measurements, only the node is alive.
+ *   Older receivers ignore the bit and show a calm wind
+ *
+ * Time beacon (MSG_TIME, 14 bytes), broadcast every second by the reference node:
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Header: message type (high nibble), version (low)    |
+ * | 1      | 6    | MAC address                                          |
+ * | 7      | 2    | Beacon sequence number (uint16)                      |
+ * | 9      | 1    | Flags: bit 0 set when the next field is valid        |
+ * | 10     | 4    | Reference clock when the previous beacon left the    |
+ * |        |      | air (uint32, us)                                     |
+ *
+ * Diagnostics frame (MSG_DIAGNOSTICS, 10 bytes + 12 per stage):
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Header: message type (high nibble), version (low)    |
+ * | 1      | 6    | MAC address                                          |
+ * | 7      | 2    | Cycle counter rate, cycles per us (uint16)           |
+ * | 9      | 1    | Number of stages                                     |
+ * | 10     | 12 n | Stage, calls (uint16), p99 bucket, average and max   |
+ * |        |      | cycles (2 x uint32)                                  |
+ *
+ * Session summary (MSG_SUMMARY, 35 bytes + 2 per bin), sent when requested:
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Header: message type (high nibble), version (low)    |
+ * | 1      | 6    | MAC address                                          |
+ * | 7      | 4    | Samples (uint32)                                     |
+ * | 11     | 4    | Duration, s (uint32)                                 |
+ * | 15     | 14   | Mean, stddev, min, max, p50, p90, p99: 7 x uint16 in |
+ * |        |      | 0.01 m/s                                             |
+ * | 29     | 2    | Weibull shape k, 0.001 (uint16), 0 if not fitted     |
+ * | 31     | 2    | Weibull scale c, 0.01 m/s (uint16)                   |
+ * | 33     | 1    | Bin width, 0.1 m/s                                   |
+ * | 34     | 1    | Number of bins n (trailing empty bins dropped)       |
+ * | 35     | 2 n  | Fraction of the samples per bin, 1/65535 (uint16)    |
+ *
+ * Summary request (MSG_SUMMARY_REQUEST, 7 bytes): header and the MAC address of
+ * the anemometer asked (broadcast address for all).
+ *
+ * Control command and reply (MSG_CONTROL, MSG_CONTROL_REPLY, 22 bytes + payload):
+ * | Offset | Size | Content                                              |
+ * |--------|------|------------------------------------------------------|
+ * | 0      | 1    | Header: message type (high nibble), version (low)    |
+ * | 1      | 6    | MAC address (addressed, or answering)                |
+ * | 7      | 4    | Counter (uint32)                                     |
+ * | 11     | 1    | Command (CMD_*)                                      |
+ * | 12     | 1    | Status (STATUS_*), 0 in commands                     |
+ * | 13     | 1    | Payload length n                                     |
+ * | 14     | n    | Payload                                              |
+ * | 14 + n | 8    | SipHash-2-4 of the bytes above, with the fleet key   |
+ *
+ * The header is covered by the tag, so a reply cannot be sent back as a command.
+ * Payloads:
+ * - CMD_GET_SETTINGS: no arguments; the reply carries the settings (27 bytes:
+ *   sample rate uint16, median, decimation, CIC order, smoothing shift, speed and
+ *   gust deadbands uint16 in 0.01 m/s, the four policy intervals uint32 in ms, log level)
+ * - CMD_SET_SETTINGS: a SET_* group mask then the settings; only the groups in the
+ *   mask are changed, all or none of them. The reply carries the settings in force
+ * - CMD_GET_STATS: no arguments; the reply carries the DeviceStats fields, 9 x uint32
+ * - CMD_RESET_COUNTERS: no arguments, no reply payload
+ * - STATUS_STALE replies carry the last counter accepted (uint32), to resynchronise
+ *
+ * Legacy v1 frames are the raw, padded AnemometerData struct of firmware 1.0.x
+ * (40 bytes, first byte = message type 2). Their header byte has a zero high
+ * nibble, which never occurs in v2+ frames, so both can be told apart.
+ * This header and WireFormat.cpp have no dependency on Arduino and can be copied
+ * as-is into receiver projects, with SipHash.h and SipHash.cpp.
+ */
+namespace WireFormat {
+
+static const uint8_t VERSION = 2;               // Current frame version
+
+static const uint8_t MSG_BOAT = 1;              // Message types (shared with legacy messageType)
+static const uint8_t MSG_ANEMOMETER = 2;
+static const uint8_t MSG_DIAGNOSTICS = 3;
+static const uint8_t MSG_TIME = 4;
+static const uint8_t MSG_SUMMARY = 5;
+static const uint8_t MSG_SUMMARY_REQUEST = 6;
+static const uint8_t MSG_CONTROL = 7;
+static const uint8_t MSG_CONTROL_REPLY = 8;
+
+static const uint8_t CMD_GET_SETTINGS = 1;      // Control commands
+static const uint8_t CMD_SET_SETTINGS = 2;
+static const uint8_t CMD_GET_STATS = 3;
+static const uint8_t CMD_RESET_COUNTERS = 4;
+
+static const uint8_t STATUS_OK = 0;             // Control reply status
+static const uint8_t STATUS_UNKNOWN_COMMAND = 1;
+static const uint8_t STATUS_INVALID = 2;        // Malformed arguments or value out of range: nothing changed
+static const uint8_t STATUS_STALE = 3;          // Counter not above the last one accepted: not executed
+static const uint8_t STATUS_BUSY = 4;           // Earlier settings not applied yet: nothing changed, try again
+
+static const uint8_t SET_SAMPLING = 0x01;       // CMD_SET_SETTINGS groups
+static const uint8_t SET_FILTER = 0x02;
+static const uint8_t SET_POLICY = 0x04;
+static const uint8_t SET_LOGGING = 0x08;
+static const uint8_t SET_ALL = 0x0F;
+
+static const uint8_t FIELD_STATS = 0x01;        // Gust, lull and mean present
+static const uint8_t FIELD_TURBULENCE = 0x02;   // Turbulence intensity and gust frequency present
+static const uint8_t FIELD_TIME = 0x04;         // Acquisition time on the reference clock present
+static const uint8_t FIELD_NO_SENSOR = 0x80;    // Sensor unavailable, no payload (flags count down from bit 7)
+
+static const size_t HEADER_SIZE = 12;           // Mandatory part of an anemometer frame
+static const size_t MAX_FRAME_SIZE = 160;       // Upper bound for any frame we build
+static const size_t LEGACY_V1_SIZE = 40;        // sizeof(AnemometerData) in firmware 1.0.x
+static const size_t DIAGNOSTICS_HEADER_SIZE = 10; // Diagnostics frame before the entries
+static const size_t DIAGNOSTICS_ENTRY_SIZE = 12;
+static const size_t TIME_BEACON_SIZE = 14;
+static const size_t SUMMARY_HEADER_SIZE = 35;   // Summary frame before the bins
+static const size_t MAX_SUMMARY_BINS = sizeof(SessionSummary::histogram) / sizeof(float);
+static const size_t SUMMARY_REQUEST_SIZE = 7;
+static const size_t CONTROL_HEADER_SIZE = 14;   // Control frame before the payload
+static const size_t CONTROL_TAG_SIZE = SipHash::TAG_SIZE;
+static const size_t MAX_CONTROL_PAYLOAD = sizeof(ControlMessage::payload);
+static const size_t CONTROL_KEY_SIZE = SipHash::KEY_SIZE;
+static const size_t SETTINGS_SIZE = 27;
+static const size_t STATS_SIZE = 36;
+static const size_t MAX_DIAGNOSTICS_ENTRIES = sizeof(DiagnosticsData::entries) / sizeof(DiagnosticsEntry);
+
+/**
+ * @brief Build a header byte
+ */
+inline uint8_t makeHeader(uint8_t type, uint8_t version) {
+    return static_cast<uint8_t>((type << 4) | (version & 0x0F));
+}
+
+/**
+ * @brief Message type of a received frame (legacy frames included)
+ * @return Message type, 0 if the frame is empty
+ */
+uint8_t frameType(const uint8_t* frame, size_t length);
+
+/**
+ * @brief Encode anemometer data
+ * @param data Data to encode; data.fields selects the optional fields
+ * @param out Output buffer
+ * @param capacity Size of the output buffer
+ * @return Frame length, 0 if the buffer is too small
+ */
+size_t encodeAnemometer(const AnemometerData& data, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode an anemometer frame (v2 or legacy v1)
+ * @param frame Received bytes
+ * @param length Number of received bytes
+ * @param data Receives the decoded data
+ * @return true if the frame is a valid anemometer frame
+ */
+bool decodeAnemometer(const uint8_t* frame, size_t length, AnemometerData& data);
+
+/**
+ * @brief Encode a diagnostics summary
+ * @return Frame length, 0 if the buffer is too small or count is out of range
+ */
+size_t encodeDiagnostics(const DiagnosticsData& data, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode a diagnostics frame
+ * @return true if the frame is a valid diagnostics frame
+ */
+bool decodeDiagnostics(const uint8_t* frame, size_t length, DiagnosticsData& data);
+
+/**
+ * @brief Encode a time beacon
+ * @return Frame length, 0 if the buffer is too small
+ */
+size_t encodeTimeBeacon(const TimeBeacon& beacon, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode a time beacon
+ * @return true if the frame is a valid time beacon
+ */
+bool decodeTimeBeacon(const uint8_t* frame, size_t length, TimeBeacon& beacon);
+
+/**
+ * @brief Encode a session summary
+ * @return Frame length, 0 if the buffer is too small or binCount is out of range
+ */
+size_t encodeSummary(const SessionSummary& summary, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode a session summary
+ * @return true if the frame is a valid summary frame
+ */
+bool decodeSummary(const uint8_t* frame, size_t length, SessionSummary& summary);
+
+/**
+ * @brief Encode a session summary request
+ * @return Frame length, 0 if the buffer is too small
+ */
+size_t encodeSummaryRequest(const SummaryRequest& request, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode a session summary request
+ * @return true if the frame is a valid request
+ */
+bool decodeSummaryRequest(const uint8_t* frame, size_t length, SummaryRequest& request);
+
+/**
+ * @brief Encode and sign a control command or reply
+ * @param type MSG_CONTROL or MSG_CONTROL_REPLY
+ * @param message Content
+ * @param key Fleet key
+ * @return Frame length, 0 if the buffer is too small or the payload too long
+ */
+size_t encodeControl(uint8_t type, const ControlMessage& message, const uint8_t key[CONTROL_KEY_SIZE], uint8_t* out,
+                     size_t capacity);
+
+/**
+ * @brief Check the tag of a control command or reply and decode it
+ * @return true if the frame is a well-formed control frame signed with the key
+ */
+bool decodeControl(const uint8_t* frame, size_t length, const uint8_t key[CONTROL_KEY_SIZE], ControlMessage& message);
+
+/**
+ * @brief Encode settings into a control payload
+ * @return SETTINGS_SIZE, 0 if the buffer is too small
+ */
+size_t encodeSettings(const DeviceSettings& settings, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode settings from a control payload
+ * @return true if there are enough bytes
+ */
+bool decodeSettings(const uint8_t* data, size_t length, DeviceSettings& settings);
+
+/**
+ * @brief Encode counters into a control payload
+ * @return STATS_SIZE, 0 if the buffer is too small
+ */
+size_t encodeStats(const DeviceStats& stats, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode counters from a control payload
+ * @return true if there are enough bytes
+ */
+bool decodeStats(const uint8_t* data, size_t length, DeviceStats& stats);
+
+/**
+ * @brief Format a MAC address as "AA:BB:CC:DD:EE:FF"
+ * @param mac 6-byte MAC address
+ * @param out Output buffer of at least 18 characters
+ */
+void formatMacAddress(const uint8_t mac[6], char out[18]);
+
+/**
+ * @brief Wrap-aware difference between two 16-bit sequence numbers
+ * @return Signed distance from previous to current
+ */
+inline int16_t sequenceDelta(uint16_t current, uint16_t previous) {
+    return static_cast<int16_t>(static_cast<uint16_t>(current - previous));
+}
+
+} // namespace WireFormat
+
+#endif // WIRE_FORMAT_H
@@ -0,0 +1,211 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file AdcFilter.cpp
+ * @brief Median, CIC decimator and IIR smoother on raw ADC codes (fixed point)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "AdcFilter.h"
+#include <string.h>
+
+const AdcFilter::Config AdcFilter::DEFAULT_CONFIG = {3, 4, 2, 2};
+const AdcFilter::Config AdcFilter::SINGLE_SHOT_CONFIG = {3, 1, 1, 0};
+const AdcFilter::Config AdcFilter::PASS_THROUGH = {1, 1, 1, 0};
+
+/**
+ * @brief Compare-exchange: a receives the smaller value, b the larger (no branch)
+ */
+static inline void sort2(int16_t& a, int16_t& b) {
+    int16_t low = a < b ? a : b;
+    int16_t high = a < b ? b : a;
+    a = low;
+    b = high;
+}
+
+static inline int16_t median3(int16_t a, int16_t b, int16_t c) {
+    sort2(a, b);
+    b = b < c ? b : c;
+    return a > b ? a : b;
+}
+
+/**
+ * @brief Median of 5 with 7 compare-exchanges (Devillard's network)
+ */
+static inline int16_t median5(int16_t a, int16_t b, int16_t c, int16_t d, int16_t e) {
+    sort2(a, b);
+    sort2(d, e);
+    sort2(a, d);
+    sort2(b, e);
+    sort2(b, c);
+    sort2(c, d);
+    sort2(b, c);
+    return c;
+}
+
+AdcFilter::AdcFilter(const Config& config) : config_(PASS_THROUGH), decimationShift_(0) {
+    if (!setConfig(config)) {
+        setConfig(PASS_THROUGH);
+    }
+}
+
+bool AdcFilter::valid(const Config& config) {
+    bool powerOfTwo = config.decimation != 0 && (config.decimation & (config.decimation - 1)) == 0;
+    return (config.medianSize == 1 || config.medianSize == 3 || config.medianSize == 5) && powerOfTwo &&
+           config.decimation <= MAX_DECIMATION && config.cicOrder >= 1 && config.cicOrder <= MAX_CIC_ORDER &&
+           config.smoothingShift <= MAX_SMOOTHING_SHIFT;
+}
+
+bool AdcFilter::setConfig(const Config& config) {
+    if (!valid(config)) {
+        return false;
+    }
+    config_ = config;
+    decimationShift_ = 0;
+    while ((1 << decimationShift_) < config.decimation) {
+        decimationShift_++;
+    }
+    reset();
+    return true;
+}
+
+const AdcFilter::Config& AdcFilter::config() const {
+    return config_;
+}
+
+void AdcFilter::reset() {
+    memset(history_, 0, sizeof(history_));
+    historyValid_ = false;
+    memset(integrators_, 0, sizeof(integrators_));
+    memset(combs_, 0, sizeof(combs_));
+    phase_ = 0;
+    // Zero state means "zero input so far": skip the outputs until the CIC window is full
+    warmup_ = config_.decimation > 1 ? config_.cicOrder : 0;
+    smoothed_ = 0;
+    primed_ = false;
+    spikes_ = 0;
+}
+
+/**
+ * @brief Median stage over one block: medians_[i] is the median of the window ending at in[i]
+ * @return count
+ */
+size_t AdcFilter::medianBlock(const int16_t* in, size_t count) {
+    size_t keep = config_.medianSize - 1;
+    if (keep == 0) {
+        memcpy(medians_, in, count * sizeof(int16_t));
+        return count;
+    }
+    // Before the first block, the missing history repeats the first code
+    if (!historyValid_) {
+        for (size_t k = 0; k < keep; k++) {
+            history_[k] = in[0];
+        }
+        historyValid_ = true;
+    }
+    memcpy(window_, history_, keep * sizeof(int16_t));
+    memcpy(window_ + keep, in, count * sizeof(int16_t));
+
+    // Straight loops of min/max over shifted windows: no branch, no dependency between i
+    const int16_t* w = window_;
+    if (config_.medianSize == 3) {
+        for (size_t i = 0; i < count; i++) {
+            medians_[i] = median3(w[i], w[i + 1], w[i + 2]);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            medians_[i] = median5(w[i], w[i + 1], w[i + 2], w[i + 3], w[i + 4]);
+        }
+    }
+    size_t centre = keep / 2;
+    for (size_t i = 0; i < count; i++) {
+        int32_t change = w[i + centre] - medians_[i];
+        spikes_ += change > SPIKE_CODES || change < -SPIKE_CODES;
+    }
+    memcpy(history_, window_ + count, keep * sizeof(int16_t));
+    return count;
+}
+
+/**
+ * @brief CIC stage: integrate one code, emit one output every decimation codes
+ */
+bool AdcFilter::decimate(int16_t code, int32_t& out) {
+    // Unsigned arithmetic: the integrators may wrap, the combs undo it
+    uint32_t value = static_cast<uint32_t>(static_cast<int32_t>(code));
+    for (uint8_t k = 0; k < config_.cicOrder; k++) {
+        integrators_[k] = static_cast<int32_t>(static_cast<uint32_t>(integrators_[k]) + value);
+        value = static_cast<uint32_t>(integrators_[k]);
+    }
+    if (++phase_ < config_.decimation) {
+        return false;
+    }
+    phase_ = 0;
+    for (uint8_t k = 0; k < config_.cicOrder; k++) {
+        uint32_t delayed = static_cast<uint32_t>(combs_[k]);
+        combs_[k] = static_cast<int32_t>(value);
+        value -= delayed;
+    }
+    if (warmup_ > 0) {
+        warmup_--;
+        return false;
+    }
+    // Gain decimation^order removed, FRACTION_BITS kept (rounded)
+    int32_t sum = static_cast<int32_t>(value);
+    int shift = config_.cicOrder * decimationShift_ - FRACTION_BITS;
+    if (shift > 0) {
+        out = (sum + (1 << (shift - 1))) >> shift;
+    } else {
+        out = sum * (1 << -shift);
+    }
+    return true;
+}
+
+size_t AdcFilter::process(const int16_t* in, size_t count, int32_t* out) {
+    size_t written = 0;
+    while (count > 0) {
+        size_t chunk = count < BLOCK ? count : BLOCK;
+        medianBlock(in, chunk);
+        for (size_t i = 0; i < chunk; i++) {
+            int32_t value;
+            if (!decimate(medians_[i], value)) {
+                continue;
+            }
+            if (!primed_) {
+                smoothed_ = value;
+                primed_ = true;
+            } else {
+                smoothed_ += (value - smoothed_) >> config_.smoothingShift;
+            }
+            out[written++] = smoothed_;
+        }
+        in += chunk;
+        count -= chunk;
+    }
+    return written;
+}
+
+bool AdcFilter::push(int16_t code, int32_t& out) {
+    return process(&code, 1, &out) == 1;
+}
+
+uint16_t AdcFilter::outputRate(uint16_t inputRate) const {
+    return inputRate >> decimationShift_;
+}
+
+uint32_t AdcFilter::spikes() const {
+    return spikes_;
+}
@@ -0,0 +1,241 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file AdcSampler.cpp
+ * @brief Continuous ADC acquisition into a lock-free ring buffer
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * I2C transfers cannot run in interrupt context, so the ALERT/RDY interrupt (or the
+ * esp_timer callback) only notifies a reader task, which performs the read. The ring
+ * is single-producer (reader task) / single-consumer (Anemometer::update()).
+ */
+
+#include "AdcSampler.h"
+
+/**
+ * @brief Construct a new AdcSampler object
+ */
+AdcSampler::AdcSampler(AdcSource& source, int core)
+    : source_(source), ring_(), samplesAcquired_(0), readErrors_(0), task_("adc_reader", 3072, READER_PRIORITY, core),
+      running_(false), pendingRate_(0)
+#ifdef ARDUINO
+      , timer_(nullptr), alertPin_(-1)
+#endif
+{
+}
+
+/**
+ * @brief Destroy the AdcSampler object
+ */
+AdcSampler::~AdcSampler() {
+    stop();
+}
+
+/**
+ * @brief Read one conversion and push it into the ring
+ */
+bool AdcSampler::service() {
+    int16_t code;
+    if (!source_.readConversion(code)) {
+        readErrors_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!ring_.push(code)) {
+        return false;
+    }
+    samplesAcquired_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Move accumulated codes out of the ring
+ */
+size_t AdcSampler::drain(int16_t* out, size_t maxCodes) {
+    return ring_.popBulk(out, maxCodes);
+}
+
+void AdcSampler::setRate(uint16_t samplesPerSecond) {
+    pendingRate_.store(samplesPerSecond, std::memory_order_relaxed);
+}
+
+uint32_t AdcSampler::samplesAcquired() const {
+    return samplesAcquired_.load(std::memory_order_relaxed);
+}
+
+uint32_t AdcSampler::overruns() const {
+    return ring_.overruns();
+}
+
+uint32_t AdcSampler::readErrors() const {
+    return readErrors_.load(std::memory_order_relaxed);
+}
+
+void AdcSampler::stop() {
+    running_.store(false);
+#ifdef ARDUINO
+    if (timer_) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+        timer_ = nullptr;
+    }
+    if (alertPin_ >= 0) {
+        // Before the join: an edge after it would notify a deleted task
+        detachInterrupt(alertPin_);
+        alertPin_ = -1;
+    }
+#endif
+    task_.notify();
+    task_.join();
+}
+
+#ifdef ARDUINO
+
+/**
+ * @brief Reader task: one I2C read per notification
+ */
+void AdcSampler::readerTask(void* arg) {
+    AdcSampler* self = static_cast<AdcSampler*>(arg);
+    while (self->running_.load()) {
+        // Several pending notifications mean we are late: catch up with one read each
+        uint32_t pending = self->task_.wait(100);
+        self->applyRate();
+        while (pending--) {
+            self->service();
+        }
+    }
+}
+
+/**
+ * @brief Restart the conversions at the pending rate and re-arm the timer
+ */
+void AdcSampler::applyRate() {
+    uint16_t rate = pendingRate_.exchange(0, std::memory_order_relaxed);
+    if (rate == 0) {
+        return;
+    }
+    source_.startContinuous(rate);
+    if (!timer_) {
+        // ALERT/RDY: keep the comparator in conversion-ready mode
+        source_.enableConversionReadyPin();
+        return;
+    }
+    esp_timer_stop(timer_);
+    rate = source_.sampleRate();
+    esp_timer_start_periodic(timer_, 1000000ULL / (rate ? rate : 8));
+}
+
+/**
+ * @brief Periodic timer callback (esp_timer task context)
+ */
+void AdcSampler::onTimer(void* arg) {
+    static_cast<AdcSampler*>(arg)->task_.notify();
+}
+
+/**
+ * @brief ALERT/RDY falling edge interrupt
+ */
+void IRAM_ATTR AdcSampler::onAlert(void* arg) {
+    static_cast<AdcSampler*>(arg)->task_.notifyFromIsr();
+}
+
+/**
+ * @brief Start the reader task and its wake-up source
+ */
+bool AdcSampler::start(int alertPin) {
+    if (running_.load()) {
+        return true;
+    }
+    running_.store(true);
+    if (!task_.start(readerTask, this)) {
+        running_.store(false);
+        return false;
+    }
+
+    if (alertPin >= 0) {
+        pinMode(alertPin, INPUT_PULLUP);
+        attachInterruptArg(alertPin, onAlert, this, FALLING);
+        alertPin_ = alertPin;
+        return true;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.name = "adc_timer";
+    if (esp_timer_create(&args, &timer_) != ESP_OK) {
+        // No wake-up source: the reader would wait forever, let it exit
+        timer_ = nullptr;
+        stop();
+        return false;
+    }
+    uint16_t rate = source_.sampleRate();
+    if (esp_timer_start_periodic(timer_, 1000000ULL / (rate ? rate : 8)) != ESP_OK) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+#else // Host
+
+/**
+ * @brief Reader thread: services as many conversions as the data rate allows
+ */
+void AdcSampler::readerTask(void* arg) {
+    AdcSampler* self = static_cast<AdcSampler*>(arg);
+    uint32_t startMs = RtosTask::nowMs();
+    uint64_t serviced = 0;
+    while (self->running_.load()) {
+        if (self->pendingRate_.load(std::memory_order_relaxed)) {
+            // The pacing restarts at the new rate
+            self->applyRate();
+            startMs = RtosTask::nowMs();
+            serviced = 0;
+        }
+        uint64_t due = static_cast<uint64_t>(RtosTask::nowMs() - startMs) * self->source_.sampleRate() / 1000;
+        while (serviced < due) {
+            self->service();
+            serviced++;
+        }
+        RtosTask::sleepMs(1);
+    }
+}
+
+/**
+ * @brief Restart the conversions at the pending rate
+ */
+void AdcSampler::applyRate() {
+    uint16_t rate = pendingRate_.exchange(0, std::memory_order_relaxed);
+    if (rate) {
+        source_.startContinuous(rate);
+    }
+}
+
+bool AdcSampler::start(int alertPin) {
+    (void)alertPin;
+    if (running_.load()) {
+        return true;
+    }
+    running_.store(true);
+    if (!task_.start(readerTask, this)) {
+        running_.store(false);
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -26,50 +26,66 @@
  * The system uses:
  * - M5Stack Unit VMeter (I2C address 0x49) for voltage measurement
  * - ADS1115 ADC with configurable gain and sampling rate
- * - Linear interpolation between calibration points for voltage-to-wind-speed conversion
+ * - Linear interpolation between calibration points for voltage-to-wind-speed conversion,
+ *   tabulated per ADC code in fixed point (mm/s) so samples need no float math
  * 
  * Key features:
- * - Automatic initialization and configuration of the VMeter unit
+ * - Automatic initialization and configuration of the VMeter unit, retried with a
+ *   backoff from update() instead of blocking the boot when the unit does not answer
  * - Real-time voltage and wind speed measurement
  * - Calibration correction factor application
+ * - Rolling statistics (3 s gust/lull, 10 min mean, min/max) over every sample
  * - Logging support for debugging and monitoring
- * - Simulation mode for testing (sinusoidal voltage generation)
+ * - Replay mode: codes from any AdcSource (FakeAdcSource, recorded traces) processed
+ *   on the source's clock, for host tests without the sensor
  * 
  * Hardware configuration:
  * - I2C communication on Wire1 (pins 2, 1)
  * - 400kHz I2C frequency
  * - ADS1115 PGA gain set to 2048 (max 32V input)
- * - Single-shot conversion mode at 8 SPS rate
+ * - Continuous conversion mode up to 860 SPS into a ring buffer (default), or
+ *   single-shot conversion mode at 8 SPS rate
  * 
  * Calibration:
  * - Input voltage range: 0-14V
  * - Output wind speed range: 0-28 m/s
  * - Linear interpolation between calibration points
- * - Factory calibration factor from EEPROM
+ * - Factory calibration factor from EEPROM, applied once when the table is built,
+ *   and cached across boots when a CalibrationStore is set
  * - Additional correction coefficient: 1.0051
  */
 
 
 #include "Anemometer.h"
+#include "Trace.h"
 
 // Static member initialization
 Logger* Anemometer::logger_ = nullptr;
 
-// VMeter Management
-#define M5_UNIT_VMETER_I2C_ADDR             0x49
-#define M5_UNIT_VMETER_EEPROM_I2C_ADDR      0x53
-#define M5_UNIT_VMETER_PRESSURE_COEFFICIENT 0.015918958F
-
 // Courbe de calibration anemometre : mV -> km/h (attention !!!!! abscisses identiques interdites)
-static float INPUT_WIND_SPEED_VS_VOLTAGE[]  = {0., 120., 188., 300., 380., 490., 620., 730.};
-static float OUTPUT_WIND_SPEED_VS_VOLTAGE[] = {0.,  10.,  20.,  30.,  40.,  50.,  60.,  70.};
-static const int CALIBRATION_TABLE_SIZE = 8;
+static constexpr CalibrationCurve DEFAULT_CALIBRATION_CURVE = {
+    {0., 120., 188., 300., 380., 490., 620., 730.},
+    {0.,  10.,  20.,  30.,  40.,  50.,  60.,  70.},
+    8};
+
+// Table generee a la compilation pour l'echelle nominale du VMeter (avant lecture de la calibration usine)
+static constexpr CalibrationTable<Anemometer::CALIBRATION_TABLE_ENTRIES> NOMINAL_CALIBRATION_TABLE(
+    DEFAULT_CALIBRATION_CURVE, VMETER_NOMINAL_MILLIVOLTS_PER_CODE * Anemometer::COEF_CORRECTION);
+static_assert(NOMINAL_CALIBRATION_TABLE.valid(), "Default calibration curve does not fit the table");
 
 
 /**
  * @brief Construct a new Anemometer object
  */
-Anemometer::Anemometer() : voltmeter_(), voltage_(0.0f), windSpeed_(0.0f) {}
+Anemometer::Anemometer(AdcSource& voltmeter, Clock& clock, AcquisitionMode mode, uint16_t sampleRate, int alertPin)
+    : voltmeter_(voltmeter), clock_(clock), sampler_(voltmeter_), mode_(mode), sampleRate_(sampleRate), alertPin_(alertPin),
+      replayUs_(0), replayDue_(0),
+      filter_(mode == AcquisitionMode::SingleShot ? AdcFilter::SINGLE_SHOT_CONFIG : AdcFilter::DEFAULT_CONFIG),
+      filteredCode_(0), millivoltsPerCode_(VMETER_NOMINAL_MILLIVOLTS_PER_CODE * COEF_CORRECTION),
+      curve_(DEFAULT_CALIBRATION_CURVE), table_(NOMINAL_CALIBRATION_TABLE), windSpeed_(0.0f), samplesProcessed_(0),
+      timestampUs_(0), recorder_(nullptr), streamer_(nullptr), analyzer_(nullptr), calibrationStore_(nullptr),
+      calibrationSource_(CalibrationSource::None), sensorReady_(false), sensorAttempts_(0), lastAttemptMs_(0),
+      retryDelayMs_(SENSOR_RETRY_FIRST_MS), sensorReadyMs_(0) {}
 
 /**
  * @brief Set the logger instance for the class
@@ -79,38 +95,102 @@ void Anemometer::setLogger(Logger& logger) {
 }
 
 /**
- * @brief Log a message using the class logger
+ * @brief Cache the converter factory calibration across boots
  */
-void Anemometer::log(const String& message) {
-    if (logger_) {
-        logger_->log(message);
+void Anemometer::setCalibrationStore(CalibrationStore* store) {
+    calibrationStore_ = store;
+}
+
+/**
+ * @brief Initialize the anemometer, without waiting for the converter
+ */
+bool Anemometer::setup() {
+    // A cached factory calibration gives the scale before the converter answers
+    AdcCalibration cached;
+    if (calibrationStore_ && calibrationStore_->load(cached, calibrationSource_)) {
+        voltmeter_.setCalibration(cached);
+        millivoltsPerCode_ = voltmeter_.millivoltsPerCode() * COEF_CORRECTION;
+        rebuildCalibrationTable();
+    }
+
+    lastAttemptMs_ = clock_.millis();
+    if (startSensor()) {
+        return true;
+    }
+    log(LogLevel::Error, "Unit Vmeter Init Fail, retrying in %lu ms", retryDelayMs_);
+    // The unit that answers later may not be the one cached: read its calibration then
+    if (calibrationSource_ != CalibrationSource::None) {
+        AdcCalibration none = {};
+        voltmeter_.setCalibration(none);
+        calibrationSource_ = CalibrationSource::None;
     }
+    return false;
 }
 
 /**
- * @brief Initialize the anemometer
+ * @brief Initialise the converter and start the acquisition mode
  */
-void Anemometer::setup() {
+bool Anemometer::startSensor() {
+    sensorAttempts_++;
+    if (!voltmeter_.begin()) {
+        return false;
+    }
+
+    // Calibration read from the converter: cache it for the next boots
+    AdcCalibration calibration;
+    if (calibrationSource_ == CalibrationSource::None && voltmeter_.getCalibration(calibration)) {
+        calibrationSource_ = CalibrationSource::Converter;
+        if (calibrationStore_ && !calibrationStore_->save(calibration)) {
+            log(LogLevel::Warning, "Calibration cache write failed");
+        }
+    }
+
+    // Apply the factory calibration once, in the lookup table
+    float millivoltsPerCode = voltmeter_.millivoltsPerCode() * COEF_CORRECTION;
+    if (millivoltsPerCode != millivoltsPerCode_) {
+        millivoltsPerCode_ = millivoltsPerCode;
+        rebuildCalibrationTable();
+    }
 
-    // Additional setup code can be added here
-    while (!voltmeter_.begin(&Wire1, M5_UNIT_VMETER_I2C_ADDR, 2, 1, 400000U)) {
-        logger_->log("Unit Vmeter Init Fail");
-        delay(1000);
+    if (mode_ == AcquisitionMode::Continuous) {
+        voltmeter_.startContinuous(sampleRate_);
+        if (alertPin_ >= 0) {
+            voltmeter_.enableConversionReadyPin();
+        }
+        if (!sampler_.start(alertPin_)) {
+            log(LogLevel::Warning, "ADC reader start failed, falling back to single-shot");
+            mode_ = AcquisitionMode::SingleShot;
+            filter_.setConfig(AdcFilter::SINGLE_SHOT_CONFIG);
+        }
+    }
+    if (mode_ == AcquisitionMode::SingleShot) {
+        voltmeter_.startSingleShot(sampleRate_);
     }
-    //logger_->log("# Unit Vmeter OK");
-    voltmeter_.setEEPROMAddr(M5_UNIT_VMETER_EEPROM_I2C_ADDR);
-    voltmeter_.setMode(ADS1115_MODE_SINGLESHOT);
-    voltmeter_.setRate(ADS1115_RATE_8);
-    voltmeter_.setGain(ADS1115_PGA_2048);
-    // | PGA      | Max Input Voltage(V) |
-    // | PGA_6144 |        128           |
-    // | PGA_4096 |        64            |
-    // | PGA_2048 |        32            |
-    // | PGA_512  |        16            |
-    // | PGA_256  |        8             |
+    if (mode_ == AcquisitionMode::Replay) {
+        voltmeter_.startContinuous(sampleRate_);
+        replayUs_ = clock_.micros();
+        replayDue_ = 0;
+    }
+    sensorReadyMs_ = clock_.millis();
+    sensorReady_ = true;
+    return true;
+}
 
-    resolution_ = voltmeter_.getCoefficient() / M5_UNIT_VMETER_PRESSURE_COEFFICIENT;
-    calibration_factor_ = voltmeter_.getFactoryCalibration();
+/**
+ * @brief Try the converter again once the backoff delay has passed
+ */
+void Anemometer::retrySensor(uint32_t now) {
+    if (now - lastAttemptMs_ < retryDelayMs_) {
+        return;
+    }
+    lastAttemptMs_ = now;
+    if (startSensor()) {
+        log(LogLevel::Info, "Unit Vmeter OK after %lu attempts (calibration from %s)", sensorAttempts_,
+            calibrationSourceName(calibrationSource_));
+        return;
+    }
+    retryDelayMs_ = retryDelayMs_ * 2 < SENSOR_RETRY_MAX_MS ? retryDelayMs_ * 2 : SENSOR_RETRY_MAX_MS;
+    log(LogLevel::Debug, "Unit Vmeter Init Fail, retrying in %lu ms", retryDelayMs_);
 }
 
 
@@ -118,22 +198,146 @@ void Anemometer::setup() {
  * @brief Update the voltage and wind speed readings
  */
 void Anemometer::update() {
-    // Read voltage from the voltmeter and convert to wind speed
-    // Correction a appliquer / mesures
-    float coefCorrection = 1.0051;
-    
-    int16_t adc_raw = voltmeter_.getSingleConversion();
+    TRACE_SCOPE(TraceStage::Update);
+    size_t count = 0;
+    uint32_t now = clock_.millis();
+    uint32_t nowUs = clock_.micros();
+    timestampUs_ = nowUs;
+    if (!sensorReady_) {
+        retrySensor(now);
+        return;
+    }
+    if (mode_ == AcquisitionMode::Continuous) {
+        count = sampler_.drain(codes_, AdcSampler::RING_SIZE);
+        processBlock(count, now, nowUs);
+    } else if (mode_ == AcquisitionMode::Replay) {
+        count = readReplay(nowUs);
+        processBlock(count, now, nowUs);
+    } else {
+        int16_t code = voltmeter_.readSingle();
+        if (streamer_) {
+            streamer_->append(&code, 1, nowUs, 0);
+        }
+        processSample(code, now);
+        int32_t filtered;
+        if (filter_.push(code, filtered)) {
+            processFiltered(filtered, now);
+        }
+        count = 1;
+    }
 
-    float voltage   = adc_raw * resolution_ * calibration_factor_ * coefCorrection;
+    // Log the readings
+    log(LogLevel::Debug, "Voltage: %.2f V, Wind Speed: %.2f m/s (%u samples)", getVoltage(), windSpeed_, count);
+}
 
-    // Simulate a random voltage between 0V and 15V for testing
-    //voltage = 1.5f + 1.5f * sin(millis() / 10000.0f); // Sinusoidal voltage between 0V and 3V with slow evolution
+/**
+ * @brief Read the conversions due since the previous update() (replay mode)
+ */
+size_t Anemometer::readReplay(uint32_t nowUs) {
+    replayDue_ += static_cast<uint64_t>(nowUs - replayUs_) * voltmeter_.sampleRate();
+    replayUs_ = nowUs;
+    size_t count = 0;
+    while (replayDue_ >= 1000000 && count < AdcSampler::RING_SIZE) {
+        if (!voltmeter_.readConversion(codes_[count])) {
+            replayDue_ = 0; // End of the trace
+            break;
+        }
+        replayDue_ -= 1000000;
+        count++;
+    }
+    return count;
+}
 
-    voltage_ = voltage;
-    windSpeed_ = voltageToWindSpeed(voltage);
+/**
+ * @brief Record, filter and convert the codes of one update
+ */
+void Anemometer::processBlock(size_t count, uint32_t now, uint32_t nowUs) {
+    // Conversions are evenly spaced at the data rate, the last one is the most recent
+    uint32_t periodUs = 1000000UL / voltmeter_.sampleRate();
+    if (streamer_) {
+        streamer_->append(codes_, count, nowUs, periodUs);
+    }
+    for (size_t i = 0; i < count; i++) {
+        processSample(codes_[i], now - static_cast<uint32_t>(((count - 1 - i) * periodUs) / 1000));
+    }
+    // Filtered codes are decimation conversions apart, the last one ends near the most recent code
+    size_t outputs;
+    {
+        TRACE_SCOPE(TraceStage::Filter);
+        outputs = filter_.process(codes_, count, filtered_);
+    }
+    TRACE_SCOPE(TraceStage::Convert);
+    uint32_t outputPeriodUs = periodUs * filter_.config().decimation;
+    for (size_t i = 0; i < outputs; i++) {
+        processFiltered(filtered_[i], now - static_cast<uint32_t>(((outputs - 1 - i) * outputPeriodUs) / 1000));
+    }
+}
 
-    // Log the readings
-    log("Voltage: " + String(voltage_, 2) + " V, Wind Speed: " + String(windSpeed_, 2) + " m/s");
+/**
+ * @brief Stop the continuous-mode reader
+ */
+void Anemometer::stop() {
+    if (mode_ == AcquisitionMode::Continuous) {
+        sampler_.stop();
+    }
+}
+
+/**
+ * @brief Count one raw ADC code and record it with its unfiltered wind speed
+ */
+void Anemometer::processSample(int16_t code, uint32_t timestampMs) {
+    if (recorder_) {
+        float speed = table_.valid() ? table_.lookup(code) * 0.001f : voltageToWindSpeed(code * millivoltsPerCode_);
+        recorder_->append(timestampMs, code, speed);
+    }
+    samplesProcessed_++;
+}
+
+/**
+ * @brief Convert one filtered code and store it as the latest reading
+ */
+void Anemometer::processFiltered(int32_t code, uint32_t timestampMs) {
+    // Convert the code to wind speed (table lookup, float path only if the table is unusable)
+    filteredCode_ = code;
+    if (table_.valid()) {
+        windSpeed_ = table_.lookupFraction(code, AdcFilter::FRACTION_BITS) * 0.001f;
+    } else {
+        windSpeed_ = voltageToWindSpeed(code * (millivoltsPerCode_ / (1 << AdcFilter::FRACTION_BITS)));
+    }
+    statistics_.addSample(windSpeed_, timestampMs);
+    if (analyzer_) {
+        analyzer_->addSample(windSpeed_);
+    }
+}
+
+bool Anemometer::isSensorReady() const {
+    return sensorReady_;
+}
+
+uint32_t Anemometer::getSensorAttempts() const {
+    return sensorAttempts_;
+}
+
+uint32_t Anemometer::getSensorReadyMs() const {
+    return sensorReadyMs_;
+}
+
+CalibrationSource Anemometer::getCalibrationSource() const {
+    return calibrationSource_;
+}
+
+/**
+ * @brief Get the number of conversions processed since setup
+ */
+uint32_t Anemometer::getSamplesProcessed() const {
+    return samplesProcessed_;
+}
+
+/**
+ * @brief Get the number of conversions lost to ring overruns
+ */
+uint32_t Anemometer::getOverruns() const {
+    return sampler_.overruns();
 }
 
 /**
@@ -141,7 +345,61 @@ void Anemometer::update() {
  * @return Voltage in volts
  */
 float Anemometer::getVoltage() const {
-    return voltage_;
+    return filteredCode_ * (millivoltsPerCode_ / (1 << AdcFilter::FRACTION_BITS));
+}
+
+/**
+ * @brief Replace the filter configuration
+ */
+bool Anemometer::setFilter(const AdcFilter::Config& config) {
+    if (!filter_.setConfig(config)) {
+        return false;
+    }
+    retuneAnalyzer();
+    return true;
+}
+
+/**
+ * @brief Change the converter data rate without stopping the acquisition
+ */
+bool Anemometer::setSampleRate(uint16_t rate) {
+    if (rate < 8 || rate > 860) {
+        return false;
+    }
+    sampleRate_ = rate;
+    if (!sensorReady_) {
+        return true;
+    }
+    if (mode_ == AcquisitionMode::Continuous) {
+        sampler_.setRate(rate);
+    } else if (mode_ == AcquisitionMode::SingleShot) {
+        voltmeter_.startSingleShot(rate);
+    } else {
+        voltmeter_.startContinuous(rate);
+    }
+    retuneAnalyzer();
+    return true;
+}
+
+uint16_t Anemometer::getSampleRate() const {
+    return sampleRate_;
+}
+
+/**
+ * @brief Give the turbulence analyzer the filter output rate
+ */
+void Anemometer::retuneAnalyzer() {
+    // In single-shot mode the analyzer rate is the update() rate, set by the caller
+    if (analyzer_ && mode_ != AcquisitionMode::SingleShot) {
+        analyzer_->changeInputRate(filter_.outputRate(sampleRate_));
+    }
+}
+
+/**
+ * @brief Get the filter
+ */
+const AdcFilter& Anemometer::getFilter() const {
+    return filter_;
 }
 
 /**
@@ -152,6 +410,54 @@ float Anemometer::getWindSpeed() const {
     return windSpeed_;
 }
 
+/**
+ * @brief Get the acquisition time of the last update
+ */
+uint32_t Anemometer::getTimestampUs() const {
+    return timestampUs_;
+}
+
+
+/**
+ * @brief Get the rolling wind statistics
+ * @return Gust, lull, mean and min/max over the reporting window
+ */
+WindStats Anemometer::getStatistics() const {
+    return statistics_.get();
+}
+
+/**
+ * @brief Record every processed sample
+ */
+void Anemometer::setRecorder(SampleRecorder* recorder) {
+    recorder_ = recorder;
+}
+
+/**
+ * @brief Stream every raw code over the serial port
+ */
+void Anemometer::setStreamer(SampleStreamer* streamer) {
+    streamer_ = streamer;
+}
+
+/**
+ * @brief Feed every filtered wind speed to a turbulence analyzer
+ */
+void Anemometer::setAnalyzer(TurbulenceAnalyzer* analyzer) {
+    if (analyzer && mode_ != AcquisitionMode::SingleShot) {
+        analyzer->setInputRate(filter_.outputRate(voltmeter_.sampleRate()));
+    }
+    analyzer_ = analyzer;
+}
+
+float Anemometer::getMillivoltsPerCode() const {
+    return millivoltsPerCode_;
+}
+
+const CalibrationCurve& Anemometer::getCalibrationCurve() const {
+    return curve_;
+}
+
 
 //Calculer l ordonnee y d une courbe xtab, ytab pour l abscisse x
 float calculerY(float xtab[], float ytab[], int taille, float x) {
@@ -178,10 +484,58 @@ float Anemometer::voltageToWindSpeed(float voltage) {
     float voltage_mV = voltage; // 1000.0f;
 
     // Interpolate on calibration curve: mV -> km/h
-    float windSpeed_kmh = calculerY(INPUT_WIND_SPEED_VS_VOLTAGE, OUTPUT_WIND_SPEED_VS_VOLTAGE, CALIBRATION_TABLE_SIZE, voltage_mV);
+    float windSpeed_kmh = calculerY(curve_.millivolts, curve_.kmh, curve_.size, voltage_mV);
 
     // Convert from km/h to m/s
     float windSpeed = windSpeed_kmh / 3.6f;
 
     return windSpeed;
 }
+
+/**
+ * @brief Replace the calibration curve
+ */
+bool Anemometer::loadCalibrationCurve(const float* millivolts, const float* kmh, size_t size) {
+    if (size > CalibrationCurve::MAX_POINTS) {
+        return false;
+    }
+    CalibrationCurve curve = {};
+    for (size_t i = 0; i < size; i++) {
+        curve.millivolts[i] = millivolts[i];
+        curve.kmh[i] = kmh[i];
+    }
+    curve.size = size;
+    if (!curve.valid()) {
+        log(LogLevel::Error, "Calibration curve rejected (abscisses non croissantes)");
+        return false;
+    }
+    curve_ = curve;
+    rebuildCalibrationTable();
+    return true;
+}
+
+/**
+ * @brief Regenerate the lookup table and check it against the float path
+ */
+void Anemometer::rebuildCalibrationTable() {
+    if (!table_.build(curve_, millivoltsPerCode_)) {
+        log(LogLevel::Warning, "Calibration table build failed, using float conversion");
+        return;
+    }
+    log(LogLevel::Info, "Calibration table max error: %ld mm/s", verifyCalibrationTable());
+}
+
+/**
+ * @brief Compare the lookup table with voltageToWindSpeed() over a code range
+ */
+int32_t Anemometer::verifyCalibrationTable(int32_t firstCode, int32_t lastCode) {
+    int32_t maxError = 0;
+    for (int32_t code = firstCode; code <= lastCode; code++) {
+        float reference = voltageToWindSpeed(code * millivoltsPerCode_) * 1000.0f;
+        int32_t expected = static_cast<int32_t>(reference >= 0.0f ? reference + 0.5f : reference - 0.5f);
+        int32_t error = table_.lookup(static_cast<int16_t>(code)) - expected;
+        if (error < 0) error = -error;
+        if (error > maxError) maxError = error;
+    }
+    return maxError;
+}
@@ -0,0 +1,198 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file AnemometerControl.cpp
+ * @brief Control channel target: runtime sampling, filter, transmit and log settings
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "AnemometerControl.h"
+#include "Trace.h"
+
+/**
+ * @brief Construct a new AnemometerControl object
+ */
+AnemometerControl::AnemometerControl(Anemometer& anemometer, Communication& comm, Logger& logger, Clock& clock)
+    : anemometer_(anemometer), comm_(comm), logger_(logger), clock_(clock), settings_(), changes_(), applied_(0) {
+}
+
+/**
+ * @brief Read the settings in force
+ */
+void AnemometerControl::begin() {
+    settings_.sampleRate = anemometer_.getSampleRate();
+    const AdcFilter::Config& filter = anemometer_.getFilter().config();
+    settings_.medianSize = filter.medianSize;
+    settings_.decimation = filter.decimation;
+    settings_.cicOrder = filter.cicOrder;
+    settings_.smoothingShift = filter.smoothingShift;
+    const BroadcastPolicy::Config& policy = comm_.policy().config();
+    settings_.speedDeadband = policy.speedDeadband;
+    settings_.gustDeadband = policy.gustDeadband;
+    settings_.minIntervalMs = policy.minIntervalMs;
+    settings_.rampStartMs = policy.rampStartMs;
+    settings_.heartbeatMs = policy.heartbeatMs;
+    settings_.fixedIntervalMs = policy.fixedIntervalMs;
+    // The logger has no getter: the most verbose level the main module passes
+    settings_.logLevel = static_cast<uint8_t>(LogLevel::Error);
+    for (uint8_t level = static_cast<uint8_t>(LogLevel::Debug); level > 0; level--) {
+        if (logger_.enabled(LogModule::Main, static_cast<LogLevel>(level))) {
+            settings_.logLevel = level;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Check the groups of a settings change
+ */
+uint8_t AnemometerControl::validate(const DeviceSettings& settings, uint8_t groups) {
+    static const uint16_t RATES[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+    if (groups & WireFormat::SET_SAMPLING) {
+        bool supported = false;
+        for (size_t i = 0; i < sizeof(RATES) / sizeof(RATES[0]); i++) {
+            supported = supported || settings.sampleRate == RATES[i];
+        }
+        if (!supported) {
+            return WireFormat::STATUS_INVALID;
+        }
+    }
+    if (groups & WireFormat::SET_FILTER) {
+        AdcFilter::Config filter = {settings.medianSize, settings.decimation, settings.cicOrder,
+                                    settings.smoothingShift};
+        if (!AdcFilter::valid(filter)) {
+            return WireFormat::STATUS_INVALID;
+        }
+    }
+    if (groups & WireFormat::SET_POLICY) {
+        if (!(settings.speedDeadband >= 0.0f) || !(settings.gustDeadband >= 0.0f) || settings.minIntervalMs == 0 ||
+            settings.fixedIntervalMs == 0 || settings.heartbeatMs > MAX_HEARTBEAT_MS) {
+            return WireFormat::STATUS_INVALID;
+        }
+    }
+    if ((groups & WireFormat::SET_LOGGING) && settings.logLevel > static_cast<uint8_t>(LogLevel::Debug)) {
+        return WireFormat::STATUS_INVALID;
+    }
+    return WireFormat::STATUS_OK;
+}
+
+void AnemometerControl::getSettings(DeviceSettings& settings) {
+    settings = settings_;
+}
+
+/**
+ * @brief Change some settings, all or none of them
+ */
+uint8_t AnemometerControl::applySettings(const DeviceSettings& settings, uint8_t groups) {
+    uint8_t status = validate(settings, groups);
+    if (status != WireFormat::STATUS_OK) {
+        return status;
+    }
+
+    // Queued first: the only step that can still fail
+    uint8_t acquisition = groups & (WireFormat::SET_SAMPLING | WireFormat::SET_FILTER);
+    if (acquisition) {
+        AcquisitionChange change;
+        change.groups = acquisition;
+        change.sampleRate = settings.sampleRate;
+        change.filter = {settings.medianSize, settings.decimation, settings.cicOrder, settings.smoothingShift};
+        if (!changes_.push(change)) {
+            return WireFormat::STATUS_BUSY;
+        }
+        if (acquisition & WireFormat::SET_SAMPLING) {
+            settings_.sampleRate = settings.sampleRate;
+        }
+        if (acquisition & WireFormat::SET_FILTER) {
+            settings_.medianSize = settings.medianSize;
+            settings_.decimation = settings.decimation;
+            settings_.cicOrder = settings.cicOrder;
+            settings_.smoothingShift = settings.smoothingShift;
+        }
+    }
+
+    if (groups & WireFormat::SET_POLICY) {
+        BroadcastPolicy::Config policy = {settings.speedDeadband, settings.gustDeadband, settings.minIntervalMs,
+                                          settings.rampStartMs, settings.heartbeatMs, settings.fixedIntervalMs};
+        comm_.setPolicy(policy);
+        // The policy orders the intervals: report what it kept
+        const BroadcastPolicy::Config& kept = comm_.policy().config();
+        settings_.speedDeadband = kept.speedDeadband;
+        settings_.gustDeadband = kept.gustDeadband;
+        settings_.minIntervalMs = kept.minIntervalMs;
+        settings_.rampStartMs = kept.rampStartMs;
+        settings_.heartbeatMs = kept.heartbeatMs;
+        settings_.fixedIntervalMs = kept.fixedIntervalMs;
+    }
+
+    if (groups & WireFormat::SET_LOGGING) {
+        for (size_t module = 0; module < LOG_MODULE_COUNT; module++) {
+            logger_.setLevel(static_cast<LogModule>(module), static_cast<LogLevel>(settings.logLevel));
+        }
+        settings_.logLevel = settings.logLevel;
+    }
+    return WireFormat::STATUS_OK;
+}
+
+/**
+ * @brief Node counters
+ */
+void AnemometerControl::getStats(DeviceStats& stats) {
+    stats.uptimeS = clock_.millis() / 1000;
+    stats.samples = anemometer_.getSamplesProcessed();
+    stats.overruns = anemometer_.getOverruns();
+    stats.spikes = anemometer_.getFilter().spikes();
+    stats.framesSent = comm_.policy().sent();
+    stats.radioQueued = comm_.transmitter().queued();
+    stats.radioFailed = comm_.transmitter().failed();
+    stats.commands = 0;
+    stats.rejected = 0;
+}
+
+/**
+ * @brief Clear the transmit counters and the trace histograms
+ */
+void AnemometerControl::resetCounters() {
+    comm_.resetCounters();
+#if TRACE_ENABLED
+    Trace::reset();
+#endif
+}
+
+/**
+ * @brief Apply the queued sampling and filter changes
+ */
+bool AnemometerControl::applyPending() {
+    AcquisitionChange change;
+    bool appliedAny = false;
+    while (changes_.pop(change)) {
+        // Both before the next update(): no block is processed with one and not the other
+        if (change.groups & WireFormat::SET_FILTER) {
+            anemometer_.setFilter(change.filter);
+        }
+        if (change.groups & WireFormat::SET_SAMPLING) {
+            anemometer_.setSampleRate(change.sampleRate);
+        }
+        applied_.fetch_add(1, std::memory_order_relaxed);
+        appliedAny = true;
+    }
+    return appliedAny;
+}
+
+uint32_t AnemometerControl::appliedChanges() const {
+    return applied_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file BroadcastPolicy.cpp
+ * @brief Deadband, rate cap and heartbeat decisions for the wind broadcasts
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "BroadcastPolicy.h"
+#include <math.h>
+
+const BroadcastPolicy::Config BroadcastPolicy::DEFAULT_CONFIG = {1.0f, 0.5f, 250, 1000, 10000, 2000};
+
+/**
+ * @brief Construct a new BroadcastPolicy object
+ */
+BroadcastPolicy::BroadcastPolicy(const Config& config) {
+    setConfig(config);
+}
+
+/**
+ * @brief Replace the configuration and reset
+ */
+void BroadcastPolicy::setConfig(const Config& config) {
+    config_ = config;
+    if (config_.minIntervalMs == 0) {
+        config_.minIntervalMs = 1;
+    }
+    if (config_.rampStartMs < config_.minIntervalMs) {
+        config_.rampStartMs = config_.minIntervalMs;
+    }
+    if (config_.heartbeatMs < config_.rampStartMs) {
+        config_.heartbeatMs = config_.rampStartMs;
+    }
+    if (config_.fixedIntervalMs == 0) {
+        config_.fixedIntervalMs = 1;
+    }
+    reset();
+}
+
+const BroadcastPolicy::Config& BroadcastPolicy::config() const {
+    return config_;
+}
+
+/**
+ * @brief Forget the last frame and clear the counters
+ */
+void BroadcastPolicy::reset() {
+    started_ = false;
+    startMs_ = 0;
+    lastEvaluationMs_ = 0;
+    lastSendMs_ = 0;
+    lastRelaxMs_ = 0;
+    gapMs_ = config_.rampStartMs;
+    sentSpeed_ = 0.0f;
+    sentGust_ = 0.0f;
+    requested_ = false;
+    evaluations_ = 0;
+    events_ = 0;
+    heartbeats_ = 0;
+    rateLimited_ = 0;
+}
+
+/**
+ * @brief Record a frame sent
+ */
+BroadcastPolicy::Decision BroadcastPolicy::send(Decision decision, uint32_t nowMs, float speed, float gust) {
+    if (decision == Decision::Event) {
+        events_++;
+    } else {
+        heartbeats_++;
+    }
+    lastSendMs_ = nowMs;
+    lastRelaxMs_ = nowMs;
+    sentSpeed_ = speed;
+    sentGust_ = gust;
+    requested_ = false;
+    return decision;
+}
+
+/**
+ * @brief Decide whether the current measurement should be broadcast
+ *
+ * Changes are measured against the last frame sent, not the last evaluation, so a
+ * slow drift still goes out once it adds up to the deadband.
+ */
+BroadcastPolicy::Decision BroadcastPolicy::evaluate(uint32_t nowMs, float speed, float gust) {
+    evaluations_++;
+    lastEvaluationMs_ = nowMs;
+    if (!started_) {
+        // First frame: tell the receivers we are here
+        started_ = true;
+        startMs_ = nowMs;
+        return send(Decision::Heartbeat, nowMs, speed, gust);
+    }
+
+    uint32_t sinceSend = nowMs - lastSendMs_;
+    if (requested_ && sinceSend >= config_.minIntervalMs) {
+        return send(Decision::Event, nowMs, speed, gust);
+    }
+    bool changed = fabsf(speed - sentSpeed_) >= config_.speedDeadband ||
+                   fabsf(gust - sentGust_) >= config_.gustDeadband;
+    if (changed) {
+        if (sinceSend < gapMs_) {
+            rateLimited_++; // Still out of the deadband next time, so it goes out when the gap allows
+            return Decision::Hold;
+        }
+        // Busy wind: the next change may follow sooner, down to the capped rate
+        gapMs_ = gapMs_ / 2 > config_.minIntervalMs ? gapMs_ / 2 : config_.minIntervalMs;
+        return send(Decision::Event, nowMs, speed, gust);
+    }
+
+    // A whole gap without a change: relax towards the quiet rate
+    if (nowMs - lastRelaxMs_ >= gapMs_ && gapMs_ < config_.rampStartMs) {
+        gapMs_ = gapMs_ * 2 < config_.rampStartMs ? gapMs_ * 2 : config_.rampStartMs;
+        lastRelaxMs_ = nowMs;
+    }
+    if (sinceSend >= config_.heartbeatMs) {
+        return send(Decision::Heartbeat, nowMs, speed, gust);
+    }
+    return Decision::Hold;
+}
+
+/**
+ * @brief Send a frame at the next evaluation the rate cap allows
+ */
+void BroadcastPolicy::requestFrame() {
+    requested_ = true;
+}
+
+uint32_t BroadcastPolicy::evaluations() const {
+    return evaluations_;
+}
+
+uint32_t BroadcastPolicy::sent() const {
+    return events_ + heartbeats_;
+}
+
+uint32_t BroadcastPolicy::events() const {
+    return events_;
+}
+
+uint32_t BroadcastPolicy::heartbeats() const {
+    return heartbeats_;
+}
+
+uint32_t BroadcastPolicy::rateLimited() const {
+    return rateLimited_;
+}
+
+/**
+ * @brief Frames the fixed schedule would have sent (one at start, then one per period)
+ */
+uint32_t BroadcastPolicy::fixedScheduleFrames() const {
+    if (!started_) {
+        return 0;
+    }
+    return (lastEvaluationMs_ - startMs_) / config_.fixedIntervalMs + 1;
+}
+
+int32_t BroadcastPolicy::saved() const {
+    return static_cast<int32_t>(fixedScheduleFrames()) - static_cast<int32_t>(sent());
+}
+
+uint32_t BroadcastPolicy::currentGapMs() const {
+    return gapMs_;
+}
@@ -0,0 +1,108 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Canvas.cpp
+ * @brief Windowed RGB565 off-screen surface with a small built-in font
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "Canvas.h"
+
+/**
+ * @brief 5x7 glyph, one byte per column, bit 0 at the top
+ */
+struct Glyph {
+    char c;
+    uint8_t columns[5];
+};
+
+static const Glyph FONT[] = {
+    {' ', {0x00, 0x00, 0x00, 0x00, 0x00}}, {'-', {0x08, 0x08, 0x08, 0x08, 0x08}},
+    {'.', {0x00, 0x60, 0x60, 0x00, 0x00}}, {'/', {0x20, 0x10, 0x08, 0x04, 0x02}},
+    {'0', {0x3E, 0x51, 0x49, 0x45, 0x3E}}, {'1', {0x00, 0x42, 0x7F, 0x40, 0x00}},
+    {'2', {0x42, 0x61, 0x51, 0x49, 0x46}}, {'3', {0x21, 0x41, 0x45, 0x4B, 0x31}},
+    {'4', {0x18, 0x14, 0x12, 0x7F, 0x10}}, {'5', {0x27, 0x45, 0x45, 0x45, 0x39}},
+    {'6', {0x3C, 0x4A, 0x49, 0x49, 0x30}}, {'7', {0x01, 0x71, 0x09, 0x05, 0x03}},
+    {'8', {0x36, 0x49, 0x49, 0x49, 0x36}}, {'9', {0x06, 0x49, 0x49, 0x29, 0x1E}},
+    {':', {0x00, 0x36, 0x36, 0x00, 0x00}}, {'G', {0x3E, 0x41, 0x49, 0x49, 0x7A}},
+    {'L', {0x7F, 0x40, 0x40, 0x40, 0x40}}, {'m', {0x7C, 0x04, 0x18, 0x04, 0x78}},
+    {'s', {0x48, 0x54, 0x54, 0x54, 0x20}},
+};
+
+static const uint8_t UNKNOWN_GLYPH[5] = {0x7F, 0x41, 0x41, 0x41, 0x7F};
+
+static const uint8_t* findGlyph(char c) {
+    for (size_t i = 0; i < sizeof(FONT) / sizeof(FONT[0]); i++) {
+        if (FONT[i].c == c) {
+            return FONT[i].columns;
+        }
+    }
+    return UNKNOWN_GLYPH;
+}
+
+Canvas::Canvas(uint16_t* pixels, size_t capacity)
+    : pixels_(pixels), capacity_(capacity), x_(0), y_(0), width_(0), height_(0) {
+}
+
+bool Canvas::setWindow(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (w <= 0 || h <= 0 || static_cast<size_t>(w) * h > capacity_) {
+        return false;
+    }
+    x_ = x;
+    y_ = y;
+    width_ = w;
+    height_ = h;
+    return true;
+}
+
+void Canvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    int16_t left = x > x_ ? x : x_;
+    int16_t top = y > y_ ? y : y_;
+    int16_t right = x + w < x_ + width_ ? x + w : x_ + width_;
+    int16_t bottom = y + h < y_ + height_ ? y + h : y_ + height_;
+    for (int16_t row = top; row < bottom; row++) {
+        uint16_t* line = pixels_ + (row - y_) * width_;
+        for (int16_t column = left; column < right; column++) {
+            line[column - x_] = color;
+        }
+    }
+}
+
+void Canvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x >= x_ && x < x_ + width_ && y >= y_ && y < y_ + height_) {
+        pixels_[(y - y_) * width_ + (x - x_)] = color;
+    }
+}
+
+void Canvas::drawChar(int16_t x, int16_t y, char c, uint8_t scale, uint16_t color, uint16_t background) {
+    fillRect(x, y, CHAR_WIDTH * scale, CHAR_HEIGHT * scale, background);
+    const uint8_t* glyph = findGlyph(c);
+    for (int16_t column = 0; column < 5; column++) {
+        uint8_t bits = glyph[column];
+        for (int16_t row = 0; bits; row++, bits >>= 1) {
+            if (bits & 1) {
+                fillRect(x + column * scale, y + row * scale, scale, scale, color);
+            }
+        }
+    }
+}
+
+void Canvas::drawText(int16_t x, int16_t y, const char* text, uint8_t scale, uint16_t color, uint16_t background) {
+    for (; *text; text++, x += CHAR_WIDTH * scale) {
+        drawChar(x, y, *text, scale, color, background);
+    }
+}
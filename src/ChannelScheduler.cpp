@@ -0,0 +1,285 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file ChannelScheduler.cpp
+ * @brief Interleaved sampling of several multiplexer inputs of one converter
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * One single-shot conversion at a time: the ADS1115 has one modulator behind its
+ * multiplexer, and a single-shot conversion started right after a multiplexer change
+ * is settled (single-cycle settling filter), so no conversion is thrown away. What
+ * an input switch costs is the I2C traffic around it; starting the next conversion
+ * before reading the finished one hides the read (about 120 us at 400 kHz) behind
+ * the conversion, which lasts at least 1.16 ms.
+ */
+
+#include "ChannelScheduler.h"
+
+/**
+ * @brief Construct a new ChannelScheduler object
+ */
+ChannelScheduler::ChannelScheduler(AdcSource& source, Clock& clock, int core)
+    : source_(source), clock_(clock), channels_(), channelCount_(0), pipelined_(true), conversionUs_(0),
+      halfConversionUs_(0), converting_(false), active_(0), startUs_(0), readyUs_(0), conversions_(0), errors_(0)
+#ifdef ARDUINO
+      , task_("adc_channels", 3072, READER_PRIORITY, core), timer_(nullptr)
+#endif
+{
+#ifndef ARDUINO
+    (void)core;
+#endif
+}
+
+/**
+ * @brief Add a channel
+ */
+int ChannelScheduler::addChannel(const ChannelConfig& config) {
+    if (channelCount_ >= MAX_CHANNELS || config.rate == 0 || config.input >= source_.inputCount()) {
+        return -1;
+    }
+    Channel& channel = channels_[channelCount_];
+    channel.config = config;
+    channel.periodUs = 1000000UL / config.rate;
+    channel.dueUs = 0;
+    channel.samples.store(0);
+    channel.skipped.store(0);
+    channel.maxLatenessUs.store(0);
+    return static_cast<int>(channelCount_++);
+}
+
+void ChannelScheduler::setPipelined(bool pipelined) {
+    pipelined_ = pipelined;
+}
+
+/**
+ * @brief Switch the converter to single-shot mode and make every channel due now
+ */
+bool ChannelScheduler::begin(uint16_t converterRate) {
+    if (source_.inputCount() == 0 || !source_.startSingleShot(converterRate)) {
+        return false;
+    }
+    conversionUs_ = source_.conversionUs();
+    uint16_t rate = source_.sampleRate();
+    halfConversionUs_ = rate ? 500000UL / rate : 0;
+    converting_ = false;
+    uint32_t now = clock_.micros();
+    for (size_t i = 0; i < channelCount_; i++) {
+        channels_[i].dueUs = now;
+    }
+    return true;
+}
+
+/**
+ * @brief Due channel with the earliest deadline
+ */
+size_t ChannelScheduler::nextDue(uint32_t nowUs) const {
+    size_t best = channelCount_;
+    int32_t bestLate = 0;
+    for (size_t i = 0; i < channelCount_; i++) {
+        int32_t late = static_cast<int32_t>(nowUs - channels_[i].dueUs);
+        if (late >= 0 && (best == channelCount_ || late > bestLate)) {
+            best = i;
+            bestLate = late;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Start a conversion of a channel and move its deadline
+ */
+void ChannelScheduler::startChannel(size_t index, uint32_t nowUs) {
+    Channel& channel = channels_[index];
+    if (!source_.startConversion(channel.config.input)) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // The write ends when the conversion starts
+    startUs_ = clock_.micros();
+    readyUs_ = startUs_ + conversionUs_;
+    active_ = index;
+    converting_ = true;
+    conversions_.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t lateness = startUs_ - channel.dueUs;
+    if (lateness > channel.maxLatenessUs.load(std::memory_order_relaxed)) {
+        channel.maxLatenessUs.store(lateness, std::memory_order_relaxed);
+    }
+    channel.dueUs += channel.periodUs;
+    int32_t behind = static_cast<int32_t>(nowUs - channel.dueUs);
+    if (behind >= static_cast<int32_t>(CATCH_UP_PERIODS * channel.periodUs)) {
+        // Too far behind to catch up: skip the missed deadlines rather than bunch them up
+        uint32_t missed = static_cast<uint32_t>(behind) / channel.periodUs + 1;
+        channel.skipped.fetch_add(missed, std::memory_order_relaxed);
+        channel.dueUs += missed * channel.periodUs;
+    }
+}
+
+/**
+ * @brief Read the finished conversion and push it into its channel
+ */
+void ChannelScheduler::collect(size_t index, uint32_t startUs) {
+    int16_t code;
+    if (!source_.readResult(code)) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Channel& channel = channels_[index];
+    ChannelSample sample = {startUs + halfConversionUs_, code};
+    if (channel.ring.push(sample)) {
+        channel.samples.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Collect a finished conversion and start the next one
+ */
+uint32_t ChannelScheduler::service() {
+    uint32_t now = clock_.micros();
+    if (converting_) {
+        int32_t wait = static_cast<int32_t>(readyUs_ - now);
+        if (wait > 0) {
+            return static_cast<uint32_t>(wait);
+        }
+    }
+
+    bool finished = converting_;
+    size_t finishedChannel = active_;
+    uint32_t finishedStartUs = startUs_;
+    converting_ = false;
+
+    if (finished && !pipelined_) {
+        collect(finishedChannel, finishedStartUs);
+        finished = false;
+        now = clock_.micros();
+    }
+    size_t next = nextDue(now);
+    if (next < channelCount_) {
+        startChannel(next, now);
+    }
+    if (finished) {
+        // Read while the next conversion runs: the register still holds this result
+        collect(finishedChannel, finishedStartUs);
+    }
+
+    now = clock_.micros();
+    if (converting_) {
+        int32_t wait = static_cast<int32_t>(readyUs_ - now);
+        return wait > 0 ? static_cast<uint32_t>(wait) : 0;
+    }
+    if (channelCount_ == 0) {
+        return 1000000UL;
+    }
+    int32_t wait = INT32_MAX;
+    for (size_t i = 0; i < channelCount_; i++) {
+        int32_t due = static_cast<int32_t>(channels_[i].dueUs - now);
+        if (due < wait) {
+            wait = due;
+        }
+    }
+    return wait > 0 ? static_cast<uint32_t>(wait) : 0;
+}
+
+/**
+ * @brief Move the samples of one channel out of its ring
+ */
+size_t ChannelScheduler::drain(size_t channel, ChannelSample* out, size_t maxSamples) {
+    return channels_[channel].ring.popBulk(out, maxSamples);
+}
+
+size_t ChannelScheduler::channelCount() const {
+    return channelCount_;
+}
+
+const ChannelConfig& ChannelScheduler::config(size_t channel) const {
+    return channels_[channel].config;
+}
+
+uint32_t ChannelScheduler::samples(size_t channel) const {
+    return channels_[channel].samples.load(std::memory_order_relaxed);
+}
+
+uint32_t ChannelScheduler::skipped(size_t channel) const {
+    return channels_[channel].skipped.load(std::memory_order_relaxed);
+}
+
+uint32_t ChannelScheduler::overruns(size_t channel) const {
+    return channels_[channel].ring.overruns();
+}
+
+uint32_t ChannelScheduler::maxLatenessUs(size_t channel) const {
+    return channels_[channel].maxLatenessUs.load(std::memory_order_relaxed);
+}
+
+uint32_t ChannelScheduler::conversions() const {
+    return conversions_.load(std::memory_order_relaxed);
+}
+
+uint32_t ChannelScheduler::errors() const {
+    return errors_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Fraction of the converter time the channel rates ask for
+ */
+float ChannelScheduler::load() const {
+    float busyUs = 0.0f;
+    for (size_t i = 0; i < channelCount_; i++) {
+        busyUs += static_cast<float>(channels_[i].config.rate) * conversionUs_;
+    }
+    return busyUs / 1000000.0f;
+}
+
+#ifdef ARDUINO
+
+/**
+ * @brief Reader task: serve the converter, then sleep until the timer says there is work
+ */
+void ChannelScheduler::readerTask(void* arg) {
+    ChannelScheduler* self = static_cast<ChannelScheduler*>(arg);
+    while (true) {
+        uint32_t delayUs = self->service();
+        esp_timer_start_once(self->timer_, delayUs ? delayUs : 1);
+        self->task_.wait(100);
+    }
+}
+
+/**
+ * @brief One-shot timer callback (esp_timer task context)
+ */
+void ChannelScheduler::onTimer(void* arg) {
+    static_cast<ChannelScheduler*>(arg)->task_.notify();
+}
+
+/**
+ * @brief Create the one-shot timer, then the reader task
+ */
+bool ChannelScheduler::start() {
+    if (timer_) {
+        return true;
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.name = "adc_channels";
+    if (esp_timer_create(&args, &timer_) != ESP_OK) {
+        return false;
+    }
+    return task_.start(readerTask, this);
+}
+
+#endif
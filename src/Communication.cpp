@@ -28,17 +28,23 @@
  * - ESP-NOW initialization and configuration
  * - WiFi station mode setup
  * - Broadcast communication to all peers
+ * - Adaptive transmit rate (deadband, capped rate, heartbeat) through offer()
+ * - Optional TDMA slots (SlotScheduler) refined by the frames heard from neighbours
+ * - Optional time synchronisation (TimeSync) to a reference node's beacons
+ * - Session summaries (MSG_SUMMARY) sent on request
+ * - Authenticated control commands (ControlChannel) executed in the sending task
  * - Integrated logging support
  * - Error handling for communication failures
  * 
  * Dependencies:
- * - ESP-NOW library for wireless communication
- * - WiFi library for network configuration
+ * - RadioTransport (EspNowTransport: ESP-NOW and WiFi configuration) for wireless communication
  * - Custom Logger class for debugging and monitoring
- * - AnemometerData structure for data transmission
+ * - AnemometerData structure and WireFormat encoder for data transmission
  */
 
 #include "Communication.h"
+#include "Trace.h"
+#include <string.h>
 
 
 // Static member initialization
@@ -46,9 +52,12 @@ Logger* Communication::logger_ = nullptr;
 
 /**
  * @brief Construct a new Communication object
- * Initializes ESPNow and WiFi in station mode.
  */
-Communication::Communication() {
+Communication::Communication(RadioTransport& radio, Clock& clock)
+    : radio_(radio), policy_(), sequence_(0), scheduler_(nullptr), clock_(clock), engine_(radio, clock),
+      observations_(), timeSync_(nullptr), beacons_(), pendingSample_(false), pendingSampleUs_(0),
+      sampleLatencyUs_(0), maxSampleLatencyUs_(0), statusFields_(0), summaries_(false), mac_(),
+      summaryRequested_(false), summaryRequests_(0), control_(nullptr), controls_() {
 }
 
 /**
@@ -58,61 +67,384 @@ void Communication::setLogger(Logger& logger) {
     logger_ = &logger;
 }
 
-/**
- * @brief Log a message using the class logger
- */
-void Communication::log(const String& message) {
-    if (logger_) {
-        logger_->log(message);
-    }
-}
-
 /**
  * @brief Setup Communication
  * Initializes ESPNow and configures WiFi in station mode with maximum power.
  */
 void Communication::setup() {
 
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();
-    
-    // Set WiFi to maximum transmission power (20.5 dBm for ESP32)
-    WiFi.setTxPower(WIFI_POWER_19_5dBm);  // Maximum power
-    log("WiFi TX power set to maximum (19.5 dBm)");
-    
-    if (esp_now_init() != ESP_OK) {
-        log("Error initializing ESP-NOW");
-    }
-
-    if (esp_now_init() != ESP_OK) {
-        log("Error initializing ESP-NOW");
+    if (!radio_.begin()) {
+        log(LogLevel::Error, "Error initializing ESP-NOW");
     } else {
-        log("ESP-NOW initialized");
+        log(LogLevel::Info, "ESP-NOW initialized");
+    }
+    if (!engine_.begin()) {
+        log(LogLevel::Warning, "Radio does not report send completions");
     }
 }
 
 /**
  * @brief Broadcast anemometer data using ESPNow
- * @param data Structure containing anemometer ID, MAC address, and wind speed
+ * @param data Structure containing MAC address, sequence number, wind speed and optional fields
  * @return true if broadcast was successful, false otherwise
  */
 bool Communication::broadcast(const AnemometerData& data) {
+    // Encode and send the frame
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    size_t length = WireFormat::encodeAnemometer(data, frame, sizeof(frame));
+    if (length == 0) {
+        log(LogLevel::Error, "ESP-NOW frame encoding failed");
+        return false;
+    }
+    return send(frame, length);
+}
+
+/**
+ * @brief Broadcast a hot-path timing summary
+ */
+bool Communication::broadcastDiagnostics(const DiagnosticsData& data) {
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    size_t length = WireFormat::encodeDiagnostics(data, frame, sizeof(frame));
+    if (length == 0) {
+        log(LogLevel::Error, "Diagnostics frame encoding failed");
+        return false;
+    }
+    return send(frame, length);
+}
+
+/**
+ * @brief Answer the session summary requests of the receivers
+ */
+bool Communication::enableSummaryRequests() {
+    radio_.macAddress(mac_);
+    summaries_ = true;
+    bool listening = radio_.setReceiveHandler(onReceive, this);
+    if (!listening) {
+        log(LogLevel::Warning, "Summary requests not heard, radio does not report received frames");
+    }
+    return listening;
+}
+
+bool Communication::summaryRequested() const {
+    return summaryRequested_.load(std::memory_order_relaxed);
+}
+
+uint32_t Communication::summaryRequests() const {
+    return summaryRequests_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Broadcast the session statistics
+ */
+bool Communication::broadcastSummary(const SessionSummary& summary) {
+    SessionSummary frameData = summary;
+    memcpy(frameData.macAddress, mac_, sizeof(mac_));
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    size_t length = WireFormat::encodeSummary(frameData, frame, sizeof(frame));
+    if (length == 0) {
+        log(LogLevel::Error, "Summary frame encoding failed");
+        return false;
+    }
+    if (!send(frame, length)) {
+        return false; // Still requested: answered at the next attempt
+    }
+    summaryRequested_.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Send an encoded frame to all peers, in the TDMA slot if there is one
+ */
+bool Communication::send(const uint8_t* frame, size_t length) {
     // Broadcast to all peers (broadcast MAC address)
-    uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    esp_now_peer_info_t peerInfo = {};
-    memcpy(peerInfo.peer_addr, broadcastAddress, 6);
-    peerInfo.channel = 0;
-    peerInfo.encrypt = false;
-
-    // Add broadcast peer if not already added
-    esp_now_add_peer(&peerInfo);
-
-    // Send the data structure
-    esp_err_t result = esp_now_send(broadcastAddress, (uint8_t*)&data, sizeof(data));
-    if (result == ESP_OK) {
-        log("ESP-NOW broadcast success");
+    static const uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    if (scheduler_) {
+        drainObservations();
+        waitForSlot();
+    }
+    RadioTransport::SendStatus status = engine_.send(broadcastAddress, frame, length);
+    if (status == RadioTransport::SendStatus::Queued) {
+        if (pendingSample_) {
+            uint32_t latency = clock_.micros() - pendingSampleUs_;
+            sampleLatencyUs_ = sampleLatencyUs_ == 0 ? latency : sampleLatencyUs_ - sampleLatencyUs_ / 16 + latency / 16;
+            if (latency > maxSampleLatencyUs_) {
+                maxSampleLatencyUs_ = latency;
+            }
+        }
+        log(LogLevel::Debug, "ESP-NOW broadcast queued");
+    } else if (status == RadioTransport::SendStatus::Busy) {
+        log(LogLevel::Debug, "ESP-NOW broadcast deferred, radio busy");
     } else {
-        log("ESP-NOW broadcast failed");
+        log(LogLevel::Warning, "ESP-NOW broadcast failed");
+    }
+    return status == RadioTransport::SendStatus::Queued;
+}
+
+/**
+ * @brief Broadcast the data only if the transmit policy asks for it
+ */
+bool Communication::offer(AnemometerData& data, uint32_t nowMs) {
+    TRACE_SCOPE(TraceStage::Offer);
+    if (scheduler_) {
+        drainObservations(); // Every measurement, so quiet periods do not overflow the queue
+    }
+    if (timeSync_) {
+        drainBeacons();
+        if (timeSync_->beaconDue(clock_.micros()) && engine_.ready()) {
+            sendBeacon();
+        }
+    }
+    if (control_ && controls_.size() > 0 && engine_.ready()) {
+        handleControl(); // One per measurement, with room for its reply
+    }
+    if ((data.fields ^ statusFields_) & WireFormat::FIELD_NO_SENSOR) {
+        // Sensor lost or back: the receivers hear it now, not at the next heartbeat
+        statusFields_ = data.fields & WireFormat::FIELD_NO_SENSOR;
+        policy_.requestFrame();
+    }
+    if (!engine_.ready()) {
+        // Back-pressure: leave the policy untouched, the change is offered again next time
+        return false;
+    }
+    BroadcastPolicy::Decision decision = policy_.evaluate(nowMs, data.windSpeed, data.windGust);
+    if (decision == BroadcastPolicy::Decision::Hold) {
+        return false;
+    }
+    data.sequenceNumber = sequence_++;
+    pendingSample_ = false;
+    if (data.fields & WireFormat::FIELD_TIME) {
+        uint32_t now = clock_.micros();
+        if (timeSync_ && timeSync_->synced(now)) {
+            pendingSample_ = true;
+            pendingSampleUs_ = data.timestampUs;
+            data.timestampUs = timeSync_->toReference(data.timestampUs);
+            data.timeErrorUs = timeSync_->errorUs(now);
+        } else {
+            data.fields &= ~WireFormat::FIELD_TIME; // A local time means nothing to the receivers
+        }
+    }
+    bool queued = broadcast(data);
+    pendingSample_ = false;
+    return queued;
+}
+
+/**
+ * @brief Replace the transmit policy configuration
+ */
+void Communication::setPolicy(const BroadcastPolicy::Config& config) {
+    policy_.setConfig(config);
+}
+
+/**
+ * @brief Execute the control commands received
+ */
+bool Communication::setControl(ControlChannel& control) {
+    control_ = &control;
+    bool listening = radio_.setReceiveHandler(onReceive, this);
+    if (!listening) {
+        log(LogLevel::Warning, "Control commands not heard, radio does not report received frames");
+    }
+    return listening;
+}
+
+uint32_t Communication::droppedControls() const {
+    return controls_.overruns();
+}
+
+/**
+ * @brief Hand one queued command to the control channel and broadcast its reply
+ */
+void Communication::handleControl() {
+    ReceivedControl received;
+    if (!controls_.pop(received)) {
+        return;
+    }
+    uint8_t reply[WireFormat::MAX_FRAME_SIZE];
+    size_t length = control_->handle(received.frame, received.length, reply, sizeof(reply));
+    if (length > 0 && !send(reply, length)) {
+        log(LogLevel::Debug, "Control reply not sent");
     }
-    return (result == ESP_OK);
+}
+
+/**
+ * @brief Clear the policy and delivery counters and the latencies
+ */
+void Communication::resetCounters() {
+    policy_.reset();
+    engine_.resetStatistics();
+    sampleLatencyUs_ = 0;
+    maxSampleLatencyUs_ = 0;
+}
+
+const BroadcastPolicy& Communication::policy() const {
+    return policy_;
+}
+
+/**
+ * @brief Send every frame in a TDMA slot
+ */
+bool Communication::setScheduler(SlotScheduler& scheduler) {
+    scheduler_ = &scheduler;
+    bool listening = radio_.setReceiveHandler(onReceive, this);
+    log(LogLevel::Info, "TDMA slot %u of %u%s", scheduler.slot(), SlotScheduler::SLOT_COUNT,
+        listening ? "" : ", not listening");
+    return listening;
+}
+
+/**
+ * @brief Synchronise the measurement times to a reference node
+ */
+bool Communication::setTimeSync(TimeSync& timeSync) {
+    timeSync_ = &timeSync;
+    bool listening = radio_.setReceiveHandler(onReceive, this);
+    bool reference = timeSync.role() == TimeSync::Role::Reference;
+    log(LogLevel::Info, "Time sync %s%s", reference ? "reference" : "follower",
+        listening || reference ? "" : ", not listening");
+    return listening;
+}
+
+const TimeSync* Communication::timeSync() const {
+    return timeSync_;
+}
+
+/**
+ * @brief Broadcast the next time beacon, with the departure time of the previous one
+ */
+void Communication::sendBeacon() {
+    static const uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    TimeBeacon beacon;
+    uint8_t frame[WireFormat::TIME_BEACON_SIZE];
+    uint32_t previousAirUs = 0;
+    bool previousSent = engine_.timedDoneUs(previousAirUs);
+    timeSync_->makeBeacon(beacon, clock_.micros(), previousSent, previousAirUs);
+    size_t length = WireFormat::encodeTimeBeacon(beacon, frame, sizeof(frame));
+    // Outside the TDMA slot: the departure time is measured, the slot does not matter
+    if (length == 0 || engine_.sendTimed(broadcastAddress, frame, length) != RadioTransport::SendStatus::Queued) {
+        log(LogLevel::Debug, "Time beacon not sent");
+    }
+}
+
+/**
+ * @brief Receive handler (radio driver context): queue time beacons, control commands,
+ *        and anemometer frames for the scheduler; flag summary requests
+ */
+void Communication::onReceive(void* context, const uint8_t source[RadioTransport::MAC_SIZE], const uint8_t* data,
+                              size_t length, uint32_t rxUs) {
+    Communication* self = static_cast<Communication*>(context);
+    uint8_t type = WireFormat::frameType(data, length);
+    if (type == WireFormat::MSG_TIME) {
+        ReceivedBeacon received;
+        if (self->timeSync_ && WireFormat::decodeTimeBeacon(data, length, received.beacon)) {
+            received.rxUs = rxUs;
+            self->beacons_.push(received);
+        }
+        return;
+    }
+    if (type == WireFormat::MSG_SUMMARY_REQUEST) {
+        static const uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        SummaryRequest request;
+        if (self->summaries_ && WireFormat::decodeSummaryRequest(data, length, request) &&
+            (memcmp(request.target, broadcastAddress, sizeof(broadcastAddress)) == 0 ||
+             memcmp(request.target, self->mac_, sizeof(self->mac_)) == 0)) {
+            self->summaryRequests_.fetch_add(1, std::memory_order_relaxed);
+            self->summaryRequested_.store(true, std::memory_order_relaxed);
+        }
+        return;
+    }
+    if (type == WireFormat::MSG_CONTROL) {
+        // Checked in the sending task: the tag costs more than a driver callback should take
+        ReceivedControl received;
+        if (self->control_ && length <= sizeof(received.frame)) {
+            memcpy(received.frame, data, length);
+            received.length = static_cast<uint8_t>(length);
+            self->controls_.push(received);
+        }
+        return;
+    }
+    if (type != WireFormat::MSG_ANEMOMETER || !self->scheduler_) {
+        return; // Boats do not follow the slots
+    }
+    AnemometerData decoded;
+    if (!WireFormat::decodeAnemometer(data, length, decoded)) {
+        return;
+    }
+    Observation observation;
+    memcpy(observation.mac, source, RadioTransport::MAC_SIZE);
+    observation.sequence = decoded.sequenceNumber;
+    observation.rxUs = rxUs;
+    self->observations_.push(observation);
+}
+
+/**
+ * @brief Hand the queued neighbour frames to the scheduler (sending task)
+ */
+void Communication::drainObservations() {
+    Observation observation;
+    while (observations_.pop(observation)) {
+        scheduler_->observe(observation.mac, observation.sequence, observation.rxUs);
+    }
+}
+
+/**
+ * @brief Hand the queued time beacons to the clock estimate (sending task)
+ */
+void Communication::drainBeacons() {
+    ReceivedBeacon received;
+    while (beacons_.pop(received)) {
+        timeSync_->observe(received.beacon, received.rxUs);
+    }
+}
+
+/**
+ * @brief Sleep in milliseconds, then wait the last one precisely
+ */
+void Communication::sleepUntilUs(uint32_t targetUs) {
+    int32_t remaining = static_cast<int32_t>(targetUs - clock_.micros());
+    if (remaining > 2000) {
+        // A tick-based delay may overshoot by up to one tick: stop one millisecond short
+        clock_.delayMs(static_cast<uint32_t>(remaining) / 1000 - 1);
+        remaining = static_cast<int32_t>(targetUs - clock_.micros());
+    }
+    if (remaining > 0) {
+        clock_.delayUs(static_cast<uint32_t>(remaining));
+    }
+}
+
+/**
+ * @brief Wait for the slot; after a wake-up too late for it, wait one more superframe
+ */
+void Communication::waitForSlot() {
+    uint32_t now = clock_.micros();
+    uint32_t target = now + scheduler_->delayUs(now);
+    sleepUntilUs(target);
+    now = clock_.micros();
+    if (!scheduler_->maySend(now)) {
+        scheduler_->recordMissedSlot();
+        target = now + scheduler_->delayUs(now);
+        sleepUntilUs(target);
+        now = clock_.micros();
+    }
+    scheduler_->recordSend(now, target);
+}
+
+const TransmitEngine& Communication::transmitter() const {
+    return engine_;
+}
+
+uint32_t Communication::averageSampleLatencyUs() const {
+    return sampleLatencyUs_;
+}
+
+uint32_t Communication::maxSampleLatencyUs() const {
+    return maxSampleLatencyUs_;
+}
+
+uint32_t Communication::sampleToAirUs() const {
+    return sampleLatencyUs_ + engine_.averageLatencyUs();
+}
+
+uint32_t Communication::droppedObservations() const {
+    return observations_.overruns();
 }
@@ -0,0 +1,194 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file ControlChannel.cpp
+ * @brief Authenticated ESP-NOW control commands: settings, counters, replay protection
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "ControlChannel.h"
+#include <string.h>
+
+/**
+ * @brief Construct a new ControlChannel object
+ */
+ControlChannel::ControlChannel(ControlTarget& target, SettingsStore* store)
+    : target_(target), store_(store), key_(), mac_(), keyed_(false), lastCounter_(0), groups_(0), commands_(0), rejected_(0),
+      storeErrors_(0) {
+}
+
+/**
+ * @brief Set the key and the address, restore the saved counter and settings
+ */
+bool ControlChannel::begin(const uint8_t key[WireFormat::CONTROL_KEY_SIZE], const uint8_t mac[6]) {
+    memcpy(key_, key, sizeof(key_));
+    memcpy(mac_, mac, sizeof(mac_));
+    keyed_ = true;
+    ControlRecord record;
+    if (!store_ || !store_->load(record)) {
+        return false;
+    }
+    lastCounter_.store(record.counter, std::memory_order_relaxed);
+    groups_ = record.groups & WireFormat::SET_ALL;
+    return groups_ == 0 || target_.applySettings(record.settings, groups_) == WireFormat::STATUS_OK;
+}
+
+/**
+ * @brief Save the counter, the groups changed and the settings in force
+ */
+void ControlChannel::persist() {
+    if (!store_) {
+        return;
+    }
+    ControlRecord record;
+    memset(&record, 0, sizeof(record));
+    record.counter = lastCounter_.load(std::memory_order_relaxed);
+    record.groups = groups_;
+    target_.getSettings(record.settings);
+    if (!store_->save(record)) {
+        storeErrors_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Read a fleet key written as hexadecimal
+ */
+bool ControlChannel::parseKey(const char* hex, uint8_t key[WireFormat::CONTROL_KEY_SIZE]) {
+    if (!hex || strlen(hex) != 2 * WireFormat::CONTROL_KEY_SIZE) {
+        return false;
+    }
+    uint8_t any = 0;
+    for (size_t i = 0; i < 2 * WireFormat::CONTROL_KEY_SIZE; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        key[i / 2] = (i % 2) ? (key[i / 2] | nibble) : (nibble << 4);
+        any |= nibble;
+    }
+    return any != 0; // The zero key is what an unset key looks like
+}
+
+/**
+ * @brief Check and execute one received frame
+ */
+size_t ControlChannel::handle(const uint8_t* frame, size_t length, uint8_t* reply, size_t capacity) {
+    static const uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    if (!keyed_ || WireFormat::frameType(frame, length) != WireFormat::MSG_CONTROL) {
+        return 0;
+    }
+    ControlMessage request;
+    if (!WireFormat::decodeControl(frame, length, key_, request)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return 0; // Not signed with the fleet key: no reply
+    }
+    if (memcmp(request.macAddress, broadcastAddress, sizeof(broadcastAddress)) != 0 &&
+        memcmp(request.macAddress, mac_, sizeof(mac_)) != 0) {
+        return 0;
+    }
+
+    ControlMessage answer;
+    memset(&answer, 0, sizeof(answer));
+    memcpy(answer.macAddress, mac_, sizeof(mac_));
+    answer.counter = request.counter;
+    answer.command = request.command;
+
+    uint32_t last = lastCounter_.load(std::memory_order_relaxed);
+    if (request.counter <= last) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        answer.status = WireFormat::STATUS_STALE;
+        answer.length = 4;
+        answer.payload[0] = static_cast<uint8_t>(last);
+        answer.payload[1] = static_cast<uint8_t>(last >> 8);
+        answer.payload[2] = static_cast<uint8_t>(last >> 16);
+        answer.payload[3] = static_cast<uint8_t>(last >> 24);
+        return WireFormat::encodeControl(WireFormat::MSG_CONTROL_REPLY, answer, key_, reply, capacity);
+    }
+    lastCounter_.store(request.counter, std::memory_order_relaxed);
+    commands_.fetch_add(1, std::memory_order_relaxed);
+
+    switch (request.command) {
+    case WireFormat::CMD_GET_SETTINGS: {
+        DeviceSettings settings;
+        target_.getSettings(settings);
+        answer.status = WireFormat::STATUS_OK;
+        answer.length = static_cast<uint8_t>(WireFormat::encodeSettings(settings, answer.payload, sizeof(answer.payload)));
+        break;
+    }
+    case WireFormat::CMD_SET_SETTINGS: {
+        uint8_t groups = request.length > 0 ? request.payload[0] : 0;
+        DeviceSettings settings;
+        if (request.length != 1 + WireFormat::SETTINGS_SIZE || groups == 0 || (groups & ~WireFormat::SET_ALL) ||
+            !WireFormat::decodeSettings(request.payload + 1, request.length - 1, settings)) {
+            answer.status = WireFormat::STATUS_INVALID;
+            break;
+        }
+        answer.status = target_.applySettings(settings, groups);
+        if (answer.status == WireFormat::STATUS_OK) {
+            groups_ |= groups;
+            persist();
+        }
+        target_.getSettings(settings);
+        answer.length = static_cast<uint8_t>(WireFormat::encodeSettings(settings, answer.payload, sizeof(answer.payload)));
+        break;
+    }
+    case WireFormat::CMD_GET_STATS: {
+        DeviceStats stats;
+        target_.getStats(stats);
+        stats.commands = commands();
+        stats.rejected = rejected();
+        answer.status = WireFormat::STATUS_OK;
+        answer.length = static_cast<uint8_t>(WireFormat::encodeStats(stats, answer.payload, sizeof(answer.payload)));
+        break;
+    }
+    case WireFormat::CMD_RESET_COUNTERS:
+        target_.resetCounters();
+        commands_.store(0, std::memory_order_relaxed);
+        rejected_.store(0, std::memory_order_relaxed);
+        persist(); // The counter: this command must not be played again after a power cycle
+        answer.status = WireFormat::STATUS_OK;
+        break;
+    default:
+        answer.status = WireFormat::STATUS_UNKNOWN_COMMAND;
+        break;
+    }
+    return WireFormat::encodeControl(WireFormat::MSG_CONTROL_REPLY, answer, key_, reply, capacity);
+}
+
+uint32_t ControlChannel::lastCounter() const {
+    return lastCounter_.load(std::memory_order_relaxed);
+}
+
+uint32_t ControlChannel::commands() const {
+    return commands_.load(std::memory_order_relaxed);
+}
+
+uint32_t ControlChannel::rejected() const {
+    return rejected_.load(std::memory_order_relaxed);
+}
+
+uint32_t ControlChannel::storeErrors() const {
+    return storeErrors_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,171 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file DisplayRenderer.cpp
+ * @brief Dirty-region wind screen with a scrolling sparkline
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "DisplayRenderer.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+DisplayRenderer::DisplayRenderer(DisplayDevice& display, Clock& clock)
+    : display_(display), clock_(clock), staging_(), nextStaging_(0), speedHistory_(), gustHistory_(),
+      historyHead_(0), historyCount_(0), fullRedraw_(true), frames_(0), lastFrameUs_(0), maxFrameUs_(0),
+      lastFrameBytes_(0), totalBytes_(0) {
+    speed_ = {4, 8, 4, 5, {}};
+    unit_ = {46, 44, 2, 3, {}};
+    gust_ = {2, 68, 2, 5, {}};
+    lull_ = {66, 68, 2, 5, {}};
+}
+
+/**
+ * @brief Next staging buffer as a canvas (alternates, see pushImage())
+ */
+Canvas DisplayRenderer::nextCanvas() {
+    Canvas canvas(staging_[nextStaging_], STAGING_PIXELS);
+    nextStaging_ ^= 1;
+    return canvas;
+}
+
+void DisplayRenderer::push(const Canvas& canvas) {
+    display_.pushImage(canvas.x(), canvas.y(), canvas.width(), canvas.height(), canvas.pixels());
+    lastFrameBytes_ += static_cast<uint32_t>(canvas.width()) * canvas.height() * 2;
+}
+
+/**
+ * @brief Redraw the cells of a field whose character changed
+ */
+void DisplayRenderer::updateField(TextField& field, const char* text, uint16_t color) {
+    size_t length = strlen(text);
+    int16_t cellWidth = Canvas::CHAR_WIDTH * field.scale;
+    int16_t cellHeight = Canvas::CHAR_HEIGHT * field.scale;
+    for (size_t i = 0; i < field.cells; i++) {
+        char c = i < length ? text[i] : ' ';
+        if (c == field.shown[i]) {
+            continue;
+        }
+        Canvas canvas = nextCanvas();
+        int16_t x = field.x + static_cast<int16_t>(i) * cellWidth;
+        canvas.setWindow(x, field.y, cellWidth, cellHeight);
+        canvas.drawChar(x, field.y, c, field.scale, color, COLOR_BACKGROUND);
+        push(canvas);
+        field.shown[i] = c;
+    }
+}
+
+/**
+ * @brief Draw the sparkline area (clipped to the canvas window)
+ */
+void DisplayRenderer::drawSparkline(Canvas& canvas, float scaleMax) {
+    const int16_t bottom = SCREEN_SIZE - 1;
+    canvas.fillRect(0, SPARKLINE_Y, SCREEN_SIZE, SPARKLINE_HEIGHT, COLOR_BACKGROUND);
+    canvas.fillRect(0, SPARKLINE_Y, SCREEN_SIZE, 1, COLOR_AXIS);
+    canvas.fillRect(0, SPARKLINE_Y + SPARKLINE_HEIGHT / 2, SCREEN_SIZE, 1, COLOR_AXIS);
+
+    const float pixelsPerUnit = (SPARKLINE_HEIGHT - 2) / scaleMax;
+    int16_t x = static_cast<int16_t>(SCREEN_SIZE - historyCount_);
+    for (size_t i = 0; i < historyCount_; i++, x++) {
+        size_t slot = (historyHead_ + SPARKLINE_POINTS - historyCount_ + i) % SPARKLINE_POINTS;
+        int16_t speedHeight = static_cast<int16_t>(speedHistory_[slot] * pixelsPerUnit + 0.5f);
+        canvas.fillRect(x, bottom + 1 - speedHeight, 1, speedHeight, COLOR_SPEED);
+        int16_t gustY = bottom - static_cast<int16_t>(gustHistory_[slot] * pixelsPerUnit + 0.5f);
+        canvas.fillRect(x, gustY - 1, 1, 2, COLOR_GUST);
+    }
+}
+
+void DisplayRenderer::render(float windSpeed, float windGust, float windLull) {
+    TRACE_SCOPE(TraceStage::Display);
+    uint32_t start = clock_.micros();
+    lastFrameBytes_ = 0;
+
+    if (fullRedraw_) {
+        display_.waitPush();
+        display_.fillScreen(COLOR_BACKGROUND);
+        lastFrameBytes_ += FULL_FRAME_BYTES;
+        memset(speed_.shown, 0, sizeof(speed_.shown));
+        memset(unit_.shown, 0, sizeof(unit_.shown));
+        memset(gust_.shown, 0, sizeof(gust_.shown));
+        memset(lull_.shown, 0, sizeof(lull_.shown));
+        fullRedraw_ = false;
+    }
+
+    // Text fields: fixed width, so unchanged digits stay in place and are not redrawn
+    char text[16];
+    snprintf(text, sizeof(text), "%5.1f", windSpeed < 999.9f ? windSpeed : 999.9f);
+    updateField(speed_, text, COLOR_TEXT);
+    updateField(unit_, "m/s", COLOR_TEXT);
+    snprintf(text, sizeof(text), "G%4.1f", windGust < 99.9f ? windGust : 99.9f);
+    updateField(gust_, text, COLOR_GUST);
+    snprintf(text, sizeof(text), "L%4.1f", windLull < 99.9f ? windLull : 99.9f);
+    updateField(lull_, text, COLOR_TEXT);
+
+    // Sparkline: scrolls every frame, pushed in bands of full-width rows
+    speedHistory_[historyHead_] = windSpeed > 0.0f ? windSpeed : 0.0f;
+    gustHistory_[historyHead_] = windGust > 0.0f ? windGust : 0.0f;
+    historyHead_ = (historyHead_ + 1) % SPARKLINE_POINTS;
+    if (historyCount_ < SPARKLINE_POINTS) {
+        historyCount_++;
+    }
+    float peak = 0.0f;
+    for (size_t i = 0; i < historyCount_; i++) {
+        float value = gustHistory_[i] > speedHistory_[i] ? gustHistory_[i] : speedHistory_[i];
+        peak = value > peak ? value : peak;
+    }
+    float scaleMax = 5.0f * (static_cast<int>(peak / 5.0f) + 1);   // Next multiple of 5 m/s
+    const int16_t bandRows = static_cast<int16_t>(STAGING_PIXELS / SCREEN_SIZE);
+    for (int16_t y = SPARKLINE_Y; y < SCREEN_SIZE; y += bandRows) {
+        Canvas canvas = nextCanvas();
+        canvas.setWindow(0, y, SCREEN_SIZE, SCREEN_SIZE - y < bandRows ? SCREEN_SIZE - y : bandRows);
+        drawSparkline(canvas, scaleMax);
+        push(canvas);
+    }
+
+    display_.waitPush();
+    lastFrameUs_ = clock_.micros() - start;
+    if (lastFrameUs_ > maxFrameUs_) {
+        maxFrameUs_ = lastFrameUs_;
+    }
+    totalBytes_ += lastFrameBytes_;
+    frames_++;
+}
+
+void DisplayRenderer::invalidate() {
+    fullRedraw_ = true;
+}
+
+uint32_t DisplayRenderer::frames() const {
+    return frames_;
+}
+
+uint32_t DisplayRenderer::lastFrameUs() const {
+    return lastFrameUs_;
+}
+
+uint32_t DisplayRenderer::maxFrameUs() const {
+    return maxFrameUs_;
+}
+
+uint32_t DisplayRenderer::lastFrameBytes() const {
+    return lastFrameBytes_;
+}
+
+uint32_t DisplayRenderer::averageFrameBytes() const {
+    return frames_ ? totalBytes_ / frames_ : 0;
+}
@@ -0,0 +1,117 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FakeAdcSource.cpp
+ * @brief Synthetic ADC source used off-device
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The simulated converter does not depend on Arduino, so it builds on a Linux host
+ * and feeds the same AdcSampler/ring buffer code as the ADS1115 backend.
+ */
+
+#include "FakeAdcSource.h"
+#include <math.h>
+
+/**
+ * @brief Construct a new FakeAdcSource object
+ */
+FakeAdcSource::FakeAdcSource(float millivoltsPerCode)
+    : sampleRate_(8), millivoltsPerCode_(millivoltsPerCode), continuous_(false), offset_(0), amplitude_(0),
+      periodSeconds_(10.0f), noise_(0), seed_(1), sequence_(nullptr), sequenceLength_(0), index_(0) {}
+
+/**
+ * @brief Configure the synthetic signal
+ */
+void FakeAdcSource::setSignal(int16_t offset, int16_t amplitude, float periodSeconds, int16_t noise, uint32_t seed) {
+    offset_ = offset;
+    amplitude_ = amplitude;
+    periodSeconds_ = periodSeconds > 0.0f ? periodSeconds : 1.0f;
+    noise_ = noise;
+    seed_ = seed ? seed : 1;
+}
+
+/**
+ * @brief Replay a fixed sequence of codes
+ */
+void FakeAdcSource::setSequence(const int16_t* codes, size_t length) {
+    sequence_ = length ? codes : nullptr;
+    sequenceLength_ = length;
+}
+
+bool FakeAdcSource::begin() {
+    index_ = 0;
+    return true;
+}
+
+bool FakeAdcSource::startSingleShot(uint16_t samplesPerSecond) {
+    sampleRate_ = samplesPerSecond ? samplesPerSecond : 8;
+    continuous_ = false;
+    return true;
+}
+
+bool FakeAdcSource::startContinuous(uint16_t samplesPerSecond) {
+    sampleRate_ = samplesPerSecond ? samplesPerSecond : 8;
+    continuous_ = true;
+    return true;
+}
+
+int16_t FakeAdcSource::readSingle() {
+    return nextCode();
+}
+
+bool FakeAdcSource::readConversion(int16_t& code) {
+    if (!continuous_) {
+        return false;
+    }
+    code = nextCode();
+    return true;
+}
+
+uint16_t FakeAdcSource::sampleRate() const {
+    return sampleRate_;
+}
+
+float FakeAdcSource::millivoltsPerCode() const {
+    return millivoltsPerCode_;
+}
+
+uint32_t FakeAdcSource::conversions() const {
+    return index_;
+}
+
+/**
+ * @brief Produce the next simulated conversion
+ */
+int16_t FakeAdcSource::nextCode() {
+    uint32_t n = index_++;
+    if (sequence_) {
+        return sequence_[n % sequenceLength_];
+    }
+
+    float t = static_cast<float>(n) / sampleRate_;
+    int32_t code = offset_ + static_cast<int32_t>(amplitude_ * sinf(6.2831853f * t / periodSeconds_));
+    if (noise_ > 0) {
+        // xorshift32, cheap and reproducible
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        code += static_cast<int32_t>(seed_ % (2U * noise_ + 1U)) - noise_;
+    }
+    if (code > 32767) code = 32767;
+    if (code < -32768) code = -32768;
+    return static_cast<int16_t>(code);
+}
@@ -0,0 +1,217 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FleetReceiver.cpp
+ * @brief Reference receiver: per-sender loss, reordering, timeouts and measurement age
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "FleetReceiver.h"
+#include <string.h>
+
+FleetReceiver::FleetReceiver(uint32_t timeoutUs)
+    : timeoutUs_(timeoutUs), timeSync_(), senders_(), windows_(), senderCount_(0), frames_(0), beacons_(0),
+      malformed_(0), others_(0), untracked_(0), timeouts_(0) {
+}
+
+void FleetReceiver::begin(const uint8_t mac[6]) {
+    timeSync_.begin(mac, TimeSync::Role::Follower);
+    senderCount_ = 0;
+    frames_ = 0;
+    beacons_ = 0;
+    malformed_ = 0;
+    others_ = 0;
+    untracked_ = 0;
+    timeouts_ = 0;
+}
+
+/**
+ * @brief Look a sender up, adding it if asked and there is room
+ */
+SenderState* FleetReceiver::find(const uint8_t mac[6], bool create) {
+    for (size_t i = 0; i < senderCount_; i++) {
+        if (memcmp(senders_[i].mac, mac, 6) == 0) {
+            return &senders_[i];
+        }
+    }
+    if (!create || senderCount_ == MAX_SENDERS) {
+        return nullptr;
+    }
+    SenderState& sender = senders_[senderCount_];
+    memset(&sender, 0, sizeof(sender));
+    memcpy(sender.mac, mac, 6);
+    windows_[senderCount_] = 0;
+    senderCount_++;
+    return &sender;
+}
+
+/**
+ * @brief File one sequence number: gap, late frame, duplicate or reboot
+ * @return true if the frame is the sender's newest
+ */
+bool FleetReceiver::account(SenderState& sender, uint32_t& window, uint16_t sequence) {
+    int16_t delta = WireFormat::sequenceDelta(sequence, sender.lastSequence);
+    bool first = sender.received == 0;
+    if (first || delta > MAX_SEQUENCE_GAP || delta < -MAX_SEQUENCE_GAP) {
+        if (!first) {
+            sender.restarts++; // Rebooted: start over from this frame
+        }
+        sender.lastSequence = sequence;
+        window = 1;
+        sender.received++;
+        return true;
+    }
+    if (delta > 0) {
+        sender.lost += static_cast<uint32_t>(delta - 1);
+        window = static_cast<size_t>(delta) < SEQUENCE_WINDOW ? (window << delta) | 1 : 1;
+        sender.lastSequence = sequence;
+        sender.received++;
+        return true;
+    }
+    size_t behind = static_cast<size_t>(-delta);
+    if (behind < SEQUENCE_WINDOW && (window & (1UL << behind))) {
+        sender.duplicates++;
+        return false;
+    }
+    if (behind < SEQUENCE_WINDOW) {
+        window |= 1UL << behind;
+    }
+    // Counted lost when the gap appeared (too late to tell beyond the window)
+    sender.reordered++;
+    if (sender.lost > 0) {
+        sender.lost--;
+    }
+    sender.received++;
+    return false;
+}
+
+bool FleetReceiver::receive(const uint8_t* frame, size_t length, uint32_t rxUs) {
+    uint8_t type = WireFormat::frameType(frame, length);
+    if (type == WireFormat::MSG_TIME) {
+        TimeBeacon beacon;
+        if (!WireFormat::decodeTimeBeacon(frame, length, beacon)) {
+            malformed_++;
+            return false;
+        }
+        beacons_++;
+        timeSync_.observe(beacon, rxUs);
+        return false;
+    }
+    if (type != WireFormat::MSG_ANEMOMETER) {
+        others_++;
+        return false;
+    }
+    AnemometerData data;
+    if (!WireFormat::decodeAnemometer(frame, length, data)) {
+        malformed_++;
+        return false;
+    }
+    frames_++;
+    SenderState* sender = find(data.macAddress, true);
+    if (!sender) {
+        untracked_++;
+        return true;
+    }
+    if (sender->received > 0 && rxUs - sender->lastRxUs > sender->maxGapUs) {
+        sender->maxGapUs = rxUs - sender->lastRxUs;
+    }
+    bool newest = account(*sender, windows_[sender - senders_], data.sequenceNumber);
+    sender->lastRxUs = rxUs;
+    sender->online = true;
+    if (!newest) {
+        return true; // Late or repeated: the newest measurement stays
+    }
+    sender->latest = data;
+    if ((data.fields & WireFormat::FIELD_TIME) && timeSync_.synced(rxUs)) {
+        sender->ageUs = timeSync_.toReference(rxUs) - data.timestampUs;
+        if (sender->ageUs > sender->maxAgeUs) {
+            sender->maxAgeUs = sender->ageUs;
+        }
+        sender->ageSumUs += sender->ageUs;
+        sender->ages++;
+    }
+    return true;
+}
+
+size_t FleetReceiver::poll(uint32_t nowUs) {
+    size_t wentOffline = 0;
+    for (size_t i = 0; i < senderCount_; i++) {
+        SenderState& sender = senders_[i];
+        if (sender.online && nowUs - sender.lastRxUs >= timeoutUs_) {
+            sender.online = false;
+            sender.timeouts++;
+            timeouts_++;
+            wentOffline++;
+        }
+    }
+    return wentOffline;
+}
+
+size_t FleetReceiver::senderCount() const {
+    return senderCount_;
+}
+
+const SenderState& FleetReceiver::sender(size_t index) const {
+    return senders_[index];
+}
+
+int FleetReceiver::indexOf(const uint8_t mac[6]) const {
+    for (size_t i = 0; i < senderCount_; i++) {
+        if (memcmp(senders_[i].mac, mac, 6) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+size_t FleetReceiver::online() const {
+    size_t count = 0;
+    for (size_t i = 0; i < senderCount_; i++) {
+        if (senders_[i].online) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t FleetReceiver::frames() const {
+    return frames_;
+}
+
+uint32_t FleetReceiver::beacons() const {
+    return beacons_;
+}
+
+uint32_t FleetReceiver::malformed() const {
+    return malformed_;
+}
+
+uint32_t FleetReceiver::others() const {
+    return others_;
+}
+
+uint32_t FleetReceiver::untracked() const {
+    return untracked_;
+}
+
+uint32_t FleetReceiver::timeouts() const {
+    return timeouts_;
+}
+
+const TimeSync& FleetReceiver::timeSync() const {
+    return timeSync_;
+}
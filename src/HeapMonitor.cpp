@@ -0,0 +1,84 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HeapMonitor.cpp
+ * @brief Heap allocation counters
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "HeapMonitor.h"
+#include <atomic>
+
+// Constant-initialised: the hooks may run before any static constructor
+static std::atomic<uint32_t> allocations_(0);
+static std::atomic<uint32_t> frees_(0);
+static std::atomic<uint32_t> steadyAllocations_(0);
+static std::atomic<uint32_t> steadyBytes_(0);
+static std::atomic<uint32_t> firstSteadySize_(0);
+static std::atomic<bool> steady_(false);
+
+void HeapMonitor::recordAllocation(size_t size) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    if (steady_.load(std::memory_order_relaxed)) {
+        if (steadyAllocations_.fetch_add(1, std::memory_order_relaxed) == 0) {
+            firstSteadySize_.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+        }
+        steadyBytes_.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    }
+}
+
+void HeapMonitor::recordFree() {
+    frees_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HeapMonitor::markSteadyState() {
+    steadyAllocations_.store(0, std::memory_order_relaxed);
+    steadyBytes_.store(0, std::memory_order_relaxed);
+    firstSteadySize_.store(0, std::memory_order_relaxed);
+    steady_.store(true, std::memory_order_relaxed);
+}
+
+bool HeapMonitor::steady() {
+    return steady_.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::allocations() {
+    return allocations_.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::frees() {
+    return frees_.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::steadyAllocations() {
+    return steadyAllocations_.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::steadyBytes() {
+    return steadyBytes_.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::firstSteadySize() {
+    return firstSteadySize_.load(std::memory_order_relaxed);
+}
+
+float HeapMonitor::fragmentation(const HeapInfo& info) {
+    if (info.freeBytes == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(info.largestFreeBlock) / info.freeBytes;
+}
@@ -23,75 +23,245 @@
  * @param enable True to enable screen logging, false to disable
  */
 #include "Logger.h"
+#include <stdio.h>
+#include <string.h>
 
 /**
  * @brief Logger constructor
  * Initializes logging channels and screen if enabled.
  */
-Logger::Logger(bool enableSDLogging, bool serialLogging, bool screenLogging) {
-    this->sdLogging = enableSDLogging;
+Logger::Logger(Console* console, DisplayDevice* display, bool serialLogging, bool screenLogging)
+    : task_("logger", 4096, TASK_PRIORITY), async_(false), droppedReported_(0) {
+    for (size_t i = 0; i < LOG_MODULE_COUNT; i++) {
+        levels_[i].store(static_cast<uint8_t>(LogLevel::Info), std::memory_order_relaxed);
+    }
+    this->console_ = console;
+    this->display_ = display;
     this->serialLogging = serialLogging;
     this->screenLogging = screenLogging;
     this->screenLine = 0;
 
     // Initialize screen if screen logging is enabled
-    if (this->screenLogging) {
-        M5.Display.fillScreen(WHITE);
-        M5.Display.setTextColor(BLACK);
-        M5.Display.setTextSize(2);
-        M5.Display.setCursor(0, 0);
+    if (this->screenLogging && display_) {
+        display_->fillScreen(DisplayDevice::COLOR_WHITE);
+        display_->setTextColor(DisplayDevice::COLOR_BLACK);
+        display_->setTextSize(2);
+        display_->setCursor(0, 0);
     }
 
     // Initialize serial if serial logging is enabled
-    if (this->serialLogging) {
-        Serial.begin(115200);
-        while (!Serial); // Wait for Serial to be ready
-    }
-
-    // TODO: Initialize SD card if SD logging is enabled
-    if (this->sdLogging) {
-        // SD card initialization code here
+    if (this->serialLogging && console_) {
+        console_->begin(115200);
     }
 }
 
 /**
- * @brief Log a message to enabled outputs (serial, screen, SD card)
+ * @brief Log a message to enabled outputs (serial, screen)
  * @param message The message to log
  */
-void Logger::log(const String& message) {
+void Logger::log(const char* message) {
+    emit(message);
+}
+
+/**
+ * @brief Write a message to enabled outputs (caller task or logger task)
+ */
+void Logger::emit(const char* message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
     // Serial logging
-    if (serialLogging) {
-        Serial.println(message);
+    if (serialLogging && console_) {
+        console_->println(message);
     }
 
     // Screen logging
-    if (screenLogging) {
+    if (screenLogging && display_) {
         if (screenLine >= MAX_LINES) {
-            M5.Display.fillScreen(WHITE);
+            display_->fillScreen(DisplayDevice::COLOR_WHITE);
             screenLine = 0;
         }
-        M5.Display.setCursor(0, screenLine * LINE_HEIGHT);
-        M5.Display.println(message);
+        display_->setCursor(0, screenLine * LINE_HEIGHT);
+        display_->println(message);
         screenLine++;
     }
+}
 
-    // SD logging
-    if (sdLogging) {
-        // TODO: Implement SD card logging
-        // File file = SD.open("/log.txt", FILE_APPEND);
-        // if (file) {
-        //     file.println(message);
-        //     file.close();
-        // }
+/**
+ * @brief Queue a deferred record, or format and emit it now in synchronous mode
+ */
+void Logger::submit(const LogRecord& record) {
+    if (async_.load(std::memory_order_acquire)) {
+        // A full ring drops the record (counted); wake the task early when half full
+        if (queue_.push(record) && queue_.size() >= QUEUE_SIZE / 2) {
+            task_.notify();
+        }
+        return;
     }
+    char message[MAX_MESSAGE];
+    format(record, message, sizeof(message));
+    emit(message);
 }
 
 /**
- * @brief Enable or disable SD card logging
- * @param enable True to enable, false to disable
+ * @brief Format and emit the queued records (logger task)
+ */
+void Logger::drain() {
+    LogRecord record;
+    char message[MAX_MESSAGE];
+    while (queue_.pop(record)) {
+        format(record, message, sizeof(message));
+        emit(message);
+    }
+    uint32_t dropped = queue_.dropped();
+    if (dropped != droppedReported_) {
+        snprintf(message, sizeof(message), "Logger: %lu messages dropped",
+                 static_cast<unsigned long>(dropped - droppedReported_));
+        droppedReported_ = dropped;
+        emit(message);
+    }
+}
+
+/**
+ * @brief Logger task: wakes periodically, or early when the queue fills up
+ */
+void Logger::drainTask(void* arg) {
+    Logger* self = static_cast<Logger*>(arg);
+    while (self->async_.load()) {
+        self->task_.wait(DRAIN_PERIOD_MS);
+        self->drain();
+    }
+    self->drain();
+}
+
+bool Logger::startAsync() {
+    if (async_.load()) {
+        return true;
+    }
+    async_.store(true);
+    if (!task_.start(drainTask, this)) {
+        async_.store(false);
+        return false;
+    }
+    return true;
+}
+
+void Logger::stopAsync() {
+    async_.store(false);
+    task_.notify();
+    task_.join();
+}
+
+void Logger::setLevel(LogModule module, LogLevel level) {
+    levels_[static_cast<size_t>(module)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+uint32_t Logger::dropped() const {
+    return queue_.dropped();
+}
+
+/**
+ * @brief Expand a record's format with its captured arguments
+ *
+ * Each conversion is rebuilt with the length modifier matching the stored width
+ * (long long for integers, double for floats), so the caller's argument types do
+ * not have to match the format exactly. Missing arguments print as '?'.
  */
-void Logger::enableSDLogging(bool enable) {
-    sdLogging = enable;
+size_t Logger::format(const LogRecord& record, char* out, size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    size_t length = 0;
+    size_t argIndex = 0;
+    const char* p = record.format;
+
+    while (*p && length + 1 < capacity) {
+        if (*p != '%') {
+            out[length++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[length++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision, skip the length modifiers
+        char spec[16];
+        size_t specLength = 0;
+        spec[specLength++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && specLength < sizeof(spec) - 4) {
+            spec[specLength++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0') {
+            break;
+        }
+        p++;
+
+        int written;
+        char* dest = out + length;
+        size_t room = capacity - length;
+        if (argIndex >= record.argCount) {
+            written = snprintf(dest, room, "?");
+        } else {
+            const LogArg& arg = record.args[argIndex++];
+            switch (conversion) {
+            case 'd':
+            case 'i':
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(dest, room, spec, static_cast<long long>(arg.i));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(dest, room, spec, static_cast<unsigned long long>(arg.u));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(dest, room, spec, arg.d);
+                break;
+            case 'c':
+                spec[specLength++] = 'c';
+                spec[specLength] = '\0';
+                written = snprintf(dest, room, spec, static_cast<int>(arg.i));
+                break;
+            case 's':
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                written = snprintf(dest, room, spec, arg.s ? arg.s : "(null)");
+                break;
+            case 'p':
+                written = snprintf(dest, room, "%p", arg.p);
+                break;
+            default:
+                written = snprintf(dest, room, "?");
+                break;
+            }
+        }
+        if (written < 0) {
+            break;
+        }
+        length += static_cast<size_t>(written) < room ? static_cast<size_t>(written) : room - 1;
+    }
+    out[length] = '\0';
+    return length;
 }
 
 /**
@@ -0,0 +1,138 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Pipeline.cpp
+ * @brief Producer task and output stages connected by SPSC queues
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Task layout on the ESP32-S3 (see main.cpp):
+ * - Core 1: ADC reader task and the measurement producer (Anemometer::update())
+ * - Core 0: display, logging and ESP-NOW stages, next to the WiFi driver
+ *
+ * Hand-off is wait-free: the producer pushes into each stage queue and notifies the
+ * stage task; if a queue is full the measurement is dropped for that stage only.
+ */
+
+#include "Pipeline.h"
+#include "Trace.h"
+
+/**
+ * @brief Construct a new PipelineStage object
+ */
+PipelineStage::PipelineStage(const char* name, MeasurementSink& sink, uint8_t priority, int core, uint32_t stackSize)
+    : name_(name), sink_(sink), queue_(), task_(name, stackSize, priority, core), running_(false), processed_(0),
+      maxServiceMs_(0) {}
+
+bool PipelineStage::start() {
+    running_.store(true);
+    return task_.start(run, this);
+}
+
+void PipelineStage::stop() {
+    running_.store(false);
+    task_.notify();
+    task_.join();
+}
+
+bool PipelineStage::offer(const Measurement& measurement) {
+    if (!queue_.push(measurement)) {
+        return false;
+    }
+    task_.notify();
+    return true;
+}
+
+/**
+ * @brief Stage task: drain the queue on every notification
+ */
+void PipelineStage::run(void* arg) {
+    PipelineStage* self = static_cast<PipelineStage*>(arg);
+    Measurement measurement;
+    for (;;) {
+        self->task_.wait(1000);
+        while (self->queue_.pop(measurement)) {
+            uint32_t start = RtosTask::nowMs();
+            self->sink_.consume(measurement);
+            uint32_t elapsed = RtosTask::nowMs() - start;
+            if (elapsed > self->maxServiceMs_.load(std::memory_order_relaxed)) {
+                self->maxServiceMs_.store(elapsed, std::memory_order_relaxed);
+            }
+            self->processed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!self->running_.load()) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Construct a new Pipeline object
+ */
+Pipeline::Pipeline(MeasurementProducer& producer, uint32_t periodMs, uint8_t priority, int core)
+    : producer_(producer), periodMs_(periodMs), stages_(), stageCount_(0), task_("producer", 4096, priority, core),
+      running_(false), produced_(0), lateWakeups_(0) {}
+
+bool Pipeline::addStage(PipelineStage& stage) {
+    if (stageCount_ >= MAX_STAGES) {
+        return false;
+    }
+    stages_[stageCount_++] = &stage;
+    return true;
+}
+
+bool Pipeline::start() {
+    for (size_t i = 0; i < stageCount_; i++) {
+        if (!stages_[i]->start()) {
+            return false;
+        }
+    }
+    running_.store(true);
+    return task_.start(run, this);
+}
+
+void Pipeline::stop() {
+    running_.store(false);
+    task_.join();
+    for (size_t i = 0; i < stageCount_; i++) {
+        stages_[i]->stop();
+    }
+}
+
+/**
+ * @brief Producer task: one measurement per period, offered to every stage
+ */
+void Pipeline::run(void* arg) {
+    Pipeline* self = static_cast<Pipeline*>(arg);
+    uint32_t lastWake = RtosTask::nowMs();
+    while (self->running_.load()) {
+        RtosTask::sleepUntil(lastWake, self->periodMs_);
+        TRACE_TICK(self->periodMs_ * 1000);
+
+        Measurement measurement = {};
+        if (!self->producer_.produce(measurement)) {
+            continue;
+        }
+        measurement.sequenceNumber = self->produced_.fetch_add(1, std::memory_order_relaxed);
+        measurement.timestampMs = RtosTask::nowMs();
+        if (measurement.timestampMs - lastWake > self->periodMs_) {
+            self->lateWakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < self->stageCount_; i++) {
+            self->stages_[i]->offer(measurement);
+        }
+    }
+}
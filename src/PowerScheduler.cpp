@@ -0,0 +1,268 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file PowerScheduler.cpp
+ * @brief Deadline scheduler with light sleep between tasks and a charge ledger
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "PowerScheduler.h"
+#include <string.h>
+
+const PowerScheduler::Config PowerScheduler::DEFAULT_CONFIG = {3000, 28.0f, 2.5f};
+
+PowerScheduler::PowerScheduler(Clock& clock, PowerControl& power, const Config& config)
+    : clock_(clock), power_(power), config_(config), tasks_(), taskCount_(0), started_(false), markUs_(0), leadUs_(0),
+      maxWakeDelayUs_(0), elapsedUs_(0), idleUs_(0), sleepUs_(0), lightSleeps_(0), alertWakes_(0) {
+}
+
+bool PowerScheduler::add(const char* name, PowerTask& task, uint32_t periodUs, float activeMilliamps,
+                         bool wakeOnAlert) {
+    if (taskCount_ >= MAX_TASKS || (periodUs == 0 && !wakeOnAlert)) {
+        return false;
+    }
+    Entry& entry = tasks_[taskCount_++];
+    entry.task = &task;
+    entry.periodUs = periodUs;
+    entry.deadlineUs = 0;
+    entry.wakeOnAlert = wakeOnAlert;
+    memset(&entry.ledger, 0, sizeof(entry.ledger));
+    entry.ledger.name = name;
+    entry.ledger.activeMilliamps = activeMilliamps;
+    return true;
+}
+
+void PowerScheduler::start() {
+    uint32_t now = clock_.micros();
+    for (size_t i = 0; i < taskCount_; i++) {
+        Entry& entry = tasks_[i];
+        entry.deadlineUs = now;
+        const char* name = entry.ledger.name;
+        float milliamps = entry.ledger.activeMilliamps;
+        memset(&entry.ledger, 0, sizeof(entry.ledger));
+        entry.ledger.name = name;
+        entry.ledger.activeMilliamps = milliamps;
+    }
+    markUs_ = now;
+    leadUs_ = 0;
+    maxWakeDelayUs_ = 0;
+    elapsedUs_ = 0;
+    idleUs_ = 0;
+    sleepUs_ = 0;
+    lightSleeps_ = 0;
+    alertWakes_ = 0;
+    started_ = true;
+}
+
+/**
+ * @brief Close the current accounting interval
+ * @return Its length (us)
+ */
+uint32_t PowerScheduler::account() {
+    uint32_t now = clock_.micros();
+    uint32_t length = now - markUs_;
+    markUs_ = now;
+    elapsedUs_ += length;
+    return length;
+}
+
+/**
+ * @brief Run one task and move its deadline, skipping the periods already over
+ */
+void PowerScheduler::runTask(Entry& entry, bool alert) {
+    idleUs_ += account();
+    uint32_t start = markUs_;
+    PowerLedger& ledger = entry.ledger;
+    if (alert) {
+        ledger.alertRuns++;
+    } else {
+        uint32_t lateness = start - entry.deadlineUs;
+        if (lateness > ledger.maxLatenessUs) {
+            ledger.maxLatenessUs = lateness;
+        }
+    }
+    ledger.runs++;
+    entry.task->run();
+    ledger.activeUs += account();
+
+    if (entry.periodUs == 0) {
+        return;
+    }
+    // An ALERT run restarts the period: the deadline is then only a timeout
+    entry.deadlineUs = (alert ? start : entry.deadlineUs) + entry.periodUs;
+    while (static_cast<int32_t>(markUs_ - entry.deadlineUs) >= 0) {
+        entry.deadlineUs += entry.periodUs;
+        ledger.missed++;
+    }
+}
+
+bool PowerScheduler::anyBusy() const {
+    for (size_t i = 0; i < taskCount_; i++) {
+        if (tasks_[i].task->busy()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Earliest deadline of the periodic tasks
+ * @return false if no task is periodic
+ */
+bool PowerScheduler::nextDeadline(uint32_t nowUs, uint32_t& deadlineUs) const {
+    bool found = false;
+    int32_t earliest = 0;
+    for (size_t i = 0; i < taskCount_; i++) {
+        if (tasks_[i].periodUs == 0) {
+            continue;
+        }
+        int32_t remaining = static_cast<int32_t>(tasks_[i].deadlineUs - nowUs);
+        if (!found || remaining < earliest) {
+            earliest = remaining;
+            found = true;
+        }
+    }
+    deadlineUs = nowUs + earliest;
+    return found;
+}
+
+void PowerScheduler::runAlertTasks() {
+    alertWakes_++;
+    for (size_t i = 0; i < taskCount_; i++) {
+        if (tasks_[i].wakeOnAlert) {
+            runTask(tasks_[i], true);
+        }
+    }
+}
+
+void PowerScheduler::step() {
+    if (!started_) {
+        start();
+    }
+    for (size_t i = 0; i < taskCount_; i++) {
+        Entry& entry = tasks_[i];
+        if (entry.periodUs != 0 && static_cast<int32_t>(clock_.micros() - entry.deadlineUs) >= 0) {
+            runTask(entry, false);
+        }
+    }
+
+    uint32_t now = clock_.micros();
+    uint32_t deadline;
+    if (!nextDeadline(now, deadline)) {
+        deadline = now + MAX_SLEEP_US;
+    }
+    int32_t gap = static_cast<int32_t>(deadline - now);
+    if (gap <= 0) {
+        return;
+    }
+    if (static_cast<uint32_t>(gap) > MAX_SLEEP_US) {
+        gap = MAX_SLEEP_US;
+        deadline = now + MAX_SLEEP_US;
+    }
+    idleUs_ += account();
+
+    if (!anyBusy() && static_cast<uint32_t>(gap) >= config_.lightSleepMinUs && static_cast<uint32_t>(gap) > leadUs_) {
+        uint32_t requestUs = gap - leadUs_;
+        PowerControl::WakeSource source = power_.sleep(PowerControl::SleepMode::Light, requestUs);
+        uint32_t slept = account();
+        sleepUs_ += slept;
+        lightSleeps_++;
+        if (source == PowerControl::WakeSource::Alert) {
+            runAlertTasks();
+            return;
+        }
+        if (source == PowerControl::WakeSource::Timer) {
+            // Wake-up delay: its running average (1/8 weight) is taken off the next sleeps
+            uint32_t delay = slept > requestUs ? slept - requestUs : 0;
+            if (delay > maxWakeDelayUs_) {
+                maxWakeDelayUs_ = delay;
+            }
+            leadUs_ += (static_cast<int32_t>(delay) - static_cast<int32_t>(leadUs_)) / 8;
+        }
+        // Early: finish the wait awake, for an accurate deadline
+        int32_t remaining = static_cast<int32_t>(deadline - clock_.micros());
+        if (remaining > 0) {
+            power_.sleep(PowerControl::SleepMode::Idle, remaining);
+            idleUs_ += account();
+        }
+        return;
+    }
+
+    // Short gap, or work in progress that light sleep would stall: stay awake
+    uint32_t idle = anyBusy() && static_cast<uint32_t>(gap) > BUSY_POLL_US ? BUSY_POLL_US : gap;
+    PowerControl::WakeSource source = power_.sleep(PowerControl::SleepMode::Idle, idle);
+    idleUs_ += account();
+    if (source == PowerControl::WakeSource::Alert) {
+        runAlertTasks();
+    }
+}
+
+size_t PowerScheduler::taskCount() const {
+    return taskCount_;
+}
+
+const PowerLedger& PowerScheduler::ledger(size_t index) const {
+    return tasks_[index].ledger;
+}
+
+uint64_t PowerScheduler::elapsedUs() const {
+    return elapsedUs_;
+}
+
+uint64_t PowerScheduler::idleUs() const {
+    return idleUs_;
+}
+
+uint64_t PowerScheduler::sleepUs() const {
+    return sleepUs_;
+}
+
+float PowerScheduler::sleepRatio() const {
+    return elapsedUs_ ? static_cast<float>(sleepUs_) / elapsedUs_ : 0.0f;
+}
+
+uint32_t PowerScheduler::lightSleeps() const {
+    return lightSleeps_;
+}
+
+uint32_t PowerScheduler::alertWakes() const {
+    return alertWakes_;
+}
+
+uint32_t PowerScheduler::leadUs() const {
+    return leadUs_;
+}
+
+uint32_t PowerScheduler::maxWakeDelayUs() const {
+    return maxWakeDelayUs_;
+}
+
+float PowerScheduler::averageMilliamps() const {
+    if (!elapsedUs_) {
+        return 0.0f;
+    }
+    return chargeMilliampHours() * 3.6e9f / elapsedUs_;
+}
+
+float PowerScheduler::chargeMilliampHours() const {
+    double charge = idleUs_ * static_cast<double>(config_.idleMilliamps) +
+                    sleepUs_ * static_cast<double>(config_.sleepMilliamps); // mA.us
+    for (size_t i = 0; i < taskCount_; i++) {
+        charge += tasks_[i].ledger.activeUs * static_cast<double>(tasks_[i].ledger.activeMilliamps);
+    }
+    return static_cast<float>(charge / 3.6e9);
+}
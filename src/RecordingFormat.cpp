@@ -0,0 +1,143 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file RecordingFormat.cpp
+ * @brief Sector layout of binary sample recordings
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "RecordingFormat.h"
+#include "ByteOrder.h"
+#include <string.h>
+
+namespace RecordingFormat {
+
+using namespace ByteOrder;
+
+static const char FILE_MAGIC[8] = {'O', 'S', 'R', 'C', 'R', 'E', 'C', '\0'};
+static const uint32_t SECTOR_MAGIC = 0x4452534F; // "OSRD"
+static const size_t HEADER_CRC_OFFSET = SECTOR_SIZE - 4;
+static const size_t SECTOR_CRC_OFFSET = 12;
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    // Nibble table: 64 bytes of flash, about 2x slower than a byte table
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = TABLE[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+void encodeFileHeader(const FileInfo& info, uint8_t sector[SECTOR_SIZE]) {
+    memset(sector, 0, SECTOR_SIZE);
+    memcpy(sector, FILE_MAGIC, sizeof(FILE_MAGIC));
+    put16(sector + 8, VERSION);
+    put16(sector + 10, SECTOR_SIZE);
+    put16(sector + 12, RECORD_SIZE);
+    put16(sector + 14, info.sampleRate);
+    put32(sector + 16, info.session);
+    put32(sector + 20, info.part);
+    put32(sector + 24, info.startMs);
+    memcpy(sector + 28, info.macAddress, 6);
+    putFloat(sector + 36, info.millivoltsPerCode);
+    size_t points = info.curve.size <= CalibrationCurve::MAX_POINTS ? info.curve.size : 0;
+    sector[40] = static_cast<uint8_t>(points);
+    for (size_t i = 0; i < points; i++) {
+        putFloat(sector + 44 + 4 * i, info.curve.millivolts[i]);
+        putFloat(sector + 108 + 4 * i, info.curve.kmh[i]);
+    }
+    put32(sector + HEADER_CRC_OFFSET, crc32(sector, HEADER_CRC_OFFSET));
+}
+
+bool decodeFileHeader(const uint8_t sector[SECTOR_SIZE], FileInfo& info) {
+    if (memcmp(sector, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || get16(sector + 8) != VERSION ||
+        get32(sector + HEADER_CRC_OFFSET) != crc32(sector, HEADER_CRC_OFFSET)) {
+        return false;
+    }
+    memset(&info, 0, sizeof(info));
+    info.sampleRate = get16(sector + 14);
+    info.session = get32(sector + 16);
+    info.part = get32(sector + 20);
+    info.startMs = get32(sector + 24);
+    memcpy(info.macAddress, sector + 28, 6);
+    info.millivoltsPerCode = getFloat(sector + 36);
+    info.curve.size = sector[40] <= CalibrationCurve::MAX_POINTS ? sector[40] : 0;
+    for (size_t i = 0; i < info.curve.size; i++) {
+        info.curve.millivolts[i] = getFloat(sector + 44 + 4 * i);
+        info.curve.kmh[i] = getFloat(sector + 108 + 4 * i);
+    }
+    return true;
+}
+
+void putRecord(uint8_t sector[SECTOR_SIZE], size_t index, const SampleRecord& record) {
+    uint8_t* p = sector + SECTOR_HEADER_SIZE + index * RECORD_SIZE;
+    put32(p, record.timestampMs);
+    put16(p + 4, static_cast<uint16_t>(record.code));
+    put16(p + 6, record.windSpeedCmS);
+}
+
+SampleRecord getRecord(const uint8_t sector[SECTOR_SIZE], size_t index) {
+    const uint8_t* p = sector + SECTOR_HEADER_SIZE + index * RECORD_SIZE;
+    SampleRecord record;
+    record.timestampMs = get32(p);
+    record.code = static_cast<int16_t>(get16(p + 4));
+    record.windSpeedCmS = get16(p + 6);
+    return record;
+}
+
+void setSectorCounts(uint8_t sector[SECTOR_SIZE], uint16_t count, uint16_t dropped) {
+    put16(sector + 8, count);
+    put16(sector + 10, dropped);
+}
+
+/**
+ * @brief CRC of a data sector, CRC field read as zero, seeded with the session
+ */
+static uint32_t sectorCrc(const uint8_t sector[SECTOR_SIZE], uint32_t session) {
+    static const uint8_t ZERO[4] = {0, 0, 0, 0};
+    uint8_t seed[4];
+    put32(seed, session);
+    uint32_t crc = crc32(seed, sizeof(seed));
+    crc = crc32(sector, SECTOR_CRC_OFFSET, crc);
+    crc = crc32(ZERO, sizeof(ZERO), crc);
+    return crc32(sector + SECTOR_CRC_OFFSET + 4, SECTOR_SIZE - SECTOR_CRC_OFFSET - 4, crc);
+}
+
+void sealSector(uint8_t sector[SECTOR_SIZE], uint32_t session, uint32_t index) {
+    put32(sector, SECTOR_MAGIC);
+    put32(sector + 4, index);
+    put32(sector + SECTOR_CRC_OFFSET, sectorCrc(sector, session));
+}
+
+bool checkSector(const uint8_t sector[SECTOR_SIZE], uint32_t session, uint32_t index, uint16_t& count,
+                 uint16_t& dropped) {
+    if (get32(sector) != SECTOR_MAGIC || get32(sector + 4) != index) {
+        return false;
+    }
+    count = get16(sector + 8);
+    dropped = get16(sector + 10);
+    if (count > RECORDS_PER_SECTOR) {
+        return false;
+    }
+    return get32(sector + SECTOR_CRC_OFFSET) == sectorCrc(sector, session);
+}
+
+} // namespace RecordingFormat
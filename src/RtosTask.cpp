@@ -0,0 +1,176 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file RtosTask.cpp
+ * @brief FreeRTOS / std::thread task wrapper
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * On the ESP32-S3 tasks are created with xTaskCreatePinnedToCore() and woken with
+ * direct-to-task notifications. On a Linux host the same calls map to std::thread
+ * and a condition variable, so pipeline code can be stress-tested off-device (host
+ * command "pipeline").
+ */
+
+#include "RtosTask.h"
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+/**
+ * @brief Construct a new RtosTask object
+ */
+RtosTask::RtosTask(const char* name, uint32_t stackSize, uint8_t priority, int core)
+    : name_(name), stackSize_(stackSize), priority_(priority), core_(core), entry_(nullptr), arg_(nullptr)
+#ifdef ARDUINO
+      , handle_(nullptr)
+#else
+      , notifications_(0)
+#endif
+{
+}
+
+RtosTask::~RtosTask() {
+    join();
+}
+
+/**
+ * @brief Run the task function (and clean up on the device if it returns)
+ */
+void RtosTask::trampoline(void* self) {
+    RtosTask* task = static_cast<RtosTask*>(self);
+    task->entry_(task->arg_);
+#ifdef ARDUINO
+    task->handle_ = nullptr;
+    vTaskDelete(nullptr);
+#endif
+}
+
+/**
+ * @brief Sleep until the next period boundary
+ */
+void RtosTask::sleepUntil(uint32_t& lastWakeMs, uint32_t periodMs) {
+    uint32_t next = lastWakeMs + periodMs;
+    int32_t remaining = static_cast<int32_t>(next - nowMs());
+    if (remaining > 0) {
+        sleepMs(static_cast<uint32_t>(remaining));
+        lastWakeMs = next;
+    } else if (-remaining >= static_cast<int32_t>(periodMs)) {
+        // More than a full period late: resynchronise instead of bursting
+        lastWakeMs = nowMs();
+    } else {
+        lastWakeMs = next;
+    }
+}
+
+#ifdef ARDUINO
+
+bool RtosTask::start(Entry entry, void* arg) {
+    if (handle_) {
+        return false;
+    }
+    entry_ = entry;
+    arg_ = arg;
+    BaseType_t core = core_ == ANY_CORE ? tskNO_AFFINITY : core_;
+    if (xTaskCreatePinnedToCore(trampoline, name_, stackSize_, this, priority_, &handle_, core) != pdPASS) {
+        handle_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void RtosTask::notify() {
+    if (handle_) {
+        xTaskNotifyGive(handle_);
+    }
+}
+
+void IRAM_ATTR RtosTask::notifyFromIsr() {
+    if (!handle_) {
+        return;
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(handle_, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+uint32_t RtosTask::wait(uint32_t timeoutMs) {
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+void RtosTask::join() {
+}
+
+uint32_t RtosTask::nowMs() {
+    return millis();
+}
+
+void RtosTask::sleepMs(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+#else // Host
+
+bool RtosTask::start(Entry entry, void* arg) {
+    if (thread_.joinable()) {
+        return false;
+    }
+    entry_ = entry;
+    arg_ = arg;
+    thread_ = std::thread(trampoline, this);
+    return true;
+}
+
+void RtosTask::notify() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notifications_++;
+    }
+    wake_.notify_one();
+}
+
+void RtosTask::notifyFromIsr() {
+    notify();
+}
+
+uint32_t RtosTask::wait(uint32_t timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return notifications_ != 0; });
+    uint32_t count = notifications_;
+    notifications_ = 0;
+    return count;
+}
+
+void RtosTask::join() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint32_t RtosTask::nowMs() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+
+void RtosTask::sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+#endif
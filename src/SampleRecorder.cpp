@@ -0,0 +1,251 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SampleRecorder.cpp
+ * @brief Double-buffered binary sample recording with a background writer
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The producer owns the active buffer; the writer owns the pending one. Ownership
+ * moves through pending_ only (release on hand-off, release when written), so the
+ * buffers themselves need no lock.
+ */
+
+#include "SampleRecorder.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace RecordingFormat;
+
+SampleRecorder::SampleRecorder(BlockStorage& storage, uint32_t fileSectors, int core)
+    : storage_(storage), fileSectors_(fileSectors > 1 ? fileSectors : 2), info_(), active_(0), sectorIndex_(0),
+      recordIndex_(0), unreportedDrops_(0), pending_(-1), pendingSectors_(0),
+      task_("recorder", 4096, WRITER_PRIORITY, core), running_(false), fileNumber_(0), sectorInFile_(0),
+      recordsAppended_(0), recordsDropped_(0), sectorsWritten_(0), writeErrors_(0), maxWriteMs_(0) {
+}
+
+/**
+ * @brief Open the first free RECnnnnn.BIN and write its header (writer context after begin())
+ *
+ * The first file of a session gives the session its number.
+ */
+bool SampleRecorder::openNextFile() {
+    char path[16];
+    do {
+        if (++fileNumber_ > MAX_FILE_NUMBER) {
+            return false;
+        }
+        snprintf(path, sizeof(path), "/REC%05lu.BIN", static_cast<unsigned long>(fileNumber_));
+    } while (storage_.exists(path));
+
+    if (info_.part == 0) {
+        info_.session = fileNumber_;
+    }
+    if (!storage_.open(path, fileSectors_ * SECTOR_SIZE)) {
+        return false;
+    }
+    info_.startMs = RtosTask::nowMs();
+    uint8_t header[SECTOR_SIZE];
+    encodeFileHeader(info_, header);
+    if (!storage_.write(header, sizeof(header)) || !storage_.sync()) {
+        return false;
+    }
+    sectorInFile_ = 1;
+    return true;
+}
+
+bool SampleRecorder::begin(const FileInfo& info) {
+    if (running_.load()) {
+        return true;
+    }
+    if (!storage_.begin()) {
+        return false;
+    }
+    info_ = info;
+    info_.part = 0;
+    if (!openNextFile()) {
+        return false;
+    }
+    running_.store(true);
+    if (!task_.start(writerTask, this)) {
+        running_.store(false);
+        storage_.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the sector being filled (producer context)
+ */
+void SampleRecorder::finishSector() {
+    uint8_t* sector = buffers_[active_] + sectorIndex_ * SECTOR_SIZE;
+    setSectorCounts(sector, static_cast<uint16_t>(recordIndex_),
+                    static_cast<uint16_t>(unreportedDrops_ > 0xFFFF ? 0xFFFF : unreportedDrops_));
+    unreportedDrops_ = 0;
+    sectorIndex_++;
+    recordIndex_ = 0;
+}
+
+/**
+ * @brief Give the active buffer to the writer and switch to the other one
+ */
+bool SampleRecorder::handOff() {
+    if (pending_.load(std::memory_order_acquire) >= 0) {
+        return false;
+    }
+    pendingSectors_ = sectorIndex_;
+    pending_.store(static_cast<int8_t>(active_), std::memory_order_release);
+    task_.notify();
+    active_ ^= 1;
+    sectorIndex_ = 0;
+    recordIndex_ = 0;
+    return true;
+}
+
+void SampleRecorder::append(uint32_t timestampMs, int16_t code, float windSpeed) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (sectorIndex_ == BUFFER_SECTORS && !handOff()) {
+        // Both buffers full: the writer is behind
+        unreportedDrops_++;
+        recordsDropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    SampleRecord record;
+    record.timestampMs = timestampMs;
+    record.code = code;
+    float scaled = windSpeed * 100.0f + 0.5f;
+    record.windSpeedCmS = !(scaled > 0.0f) ? 0 : (scaled >= 65535.0f ? 65535 : static_cast<uint16_t>(scaled));
+    putRecord(buffers_[active_] + sectorIndex_ * SECTOR_SIZE, recordIndex_, record);
+    recordsAppended_.fetch_add(1, std::memory_order_relaxed);
+
+    if (++recordIndex_ == RECORDS_PER_SECTOR) {
+        finishSector();
+    }
+}
+
+bool SampleRecorder::flush() {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (pending_.load(std::memory_order_acquire) >= 0) {
+        return false;
+    }
+    // A sector with no record still carries pending drop counts
+    if ((recordIndex_ > 0 || unreportedDrops_ > 0) && sectorIndex_ < BUFFER_SECTORS) {
+        finishSector();
+    }
+    return sectorIndex_ == 0 || handOff();
+}
+
+/**
+ * @brief Stamp and write a buffer, rotating files as they fill up (writer context)
+ */
+void SampleRecorder::writeBuffer(uint8_t* buffer, size_t sectors) {
+    uint32_t start = RtosTask::nowMs();
+    size_t done = 0;
+    while (done < sectors) {
+        if (sectorInFile_ >= fileSectors_) {
+            storage_.close();
+            info_.part++;
+            if (!openNextFile()) {
+                writeErrors_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        size_t room = fileSectors_ - sectorInFile_;
+        size_t count = sectors - done < room ? sectors - done : room;
+        for (size_t i = 0; i < count; i++) {
+            sealSector(buffer + (done + i) * SECTOR_SIZE, info_.session, sectorInFile_ + static_cast<uint32_t>(i));
+        }
+        if (!storage_.write(buffer + done * SECTOR_SIZE, count * SECTOR_SIZE)) {
+            writeErrors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        sectorInFile_ += static_cast<uint32_t>(count);
+        sectorsWritten_.fetch_add(static_cast<uint32_t>(count), std::memory_order_relaxed);
+        done += count;
+    }
+    if (!storage_.sync()) {
+        writeErrors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    uint32_t elapsed = RtosTask::nowMs() - start;
+    if (elapsed > maxWriteMs_.load(std::memory_order_relaxed)) {
+        maxWriteMs_.store(elapsed, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Writer task: writes each handed-off buffer, then gives it back
+ */
+void SampleRecorder::writerTask(void* arg) {
+    SampleRecorder* self = static_cast<SampleRecorder*>(arg);
+    for (;;) {
+        self->task_.wait(1000);
+        int8_t pending = self->pending_.load(std::memory_order_acquire);
+        if (pending >= 0) {
+            self->writeBuffer(self->buffers_[pending], self->pendingSectors_);
+            self->pending_.store(-1, std::memory_order_release);
+        } else if (!self->running_.load()) {
+            return;
+        }
+    }
+}
+
+void SampleRecorder::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    // A second flush may be needed to stamp drops that followed a full buffer
+    while (!flush() || unreportedDrops_ > 0) {
+        RtosTask::sleepMs(1);
+    }
+    running_.store(false);
+    task_.notify();
+    task_.join();
+    storage_.close();
+}
+
+bool SampleRecorder::idle() const {
+    return pending_.load(std::memory_order_acquire) < 0;
+}
+
+uint32_t SampleRecorder::session() const {
+    return info_.session;
+}
+
+uint32_t SampleRecorder::recordsAppended() const {
+    return recordsAppended_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleRecorder::recordsDropped() const {
+    return recordsDropped_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleRecorder::sectorsWritten() const {
+    return sectorsWritten_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleRecorder::writeErrors() const {
+    return writeErrors_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleRecorder::maxWriteMs() const {
+    return maxWriteMs_.load(std::memory_order_relaxed);
+}
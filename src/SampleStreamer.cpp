@@ -0,0 +1,194 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SampleStreamer.cpp
+ * @brief Binary raw sample stream: packing on the producer side, framing in a writer task
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SampleStreamer.h"
+
+SampleStreamer::SampleStreamer(Console& console, int core)
+    : console_(console), info_(), filling_(), nextIndex_(0), sequence_(0), unreportedDrops_(0),
+      task_("streamer", 4096, WRITER_PRIORITY, core), running_(false), packetsSinceInfo_(0), batchLength_(0),
+      codesAppended_(0), codesDropped_(0), packetsWritten_(0), bytesWritten_(0), shortWrites_(0), maxWriteMs_(0) {
+}
+
+bool SampleStreamer::begin(const StreamFormat::StreamInfo& info) {
+    if (running_.load()) {
+        return true;
+    }
+    info_ = info;
+    packetsSinceInfo_ = StreamFormat::INFO_EVERY; // Info packet first
+    running_.store(true);
+    if (!task_.start(writerTask, this)) {
+        running_.store(false);
+        return false;
+    }
+    return true;
+}
+
+void SampleStreamer::append(const int16_t* codes, size_t count, uint32_t lastUs, uint32_t periodUs) {
+    if (!running_.load(std::memory_order_relaxed) || count == 0) {
+        return;
+    }
+    StreamFormat::SamplesHeader& header = filling_.header;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t us = lastUs - static_cast<uint32_t>(count - 1 - i) * periodUs;
+        if (header.count == 0) {
+            header.firstIndex = nextIndex_;
+            header.firstUs = us;
+        }
+        filling_.codes[header.count++] = codes[i];
+        header.lastUs = us;
+        nextIndex_++;
+        if (header.count == StreamFormat::MAX_CODES) {
+            queuePacket();
+        }
+    }
+    codesAppended_.fetch_add(static_cast<uint32_t>(count), std::memory_order_relaxed);
+    // Slow single-shot acquisition: do not hold codes back for seconds
+    if (header.count > 0 && lastUs - header.firstUs >= MAX_PACKET_US) {
+        queuePacket();
+    }
+}
+
+void SampleStreamer::flush() {
+    if (filling_.header.count > 0) {
+        queuePacket();
+    }
+}
+
+/**
+ * @brief Number and hand the packet being filled to the writer, or drop it (producer context)
+ */
+void SampleStreamer::queuePacket() {
+    StreamFormat::SamplesHeader& header = filling_.header;
+    header.sequence = sequence_++;
+    header.dropped = static_cast<uint16_t>(unreportedDrops_ > 0xFFFF ? 0xFFFF : unreportedDrops_);
+    if (queue_.push(filling_)) {
+        unreportedDrops_ = 0;
+        task_.notify();
+    } else {
+        unreportedDrops_ += header.count;
+        codesDropped_.fetch_add(header.count, std::memory_order_relaxed);
+    }
+    header.count = 0;
+}
+
+/**
+ * @brief Add one frame to the batch, writing the batch first if it would not fit (writer context)
+ */
+void SampleStreamer::writeFrame(const uint8_t* frame, size_t length) {
+    if (batchLength_ + length > WRITE_BATCH) {
+        writeBatch();
+    }
+    for (size_t i = 0; i < length; i++) {
+        batch_[batchLength_ + i] = frame[i];
+    }
+    batchLength_ += length;
+}
+
+void SampleStreamer::writeBatch() {
+    if (batchLength_ == 0) {
+        return;
+    }
+    uint32_t start = RtosTask::nowMs();
+    size_t written = console_.write(batch_, batchLength_);
+    if (written < batchLength_) {
+        shortWrites_.fetch_add(1, std::memory_order_relaxed);
+    }
+    bytesWritten_.fetch_add(static_cast<uint32_t>(written), std::memory_order_relaxed);
+    batchLength_ = 0;
+    uint32_t elapsed = RtosTask::nowMs() - start;
+    if (elapsed > maxWriteMs_.load(std::memory_order_relaxed)) {
+        maxWriteMs_.store(elapsed, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Writer task: frames the queued packets and writes them in batches
+ */
+void SampleStreamer::writerTask(void* arg) {
+    SampleStreamer* self = static_cast<SampleStreamer*>(arg);
+    uint8_t frame[StreamFormat::MAX_FRAME_SIZE];
+    Packet packet;
+    for (;;) {
+        self->task_.wait(100);
+        bool running = self->running_.load();
+        while (self->queue_.pop(packet)) {
+            if (self->packetsSinceInfo_ >= StreamFormat::INFO_EVERY) {
+                self->info_.nextSequence = packet.header.sequence;
+                self->writeFrame(frame, StreamFormat::encodeInfo(self->info_, frame, sizeof(frame)));
+                self->packetsSinceInfo_ = 0;
+            }
+            self->writeFrame(frame, StreamFormat::encodeSamples(packet.header, packet.codes, frame, sizeof(frame)));
+            self->packetsSinceInfo_++;
+            self->packetsWritten_.fetch_add(1, std::memory_order_relaxed);
+        }
+        self->writeBatch();
+        if (!running) {
+            return;
+        }
+    }
+}
+
+void SampleStreamer::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    flush();
+    running_.store(false);
+    task_.notify();
+    task_.join();
+}
+
+bool SampleStreamer::running() const {
+    return running_.load();
+}
+
+uint32_t SampleStreamer::codesAppended() const {
+    return codesAppended_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::codesDropped() const {
+    return codesDropped_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::packetsWritten() const {
+    return packetsWritten_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::bytesWritten() const {
+    return bytesWritten_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::shortWrites() const {
+    return shortWrites_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::maxWriteMs() const {
+    return maxWriteMs_.load(std::memory_order_relaxed);
+}
+
+uint32_t SampleStreamer::queued() const {
+    return static_cast<uint32_t>(queue_.size());
+}
+
+uint32_t SampleStreamer::queueHighWater() const {
+    return queue_.highWater();
+}
@@ -0,0 +1,90 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SipHash.cpp
+ * @brief SipHash-2-4 keyed hash
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Straight from the reference description: four 64-bit words of state, two
+ * compression rounds per 8-byte word, the length in the top byte of the last
+ * word, four finalisation rounds.
+ */
+
+#include "SipHash.h"
+
+namespace SipHash {
+
+static inline uint64_t rotate(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static inline void round(uint64_t v[4]) {
+    v[0] += v[1];
+    v[1] = rotate(v[1], 13);
+    v[1] ^= v[0];
+    v[0] = rotate(v[0], 32);
+    v[2] += v[3];
+    v[3] = rotate(v[3], 16);
+    v[3] ^= v[2];
+    v[0] += v[3];
+    v[3] = rotate(v[3], 21);
+    v[3] ^= v[0];
+    v[2] += v[1];
+    v[1] = rotate(v[1], 17);
+    v[1] ^= v[2];
+    v[2] = rotate(v[2], 32);
+}
+
+uint64_t hash(const uint8_t key[KEY_SIZE], const uint8_t* data, size_t length) {
+    uint64_t k0 = load64(key);
+    uint64_t k1 = load64(key + 8);
+    uint64_t v[4] = {k0 ^ 0x736f6d6570736575ULL, k1 ^ 0x646f72616e646f6dULL, k0 ^ 0x6c7967656e657261ULL,
+                     k1 ^ 0x7465646279746573ULL};
+
+    size_t whole = length - length % 8;
+    for (size_t i = 0; i < whole; i += 8) {
+        uint64_t m = load64(data + i);
+        v[3] ^= m;
+        round(v);
+        round(v);
+        v[0] ^= m;
+    }
+    uint64_t last = static_cast<uint64_t>(length) << 56;
+    for (size_t i = whole; i < length; i++) {
+        last |= static_cast<uint64_t>(data[i]) << (8 * (i - whole));
+    }
+    v[3] ^= last;
+    round(v);
+    round(v);
+    v[0] ^= last;
+
+    v[2] ^= 0xFF;
+    for (int i = 0; i < 4; i++) {
+        round(v);
+    }
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+} // namespace SipHash
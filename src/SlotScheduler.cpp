@@ -0,0 +1,300 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SlotScheduler.cpp
+ * @brief Slotted transmit times and neighbour-based slot refinement
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SlotScheduler.h"
+#include <string.h>
+
+static const uint32_t PHASE_MASK = SlotScheduler::SUPERFRAME_US - 1;
+static const uint16_t SUPERFRAME_INDEX_MASK = 0x7FFF;  // 2^32 us / SUPERFRAME_US superframes before wrap-around
+static const int16_t MAX_SEQUENCE_GAP = 100;           // Larger jumps are reboots, not losses
+
+/**
+ * @brief FNV-1a hash of a MAC address
+ */
+static uint32_t macHash(const uint8_t mac[SlotScheduler::MAC_SIZE]) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < SlotScheduler::MAC_SIZE; i++) {
+        hash ^= mac[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Position of a time within its superframe
+ */
+static uint32_t phase(uint32_t us) {
+    return us & PHASE_MASK;
+}
+
+/**
+ * @brief Construct a new SlotScheduler object (call begin() with the MAC address)
+ */
+SlotScheduler::SlotScheduler() {
+    uint8_t none[MAC_SIZE] = {};
+    begin(none);
+}
+
+/**
+ * @brief Derive the initial slot from the MAC address and clear the history
+ */
+void SlotScheduler::begin(const uint8_t mac[MAC_SIZE]) {
+    memcpy(mac_, mac, MAC_SIZE);
+    slot_ = slotForMac(mac);
+    seed_ = macHash(mac) | 1;
+    leadUs_ = 0;
+    maxLatenessUs_ = 0;
+    sends_ = 0;
+    missedSlots_ = 0;
+    conflicts_ = 0;
+    reselections_ = 0;
+    memset(neighbours_, 0, sizeof(neighbours_));
+    memset(slots_, 0, sizeof(slots_));
+    memset(heardSuperframe_, 0, sizeof(heardSuperframe_));
+    memset(heard_, 0, sizeof(heard_));
+    dither_ = random() % DITHER_US;
+}
+
+uint16_t SlotScheduler::slotForMac(const uint8_t mac[MAC_SIZE]) {
+    return static_cast<uint16_t>(macHash(mac) % SLOT_COUNT);
+}
+
+uint16_t SlotScheduler::slot() const {
+    return slot_;
+}
+
+/**
+ * @brief xorshift32
+ */
+uint32_t SlotScheduler::random() {
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+uint16_t SlotScheduler::superframe(uint32_t us) {
+    return static_cast<uint16_t>(us / SUPERFRAME_US);
+}
+
+/**
+ * @brief Time to wait before sending
+ *
+ * The send point is the slot start plus the dither, moved earlier by the average
+ * lateness. Between the send point and the latest start the slot is open now.
+ */
+uint32_t SlotScheduler::delayUs(uint32_t nowUs) const {
+    uint32_t start = slot_ * SLOT_US;
+    uint32_t targetOffset = dither_ > leadUs_ ? dither_ - leadUs_ : 0;
+    uint32_t offset = (phase(nowUs) - start) & PHASE_MASK;
+    if (offset >= targetOffset && offset <= LATEST_START_US) {
+        return 0;
+    }
+    return (start + targetOffset - phase(nowUs)) & PHASE_MASK;
+}
+
+/**
+ * @brief Check that a send starting now stays inside the slot
+ */
+bool SlotScheduler::maySend(uint32_t nowUs) const {
+    return ((phase(nowUs) - slot_ * SLOT_US) & PHASE_MASK) <= LATEST_START_US;
+}
+
+/**
+ * @brief Record a frame sent in the slot and draw the next dither
+ */
+void SlotScheduler::recordSend(uint32_t nowUs, uint32_t targetUs) {
+    sends_++;
+    int32_t lateness = static_cast<int32_t>(nowUs - targetUs);
+    if (lateness < 0) {
+        lateness = 0;
+    } else if (lateness > static_cast<int32_t>(SLOT_US)) {
+        lateness = SLOT_US; // One preemption must not push the target out of the slot
+    }
+    if (static_cast<uint32_t>(lateness) > maxLatenessUs_) {
+        maxLatenessUs_ = lateness;
+    }
+    leadUs_ = (leadUs_ * 7 + lateness) / 8;
+    dither_ = random() % DITHER_US;
+}
+
+void SlotScheduler::recordMissedSlot() {
+    missedSlots_++;
+}
+
+bool SlotScheduler::busy(uint16_t slot, uint16_t now) const {
+    return heard_[slot] && ((now - heardSuperframe_[slot]) & SUPERFRAME_INDEX_MASK) < BUSY_SUPERFRAMES;
+}
+
+void SlotScheduler::markHeard(uint16_t slot, uint16_t now) {
+    heard_[slot] = true;
+    heardSuperframe_[slot] = now;
+}
+
+/**
+ * @brief Find a neighbour, or take the entry of the one heard least recently
+ */
+SlotScheduler::Neighbour& SlotScheduler::neighbour(const uint8_t mac[MAC_SIZE], uint16_t now, bool& known) {
+    Neighbour* spare = nullptr;
+    uint16_t spareAge = 0;
+    for (size_t i = 0; i < NEIGHBOUR_COUNT; i++) {
+        Neighbour& entry = neighbours_[i];
+        if (entry.valid && memcmp(entry.mac, mac, MAC_SIZE) == 0) {
+            known = true;
+            return entry;
+        }
+        // A free entry beats any used one
+        uint16_t age = entry.valid ? (now - entry.lastSuperframe) & SUPERFRAME_INDEX_MASK : SUPERFRAME_INDEX_MASK + 1;
+        if (!spare || age > spareAge) {
+            spare = &entry;
+            spareAge = age;
+        }
+    }
+    known = false;
+    memcpy(spare->mac, mac, MAC_SIZE);
+    spare->valid = true;
+    return *spare;
+}
+
+/**
+ * @brief Move to a random slot where nobody was heard recently
+ *
+ * Random rather than the first free slot, so nodes leaving the same crowded slot
+ * do not all land on the same one. With no free slot, take the one heard least recently.
+ */
+void SlotScheduler::reselect(uint16_t now) {
+    uint16_t freeSlots = 0;
+    for (uint16_t i = 0; i < SLOT_COUNT; i++) {
+        if (i != slot_ && !busy(i, now)) {
+            freeSlots++;
+        }
+    }
+    uint16_t chosen = slot_;
+    if (freeSlots > 0) {
+        uint16_t pick = random() % freeSlots;
+        for (uint16_t i = 0; i < SLOT_COUNT; i++) {
+            if (i != slot_ && !busy(i, now) && pick-- == 0) {
+                chosen = i;
+                break;
+            }
+        }
+    } else {
+        uint16_t oldestAge = 0;
+        for (uint16_t i = 0; i < SLOT_COUNT; i++) {
+            uint16_t age = (now - heardSuperframe_[i]) & SUPERFRAME_INDEX_MASK;
+            if (i != slot_ && age >= oldestAge) {
+                chosen = i;
+                oldestAge = age;
+            }
+        }
+    }
+    if (chosen != slot_) {
+        slot_ = chosen;
+        reselections_++;
+    }
+}
+
+/**
+ * @brief Account for a frame heard from another anemometer
+ *
+ * The frame and the guard after it may spill into the next slot, which is marked too.
+ */
+void SlotScheduler::observe(const uint8_t mac[MAC_SIZE], uint16_t sequence, uint32_t rxUs) {
+    if (memcmp(mac, mac_, MAC_SIZE) == 0) {
+        return;
+    }
+    uint16_t now = superframe(rxUs);
+    uint32_t startUs = rxUs - FRAME_AIRTIME_US;
+    uint16_t first = phase(startUs) / SLOT_US;
+    uint16_t last = phase(startUs + FRAME_AIRTIME_US + GUARD_US - 1) / SLOT_US;
+
+    bool known;
+    Neighbour& entry = neighbour(mac, now, known);
+    SlotStats& stats = slots_[first];
+    stats.received++;
+    if (known) {
+        int16_t gap = static_cast<int16_t>(static_cast<uint16_t>(sequence - entry.lastSequence));
+        if (gap > 1 && gap <= MAX_SEQUENCE_GAP) {
+            stats.missed += gap - 1;
+        }
+    }
+    entry.lastSequence = sequence;
+    entry.slot = first;
+    entry.lastSuperframe = now;
+    markHeard(first, now);
+    markHeard(last, now);
+
+    if (first == slot_ || last == slot_) {
+        conflicts_++;
+        // The lower MAC keeps the slot, so two nodes never chase each other
+        if (memcmp(mac, mac_, MAC_SIZE) < 0) {
+            reselect(now);
+        }
+    }
+}
+
+/**
+ * @brief Statistics of one slot, occupants counted at the given time
+ */
+SlotStats SlotScheduler::slotStats(uint16_t slot, uint32_t nowUs) const {
+    SlotStats stats = slots_[slot % SLOT_COUNT];
+    stats.occupants = 0;
+    uint16_t now = superframe(nowUs);
+    for (size_t i = 0; i < NEIGHBOUR_COUNT; i++) {
+        const Neighbour& entry = neighbours_[i];
+        if (entry.valid && entry.slot == slot &&
+            ((now - entry.lastSuperframe) & SUPERFRAME_INDEX_MASK) < BUSY_SUPERFRAMES) {
+            stats.occupants++;
+        }
+    }
+    return stats;
+}
+
+float SlotScheduler::lossEstimate(uint16_t slot) const {
+    const SlotStats& stats = slots_[slot % SLOT_COUNT];
+    uint32_t total = stats.received + stats.missed;
+    return total ? static_cast<float>(stats.missed) / total : 0.0f;
+}
+
+uint32_t SlotScheduler::sends() const {
+    return sends_;
+}
+
+uint32_t SlotScheduler::missedSlots() const {
+    return missedSlots_;
+}
+
+uint32_t SlotScheduler::conflicts() const {
+    return conflicts_;
+}
+
+uint32_t SlotScheduler::reselections() const {
+    return reselections_;
+}
+
+uint32_t SlotScheduler::leadUs() const {
+    return leadUs_;
+}
+
+uint32_t SlotScheduler::maxLatenessUs() const {
+    return maxLatenessUs_;
+}
@@ -0,0 +1,164 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file StreamFormat.cpp
+ * @brief COBS framing and CRC-32 of the raw sample stream packets
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * COBS (consistent overhead byte stuffing) replaces every zero byte by the distance
+ * to the next one, so the only zero on the wire is the frame delimiter. The
+ * overhead is one byte per 254 bytes of packet plus one.
+ */
+
+#include "StreamFormat.h"
+#include "ByteOrder.h"
+#include "RecordingFormat.h"
+#include <string.h>
+
+namespace StreamFormat {
+
+using namespace ByteOrder;
+
+size_t cobsEncode(const uint8_t* packet, size_t length, uint8_t* out, size_t capacity) {
+    if (capacity < length + length / 254 + 2) {
+        return 0;
+    }
+    size_t codeIndex = 0;   // Where the distance of the current block goes
+    size_t written = 1;
+    uint8_t distance = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (packet[i] != 0) {
+            out[written++] = packet[i];
+            distance++;
+        }
+        if (packet[i] == 0 || distance == 0xFF) {
+            out[codeIndex] = distance;
+            codeIndex = written++;
+            distance = 1;
+        }
+    }
+    out[codeIndex] = distance;
+    out[written++] = DELIMITER;
+    return written;
+}
+
+size_t cobsDecode(const uint8_t* frame, size_t length, uint8_t* out, size_t capacity) {
+    size_t written = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t distance = frame[i++];
+        if (distance == 0 || i + distance - 1 > length) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < distance; k++) {
+            if (written >= capacity || frame[i] == 0) {
+                return 0;
+            }
+            out[written++] = frame[i++];
+        }
+        // A block shorter than 254 bytes stands for a zero, except at the end
+        if (distance != 0xFF && i < length) {
+            if (written >= capacity) {
+                return 0;
+            }
+            out[written++] = 0;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief Append the CRC to a packet and frame it
+ */
+static size_t finish(uint8_t* packet, size_t length, uint8_t* out, size_t capacity) {
+    put32(packet + length, RecordingFormat::crc32(packet, length));
+    return cobsEncode(packet, length + CRC_SIZE, out, capacity);
+}
+
+size_t encodeSamples(const SamplesHeader& header, const int16_t* codes, uint8_t* out, size_t capacity) {
+    if (header.count == 0 || header.count > MAX_CODES) {
+        return 0;
+    }
+    uint8_t packet[MAX_PACKET_SIZE];
+    packet[0] = TYPE_SAMPLES;
+    packet[1] = VERSION;
+    put16(packet + 2, header.sequence);
+    put32(packet + 4, header.firstIndex);
+    put32(packet + 8, header.firstUs);
+    put32(packet + 12, header.lastUs);
+    put16(packet + 16, header.dropped);
+    packet[18] = header.count;
+    for (size_t i = 0; i < header.count; i++) {
+        put16(packet + SAMPLES_HEADER_SIZE + 2 * i, static_cast<uint16_t>(codes[i]));
+    }
+    return finish(packet, SAMPLES_HEADER_SIZE + 2 * header.count, out, capacity);
+}
+
+size_t encodeInfo(const StreamInfo& info, uint8_t* out, size_t capacity) {
+    uint8_t packet[INFO_SIZE];
+    packet[0] = TYPE_INFO;
+    packet[1] = VERSION;
+    put16(packet + 2, info.nextSequence);
+    memcpy(packet + 4, info.macAddress, 6);
+    put16(packet + 10, info.sampleRate);
+    putFloat(packet + 12, info.millivoltsPerCode);
+    return finish(packet, INFO_SIZE - CRC_SIZE, out, capacity);
+}
+
+uint8_t checkPacket(const uint8_t* packet, size_t length) {
+    if (length < 2 + CRC_SIZE || packet[1] != VERSION ||
+        get32(packet + length - CRC_SIZE) != RecordingFormat::crc32(packet, length - CRC_SIZE)) {
+        return 0;
+    }
+    if (packet[0] == TYPE_SAMPLES && length >= SAMPLES_HEADER_SIZE + CRC_SIZE &&
+        length == SAMPLES_HEADER_SIZE + 2 * packet[18] + CRC_SIZE) {
+        return TYPE_SAMPLES;
+    }
+    if (packet[0] == TYPE_INFO && length == INFO_SIZE) {
+        return TYPE_INFO;
+    }
+    return 0;
+}
+
+bool decodeSamples(const uint8_t* packet, size_t length, SamplesHeader& header, int16_t* codes) {
+    if (checkPacket(packet, length) != TYPE_SAMPLES || packet[18] > MAX_CODES) {
+        return false;
+    }
+    header.sequence = get16(packet + 2);
+    header.firstIndex = get32(packet + 4);
+    header.firstUs = get32(packet + 8);
+    header.lastUs = get32(packet + 12);
+    header.dropped = get16(packet + 16);
+    header.count = packet[18];
+    for (size_t i = 0; i < header.count; i++) {
+        codes[i] = static_cast<int16_t>(get16(packet + SAMPLES_HEADER_SIZE + 2 * i));
+    }
+    return true;
+}
+
+bool decodeInfo(const uint8_t* packet, size_t length, StreamInfo& info) {
+    if (checkPacket(packet, length) != TYPE_INFO) {
+        return false;
+    }
+    info.nextSequence = get16(packet + 2);
+    memcpy(info.macAddress, packet + 4, 6);
+    info.sampleRate = get16(packet + 10);
+    info.millivoltsPerCode = getFloat(packet + 12);
+    return true;
+}
+
+} // namespace StreamFormat
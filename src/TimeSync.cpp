@@ -0,0 +1,230 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TimeSync.cpp
+ * @brief Offset and drift estimation against the two-step time beacons of a reference node
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "TimeSync.h"
+#include <math.h>
+#include <string.h>
+
+TimeSync::TimeSync()
+    : role_(Role::Follower), mac_(), referenceMac_(), hasReference_(false), nextSequence_(0), lastBeaconUs_(0),
+      hasLastBeacon_(false), lastSequence_(0), points_(), count_(0), next_(0), originUs_(0), baseOffsetUs_(0),
+      interceptUs_(0.0f), slope_(0.0f), slopeErrorPpm_(0.0f), residualUs_(0.0f), outliersInRow_(0), beacons_(0), lostBeacons_(0), outliers_(0),
+      resets_(0) {
+}
+
+void TimeSync::begin(const uint8_t mac[MAC_SIZE], Role role) {
+    memcpy(mac_, mac, MAC_SIZE);
+    role_ = role;
+    hasReference_ = false;
+    hasLastBeacon_ = false;
+    nextSequence_ = 0;
+    beacons_ = 0;
+    lostBeacons_ = 0;
+    outliers_ = 0;
+    resets_ = 0;
+    restart();
+}
+
+TimeSync::Role TimeSync::role() const {
+    return role_;
+}
+
+/**
+ * @brief Forget the beacons of the fit
+ */
+void TimeSync::restart() {
+    count_ = 0;
+    next_ = 0;
+    interceptUs_ = 0.0f;
+    slope_ = 0.0f;
+    slopeErrorPpm_ = 0.0f;
+    residualUs_ = 0.0f;
+    outliersInRow_ = 0;
+}
+
+bool TimeSync::beaconDue(uint32_t nowUs) const {
+    return role_ == Role::Reference && (beacons_ == 0 || nowUs - lastBeaconUs_ >= BEACON_PERIOD_US);
+}
+
+void TimeSync::makeBeacon(TimeBeacon& beacon, uint32_t nowUs, bool previousSent, uint32_t previousAirUs) {
+    memcpy(beacon.macAddress, mac_, MAC_SIZE);
+    beacon.sequence = nextSequence_++;
+    beacon.hasPrevious = previousSent && beacons_ > 0;
+    beacon.previousAirUs = beacon.hasPrevious ? previousAirUs : 0;
+    lastBeaconUs_ = nowUs;
+    beacons_++;
+}
+
+bool TimeSync::observe(const TimeBeacon& beacon, uint32_t rxUs) {
+    if (role_ == Role::Reference) {
+        return false;
+    }
+    if (hasReference_ && memcmp(beacon.macAddress, referenceMac_, MAC_SIZE) != 0) {
+        if (rxUs - lastBeaconUs_ < REFERENCE_TIMEOUT_US) {
+            return false; // Another reference: keep the one we follow while it is heard
+        }
+        hasReference_ = false;
+        hasLastBeacon_ = false;
+        resets_++;
+        restart();
+    }
+    if (!hasReference_) {
+        memcpy(referenceMac_, beacon.macAddress, MAC_SIZE);
+        hasReference_ = true;
+        nextSequence_ = beacon.sequence;
+    }
+    int16_t gap = WireFormat::sequenceDelta(beacon.sequence, nextSequence_);
+    if (gap < 0) {
+        return false; // Repeated or reordered beacon
+    }
+    lostBeacons_ += static_cast<uint32_t>(gap);
+    nextSequence_ = static_cast<uint16_t>(beacon.sequence + 1);
+
+    // The departure time of the previous beacon pairs with our receive time of it
+    bool paired = hasLastBeacon_ && beacon.hasPrevious && lastSequence_ == static_cast<uint16_t>(beacon.sequence - 1);
+    uint32_t localUs = lastBeaconUs_;
+    hasLastBeacon_ = true;
+    lastSequence_ = beacon.sequence;
+    lastBeaconUs_ = rxUs;
+    if (!paired) {
+        return false;
+    }
+    uint32_t offset = beacon.previousAirUs - localUs;
+    if (count_ >= MIN_BEACONS) {
+        float residual = static_cast<float>(static_cast<int32_t>(offset - baseOffsetUs_) - predictUs(localUs));
+        float limit = 4.0f * residualUs_ > OUTLIER_US ? 4.0f * residualUs_ : static_cast<float>(OUTLIER_US);
+        if (fabsf(residual) > limit) {
+            outliers_++;
+            if (++outliersInRow_ < MAX_OUTLIERS) {
+                return false;
+            }
+            resets_++; // The reference clock jumped (restart): follow it
+            restart();
+        }
+    }
+    outliersInRow_ = 0;
+    points_[next_] = {localUs, offset};
+    next_ = (next_ + 1) % WINDOW;
+    if (count_ < WINDOW) {
+        count_++;
+    }
+    beacons_++;
+    fit();
+    return true;
+}
+
+/**
+ * @brief Least-squares line through the offsets, around the newest beacon
+ */
+void TimeSync::fit() {
+    const Point& newest = points_[(next_ + WINDOW - 1) % WINDOW];
+    originUs_ = newest.localUs;
+    baseOffsetUs_ = newest.offsetUs;
+    float xs[WINDOW];
+    float ys[WINDOW];
+    float meanX = 0.0f;
+    float meanY = 0.0f;
+    for (size_t i = 0; i < count_; i++) {
+        xs[i] = static_cast<float>(static_cast<int32_t>(points_[i].localUs - originUs_));
+        ys[i] = static_cast<float>(static_cast<int32_t>(points_[i].offsetUs - baseOffsetUs_));
+        meanX += xs[i];
+        meanY += ys[i];
+    }
+    meanX /= count_;
+    meanY /= count_;
+    float sxx = 0.0f;
+    float sxy = 0.0f;
+    for (size_t i = 0; i < count_; i++) {
+        sxx += (xs[i] - meanX) * (xs[i] - meanX);
+        sxy += (xs[i] - meanX) * (ys[i] - meanY);
+    }
+    slope_ = sxx > 0.0f ? sxy / sxx : 0.0f;
+    interceptUs_ = meanY - slope_ * meanX;
+    float squares = 0.0f;
+    for (size_t i = 0; i < count_; i++) {
+        float residual = ys[i] - (interceptUs_ + slope_ * xs[i]);
+        squares += residual * residual;
+    }
+    residualUs_ = count_ > 2 ? sqrtf(squares / (count_ - 2)) : 0.0f;
+    slopeErrorPpm_ = sxx > 0.0f ? residualUs_ / sqrtf(sxx) * 1e6f : 0.0f;
+}
+
+/**
+ * @brief Fitted offset at a local time, relative to baseOffsetUs_
+ */
+int32_t TimeSync::predictUs(uint32_t localUs) const {
+    float x = static_cast<float>(static_cast<int32_t>(localUs - originUs_));
+    return static_cast<int32_t>(lroundf(interceptUs_ + slope_ * x));
+}
+
+bool TimeSync::synced(uint32_t nowUs) const {
+    if (role_ == Role::Reference) {
+        return true;
+    }
+    return count_ >= MIN_BEACONS && nowUs - originUs_ < MAX_BEACON_AGE_US;
+}
+
+uint32_t TimeSync::toReference(uint32_t localUs) const {
+    if (role_ == Role::Reference || count_ == 0) {
+        return localUs;
+    }
+    return localUs + baseOffsetUs_ + static_cast<uint32_t>(predictUs(localUs));
+}
+
+uint16_t TimeSync::errorUs(uint32_t nowUs) const {
+    if (role_ == Role::Reference) {
+        return 0;
+    }
+    if (!synced(nowUs)) {
+        return MAX_ERROR_US;
+    }
+    float error = residualUs_ + slopeErrorPpm_ * 1e-6f * static_cast<float>(nowUs - originUs_);
+    return error >= MAX_ERROR_US ? MAX_ERROR_US : static_cast<uint16_t>(error + 0.5f);
+}
+
+int32_t TimeSync::offsetUs() const {
+    return static_cast<int32_t>(baseOffsetUs_ + static_cast<uint32_t>(predictUs(originUs_)));
+}
+
+float TimeSync::driftPpm() const {
+    return slope_ * 1e6f;
+}
+
+float TimeSync::residualUs() const {
+    return residualUs_;
+}
+
+uint32_t TimeSync::beacons() const {
+    return beacons_;
+}
+
+uint32_t TimeSync::lostBeacons() const {
+    return lostBeacons_;
+}
+
+uint32_t TimeSync::outliers() const {
+    return outliers_;
+}
+
+uint32_t TimeSync::resets() const {
+    return resets_;
+}
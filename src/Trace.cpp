@@ -0,0 +1,217 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Trace.cpp
+ * @brief Cycle-counter histograms of the hot paths (compiled only with TRACE_ENABLED)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include "Logger.h"
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+namespace {
+
+struct StageStats {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> maxCycles;
+    std::atomic<uint32_t> averageCycles;
+    std::atomic<uint32_t> histogram[Trace::BUCKETS];
+};
+
+StageStats stages[TRACE_STAGE_COUNT];
+StageStats calibration;                 // Scratch stage timed by begin()
+uint32_t cyclesPerUs = 1;
+uint32_t overhead = 0;
+uint32_t lastTick = 0;                  // Cycle count of the previous tick()
+bool ticking = false;
+
+const char* const NAMES[TRACE_STAGE_COUNT] = {"update", "filter", "convert", "log", "display",
+                                              "mac",    "offer",  "analysis", "jitter"};
+
+size_t bucketOf(uint32_t cycles) {
+    if (cycles < (1u << Trace::MIN_BUCKET_BITS)) {
+        return 0;
+    }
+    size_t bucket = 32 - __builtin_clz(cycles) - Trace::MIN_BUCKET_BITS;
+    return bucket < Trace::BUCKETS ? bucket : Trace::BUCKETS - 1;
+}
+
+void file(StageStats& stats, uint32_t cycles) {
+    stats.histogram[bucketOf(cycles)].fetch_add(1, std::memory_order_relaxed);
+    uint32_t count = stats.count.fetch_add(1, std::memory_order_relaxed);
+    uint32_t average = stats.averageCycles.load(std::memory_order_relaxed);
+    average = count == 0 ? cycles : average + (static_cast<int32_t>(cycles - average) >> 4);
+    stats.averageCycles.store(average, std::memory_order_relaxed);
+    if (cycles > stats.maxCycles.load(std::memory_order_relaxed)) {
+        stats.maxCycles.store(cycles, std::memory_order_relaxed);
+    }
+}
+
+void clear(StageStats& stats) {
+    stats.count.store(0, std::memory_order_relaxed);
+    stats.maxCycles.store(0, std::memory_order_relaxed);
+    stats.averageCycles.store(0, std::memory_order_relaxed);
+    for (size_t b = 0; b < Trace::BUCKETS; b++) {
+        stats.histogram[b].store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Cycles per microsecond of the counter read by Trace::cycles()
+ */
+uint32_t measureRate() {
+#ifdef ARDUINO
+    return getCpuFrequencyMhz();
+#elif defined(__x86_64__) || defined(__i386__)
+    auto start = std::chrono::steady_clock::now();
+    uint32_t startCycles = Trace::cycles();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {
+    }
+    uint32_t elapsedCycles = Trace::cycles() - startCycles;
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double us = std::chrono::duration<double, std::micro>(elapsed).count();
+    return static_cast<uint32_t>(elapsedCycles / us + 0.5);
+#else
+    return 1000; // Nanoseconds
+#endif
+}
+
+} // namespace
+
+void Trace::begin() {
+    cyclesPerUs = measureRate();
+    // Time scopes filed into a scratch stage: counter reads, bucket and atomics included
+    static const uint32_t ROUNDS = 1000;
+    clear(calibration);
+    uint32_t start = cycles();
+    for (uint32_t i = 0; i < ROUNDS; i++) {
+        uint32_t entry = cycles();
+        file(calibration, cycles() - entry);
+    }
+    overhead = (cycles() - start) / ROUNDS;
+    reset();
+}
+
+void Trace::record(TraceStage stage, uint32_t cycles) {
+    file(stages[static_cast<size_t>(stage)], cycles);
+}
+
+void Trace::tick(uint32_t periodUs) {
+    uint32_t now = cycles();
+    if (ticking) {
+        uint32_t interval = now - lastTick;
+        uint32_t period = periodUs * cyclesPerUs;
+        record(TraceStage::Jitter, interval > period ? interval - period : period - interval);
+    }
+    lastTick = now;
+    ticking = true;
+}
+
+void Trace::reset() {
+    for (StageStats& stats : stages) {
+        clear(stats);
+    }
+    ticking = false;
+}
+
+uint32_t Trace::count(TraceStage stage) {
+    return stages[static_cast<size_t>(stage)].count.load(std::memory_order_relaxed);
+}
+
+uint32_t Trace::maxCycles(TraceStage stage) {
+    return stages[static_cast<size_t>(stage)].maxCycles.load(std::memory_order_relaxed);
+}
+
+uint32_t Trace::averageCycles(TraceStage stage) {
+    return stages[static_cast<size_t>(stage)].averageCycles.load(std::memory_order_relaxed);
+}
+
+uint32_t Trace::bucketCount(TraceStage stage, size_t bucket) {
+    return bucket < BUCKETS ? stages[static_cast<size_t>(stage)].histogram[bucket].load(std::memory_order_relaxed)
+                            : 0;
+}
+
+size_t Trace::percentileBucket(TraceStage stage, float fraction) {
+    uint32_t total = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        total += bucketCount(stage, b);
+    }
+    uint32_t target = static_cast<uint32_t>(total * fraction + 0.5f);
+    uint32_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        seen += bucketCount(stage, b);
+        if (seen >= target && seen > 0) {
+            return b;
+        }
+    }
+    return 0;
+}
+
+uint32_t Trace::bucketLimit(size_t bucket) {
+    return bucket + 1 < BUCKETS ? 1u << (bucket + MIN_BUCKET_BITS) : 0;
+}
+
+uint32_t Trace::cyclesPerMicrosecond() {
+    return cyclesPerUs;
+}
+
+uint32_t Trace::overheadCycles() {
+    return overhead;
+}
+
+const char* Trace::name(TraceStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < TRACE_STAGE_COUNT ? NAMES[index] : "?";
+}
+
+void Trace::dump(Logger& logger) {
+    float us = 1.0f / cyclesPerUs;
+    logger.logf(LogModule::Main, LogLevel::Info, "Trace: %lu cycles/us, %lu cycles per scope", cyclesPerUs, overhead);
+    for (size_t i = 0; i < TRACE_STAGE_COUNT; i++) {
+        TraceStage stage = static_cast<TraceStage>(i);
+        uint32_t calls = count(stage);
+        if (calls == 0) {
+            continue;
+        }
+        size_t p50 = percentileBucket(stage, 0.5f);
+        size_t p99 = percentileBucket(stage, 0.99f);
+        logger.logf(LogModule::Main, LogLevel::Info, "Trace %s: %lu calls, avg %.1f us, p50 < %.1f us, p99 < %.1f us, max %.1f us",
+                    name(stage), calls, averageCycles(stage) * us,
+                    bucketLimit(p50) ? bucketLimit(p50) * us : maxCycles(stage) * us,
+                    bucketLimit(p99) ? bucketLimit(p99) * us : maxCycles(stage) * us, maxCycles(stage) * us);
+        for (size_t b = 0; b < BUCKETS; b++) {
+            uint32_t n = bucketCount(stage, b);
+            if (n == 0) {
+                continue;
+            }
+            if (bucketLimit(b)) {
+                logger.logf(LogModule::Main, LogLevel::Debug, "Trace %s < %lu cycles: %lu", name(stage), bucketLimit(b), n);
+            } else {
+                logger.logf(LogModule::Main, LogLevel::Debug, "Trace %s >= %lu cycles: %lu", name(stage),
+                            bucketLimit(b - 1), n);
+            }
+        }
+    }
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,228 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TransmitEngine.cpp
+ * @brief In-flight tracking, back-pressure and latency statistics of the radio frames
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "TransmitEngine.h"
+
+/**
+ * @brief Construct a new TransmitEngine object
+ */
+TransmitEngine::TransmitEngine(RadioTransport& radio, Clock& clock)
+    : radio_(radio), clock_(clock), tracking_(false), enqueueUs_(), head_(0), tail_(0), queued_(0), completed_(0),
+      failed_(0), busy_(0), errors_(0), unexpected_(0), maxInFlight_(0), maxLatencyUs_(0), averageLatencyUs_(0),
+      timedFrame_(0), timedPending_(false), timedSent_(false), timedDoneUs_(0), firstSent_(false),
+      firstSentUs_(0) {
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        histogram_[0][i].store(0, std::memory_order_relaxed);
+        histogram_[1][i].store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Register the completion handler
+ */
+bool TransmitEngine::begin() {
+    tracking_ = radio_.setSendHandler(onSent, this);
+    return tracking_;
+}
+
+bool TransmitEngine::ready() {
+    if (inFlight() < MAX_IN_FLIGHT) {
+        return true;
+    }
+    busy_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Queue one frame, unless too many are already in flight
+ *
+ * The stamp is published before the radio call: the completion may arrive before
+ * send() returns. If the radio refuses the frame, no completion will come, so the
+ * stamp is withdrawn (the handler never pops past a frame it was not told about).
+ */
+RadioTransport::SendStatus TransmitEngine::send(const uint8_t destination[RadioTransport::MAC_SIZE],
+                                                const uint8_t* data, size_t length) {
+    if (!ready()) {
+        return RadioTransport::SendStatus::Busy;
+    }
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    enqueueUs_[head % MAX_IN_FLIGHT] = clock_.micros();
+    head_.store(head + 1, std::memory_order_release);
+
+    RadioTransport::SendStatus status = radio_.send(destination, data, length);
+    if (status != RadioTransport::SendStatus::Queued) {
+        head_.store(head, std::memory_order_release);
+        (status == RadioTransport::SendStatus::Busy ? busy_ : errors_).fetch_add(1, std::memory_order_relaxed);
+        return status;
+    }
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t outstanding = inFlight();
+    if (outstanding > maxInFlight_.load(std::memory_order_relaxed)) {
+        maxInFlight_.store(outstanding, std::memory_order_relaxed);
+    }
+    if (!tracking_) {
+        complete(true, clock_.micros());
+    }
+    return status;
+}
+
+/**
+ * @brief Queue one frame and keep its completion time
+ *
+ * The frame index is published before send(), as the completion may come first.
+ */
+RadioTransport::SendStatus TransmitEngine::sendTimed(const uint8_t destination[RadioTransport::MAC_SIZE],
+                                                     const uint8_t* data, size_t length) {
+    timedSent_.store(false, std::memory_order_relaxed);
+    timedFrame_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    timedPending_.store(true, std::memory_order_release);
+    RadioTransport::SendStatus status = send(destination, data, length);
+    if (status != RadioTransport::SendStatus::Queued) {
+        timedPending_.store(false, std::memory_order_relaxed);
+    }
+    return status;
+}
+
+bool TransmitEngine::timedDoneUs(uint32_t& doneUs) const {
+    if (!timedSent_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    doneUs = timedDoneUs_;
+    return true;
+}
+
+bool TransmitEngine::firstSentUs(uint32_t& doneUs) const {
+    if (!firstSent_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    doneUs = firstSentUs_;
+    return true;
+}
+
+/**
+ * @brief Send-completion handler (radio driver context)
+ */
+void TransmitEngine::onSent(void* context, bool delivered, uint32_t doneUs) {
+    static_cast<TransmitEngine*>(context)->complete(delivered, doneUs);
+}
+
+/**
+ * @brief Pop the oldest frame in flight and file its latency
+ */
+void TransmitEngine::complete(bool delivered, uint32_t doneUs) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+        unexpected_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t latency = doneUs - enqueueUs_[tail % MAX_IN_FLIGHT];
+    tail_.store(tail + 1, std::memory_order_release);
+    if (timedPending_.load(std::memory_order_acquire) && tail == timedFrame_.load(std::memory_order_relaxed)) {
+        timedPending_.store(false, std::memory_order_relaxed);
+        timedDoneUs_ = doneUs;
+        timedSent_.store(delivered, std::memory_order_release);
+    }
+
+    if (delivered && !firstSent_.load(std::memory_order_relaxed)) {
+        firstSentUs_ = doneUs;
+        firstSent_.store(true, std::memory_order_release);
+    }
+    (delivered ? completed_ : failed_).fetch_add(1, std::memory_order_relaxed);
+    size_t bucket = 0;
+    while (bucket + 1 < LATENCY_BUCKETS && latency >= bucketLimitUs(bucket)) {
+        bucket++;
+    }
+    histogram_[delivered ? 1 : 0][bucket].fetch_add(1, std::memory_order_relaxed);
+    if (latency > maxLatencyUs_.load(std::memory_order_relaxed)) {
+        maxLatencyUs_.store(latency, std::memory_order_relaxed);
+    }
+    uint32_t average = averageLatencyUs_.load(std::memory_order_relaxed);
+    averageLatencyUs_.store(average == 0 ? latency : average - average / 16 + latency / 16,
+                            std::memory_order_relaxed);
+}
+
+/**
+ * @brief Clear the delivery statistics
+ */
+void TransmitEngine::resetStatistics() {
+    queued_.store(0, std::memory_order_relaxed);
+    completed_.store(0, std::memory_order_relaxed);
+    failed_.store(0, std::memory_order_relaxed);
+    busy_.store(0, std::memory_order_relaxed);
+    errors_.store(0, std::memory_order_relaxed);
+    unexpected_.store(0, std::memory_order_relaxed);
+    maxInFlight_.store(0, std::memory_order_relaxed);
+    maxLatencyUs_.store(0, std::memory_order_relaxed);
+    averageLatencyUs_.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        histogram_[0][i].store(0, std::memory_order_relaxed);
+        histogram_[1][i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t TransmitEngine::inFlight() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+}
+
+uint32_t TransmitEngine::queued() const {
+    return queued_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::completed() const {
+    return completed_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::failed() const {
+    return failed_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::busy() const {
+    return busy_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::errors() const {
+    return errors_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::unexpected() const {
+    return unexpected_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::maxInFlight() const {
+    return maxInFlight_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::maxLatencyUs() const {
+    return maxLatencyUs_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::averageLatencyUs() const {
+    return averageLatencyUs_.load(std::memory_order_relaxed);
+}
+
+uint32_t TransmitEngine::latencyCount(bool delivered, size_t bucket) const {
+    return bucket < LATENCY_BUCKETS ? histogram_[delivered ? 1 : 0][bucket].load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t TransmitEngine::bucketLimitUs(size_t bucket) {
+    return bucket + 1 < LATENCY_BUCKETS ? FIRST_BUCKET_US << bucket : 0;
+}
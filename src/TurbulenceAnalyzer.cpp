@@ -0,0 +1,264 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TurbulenceAnalyzer.cpp
+ * @brief Turbulence intensity and gust frequency from a windowed real FFT
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "TurbulenceAnalyzer.h"
+#include "Trace.h"
+#include <math.h>
+
+TurbulenceAnalyzer::TurbulenceAnalyzer(Clock& clock, float inputRate)
+    : clock_(clock), sampleRate_(ANALYSIS_RATE_HZ), averaging_(1), accumulator_(0), accumulated_(0),
+      pendingRate_(0.0f), historyCount_(0), sinceAnalysis_(0), windowEnergy_(0), analyses_(0), lastAnalysisUs_(0),
+      maxAnalysisUs_(0) {
+    const float twoPi = 6.28318530718f;
+    // Periodic Hann window: its spectral leakage is the usual reference for PSD estimates
+    for (size_t n = 0; n < FFT_SIZE; n++) {
+        window_[n] = 0.5f - 0.5f * cosf(twoPi * n / FFT_SIZE);
+        windowEnergy_ += window_[n] * window_[n];
+    }
+    for (size_t k = 0; k < HALF; k++) {
+        cos_[k] = cosf(twoPi * k / FFT_SIZE);
+        sin_[k] = sinf(twoPi * k / FFT_SIZE);
+    }
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < HALF) {
+        bits++;
+    }
+    for (size_t n = 0; n < HALF; n++) {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; b++) {
+            reversed |= ((n >> b) & 1) << (bits - 1 - b);
+        }
+        bitReverse_[n] = static_cast<uint16_t>(reversed);
+    }
+    for (size_t k = 0; k < BINS; k++) {
+        power_[k] = 0;
+    }
+    setInputRate(inputRate);
+}
+
+void TurbulenceAnalyzer::setInputRate(float inputRate) {
+    averaging_ = inputRate > ANALYSIS_RATE_HZ ? static_cast<uint32_t>(inputRate / ANALYSIS_RATE_HZ + 0.5f) : 1;
+    sampleRate_ = inputRate > 0 ? inputRate / averaging_ : ANALYSIS_RATE_HZ;
+    accumulator_ = 0;
+    accumulated_ = 0;
+    pendingRate_.store(0.0f, std::memory_order_relaxed);
+    float discarded;
+    while (samples_.pop(discarded)) {
+    }
+    historyCount_ = 0;
+    sinceAnalysis_ = 0;
+}
+
+void TurbulenceAnalyzer::changeInputRate(float inputRate) {
+    averaging_ = inputRate > ANALYSIS_RATE_HZ ? static_cast<uint32_t>(inputRate / ANALYSIS_RATE_HZ + 0.5f) : 1;
+    accumulator_ = 0;
+    accumulated_ = 0;
+    pendingRate_.store(inputRate > 0 ? inputRate / averaging_ : ANALYSIS_RATE_HZ, std::memory_order_release);
+}
+
+void TurbulenceAnalyzer::addSample(float windSpeed) {
+    accumulator_ += windSpeed;
+    if (++accumulated_ < averaging_) {
+        return;
+    }
+    samples_.push(accumulator_ / accumulated_);
+    accumulator_ = 0;
+    accumulated_ = 0;
+}
+
+bool TurbulenceAnalyzer::service(uint32_t nowMs) {
+    TRACE_SCOPE(TraceStage::Analysis);
+    bool analysed = false;
+    float rate = pendingRate_.exchange(0.0f, std::memory_order_acquire);
+    if (rate > 0) {
+        sampleRate_ = rate;
+        historyCount_ = 0;
+        sinceAnalysis_ = 0;
+    }
+    float sample;
+    while (samples_.pop(sample)) {
+        history_[historyCount_ & (FFT_SIZE - 1)] = sample;
+        historyCount_++;
+        sinceAnalysis_++;
+        if (historyCount_ < FFT_SIZE || sinceAnalysis_ < HOP) {
+            continue;
+        }
+        sinceAnalysis_ = 0;
+        TurbulenceResult result;
+        // The oldest sample sits right after the newest one
+        analyze(history_, historyCount_ & (FFT_SIZE - 1), result);
+        result.timestampMs = nowMs;
+        results_.push(result);
+        analysed = true;
+    }
+    return analysed;
+}
+
+void TurbulenceAnalyzer::analyzeBlock(const float* samples, TurbulenceResult& result) {
+    analyze(samples, 0, result);
+    result.timestampMs = clock_.millis();
+}
+
+/**
+ * @brief In-place radix-2 FFT of re_/im_ (HALF points, already in bit-reversed order)
+ */
+void TurbulenceAnalyzer::fft() {
+    for (size_t size = 2; size <= HALF; size <<= 1) {
+        size_t half = size >> 1;
+        size_t step = FFT_SIZE / size;
+        for (size_t start = 0; start < HALF; start += size) {
+            for (size_t j = 0; j < half; j++) {
+                float c = cos_[j * step];
+                float s = sin_[j * step];
+                size_t a = start + j;
+                size_t b = a + half;
+                float tr = c * re_[b] + s * im_[b];
+                float ti = c * im_[b] - s * re_[b];
+                re_[b] = re_[a] - tr;
+                im_[b] = im_[a] - ti;
+                re_[a] += tr;
+                im_[a] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Statistics, detrend, window, FFT and gust peak of one window
+ * @param samples Circular buffer of FFT_SIZE samples
+ * @param start Index of the oldest sample
+ */
+void TurbulenceAnalyzer::analyze(const float* samples, size_t start, TurbulenceResult& result) {
+    uint32_t startUs = clock_.micros();
+    const size_t mask = FFT_SIZE - 1;
+
+    float sum = 0;
+    for (size_t n = 0; n < FFT_SIZE; n++) {
+        sum += samples[(start + n) & mask];
+    }
+    float mean = sum / FFT_SIZE;
+    // Least-squares line through the window: slope from the centred sums
+    const float centre = (FFT_SIZE - 1) * 0.5f;
+    float squares = 0;
+    float moment = 0;
+    for (size_t n = 0; n < FFT_SIZE; n++) {
+        float deviation = samples[(start + n) & mask] - mean;
+        squares += deviation * deviation;
+        moment += (n - centre) * deviation;
+    }
+    float slope = moment / (static_cast<float>(FFT_SIZE) * (FFT_SIZE * FFT_SIZE - 1.0f) / 12.0f);
+    float stddev = sqrtf(squares / FFT_SIZE);
+
+    // Even samples in the real part, odd ones in the imaginary part, loaded in bit-reversed order
+    for (size_t n = 0; n < HALF; n++) {
+        size_t even = 2 * bitReverse_[n];
+        float x0 = samples[(start + even) & mask] - mean - slope * (even - centre);
+        float x1 = samples[(start + even + 1) & mask] - mean - slope * (even + 1 - centre);
+        re_[n] = x0 * window_[even];
+        im_[n] = x1 * window_[even + 1];
+    }
+    fft();
+
+    // Split the half-size transform into the real spectrum, one-sided density
+    float scale = 1.0f / (sampleRate_ * windowEnergy_);
+    power_[0] = (re_[0] + im_[0]) * (re_[0] + im_[0]) * scale;
+    power_[HALF] = (re_[0] - im_[0]) * (re_[0] - im_[0]) * scale;
+    for (size_t k = 1; k < HALF; k++) {
+        float ar = re_[k], ai = im_[k];
+        float br = re_[HALF - k], bi = im_[HALF - k];
+        float evenRe = 0.5f * (ar + br);
+        float evenIm = 0.5f * (ai - bi);
+        float oddRe = 0.5f * (ai + bi);
+        float oddIm = -0.5f * (ar - br);
+        float xr = evenRe + cos_[k] * oddRe + sin_[k] * oddIm;
+        float xi = evenIm + cos_[k] * oddIm - sin_[k] * oddRe;
+        power_[k] = 2.0f * (xr * xr + xi * xi) * scale;
+    }
+
+    result.mean = mean;
+    result.stddev = stddev;
+    result.intensity = 0;
+    result.gustFrequency = 0;
+    result.gustPeriod = 0;
+    if (mean >= MIN_MEAN) {
+        result.intensity = stddev / mean;
+        float width = binWidth();
+        size_t first = static_cast<size_t>(ceilf(MIN_FREQUENCY_HZ / width));
+        size_t last = static_cast<size_t>(MAX_FREQUENCY_HZ / width);
+        first = first < 1 ? 1 : first;
+        last = last > BINS - 2 ? BINS - 2 : last;
+        size_t peak = first;
+        for (size_t k = first + 1; k <= last; k++) {
+            if (power_[k] > power_[peak]) {
+                peak = k;
+            }
+        }
+        if (first <= last && power_[peak] > 0) {
+            // Parabola through the peak and its neighbours
+            float left = power_[peak - 1], centrePower = power_[peak], right = power_[peak + 1];
+            float curvature = left - 2.0f * centrePower + right;
+            float offset = curvature < 0 ? 0.5f * (left - right) / curvature : 0;
+            offset = offset > 0.5f ? 0.5f : (offset < -0.5f ? -0.5f : offset);
+            result.gustFrequency = (peak + offset) * width;
+            result.gustPeriod = 1.0f / result.gustFrequency;
+        }
+    }
+
+    uint32_t elapsedUs = clock_.micros() - startUs;
+    lastAnalysisUs_.store(elapsedUs, std::memory_order_relaxed);
+    if (elapsedUs > maxAnalysisUs_.load(std::memory_order_relaxed)) {
+        maxAnalysisUs_.store(elapsedUs, std::memory_order_relaxed);
+    }
+    analyses_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TurbulenceAnalyzer::takeResult(TurbulenceResult& result) {
+    return results_.pop(result);
+}
+
+const float* TurbulenceAnalyzer::spectrum() const {
+    return power_;
+}
+
+float TurbulenceAnalyzer::sampleRate() const {
+    return sampleRate_;
+}
+
+float TurbulenceAnalyzer::binWidth() const {
+    return sampleRate_ / FFT_SIZE;
+}
+
+uint32_t TurbulenceAnalyzer::analyses() const {
+    return analyses_.load(std::memory_order_relaxed);
+}
+
+uint32_t TurbulenceAnalyzer::overruns() const {
+    return samples_.overruns();
+}
+
+uint32_t TurbulenceAnalyzer::lastAnalysisUs() const {
+    return lastAnalysisUs_.load(std::memory_order_relaxed);
+}
+
+uint32_t TurbulenceAnalyzer::maxAnalysisUs() const {
+    return maxAnalysisUs_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file VirtualClock.cpp
+ * @brief Manually advanced Clock for simulations and benchmarks
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "VirtualClock.h"
+
+VirtualClock::VirtualClock(uint64_t startUs) : nowUs_(startUs) {
+}
+
+uint32_t VirtualClock::millis() {
+    return static_cast<uint32_t>(nowUs_ / 1000);
+}
+
+uint32_t VirtualClock::micros() {
+    return static_cast<uint32_t>(nowUs_);
+}
+
+void VirtualClock::delayMs(uint32_t ms) {
+    nowUs_ += static_cast<uint64_t>(ms) * 1000;
+}
+
+void VirtualClock::delayUs(uint32_t us) {
+    nowUs_ += us;
+}
+
+void VirtualClock::advanceUs(uint64_t us) {
+    nowUs_ += us;
+}
+
+uint64_t VirtualClock::nowUs() const {
+    return nowUs_;
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file WindDirection.cpp
+ * @brief Incremental unit-vector mean of the wind direction
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Vectors are kept as (east, north) components, so the angle of a sum is
+ * atan2(east, north): degrees from north, clockwise, the way a vane reads. As in
+ * WindStatistics, the window sums are kept in double so they do not drift.
+ */
+
+#include "WindDirection.h"
+#include <math.h>
+
+static const float DEGREES_PER_RADIAN = 57.2957795f;
+
+/**
+ * @brief Angle of a vector in degrees from north, 0..360
+ */
+static float vectorDegrees(double east, double north) {
+    float degrees = static_cast<float>(atan2(east, north)) * DEGREES_PER_RADIAN;
+    return degrees < 0.0f ? degrees + 360.0f : degrees;
+}
+
+/**
+ * @brief Construct a new WindDirection object
+ */
+WindDirection::WindDirection() : northCode_(0), codesPerTurn_(32768) {
+    reset();
+}
+
+/**
+ * @brief Map vane codes to degrees
+ */
+void WindDirection::setCalibration(int16_t northCode, int32_t codesPerTurn) {
+    northCode_ = northCode;
+    codesPerTurn_ = codesPerTurn ? codesPerTurn : 32768;
+}
+
+/**
+ * @brief Direction of a vane code
+ */
+float WindDirection::codeToDegrees(int16_t code) const {
+    float degrees = 360.0f * static_cast<float>(code - northCode_) / static_cast<float>(codesPerTurn_);
+    degrees = fmodf(degrees, 360.0f);
+    return degrees < 0.0f ? degrees + 360.0f : degrees;
+}
+
+/**
+ * @brief Forget all history
+ */
+void WindDirection::reset() {
+    started_ = false;
+    tickStartMs_ = 0;
+    tickEast_ = 0.0f;
+    tickNorth_ = 0.0f;
+    tickCount_ = 0;
+    lastEast_ = 0.0f;
+    lastNorth_ = 0.0f;
+    tickIndex_ = 0;
+    currentEastSum_ = 0.0;
+    currentNorthSum_ = 0.0;
+    windowEastSum_ = 0.0;
+    windowNorthSum_ = 0.0;
+}
+
+/**
+ * @brief Add one direction sample
+ */
+void WindDirection::addSample(float degrees, uint32_t timestampMs) {
+    if (!started_) {
+        started_ = true;
+        tickStartMs_ = timestampMs;
+    }
+
+    uint32_t elapsed = timestampMs - tickStartMs_;
+    if (elapsed >= WINDOW_MS) {
+        // Longer gap than the whole window: nothing worth keeping
+        reset();
+        started_ = true;
+        tickStartMs_ = timestampMs;
+    } else {
+        while (timestampMs - tickStartMs_ >= TICK_MS) {
+            closeTick();
+            tickStartMs_ += TICK_MS;
+        }
+    }
+
+    float radians = degrees / DEGREES_PER_RADIAN;
+    tickEast_ += sinf(radians);
+    tickNorth_ += cosf(radians);
+    tickCount_++;
+}
+
+void WindDirection::addCode(int16_t code, uint32_t timestampMs) {
+    addSample(codeToDegrees(code), timestampMs);
+}
+
+/**
+ * @brief Close the current tick and update both windows
+ */
+void WindDirection::closeTick() {
+    if (tickCount_ > 0) {
+        lastEast_ = tickEast_ / tickCount_;
+        lastNorth_ = tickNorth_ / tickCount_;
+    }
+    // else no sample in this tick: hold the previous vector
+
+    uint32_t index = tickIndex_++;
+
+    size_t currentSlot = index % CURRENT_TICKS;
+    if (index >= CURRENT_TICKS) {
+        currentEastSum_ -= currentEast_[currentSlot];
+        currentNorthSum_ -= currentNorth_[currentSlot];
+    }
+    currentEast_[currentSlot] = lastEast_;
+    currentNorth_[currentSlot] = lastNorth_;
+    currentEastSum_ += lastEast_;
+    currentNorthSum_ += lastNorth_;
+
+    size_t windowSlot = index % WINDOW_TICKS;
+    if (index >= WINDOW_TICKS) {
+        windowEastSum_ -= windowEast_[windowSlot];
+        windowNorthSum_ -= windowNorth_[windowSlot];
+    }
+    windowEast_[windowSlot] = lastEast_;
+    windowNorth_[windowSlot] = lastNorth_;
+    windowEastSum_ += lastEast_;
+    windowNorthSum_ += lastNorth_;
+
+    tickEast_ = 0.0f;
+    tickNorth_ = 0.0f;
+    tickCount_ = 0;
+}
+
+/**
+ * @brief Current statistics
+ */
+DirectionStats WindDirection::get() const {
+    DirectionStats stats = {};
+    if (tickIndex_ == 0) {
+        return stats;
+    }
+    uint32_t windowTicks = tickIndex_ < WINDOW_TICKS ? tickIndex_ : WINDOW_TICKS;
+
+    stats.current = vectorDegrees(currentEastSum_, currentNorthSum_);
+    stats.mean = vectorDegrees(windowEastSum_, windowNorthSum_);
+    stats.steadiness = static_cast<float>(sqrt(windowEastSum_ * windowEastSum_ + windowNorthSum_ * windowNorthSum_) /
+                                          windowTicks);
+    stats.ticks = windowTicks;
+    return stats;
+}
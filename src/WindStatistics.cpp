@@ -0,0 +1,154 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file WindStatistics.cpp
+ * @brief Rolling gust, lull, mean and min/max wind statistics
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Definitions follow WMO practice: the gust (lull) is the highest (lowest) 3 s
+ * running mean over the 10 min reporting window, and the mean wind is the plain
+ * 10 min average. The window sums are kept in double so that they do not drift
+ * over days of uptime.
+ */
+
+#include "WindStatistics.h"
+
+/**
+ * @brief Construct a new WindStatistics object
+ */
+WindStatistics::WindStatistics() {
+    reset();
+}
+
+/**
+ * @brief Forget all history
+ */
+void WindStatistics::reset() {
+    started_ = false;
+    tickStartMs_ = 0;
+    tickSum_ = 0.0f;
+    tickCount_ = 0;
+    tickMin_ = 0.0f;
+    tickMax_ = 0.0f;
+    lastTickMean_ = 0.0f;
+    tickIndex_ = 0;
+    gustSum_ = 0.0;
+    windowSum_ = 0.0;
+    gustMax_.clear();
+    lullMin_.clear();
+    sampleMax_.clear();
+    sampleMin_.clear();
+}
+
+/**
+ * @brief Add one wind speed sample
+ */
+void WindStatistics::addSample(float windSpeed, uint32_t timestampMs) {
+    if (!started_) {
+        started_ = true;
+        tickStartMs_ = timestampMs;
+    }
+
+    uint32_t elapsed = timestampMs - tickStartMs_;
+    if (elapsed >= WINDOW_MS) {
+        // Longer gap than the whole window: nothing worth keeping
+        reset();
+        started_ = true;
+        tickStartMs_ = timestampMs;
+    } else {
+        while (timestampMs - tickStartMs_ >= TICK_MS) {
+            closeTick();
+            tickStartMs_ += TICK_MS;
+        }
+    }
+
+    if (tickCount_ == 0) {
+        tickMin_ = windSpeed;
+        tickMax_ = windSpeed;
+    } else {
+        if (windSpeed < tickMin_) tickMin_ = windSpeed;
+        if (windSpeed > tickMax_) tickMax_ = windSpeed;
+    }
+    tickSum_ += windSpeed;
+    tickCount_++;
+}
+
+/**
+ * @brief Close the current tick and update every window
+ */
+void WindStatistics::closeTick() {
+    float mean;
+    if (tickCount_ > 0) {
+        mean = tickSum_ / tickCount_;
+    } else {
+        // No sample in this tick: hold the previous value
+        mean = lastTickMean_;
+        tickMin_ = mean;
+        tickMax_ = mean;
+    }
+    lastTickMean_ = mean;
+
+    uint32_t index = tickIndex_++;
+
+    // 3 s running mean
+    size_t gustSlot = index % GUST_TICKS;
+    if (index >= GUST_TICKS) {
+        gustSum_ -= gustRing_[gustSlot];
+    }
+    gustRing_[gustSlot] = mean;
+    gustSum_ += mean;
+    size_t gustCount = index + 1 < GUST_TICKS ? index + 1 : GUST_TICKS;
+    float gustMean = static_cast<float>(gustSum_ / gustCount);
+
+    // 10 min running mean
+    size_t windowSlot = index % WINDOW_TICKS;
+    if (index >= WINDOW_TICKS) {
+        windowSum_ -= windowRing_[windowSlot];
+    }
+    windowRing_[windowSlot] = mean;
+    windowSum_ += mean;
+
+    // Sliding extrema
+    gustMax_.push(index, gustMean, WINDOW_TICKS);
+    lullMin_.push(index, gustMean, WINDOW_TICKS);
+    sampleMax_.push(index, tickMax_, WINDOW_TICKS);
+    sampleMin_.push(index, tickMin_, WINDOW_TICKS);
+
+    tickSum_ = 0.0f;
+    tickCount_ = 0;
+}
+
+/**
+ * @brief Current statistics
+ */
+WindStats WindStatistics::get() const {
+    WindStats stats = {};
+    if (tickIndex_ == 0) {
+        return stats;
+    }
+    uint32_t windowTicks = tickIndex_ < WINDOW_TICKS ? tickIndex_ : WINDOW_TICKS;
+    size_t gustCount = tickIndex_ < GUST_TICKS ? tickIndex_ : GUST_TICKS;
+
+    stats.current = static_cast<float>(gustSum_ / gustCount);
+    stats.gust = gustMax_.value();
+    stats.lull = lullMin_.value();
+    stats.mean = static_cast<float>(windowSum_ / windowTicks);
+    stats.min = sampleMin_.value();
+    stats.max = sampleMax_.value();
+    stats.ticks = windowTicks;
+    return stats;
+}
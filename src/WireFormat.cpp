@@ -0,0 +1,443 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file WireFormat.cpp
+ * @brief Encoder/decoder for the versioned ESP-NOW frame format
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * All multi-byte values are written byte by byte in little-endian order, so the
+ * result does not depend on the compiler, its padding or the host endianness.
+ * Speeds are carried in 0.01 m/s units, clamped to [0, 655.35] m/s.
+ */
+
+#include "WireFormat.h"
+#include "ByteOrder.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace WireFormat {
+
+using namespace ByteOrder;
+
+// Legacy v1 layout (ESP32, GCC): padded struct with a 4-byte unsigned long
+static const size_t LEGACY_MAC_OFFSET = 19;
+static const size_t LEGACY_SEQUENCE_OFFSET = 28;
+static const size_t LEGACY_SPEED_OFFSET = 32;
+
+/**
+ * @brief m/s to 0.01 m/s, rounded and clamped to the uint16 range
+ */
+static uint16_t toCentimetres(float speed) {
+    if (!(speed > 0.0f)) {
+        return 0;
+    }
+    float scaled = speed * 100.0f + 0.5f;
+    return scaled >= 65535.0f ? 65535 : static_cast<uint16_t>(scaled);
+}
+
+static float fromCentimetres(uint16_t value) {
+    return value / 100.0f;
+}
+
+/**
+ * @brief Scale a non-negative value to a uint16, rounded and clamped
+ */
+static uint16_t toScaled(float value, float scale) {
+    if (!(value > 0.0f)) {
+        return 0;
+    }
+    float scaled = value * scale + 0.5f;
+    return scaled >= 65535.0f ? 65535 : static_cast<uint16_t>(scaled);
+}
+
+uint8_t frameType(const uint8_t* frame, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    // Legacy frames start with the message type itself
+    return (frame[0] >> 4) ? (frame[0] >> 4) : frame[0];
+}
+
+size_t encodeAnemometer(const AnemometerData& data, uint8_t* out, size_t capacity) {
+    size_t length = HEADER_SIZE;
+    if (data.fields & FIELD_STATS) {
+        length += 6;
+    }
+    if (data.fields & FIELD_TURBULENCE) {
+        length += 4;
+    }
+    if (data.fields & FIELD_TIME) {
+        length += 6;
+    }
+    if (capacity < length) {
+        return 0;
+    }
+
+    out[0] = makeHeader(MSG_ANEMOMETER, VERSION);
+    memcpy(out + 1, data.macAddress, 6);
+    put16(out + 7, data.sequenceNumber);
+    put16(out + 9, toCentimetres(data.windSpeed));
+    out[11] = data.fields & (FIELD_STATS | FIELD_TURBULENCE | FIELD_TIME | FIELD_NO_SENSOR);
+
+    uint8_t* p = out + HEADER_SIZE;
+    if (data.fields & FIELD_STATS) {
+        put16(p, toCentimetres(data.windGust));
+        put16(p + 2, toCentimetres(data.windLull));
+        put16(p + 4, toCentimetres(data.windMean));
+        p += 6;
+    }
+    if (data.fields & FIELD_TURBULENCE) {
+        put16(p, toScaled(data.turbulenceIntensity, 1000.0f));
+        put16(p + 2, toScaled(data.gustFrequency, 1000.0f));
+        p += 4;
+    }
+    if (data.fields & FIELD_TIME) {
+        put32(p, data.timestampUs);
+        put16(p + 4, data.timeErrorUs);
+        p += 6;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+/**
+ * @brief Decode the raw AnemometerData struct sent by firmware 1.0.x
+ */
+static bool decodeLegacy(const uint8_t* frame, size_t length, AnemometerData& data) {
+    if (length != LEGACY_V1_SIZE) {
+        return false;
+    }
+    memset(&data, 0, sizeof(data));
+    data.version = 1;
+    memcpy(data.macAddress, frame + LEGACY_MAC_OFFSET, 6);
+    data.sequenceNumber = static_cast<uint16_t>(get32(frame + LEGACY_SEQUENCE_OFFSET));
+    data.windSpeed = getFloat(frame + LEGACY_SPEED_OFFSET);
+    return true;
+}
+
+bool decodeAnemometer(const uint8_t* frame, size_t length, AnemometerData& data) {
+    if (length == 0 || frameType(frame, length) != MSG_ANEMOMETER) {
+        return false;
+    }
+    if ((frame[0] >> 4) == 0) {
+        return decodeLegacy(frame, length, data);
+    }
+    if (length < HEADER_SIZE || (frame[0] & 0x0F) < 2) {
+        return false;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.version = frame[0] & 0x0F;
+    memcpy(data.macAddress, frame + 1, 6);
+    data.sequenceNumber = get16(frame + 7);
+    data.windSpeed = fromCentimetres(get16(frame + 9));
+    uint8_t fields = frame[11];
+    data.fields = fields & FIELD_NO_SENSOR;
+
+    // Fields are parsed in bit order; unknown higher bits (newer versions) are ignored
+    const uint8_t* p = frame + HEADER_SIZE;
+    const uint8_t* end = frame + length;
+    if (fields & FIELD_STATS) {
+        if (end - p < 6) {
+            return false;
+        }
+        data.windGust = fromCentimetres(get16(p));
+        data.windLull = fromCentimetres(get16(p + 2));
+        data.windMean = fromCentimetres(get16(p + 4));
+        data.fields |= FIELD_STATS;
+        p += 6;
+    }
+    if (fields & FIELD_TURBULENCE) {
+        if (end - p < 4) {
+            return false;
+        }
+        data.turbulenceIntensity = get16(p) / 1000.0f;
+        data.gustFrequency = get16(p + 2) / 1000.0f;
+        data.fields |= FIELD_TURBULENCE;
+        p += 4;
+    }
+    if (fields & FIELD_TIME) {
+        if (end - p < 6) {
+            return false;
+        }
+        data.timestampUs = get32(p);
+        data.timeErrorUs = get16(p + 4);
+        data.fields |= FIELD_TIME;
+        p += 6;
+    }
+    return true;
+}
+
+size_t encodeDiagnostics(const DiagnosticsData& data, uint8_t* out, size_t capacity) {
+    size_t length = DIAGNOSTICS_HEADER_SIZE + data.count * DIAGNOSTICS_ENTRY_SIZE;
+    if (data.count > MAX_DIAGNOSTICS_ENTRIES || capacity < length) {
+        return 0;
+    }
+    out[0] = makeHeader(MSG_DIAGNOSTICS, VERSION);
+    memcpy(out + 1, data.macAddress, 6);
+    put16(out + 7, data.cyclesPerUs);
+    out[9] = data.count;
+    uint8_t* p = out + DIAGNOSTICS_HEADER_SIZE;
+    for (uint8_t i = 0; i < data.count; i++, p += DIAGNOSTICS_ENTRY_SIZE) {
+        const DiagnosticsEntry& entry = data.entries[i];
+        p[0] = entry.stage;
+        put16(p + 1, entry.calls);
+        p[3] = entry.p99Bucket;
+        put32(p + 4, entry.averageCycles);
+        put32(p + 8, entry.maxCycles);
+    }
+    return length;
+}
+
+bool decodeDiagnostics(const uint8_t* frame, size_t length, DiagnosticsData& data) {
+    if (length < DIAGNOSTICS_HEADER_SIZE || (frame[0] >> 4) != MSG_DIAGNOSTICS) {
+        return false;
+    }
+    uint8_t count = frame[9];
+    if (count > MAX_DIAGNOSTICS_ENTRIES || length < DIAGNOSTICS_HEADER_SIZE + count * DIAGNOSTICS_ENTRY_SIZE) {
+        return false;
+    }
+    memset(&data, 0, sizeof(data));
+    memcpy(data.macAddress, frame + 1, 6);
+    data.cyclesPerUs = get16(frame + 7);
+    data.count = count;
+    const uint8_t* p = frame + DIAGNOSTICS_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++, p += DIAGNOSTICS_ENTRY_SIZE) {
+        DiagnosticsEntry& entry = data.entries[i];
+        entry.stage = p[0];
+        entry.calls = get16(p + 1);
+        entry.p99Bucket = p[3];
+        entry.averageCycles = get32(p + 4);
+        entry.maxCycles = get32(p + 8);
+    }
+    return true;
+}
+
+size_t encodeTimeBeacon(const TimeBeacon& beacon, uint8_t* out, size_t capacity) {
+    if (capacity < TIME_BEACON_SIZE) {
+        return 0;
+    }
+    out[0] = makeHeader(MSG_TIME, VERSION);
+    memcpy(out + 1, beacon.macAddress, 6);
+    put16(out + 7, beacon.sequence);
+    out[9] = beacon.hasPrevious ? 0x01 : 0x00;
+    put32(out + 10, beacon.previousAirUs);
+    return TIME_BEACON_SIZE;
+}
+
+bool decodeTimeBeacon(const uint8_t* frame, size_t length, TimeBeacon& beacon) {
+    if (length < TIME_BEACON_SIZE || (frame[0] >> 4) != MSG_TIME) {
+        return false;
+    }
+    memcpy(beacon.macAddress, frame + 1, 6);
+    beacon.sequence = get16(frame + 7);
+    beacon.hasPrevious = (frame[9] & 0x01) != 0;
+    beacon.previousAirUs = get32(frame + 10);
+    return true;
+}
+
+size_t encodeSummary(const SessionSummary& summary, uint8_t* out, size_t capacity) {
+    size_t length = SUMMARY_HEADER_SIZE + 2 * static_cast<size_t>(summary.binCount);
+    if (summary.binCount > MAX_SUMMARY_BINS || capacity < length) {
+        return 0;
+    }
+    out[0] = makeHeader(MSG_SUMMARY, VERSION);
+    memcpy(out + 1, summary.macAddress, 6);
+    put32(out + 7, summary.samples);
+    put32(out + 11, summary.durationS);
+    put16(out + 15, toCentimetres(summary.mean));
+    put16(out + 17, toCentimetres(summary.stddev));
+    put16(out + 19, toCentimetres(summary.min));
+    put16(out + 21, toCentimetres(summary.max));
+    put16(out + 23, toCentimetres(summary.p50));
+    put16(out + 25, toCentimetres(summary.p90));
+    put16(out + 27, toCentimetres(summary.p99));
+    put16(out + 29, toScaled(summary.weibullK, 1000.0f));
+    put16(out + 31, toCentimetres(summary.weibullC));
+    float binWidth = summary.binWidth * 10.0f + 0.5f;
+    out[33] = binWidth >= 255.0f ? 255 : (binWidth < 1.0f ? 1 : static_cast<uint8_t>(binWidth));
+    out[34] = summary.binCount;
+    for (size_t i = 0; i < summary.binCount; i++) {
+        float fraction = summary.histogram[i] > 1.0f ? 1.0f : summary.histogram[i];
+        put16(out + SUMMARY_HEADER_SIZE + 2 * i, toScaled(fraction, 65535.0f));
+    }
+    return length;
+}
+
+bool decodeSummary(const uint8_t* frame, size_t length, SessionSummary& summary) {
+    if (length < SUMMARY_HEADER_SIZE || (frame[0] >> 4) != MSG_SUMMARY) {
+        return false;
+    }
+    uint8_t binCount = frame[34];
+    if (binCount > MAX_SUMMARY_BINS || length < SUMMARY_HEADER_SIZE + 2 * static_cast<size_t>(binCount)) {
+        return false;
+    }
+    memset(&summary, 0, sizeof(summary));
+    memcpy(summary.macAddress, frame + 1, 6);
+    summary.samples = get32(frame + 7);
+    summary.durationS = get32(frame + 11);
+    summary.mean = fromCentimetres(get16(frame + 15));
+    summary.stddev = fromCentimetres(get16(frame + 17));
+    summary.min = fromCentimetres(get16(frame + 19));
+    summary.max = fromCentimetres(get16(frame + 21));
+    summary.p50 = fromCentimetres(get16(frame + 23));
+    summary.p90 = fromCentimetres(get16(frame + 25));
+    summary.p99 = fromCentimetres(get16(frame + 27));
+    summary.weibullK = get16(frame + 29) / 1000.0f;
+    summary.weibullC = fromCentimetres(get16(frame + 31));
+    summary.binWidth = frame[33] / 10.0f;
+    summary.binCount = binCount;
+    for (size_t i = 0; i < binCount; i++) {
+        summary.histogram[i] = get16(frame + SUMMARY_HEADER_SIZE + 2 * i) / 65535.0f;
+    }
+    return true;
+}
+
+size_t encodeSummaryRequest(const SummaryRequest& request, uint8_t* out, size_t capacity) {
+    if (capacity < SUMMARY_REQUEST_SIZE) {
+        return 0;
+    }
+    out[0] = makeHeader(MSG_SUMMARY_REQUEST, VERSION);
+    memcpy(out + 1, request.target, 6);
+    return SUMMARY_REQUEST_SIZE;
+}
+
+bool decodeSummaryRequest(const uint8_t* frame, size_t length, SummaryRequest& request) {
+    if (length < SUMMARY_REQUEST_SIZE || (frame[0] >> 4) != MSG_SUMMARY_REQUEST) {
+        return false;
+    }
+    memcpy(request.target, frame + 1, 6);
+    return true;
+}
+
+size_t encodeControl(uint8_t type, const ControlMessage& message, const uint8_t key[CONTROL_KEY_SIZE], uint8_t* out,
+                     size_t capacity) {
+    size_t signedLength = CONTROL_HEADER_SIZE + message.length;
+    if (message.length > MAX_CONTROL_PAYLOAD || capacity < signedLength + CONTROL_TAG_SIZE) {
+        return 0;
+    }
+    out[0] = makeHeader(type, VERSION);
+    memcpy(out + 1, message.macAddress, 6);
+    put32(out + 7, message.counter);
+    out[11] = message.command;
+    out[12] = message.status;
+    out[13] = message.length;
+    memcpy(out + CONTROL_HEADER_SIZE, message.payload, message.length);
+    uint64_t tag = SipHash::hash(key, out, signedLength);
+    put32(out + signedLength, static_cast<uint32_t>(tag));
+    put32(out + signedLength + 4, static_cast<uint32_t>(tag >> 32));
+    return signedLength + CONTROL_TAG_SIZE;
+}
+
+bool decodeControl(const uint8_t* frame, size_t length, const uint8_t key[CONTROL_KEY_SIZE], ControlMessage& message) {
+    uint8_t type = length > 0 ? frame[0] >> 4 : 0;
+    if (length < CONTROL_HEADER_SIZE + CONTROL_TAG_SIZE || (type != MSG_CONTROL && type != MSG_CONTROL_REPLY)) {
+        return false;
+    }
+    size_t signedLength = CONTROL_HEADER_SIZE + frame[13];
+    if (frame[13] > MAX_CONTROL_PAYLOAD || length != signedLength + CONTROL_TAG_SIZE) {
+        return false;
+    }
+    uint64_t tag = SipHash::hash(key, frame, signedLength);
+    uint8_t expected[CONTROL_TAG_SIZE];
+    put32(expected, static_cast<uint32_t>(tag));
+    put32(expected + 4, static_cast<uint32_t>(tag >> 32));
+    uint8_t difference = 0;
+    for (size_t i = 0; i < CONTROL_TAG_SIZE; i++) {
+        difference |= expected[i] ^ frame[signedLength + i]; // Same time whatever byte differs
+    }
+    if (difference != 0) {
+        return false;
+    }
+    memset(&message, 0, sizeof(message));
+    memcpy(message.macAddress, frame + 1, 6);
+    message.counter = get32(frame + 7);
+    message.command = frame[11];
+    message.status = frame[12];
+    message.length = frame[13];
+    memcpy(message.payload, frame + CONTROL_HEADER_SIZE, message.length);
+    return true;
+}
+
+size_t encodeSettings(const DeviceSettings& settings, uint8_t* out, size_t capacity) {
+    if (capacity < SETTINGS_SIZE) {
+        return 0;
+    }
+    put16(out, settings.sampleRate);
+    out[2] = settings.medianSize;
+    out[3] = settings.decimation;
+    out[4] = settings.cicOrder;
+    out[5] = settings.smoothingShift;
+    put16(out + 6, toCentimetres(settings.speedDeadband));
+    put16(out + 8, toCentimetres(settings.gustDeadband));
+    put32(out + 10, settings.minIntervalMs);
+    put32(out + 14, settings.rampStartMs);
+    put32(out + 18, settings.heartbeatMs);
+    put32(out + 22, settings.fixedIntervalMs);
+    out[26] = settings.logLevel;
+    return SETTINGS_SIZE;
+}
+
+bool decodeSettings(const uint8_t* data, size_t length, DeviceSettings& settings) {
+    if (length < SETTINGS_SIZE) {
+        return false;
+    }
+    settings.sampleRate = get16(data);
+    settings.medianSize = data[2];
+    settings.decimation = data[3];
+    settings.cicOrder = data[4];
+    settings.smoothingShift = data[5];
+    settings.speedDeadband = fromCentimetres(get16(data + 6));
+    settings.gustDeadband = fromCentimetres(get16(data + 8));
+    settings.minIntervalMs = get32(data + 10);
+    settings.rampStartMs = get32(data + 14);
+    settings.heartbeatMs = get32(data + 18);
+    settings.fixedIntervalMs = get32(data + 22);
+    settings.logLevel = data[26];
+    return true;
+}
+
+size_t encodeStats(const DeviceStats& stats, uint8_t* out, size_t capacity) {
+    if (capacity < STATS_SIZE) {
+        return 0;
+    }
+    const uint32_t values[] = {stats.uptimeS,     stats.samples,     stats.overruns,
+                               stats.spikes,      stats.framesSent,  stats.radioQueued,
+                               stats.radioFailed, stats.commands,    stats.rejected};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        put32(out + 4 * i, values[i]);
+    }
+    return STATS_SIZE;
+}
+
+bool decodeStats(const uint8_t* data, size_t length, DeviceStats& stats) {
+    if (length < STATS_SIZE) {
+        return false;
+    }
+    uint32_t* values[] = {&stats.uptimeS,     &stats.samples,     &stats.overruns,
+                          &stats.spikes,      &stats.framesSent,  &stats.radioQueued,
+                          &stats.radioFailed, &stats.commands,    &stats.rejected};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        *values[i] = get32(data + 4 * i);
+    }
+    return true;
+}
+
+void formatMacAddress(const uint8_t mac[6], char out[18]) {
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+} // namespace WireFormat
@@ -0,0 +1,230 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Ads1115Source.cpp
+ * @brief ADS1115 (M5Stack Unit VMeter) implementation of AdcSource
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Hardware configuration:
+ * - I2C communication on Wire1 (pins 2, 1) at 400kHz
+ * - ADS1115 PGA gain set to 2048 (max 32V input)
+ * - Single-shot or continuous conversion, 8 to 860 SPS
+ * - Optional ALERT/RDY conversion-ready pulse (comparator registers)
+ * - Multiplexer inputs, one single-shot conversion at a time: MUX codes 0-3 are the
+ *   differential pairs (0 = AIN0-AIN1, the VMeter input), 4-7 AIN0-AIN3 against GND
+ */
+
+#include "Ads1115Source.h"
+
+// VMeter Management
+#define M5_UNIT_VMETER_I2C_ADDR             0x49
+#define M5_UNIT_VMETER_EEPROM_I2C_ADDR      0x53
+#define M5_UNIT_VMETER_PRESSURE_COEFFICIENT 0.015918958F
+
+// ADS1115 register map
+#define ADS1115_REG_CONVERSION 0x00
+#define ADS1115_REG_CONFIG     0x01
+#define ADS1115_REG_LO_THRESH  0x02
+#define ADS1115_REG_HI_THRESH  0x03
+#define ADS1115_COMP_QUE_MASK  0x0003  // 11 = comparator disabled, 00 = assert after one conversion
+#define ADS1115_OS_START       0x8000  // Write: start a single-shot conversion
+#define ADS1115_MUX_MASK       0x7000
+#define ADS1115_MUX_SHIFT      12
+#define ADS1115_MUX_INPUTS     8
+
+/**
+ * @brief Construct a new Ads1115Source object
+ */
+Ads1115Source::Ads1115Source(TwoWire& wire, uint8_t sdaPin, uint8_t sclPin)
+    : voltmeter_(), wire_(&wire), address_(M5_UNIT_VMETER_I2C_ADDR), sdaPin_(sdaPin), sclPin_(sclPin),
+      sampleRate_(8), resolution_(0.0f), calibration_factor_(0.0f), singleShotConfig_(0) {}
+
+/**
+ * @brief Initialize the VMeter and read its factory calibration, unless it is cached
+ */
+bool Ads1115Source::begin() {
+    if (!voltmeter_.begin(wire_, address_, sdaPin_, sclPin_, 400000U)) {
+        return false;
+    }
+    voltmeter_.setEEPROMAddr(M5_UNIT_VMETER_EEPROM_I2C_ADDR);
+    voltmeter_.setGain(ADS1115_PGA_2048);
+    // | PGA      | Max Input Voltage(V) |
+    // | PGA_6144 |        128           |
+    // | PGA_4096 |        64            |
+    // | PGA_2048 |        32            |
+    // | PGA_512  |        16            |
+    // | PGA_256  |        8             |
+
+    if (resolution_ <= 0.0f || calibration_factor_ <= 0.0f) {
+        resolution_ = voltmeter_.getCoefficient() / M5_UNIT_VMETER_PRESSURE_COEFFICIENT;
+        calibration_factor_ = voltmeter_.getFactoryCalibration();
+    }
+    return true;
+}
+
+bool Ads1115Source::getCalibration(AdcCalibration& calibration) const {
+    if (resolution_ <= 0.0f || calibration_factor_ <= 0.0f) {
+        return false;
+    }
+    calibration.resolution = resolution_;
+    calibration.factor = calibration_factor_;
+    return true;
+}
+
+void Ads1115Source::setCalibration(const AdcCalibration& calibration) {
+    resolution_ = calibration.resolution;
+    calibration_factor_ = calibration.factor;
+}
+
+/**
+ * @brief Map a requested rate to a supported ADS1115 rate
+ */
+uint16_t Ads1115Source::selectRate(uint16_t samplesPerSecond, ads1115_rate_t& rate) {
+    static const uint16_t RATES[] = {8, 16, 32, 64, 128, 250, 475, 860};
+    static const ads1115_rate_t CODES[] = {ADS1115_RATE_8,   ADS1115_RATE_16,  ADS1115_RATE_32,
+                                           ADS1115_RATE_64,  ADS1115_RATE_128, ADS1115_RATE_250,
+                                           ADS1115_RATE_475, ADS1115_RATE_860};
+    int i = 0;
+    while (i < 7 && RATES[i] < samplesPerSecond) {
+        i++;
+    }
+    rate = CODES[i];
+    return RATES[i];
+}
+
+/**
+ * @brief Switch to single-shot mode and keep the config register for startConversion()
+ */
+bool Ads1115Source::startSingleShot(uint16_t samplesPerSecond) {
+    ads1115_rate_t rate;
+    sampleRate_ = selectRate(samplesPerSecond, rate);
+    uint16_t config;
+    if (!voltmeter_.setMode(ADS1115_MODE_SINGLESHOT) || !voltmeter_.setRate(rate) ||
+        !readRegister(ADS1115_REG_CONFIG, config)) {
+        return false;
+    }
+    singleShotConfig_ = config & ~(ADS1115_OS_START | ADS1115_MUX_MASK);
+    return true;
+}
+
+/**
+ * @brief Switch to continuous-conversion mode
+ */
+bool Ads1115Source::startContinuous(uint16_t samplesPerSecond) {
+    ads1115_rate_t rate;
+    sampleRate_ = selectRate(samplesPerSecond, rate);
+    return voltmeter_.setRate(rate) && voltmeter_.setMode(ADS1115_MODE_CONTINUOUS);
+}
+
+/**
+ * @brief Run one blocking single-shot conversion
+ */
+int16_t Ads1115Source::readSingle() {
+    return voltmeter_.getSingleConversion();
+}
+
+/**
+ * @brief Read the conversion register
+ */
+bool Ads1115Source::readConversion(int16_t& code) {
+    uint16_t value;
+    if (!readRegister(ADS1115_REG_CONVERSION, value)) {
+        return false;
+    }
+    code = static_cast<int16_t>(value);
+    return true;
+}
+
+uint8_t Ads1115Source::inputCount() const {
+    return ADS1115_MUX_INPUTS;
+}
+
+/**
+ * @brief Select a multiplexer input and start a conversion: one register write
+ *
+ * The conversion register keeps the previous result until this conversion ends.
+ */
+bool Ads1115Source::startConversion(uint8_t input) {
+    if (input >= ADS1115_MUX_INPUTS || singleShotConfig_ == 0) {
+        return false;   // Not in single-shot mode (MODE bit clear)
+    }
+    uint16_t mux = static_cast<uint16_t>(input) << ADS1115_MUX_SHIFT;
+    return writeRegister(ADS1115_REG_CONFIG, singleShotConfig_ | mux | ADS1115_OS_START);
+}
+
+bool Ads1115Source::readResult(int16_t& code) {
+    return readConversion(code);
+}
+
+/**
+ * @brief Current data rate
+ */
+uint16_t Ads1115Source::sampleRate() const {
+    return sampleRate_;
+}
+
+/**
+ * @brief Millivolts per code, factory calibration included
+ */
+float Ads1115Source::millivoltsPerCode() const {
+    return resolution_ * calibration_factor_;
+}
+
+/**
+ * @brief Program the comparator as a conversion-ready signal
+ *
+ * Hi_thresh MSB = 1 and Lo_thresh MSB = 0 turn ALERT/RDY into a pulse at the end
+ * of every conversion, provided COMP_QUE is not "disabled".
+ */
+bool Ads1115Source::enableConversionReadyPin() {
+    uint16_t config;
+    if (!writeRegister(ADS1115_REG_HI_THRESH, 0x8000) || !writeRegister(ADS1115_REG_LO_THRESH, 0x0000) ||
+        !readRegister(ADS1115_REG_CONFIG, config)) {
+        return false;
+    }
+    config &= ~ADS1115_COMP_QUE_MASK;
+    return writeRegister(ADS1115_REG_CONFIG, config);
+}
+
+/**
+ * @brief Write a 16-bit register (MSB first)
+ */
+bool Ads1115Source::writeRegister(uint8_t reg, uint16_t value) {
+    wire_->beginTransmission(address_);
+    wire_->write(reg);
+    wire_->write(static_cast<uint8_t>(value >> 8));
+    wire_->write(static_cast<uint8_t>(value & 0xFF));
+    return wire_->endTransmission() == 0;
+}
+
+/**
+ * @brief Read a 16-bit register (MSB first)
+ */
+bool Ads1115Source::readRegister(uint8_t reg, uint16_t& value) {
+    wire_->beginTransmission(address_);
+    wire_->write(reg);
+    if (wire_->endTransmission(false) != 0) {
+        return false;
+    }
+    if (wire_->requestFrom(address_, static_cast<uint8_t>(2)) != 2) {
+        return false;
+    }
+    uint8_t msb = wire_->read();
+    uint8_t lsb = wire_->read();
+    value = (static_cast<uint16_t>(msb) << 8) | lsb;
+    return true;
+}
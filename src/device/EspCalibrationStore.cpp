@@ -0,0 +1,99 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file EspCalibrationStore.cpp
+ * @brief Factory calibration cache in RTC memory and NVS
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "EspCalibrationStore.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <stddef.h>
+#include <string.h>
+#include "RecordingFormat.h"
+
+static const uint32_t CALIBRATION_MAGIC = 0x4C414341; // "ACAL"
+
+/**
+ * @brief Cached calibration as stored, with its integrity check
+ */
+struct CalibrationRecord {
+    uint32_t magic;
+    AdcCalibration calibration;
+    uint32_t crc;   // CRC-32 of the fields above
+};
+
+// Not cleared at boot: kept across deep sleep and soft resets
+static RTC_NOINIT_ATTR CalibrationRecord retained;
+
+static uint32_t recordCrc(const CalibrationRecord& record) {
+    return RecordingFormat::crc32(reinterpret_cast<const uint8_t*>(&record), offsetof(CalibrationRecord, crc));
+}
+
+static bool valid(const CalibrationRecord& record) {
+    return record.magic == CALIBRATION_MAGIC && record.crc == recordCrc(record) &&
+           record.calibration.resolution > 0.0f && record.calibration.factor > 0.0f;
+}
+
+static CalibrationRecord makeRecord(const AdcCalibration& calibration) {
+    CalibrationRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = CALIBRATION_MAGIC;
+    record.calibration = calibration;
+    record.crc = recordCrc(record);
+    return record;
+}
+
+bool EspCalibrationStore::load(AdcCalibration& calibration, CalibrationSource& source) {
+    if (valid(retained)) {
+        calibration = retained.calibration;
+        source = CalibrationSource::Retained;
+        return true;
+    }
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, true)) {
+        return false; // Namespace not created yet: first boot
+    }
+    CalibrationRecord record;
+    bool found = preferences.getBytes(KEY, &record, sizeof(record)) == sizeof(record) && valid(record);
+    preferences.end();
+    if (!found) {
+        return false;
+    }
+    retained = record;
+    calibration = record.calibration;
+    source = CalibrationSource::Flash;
+    return true;
+}
+
+bool EspCalibrationStore::save(const AdcCalibration& calibration) {
+    CalibrationRecord record = makeRecord(calibration);
+    retained = record;
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, false)) {
+        return false;
+    }
+    CalibrationRecord stored;
+    bool written = preferences.getBytes(KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+                   memcmp(&stored, &record, sizeof(record)) == 0;
+    if (!written) {
+        written = preferences.putBytes(KEY, &record, sizeof(record)) == sizeof(record);
+    }
+    preferences.end();
+    return written;
+}
@@ -0,0 +1,127 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/**
+ * @file EspNowTransport.cpp
+ * @brief ESP-NOW implementation of RadioTransport
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * - WiFi station mode at maximum transmission power (19.5 dBm)
+ * - ESP-NOW initialized once, broadcast peer registered once; unicast peers on first use
+ * - Send completions and received frames are passed to the registered handlers
+ *   from the WiFi task
+ */
+
+#include "EspNowTransport.h"
+
+static const uint8_t BROADCAST_ADDRESS[RadioTransport::MAC_SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+RadioTransport::ReceiveHandler EspNowTransport::receiveHandler_ = nullptr;
+void* EspNowTransport::receiveContext_ = nullptr;
+RadioTransport::SendHandler EspNowTransport::sendHandler_ = nullptr;
+void* EspNowTransport::sendContext_ = nullptr;
+
+/**
+ * @brief Register a peer unless the driver already knows it
+ */
+static bool addPeer(const uint8_t address[RadioTransport::MAC_SIZE]) {
+    if (esp_now_is_peer_exist(address)) {
+        return true;
+    }
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, address, RadioTransport::MAC_SIZE);
+    peerInfo.channel = 0;
+    peerInfo.encrypt = false;
+    return esp_now_add_peer(&peerInfo) == ESP_OK;
+}
+
+EspNowTransport::EspNowTransport() : mac_(), macRead_(false) {
+}
+
+bool EspNowTransport::begin() {
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect();
+    WiFi.macAddress(mac_);
+    macRead_ = true;
+
+    // Set WiFi to maximum transmission power (20.5 dBm for ESP32)
+    WiFi.setTxPower(WIFI_POWER_19_5dBm);  // Maximum power
+
+    if (esp_now_init() != ESP_OK) {
+        return false;
+    }
+    return addPeer(BROADCAST_ADDRESS);
+}
+
+RadioTransport::SendStatus EspNowTransport::send(const uint8_t destination[MAC_SIZE], const uint8_t* data,
+                                                 size_t length) {
+    if (memcmp(destination, BROADCAST_ADDRESS, MAC_SIZE) != 0 && !addPeer(destination)) {
+        return SendStatus::Failed;
+    }
+    esp_err_t result = esp_now_send(destination, data, length);
+    if (result == ESP_OK) {
+        return SendStatus::Queued;
+    }
+    return result == ESP_ERR_ESPNOW_NO_MEM ? SendStatus::Busy : SendStatus::Failed;
+}
+
+void EspNowTransport::macAddress(uint8_t mac[MAC_SIZE]) {
+    if (!macRead_) {
+        WiFi.macAddress(mac);
+        return;
+    }
+    memcpy(mac, mac_, MAC_SIZE);
+}
+
+/**
+ * @brief ESP-NOW receive callback (WiFi task)
+ */
+void EspNowTransport::onReceive(const uint8_t* mac, const uint8_t* data, int length) {
+    ReceiveHandler handler = receiveHandler_;
+    if (handler && length > 0) {
+        handler(receiveContext_, mac, data, static_cast<size_t>(length), ::micros());
+    }
+}
+
+bool EspNowTransport::setReceiveHandler(ReceiveHandler handler, void* context) {
+    receiveContext_ = context;
+    receiveHandler_ = handler;
+    if (!handler) {
+        return esp_now_unregister_recv_cb() == ESP_OK;
+    }
+    return esp_now_register_recv_cb(onReceive) == ESP_OK;
+}
+
+/**
+ * @brief ESP-NOW send callback (WiFi task); broadcast frames always report success
+ */
+void EspNowTransport::onSent(const uint8_t* mac, esp_now_send_status_t status) {
+    (void)mac;
+    SendHandler handler = sendHandler_;
+    if (handler) {
+        handler(sendContext_, status == ESP_NOW_SEND_SUCCESS, ::micros());
+    }
+}
+
+bool EspNowTransport::setSendHandler(SendHandler handler, void* context) {
+    sendContext_ = context;
+    sendHandler_ = handler;
+    if (!handler) {
+        return esp_now_unregister_send_cb() == ESP_OK;
+    }
+    return esp_now_register_send_cb(onSent) == ESP_OK;
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file EspPowerControl.cpp
+ * @brief ESP32 light sleep and WiFi modem sleep
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "EspPowerControl.h"
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <esp_wifi.h>
+
+EspPowerControl::EspPowerControl(int alertPin) : alertPin_(alertPin) {
+}
+
+bool EspPowerControl::begin() {
+    if (alertPin_ < 0) {
+        return true;
+    }
+    pinMode(alertPin_, INPUT_PULLUP); // ALERT/RDY is open-drain
+    return esp_sleep_enable_gpio_wakeup() == ESP_OK;
+}
+
+PowerControl::WakeSource EspPowerControl::sleep(SleepMode mode, uint32_t durationUs) {
+    bool alertArmed = alertPin_ >= 0 && digitalRead(alertPin_) == HIGH;
+    if (mode == SleepMode::Light) {
+        esp_sleep_enable_timer_wakeup(durationUs);
+        if (alertArmed) {
+            gpio_wakeup_enable(static_cast<gpio_num_t>(alertPin_), GPIO_INTR_LOW_LEVEL);
+        }
+        esp_err_t result = esp_light_sleep_start();
+        if (alertArmed) {
+            gpio_wakeup_disable(static_cast<gpio_num_t>(alertPin_));
+        }
+        if (result != ESP_OK) {
+            return WakeSource::Other;
+        }
+        switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_TIMER:
+            return WakeSource::Timer;
+        case ESP_SLEEP_WAKEUP_GPIO:
+            return WakeSource::Alert;
+        default:
+            return WakeSource::Other;
+        }
+    }
+
+    if (!alertArmed) {
+        // Tick-based delay for the whole milliseconds (other tasks run), then precise
+        if (durationUs >= 1000) {
+            ::delay(durationUs / 1000);
+        }
+        ::delayMicroseconds(durationUs % 1000);
+        return WakeSource::Timer;
+    }
+    // Short idle gaps only: poll the pin so a conversion is read as soon as it is ready
+    uint32_t start = ::micros();
+    while (::micros() - start < durationUs) {
+        if (digitalRead(alertPin_) == LOW) {
+            return WakeSource::Alert;
+        }
+        ::delayMicroseconds(ALERT_POLL_US);
+    }
+    return WakeSource::Timer;
+}
+
+bool EspPowerControl::setRadioPowerSave(bool enabled) {
+    return esp_wifi_set_ps(enabled ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE) == ESP_OK;
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file EspSessionStore.cpp
+ * @brief Session statistics saved in RTC memory and NVS
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "EspSessionStore.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <stddef.h>
+#include <string.h>
+#include "RecordingFormat.h"
+
+static const uint32_t SESSION_MAGIC = 0x53534553; // "SESS"
+
+/**
+ * @brief Saved session as stored, with its integrity check
+ */
+struct StoredSession {
+    uint32_t magic;
+    SessionRecord session;
+    uint32_t crc;   // CRC-32 of the fields above
+};
+
+// Not cleared at boot: kept across deep sleep and soft resets
+static RTC_NOINIT_ATTR StoredSession retained;
+
+static uint32_t storedCrc(const StoredSession& stored) {
+    return RecordingFormat::crc32(reinterpret_cast<const uint8_t*>(&stored), offsetof(StoredSession, crc));
+}
+
+static bool valid(const StoredSession& stored) {
+    return stored.magic == SESSION_MAGIC && stored.crc == storedCrc(stored);
+}
+
+bool EspSessionStore::load(SessionRecord& record) {
+    if (valid(retained)) {
+        record = retained.session;
+        return true;
+    }
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, true)) {
+        return false; // Namespace not created yet: first boot
+    }
+    StoredSession stored;
+    bool found = preferences.getBytes(KEY, &stored, sizeof(stored)) == sizeof(stored) && valid(stored);
+    preferences.end();
+    if (!found) {
+        return false;
+    }
+    retained = stored;
+    record = stored.session;
+    return true;
+}
+
+bool EspSessionStore::save(const SessionRecord& record, bool flash) {
+    StoredSession stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.magic = SESSION_MAGIC;
+    stored.session = record;
+    stored.crc = storedCrc(stored);
+    retained = stored;
+    if (!flash) {
+        return true;
+    }
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, false)) {
+        return false;
+    }
+    bool written = preferences.putBytes(KEY, &stored, sizeof(stored)) == sizeof(stored);
+    preferences.end();
+    return written;
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file EspSettingsStore.cpp
+ * @brief Control channel settings saved in NVS
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "EspSettingsStore.h"
+#include <Preferences.h>
+#include <stddef.h>
+#include <string.h>
+#include "RecordingFormat.h"
+
+static const uint32_t SETTINGS_MAGIC = 0x4C525443; // "CTRL"
+
+/**
+ * @brief Control record as stored, with its integrity check
+ */
+struct StoredControl {
+    uint32_t magic;
+    ControlRecord control;
+    uint32_t crc;   // CRC-32 of the fields above
+};
+
+static uint32_t storedCrc(const StoredControl& stored) {
+    return RecordingFormat::crc32(reinterpret_cast<const uint8_t*>(&stored), offsetof(StoredControl, crc));
+}
+
+bool EspSettingsStore::load(ControlRecord& record) {
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, true)) {
+        return false; // Namespace not created yet: first boot
+    }
+    StoredControl stored;
+    bool found = preferences.getBytes(KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+                 stored.magic == SETTINGS_MAGIC && stored.crc == storedCrc(stored);
+    preferences.end();
+    if (!found) {
+        return false;
+    }
+    record = stored.control;
+    return true;
+}
+
+bool EspSettingsStore::save(const ControlRecord& record) {
+    StoredControl stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.magic = SETTINGS_MAGIC;
+    stored.control = record;
+    stored.crc = storedCrc(stored);
+    Preferences preferences;
+    if (!preferences.begin(NAMESPACE, false)) {
+        return false;
+    }
+    bool written = preferences.putBytes(KEY, &stored, sizeof(stored)) == sizeof(stored);
+    preferences.end();
+    return written;
+}
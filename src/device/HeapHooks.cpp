@@ -0,0 +1,69 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HeapHooks.cpp
+ * @brief Allocation hooks of the device build (linker-wrapped malloc family)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Active with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free in the
+ * build flags: every call to these functions, in the Arduino core and the libraries
+ * too, lands here first.
+ */
+
+#include <esp_heap_caps.h>
+#include <stddef.h>
+#include "HeapMonitor.h"
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+void* __wrap_malloc(size_t size) {
+    HeapMonitor::recordAllocation(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    HeapMonitor::recordAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+    HeapMonitor::recordAllocation(size);
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void* pointer) {
+    if (pointer) {
+        HeapMonitor::recordFree();
+    }
+    __real_free(pointer);
+}
+
+} // extern "C"
+
+bool HeapMonitor::heapInfo(HeapInfo& info) {
+    multi_heap_info_t heap;
+    heap_caps_get_info(&heap, MALLOC_CAP_8BIT);
+    info.freeBytes = heap.total_free_bytes;
+    info.largestFreeBlock = heap.largest_free_block;
+    info.minimumFreeBytes = heap.minimum_free_bytes;
+    return true;
+}
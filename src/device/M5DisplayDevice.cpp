@@ -0,0 +1,69 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/**
+ * @file M5DisplayDevice.cpp
+ * @brief M5GFX implementation of DisplayDevice
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "M5DisplayDevice.h"
+
+int16_t M5DisplayDevice::width() {
+    return M5.Display.width();
+}
+
+int16_t M5DisplayDevice::height() {
+    return M5.Display.height();
+}
+
+void M5DisplayDevice::fillScreen(uint16_t color) {
+    M5.Display.fillScreen(color);
+}
+
+void M5DisplayDevice::setTextSize(uint8_t size) {
+    M5.Display.setTextSize(size);
+}
+
+void M5DisplayDevice::setTextColor(uint16_t color) {
+    M5.Display.setTextColor(color);
+}
+
+void M5DisplayDevice::setCursor(int16_t x, int16_t y) {
+    M5.Display.setCursor(x, y);
+}
+
+void M5DisplayDevice::print(const char* text) {
+    M5.Display.print(text);
+}
+
+void M5DisplayDevice::println(const char* text) {
+    M5.Display.println(text);
+}
+
+int16_t M5DisplayDevice::textWidth(const char* text) {
+    return M5.Display.textWidth(text);
+}
+
+void M5DisplayDevice::pushImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) {
+    M5.Display.waitDMA();
+    M5.Display.pushImageDMA(x, y, w, h, reinterpret_cast<const lgfx::rgb565_t*>(pixels));
+}
+
+void M5DisplayDevice::waitPush() {
+    M5.Display.waitDMA();
+}
@@ -0,0 +1,69 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SdBlockStorage.cpp
+ * @brief SD card implementation of BlockStorage
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SdBlockStorage.h"
+
+SdBlockStorage::SdBlockStorage(int8_t sckPin, int8_t misoPin, int8_t mosiPin, int8_t csPin, uint32_t frequency)
+    : spi_(HSPI), sckPin_(sckPin), misoPin_(misoPin), mosiPin_(mosiPin), csPin_(csPin), frequency_(frequency) {
+}
+
+bool SdBlockStorage::begin() {
+    spi_.begin(sckPin_, misoPin_, mosiPin_, csPin_);
+    return SD.begin(csPin_, spi_, frequency_);
+}
+
+bool SdBlockStorage::exists(const char* path) {
+    return SD.exists(path);
+}
+
+bool SdBlockStorage::open(const char* path, uint32_t size) {
+    close();
+    file_ = SD.open(path, FILE_WRITE);
+    if (!file_) {
+        return false;
+    }
+    // Seeking past the end in write mode makes FatFs allocate the whole cluster chain now
+    if (size > 0 && (!file_.seek(size - 1) || file_.write(static_cast<uint8_t>(0)) != 1)) {
+        close();
+        return false;
+    }
+    file_.flush();
+    return file_.seek(0);
+}
+
+bool SdBlockStorage::write(const uint8_t* data, size_t length) {
+    return file_ && file_.write(data, length) == length;
+}
+
+bool SdBlockStorage::sync() {
+    if (!file_) {
+        return false;
+    }
+    file_.flush();
+    return true;
+}
+
+void SdBlockStorage::close() {
+    if (file_) {
+        file_.close();
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/**
+ * @file SerialConsole.cpp
+ * @brief Arduino Serial implementation of Console
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SerialConsole.h"
+
+/**
+ * @brief Open the port without waiting for a USB host: the node must boot and
+ * broadcast unattended. Output written before a host connects is lost.
+ */
+bool SerialConsole::begin(uint32_t baudRate) {
+    Serial.begin(baudRate);
+#if ARDUINO_USB_MODE && ARDUINO_USB_CDC_ON_BOOT
+    Serial.setTxTimeoutMs(0); // With no host reading, a full buffer drops output instead of stalling the writer
+#endif
+    return static_cast<bool>(Serial);
+}
+
+void SerialConsole::print(const char* text) {
+    Serial.print(text);
+}
+
+void SerialConsole::println(const char* text) {
+    Serial.println(text);
+}
+
+size_t SerialConsole::write(const uint8_t* data, size_t length) {
+    return Serial.write(data, length);
+}
+
+int SerialConsole::read() {
+    return Serial.read();
+}
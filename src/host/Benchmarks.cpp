@@ -0,0 +1,221 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file Benchmarks.cpp
+ * @brief Host benchmarks of the per-sample, per-frame and logging hot paths
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Each benchmark runs its body a fixed number of times and prints the mean cost per
+ * operation. Results feed a volatile sink so the optimizer cannot drop the work.
+ * Host timings are not device timings: compare runs of the same machine to spot
+ * regressions, not absolute numbers.
+ *
+ * Tracing builds (-DTRACE_ENABLED=1, the native default) also time the cost of one
+ * trace scope and print the per-stage histograms the benchmarks filled; build
+ * without the flag to compare with the instrumentation compiled out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "AdcFilter.h"
+#include "AdcSampler.h"
+#include "Anemometer.h"
+#include "CalibrationTable.h"
+#include "DisplayRenderer.h"
+#include "FakeAdcSource.h"
+#include "HostConsole.h"
+#include "Logger.h"
+#include "RtosTask.h"
+#include "SimDisplay.h"
+#include "SystemClock.h"
+#include "Trace.h"
+#include "VirtualClock.h"
+#include "WindStatistics.h"
+#include "WireFormat.h"
+
+static const uint32_t DEFAULT_ITERATIONS = 1000000;
+
+// Same shape as the firmware default curve (mV -> km/h)
+static constexpr CalibrationCurve BENCH_CURVE = {
+    {0., 120., 188., 300., 380., 490., 620., 730.},
+    {0.,  10.,  20.,  30.,  40.,  50.,  60.,  70.},
+    8};
+
+static volatile int64_t sink;
+
+/**
+ * @brief Time iterations calls of body(i) and print the mean cost
+ */
+template <typename Body>
+static void bench(const char* name, uint32_t iterations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    int64_t accumulator = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        accumulator += body(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = accumulator;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    printf("%-36s %10.1f ns/op  (%u ops)\n", name, ns, static_cast<unsigned>(iterations));
+}
+
+int runBenchmarks(int argc, char** argv) {
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : DEFAULT_ITERATIONS;
+    if (iterations == 0) {
+        fprintf(stderr, "Usage: bench [iterations]\n");
+        return 1;
+    }
+#if TRACE_ENABLED
+    Trace::begin();
+#endif
+
+    // Per-sample conversion: lookup table against the float interpolation it replaced
+    static const CalibrationTable<Anemometer::CALIBRATION_TABLE_ENTRIES> table(
+        BENCH_CURVE, VMETER_NOMINAL_MILLIVOLTS_PER_CODE);
+    bench("convert: table lookup", iterations, [&](uint32_t i) {
+        return static_cast<int64_t>(table.lookup(static_cast<int16_t>(i & 0x3FF)));
+    });
+    bench("convert: float interpolation", iterations, [&](uint32_t i) {
+        float mv = static_cast<int16_t>(i & 0x3FF) * VMETER_NOMINAL_MILLIVOLTS_PER_CODE;
+        return static_cast<int64_t>(BENCH_CURVE.interpolate(mv) / 3.6f * 1000.0f);
+    });
+
+    // Rolling statistics at 860 SPS
+    WindStatistics statistics;
+    bench("statistics: addSample", iterations, [&](uint32_t i) {
+        statistics.addSample(static_cast<float>(i & 0xFF) * 0.1f, (i * 1000U) / 860U);
+        return static_cast<int64_t>(statistics.get().ticks);
+    });
+
+    // Acquisition ring: one service() per conversion, drained in blocks as the producer does
+    FakeAdcSource adc;
+    adc.setSignal(300, 200, 5.0f, 8);
+    adc.begin();
+    adc.startContinuous(860);
+    AdcSampler sampler(adc);
+    int16_t codes[64];
+    bench("sampler: service + drain", iterations, [&](uint32_t i) {
+        sampler.service();
+        return (i & 63) == 63 ? static_cast<int64_t>(sampler.drain(codes, 64)) : 0;
+    });
+
+    // Filter chain per code, on the blocks the continuous mode drains
+    AdcFilter filter;
+    int32_t filtered[AdcFilter::BLOCK];
+    bench("filter: process (64 codes)", iterations / 64 + 1, [&](uint32_t i) {
+        (void)i;
+        size_t count = filter.process(codes, 64, filtered);
+        return count ? static_cast<int64_t>(filtered[count - 1]) : 0;
+    });
+
+    // Full Anemometer::update() in single-shot mode (one sample, its log line included)
+    FakeAdcSource singleAdc;
+    singleAdc.setSignal(300, 200, 5.0f, 8);
+    VirtualClock clock;
+    Anemometer anemometer(singleAdc, clock, AcquisitionMode::SingleShot);
+    anemometer.setup();
+    bench("anemometer: update (single-shot)", iterations / 10 + 1, [&](uint32_t i) {
+        (void)i;
+        clock.advanceUs(125000);
+        anemometer.update();
+        return static_cast<int64_t>(anemometer.getWindSpeed() * 1000.0f);
+    });
+
+    // Frame encoding and decoding
+    AnemometerData data = {};
+    data.sequenceNumber = 1;
+    data.windSpeed = 7.35f;
+    data.fields = WireFormat::FIELD_STATS;
+    data.windGust = 9.1f;
+    data.windLull = 4.2f;
+    data.windMean = 6.8f;
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    size_t frameLength = WireFormat::encodeAnemometer(data, frame, sizeof(frame));
+    bench("wire: encode (stats)", iterations, [&](uint32_t i) {
+        data.sequenceNumber = static_cast<uint16_t>(i);
+        return static_cast<int64_t>(WireFormat::encodeAnemometer(data, frame, sizeof(frame)));
+    });
+    AnemometerData decoded;
+    bench("wire: decode (stats)", iterations, [&](uint32_t i) {
+        (void)i;
+        return static_cast<int64_t>(WireFormat::decodeAnemometer(frame, frameLength, decoded));
+    });
+
+    // Display frame: changed digit cells plus the sparkline bands, on the simulated display
+    SimDisplay frameDisplay;
+    SystemClock systemClock;
+    DisplayRenderer renderer(frameDisplay, systemClock);
+    bench("display: render frame", iterations / 100 + 1, [&](uint32_t i) {
+        renderer.render(5.0f + (i % 50) * 0.1f, 9.0f, 3.0f);
+        return static_cast<int64_t>(renderer.lastFrameBytes());
+    });
+
+    // Logging: formatting plus the console write, with the output muted
+    HostConsole console(true);
+    SimDisplay display;
+    Logger serialLogger(&console, nullptr, true, false);
+    Logger screenLogger(&console, &display, true, true);
+    char message[96];
+    bench("logger: snprintf + serial", iterations / 10 + 1, [&](uint32_t i) {
+        snprintf(message, sizeof(message), "Wind Speed: %.2f m/s, Gust: %.2f m/s", i * 0.01f, i * 0.02f);
+        serialLogger.log(message);
+        return static_cast<int64_t>(console.bytesWritten());
+    });
+    bench("logger: snprintf + serial + screen", iterations / 10 + 1, [&](uint32_t i) {
+        snprintf(message, sizeof(message), "Wind Speed: %.2f m/s, Gust: %.2f m/s", i * 0.01f, i * 0.02f);
+        screenLogger.log(message);
+        return static_cast<int64_t>(display.pixels());
+    });
+
+    // Deferred logging: the caller only captures the record, the logger task formats it.
+    // Bursts of a quarter of the queue, with a pause for the task, so nothing is dropped.
+    Logger asyncLogger(&console, nullptr, true, false);
+    asyncLogger.startAsync();
+    const uint32_t burst = Logger::QUEUE_SIZE / 4;
+    uint32_t captures = iterations / 10 + 1;
+    std::chrono::steady_clock::duration captureTime{};
+    for (uint32_t done = 0; done < captures; done += burst) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < burst; i++) {
+            asyncLogger.logf(LogModule::Main, LogLevel::Info, "Wind Speed: %.2f m/s, Gust: %.2f m/s", i * 0.01f,
+                             i * 0.02f);
+        }
+        captureTime += std::chrono::steady_clock::now() - start;
+        RtosTask::sleepMs(2);
+    }
+    asyncLogger.stopAsync();
+    uint32_t rounds = (captures + burst - 1) / burst;
+    printf("%-36s %10.1f ns/op  (%u ops, %lu dropped)\n", "logger: logf capture (async)",
+           std::chrono::duration<double, std::nano>(captureTime).count() / (rounds * burst),
+           static_cast<unsigned>(rounds * burst), static_cast<unsigned long>(asyncLogger.dropped()));
+
+#if TRACE_ENABLED
+    console.setMuted(false);
+    printf("\n");
+    Trace::dump(serialLogger);
+    bench("trace: scope (reads + record)", iterations, [&](uint32_t i) {
+        TRACE_SCOPE(TraceStage::Jitter);
+        return static_cast<int64_t>(i);
+    });
+    Trace::reset();
+#else
+    printf("trace: compiled out (TRACE_ENABLED=0)\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,382 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file BootSim.cpp
+ * @brief Boot to first frame with a missing or late sensor and a cached calibration
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Runs the firmware start sequence on a virtual clock, boot after boot, with one
+ * calibration cache standing for the RTC memory and the NVS: radio first, then
+ * Anemometer::setup(), then one measurement offered to Communication every period
+ * like the transmit stage does. The converter answers only after --late seconds in
+ * the late scenarios (the last one with another unit plugged in), never in the
+ * missing one. I2C, EEPROM and radio start costs are model figures, so the times
+ * compare the two start sequences rather than predict the device exactly.
+ *
+ * The former sequence (blocking 1 s retries, EEPROM read at every boot, radio last)
+ * is timed with the same models; it also waited for a USB host, so its figures
+ * assume one is connected. Checks: the first frame leaves right after setup
+ * whatever the sensor, frames are flagged FIELD_NO_SENSOR exactly while it is
+ * missing, the first measured frame follows the sensor within one period, cached
+ * boots skip the EEPROM, and the cache is only rewritten for another unit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Anemometer.h"
+#include "CalibrationStore.h"
+#include "Communication.h"
+#include "FakeAdcSource.h"
+#include "HostCommands.h"
+#include "SimRadio.h"
+#include "VirtualClock.h"
+#include "WireFormat.h"
+
+static const uint32_t RADIO_BEGIN_US = 120000;   // WiFi and ESP-NOW start (model)
+static const uint32_t PROBE_US = 300;            // ADS1115 probe nobody answers (model)
+static const uint32_t BEGIN_US = 2000;           // ADS1115 probe and configuration (model)
+static const uint32_t EEPROM_US = 15000;         // Factory calibration read from the unit EEPROM (model)
+static const uint32_t AIRTIME_US = 800;          // ESP-NOW anemometer frame at 1 Mbps
+static const uint32_t LEGACY_RETRY_MS = 1000;    // Former blocking retry delay
+static const uint32_t PERIOD_MS = 250;           // Measurement period
+static const uint32_t NEVER = 0xFFFFFFFF;
+
+static const AdcCalibration UNIT_A = {0.0625f / 0.015918958f, 1.0032f};
+static const AdcCalibration UNIT_B = {0.0625f / 0.015918958f, 0.9961f};
+
+namespace {
+
+/**
+ * @brief Converter that answers from a given time, with the I2C costs on the virtual clock
+ */
+class BootAdcSource : public FakeAdcSource {
+private:
+    VirtualClock& clock_;
+    uint32_t answerMs_;          // First time the unit answers, NEVER if missing
+    AdcCalibration unit_;        // Calibration in the unit EEPROM
+    AdcCalibration calibration_; // Calibration in use, factor 0 until read or set
+    uint32_t eepromReads_;
+
+public:
+    BootAdcSource(VirtualClock& clock, uint32_t answerMs, const AdcCalibration& unit)
+        : clock_(clock), answerMs_(answerMs), unit_(unit), calibration_(), eepromReads_(0) {
+        setSignal(1500, 300, 20.0f, 0);
+    }
+
+    bool begin() override {
+        if (answerMs_ == NEVER || clock_.millis() < answerMs_) {
+            clock_.advanceUs(PROBE_US);
+            return false;
+        }
+        clock_.advanceUs(BEGIN_US);
+        if (calibration_.factor <= 0.0f) {
+            clock_.advanceUs(EEPROM_US);
+            calibration_ = unit_;
+            eepromReads_++;
+        }
+        return FakeAdcSource::begin();
+    }
+
+    float millivoltsPerCode() const override {
+        return calibration_.resolution * calibration_.factor;
+    }
+
+    bool getCalibration(AdcCalibration& calibration) const override {
+        calibration = calibration_;
+        return calibration_.factor > 0.0f;
+    }
+
+    void setCalibration(const AdcCalibration& calibration) override {
+        calibration_ = calibration;
+    }
+
+    uint32_t eepromReads() const {
+        return eepromReads_;
+    }
+};
+
+/**
+ * @brief Calibration cache: a retained copy lost at power-on and a flash copy
+ */
+class MemoryCalibrationStore : public CalibrationStore {
+private:
+    bool retained_;
+    bool flash_;
+    AdcCalibration value_;
+    uint32_t flashWrites_;
+
+public:
+    MemoryCalibrationStore() : retained_(false), flash_(false), value_(), flashWrites_(0) {}
+
+    bool load(AdcCalibration& calibration, CalibrationSource& source) override {
+        if (!retained_ && !flash_) {
+            return false;
+        }
+        source = retained_ ? CalibrationSource::Retained : CalibrationSource::Flash;
+        retained_ = true;
+        calibration = value_;
+        return true;
+    }
+
+    bool save(const AdcCalibration& calibration) override {
+        retained_ = true;
+        if (!flash_ || memcmp(&value_, &calibration, sizeof(calibration)) != 0) {
+            flash_ = true;
+            flashWrites_++;
+        }
+        value_ = calibration;
+        return true;
+    }
+
+    void powerOff() {
+        retained_ = false;
+    }
+
+    uint32_t flashWrites() const {
+        return flashWrites_;
+    }
+};
+
+/**
+ * @brief What one boot looked like
+ */
+struct BootResult {
+    uint32_t setupMs;          // End of the start sequence
+    uint32_t firstFrameMs;     // First frame on air
+    uint32_t sensorMs;         // Converter running
+    uint32_t measuredFrameMs;  // First frame queued without FIELD_NO_SENSOR
+    uint32_t lastFlaggedMs;    // Last frame queued with FIELD_NO_SENSOR
+    uint32_t frames;
+    uint32_t flagged;
+    uint32_t attempts;
+    uint32_t eepromReads;
+    CalibrationSource source;
+    float millivoltsPerCode;   // Scale in use at the end (correction included)
+};
+
+} // namespace
+
+static uint32_t toMs(uint32_t us) {
+    return us / 1000;
+}
+
+/**
+ * @brief Run the firmware start sequence then seconds of measurement periods
+ */
+static BootResult bootFirmware(MemoryCalibrationStore& store, uint32_t answerMs, const AdcCalibration& unit,
+                               uint32_t seconds) {
+    VirtualClock clock;
+    SimRadio radio;
+    radio.setDriver(4, AIRTIME_US);
+    Communication comm(radio, clock);
+    BootAdcSource adc(clock, answerMs, unit);
+    Anemometer anemometer(adc, clock, AcquisitionMode::SingleShot, 8);
+
+    BootResult result = {};
+    result.firstFrameMs = NEVER;
+    result.sensorMs = NEVER;
+    result.measuredFrameMs = NEVER;
+    result.lastFlaggedMs = NEVER;
+
+    clock.advanceUs(RADIO_BEGIN_US);
+    comm.setup();
+    anemometer.setCalibrationStore(&store);
+    anemometer.setup();
+    result.setupMs = clock.millis();
+
+    uint32_t endMs = result.setupMs + seconds * 1000;
+    while (clock.millis() < endMs) {
+        uint32_t periodStartUs = clock.micros();
+        anemometer.update();
+
+        AnemometerData data = {};
+        radio.macAddress(data.macAddress);
+        data.windSpeed = anemometer.getWindSpeed();
+        data.fields = anemometer.isSensorReady() ? WireFormat::FIELD_STATS : WireFormat::FIELD_NO_SENSOR;
+        WindStats stats = anemometer.getStatistics();
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        uint32_t before = radio.sent();
+        radio.advance(clock.micros());
+        comm.offer(data, clock.millis());
+        if (radio.sent() != before) {
+            AnemometerData sent;
+            const SimRadio::Frame* frame = radio.frame(0);
+            if (frame && WireFormat::decodeAnemometer(frame->data, frame->length, sent)) {
+                result.frames++;
+                if (sent.fields & WireFormat::FIELD_NO_SENSOR) {
+                    result.flagged++;
+                    result.lastFlaggedMs = clock.millis();
+                } else if (result.measuredFrameMs == NEVER) {
+                    result.measuredFrameMs = clock.millis();
+                }
+            }
+        }
+
+        // Rest of the period; the radio reports the completions due by then
+        uint32_t spentUs = clock.micros() - periodStartUs;
+        clock.advanceUs(spentUs < PERIOD_MS * 1000 ? PERIOD_MS * 1000 - spentUs : 0);
+        radio.advance(clock.micros());
+    }
+
+    uint32_t firstUs;
+    if (comm.transmitter().firstSentUs(firstUs)) {
+        result.firstFrameMs = toMs(firstUs);
+    }
+    if (anemometer.isSensorReady()) {
+        result.sensorMs = anemometer.getSensorReadyMs();
+    }
+    result.attempts = anemometer.getSensorAttempts();
+    result.eepromReads = adc.eepromReads();
+    result.source = anemometer.getCalibrationSource();
+    result.millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    return result;
+}
+
+/**
+ * @brief Time the former start sequence: blocking retries, EEPROM read, radio last
+ */
+static BootResult bootLegacy(uint32_t answerMs, const AdcCalibration& unit, uint32_t seconds) {
+    VirtualClock clock;
+    BootAdcSource adc(clock, answerMs, unit);
+    BootResult result = {};
+    result.firstFrameMs = NEVER;
+    result.sensorMs = NEVER;
+    result.attempts = 1;
+    while (!adc.begin()) {
+        if (clock.millis() >= seconds * 1000) {
+            result.setupMs = NEVER;
+            return result;
+        }
+        clock.delayMs(LEGACY_RETRY_MS);
+        result.attempts++;
+    }
+    result.sensorMs = clock.millis();
+    result.eepromReads = adc.eepromReads();
+    clock.advanceUs(RADIO_BEGIN_US);
+    result.setupMs = clock.millis();
+    result.firstFrameMs = toMs(clock.micros() + AIRTIME_US);
+    return result;
+}
+
+static void printTime(uint32_t ms) {
+    if (ms == NEVER) {
+        printf("%8s", "never");
+    } else {
+        printf("%8lu", static_cast<unsigned long>(ms));
+    }
+}
+
+int runBootSim(int argc, char** argv) {
+    uint32_t lateSeconds = 5;
+    uint32_t seconds = 60;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--late") == 0 && i + 1 < argc) {
+            lateSeconds = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+    }
+    if (lateSeconds == 0) {
+        lateSeconds = 1; // The late scenarios need a sensor that is late
+    }
+    if (seconds < lateSeconds + 20) {
+        seconds = lateSeconds + 20; // Room for the backoff to catch the late sensor
+    }
+
+    struct Scenario {
+        const char* name;
+        bool powerOff;             // Retained copy lost (power-on rather than deep-sleep wake)
+        uint32_t answerMs;
+        const AdcCalibration* unit;
+        CalibrationSource expectedSource;
+        uint32_t expectedEepromReads;
+        uint32_t expectedFlashWrites; // Total so far
+    };
+    uint32_t lateMs = lateSeconds * 1000;
+    const Scenario scenarios[] = {
+        {"first boot", true, 0, &UNIT_A, CalibrationSource::Converter, 1, 1},
+        {"power-on, cached", true, 0, &UNIT_A, CalibrationSource::Flash, 0, 1},
+        {"deep-sleep wake", false, 0, &UNIT_A, CalibrationSource::Retained, 0, 1},
+        {"sensor late", true, lateMs, &UNIT_A, CalibrationSource::Converter, 1, 1},
+        {"late, other unit", true, lateMs, &UNIT_B, CalibrationSource::Converter, 1, 2},
+        {"sensor missing", true, NEVER, &UNIT_B, CalibrationSource::None, 0, 2},
+    };
+
+    printf("Boot: radio %lu ms, probe %lu us, begin %lu ms, EEPROM %lu ms (models), %lu s per boot\n",
+           static_cast<unsigned long>(RADIO_BEGIN_US / 1000), static_cast<unsigned long>(PROBE_US),
+           static_cast<unsigned long>(BEGIN_US / 1000), static_cast<unsigned long>(EEPROM_US / 1000),
+           static_cast<unsigned long>(seconds));
+    printf("%-18s %8s %8s %8s %8s %8s %6s %6s %-16s | %8s %8s\n", "scenario", "setup", "1st air", "sensor",
+           "measured", "flagged", "tries", "eeprom", "calibration", "old air", "old tries");
+
+    MemoryCalibrationStore store;
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        if (scenario.powerOff) {
+            store.powerOff();
+        }
+        BootResult boot = bootFirmware(store, scenario.answerMs, *scenario.unit, seconds);
+        BootResult legacy = bootLegacy(scenario.answerMs, *scenario.unit, seconds);
+
+        printf("%-18s ", scenario.name);
+        printTime(boot.setupMs);
+        printf(" ");
+        printTime(boot.firstFrameMs);
+        printf(" ");
+        printTime(boot.sensorMs);
+        printf(" ");
+        printTime(boot.measuredFrameMs);
+        printf(" %8lu %6lu %6lu %-16s | ", static_cast<unsigned long>(boot.flagged),
+               static_cast<unsigned long>(boot.attempts), static_cast<unsigned long>(boot.eepromReads),
+               calibrationSourceName(boot.source));
+        printTime(legacy.firstFrameMs);
+        printf(" %9lu\n", static_cast<unsigned long>(legacy.attempts));
+
+        bool missing = scenario.answerMs == NEVER;
+        bool late = scenario.answerMs > 0;
+        // First frame in the first period after setup, whatever the sensor
+        bool fast = boot.firstFrameMs != NEVER && boot.firstFrameMs <= boot.setupMs + PERIOD_MS;
+        // Flagged exactly while the sensor is missing, measured frame within one period of it
+        bool flags = late ? boot.flagged > 0 : boot.flagged == 0;
+        if (!missing) {
+            flags = flags && boot.sensorMs != NEVER && boot.measuredFrameMs != NEVER &&
+                    boot.measuredFrameMs <= boot.sensorMs + PERIOD_MS &&
+                    (boot.lastFlaggedMs == NEVER || boot.lastFlaggedMs <= boot.sensorMs);
+        } else {
+            // Still heard: one heartbeat per 10 s at least
+            flags = flags && boot.sensorMs == NEVER && boot.measuredFrameMs == NEVER &&
+                    boot.frames >= seconds / 10;
+        }
+        // Backoff: the late sensor is caught within twice its delay
+        bool backoff = !late || missing || boot.sensorMs <= scenario.answerMs * 2 + Anemometer::SENSOR_RETRY_FIRST_MS;
+        bool cache = boot.source == scenario.expectedSource && boot.eepromReads == scenario.expectedEepromReads &&
+                     store.flashWrites() == scenario.expectedFlashWrites;
+        float expectedScale = scenario.unit->resolution * scenario.unit->factor * Anemometer::COEF_CORRECTION;
+        bool scale = missing || boot.millivoltsPerCode == expectedScale;
+        if (!fast || !flags || !backoff || !cache || !scale) {
+            printf("  FAILED:%s%s%s%s%s\n", fast ? "" : " first frame late", flags ? "" : " sensor flag",
+                   backoff ? "" : " backoff", cache ? "" : " calibration cache", scale ? "" : " scale");
+            ok = false;
+        }
+    }
+    printf("Times in ms since boot; the former sequence also waited for a USB host.\n");
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file BroadcastSim.cpp
+ * @brief Adaptive broadcast policy replayed against wind traces on the simulated radio
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Each trace is stepped at the 250 ms measurement period through WindStatistics,
+ * Communication::offer() and SimRadio, as on the device. A receiver decodes the
+ * delivered frames; its error (true speed minus last received speed) is compared
+ * with the former fixed 2 s schedule sent over a second simulated radio with the
+ * same loss rate. Without a file, four synthetic traces are replayed; a CSV file
+ * from tools/decode_recording.py (timestamp_ms, wind_speed_ms) or with
+ * time_s,speed columns can be replayed instead.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "HostCommands.h"
+#include "Communication.h"
+#include "SimRadio.h"
+#include "VirtualClock.h"
+#include "WindStatistics.h"
+
+static const uint32_t STEP_MS = 250;
+static const uint32_t FIXED_PERIOD_MS = 2000;
+
+namespace {
+
+/**
+ * @brief Wind speed over time, one point per sample
+ */
+struct TracePoint {
+    uint32_t timeMs;
+    float speed;
+};
+
+/**
+ * @brief Reproducible uniform noise in [-1, 1]
+ */
+static float noise(uint32_t& seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/**
+ * @brief Build one of the synthetic traces at the measurement period
+ * @param kind 0 steady, 1 gust front, 2 building breeze, 3 gusty
+ */
+static void syntheticTrace(int kind, uint32_t minutes, std::vector<TracePoint>& trace) {
+    uint32_t seed = 12345 + kind;
+    uint32_t steps = minutes * 60000 / STEP_MS;
+    float turbulence = 0.0f; // Correlated over a few seconds, unit variance
+    trace.clear();
+    for (uint32_t i = 0; i < steps; i++) {
+        float t = i * (STEP_MS / 1000.0f);
+        float fraction = static_cast<float>(i) / steps;
+        turbulence = 0.9f * turbulence + 0.75f * noise(seed);
+        float speed;
+        switch (kind) {
+        case 0: // Steady 8 m/s, sensor noise only
+            speed = 8.0f + 0.15f * noise(seed);
+            break;
+        case 1: { // 5 m/s, then a front brings 14 m/s within 30 s a third of the way in
+            float front = (fraction - 1.0f / 3) * minutes * 60.0f / 30.0f;
+            front = front < 0.0f ? 0.0f : (front > 1.0f ? 1.0f : front);
+            speed = 5.0f + 9.0f * front + (0.3f + 1.2f * front) * turbulence + 0.1f * noise(seed);
+            break;
+        }
+        case 2: // Sea breeze building from 3 to 12 m/s
+            speed = 3.0f + 9.0f * fraction + 0.3f * turbulence + 0.1f * noise(seed);
+            break;
+        default: // Gusty: slow swing with 20 s gust cycles
+            speed = 9.0f + 2.0f * sinf(t / 300.0f) + 2.5f * sinf(t / 3.2f) * sinf(t / 20.0f) + 0.4f * turbulence +
+                    0.1f * noise(seed);
+            break;
+        }
+        trace.push_back({static_cast<uint32_t>(i * STEP_MS), speed > 0.0f ? speed : 0.0f});
+    }
+}
+
+/**
+ * @brief Load a CSV trace (decode_recording.py output, or time_s,speed columns)
+ * @return true if at least one point was read
+ */
+static bool loadTrace(const char* path, std::vector<TracePoint>& trace) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    char line[512];
+    int timeColumn = 0;
+    int speedColumn = 1;
+    double timeScale = 1000.0; // time_s by default
+    trace.clear();
+    bool first = true;
+    while (fgets(line, sizeof(line), file)) {
+        if (first) {
+            first = false;
+            if (!strchr("0123456789.-", line[0])) {
+                // Header: locate the columns by name
+                int column = 0;
+                for (char* field = strtok(line, ",\r\n"); field; field = strtok(nullptr, ",\r\n"), column++) {
+                    if (strcmp(field, "timestamp_ms") == 0) {
+                        timeColumn = column;
+                        timeScale = 1.0;
+                    } else if (strcmp(field, "time_s") == 0) {
+                        timeColumn = column;
+                    } else if (strcmp(field, "wind_speed_ms") == 0 || strcmp(field, "speed") == 0) {
+                        speedColumn = column;
+                    }
+                }
+                continue;
+            }
+        }
+        double time = 0.0;
+        double speed = 0.0;
+        int found = 0;
+        int column = 0;
+        for (char* field = strtok(line, ",\r\n"); field; field = strtok(nullptr, ",\r\n"), column++) {
+            if (column == timeColumn) {
+                time = strtod(field, nullptr);
+                found++;
+            } else if (column == speedColumn) {
+                speed = strtod(field, nullptr);
+                found++;
+            }
+        }
+        if (found == 2) {
+            trace.push_back({static_cast<uint32_t>(time * timeScale), static_cast<float>(speed)});
+        }
+    }
+    fclose(file);
+    return !trace.empty();
+}
+
+/**
+ * @brief Receiver side: last speed decoded from the delivered frames
+ */
+struct Receiver {
+    uint32_t delivered = 0;
+    float speed = 0.0f;
+    double errorSum = 0.0;
+    float errorMax = 0.0f;
+    uint32_t outside = 0;   // Steps where the error exceeded the deadband
+
+    void poll(const SimRadio& radio) {
+        if (radio.delivered() == delivered) {
+            return;
+        }
+        delivered = radio.delivered();
+        AnemometerData data;
+        const SimRadio::Frame* frame = radio.frame(0);
+        if (frame && WireFormat::decodeAnemometer(frame->data, frame->length, data)) {
+            speed = data.windSpeed;
+        }
+    }
+
+    void score(float truth, float deadband) {
+        float error = fabsf(truth - speed);
+        errorSum += error;
+        errorMax = error > errorMax ? error : errorMax;
+        if (error > deadband) {
+            outside++;
+        }
+    }
+};
+
+} // namespace
+
+static WindStatistics statistics; // Large (10 min window), kept off the stack
+
+/**
+ * @brief Replay one trace and print one result line
+ */
+static void replay(const char* name, const std::vector<TracePoint>& trace, const BroadcastPolicy::Config& config,
+                   float lossRate) {
+    VirtualClock clock;
+    SimRadio radio;
+    SimRadio fixedRadio;
+    radio.setLossRate(lossRate, 7);
+    fixedRadio.setLossRate(lossRate, 7);
+    Communication comm(radio, clock);
+    comm.setup();
+    comm.setPolicy(config);
+    Communication fixed(fixedRadio, clock);
+    fixed.setup();
+    statistics.reset();
+
+    Receiver adaptiveView;
+    Receiver fixedView;
+    uint32_t steps = 0;
+    size_t next = 0;
+    uint32_t startMs = trace.front().timeMs;
+    float speed = trace.front().speed;
+    uint16_t fixedSequence = 0;
+    while (next < trace.size()) {
+        // Fold the samples of one measurement period, as Anemometer::update() does
+        clock.advanceUs(STEP_MS * 1000ULL);
+        uint32_t nowMs = clock.millis();
+        radio.advance(clock.micros());
+        fixedRadio.advance(clock.micros());
+        while (next < trace.size() && trace[next].timeMs - startMs < nowMs) {
+            speed = trace[next].speed;
+            statistics.addSample(speed, trace[next].timeMs - startMs);
+            next++;
+        }
+        WindStats stats = statistics.get();
+
+        AnemometerData data = {};
+        radio.macAddress(data.macAddress);
+        data.windSpeed = speed;
+        data.fields = WireFormat::FIELD_STATS;
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        comm.offer(data, nowMs);
+        if (steps % (FIXED_PERIOD_MS / STEP_MS) == 0) {
+            data.sequenceNumber = fixedSequence++;
+            fixed.broadcast(data);
+        }
+        steps++;
+
+        adaptiveView.poll(radio);
+        fixedView.poll(fixedRadio);
+        adaptiveView.score(speed, config.speedDeadband);
+        fixedView.score(speed, config.speedDeadband);
+    }
+
+    const BroadcastPolicy& policy = comm.policy();
+    printf("%-16s %7lu %7lu %6.1f%% %7lu %6lu %7lu  %5.2f %5.2f %5.1f%%  %5.2f %5.2f %5.1f%%\n", name,
+           static_cast<unsigned long>(policy.sent()), static_cast<unsigned long>(policy.fixedScheduleFrames()),
+           100.0 * policy.saved() / policy.fixedScheduleFrames(),
+           static_cast<unsigned long>(policy.events()), static_cast<unsigned long>(policy.heartbeats()),
+           static_cast<unsigned long>(policy.rateLimited()), adaptiveView.errorSum / steps, adaptiveView.errorMax,
+           100.0 * adaptiveView.outside / steps, fixedView.errorSum / steps, fixedView.errorMax,
+           100.0 * fixedView.outside / steps);
+}
+
+int runBroadcastSim(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    BroadcastPolicy::Config config = BroadcastPolicy::DEFAULT_CONFIG;
+    float lossRate = 0.0f;
+    uint32_t minutes = 30;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--deadband") == 0 && i + 1 < argc) {
+            config.speedDeadband = config.gustDeadband = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--heartbeat") == 0 && i + 1 < argc) {
+            config.heartbeatMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            lossRate = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-') {
+            tracePath = argv[i];
+        } else {
+            fprintf(stderr, "Usage: broadcast [trace.csv] [--deadband M/S] [--heartbeat MS] [--loss RATE] "
+                            "[--minutes N]\n");
+            return 1;
+        }
+    }
+
+    printf("Deadband %.2f m/s, gap %lu..%lu ms, heartbeat %lu ms, loss %.0f%%, fixed schedule %lu ms\n",
+           config.speedDeadband, static_cast<unsigned long>(config.minIntervalMs),
+           static_cast<unsigned long>(config.rampStartMs), static_cast<unsigned long>(config.heartbeatMs),
+           lossRate * 100.0f, static_cast<unsigned long>(FIXED_PERIOD_MS));
+    printf("%-16s %7s %7s %7s %7s %6s %7s  %-19s  %-19s\n", "trace", "frames", "fixed", "saved", "changes", "beats",
+           "limited", "adaptive err (m/s)", "fixed err (m/s)");
+    printf("%-16s %7s %7s %7s %7s %6s %7s  %5s %5s %6s  %5s %5s %6s\n", "", "", "", "", "", "", "", "mean", "max",
+           ">band", "mean", "max", ">band");
+
+    std::vector<TracePoint> trace;
+    if (tracePath) {
+        if (!loadTrace(tracePath, trace)) {
+            fprintf(stderr, "Cannot read a trace from %s\n", tracePath);
+            return 1;
+        }
+        const char* name = strrchr(tracePath, '/');
+        replay(name ? name + 1 : tracePath, trace, config, lossRate);
+        return 0;
+    }
+    static const char* const NAMES[] = {"steady", "gust front", "building breeze", "gusty"};
+    for (int kind = 0; kind < 4; kind++) {
+        syntheticTrace(kind, minutes, trace);
+        replay(NAMES[kind], trace, config, lossRate);
+    }
+    return 0;
+}
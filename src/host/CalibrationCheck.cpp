@@ -0,0 +1,133 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file CalibrationCheck.cpp
+ * @brief Code to wind speed lookup table against the float conversion
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The lookup table replaces voltageToWindSpeed() on every sample, so it must give
+ * the same speed to the millimetre per second: exactly inside the table, within
+ * 1 mm/s for the extrapolated codes the VMeter can produce (+-36 V). Beyond that,
+ * up to the ends of the 16-bit range, the float path itself rounds its two large
+ * products by more than 1 mm/s, so there every code is compared with the same
+ * interpolation evaluated in double instead, again within 1 mm/s; the difference
+ * to the float path is only printed. This is done for the tables the firmware
+ * actually uses: the compile-time table of the nominal VMeter scale, the table
+ * rebuilt at setup with a factory calibration factor other than 1, and the table
+ * rebuilt when a calibration curve is loaded at runtime.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "Anemometer.h"
+#include "FakeAdcSource.h"
+#include "HostCommands.h"
+#include "VirtualClock.h"
+
+static const int32_t TOLERANCE_MM_S = 1;
+static const float INPUT_RANGE_MILLIVOLTS = 36000.0f;  // Unit VMeter input range, +-36 V
+static const float FACTORY_FACTOR = 1.0137f;   // A unit reading 1.37 % high
+
+// A steeper curve with more points, as loaded from a wind tunnel calibration
+static const float TUNNEL_MILLIVOLTS[] = {0.0f, 45.0f, 95.0f, 160.0f, 240.0f, 330.0f, 430.0f, 540.0f, 660.0f, 790.0f};
+static const float TUNNEL_KMH[] = {0.0f, 4.0f, 9.5f, 16.0f, 23.0f, 31.0f, 39.5f, 48.0f, 57.5f, 67.0f};
+
+/**
+ * @brief Wind speed (mm/s) of calculerY() at a voltage, evaluated in double
+ */
+static double exactSpeedMm(const CalibrationCurve& curve, double millivolts) {
+    size_t i = 0;
+    while (i + 2 < curve.size && millivolts >= curve.millivolts[i + 1]) {
+        i++;
+    }
+    double kmh = ((millivolts - curve.millivolts[i]) * curve.kmh[i + 1] +
+                  (curve.millivolts[i + 1] - millivolts) * curve.kmh[i]) /
+                 (static_cast<double>(curve.millivolts[i + 1]) - curve.millivolts[i]);
+    return kmh / 3.6 * 1000.0;
+}
+
+/**
+ * @brief Largest difference (mm/s, unrounded) between a table and the double evaluation over every code
+ */
+static double exactError(const CalibrationCurve& curve, float millivoltsPerCode) {
+    static CalibrationTable<Anemometer::CALIBRATION_TABLE_ENTRIES> table; // Same build as the anemometer's
+    if (!table.build(curve, millivoltsPerCode)) {
+        return HUGE_VAL;
+    }
+    double maxError = 0.0;
+    for (int32_t code = INT16_MIN; code <= INT16_MAX; code++) {
+        double error = fabs(table.lookup(static_cast<int16_t>(code)) -
+                            exactSpeedMm(curve, static_cast<double>(code) * millivoltsPerCode));
+        maxError = error > maxError ? error : maxError;
+    }
+    return maxError;
+}
+
+/**
+ * @brief Compare the table in use with the float path and with the double evaluation
+ */
+static bool checkTable(const char* name, Anemometer& anemometer) {
+    const CalibrationCurve& curve = anemometer.getCalibrationCurve();
+    float millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    int32_t inputCodes = static_cast<int32_t>(INPUT_RANGE_MILLIVOLTS / millivoltsPerCode) + 1;
+    int32_t tableError = anemometer.verifyCalibrationTable(0, Anemometer::CALIBRATION_TABLE_ENTRIES - 1);
+    int32_t inputError = anemometer.verifyCalibrationTable(-inputCodes, inputCodes);
+    int32_t floatError = anemometer.verifyCalibrationTable(INT16_MIN, INT16_MAX);
+    double error = exactError(curve, millivoltsPerCode);
+    bool ok = tableError == 0 && inputError <= TOLERANCE_MM_S && error <= TOLERANCE_MM_S;
+    printf("%-24s %.5f mV/code, %u points: max error %ld mm/s in the table, %ld within +-36 V; all %ld codes "
+           "%.2f mm/s (float path %ld) %s\n",
+           name, millivoltsPerCode, static_cast<unsigned>(curve.size), static_cast<long>(tableError),
+           static_cast<long>(inputError), static_cast<long>(INT16_MAX - INT16_MIN + 1), error,
+           static_cast<long>(floatError), ok ? "OK" : "FAILED");
+    return ok;
+}
+
+int runCalibrationCheck(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    VirtualClock clock;
+    bool ok = true;
+
+    // Nominal scale: the table generated at compile time, then after setup
+    FakeAdcSource nominalAdc;
+    Anemometer nominal(nominalAdc, clock, AcquisitionMode::SingleShot);
+    ok = checkTable("Nominal, compile time", nominal) && ok;
+    nominal.setup();
+    ok = checkTable("Nominal, after setup", nominal) && ok;
+
+    // Factory calibration read from the converter: the table is rebuilt at setup
+    FakeAdcSource factoryAdc(VMETER_NOMINAL_MILLIVOLTS_PER_CODE * FACTORY_FACTOR);
+    Anemometer factory(factoryAdc, clock, AcquisitionMode::SingleShot);
+    factory.setup();
+    bool rebuilt = factory.getMillivoltsPerCode() != nominal.getMillivoltsPerCode();
+    if (!rebuilt) {
+        printf("Factory calibration not applied\n");
+    }
+    ok = rebuilt && checkTable("Factory factor 1.0137", factory) && ok;
+
+    // Curve loaded at runtime, on top of the factory calibration
+    bool loaded = factory.loadCalibrationCurve(TUNNEL_MILLIVOLTS, TUNNEL_KMH, sizeof(TUNNEL_KMH) / sizeof(TUNNEL_KMH[0]));
+    if (!loaded) {
+        printf("Runtime curve rejected\n");
+    }
+    ok = loaded && checkTable("Runtime curve", factory) && ok;
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,437 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file ControlCheck.cpp
+ * @brief Control channel checks: authentication, replay, atomic settings changes, persistence
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * SipHash-2-4 is checked against the reference vectors of its authors first. Then
+ * a node is built on a virtual clock as setup() does (converter in replay mode,
+ * turbulence analysis, transmit path on a simulated ESP-NOW driver, control channel
+ * with an in-memory settings store) and an operator talks to it through the
+ * simulated radio, one measurement period per command: a frame signed with another
+ * key and a command for another node get no reply, a command played again gets
+ * STATUS_STALE, out-of-range values change nothing, and a change of sample rate and
+ * filter reaches the acquisition in the same period, the one after the command,
+ * while the conversions keep flowing. The cost of that change in the producer is
+ * reported. A second node boots on the saved record: it applies the same settings
+ * and refuses the commands already executed. Finally a node built without a fleet
+ * key ignores every command and leaves the saved settings alone.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "AnemometerControl.h"
+#include "ControlChannel.h"
+#include "FakeAdcSource.h"
+#include "HostCommands.h"
+#include "Logger.h"
+#include "SimRadio.h"
+#include "SipHash.h"
+#include "TurbulenceAnalyzer.h"
+#include "VirtualClock.h"
+#include "WireFormat.h"
+
+static const uint32_t PERIOD_MS = 250;   // Measurement period
+static const uint32_t AIRTIME_US = 800;  // ESP-NOW frame at 1 Mbps
+static const uint8_t NODE_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t OTHER_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+static const uint8_t OPERATOR_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x99};
+static const uint8_t BROADCAST_MAC[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t KEY[WireFormat::CONTROL_KEY_SIZE] = {0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+                                                          0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef};
+
+static Logger logger(nullptr, nullptr, false, false);
+
+namespace {
+
+/**
+ * @brief SettingsStore in memory (the NVS of the device)
+ */
+class MemoryStore : public SettingsStore {
+public:
+    ControlRecord record = {};
+    bool saved = false;
+    uint32_t saves = 0;
+
+    bool load(ControlRecord& out) override {
+        out = record;
+        return saved;
+    }
+
+    bool save(const ControlRecord& in) override {
+        record = in;
+        saved = true;
+        saves++;
+        return true;
+    }
+};
+
+/**
+ * @brief One anemometer node, stepped one measurement period at a time
+ */
+struct Node {
+    VirtualClock clock;
+    FakeAdcSource adc;
+    SimRadio radio;
+    Anemometer anemometer;
+    TurbulenceAnalyzer analyzer;
+    Communication comm;
+    AnemometerControl target;
+    ControlChannel control;
+    uint32_t maxApplyNs;   // Longest applyPending() that changed something
+    uint32_t lastSamples;   // Conversions processed in the last period
+
+    explicit Node(SettingsStore* store)
+        : clock(), adc(), radio(NODE_MAC), anemometer(adc, clock, AcquisitionMode::Replay, 860), analyzer(clock),
+          comm(radio, clock), target(anemometer, comm, logger, clock), control(target, store), maxApplyNs(0),
+          lastSamples(0) {
+    }
+
+    /**
+     * @brief Set up as setup() does
+     * @param keyed false for a build without a fleet key: the channel stays off
+     * @return true if saved settings were restored
+     */
+    bool begin(bool keyed = true) {
+        adc.setSignal(120, 40, 20.0f, 6);
+        radio.setDriver(4, AIRTIME_US);
+        comm.setup();
+        anemometer.setup();
+        anemometer.setAnalyzer(&analyzer);
+        target.begin();
+        if (!keyed) {
+            return false;
+        }
+        bool restored = control.begin(KEY, NODE_MAC);
+        comm.setControl(control);
+        return restored;
+    }
+
+    /**
+     * @brief One period: producer, then the analysis and transmit stages
+     */
+    void period() {
+        clock.advanceUs(PERIOD_MS * 1000ULL);
+        radio.advance(clock.micros());
+        auto start = std::chrono::steady_clock::now();
+        bool applied = target.applyPending();
+        uint32_t applyNs = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        if (applied && applyNs > maxApplyNs) {
+            maxApplyNs = applyNs;
+        }
+        uint32_t before = anemometer.getSamplesProcessed();
+        anemometer.update();
+        lastSamples = anemometer.getSamplesProcessed() - before;
+        analyzer.service(clock.millis());
+        AnemometerData data = {};
+        memcpy(data.macAddress, NODE_MAC, sizeof(NODE_MAC));
+        data.windSpeed = anemometer.getWindSpeed();
+        data.fields = WireFormat::FIELD_STATS;
+        WindStats stats = anemometer.getStatistics();
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        comm.offer(data, clock.millis());
+    }
+
+    /**
+     * @brief Deliver a frame from the operator, run one period and pick up the reply
+     * @return false if the node did not answer
+     */
+    bool exchange(const uint8_t* frame, size_t length, ControlMessage& reply) {
+        radio.receive(OPERATOR_MAC, frame, length, clock.micros());
+        uint32_t before = radio.sent();
+        period();
+        for (uint32_t age = 0; age < radio.sent() - before && age < SimRadio::HISTORY_SIZE; age++) {
+            const SimRadio::Frame* sent = radio.frame(age);
+            if (sent && WireFormat::frameType(sent->data, sent->length) == WireFormat::MSG_CONTROL_REPLY &&
+                WireFormat::decodeControl(sent->data, sent->length, KEY, reply)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Sign a command
+ */
+static size_t command(uint8_t code, uint32_t counter, const uint8_t target[6], const uint8_t* payload, size_t length,
+                      const uint8_t key[WireFormat::CONTROL_KEY_SIZE], uint8_t* out, size_t capacity) {
+    ControlMessage message = {};
+    memcpy(message.macAddress, target, sizeof(message.macAddress));
+    message.counter = counter;
+    message.command = code;
+    message.length = static_cast<uint8_t>(length);
+    memcpy(message.payload, payload, length);
+    return WireFormat::encodeControl(WireFormat::MSG_CONTROL, message, key, out, capacity);
+}
+
+/**
+ * @brief Sign a CMD_SET_SETTINGS command
+ */
+static size_t setCommand(uint32_t counter, uint8_t groups, const DeviceSettings& settings, uint8_t* out,
+                         size_t capacity) {
+    uint8_t payload[1 + WireFormat::SETTINGS_SIZE];
+    payload[0] = groups;
+    WireFormat::encodeSettings(settings, payload + 1, sizeof(payload) - 1);
+    return command(WireFormat::CMD_SET_SETTINGS, counter, BROADCAST_MAC, payload, sizeof(payload), KEY, out, capacity);
+}
+
+static bool sameSettings(const DeviceSettings& a, const DeviceSettings& b) {
+    uint8_t encodedA[WireFormat::SETTINGS_SIZE];
+    uint8_t encodedB[WireFormat::SETTINGS_SIZE];
+    WireFormat::encodeSettings(a, encodedA, sizeof(encodedA));
+    WireFormat::encodeSettings(b, encodedB, sizeof(encodedB));
+    return memcmp(encodedA, encodedB, sizeof(encodedA)) == 0;
+}
+
+static const char* verdict(bool ok) {
+    return ok ? "OK" : "FAILED";
+}
+
+/**
+ * @brief SipHash-2-4 against the reference vectors (key 00..0f, message 00, 01, ...)
+ */
+static bool checkSipHash() {
+    static const struct {
+        size_t length;
+        uint64_t hash;
+    } VECTORS[] = {{0, 0x726fdb47dd0e0e31ULL}, {15, 0xa129ca6149be45e5ULL}, {63, 0x958a324ceb064572ULL}};
+    uint8_t key[SipHash::KEY_SIZE];
+    uint8_t message[64];
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = static_cast<uint8_t>(i);
+    }
+    for (size_t i = 0; i < sizeof(message); i++) {
+        message[i] = static_cast<uint8_t>(i);
+    }
+    bool ok = true;
+    for (const auto& vector : VECTORS) {
+        ok = ok && SipHash::hash(key, message, vector.length) == vector.hash;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    static const uint32_t RUNS = 100000;
+    uint64_t sink = 0;
+    for (uint32_t i = 0; i < RUNS; i++) {
+        message[0] = static_cast<uint8_t>(i);
+        sink ^= SipHash::hash(key, message, WireFormat::CONTROL_HEADER_SIZE + WireFormat::SETTINGS_SIZE + 1);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / RUNS;
+    printf("SipHash-2-4: reference vectors %s, %.0f ns per SET command tag (%llx)\n", verdict(ok), ns,
+           static_cast<unsigned long long>(sink & 0xF));
+    return ok;
+}
+
+int runControlCheck(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    bool ok = checkSipHash();
+
+    MemoryStore store;
+    Node node(&store);
+    node.begin();
+    for (int i = 0; i < 4; i++) {
+        node.period();
+    }
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    uint8_t otherKey[WireFormat::CONTROL_KEY_SIZE];
+    memcpy(otherKey, KEY, sizeof(otherKey));
+    otherKey[0] ^= 1;
+    ControlMessage reply;
+    uint32_t counter = 1000;
+
+    // Settings in force
+    size_t length = command(WireFormat::CMD_GET_SETTINGS, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    DeviceSettings initial = {};
+    bool got = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_OK &&
+               reply.counter == counter && memcmp(reply.macAddress, NODE_MAC, sizeof(NODE_MAC)) == 0 &&
+               WireFormat::decodeSettings(reply.payload, reply.length, initial) && initial.sampleRate == 860 &&
+               initial.decimation == AdcFilter::DEFAULT_CONFIG.decimation &&
+               initial.heartbeatMs == BroadcastPolicy::DEFAULT_CONFIG.heartbeatMs;
+    printf("Get settings: %u SPS, median %u, decimation %u, CIC %u, smoothing %u, heartbeat %lu ms: %s\n",
+           initial.sampleRate, initial.medianSize, initial.decimation, initial.cicOrder, initial.smoothingShift,
+           static_cast<unsigned long>(initial.heartbeatMs), verdict(got));
+    ok = ok && got;
+
+    // Refused frames: another key, played again, another node
+    uint32_t accepted = node.control.commands();
+    length = command(WireFormat::CMD_RESET_COUNTERS, ++counter, NODE_MAC, nullptr, 0, otherKey, frame, sizeof(frame));
+    bool forged = !node.exchange(frame, length, reply) && node.control.rejected() == 1;
+    length = command(WireFormat::CMD_GET_SETTINGS, counter - 1, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    bool replayed = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_STALE &&
+                    reply.length == 4 && node.control.rejected() == 2;
+    uint32_t stale = reply.payload[0] | reply.payload[1] << 8 | reply.payload[2] << 16 |
+                     static_cast<uint32_t>(reply.payload[3]) << 24;
+    replayed = replayed && stale == counter - 1;
+    length = command(WireFormat::CMD_GET_SETTINGS, ++counter, OTHER_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    bool ignored = !node.exchange(frame, length, reply) && node.control.commands() == accepted;
+    printf("Refused: other key %s, replayed command %s (last counter %lu), other node's command %s: %s\n",
+           forged ? "dropped" : "ACCEPTED", replayed ? "stale" : "EXECUTED", static_cast<unsigned long>(stale),
+           ignored ? "ignored" : "EXECUTED", verdict(forged && replayed && ignored));
+    ok = ok && forged && replayed && ignored;
+
+    // Out of range: nothing changes, not even the valid group of the same command
+    DeviceSettings invalid = initial;
+    invalid.sampleRate = 100;
+    invalid.heartbeatMs = 4000;
+    length = setCommand(++counter, WireFormat::SET_SAMPLING | WireFormat::SET_POLICY, invalid, frame, sizeof(frame));
+    bool refused = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_INVALID &&
+                   node.comm.policy().config().heartbeatMs == initial.heartbeatMs &&
+                   node.anemometer.getSampleRate() == 860;
+    invalid = initial;
+    invalid.decimation = 3;
+    length = setCommand(++counter, WireFormat::SET_FILTER, invalid, frame, sizeof(frame));
+    refused = refused && node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_INVALID;
+    length = command(0x7F, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    refused = refused && node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_UNKNOWN_COMMAND;
+    uint8_t noGroup[1 + WireFormat::SETTINGS_SIZE] = {};
+    length = command(WireFormat::CMD_SET_SETTINGS, ++counter, NODE_MAC, noGroup, sizeof(noGroup), KEY, frame,
+                     sizeof(frame));
+    refused = refused && node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_INVALID;
+    printf("Invalid: rate 100 SPS, decimation 3, unknown command, empty group mask, nothing changed: %s\n",
+           verdict(refused));
+    ok = ok && refused;
+
+    // Sample rate and filter: both reach the producer in the period after the command
+    DeviceSettings tuned = initial;
+    tuned.sampleRate = 250;
+    tuned.decimation = 2;
+    length = setCommand(++counter, WireFormat::SET_SAMPLING | WireFormat::SET_FILTER, tuned, frame, sizeof(frame));
+    DeviceSettings answered = {};
+    bool queued = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_OK &&
+                  WireFormat::decodeSettings(reply.payload, reply.length, answered) && sameSettings(answered, tuned);
+    bool notYet = node.anemometer.getSampleRate() == 860 && node.anemometer.getFilter().config().decimation == 4;
+    uint32_t beforeSamples = node.lastSamples;
+    node.period();
+    bool together = node.anemometer.getSampleRate() == 250 && node.anemometer.getFilter().config().decimation == 2;
+    node.period();
+    float expectedRate = 250.0f / 2 / 16; // Filter output at 125 Hz, averaged by 16
+    bool flowing = node.lastSamples >= 62 && node.lastSamples <= 63 && node.analyzer.sampleRate() == expectedRate;
+    printf("Sample rate and filter: queued %s, untouched until the next period %s, then applied together %s; "
+           "%lu then %lu conversions per period, analysis at %.3f Hz, applied in %.1f us: %s\n",
+           queued ? "yes" : "NO", notYet ? "yes" : "NO", together ? "yes" : "NO",
+           static_cast<unsigned long>(beforeSamples), static_cast<unsigned long>(node.lastSamples),
+           node.analyzer.sampleRate(), node.maxApplyNs / 1000.0,
+           verdict(queued && notYet && together && flowing));
+    ok = ok && queued && notYet && together && flowing;
+
+    // Transmit policy (the intervals are put in order) and log level: applied at once
+    tuned.minIntervalMs = 500;
+    tuned.rampStartMs = 100;
+    tuned.heartbeatMs = 5000;
+    tuned.speedDeadband = 0.5f;
+    tuned.logLevel = static_cast<uint8_t>(LogLevel::Warning);
+    length = setCommand(++counter, WireFormat::SET_POLICY | WireFormat::SET_LOGGING, tuned, frame, sizeof(frame));
+    bool policy = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_OK &&
+                  WireFormat::decodeSettings(reply.payload, reply.length, answered) && answered.rampStartMs == 500 &&
+                  node.comm.policy().config().heartbeatMs == 5000 &&
+                  !logger.enabled(LogModule::Communication, LogLevel::Info) &&
+                  logger.enabled(LogModule::Anemometer, LogLevel::Warning);
+    tuned.rampStartMs = 500;
+    printf("Policy and log level: heartbeat %lu ms, ramp %lu ms (asked 100), log level %u: %s\n",
+           static_cast<unsigned long>(node.comm.policy().config().heartbeatMs),
+           static_cast<unsigned long>(answered.rampStartMs), answered.logLevel, verdict(policy));
+    ok = ok && policy;
+
+    // Acquisition changes queue while the producer does not run: the fifth finds the queue full
+    bool busy = true;
+    for (size_t i = 0; i <= AnemometerControl::QUEUE_SIZE; i++) {
+        uint8_t answer[WireFormat::MAX_FRAME_SIZE];
+        length = setCommand(++counter, WireFormat::SET_SAMPLING, tuned, frame, sizeof(frame));
+        size_t answerLength = node.control.handle(frame, length, answer, sizeof(answer));
+        uint8_t expected = i < AnemometerControl::QUEUE_SIZE ? WireFormat::STATUS_OK : WireFormat::STATUS_BUSY;
+        busy = busy && WireFormat::decodeControl(answer, answerLength, KEY, reply) && reply.status == expected;
+    }
+    node.period();
+    printf("Producer stalled: %u changes queued, the next one busy: %s\n",
+           static_cast<unsigned>(AnemometerControl::QUEUE_SIZE), verdict(busy));
+    ok = ok && busy;
+
+    // Counters
+    length = command(WireFormat::CMD_GET_STATS, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    DeviceStats stats = {};
+    bool counted = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_OK &&
+                   WireFormat::decodeStats(reply.payload, reply.length, stats) &&
+                   stats.samples == node.anemometer.getSamplesProcessed() && stats.rejected == 2 &&
+                   stats.commands == node.control.commands() && stats.radioQueued > 0;
+    length = command(WireFormat::CMD_RESET_COUNTERS, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    bool reset = node.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_OK;
+    DeviceStats cleared = {};
+    length = command(WireFormat::CMD_GET_STATS, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    reset = reset && node.exchange(frame, length, reply) &&
+            WireFormat::decodeStats(reply.payload, reply.length, cleared) && cleared.commands == 1 &&
+            cleared.rejected == 0 && cleared.framesSent <= 2 && cleared.samples == node.anemometer.getSamplesProcessed();
+    printf("Stats: %lu frames, %lu commands, %lu rejected; after reset %lu frames, %lu commands, %lu rejected: %s\n",
+           static_cast<unsigned long>(stats.framesSent), static_cast<unsigned long>(stats.commands),
+           static_cast<unsigned long>(stats.rejected), static_cast<unsigned long>(cleared.framesSent),
+           static_cast<unsigned long>(cleared.commands), static_cast<unsigned long>(cleared.rejected),
+           verdict(counted && reset));
+    ok = ok && counted && reset;
+
+    // Power cycle: a new node on the same store
+    Node rebooted(&store);
+    bool restored = rebooted.begin();
+    rebooted.period();
+    DeviceSettings after;
+    rebooted.target.getSettings(after);
+    bool same = restored && sameSettings(after, tuned) && rebooted.anemometer.getSampleRate() == tuned.sampleRate &&
+                rebooted.anemometer.getFilter().config().decimation == tuned.decimation &&
+                rebooted.comm.policy().config().heartbeatMs == tuned.heartbeatMs &&
+                rebooted.control.lastCounter() == counter - 1;
+    length = command(WireFormat::CMD_RESET_COUNTERS, counter - 1, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    bool noReplay = rebooted.exchange(frame, length, reply) && reply.status == WireFormat::STATUS_STALE;
+    printf("Reboot: %lu store writes, settings restored %s, counter %lu, reset played again %s: %s\n",
+           static_cast<unsigned long>(store.saves), same ? "yes" : "NO",
+           static_cast<unsigned long>(rebooted.control.lastCounter()), noReplay ? "stale" : "EXECUTED",
+           verdict(same && noReplay));
+    ok = ok && same && noReplay;
+
+    // Build without a fleet key: commands ignored, even signed with the zero key, and
+    // the saved settings left alone; keys that are not 32 hex digits or all zero refused
+    Node unkeyed(&store);
+    unkeyed.begin(false);
+    unkeyed.period();
+    length = command(WireFormat::CMD_GET_SETTINGS, ++counter, NODE_MAC, nullptr, 0, KEY, frame, sizeof(frame));
+    bool off = !unkeyed.exchange(frame, length, reply) && unkeyed.anemometer.getSampleRate() == 860;
+    uint8_t zeroKey[WireFormat::CONTROL_KEY_SIZE] = {};
+    uint8_t answer[WireFormat::MAX_FRAME_SIZE];
+    length = command(WireFormat::CMD_RESET_COUNTERS, ++counter, NODE_MAC, nullptr, 0, zeroKey, frame, sizeof(frame));
+    off = off && unkeyed.control.handle(frame, length, answer, sizeof(answer)) == 0 &&
+          unkeyed.control.commands() == 0;
+    uint8_t parsed[WireFormat::CONTROL_KEY_SIZE];
+    bool keys = ControlChannel::parseKey("0123456789abcdefFEDCBA9876543210", parsed) && parsed[0] == 0x01 &&
+                parsed[15] == 0x10 && !ControlChannel::parseKey("", parsed) &&
+                !ControlChannel::parseKey(nullptr, parsed) &&
+                !ControlChannel::parseKey("00000000000000000000000000000000", parsed) &&
+                !ControlChannel::parseKey("0123456789abcdef0123456789abcde", parsed) &&
+                !ControlChannel::parseKey("0123456789abcdef0123456789abcdeg", parsed);
+    printf("No fleet key: commands %s, saved settings %s, malformed keys %s: %s\n", off ? "ignored" : "EXECUTED",
+           unkeyed.anemometer.getSampleRate() == 860 ? "not applied" : "APPLIED", keys ? "refused" : "ACCEPTED",
+           verdict(off && keys));
+    ok = ok && off && keys;
+
+    printf("%s\n", verdict(ok));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,449 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file ControlTool.cpp
+ * @brief Operator tool for the control channel, and a node to try it on
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * "node" runs the firmware chain in real time on a host: a simulated converter in
+ * continuous mode (the reader thread paces the conversions), the filter, the
+ * turbulence analysis, the broadcast policy and the control channel, over a
+ * UdpRadio instead of ESP-NOW. It prints its settings and counters every few
+ * seconds, so a change sent by "ctl" shows up in the conversion rate.
+ *
+ * Both take the fleet key from --key or from the ANEMOMETER_CONTROL_KEY environment
+ * variable, the one the firmware is built with.
+ *
+ * "ctl" is the operator side: it signs one command with the fleet key, sends it
+ * with the Unix time as counter (or --counter), waits for the reply and prints it.
+ * A STATUS_STALE reply (the node saw a higher counter) is retried once above the
+ * counter it carries. "set" reads the settings first, so only the options given
+ * change, and sends the groups they belong to in one command.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "AnemometerControl.h"
+#include "ControlChannel.h"
+#include "FakeAdcSource.h"
+#include "HostCommands.h"
+#include "HostConsole.h"
+#include "Logger.h"
+#include "SpscRing.h"
+#include "SystemClock.h"
+#include "TurbulenceAnalyzer.h"
+#include "UdpRadio.h"
+#include "WireFormat.h"
+
+static const uint16_t NODE_PORT = 47000;        // UDP port of the node
+static const uint16_t TOOL_PORT = 47001;        // UDP port of the operator tool
+static const uint32_t PERIOD_MS = 250;          // Measurement period
+static const uint32_t STATUS_EVERY = 20;        // Node status line every 5 s
+static const uint32_t REPLY_TIMEOUT_MS = 2000;  // The node answers within one period, when the radio has room
+static const uint8_t NODE_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t OPERATOR_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x99};
+
+// Environment variable holding the fleet key, as for the firmware build
+static const char* KEY_VARIABLE = "ANEMOMETER_CONTROL_KEY";
+
+// Static lifetime: the classes keep a pointer to the logger
+static HostConsole console;
+static Logger logger(&console, nullptr, true, false);
+
+/**
+ * @brief Read the fleet key given with --key, or else from the environment
+ * @param text --key value, nullptr if not given
+ */
+static bool fleetKey(const char* text, uint8_t key[WireFormat::CONTROL_KEY_SIZE]) {
+    if (!text) {
+        text = getenv(KEY_VARIABLE);
+    }
+    if (!ControlChannel::parseKey(text, key)) {
+        printf("No fleet key: --key or %s, 32 hex digits (not all zero)\n", KEY_VARIABLE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse "AA:BB:CC:DD:EE:FF"
+ */
+static bool parseMac(const char* text, uint8_t mac[RadioTransport::MAC_SIZE]) {
+    unsigned int bytes[RadioTransport::MAC_SIZE];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x", &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]) != 6) {
+        return false;
+    }
+    for (size_t i = 0; i < RadioTransport::MAC_SIZE; i++) {
+        mac[i] = static_cast<uint8_t>(bytes[i]);
+    }
+    return true;
+}
+
+static void printSettings(const DeviceSettings& settings) {
+    printf("  sample rate     %u SPS\n", settings.sampleRate);
+    printf("  filter          median %u, decimation %u, CIC order %u, smoothing shift %u\n", settings.medianSize,
+           settings.decimation, settings.cicOrder, settings.smoothingShift);
+    printf("  deadbands       speed %.2f m/s, gust %.2f m/s\n", settings.speedDeadband, settings.gustDeadband);
+    printf("  intervals       min %lu ms, ramp %lu ms, heartbeat %lu ms, fixed %lu ms\n",
+           static_cast<unsigned long>(settings.minIntervalMs), static_cast<unsigned long>(settings.rampStartMs),
+           static_cast<unsigned long>(settings.heartbeatMs), static_cast<unsigned long>(settings.fixedIntervalMs));
+    printf("  log level       %u\n", settings.logLevel);
+}
+
+static void printStats(const DeviceStats& stats) {
+    printf("  uptime          %lu s\n", static_cast<unsigned long>(stats.uptimeS));
+    printf("  conversions     %lu (%lu overruns, %lu spikes)\n", static_cast<unsigned long>(stats.samples),
+           static_cast<unsigned long>(stats.overruns), static_cast<unsigned long>(stats.spikes));
+    printf("  frames          %lu sent by the policy, %lu queued, %lu failed\n",
+           static_cast<unsigned long>(stats.framesSent), static_cast<unsigned long>(stats.radioQueued),
+           static_cast<unsigned long>(stats.radioFailed));
+    printf("  control         %lu commands, %lu rejected\n", static_cast<unsigned long>(stats.commands),
+           static_cast<unsigned long>(stats.rejected));
+}
+
+int runNode(int argc, char** argv) {
+    uint16_t port = NODE_PORT;
+    uint16_t peer = TOOL_PORT;
+    uint32_t seconds = 60;
+    const char* keyText = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = static_cast<uint16_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--peer") == 0 && i + 1 < argc) {
+            peer = static_cast<uint16_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+            keyText = argv[++i];
+        }
+    }
+    uint8_t key[WireFormat::CONTROL_KEY_SIZE];
+    if (!fleetKey(keyText, key)) {
+        return 1;
+    }
+
+    // As in setup(), without the display and the slots
+    SystemClock clock;
+    FakeAdcSource adc;
+    adc.setSignal(120, 40, 20.0f, 6);
+    UdpRadio radio(clock, port, peer, NODE_MAC);
+    Anemometer anemometer(adc, clock, AcquisitionMode::Continuous, 860);
+    TurbulenceAnalyzer analyzer(clock);
+    Communication comm(radio, clock);
+    AnemometerControl target(anemometer, comm, logger, clock);
+    ControlChannel control(target);
+    Anemometer::setLogger(logger);
+    Communication::setLogger(logger);
+    comm.setup();
+    if (!radio.begin()) {
+        printf("UDP port %u not available\n", port);
+        return 1;
+    }
+    anemometer.setup();
+    anemometer.setAnalyzer(&analyzer);
+    target.begin();
+    control.begin(key, NODE_MAC);
+    comm.setControl(control);
+    printf("Node %s on UDP port %u, replies to port %u, %lu s\n", "02:00:00:00:00:01", port, peer,
+           static_cast<unsigned long>(seconds));
+
+    uint32_t periods = seconds * 1000 / PERIOD_MS;
+    uint32_t lastWakeMs = RtosTask::nowMs();
+    uint32_t lastSamples = 0;
+    for (uint32_t period = 1; period <= periods; period++) {
+        RtosTask::sleepUntil(lastWakeMs, PERIOD_MS);
+        target.applyPending();
+        anemometer.update();
+        analyzer.service(clock.millis());
+        AnemometerData data = {};
+        memcpy(data.macAddress, NODE_MAC, sizeof(NODE_MAC));
+        data.windSpeed = anemometer.getWindSpeed();
+        data.fields = WireFormat::FIELD_STATS;
+        WindStats stats = anemometer.getStatistics();
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        comm.offer(data, clock.millis());
+
+        if (period % STATUS_EVERY == 0) {
+            uint32_t samples = anemometer.getSamplesProcessed();
+            DeviceSettings settings;
+            target.getSettings(settings);
+            printf("%5lu s: %u SPS (%lu conversions/s), decimation %u, heartbeat %lu ms, %lu frames, "
+                   "%lu commands, %lu rejected\n",
+                   static_cast<unsigned long>(period * PERIOD_MS / 1000), settings.sampleRate,
+                   static_cast<unsigned long>((samples - lastSamples) * 1000 / (STATUS_EVERY * PERIOD_MS)),
+                   settings.decimation, static_cast<unsigned long>(settings.heartbeatMs),
+                   static_cast<unsigned long>(comm.policy().sent()), static_cast<unsigned long>(control.commands()),
+                   static_cast<unsigned long>(control.rejected()));
+            fflush(stdout);
+            lastSamples = samples;
+        }
+    }
+    anemometer.stop();
+    radio.stop();
+    return 0;
+}
+
+namespace {
+
+/**
+ * @brief A datagram heard by the tool
+ */
+struct ToolFrame {
+    uint8_t data[UdpRadio::MAX_FRAME];
+    size_t length;
+};
+
+} // namespace
+
+static SpscRing<ToolFrame, 16> toolFrames;
+
+/**
+ * @brief Receive handler of the tool: keep the control replies
+ */
+static void onToolFrame(void* context, const uint8_t source[RadioTransport::MAC_SIZE], const uint8_t* data,
+                        size_t length, uint32_t rxUs) {
+    (void)context;
+    (void)source;
+    (void)rxUs;
+    if (WireFormat::frameType(data, length) != WireFormat::MSG_CONTROL_REPLY || length > UdpRadio::MAX_FRAME) {
+        return;
+    }
+    ToolFrame frame;
+    memcpy(frame.data, data, length);
+    frame.length = length;
+    toolFrames.push(frame);
+}
+
+/**
+ * @brief Send one command and wait for its reply, retrying once above a stale counter
+ * @return false on time-out
+ */
+static bool request(UdpRadio& radio, const uint8_t key[WireFormat::CONTROL_KEY_SIZE], const uint8_t target[6],
+                    uint32_t& counter, uint8_t code, const uint8_t* payload, size_t length, ControlMessage& reply) {
+    static const uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    for (int attempt = 0; attempt < 2; attempt++) {
+        ControlMessage message = {};
+        memcpy(message.macAddress, target, sizeof(message.macAddress));
+        message.counter = counter;
+        message.command = code;
+        message.length = static_cast<uint8_t>(length);
+        memcpy(message.payload, payload, length);
+        uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+        size_t frameLength = WireFormat::encodeControl(WireFormat::MSG_CONTROL, message, key, frame, sizeof(frame));
+        if (frameLength == 0 || radio.send(broadcastAddress, frame, frameLength) != RadioTransport::SendStatus::Queued) {
+            return false;
+        }
+        bool answered = false;
+        for (uint32_t startMs = RtosTask::nowMs(); !answered && RtosTask::nowMs() - startMs < REPLY_TIMEOUT_MS;) {
+            ToolFrame received;
+            if (!toolFrames.pop(received)) {
+                RtosTask::sleepMs(10);
+                continue;
+            }
+            answered = WireFormat::decodeControl(received.data, received.length, key, reply) &&
+                       reply.counter == counter && reply.command == code;
+        }
+        if (!answered) {
+            return false;
+        }
+        if (reply.status != WireFormat::STATUS_STALE || reply.length < 4) {
+            counter++;
+            return true;
+        }
+        uint32_t last = reply.payload[0] | reply.payload[1] << 8 | reply.payload[2] << 16 |
+                        static_cast<uint32_t>(reply.payload[3]) << 24;
+        printf("Counter %lu stale, node is at %lu: retrying\n", static_cast<unsigned long>(counter),
+               static_cast<unsigned long>(last));
+        counter = last + 1;
+    }
+    return true; // Still stale: reported by the caller
+}
+
+static const char* statusName(uint8_t status) {
+    switch (status) {
+    case WireFormat::STATUS_OK:
+        return "ok";
+    case WireFormat::STATUS_UNKNOWN_COMMAND:
+        return "unknown command";
+    case WireFormat::STATUS_INVALID:
+        return "invalid, nothing changed";
+    case WireFormat::STATUS_STALE:
+        return "stale counter";
+    case WireFormat::STATUS_BUSY:
+        return "busy, nothing changed, try again";
+    default:
+        return "?";
+    }
+}
+
+int runControlTool(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: ctl <get|set|stats|reset> [--target MAC] [--key HEX] [--counter N] [--port P] [--peer P]\n"
+               "  set: [--rate SPS] [--median N] [--decimation N] [--cic N] [--smoothing N] [--speed-deadband M/S]\n"
+               "       [--gust-deadband M/S] [--min-interval MS] [--ramp MS] [--heartbeat MS] [--fixed MS]\n"
+               "       [--log-level 0-3]\n");
+        return 1;
+    }
+    const char* action = argv[1];
+    const char* keyText = nullptr;
+    uint8_t target[RadioTransport::MAC_SIZE];
+    memset(target, 0xFF, sizeof(target));
+    uint32_t counter = static_cast<uint32_t>(time(nullptr));
+    uint16_t port = TOOL_PORT;
+    uint16_t peer = NODE_PORT;
+    DeviceSettings wanted = {};
+    uint8_t groups = 0;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) {
+            printf("Missing value for %s\n", argv[i]);
+            return 1;
+        }
+        const char* option = argv[i];
+        const char* value = argv[++i];
+        if (strcmp(option, "--target") == 0) {
+            if (!parseMac(value, target)) {
+                printf("Bad MAC address %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(option, "--key") == 0) {
+            keyText = value;
+        } else if (strcmp(option, "--counter") == 0) {
+            counter = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        } else if (strcmp(option, "--port") == 0) {
+            port = static_cast<uint16_t>(atoi(value));
+        } else if (strcmp(option, "--peer") == 0) {
+            peer = static_cast<uint16_t>(atoi(value));
+        } else if (strcmp(option, "--rate") == 0) {
+            wanted.sampleRate = static_cast<uint16_t>(atoi(value));
+            groups |= WireFormat::SET_SAMPLING;
+        } else if (strcmp(option, "--median") == 0) {
+            wanted.medianSize = static_cast<uint8_t>(atoi(value));
+            groups |= WireFormat::SET_FILTER;
+        } else if (strcmp(option, "--decimation") == 0) {
+            wanted.decimation = static_cast<uint8_t>(atoi(value));
+            groups |= WireFormat::SET_FILTER;
+        } else if (strcmp(option, "--cic") == 0) {
+            wanted.cicOrder = static_cast<uint8_t>(atoi(value));
+            groups |= WireFormat::SET_FILTER;
+        } else if (strcmp(option, "--smoothing") == 0) {
+            wanted.smoothingShift = static_cast<uint8_t>(atoi(value));
+            groups |= WireFormat::SET_FILTER;
+        } else if (strcmp(option, "--speed-deadband") == 0) {
+            wanted.speedDeadband = static_cast<float>(atof(value));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--gust-deadband") == 0) {
+            wanted.gustDeadband = static_cast<float>(atof(value));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--min-interval") == 0) {
+            wanted.minIntervalMs = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--ramp") == 0) {
+            wanted.rampStartMs = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--heartbeat") == 0) {
+            wanted.heartbeatMs = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--fixed") == 0) {
+            wanted.fixedIntervalMs = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            groups |= WireFormat::SET_POLICY;
+        } else if (strcmp(option, "--log-level") == 0) {
+            wanted.logLevel = static_cast<uint8_t>(atoi(value));
+            groups |= WireFormat::SET_LOGGING;
+        } else {
+            printf("Unknown option %s\n", option);
+            return 1;
+        }
+    }
+    uint8_t key[WireFormat::CONTROL_KEY_SIZE];
+    if (!fleetKey(keyText, key)) {
+        return 1;
+    }
+
+    SystemClock clock;
+    UdpRadio radio(clock, port, peer, OPERATOR_MAC);
+    radio.setReceiveHandler(onToolFrame, nullptr);
+    if (!radio.begin()) {
+        printf("UDP port %u not available\n", port);
+        return 1;
+    }
+    ControlMessage reply;
+    bool answered;
+    if (strcmp(action, "get") == 0) {
+        answered = request(radio, key, target, counter, WireFormat::CMD_GET_SETTINGS, nullptr, 0, reply);
+    } else if (strcmp(action, "stats") == 0) {
+        answered = request(radio, key, target, counter, WireFormat::CMD_GET_STATS, nullptr, 0, reply);
+    } else if (strcmp(action, "reset") == 0) {
+        answered = request(radio, key, target, counter, WireFormat::CMD_RESET_COUNTERS, nullptr, 0, reply);
+    } else if (strcmp(action, "set") == 0) {
+        if (groups == 0) {
+            printf("Nothing to set\n");
+            return 1;
+        }
+        // Start from the settings in force: the options given replace fields of their groups only
+        DeviceSettings settings;
+        answered = request(radio, key, target, counter, WireFormat::CMD_GET_SETTINGS, nullptr, 0, reply) &&
+                   reply.status == WireFormat::STATUS_OK &&
+                   WireFormat::decodeSettings(reply.payload, reply.length, settings);
+        if (answered) {
+            for (int i = 2; i + 1 < argc; i += 2) {
+                const char* option = argv[i];
+                if (strcmp(option, "--rate") == 0) settings.sampleRate = wanted.sampleRate;
+                else if (strcmp(option, "--median") == 0) settings.medianSize = wanted.medianSize;
+                else if (strcmp(option, "--decimation") == 0) settings.decimation = wanted.decimation;
+                else if (strcmp(option, "--cic") == 0) settings.cicOrder = wanted.cicOrder;
+                else if (strcmp(option, "--smoothing") == 0) settings.smoothingShift = wanted.smoothingShift;
+                else if (strcmp(option, "--speed-deadband") == 0) settings.speedDeadband = wanted.speedDeadband;
+                else if (strcmp(option, "--gust-deadband") == 0) settings.gustDeadband = wanted.gustDeadband;
+                else if (strcmp(option, "--min-interval") == 0) settings.minIntervalMs = wanted.minIntervalMs;
+                else if (strcmp(option, "--ramp") == 0) settings.rampStartMs = wanted.rampStartMs;
+                else if (strcmp(option, "--heartbeat") == 0) settings.heartbeatMs = wanted.heartbeatMs;
+                else if (strcmp(option, "--fixed") == 0) settings.fixedIntervalMs = wanted.fixedIntervalMs;
+                else if (strcmp(option, "--log-level") == 0) settings.logLevel = wanted.logLevel;
+            }
+            uint8_t payload[1 + WireFormat::SETTINGS_SIZE];
+            payload[0] = groups;
+            WireFormat::encodeSettings(settings, payload + 1, sizeof(payload) - 1);
+            answered = request(radio, key, target, counter, WireFormat::CMD_SET_SETTINGS, payload, sizeof(payload),
+                               reply);
+        }
+    } else {
+        printf("Unknown action %s\n", action);
+        return 1;
+    }
+    radio.stop();
+    if (!answered) {
+        printf("No reply (node not running, other key, or other target)\n");
+        return 1;
+    }
+
+    char mac[18];
+    WireFormat::formatMacAddress(reply.macAddress, mac);
+    printf("%s: counter %lu, %s\n", mac, static_cast<unsigned long>(reply.counter), statusName(reply.status));
+    DeviceSettings settings;
+    DeviceStats stats;
+    if (reply.command == WireFormat::CMD_GET_STATS && WireFormat::decodeStats(reply.payload, reply.length, stats)) {
+        printStats(stats);
+    } else if (reply.status != WireFormat::STATUS_STALE &&
+               WireFormat::decodeSettings(reply.payload, reply.length, settings)) {
+        printSettings(settings);
+    }
+    return reply.status == WireFormat::STATUS_OK ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file DisplayBench.cpp
+ * @brief Renderer savings against a full repaint, on the simulated display
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Renders a synthetic gusty wind and reports the pixel bytes pushed per frame,
+ * against the 32 KB of the former fillScreen() + text repaint. The last frame can
+ * be saved as a PPM image to check the layout.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostCommands.h"
+#include "DisplayRenderer.h"
+#include "SimDisplay.h"
+#include "SystemClock.h"
+
+int runDisplayBench(int argc, char** argv) {
+    const char* imagePath = nullptr;
+    uint32_t frames = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-') {
+            imagePath = argv[i];
+        } else {
+            fprintf(stderr, "Usage: display [image.ppm] [--frames N]\n");
+            return 1;
+        }
+    }
+
+    SimDisplay display;
+    SystemClock clock;
+    DisplayRenderer renderer(display, clock);
+    uint64_t totalUs = 0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        // 2 s frames: slow oscillation around 8 m/s with faster gusts on top
+        float t = frame * 2.0f;
+        float speed = 8.0f + 3.0f * sinf(t / 120.0f) + 1.5f * sinf(t / 7.0f);
+        float gust = speed + 2.0f + 1.0f * sinf(t / 3.0f);
+        float lull = speed - 2.5f;
+        renderer.render(speed, gust, lull);
+        totalUs += renderer.lastFrameUs();
+    }
+
+    printf("%lu frames: %lu bytes/frame on average (full repaint: %lu), %.1f%% of the full repaint\n",
+           static_cast<unsigned long>(renderer.frames()), static_cast<unsigned long>(renderer.averageFrameBytes()),
+           static_cast<unsigned long>(DisplayRenderer::FULL_FRAME_BYTES),
+           100.0 * renderer.averageFrameBytes() / DisplayRenderer::FULL_FRAME_BYTES);
+    printf("Last frame %lu bytes, host frame time %.1f us average, %lu us max\n",
+           static_cast<unsigned long>(renderer.lastFrameBytes()), frames ? static_cast<double>(totalUs) / frames : 0.0,
+           static_cast<unsigned long>(renderer.maxFrameUs()));
+    if (imagePath) {
+        if (!display.writePpm(imagePath)) {
+            fprintf(stderr, "Cannot write %s\n", imagePath);
+            return 1;
+        }
+        printf("Last frame saved to %s\n", imagePath);
+    }
+    return 0;
+}
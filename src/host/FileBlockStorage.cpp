@@ -0,0 +1,87 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FileBlockStorage.cpp
+ * @brief Host directory implementation of BlockStorage
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "FileBlockStorage.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileBlockStorage::FileBlockStorage(const char* directory, bool durable) : durable_(durable), file_(nullptr) {
+    snprintf(directory_, sizeof(directory_), "%s", directory);
+}
+
+FileBlockStorage::~FileBlockStorage() {
+    close();
+}
+
+bool FileBlockStorage::fullPath(const char* path, char* out, size_t capacity) const {
+    int length = snprintf(out, capacity, "%s/%s", directory_, path[0] == '/' ? path + 1 : path);
+    return length > 0 && static_cast<size_t>(length) < capacity;
+}
+
+bool FileBlockStorage::begin() {
+    struct stat info;
+    return stat(directory_, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool FileBlockStorage::exists(const char* path) {
+    char full[MAX_PATH];
+    struct stat info;
+    return fullPath(path, full, sizeof(full)) && stat(full, &info) == 0;
+}
+
+bool FileBlockStorage::open(const char* path, uint32_t size) {
+    close();
+    char full[MAX_PATH];
+    if (!fullPath(path, full, sizeof(full))) {
+        return false;
+    }
+    file_ = fopen(full, "w+b");
+    if (!file_) {
+        return false;
+    }
+    // Reserve the blocks like a pre-allocated FAT file; fall back to a sparse file
+    if (posix_fallocate(fileno(file_), 0, size) != 0 && ftruncate(fileno(file_), size) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool FileBlockStorage::write(const uint8_t* data, size_t length) {
+    return file_ && fwrite(data, 1, length, file_) == length;
+}
+
+bool FileBlockStorage::sync() {
+    if (!file_ || fflush(file_) != 0) {
+        return false;
+    }
+    return !durable_ || fsync(fileno(file_)) == 0;
+}
+
+void FileBlockStorage::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
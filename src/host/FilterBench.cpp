@@ -0,0 +1,191 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FilterBench.cpp
+ * @brief Golden vectors, noise reduction and cost per sample of the ADC filter chain
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The golden vectors were computed with a straightforward reference (sorted
+ * windows for the median, the CIC as a convolution with its boxcar^order impulse
+ * response); both process() in odd-sized blocks and push() must reproduce them bit
+ * for bit. The cost is measured on blocks of 64 codes, as Anemometer::update()
+ * drains them, in ns and (on x86) TSC cycles per input code.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "AdcFilter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+static volatile int64_t sink;
+
+// Slow ramp with two spikes (codes)
+static const int16_t GOLDEN_INPUT[] = {300, 302, 305, 301, 299, 4000, 303, 306, 310, 312, 315, 313, 318, -2000, 320, 322,
+                                       325, 330, 328, 333, 335, 334, 340, 342, 338, 345, 347, 350, 352, 349, 355, 358};
+static const size_t GOLDEN_SIZE = sizeof(GOLDEN_INPUT) / sizeof(GOLDEN_INPUT[0]);
+
+namespace {
+
+struct GoldenVector {
+    AdcFilter::Config config;
+    size_t count;
+    int32_t expected[GOLDEN_SIZE]; // Q8
+};
+
+} // namespace
+
+static const GoldenVector GOLDEN[] = {
+    {{3, 1, 1, 0}, 32, {76800, 76800, 77312, 77312, 77056, 77056, 77568, 78336, 78336, 79360, 79872,
+                        80128, 80640, 80128, 81408, 81920, 82432, 83200, 83968, 84480, 85248, 85504,
+                        85760, 87040, 87040, 87552, 88320, 88832, 89600, 89600, 90112, 90880}},
+    {{5, 1, 1, 0}, 32, {76800, 76800, 76800, 77056, 77056, 77312, 77568, 77568, 78336, 79360, 79360,
+                        79872, 80128, 80128, 80640, 81408, 81920, 82432, 83200, 83968, 84480, 85248,
+                        85504, 85760, 86528, 87040, 87552, 88320, 88832, 89344, 89600, 90112}},
+    {{3, 4, 2, 2}, 6, {78656, 79104, 79960, 81230, 82710, 84360}},
+    {{5, 2, 1, 3}, 15, {76928, 76960, 77036, 77262, 77556, 77877, 78270, 78758, 79361, 80048, 80746, 81500,
+                        82304, 83152, 83990}},
+    {{1, 4, 3, 0}, 5, {24796, -10348, 84736, 86808, 88980}}, // No median: the spikes leak through
+};
+
+/**
+ * @brief Check one golden vector through process() (odd block sizes) and push()
+ */
+static bool checkGolden(const GoldenVector& golden) {
+    AdcFilter blocks(golden.config);
+    AdcFilter single(golden.config);
+    int32_t out[GOLDEN_SIZE + 1];
+    size_t count = 0;
+    for (size_t pos = 0, chunk = 1; pos < GOLDEN_SIZE; pos += chunk, chunk += 2) {
+        size_t length = GOLDEN_SIZE - pos < chunk ? GOLDEN_SIZE - pos : chunk;
+        count += blocks.process(GOLDEN_INPUT + pos, length, out + count);
+    }
+    bool ok = count == golden.count;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = out[i] == golden.expected[i];
+    }
+    size_t pushed = 0;
+    for (size_t i = 0; ok && i < GOLDEN_SIZE; i++) {
+        int32_t value;
+        if (single.push(GOLDEN_INPUT[i], value)) {
+            ok = pushed < golden.count && value == golden.expected[pushed];
+            pushed++;
+        }
+    }
+    ok = ok && pushed == golden.count;
+    printf("  median %u, CIC %u/%u, smoothing 1/%-3u %2zu outputs  %s\n", golden.config.medianSize,
+           golden.config.cicOrder, golden.config.decimation, 1u << golden.config.smoothingShift, golden.count,
+           ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+/**
+ * @brief Noisy 860 SPS signal: 300 codes, Gaussian noise, occasional spikes
+ */
+static void noisySignal(int16_t* codes, size_t count, uint32_t& seed) {
+    for (size_t i = 0; i < count; i++) {
+        float gauss = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            gauss += (seed >> 8) * (1.0f / 16777216.0f) - 0.5f;
+        }
+        int32_t code = 300 + static_cast<int32_t>(gauss * 14.0f); // ~8 codes rms
+        if (seed % 200 == 0) {
+            code += seed & 1 ? 3000 : -3000;
+        }
+        codes[i] = static_cast<int16_t>(code);
+    }
+}
+
+int runFilterBench(int argc, char** argv) {
+    uint32_t blocks = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 200000;
+    if (blocks == 0) {
+        fprintf(stderr, "Usage: filter [blocks]\n");
+        return 1;
+    }
+
+    printf("Golden vectors:\n");
+    bool ok = true;
+    for (const GoldenVector& golden : GOLDEN) {
+        ok = checkGolden(golden) && ok;
+    }
+
+    static const AdcFilter::Config CONFIGS[] = {
+        AdcFilter::PASS_THROUGH, AdcFilter::SINGLE_SHOT_CONFIG, {5, 1, 1, 0}, AdcFilter::DEFAULT_CONFIG,
+        {5, 16, 3, 4},
+    };
+    static const size_t SIGNAL = 1 << 14;
+    static int16_t codes[SIGNAL];
+    static int32_t out[SIGNAL + 1];
+    uint32_t seed = 99;
+    noisySignal(codes, SIGNAL, seed);
+
+    printf("\n%-28s %10s %9s %12s %8s %8s\n", "configuration", "out SPS", "rms code", "ns/sample", "cycles", "spikes");
+    for (const AdcFilter::Config& config : CONFIGS) {
+        AdcFilter filter(config);
+
+        // Noise left at the output (codes rms around the true level), spikes excluded from the input figure
+        size_t count = filter.process(codes, SIGNAL, out);
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            double error = out[i] / 256.0 - 300.0;
+            sum += error * error;
+        }
+        double rms = count ? sqrt(sum / count) : 0.0;
+        uint32_t spikes = filter.spikes();
+
+        filter.reset();
+        const size_t block = AdcFilter::BLOCK;
+        auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+        uint64_t startTsc = __rdtsc();
+#endif
+        int64_t accumulator = 0;
+        for (uint32_t b = 0; b < blocks; b++) {
+            size_t offset = (b * block) & (SIGNAL - 1);
+            size_t written = filter.process(codes + offset, block, out);
+            accumulator += written ? out[written - 1] : 0;
+        }
+#ifdef HAVE_TSC
+        uint64_t tsc = __rdtsc() - startTsc;
+#endif
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        sink = accumulator;
+        double samples = static_cast<double>(blocks) * block;
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / samples;
+
+        char name[40];
+        snprintf(name, sizeof(name), "median %u, CIC %u/%u, 1/%u", config.medianSize, config.cicOrder,
+                 config.decimation, 1u << config.smoothingShift);
+        printf("%-28s %10u %9.2f %12.2f", name, filter.outputRate(860), rms, ns);
+#ifdef HAVE_TSC
+        printf(" %8.1f", tsc / samples);
+#else
+        printf(" %8s", "-");
+#endif
+        printf(" %8u\n", spikes);
+    }
+    return ok ? 0 : 1;
+}
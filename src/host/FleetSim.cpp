@@ -0,0 +1,376 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file FleetSim.cpp
+ * @brief Fleet of anemometers sharing one channel: free-running against slotted transmits
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Every node has its own clock (random origin, so micros() wraps, and a drift of up
+ * to 40 ppm) and wakes up late by a random amount, with occasional millisecond
+ * preemptions. Frames overlapping in time are lost for every receiver (no capture
+ * effect), and a node cannot hear while it transmits. Boat transmitters add random
+ * traffic that follows no schedule.
+ *
+ * The free-running mode sends as soon as a frame is due, like the former firmware.
+ * The slotted mode runs each node's SlotScheduler, fed with the frames that node
+ * actually heard. Delivery is counted at a reference receiver and between nodes.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "HostCommands.h"
+#include "HostRandom.h"
+#include "SlotScheduler.h"
+
+static const uint32_t AIRTIME_US = 780;         // ~75-byte ESP-NOW frame at 1 Mbps
+static const double BOAT_RATE_HZ = 10.0;        // Frames per second per boat
+
+namespace {
+
+/**
+ * @brief Simulation parameters
+ */
+struct FleetConfig {
+    uint32_t nodes;
+    uint32_t boats;
+    uint32_t periodMs;
+    uint32_t seconds;
+    bool slotted;
+    uint32_t seed;
+};
+
+/**
+ * @brief Delivery results of one run
+ */
+struct FleetResult {
+    uint64_t sent;
+    uint64_t received;          // At the reference receiver
+    uint64_t settledSent;       // Last quarter of the run
+    uint64_t settledReceived;
+    uint64_t peerPossible;      // Node-to-node deliveries possible
+    uint64_t peerDelivered;
+    uint64_t peerMissed;        // Node-to-node frames lost (to compare with the estimates)
+    uint32_t reselections;
+    uint32_t missedSlots;
+    uint32_t maxLatenessUs;
+    double estimatedLoss;       // Average of the per-slot estimates over all nodes
+};
+
+struct Node {
+    SlotScheduler scheduler;
+    uint8_t mac[SlotScheduler::MAC_SIZE];
+    double originUs;        // Local time at global time 0
+    double rate;            // Local microseconds per global microsecond
+    double dueLocalUs;      // Next frame generation time, local clock
+    double txGlobalUs;      // Planned start of the next frame, global time
+    uint16_t sequence;
+    uint64_t received;      // Frames heard from the other nodes
+};
+
+struct AirFrame {
+    int node;               // Sender, -1 for a boat
+    double startUs;
+    double endUs;
+    uint16_t sequence;
+    bool finalized;
+};
+
+class Fleet {
+private:
+    const FleetConfig& config_;
+    Random random_;
+    std::vector<Node> nodes_;
+    std::vector<AirFrame> air_;
+    FleetResult result_;
+    double settledFromUs_;
+
+    double local(const Node& node, double globalUs) const {
+        return node.originUs + globalUs * node.rate;
+    }
+
+    double global(const Node& node, double localUs) const {
+        return (localUs - node.originUs) / node.rate;
+    }
+
+    /**
+     * @brief Wake-up lateness: a little scheduling noise, sometimes a preemption
+     */
+    double lateness() {
+        double late = random_.uniform() * 150.0;
+        if (random_.uniform() < 0.03) {
+            late += 500.0 + random_.uniform() * 2500.0;
+        }
+        return late;
+    }
+
+    /**
+     * @brief Plan the transmission of the frame due at node.dueLocalUs
+     */
+    void plan(Node& node) {
+        double due = node.dueLocalUs;
+        if (!config_.slotted) {
+            node.txGlobalUs = global(node, due + lateness());
+            return;
+        }
+        // What Communication does on the device: wait for the slot, check, retry once
+        double target = due + node.scheduler.delayUs(static_cast<uint32_t>(static_cast<uint64_t>(due)));
+        double actual = target + lateness();
+        if (!node.scheduler.maySend(static_cast<uint32_t>(static_cast<uint64_t>(actual)))) {
+            node.scheduler.recordMissedSlot();
+            target = actual + node.scheduler.delayUs(static_cast<uint32_t>(static_cast<uint64_t>(actual)));
+            actual = target + lateness();
+        }
+        node.scheduler.recordSend(static_cast<uint32_t>(static_cast<uint64_t>(actual)),
+                                  static_cast<uint32_t>(static_cast<uint64_t>(target)));
+        node.txGlobalUs = global(node, actual);
+    }
+
+    /**
+     * @brief Decide who received a frame once every frame overlapping it is known
+     */
+    void finalize(const AirFrame& frame) {
+        bool collided = false;
+        for (const AirFrame& other : air_) {
+            if (&other != &frame && other.startUs < frame.endUs && other.endUs > frame.startUs) {
+                collided = true;
+                break;
+            }
+        }
+        if (frame.node < 0) {
+            return;
+        }
+        bool settled = frame.startUs >= settledFromUs_;
+        result_.sent++;
+        result_.settledSent += settled;
+        result_.received += !collided;
+        result_.settledReceived += settled && !collided;
+
+        const Node& sender = nodes_[frame.node];
+        for (size_t j = 0; j < nodes_.size(); j++) {
+            if (static_cast<int>(j) == frame.node) {
+                continue;
+            }
+            result_.peerPossible++;
+            bool transmitting = false;
+            for (const AirFrame& other : air_) {
+                if (other.node == static_cast<int>(j) && other.startUs < frame.endUs && other.endUs > frame.startUs) {
+                    transmitting = true;
+                    break;
+                }
+            }
+            if (collided || transmitting) {
+                result_.peerMissed++;
+                continue;
+            }
+            Node& receiver = nodes_[j];
+            result_.peerDelivered++;
+            receiver.received++;
+            if (config_.slotted) {
+                receiver.scheduler.observe(sender.mac, frame.sequence,
+                                           static_cast<uint32_t>(static_cast<uint64_t>(local(receiver, frame.endUs))));
+            }
+        }
+    }
+
+    /**
+     * @brief Finalize the frames that ended before the given time, forget the old ones
+     *
+     * A frame that ended is only finalized once the next event is known, so every
+     * frame overlapping it is already in the list.
+     */
+    void settle(double nowUs) {
+        for (AirFrame& frame : air_) {
+            if (!frame.finalized && frame.endUs <= nowUs) {
+                finalize(frame);
+                frame.finalized = true;
+            }
+        }
+        size_t kept = 0;
+        for (const AirFrame& frame : air_) {
+            if (!frame.finalized || frame.endUs > nowUs - AIRTIME_US) {
+                air_[kept++] = frame;
+            }
+        }
+        air_.resize(kept);
+    }
+
+public:
+    Fleet(const FleetConfig& config) : config_(config), random_(config.seed), result_() {
+        nodes_.resize(config.nodes);
+        double periodUs = config.periodMs * 1000.0;
+        for (uint32_t i = 0; i < config.nodes; i++) {
+            Node& node = nodes_[i];
+            // Espressif-like OUI, random device part
+            uint64_t bits = random_.next();
+            const uint8_t mac[SlotScheduler::MAC_SIZE] = {0x48, 0x27, 0xE2, static_cast<uint8_t>(bits),
+                                                          static_cast<uint8_t>(bits >> 8),
+                                                          static_cast<uint8_t>(bits >> 16)};
+            memcpy(node.mac, mac, sizeof(mac));
+            node.scheduler.begin(node.mac);
+            node.originUs = random_.uniform() * 4294967296.0;
+            node.rate = 1.0 + (random_.uniform() * 2.0 - 1.0) * 40e-6;
+            node.dueLocalUs = local(node, random_.uniform() * periodUs);
+            node.sequence = 0;
+            node.received = 0;
+            plan(node);
+        }
+        settledFromUs_ = config.seconds * 1e6 * 0.75;
+    }
+
+    FleetResult run() {
+        double endUs = config_.seconds * 1e6;
+        double boatRateUs = config_.boats * BOAT_RATE_HZ / 1e6;
+        double nextBoatUs = boatRateUs > 0.0 ? -log(1.0 - random_.uniform()) / boatRateUs : endUs;
+        double periodUs = config_.periodMs * 1000.0;
+        for (;;) {
+            size_t first = 0;
+            for (size_t i = 1; i < nodes_.size(); i++) {
+                if (nodes_[i].txGlobalUs < nodes_[first].txGlobalUs) {
+                    first = i;
+                }
+            }
+            double nowUs = nodes_[first].txGlobalUs < nextBoatUs ? nodes_[first].txGlobalUs : nextBoatUs;
+            if (nowUs >= endUs) {
+                break;
+            }
+            settle(nowUs);
+            if (nextBoatUs <= nowUs) {
+                air_.push_back({-1, nowUs, nowUs + AIRTIME_US, 0, false});
+                nextBoatUs += -log(1.0 - random_.uniform()) / boatRateUs;
+                continue;
+            }
+            Node& node = nodes_[first];
+            air_.push_back({static_cast<int>(first), nowUs, nowUs + AIRTIME_US, node.sequence++, false});
+            // Next frame; a radio busy with this one cannot start before it ends
+            node.dueLocalUs += periodUs;
+            plan(node);
+            double busyUntil = nowUs + AIRTIME_US;
+            if (node.txGlobalUs < busyUntil) {
+                node.txGlobalUs = busyUntil;
+            }
+        }
+        settle(endUs + 4.0 * AIRTIME_US);
+
+        double lossSum = 0.0;
+        uint32_t lossCount = 0;
+        for (const Node& node : nodes_) {
+            result_.reselections += node.scheduler.reselections();
+            result_.missedSlots += node.scheduler.missedSlots();
+            if (node.scheduler.maxLatenessUs() > result_.maxLatenessUs) {
+                result_.maxLatenessUs = node.scheduler.maxLatenessUs();
+            }
+            for (uint16_t slot = 0; slot < SlotScheduler::SLOT_COUNT; slot++) {
+                SlotStats stats = node.scheduler.slotStats(slot, 0);
+                if (stats.received > 0) {
+                    lossSum += node.scheduler.lossEstimate(slot) * (stats.received + stats.missed);
+                    lossCount += stats.received + stats.missed;
+                }
+            }
+        }
+        result_.estimatedLoss = lossCount ? lossSum / lossCount : 0.0;
+        return result_;
+    }
+
+    /**
+     * @brief Per-slot view of one node
+     */
+    void printSlots(size_t index) const {
+        const Node& node = nodes_[index];
+        uint32_t nowUs = static_cast<uint32_t>(static_cast<uint64_t>(local(node, config_.seconds * 1e6)));
+        printf("\nSlots seen by node 0 (own slot %u, %lu conflicts, %lu reselections, lead %lu us):\n",
+               node.scheduler.slot(), static_cast<unsigned long>(node.scheduler.conflicts()),
+               static_cast<unsigned long>(node.scheduler.reselections()),
+               static_cast<unsigned long>(node.scheduler.leadUs()));
+        printf("slot  occupants  received  missed  loss\n");
+        for (uint16_t slot = 0; slot < SlotScheduler::SLOT_COUNT; slot++) {
+            SlotStats stats = node.scheduler.slotStats(slot, nowUs);
+            if (stats.received || stats.occupants) {
+                printf("%4u  %9u  %8lu  %6lu  %4.1f%%\n", slot, stats.occupants,
+                       static_cast<unsigned long>(stats.received), static_cast<unsigned long>(stats.missed),
+                       100.0f * node.scheduler.lossEstimate(slot));
+            }
+        }
+    }
+};
+
+} // namespace
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+int runFleetSim(int argc, char** argv) {
+    FleetConfig config = {0, 0, 250, 120, false, 1};
+    bool showSlots = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            config.nodes = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--boats") == 0 && i + 1 < argc) {
+            config.boats = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            config.periodMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            config.seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--slots") == 0) {
+            showSlots = true;
+        } else {
+            fprintf(stderr, "Usage: fleet [--nodes N] [--boats N] [--period MS] [--seconds N] [--seed N] [--slots]\n");
+            return 1;
+        }
+    }
+    if (config.periodMs * 1000 < SlotScheduler::SUPERFRAME_US) {
+        fprintf(stderr, "Period must be at least one superframe (%lu us)\n",
+                static_cast<unsigned long>(SlotScheduler::SUPERFRAME_US));
+        return 1;
+    }
+
+    static const uint32_t SWEEP[] = {2, 5, 10, 20, 30, 40, 50};
+    const uint32_t* counts = config.nodes ? &config.nodes : SWEEP;
+    size_t countCount = config.nodes ? 1 : sizeof(SWEEP) / sizeof(SWEEP[0]);
+
+    printf("Frame every %lu ms per node, %lu boats at %.0f Hz, %lu s, %u slots of %lu us\n",
+           static_cast<unsigned long>(config.periodMs), static_cast<unsigned long>(config.boats), BOAT_RATE_HZ,
+           static_cast<unsigned long>(config.seconds), SlotScheduler::SLOT_COUNT,
+           static_cast<unsigned long>(SlotScheduler::SLOT_US));
+    printf("nodes   free: delivered  settled   slotted: delivered  settled  peers  est.loss  true loss  "
+           "reselect  missed  max late\n");
+    for (size_t i = 0; i < countCount; i++) {
+        FleetConfig run = config;
+        run.nodes = counts[i];
+        run.slotted = false;
+        FleetResult free = Fleet(run).run();
+        run.slotted = true;
+        Fleet slottedFleet(run);
+        FleetResult slotted = slottedFleet.run();
+        printf("%5lu   %14.2f%% %7.2f%%   %17.2f%% %7.2f%% %5.1f%% %8.2f%% %9.2f%%  %8lu  %6lu  %5lu us\n",
+               static_cast<unsigned long>(run.nodes), percent(free.received, free.sent),
+               percent(free.settledReceived, free.settledSent), percent(slotted.received, slotted.sent),
+               percent(slotted.settledReceived, slotted.settledSent),
+               percent(slotted.peerDelivered, slotted.peerPossible), 100.0 * slotted.estimatedLoss,
+               percent(slotted.peerMissed, slotted.peerPossible), static_cast<unsigned long>(slotted.reselections),
+               static_cast<unsigned long>(slotted.missedSlots), static_cast<unsigned long>(slotted.maxLatenessUs));
+        if (showSlots && i + 1 == countCount) {
+            slottedFleet.printSlots(0);
+        }
+    }
+    return 0;
+}
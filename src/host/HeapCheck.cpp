@@ -0,0 +1,197 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HeapCheck.cpp
+ * @brief Check that the steady-state measurement loop makes no heap allocation
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Builds the firmware chain on a virtual clock the way setup() does: the converter
+ * in replay mode (filter, lookup table, statistics), the turbulence analysis, the
+ * wind screen on a simulated display, the deferred logger with its task, the TDMA
+ * slots and the time beacons of a reference node, the transmit path on a simulated
+ * ESP-NOW driver, the session statistics with their periodic fit, export and
+ * summary requests, and a FleetReceiver decoding every frame sent. Then HeapMonitor
+ * is marked steady, as at the end of setup(), and --hours of measurement periods
+ * run like the pipeline stages would. Any allocation counted by the malloc hooks
+ * after the mark fails the check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Anemometer.h"
+#include "Communication.h"
+#include "DisplayRenderer.h"
+#include "FakeAdcSource.h"
+#include "FleetReceiver.h"
+#include "HeapMonitor.h"
+#include "HostCommands.h"
+#include "HostConsole.h"
+#include "Logger.h"
+#include "SessionStatistics.h"
+#include "SimDisplay.h"
+#include "SimRadio.h"
+#include "SlotScheduler.h"
+#include "TimeSync.h"
+#include "TurbulenceAnalyzer.h"
+#include "VirtualClock.h"
+#include "WireFormat.h"
+
+static const uint32_t PERIOD_MS = 250;   // Measurement period
+static const uint32_t LOG_EVERY = 8;     // Log line every 2 s, as the firmware
+static const uint32_t AIRTIME_US = 800;  // ESP-NOW anemometer frame at 1 Mbps
+static const uint32_t SESSION_SAVE_EVERY = 240;   // Fit and export every minute, as the firmware
+static const uint32_t SUMMARY_REQUEST_EVERY = 40; // A receiver asks for the summary every 10 s
+
+// Static lifetime: the classes keep a pointer to the logger
+static HostConsole console(true);
+static SimDisplay screen;
+static Logger logger(&console, &screen, true, false);
+static FleetReceiver receiver; // Large (per-sender windows), kept off the stack
+static SessionStatistics session;
+static SessionRecord sessionRecord;
+
+int runHeapCheck(int argc, char** argv) {
+    float hours = 1.0f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = static_cast<float>(atof(argv[++i]));
+        }
+    }
+    uint32_t periods = static_cast<uint32_t>(hours * 3600.0f * 1000.0f / PERIOD_MS);
+    if (HeapMonitor::allocations() == 0) {
+        printf("No allocation hooks in this build (glibc only), nothing to check\n");
+        return 1;
+    }
+
+    // Initialisation, as in setup()
+    VirtualClock clock;
+    FakeAdcSource adc;
+    adc.setSignal(120, 40, 20.0f, 6);
+    SimRadio radio;
+    radio.setDriver(4, AIRTIME_US);
+    Anemometer anemometer(adc, clock, AcquisitionMode::Replay, 860);
+    TurbulenceAnalyzer analyzer(clock);
+    Communication comm(radio, clock);
+    DisplayRenderer renderer(screen, clock);
+    SlotScheduler slots;
+    TimeSync timeSync;
+    Anemometer::setLogger(logger);
+    Communication::setLogger(logger);
+    comm.setup();
+    anemometer.setup();
+    anemometer.setAnalyzer(&analyzer);
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    radio.macAddress(mac);
+    slots.begin(mac);
+    comm.setScheduler(slots);
+    timeSync.begin(mac, TimeSync::Role::Reference);
+    comm.setTimeSync(timeSync);
+    comm.enableSummaryRequests();
+    receiver.begin(mac);
+    if (!logger.startAsync()) {
+        printf("Logger task start failed\n");
+        return 1;
+    }
+    uint32_t setupAllocations = HeapMonitor::allocations();
+    printf("Initialisation: %lu allocations, %lu frees; %lu periods (%.1f h) of steady state\n",
+           static_cast<unsigned long>(setupAllocations), static_cast<unsigned long>(HeapMonitor::frees()),
+           static_cast<unsigned long>(periods), hours);
+    fflush(stdout);
+    HeapMonitor::markSteadyState();
+
+    // Steady state: producer, then the transmit, log, display and analysis stages
+    TurbulenceResult turbulence = {};
+    bool turbulencePending = false;
+    uint32_t frames = 0;
+    uint32_t summaries = 0;
+    static const uint8_t requesterMac[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x99};
+    uint8_t request[WireFormat::SUMMARY_REQUEST_SIZE];
+    SummaryRequest summaryRequest;
+    memset(summaryRequest.target, 0xFF, sizeof(summaryRequest.target));
+    size_t requestLength = WireFormat::encodeSummaryRequest(summaryRequest, request, sizeof(request));
+    for (uint32_t period = 0; period < periods; period++) {
+        clock.advanceUs(PERIOD_MS * 1000ULL);
+        uint32_t nowMs = clock.millis();
+        radio.advance(clock.micros());
+        anemometer.update();
+        WindStats stats = anemometer.getStatistics();
+        session.addSample(anemometer.getWindSpeed(), nowMs);
+        if (period % SESSION_SAVE_EVERY == 0) {
+            session.fitWeibull();
+            session.exportRecord(sessionRecord);
+        }
+        if (period % SUMMARY_REQUEST_EVERY == 0) {
+            radio.receive(requesterMac, request, requestLength, clock.micros());
+        }
+
+        if (analyzer.takeResult(turbulence)) {
+            turbulencePending = true;
+            logger.logf(LogModule::Main, LogLevel::Info, "Turbulence: %.1f%% (%.2f +/- %.2f m/s), gust period %.1f s",
+                        100.0f * turbulence.intensity, turbulence.mean, turbulence.stddev, turbulence.gustPeriod);
+        }
+        AnemometerData data = {};
+        memcpy(data.macAddress, mac, sizeof(mac));
+        data.windSpeed = anemometer.getWindSpeed();
+        data.fields = WireFormat::FIELD_STATS;
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        if (turbulencePending) {
+            data.fields |= WireFormat::FIELD_TURBULENCE;
+            data.turbulenceIntensity = turbulence.intensity;
+            data.gustFrequency = turbulence.gustFrequency;
+        }
+        uint32_t before = radio.sent();
+        if (comm.offer(data, nowMs)) {
+            turbulencePending = false;
+        } else if (comm.summaryRequested()) {
+            SessionSummary summary = {};
+            session.summary(summary);
+            if (comm.broadcastSummary(summary)) {
+                summaries++;
+            }
+        }
+        for (uint32_t i = before; i < radio.sent() && i - before < SimRadio::HISTORY_SIZE; i++) {
+            const SimRadio::Frame* frame = radio.frame(radio.sent() - 1 - i);
+            if (frame && receiver.receive(frame->data, frame->length, clock.micros())) {
+                frames++;
+            }
+        }
+        receiver.poll(clock.micros());
+
+        if (period % LOG_EVERY == 0) {
+            logger.logf(LogModule::Main, LogLevel::Info, "Wind Speed: %.2f m/s, Gust: %.2f m/s, Lull: %.2f m/s, Mean: %.2f m/s",
+                        data.windSpeed, stats.gust, stats.lull, stats.mean);
+        }
+        renderer.render(data.windSpeed, stats.gust, stats.lull);
+        analyzer.service(nowMs);
+    }
+    logger.stopAsync();
+
+    uint32_t steady = HeapMonitor::steadyAllocations();
+    printf("Steady state: %lu frames decoded, %lu analyses, %lu screen frames, %lu session summaries\n",
+           static_cast<unsigned long>(frames), static_cast<unsigned long>(analyzer.analyses()),
+           static_cast<unsigned long>(renderer.frames()), static_cast<unsigned long>(summaries));
+    printf("Steady state: %lu allocations (%lu bytes)", static_cast<unsigned long>(steady),
+           static_cast<unsigned long>(HeapMonitor::steadyBytes()));
+    if (steady) {
+        printf(", the first of %lu bytes", static_cast<unsigned long>(HeapMonitor::firstSteadySize()));
+    }
+    printf("\n%s\n", steady == 0 ? "OK" : "FAILED");
+    return steady == 0 ? 0 : 1;
+}
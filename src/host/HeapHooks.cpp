@@ -0,0 +1,68 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HeapHooks.cpp
+ * @brief Allocation hooks of the host build (glibc malloc family replaced)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * glibc lets a program define malloc, calloc, realloc and free itself; these count
+ * the call and forward to the glibc allocator. Other C libraries: no hooks, the
+ * counters stay at zero.
+ */
+
+#include <stdlib.h>
+#include "HeapMonitor.h"
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size) noexcept;
+void* __libc_calloc(size_t count, size_t size) noexcept;
+void* __libc_realloc(void* pointer, size_t size) noexcept;
+void __libc_free(void* pointer) noexcept;
+
+void* malloc(size_t size) noexcept {
+    HeapMonitor::recordAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    HeapMonitor::recordAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    HeapMonitor::recordAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) noexcept {
+    if (pointer) {
+        HeapMonitor::recordFree();
+    }
+    __libc_free(pointer);
+}
+
+} // extern "C"
+
+#endif // __GLIBC__
+
+bool HeapMonitor::heapInfo(HeapInfo& info) {
+    (void)info;
+    return false;
+}
@@ -0,0 +1,128 @@
+#ifndef HOST_COMMANDS_H
+#define HOST_COMMANDS_H
+
+/**
+ * @brief Subcommand of the host program (native environment)
+ */
+struct HostCommand {
+    const char* name;                       // Name on the command line
+    const char* help;                       // One-line description
+    int (*run)(int argc, char** argv);      // Entry point, argv[0] is the subcommand name
+};
+
+/**
+ * @brief Time the hot paths of the firmware (conversion, statistics, encoding, logging)
+ */
+int runBenchmarks(int argc, char** argv);
+
+/**
+ * @brief Measure SD recording throughput against a file-backed stand-in and verify the files
+ */
+int runRecordBench(int argc, char** argv);
+
+/**
+ * @brief Compare the dirty-region renderer with a full repaint on the simulated display
+ */
+int runDisplayBench(int argc, char** argv);
+
+/**
+ * @brief Replay wind traces through the adaptive broadcast policy and the fixed schedule
+ */
+int runBroadcastSim(int argc, char** argv);
+
+/**
+ * @brief Check the ADC filter chain against golden vectors and time it per sample
+ */
+int runFilterBench(int argc, char** argv);
+
+/**
+ * @brief Simulate a fleet of anemometers on one channel, free-running against slotted
+ */
+int runFleetSim(int argc, char** argv);
+
+/**
+ * @brief Run the low-power duty cycle on a virtual clock and report the sleep ratio and charge
+ */
+int runPowerSim(int argc, char** argv);
+
+/**
+ * @brief Drive the transmit engine against a simulated ESP-NOW driver queue
+ */
+int runRadioBench(int argc, char** argv);
+
+/**
+ * @brief Check the turbulence spectrum against a NumPy reference and time one analysis
+ */
+int runTurbulenceBench(int argc, char** argv);
+
+/**
+ * @brief Write the binary raw sample stream to stdout (see tools/capture_stream.py)
+ */
+int runStreamBench(int argc, char** argv);
+
+/**
+ * @brief Replay recorded or synthetic codes through the whole measurement chain, faster than real time
+ */
+int runReplayBench(int argc, char** argv);
+
+/**
+ * @brief Synchronise drifting follower clocks to a reference node's beacons and report the error
+ */
+int runTimeSyncSim(int argc, char** argv);
+
+/**
+ * @brief Generate fleet traffic on a lossy channel and check the reference receiver against it
+ */
+int runTrafficSim(int argc, char** argv);
+
+/**
+ * @brief Time the boot to the first frame with a late or missing sensor and a cached calibration
+ */
+int runBootSim(int argc, char** argv);
+
+/**
+ * @brief Run the measurement loop after initialisation and fail on any heap allocation
+ */
+int runHeapCheck(int argc, char** argv);
+
+/**
+ * @brief Interleave several inputs of a simulated ADS1115 and check the rates, time stamps and mean direction
+ */
+int runMuxSim(int argc, char** argv);
+
+/**
+ * @brief Check the incremental session statistics against offline computations over the stored samples
+ */
+int runSessionCheck(int argc, char** argv);
+
+/**
+ * @brief Check the authenticated control channel: replay protection, invalid values, settings changes and persistence
+ */
+int runControlCheck(int argc, char** argv);
+
+/**
+ * @brief Run a node in real time on UDP loopback, with the control channel
+ */
+int runNode(int argc, char** argv);
+
+/**
+ * @brief Send one signed control command to a node and print the reply
+ */
+int runControlTool(int argc, char** argv);
+
+/**
+ * @brief Stress the SPSC ring and the pipeline stages on threads with slow consumers
+ */
+int runPipelineCheck(int argc, char** argv);
+
+/**
+ * @brief Check the rolling wind statistics against a naive recomputation over random traces
+ */
+int runWindStatsCheck(int argc, char** argv);
+
+/**
+ * @brief Check the calibration lookup table against the float conversion over every code
+ */
+int runCalibrationCheck(int argc, char** argv);
+
+#endif // HOST_COMMANDS_H
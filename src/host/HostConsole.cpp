@@ -0,0 +1,62 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file HostConsole.cpp
+ * @brief stdio implementation of Console (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "HostConsole.h"
+#include <stdio.h>
+#include <string.h>
+
+HostConsole::HostConsole(bool muted) : muted_(muted), bytesWritten_(0) {
+}
+
+bool HostConsole::begin(uint32_t baudRate) {
+    (void)baudRate;
+    return true;
+}
+
+void HostConsole::print(const char* text) {
+    write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+void HostConsole::println(const char* text) {
+    print(text);
+    write(reinterpret_cast<const uint8_t*>("\n"), 1);
+}
+
+size_t HostConsole::write(const uint8_t* data, size_t length) {
+    bytesWritten_ += length;
+    if (muted_) {
+        return length;
+    }
+    return fwrite(data, 1, length, stdout);
+}
+
+int HostConsole::read() {
+    return getchar();
+}
+
+void HostConsole::setMuted(bool muted) {
+    muted_ = muted;
+}
+
+uint32_t HostConsole::bytesWritten() const {
+    return bytesWritten_;
+}
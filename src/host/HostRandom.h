@@ -0,0 +1,41 @@
+#ifndef HOST_RANDOM_H
+#define HOST_RANDOM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Uniform random generator (xorshift64*) of the host simulations and checks.
+ *
+ * Seeded explicitly, so a run with the same options gives the same numbers.
+ */
+class Random {
+private:
+    uint64_t state_;
+
+public:
+    Random(uint64_t seed) : state_(seed ? seed : 1) {
+    }
+
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 2685821657736338717ULL;
+    }
+
+    /**
+     * @brief Uniform in [0, 1)
+     */
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * @brief Uniform integer in [0, n)
+     */
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>(uniform() * n);
+    }
+};
+
+#endif // HOST_RANDOM_H
@@ -0,0 +1,335 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file MuxSim.cpp
+ * @brief Interleaved multi-channel sampling on a simulated ADS1115
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The ChannelScheduler shares a simulated ADS1115 between four inputs (one per
+ * pin, single-ended): the anemometer, a potentiometer wind vane, the supply voltage
+ * and a temperature sensor. The anemometer, supply and temperature inputs carry
+ * ramps of time, each from its own base code: a sample whose code does not match
+ * the ramp at its time stamp was either read from the wrong conversion (stale
+ * register, wrong input) or stamped at the wrong time. The vane swings 40 degrees
+ * either side of north-north-west across north, where an arithmetic mean of the
+ * angles fails and the vector mean must not.
+ *
+ * The same channels run with the pipelined sequence and with the serial one (read,
+ * then start the next conversion), and every input asking for 860 SPS measures the
+ * conversion rate each sequence can reach.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ChannelScheduler.h"
+#include "HostCommands.h"
+#include "SimMuxAdc.h"
+#include "VirtualClock.h"
+#include "WindDirection.h"
+
+static const uint8_t WIND_INPUT = 4;          // AIN0 against GND
+static const uint8_t VANE_INPUT = 5;          // AIN1
+static const uint8_t SUPPLY_INPUT = 6;        // AIN2
+static const uint8_t TEMPERATURE_INPUT = 7;   // AIN3
+static const int RAMP_SHIFT = 7;              // One ramp code per 128 us
+static const int32_t RAMP_CODES = 2048;       // Ramp period (power of two: continuous across the micros() wrap)
+static const int32_t RAMP_TOLERANCE = 2;      // Codes, 256 us of time stamp error
+static const int32_t VANE_CODES_PER_TURN = 26400;
+static const float VANE_CENTRE = 337.5f;      // North-north-west
+static const float VANE_SWING = 40.0f;        // Degrees either side
+static const float VANE_PERIOD_S = 20.0f;
+static const uint32_t DRAIN_PERIOD_US = 250000; // Consumer period (measurement period)
+
+namespace {
+
+/**
+ * @brief Simulation parameters
+ */
+struct MuxSimConfig {
+    uint32_t seconds;
+    uint16_t converterRate;
+    uint16_t rates[4];          // Wind, vane, supply, temperature
+    float oscillatorError;
+};
+
+/**
+ * @brief Outcome of one run
+ */
+struct MuxSimResult {
+    uint32_t samples[ChannelScheduler::MAX_CHANNELS];
+    uint32_t skipped[ChannelScheduler::MAX_CHANNELS];
+    uint32_t overruns[ChannelScheduler::MAX_CHANNELS];
+    uint32_t maxLatenessUs[ChannelScheduler::MAX_CHANNELS];
+    uint32_t maxWindGapUs;
+    uint32_t offRamp;
+    uint32_t errors;
+    uint32_t ignoredStarts;
+    float load;
+    float conversionsPerSecond;
+    float converterBusy;
+    DirectionStats direction;
+    float arithmeticMean;
+};
+
+} // namespace
+
+static const char* const CHANNEL_NAMES[] = {"wind", "vane", "supply", "temperature"};
+static const uint8_t CHANNEL_INPUTS[] = {WIND_INPUT, VANE_INPUT, SUPPLY_INPUT, TEMPERATURE_INPUT};
+
+/**
+ * @brief Direction of the simulated vane
+ */
+static float vaneDegrees(uint32_t timeUs) {
+    float t = static_cast<float>(timeUs) / 1000000.0f;
+    float degrees = VANE_CENTRE + VANE_SWING * sinf(6.2831853f * t / VANE_PERIOD_S);
+    return degrees >= 360.0f ? degrees - 360.0f : degrees;
+}
+
+/**
+ * @brief Base code of the ramp of one input
+ */
+static int32_t rampBase(uint8_t input) {
+    return 4096 * (input - WIND_INPUT + 1);
+}
+
+/**
+ * @brief Input values: a ramp of time per input, the vane direction on its input
+ */
+static int16_t muxSignal(uint8_t input, uint32_t timeUs, void* context) {
+    (void)context;
+    if (input == VANE_INPUT) {
+        return static_cast<int16_t>(vaneDegrees(timeUs) / 360.0f * VANE_CODES_PER_TURN);
+    }
+    return static_cast<int16_t>(rampBase(input) + ((timeUs >> RAMP_SHIFT) & (RAMP_CODES - 1)));
+}
+
+/**
+ * @brief Check a ramp sample against its time stamp
+ */
+static bool onRamp(uint8_t input, const ChannelSample& sample) {
+    int32_t expected = (sample.timeUs >> RAMP_SHIFT) & (RAMP_CODES - 1);
+    int32_t difference = (sample.code - rampBase(input) - expected) & (RAMP_CODES - 1);
+    if (difference >= RAMP_CODES / 2) {
+        difference -= RAMP_CODES;
+    }
+    return difference >= -RAMP_TOLERANCE && difference <= RAMP_TOLERANCE;
+}
+
+/**
+ * @brief Run the scheduler over the configured time and check every sample
+ */
+static bool runMux(const MuxSimConfig& config, bool pipelined, MuxSimResult& result) {
+    static ChannelSample samples[ChannelScheduler::RING_SIZE];
+    memset(&result, 0, sizeof(result));
+
+    VirtualClock clock(0xFFFFFFFFULL - 3000000); // micros() wraps during the run
+    SimMuxAdc adc(clock);
+    adc.setSignal(muxSignal, nullptr);
+    adc.setOscillatorError(config.oscillatorError);
+    ChannelScheduler scheduler(adc, clock);
+    scheduler.setPipelined(pipelined);
+    int index[ChannelScheduler::MAX_CHANNELS];
+    for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+        index[i] = -1;
+        if (config.rates[i]) {
+            ChannelConfig channel = {CHANNEL_NAMES[i], CHANNEL_INPUTS[i], config.rates[i]};
+            index[i] = scheduler.addChannel(channel);
+        }
+    }
+    if (!scheduler.begin(config.converterRate)) {
+        return false;
+    }
+
+    WindDirection direction;
+    direction.setCalibration(0, VANE_CODES_PER_TURN);
+    double angleSum = 0.0;
+    uint32_t angles = 0;
+    bool windSeen = false;
+    uint32_t lastWindUs = 0;
+
+    uint64_t startUs = clock.nowUs();
+    uint64_t endUs = startUs + static_cast<uint64_t>(config.seconds) * 1000000;
+    uint64_t drainUs = startUs + DRAIN_PERIOD_US;
+    uint32_t startConversions = adc.conversions();
+    while (clock.nowUs() < endUs) {
+        uint32_t waitUs = scheduler.service();
+        uint64_t wakeUs = clock.nowUs() + waitUs;
+        if (wakeUs >= drainUs) {
+            // The consumer runs before the converter is served again
+            if (drainUs > clock.nowUs()) {
+                clock.advanceUs(drainUs - clock.nowUs());
+            }
+            drainUs += DRAIN_PERIOD_US;
+            uint32_t nowUs = clock.micros();
+            uint32_t nowMs = clock.millis();
+            for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+                if (index[i] < 0) {
+                    continue;
+                }
+                size_t count = scheduler.drain(index[i], samples, ChannelScheduler::RING_SIZE);
+                for (size_t n = 0; n < count; n++) {
+                    const ChannelSample& sample = samples[n];
+                    if (CHANNEL_INPUTS[i] == VANE_INPUT) {
+                        uint32_t sampleMs = nowMs - (nowUs - sample.timeUs) / 1000;
+                        direction.addCode(sample.code, sampleMs);
+                        angleSum += direction.codeToDegrees(sample.code);
+                        angles++;
+                        continue;
+                    }
+                    if (!onRamp(CHANNEL_INPUTS[i], sample)) {
+                        result.offRamp++;
+                    }
+                    if (CHANNEL_INPUTS[i] == WIND_INPUT) {
+                        if (windSeen && sample.timeUs - lastWindUs > result.maxWindGapUs) {
+                            result.maxWindGapUs = sample.timeUs - lastWindUs;
+                        }
+                        windSeen = true;
+                        lastWindUs = sample.timeUs;
+                    }
+                }
+            }
+        } else {
+            clock.advanceUs(waitUs);
+        }
+    }
+
+    for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+        if (index[i] >= 0) {
+            result.samples[i] = scheduler.samples(index[i]);
+            result.skipped[i] = scheduler.skipped(index[i]);
+            result.overruns[i] = scheduler.overruns(index[i]);
+            result.maxLatenessUs[i] = scheduler.maxLatenessUs(index[i]);
+        }
+    }
+    result.load = scheduler.load();
+    result.errors = scheduler.errors();
+    result.ignoredStarts = adc.ignoredStarts();
+    result.conversionsPerSecond = static_cast<float>(adc.conversions() - startConversions) / config.seconds;
+    result.converterBusy = static_cast<float>(adc.busyUs()) / (clock.nowUs() - startUs);
+    result.direction = direction.get();
+    result.arithmeticMean = angles ? static_cast<float>(angleSum / angles) : 0.0f;
+    return true;
+}
+
+/**
+ * @brief Print the per-channel table of one run
+ */
+static void printRun(const char* mode, const MuxSimConfig& config, const MuxSimResult& result) {
+    for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+        if (!config.rates[i]) {
+            continue;
+        }
+        printf("%-10s %-12s %6u %9.1f %8u %8u %7u us\n", i == 0 ? mode : "", CHANNEL_NAMES[i], config.rates[i],
+               static_cast<float>(result.samples[i]) / config.seconds, result.skipped[i], result.overruns[i],
+               result.maxLatenessUs[i]);
+    }
+}
+
+/**
+ * @brief Angle between two directions (degrees, 0..180)
+ */
+static float angleBetween(float a, float b) {
+    float difference = fabsf(a - b);
+    return difference > 180.0f ? 360.0f - difference : difference;
+}
+
+/**
+ * @brief Interleave four inputs of a simulated ADS1115 and check rates, time stamps and direction
+ */
+int runMuxSim(int argc, char** argv) {
+    MuxSimConfig config = {120, 860, {640, 32, 2, 1}, 0.08f};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            config.seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.converterRate = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--wind") == 0 && i + 1 < argc) {
+            config.rates[0] = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--vane") == 0 && i + 1 < argc) {
+            config.rates[1] = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--supply") == 0 && i + 1 < argc) {
+            config.rates[2] = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--temperature") == 0 && i + 1 < argc) {
+            config.rates[3] = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--oscillator") == 0 && i + 1 < argc) {
+            config.oscillatorError = static_cast<float>(atof(argv[++i])) / 100.0f;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (config.seconds == 0 || config.converterRate == 0 || config.rates[0] == 0 || config.rates[1] == 0) {
+        fprintf(stderr, "--seconds, --rate, --wind and --vane must be positive\n");
+        return 1;
+    }
+    if (config.oscillatorError < -0.1f || config.oscillatorError > 0.1f) {
+        fprintf(stderr, "--oscillator must be within the ADS1115 10 %% tolerance\n");
+        return 1;
+    }
+
+    MuxSimResult pipelined;
+    MuxSimResult serial;
+    if (!runMux(config, true, pipelined) || !runMux(config, false, serial)) {
+        fprintf(stderr, "Scheduler start failed\n");
+        return 1;
+    }
+    MuxSimConfig saturated = config;
+    saturated.seconds = 10;
+    for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+        saturated.rates[i] = 860;
+    }
+    MuxSimResult pipelinedMax;
+    MuxSimResult serialMax;
+    runMux(saturated, true, pipelinedMax);
+    runMux(saturated, false, serialMax);
+
+    float load = pipelined.load;
+    printf("%u s, converter at %u SPS, oscillator %+.0f%%, rates ask for %.0f%% of the converter\n\n", config.seconds,
+           config.converterRate, 100.0f * config.oscillatorError, 100.0f * load);
+    printf("%-10s %-12s %6s %9s %8s %8s %10s\n", "sequence", "channel", "rate", "samples/s", "skipped", "overrun",
+           "max late");
+    printRun("pipelined", config, pipelined);
+    printRun("serial", config, serial);
+    printf("\nConverter: %.0f conversions/s, busy %.1f%% (serial: %.0f/s, %.1f%%)\n", pipelined.conversionsPerSecond,
+           100.0f * pipelined.converterBusy, serial.conversionsPerSecond, 100.0f * serial.converterBusy);
+    printf("Capacity, every input at 860 SPS: %.0f conversions/s pipelined, %.0f serial\n",
+           pipelinedMax.conversionsPerSecond, serialMax.conversionsPerSecond);
+    printf("Wind: largest gap between samples %u us (period %u us)\n", pipelined.maxWindGapUs,
+           1000000U / config.rates[0]);
+    printf("Time stamps: %u samples off their input ramp (serial: %u), %u ignored starts, %u errors\n",
+           pipelined.offRamp, serial.offRamp, pipelined.ignoredStarts, pipelined.errors);
+    printf("Direction: vane %.1f +/- %.0f deg, vector mean %.1f deg (steadiness %.2f, 3 s: %.1f deg), "
+           "arithmetic mean %.1f deg\n", VANE_CENTRE, VANE_SWING, pipelined.direction.mean,
+           pipelined.direction.steadiness, pipelined.direction.current, pipelined.arithmeticMean);
+
+    bool ok = pipelined.offRamp == 0 && serial.offRamp == 0 && pipelined.ignoredStarts == 0 &&
+              serial.ignoredStarts == 0 && pipelined.errors == 0;
+    if (load <= 0.95f) {
+        for (size_t i = 0; i < ChannelScheduler::MAX_CHANNELS; i++) {
+            ok = ok && pipelined.skipped[i] == 0 && pipelined.overruns[i] == 0;
+        }
+    }
+    if (config.seconds >= WindDirection::WINDOW_MS / 1000) {
+        // The 2 min window holds whole swings of the vane: its mean is the centre
+        ok = ok && angleBetween(pipelined.direction.mean, VANE_CENTRE) < 1.0f;
+    }
+    ok = ok && pipelinedMax.conversionsPerSecond > serialMax.conversionsPerSecond;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
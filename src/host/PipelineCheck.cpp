@@ -0,0 +1,294 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file PipelineCheck.cpp
+ * @brief Stress test of the SPSC ring and the pipeline stages on host threads
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Three runs, each on real threads (RtosTask maps to std::thread on the host):
+ *
+ * - Ring: a producer pushes a counter into an SpscRing as fast as it can, retrying
+ *   when it is full, while the consumer pops in bursts with pauses. Every value must
+ *   come out once and in order, overruns() must equal the refused pushes counted by
+ *   the producer, and the high-water mark must reach the capacity.
+ * - Stage: the sink of one PipelineStage is held inside consume(); exactly
+ *   QUEUE_SIZE more measurements must be accepted, every further one dropped and
+ *   counted, and all accepted ones delivered in order once the sink is released.
+ * - Pipeline: a 1 ms producer feeds a fast, a slow and a bursty consumer. Each
+ *   stage must deliver in order, intact, and account for every measurement produced
+ *   as delivered or dropped(); a stage never drops before its queue is full.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "HostCommands.h"
+#include "Pipeline.h"
+#include "RtosTask.h"
+#include "SpscRing.h"
+
+static const size_t RING_SIZE = 64;
+static const uint32_t PERIOD_MS = 1;           // Producer period of the pipeline run
+static const uint32_t SLOW_MS = 3;             // Slow consumer: three periods per measurement
+static const uint32_t BURST_EVERY = 200;       // Bursty consumer: a long call every 200 measurements
+static const uint32_t BURST_MS = 40;
+
+namespace {
+
+/**
+ * @brief Ring run: shared between the producer and the consumer threads
+ */
+struct RingRun {
+    SpscRing<uint32_t, RING_SIZE> ring;
+    uint32_t count;                  // Values to push
+    uint32_t refused;                // Pushes refused (producer only)
+    uint32_t received;               // Values popped (consumer only)
+    uint32_t outOfOrder;             // Values popped that were not the next one
+};
+
+static void ringProducer(void* arg) {
+    RingRun* run = static_cast<RingRun*>(arg);
+    for (uint32_t value = 0; value < run->count;) {
+        if (run->ring.push(value)) {
+            value++;
+        } else {
+            run->refused++;
+            std::this_thread::yield(); // Single-core hosts: let the consumer run
+        }
+    }
+}
+
+static void ringConsumer(void* arg) {
+    RingRun* run = static_cast<RingRun*>(arg);
+    uint32_t batch[RING_SIZE / 4];
+    while (run->received < run->count) {
+        size_t got;
+        if (run->received % 3 == 0) {
+            got = run->ring.popBulk(batch, sizeof(batch) / sizeof(batch[0]));
+        } else {
+            got = run->ring.pop(batch[0]) ? 1 : 0;
+        }
+        if (got == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < got; i++) {
+            if (batch[i] != run->received) {
+                run->outOfOrder++;
+            }
+            run->received++;
+        }
+        if (run->received % 65536 < got) {
+            // Let the ring fill up now and then
+            RtosTask::sleepMs(1);
+        }
+    }
+}
+
+static bool checkRing(uint32_t count) {
+    static RingRun run; // Not on the stack: the items array is shared by the threads
+    run.count = count;
+    run.refused = 0;
+    run.received = 0;
+    run.outOfOrder = 0;
+    RtosTask consumer("ring_consumer", 4096, 1);
+    RtosTask producer("ring_producer", 4096, 1);
+    consumer.start(ringConsumer, &run);
+    producer.start(ringProducer, &run);
+    producer.join();
+    consumer.join();
+
+    bool ok = run.received == count && run.outOfOrder == 0 && run.ring.overruns() == run.refused &&
+              run.ring.size() == 0 && run.ring.highWater() == (run.refused ? RING_SIZE : run.ring.highWater()) &&
+              run.ring.highWater() <= RING_SIZE;
+    printf("Ring: %lu values, %lu out of order, %lu pushes refused, overruns %lu, high-water %lu/%zu %s\n",
+           static_cast<unsigned long>(run.received), static_cast<unsigned long>(run.outOfOrder),
+           static_cast<unsigned long>(run.refused), static_cast<unsigned long>(run.ring.overruns()),
+           static_cast<unsigned long>(run.ring.highWater()), RING_SIZE, ok ? "OK" : "FAILED");
+    return ok;
+}
+
+/**
+ * @brief Sink keeping what it receives, optionally slow or held
+ */
+class RecordingSink : public MeasurementSink {
+private:
+    std::vector<Measurement> received_;  // Reserved up front, only touched by the stage task
+    uint32_t delayMs_;                   // Time spent in every consume()
+    uint32_t burstEvery_;                // Every burstEvery_ measurements, spend burstMs_ instead
+    uint32_t burstMs_;
+    std::atomic<bool> hold_;             // Block in consume() while set
+    std::atomic<bool> entered_;          // A consume() call started
+
+public:
+    RecordingSink(size_t capacity, uint32_t delayMs = 0, uint32_t burstEvery = 0, uint32_t burstMs = 0)
+        : delayMs_(delayMs), burstEvery_(burstEvery), burstMs_(burstMs), hold_(false), entered_(false) {
+        received_.reserve(capacity);
+    }
+
+    void consume(const Measurement& measurement) override {
+        entered_.store(true);
+        while (hold_.load()) {
+            RtosTask::sleepMs(1);
+        }
+        if (received_.size() < received_.capacity()) {
+            received_.push_back(measurement);
+        }
+        if (burstEvery_ && received_.size() % burstEvery_ == 0) {
+            RtosTask::sleepMs(burstMs_);
+        } else if (delayMs_) {
+            RtosTask::sleepMs(delayMs_);
+        }
+    }
+
+    void hold(bool on) { hold_.store(on); }
+    bool entered() const { return entered_.load(); }
+    const std::vector<Measurement>& received() const { return received_; }
+
+    /**
+     * @brief Measurements out of order or not as produced (voltage carries the sequence number)
+     */
+    uint32_t defects() const {
+        uint32_t count = 0;
+        for (size_t i = 0; i < received_.size(); i++) {
+            const Measurement& m = received_[i];
+            if ((i > 0 && m.sequenceNumber <= received_[i - 1].sequenceNumber) ||
+                m.voltage != static_cast<float>(m.sequenceNumber)) {
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+static bool checkStage() {
+    const uint32_t extra = 5;
+    RecordingSink sink(64);
+    PipelineStage stage("held", sink, 1, RtosTask::ANY_CORE);
+    stage.start();
+
+    // The first measurement is taken out of the queue and held inside consume()
+    sink.hold(true);
+    Measurement m = {};
+    stage.offer(m);
+    for (uint32_t waitedMs = 0; !sink.entered() && waitedMs < 1000; waitedMs++) {
+        RtosTask::sleepMs(1);
+    }
+    uint32_t accepted = 0;
+    for (uint32_t i = 1; i <= PipelineStage::QUEUE_SIZE + extra; i++) {
+        m.sequenceNumber = i;
+        m.voltage = static_cast<float>(i);
+        if (stage.offer(m)) {
+            accepted++;
+        }
+    }
+    uint32_t dropped = stage.dropped();
+    uint32_t highWater = stage.highWater();
+    sink.hold(false);
+    stage.stop();
+
+    bool ok = sink.entered() && accepted == PipelineStage::QUEUE_SIZE && dropped == extra &&
+              highWater == PipelineStage::QUEUE_SIZE && sink.received().size() == 1 + PipelineStage::QUEUE_SIZE &&
+              stage.processed() == 1 + PipelineStage::QUEUE_SIZE && sink.defects() == 0;
+    printf("Stage held in consume(): %lu of %lu accepted, %lu dropped, high-water %lu/%zu, %zu delivered in order %s\n",
+           static_cast<unsigned long>(accepted), static_cast<unsigned long>(PipelineStage::QUEUE_SIZE + extra),
+           static_cast<unsigned long>(dropped), static_cast<unsigned long>(highWater), PipelineStage::QUEUE_SIZE,
+           sink.received().size(), ok ? "OK" : "FAILED");
+    return ok;
+}
+
+/**
+ * @brief Producer of the pipeline run: voltage carries the number of the call
+ */
+class CountingProducer : public MeasurementProducer {
+private:
+    uint32_t calls_;
+
+public:
+    CountingProducer() : calls_(0) {}
+
+    bool produce(Measurement& measurement) override {
+        measurement.voltage = static_cast<float>(calls_++);
+        return true;
+    }
+};
+
+} // namespace
+
+static bool checkPipeline(uint32_t seconds) {
+    size_t capacity = seconds * 1000 / PERIOD_MS + 1000;
+    CountingProducer producer;
+    RecordingSink fastSink(capacity);
+    RecordingSink slowSink(capacity, SLOW_MS);
+    RecordingSink burstySink(capacity, 0, BURST_EVERY, BURST_MS);
+    PipelineStage fast("fast", fastSink, 2, RtosTask::ANY_CORE);
+    PipelineStage slow("slow", slowSink, 2, RtosTask::ANY_CORE);
+    PipelineStage bursty("bursty", burstySink, 2, RtosTask::ANY_CORE);
+    Pipeline pipeline(producer, PERIOD_MS, 3, RtosTask::ANY_CORE);
+    pipeline.addStage(fast);
+    pipeline.addStage(slow);
+    pipeline.addStage(bursty);
+    pipeline.start();
+    RtosTask::sleepMs(seconds * 1000);
+    pipeline.stop();
+
+    uint32_t produced = pipeline.produced();
+    printf("Pipeline: %lu measurements in %lu s, %lu late wake-ups\n", static_cast<unsigned long>(produced),
+           static_cast<unsigned long>(seconds), static_cast<unsigned long>(pipeline.lateWakeups()));
+    const RecordingSink* sinks[] = {&fastSink, &slowSink, &burstySink};
+    bool ok = true;
+    for (size_t i = 0; i < pipeline.stageCount(); i++) {
+        const PipelineStage& stage = pipeline.stage(i);
+        const RecordingSink& sink = *sinks[i];
+        uint32_t delivered = static_cast<uint32_t>(sink.received().size());
+        // A drop means the queue was full at that moment, so the mark reached the capacity
+        bool good = sink.defects() == 0 && delivered == stage.processed() && delivered + stage.dropped() == produced &&
+                    stage.highWater() <= PipelineStage::QUEUE_SIZE &&
+                    (stage.dropped() == 0 || stage.highWater() == PipelineStage::QUEUE_SIZE);
+        printf("  %-7s %6lu delivered, %6lu dropped, high-water %lu/%zu, longest consume %lu ms %s\n", stage.name(),
+               static_cast<unsigned long>(delivered), static_cast<unsigned long>(stage.dropped()),
+               static_cast<unsigned long>(stage.highWater()), PipelineStage::QUEUE_SIZE,
+               static_cast<unsigned long>(stage.maxServiceMs()), good ? "OK" : "FAILED");
+        ok = good && ok;
+    }
+    // The slow stage cannot keep up and must have dropped; the fast one must not have
+    bool expected = slow.dropped() > 0 && fast.dropped() == 0;
+    if (!expected) {
+        printf("  expected drops on the slow stage only\n");
+    }
+    return ok && expected;
+}
+
+int runPipelineCheck(int argc, char** argv) {
+    uint32_t values = 2000000;
+    uint32_t seconds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--values") == 0 && i + 1 < argc) {
+            values = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    bool ok = checkRing(values);
+    ok = checkStage() && ok;
+    ok = checkPipeline(seconds) && ok;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file PowerSim.cpp
+ * @brief Low-power duty cycle on a virtual clock: wake-up accuracy, sleep ratio, charge
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The PowerScheduler runs the low-power duty cycle of the firmware against
+ * SimPowerControl: a single-shot conversion started every 250 ms and read when the
+ * ADS1115 ALERT pin wakes the CPU (or waited for, with --no-alert), a transmit
+ * that keeps the CPU out of light sleep while the frame is on the air, and a display
+ * refresh. Work durations and currents are estimates for the ESP32-S3; the result
+ * is compared with the always-awake firmware (CPU idle with the receiver on).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostCommands.h"
+#include "PowerScheduler.h"
+#include "SimPowerControl.h"
+#include "VirtualClock.h"
+
+static const float AWAKE_MILLIAMPS = 95.0f;     // Always-awake firmware, receiver on
+static const float CPU_MILLIAMPS = 35.0f;       // CPU running, radio in modem sleep
+static const float TX_MILLIAMPS = 190.0f;       // CPU running and transmitting at 19.5 dBm
+static const float DISPLAY_MILLIAMPS = 45.0f;   // CPU running, SPI transfer to the LCD
+
+namespace {
+
+/**
+ * @brief Simulation parameters
+ */
+struct PowerSimConfig {
+    uint32_t seconds;
+    uint32_t wakeDelayUs;
+    uint32_t jitterUs;
+    uint32_t sampleRate;
+    uint32_t transmitMs;
+    uint32_t displayMs;
+    uint32_t batteryMah;
+    bool alert;
+};
+
+/**
+ * @brief Fixed amount of work on the virtual clock
+ */
+class SimWork : public PowerTask {
+protected:
+    VirtualClock& clock_;
+    uint32_t workUs_;
+
+public:
+    SimWork(VirtualClock& clock, uint32_t workUs) : clock_(clock), workUs_(workUs) {
+    }
+
+    void run() override {
+        clock_.advanceUs(workUs_);
+    }
+};
+
+/**
+ * @brief Starts a single-shot conversion; ALERT marks its end (or the CPU waits for it)
+ */
+class ConvertTask : public SimWork {
+private:
+    SimPowerControl& power_;
+    uint32_t conversionUs_;
+    bool alert_;
+
+public:
+    ConvertTask(VirtualClock& clock, SimPowerControl& power, uint32_t conversionUs, bool alert)
+        : SimWork(clock, 150), power_(power), conversionUs_(conversionUs), alert_(alert) {
+    }
+
+    void run() override {
+        SimWork::run(); // I2C write of the config register
+        if (alert_) {
+            power_.scheduleAlert(clock_.nowUs() + conversionUs_);
+        } else {
+            clock_.advanceUs(conversionUs_ + 250); // Blocking read, then the code and the statistics
+        }
+    }
+};
+
+/**
+ * @brief Queues a frame; the radio keeps it on the air for a while after run()
+ */
+class TransmitTask : public SimWork {
+private:
+    uint64_t airUntilUs_;
+
+public:
+    TransmitTask(VirtualClock& clock) : SimWork(clock, 400), airUntilUs_(0) {
+    }
+
+    void run() override {
+        SimWork::run(); // Encode and esp_now_send()
+        airUntilUs_ = clock_.nowUs() + 800 + 1200; // Air time and completion callback
+    }
+
+    bool busy() const override {
+        return clock_.nowUs() < airUntilUs_;
+    }
+};
+
+} // namespace
+
+int runPowerSim(int argc, char** argv) {
+    PowerSimConfig config = {600, 400, 200, 128, 1000, 1000, 2000, true};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            config.seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--wake") == 0 && i + 1 < argc) {
+            config.wakeDelayUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            config.jitterUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.sampleRate = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--transmit") == 0 && i + 1 < argc) {
+            config.transmitMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--display") == 0 && i + 1 < argc) {
+            config.displayMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--battery") == 0 && i + 1 < argc) {
+            config.batteryMah = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--no-alert") == 0) {
+            config.alert = false;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (config.seconds == 0 || config.sampleRate == 0 || config.transmitMs == 0 || config.displayMs == 0) {
+        fprintf(stderr, "--seconds, --rate, --transmit and --display must be positive\n");
+        return 1;
+    }
+
+    VirtualClock clock(0xFFFFFFFFULL - 2000000); // micros() wraps during the run
+    SimPowerControl power(clock, config.wakeDelayUs, config.jitterUs);
+    power.setRadioPowerSave(true);
+    PowerScheduler scheduler(clock, power);
+
+    ConvertTask convert(clock, power, 1000000 / config.sampleRate, config.alert);
+    SimWork read(clock, 350);        // Conversion register, lookup table, statistics
+    TransmitTask transmit(clock);
+    SimWork display(clock, 6000);    // Dirty regions of a wind change
+    scheduler.add("convert", convert, 250000, CPU_MILLIAMPS);
+    if (config.alert) {
+        scheduler.add("read", read, 0, CPU_MILLIAMPS, true);
+    }
+    scheduler.add("transmit", transmit, config.transmitMs * 1000, TX_MILLIAMPS);
+    scheduler.add("display", display, config.displayMs * 1000, DISPLAY_MILLIAMPS);
+
+    uint64_t endUs = clock.nowUs() + static_cast<uint64_t>(config.seconds) * 1000000;
+    scheduler.start();
+    while (clock.nowUs() < endUs) {
+        scheduler.step();
+    }
+
+    printf("%u s, conversions at %u SPS %s, wake-up delay %u us + 0..%u us\n\n", config.seconds, config.sampleRate,
+           config.alert ? "read on ALERT" : "waited for", config.wakeDelayUs, config.jitterUs);
+    printf("%-10s %8s %8s %7s %10s %8s %9s\n", "task", "runs", "alert", "missed", "max late", "duty", "charge");
+    double elapsed = static_cast<double>(scheduler.elapsedUs());
+    for (size_t i = 0; i < scheduler.taskCount(); i++) {
+        const PowerLedger& ledger = scheduler.ledger(i);
+        printf("%-10s %8u %8u %7u %7u us %7.3f%% %6.4f mAh\n", ledger.name, ledger.runs, ledger.alertRuns,
+               ledger.missed, ledger.maxLatenessUs, 100.0 * ledger.activeUs / elapsed,
+               ledger.activeUs * ledger.activeMilliamps / 3.6e9);
+    }
+    printf("%-10s %44.3f%%\n", "idle", 100.0 * scheduler.idleUs() / elapsed);
+    printf("%-10s %44.3f%%\n\n", "sleep", 100.0 * scheduler.sleepRatio());
+
+    float average = scheduler.averageMilliamps();
+    printf("Light sleeps: %u (%u ended by ALERT), wake-up compensation %u us, worst delay %u us\n",
+           scheduler.lightSleeps(), scheduler.alertWakes(), scheduler.leadUs(), scheduler.maxWakeDelayUs());
+    printf("Average current: %.2f mA (always awake: %.0f mA), %u mAh battery: %.0f h (always awake: %.0f h)\n",
+           average, AWAKE_MILLIAMPS, config.batteryMah, config.batteryMah / average,
+           config.batteryMah / AWAKE_MILLIAMPS);
+    return 0;
+}
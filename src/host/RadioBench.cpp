@@ -0,0 +1,162 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file RadioBench.cpp
+ * @brief Send-completion tracking and back-pressure on the simulated ESP-NOW driver
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Communication::broadcast() is driven through its TransmitEngine against a
+ * SimRadio shaped like the ESP-NOW driver (queue depth, air time per frame, loss),
+ * on a VirtualClock. Every period a burst of frames is offered back to back, as when
+ * a backlog is flushed; frames refused while the radio is busy are retried 100 us
+ * later. The delivery counters and the enqueue-to-completion latency histogram are
+ * printed as the firmware reports them over serial.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostCommands.h"
+#include "Communication.h"
+#include "SimRadio.h"
+#include "VirtualClock.h"
+
+static const uint32_t STEP_US = 100;        // Retry and completion polling interval
+
+namespace {
+
+/**
+ * @brief Simulation parameters
+ */
+struct RadioBenchConfig {
+    uint32_t frames;
+    uint32_t burst;
+    uint32_t periodMs;
+    uint32_t depth;         // 0 to sweep 1, 2, 4 and 8
+    uint32_t airtimeUs;
+    float loss;
+};
+
+} // namespace
+
+/**
+ * @brief Send the configured frames through one Communication instance
+ */
+static void run(const RadioBenchConfig& config, uint32_t depth, SimRadio& radio, VirtualClock& clock,
+                Communication& comm) {
+    radio.setDriver(depth, config.airtimeUs);
+    radio.setLossRate(config.loss, 7);
+    comm.setup();
+
+    AnemometerData data = {};
+    radio.macAddress(data.macAddress);
+    data.windSpeed = 8.0f;
+    uint32_t sent = 0;
+    while (sent < config.frames) {
+        uint64_t periodEndUs = clock.nowUs() + config.periodMs * 1000ULL;
+        for (uint32_t i = 0; i < config.burst && sent < config.frames;) {
+            radio.advance(clock.micros());
+            data.sequenceNumber = static_cast<uint16_t>(sent);
+            if (comm.broadcast(data)) {
+                i++;
+                sent++;
+            } else {
+                clock.advanceUs(STEP_US); // Busy: wait for a completion
+            }
+        }
+        while (clock.nowUs() < periodEndUs) {
+            clock.advanceUs(STEP_US);
+            radio.advance(clock.micros());
+        }
+    }
+    // Let the last frames complete
+    while (radio.pending() > 0) {
+        clock.advanceUs(STEP_US);
+        radio.advance(clock.micros());
+    }
+}
+
+int runRadioBench(int argc, char** argv) {
+    RadioBenchConfig config = {2000, 12, 250, 0, 800, 0.0f};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            config.burst = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            config.periodMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            config.depth = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--airtime") == 0 && i + 1 < argc) {
+            config.airtimeUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            config.loss = strtof(argv[++i], nullptr);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (config.frames == 0 || config.burst == 0 || config.periodMs == 0) {
+        fprintf(stderr, "--frames, --burst and --period must be positive\n");
+        return 1;
+    }
+
+    printf("%u frames in bursts of %u every %u ms, %u us air time, %.0f%% loss\n\n", config.frames, config.burst,
+           config.periodMs, config.airtimeUs, config.loss * 100.0f);
+    printf("%5s %8s %9s %7s %7s %6s %9s %9s %9s\n", "depth", "queued", "completed", "failed", "busy", "peak",
+           "avg us", "max us", "unexpect");
+
+    static const uint32_t SWEEP[] = {1, 2, 4, 8};
+    uint32_t first = config.depth ? config.depth : SWEEP[0];
+    size_t runs = config.depth ? 1 : sizeof(SWEEP) / sizeof(SWEEP[0]);
+    for (size_t r = 0; r < runs; r++) {
+        uint32_t depth = config.depth ? first : SWEEP[r];
+        SimRadio radio;
+        VirtualClock clock(0xFFFFFFFFULL - 500000); // micros() wraps during the run
+        Communication comm(radio, clock);
+        run(config, depth, radio, clock, comm);
+
+        const TransmitEngine& engine = comm.transmitter();
+        printf("%5u %8u %9u %7u %7u %6u %9u %9u %9u\n", depth, engine.queued(), engine.completed(), engine.failed(),
+               engine.busy(), engine.maxInFlight(), engine.averageLatencyUs(), engine.maxLatencyUs(),
+               engine.unexpected());
+        if (engine.queued() != engine.completed() + engine.failed() || engine.inFlight() != 0) {
+            printf("  completions do not match the frames queued\n");
+            return 1;
+        }
+        if (r + 1 < runs) {
+            continue;
+        }
+
+        printf("\nLatency histogram, depth %u:\n", depth);
+        for (size_t bucket = 0; bucket < TransmitEngine::LATENCY_BUCKETS; bucket++) {
+            uint32_t completed = engine.latencyCount(true, bucket);
+            uint32_t failed = engine.latencyCount(false, bucket);
+            if (!completed && !failed) {
+                continue;
+            }
+            uint32_t limit = TransmitEngine::bucketLimitUs(bucket);
+            if (limit) {
+                printf("  < %7u us %8u sent %6u failed\n", limit, completed, failed);
+            } else {
+                printf("  >=%7u us %8u sent %6u failed\n", TransmitEngine::bucketLimitUs(bucket - 1), completed,
+                       failed);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file RecordBench.cpp
+ * @brief Recording throughput test against a file-backed BlockStorage
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Simulated samples go through Anemometer (single-shot, virtual clock) into a
+ * SampleRecorder writing to FileBlockStorage. The producer hands a buffer over every
+ * simulated measurement period, like the firmware, and waits for the writer only
+ * between periods, so drops mean the storage could not keep up. The files are then
+ * read back and every sector checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "Anemometer.h"
+#include "FakeAdcSource.h"
+#include "FileBlockStorage.h"
+#include "RecordingFormat.h"
+#include "SampleRecorder.h"
+#include "VirtualClock.h"
+
+using namespace RecordingFormat;
+
+static const uint16_t SAMPLE_RATE = 860;
+static const uint32_t PERIOD_MS = 2000;
+static const uint32_t BENCH_FILE_SECTORS = 4096;    // 2 MB files, so rotation is exercised
+
+/**
+ * @brief Read back the files of a session and count valid records
+ * @return Number of records, or -1 on a format error
+ */
+static long verifySession(const char* directory, uint32_t session, uint32_t& files) {
+    long records = 0;
+    uint32_t lastTimestamp = 0;
+    files = 0;
+    for (uint32_t number = session;; number++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/REC%05lu.BIN", directory, static_cast<unsigned long>(number));
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            break;
+        }
+        uint8_t sector[SECTOR_SIZE];
+        FileInfo info;
+        if (fread(sector, 1, SECTOR_SIZE, file) != SECTOR_SIZE || !decodeFileHeader(sector, info) ||
+            info.session != session) {
+            fclose(file);
+            break;
+        }
+        if (info.part != files) {
+            fprintf(stderr, "%s: part %lu, expected %lu\n", path, static_cast<unsigned long>(info.part),
+                    static_cast<unsigned long>(files));
+            fclose(file);
+            return -1;
+        }
+        files++;
+        uint16_t count, dropped;
+        for (uint32_t index = 1; fread(sector, 1, SECTOR_SIZE, file) == SECTOR_SIZE; index++) {
+            if (!checkSector(sector, session, index, count, dropped)) {
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                SampleRecord record = getRecord(sector, i);
+                if (record.timestampMs < lastTimestamp) {
+                    fprintf(stderr, "%s: timestamp going back at sector %lu\n", path,
+                            static_cast<unsigned long>(index));
+                    fclose(file);
+                    return -1;
+                }
+                lastTimestamp = record.timestampMs;
+            }
+            records += count;
+        }
+        fclose(file);
+    }
+    return records;
+}
+
+int runRecordBench(int argc, char** argv) {
+    const char* directory = ".";
+    uint32_t seconds = 600;
+    bool durable = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--durable") == 0) {
+            durable = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-') {
+            directory = argv[i];
+        } else {
+            fprintf(stderr, "Usage: record [directory] [--seconds N] [--durable]\n");
+            return 1;
+        }
+    }
+
+    FileBlockStorage storage(directory, durable);
+    SampleRecorder recorder(storage, BENCH_FILE_SECTORS);
+    FakeAdcSource adc;
+    adc.setSignal(300, 250, 7.0f, 12);
+    VirtualClock clock;
+    Anemometer anemometer(adc, clock, AcquisitionMode::SingleShot, SAMPLE_RATE);
+    anemometer.setup();
+
+    FileInfo info = {};
+    info.sampleRate = SAMPLE_RATE;
+    info.millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    info.curve = anemometer.getCalibrationCurve();
+    if (!recorder.begin(info)) {
+        fprintf(stderr, "Cannot start recording in %s\n", directory);
+        return 1;
+    }
+    anemometer.setRecorder(&recorder);
+
+    const uint32_t samplesPerPeriod = SAMPLE_RATE * PERIOD_MS / 1000;
+    const uint32_t periods = seconds * 1000 / PERIOD_MS;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t period = 0; period < periods; period++) {
+        for (uint32_t i = 0; i < samplesPerPeriod; i++) {
+            clock.advanceUs(1000000 / SAMPLE_RATE);
+            anemometer.update();
+        }
+        while (!recorder.flush()) {
+            RtosTask::sleepMs(1);
+        }
+    }
+    recorder.stop();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double megabytes = recorder.sectorsWritten() * static_cast<double>(SECTOR_SIZE) / 1e6;
+    printf("Session %lu: %lu samples, %lu dropped, %lu sectors, %lu write errors\n",
+           static_cast<unsigned long>(recorder.session()), static_cast<unsigned long>(recorder.recordsAppended()),
+           static_cast<unsigned long>(recorder.recordsDropped()), static_cast<unsigned long>(recorder.sectorsWritten()),
+           static_cast<unsigned long>(recorder.writeErrors()));
+    printf("%.2f MB in %.2f s: %.1f MB/s, %.0fx real time, longest write+sync %lu ms%s\n", megabytes, wall,
+           megabytes / wall, seconds / wall, static_cast<unsigned long>(recorder.maxWriteMs()),
+           durable ? " (fsync)" : "");
+
+    uint32_t files = 0;
+    long verified = verifySession(directory, recorder.session(), files);
+    printf("Read back %ld samples from %lu files\n", verified, static_cast<unsigned long>(files));
+    bool ok = verified == static_cast<long>(recorder.recordsAppended()) && recorder.writeErrors() == 0;
+    printf("%s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file ReplayBench.cpp
+ * @brief Recorded traces replayed through the whole measurement chain, faster than real time
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The codes of a trace (TraceAdcSource) or of the synthetic signal go through
+ * Anemometer in replay mode on a virtual clock: one update() per 250 ms measurement
+ * period, then the turbulence analysis, the frame contents and
+ * Communication::offer() on the simulated radio, as the firmware stages do. Each
+ * period gives one digest row (speed, gust, lull, mean, turbulence, frames sent and a
+ * CRC of the frames); --write saves the digest and --check compares a run with a
+ * saved one, so a change to the chain can be checked against a known-good run.
+ * The throughput in samples per second is printed on every run.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "Anemometer.h"
+#include "Communication.h"
+#include "FakeAdcSource.h"
+#include "RecordingFormat.h"
+#include "SimRadio.h"
+#include "TraceAdcSource.h"
+#include "TurbulenceAnalyzer.h"
+#include "VirtualClock.h"
+
+static const uint32_t PERIOD_MS = 250;
+static const float DIGEST_TOLERANCE = 0.001f;  // m/s, and turbulence intensity
+
+namespace {
+
+/**
+ * @brief State of the chain after one measurement period
+ */
+struct DigestRow {
+    uint32_t period;
+    float speed;
+    float gust;
+    float lull;
+    float mean;
+    float intensity;
+    uint32_t frames;
+    uint32_t frameCrc;    // CRC-32 of every frame sent so far
+};
+
+} // namespace
+
+static bool readDigest(FILE* file, DigestRow& row) {
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long period;
+        unsigned long frames;
+        unsigned long crc;
+        if (sscanf(line, "%lu,%f,%f,%f,%f,%f,%lu,%lx", &period, &row.speed, &row.gust, &row.lull, &row.mean,
+                   &row.intensity, &frames, &crc) == 8) {
+            row.period = static_cast<uint32_t>(period);
+            row.frames = static_cast<uint32_t>(frames);
+            row.frameCrc = static_cast<uint32_t>(crc);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void writeDigest(FILE* file, const DigestRow& row) {
+    fprintf(file, "%lu,%.4f,%.4f,%.4f,%.4f,%.4f,%lu,%08lx\n", static_cast<unsigned long>(row.period), row.speed,
+            row.gust, row.lull, row.mean, row.intensity, static_cast<unsigned long>(row.frames),
+            static_cast<unsigned long>(row.frameCrc));
+}
+
+/**
+ * @brief Compare with the saved digest; the printed values went through %.4f, so compare at that precision
+ */
+static bool sameDigest(const DigestRow& a, const DigestRow& b) {
+    return a.period == b.period && fabsf(a.speed - b.speed) <= DIGEST_TOLERANCE &&
+           fabsf(a.gust - b.gust) <= DIGEST_TOLERANCE && fabsf(a.lull - b.lull) <= DIGEST_TOLERANCE &&
+           fabsf(a.mean - b.mean) <= DIGEST_TOLERANCE && fabsf(a.intensity - b.intensity) <= DIGEST_TOLERANCE &&
+           a.frames == b.frames && a.frameCrc == b.frameCrc;
+}
+
+int runReplayBench(int argc, char** argv) {
+    static const int MAX_TRACES = 16;
+    const char* traces[MAX_TRACES];
+    int traceCount = 0;
+    const char* writePath = nullptr;
+    const char* checkPath = nullptr;
+    float hours = 24.0f;
+    uint16_t rate = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            writePath = argv[++i];
+        } else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            checkPath = argv[++i];
+        } else if (argv[i][0] != '-' && traceCount < MAX_TRACES) {
+            traces[traceCount++] = argv[i];
+        } else {
+            fprintf(stderr, "Usage: replay [trace ...] [--hours H] [--rate SPS] [--write digest.csv] "
+                            "[--check digest.csv]\n");
+            return 1;
+        }
+    }
+
+    // Converter: the traces one after the other, or the synthetic signal for the given time
+    TraceAdcSource trace;
+    FakeAdcSource synthetic;
+    synthetic.setSignal(120, 40, 20.0f, 6); // About 13 +/- 4 m/s
+    for (int i = 0; i < traceCount; i++) {
+        if (!trace.load(traces[i])) {
+            fprintf(stderr, "Cannot read a trace from %s\n", traces[i]);
+            return 1;
+        }
+    }
+    if (rate) {
+        trace.setSampleRate(rate);
+    }
+    AdcSource& source = traceCount ? static_cast<AdcSource&>(trace) : static_cast<AdcSource&>(synthetic);
+    uint16_t sampleRate = traceCount ? trace.sampleRate() : (rate ? rate : 860);
+    uint64_t codesPerPeriodMillionths = static_cast<uint64_t>(sampleRate) * PERIOD_MS * 1000;
+    uint32_t periods;
+    uint64_t expected;
+    if (traceCount) {
+        expected = trace.size();
+        periods = static_cast<uint32_t>((expected * 1000000 + codesPerPeriodMillionths - 1) / codesPerPeriodMillionths);
+    } else {
+        periods = static_cast<uint32_t>(hours * 3600.0f * 1000.0f / PERIOD_MS);
+        expected = periods * codesPerPeriodMillionths / 1000000;
+    }
+
+    FILE* writeFile = writePath ? fopen(writePath, "w") : nullptr;
+    FILE* checkFile = checkPath ? fopen(checkPath, "r") : nullptr;
+    if ((writePath && !writeFile) || (checkPath && !checkFile)) {
+        fprintf(stderr, "Cannot open %s\n", writePath && !writeFile ? writePath : checkPath);
+        return 1;
+    }
+    if (writeFile) {
+        fprintf(writeFile, "period,speed,gust,lull,mean,intensity,frames,frame_crc\n");
+    }
+
+    // The firmware chain on a virtual clock
+    VirtualClock clock;
+    SimRadio radio;
+    Anemometer anemometer(source, clock, AcquisitionMode::Replay, sampleRate);
+    TurbulenceAnalyzer analyzer(clock);
+    Communication comm(radio, clock);
+    anemometer.setup();
+    comm.setup();
+    anemometer.setAnalyzer(&analyzer);
+
+    TurbulenceResult turbulence = {};
+    bool turbulencePending = false;
+    DigestRow row = {};
+    uint32_t mismatches = 0;
+    uint32_t firstMismatch = 0;
+    bool checkEnded = false;
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t period = 0; period < periods; period++) {
+        clock.advanceUs(PERIOD_MS * 1000ULL);
+        uint32_t nowMs = clock.millis();
+        radio.advance(clock.micros());
+        anemometer.update();
+        analyzer.service(nowMs);
+
+        WindStats stats = anemometer.getStatistics();
+        if (analyzer.takeResult(turbulence)) {
+            turbulencePending = true;
+        }
+        AnemometerData data = {};
+        radio.macAddress(data.macAddress);
+        data.windSpeed = anemometer.getWindSpeed();
+        data.fields = WireFormat::FIELD_STATS;
+        data.windGust = stats.gust;
+        data.windLull = stats.lull;
+        data.windMean = stats.mean;
+        if (turbulencePending) {
+            data.fields |= WireFormat::FIELD_TURBULENCE;
+            data.turbulenceIntensity = turbulence.intensity;
+            data.gustFrequency = turbulence.gustFrequency;
+        }
+        if (comm.offer(data, nowMs)) {
+            turbulencePending = false;
+            row.frameCrc = RecordingFormat::crc32(frame, WireFormat::encodeAnemometer(data, frame, sizeof(frame)),
+                                                  row.frameCrc);
+            row.frames++;
+        }
+
+        row.period = period;
+        row.speed = data.windSpeed;
+        row.gust = stats.gust;
+        row.lull = stats.lull;
+        row.mean = stats.mean;
+        row.intensity = turbulence.intensity;
+        if (writeFile) {
+            writeDigest(writeFile, row);
+        }
+        if (checkFile && !checkEnded) {
+            DigestRow saved;
+            if (!readDigest(checkFile, saved)) {
+                checkEnded = true;
+            } else if (!sameDigest(row, saved)) {
+                if (mismatches++ == 0) {
+                    firstMismatch = period;
+                }
+            }
+        }
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t processed = anemometer.getSamplesProcessed();
+    double simulated = static_cast<double>(processed) / sampleRate;
+    printf("%s: %lu samples at %u SPS (%.2f h), %lu periods, %lu frames, %lu analyses\n",
+           traceCount ? traces[0] : "synthetic", static_cast<unsigned long>(processed),
+           static_cast<unsigned>(sampleRate), simulated / 3600.0, static_cast<unsigned long>(periods),
+           static_cast<unsigned long>(row.frames), static_cast<unsigned long>(analyzer.analyses()));
+    printf("%.2f s: %.2f M samples/s, %.1f ns/sample, %.0fx real time%s\n", wall, processed / wall / 1e6,
+           wall * 1e9 / (processed ? processed : 1), simulated / wall, writeFile ? " (digest written)" : "");
+
+    bool ok = processed == expected;
+    if (!ok) {
+        printf("MISMATCH: %llu samples expected\n", static_cast<unsigned long long>(expected));
+    }
+    if (writeFile) {
+        fclose(writeFile);
+        printf("Digest of %lu periods written to %s\n", static_cast<unsigned long>(periods), writePath);
+    }
+    if (checkFile) {
+        DigestRow extra;
+        if (checkEnded || readDigest(checkFile, extra)) {
+            printf("MISMATCH: %s has a different number of periods\n", checkPath);
+            ok = false;
+        }
+        fclose(checkFile);
+        if (mismatches) {
+            printf("MISMATCH: %lu periods differ from %s, first at %.2f s\n", static_cast<unsigned long>(mismatches),
+                   checkPath, firstMismatch * (PERIOD_MS / 1000.0));
+            ok = false;
+        } else if (ok) {
+            printf("Digest matches %s\n", checkPath);
+        }
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SessionCheck.cpp
+ * @brief Session statistics against offline computations over the stored samples
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Two synthetic sessions at the 4 Hz measurement rate go through SessionStatistics:
+ * independent Weibull speeds (k = 2.2, c = 6.5 m/s, a typical sailing site) and a
+ * bimodal mix of a light and a strong wind, on which a percentile sketch built for
+ * one hump would fail. Every sample is also kept, and the incremental results are
+ * checked against the offline ones: two-pass mean and standard deviation, extremes,
+ * exact histogram, percentiles of the sorted samples (compared as ranks: a P²
+ * estimate is good when the fraction of samples below it is close to p) and the
+ * maximum-likelihood Weibull fit of the raw samples.
+ *
+ * The session is then run again with a reboot halfway: the state goes through
+ * exportRecord() and a byte copy, as in RTC memory, and must end the same as the
+ * uninterrupted run. Finally the summary goes through the radio path: a request
+ * for another anemometer is ignored, a broadcast request is answered, and the
+ * frame a receiver decodes matches the statistics within the frame resolution.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Communication.h"
+#include "HostCommands.h"
+#include "HostRandom.h"
+#include "SessionStatistics.h"
+#include "SimRadio.h"
+#include "VirtualClock.h"
+#include "WireFormat.h"
+
+static const uint32_t PERIOD_MS = 250;          // Measurement period
+static const uint32_t GAP_EVERY = 20000;        // A 60 s outage (sensor lost) every 20000 samples
+static const uint32_t GAP_MS = 60000;
+static const float PERCENTILE_RANK_TOLERANCE[SessionStatistics::QUANTILES] = {0.005f, 0.005f, 0.002f};
+static const double WEIBULL_TOLERANCE = 0.02;   // Relative, binned fit against the raw samples
+
+/**
+ * @brief Weibull speed by inversion of the distribution function
+ */
+static float weibull(Random& random, double k, double c) {
+    return static_cast<float>(c * pow(-log(1.0 - random.uniform()), 1.0 / k));
+}
+
+/**
+ * @brief Maximum-likelihood Weibull fit of the raw samples (same equation as the
+ *        binned fit, every sample at its own speed)
+ */
+static void fitRaw(const std::vector<float>& samples, double& k, double& c) {
+    double meanLog = 0.0;
+    for (float v : samples) {
+        meanLog += log(v);
+    }
+    meanLog /= samples.size();
+    double low = 0.3;
+    double high = 15.0;
+    for (int iteration = 0; iteration < 50; iteration++) {
+        k = 0.5 * (low + high);
+        double powerSum = 0.0;
+        double weightedLog = 0.0;
+        for (float v : samples) {
+            double term = pow(v, k);
+            powerSum += term;
+            weightedLog += term * log(v);
+        }
+        if (weightedLog / powerSum - 1.0 / k - meanLog > 0.0) {
+            high = k;
+        } else {
+            low = k;
+        }
+    }
+    double powerSum = 0.0;
+    for (float v : samples) {
+        powerSum += pow(v, k);
+    }
+    c = pow(powerSum / samples.size(), 1.0 / k);
+}
+
+/**
+ * @brief Time stamp of a sample, with the periodic outages
+ */
+static uint32_t timestampMs(uint32_t index) {
+    return index * PERIOD_MS + (index / GAP_EVERY) * GAP_MS;
+}
+
+/**
+ * @brief Check one session against the offline computations
+ * @return true if every result is within tolerance
+ */
+static bool checkSession(const char* name, const std::vector<float>& samples) {
+    SessionStatistics session;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        session.addSample(samples[i], timestampMs(i));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / samples.size();
+    start = std::chrono::steady_clock::now();
+    bool fitted = session.fitWeibull();
+    double fitUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // Offline: two passes over the stored samples, then the sorted samples
+    double sum = 0.0;
+    for (float v : samples) {
+        sum += v;
+    }
+    double mean = sum / samples.size();
+    double squares = 0.0;
+    for (float v : samples) {
+        squares += (v - mean) * (v - mean);
+    }
+    double stddev = sqrt(squares / (samples.size() - 1));
+    std::vector<float> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    uint32_t histogram[SessionStatistics::BINS] = {};
+    for (float v : samples) {
+        size_t bin = static_cast<size_t>(v / SessionStatistics::BIN_WIDTH);
+        histogram[bin < SessionStatistics::BINS ? bin : SessionStatistics::BINS - 1]++;
+    }
+    double k = 0.0;
+    double c = 0.0;
+    fitRaw(samples, k, c);
+    uint32_t expectedDurationMs = 0;
+    for (uint32_t i = 1; i < samples.size(); i++) {
+        uint32_t gap = timestampMs(i) - timestampMs(i - 1);
+        expectedDurationMs += gap < SessionStatistics::MAX_GAP_MS ? gap : 0;
+    }
+
+    bool ok = fitted;
+    SessionSummary summary = {};
+    session.summary(summary);
+    printf("%s: %zu samples, %.0f ns/sample, Weibull fit %.0f us\n", name, samples.size(), ns, fitUs);
+    bool moments = fabs(session.mean() - mean) < 1e-4 && fabs(session.stddev() - stddev) < 1e-4 &&
+                   summary.min == sorted.front() && summary.max == sorted.back() &&
+                   summary.samples == samples.size() && summary.durationS == expectedDurationMs / 1000;
+    printf("  mean %.4f (offline %.4f), stddev %.4f (%.4f), min %.2f, max %.2f, %lu s %s\n", session.mean(), mean,
+           session.stddev(), stddev, summary.min, summary.max, static_cast<unsigned long>(summary.durationS),
+           moments ? "OK" : "MISMATCH");
+    ok = ok && moments;
+
+    bool binsMatch = true;
+    for (size_t i = 0; i < SessionStatistics::BINS; i++) {
+        binsMatch = binsMatch && session.binCount(i) == histogram[i];
+    }
+    printf("  histogram: %u bins sent, counts %s\n", summary.binCount, binsMatch ? "exact" : "MISMATCH");
+    ok = ok && binsMatch;
+
+    static const float P[SessionStatistics::QUANTILES] = {0.5f, 0.9f, 0.99f};
+    for (size_t i = 0; i < SessionStatistics::QUANTILES; i++) {
+        float estimate = session.quantile(i);
+        float exact = sorted[static_cast<size_t>(P[i] * (sorted.size() - 1) + 0.5f)];
+        float rank = static_cast<float>(std::upper_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) /
+                     sorted.size();
+        bool good = fabs(rank - P[i]) <= PERCENTILE_RANK_TOLERANCE[i];
+        printf("  p%-2.0f %.3f m/s (exact %.3f), rank %.4f %s\n", 100.0f * P[i], estimate, exact, rank,
+               good ? "OK" : "OUT OF TOLERANCE");
+        ok = ok && good;
+    }
+
+    bool weibullGood = fabs(session.weibullK() - k) / k < WEIBULL_TOLERANCE &&
+                       fabs(session.weibullC() - c) / c < WEIBULL_TOLERANCE;
+    printf("  Weibull k %.3f c %.3f (raw samples: k %.3f c %.3f) %s\n", session.weibullK(), session.weibullC(), k, c,
+           weibullGood ? "OK" : "OUT OF TOLERANCE");
+    return ok && weibullGood;
+}
+
+/**
+ * @brief Run the session with a reboot halfway and compare with the uninterrupted run
+ */
+static bool checkReboot(const std::vector<float>& samples) {
+    SessionStatistics uninterrupted;
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        uninterrupted.addSample(samples[i], timestampMs(i));
+    }
+    uninterrupted.fitWeibull();
+
+    // Before the reboot: export into retained memory (a byte copy), as EspSessionStore
+    SessionStatistics before;
+    uint32_t half = static_cast<uint32_t>(samples.size() / 2);
+    for (uint32_t i = 0; i < half; i++) {
+        before.addSample(samples[i], timestampMs(i));
+    }
+    SessionRecord record;
+    before.exportRecord(record);
+    uint8_t retained[sizeof(SessionRecord)];
+    memcpy(retained, &record, sizeof(record));
+
+    // After: a fresh object, and a clock started again from 0
+    SessionStatistics after;
+    SessionRecord restored;
+    memcpy(&restored, retained, sizeof(restored));
+    bool imported = after.importRecord(restored);
+    uint32_t rebootMs = timestampMs(half);
+    for (uint32_t i = half; i < samples.size(); i++) {
+        after.addSample(samples[i], timestampMs(i) - rebootMs);
+    }
+    after.fitWeibull();
+
+    // Same state, except the time between the last sample before the reboot and the first after
+    SessionRecord expected;
+    SessionRecord resumed;
+    uninterrupted.exportRecord(expected);
+    after.exportRecord(resumed);
+    uint32_t gapMs = timestampMs(half) - timestampMs(half - 1);
+    uint32_t lostMs = expected.durationMs - resumed.durationMs;
+    resumed.durationMs = expected.durationMs;
+    bool same = imported && lostMs == (gapMs < SessionStatistics::MAX_GAP_MS ? gapMs : 0) &&
+                memcmp(&expected, &resumed, sizeof(expected)) == 0;
+
+    // A record that does not add up is refused
+    SessionStatistics corrupted;
+    record.histogram[3]++;
+    bool refused = !corrupted.importRecord(record) && corrupted.samples() == 0;
+    printf("Reboot at sample %lu: %u-byte record, %s, %lu ms lost, corrupted record %s\n",
+           static_cast<unsigned long>(half), static_cast<unsigned>(sizeof(SessionRecord)),
+           same ? "same state as without reboot" : "STATE DIFFERS", static_cast<unsigned long>(lostMs),
+           refused ? "refused" : "ACCEPTED");
+    return same && refused;
+}
+
+/**
+ * @brief Ask for the summary over a simulated radio and decode the answer
+ */
+static bool checkSummaryFrame(const std::vector<float>& samples) {
+    SessionStatistics session;
+    for (uint32_t i = 0; i < samples.size(); i++) {
+        session.addSample(samples[i], timestampMs(i));
+    }
+    session.fitWeibull();
+
+    VirtualClock clock;
+    SimRadio radio;
+    Communication comm(radio, clock);
+    comm.setup();
+    comm.enableSummaryRequests();
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    radio.macAddress(mac);
+    static const uint8_t receiverMac[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x99};
+    uint8_t frame[WireFormat::MAX_FRAME_SIZE];
+
+    SummaryRequest request;
+    memcpy(request.target, receiverMac, sizeof(request.target)); // Another anemometer
+    size_t length = WireFormat::encodeSummaryRequest(request, frame, sizeof(frame));
+    radio.receive(receiverMac, frame, length, clock.micros());
+    bool ignored = !comm.summaryRequested();
+    memset(request.target, 0xFF, sizeof(request.target));
+    length = WireFormat::encodeSummaryRequest(request, frame, sizeof(frame));
+    radio.receive(receiverMac, frame, length, clock.micros());
+    bool requested = comm.summaryRequested();
+
+    SessionSummary summary = {};
+    session.summary(summary);
+    bool sent = comm.broadcastSummary(summary);
+    const SimRadio::Frame* answer = radio.frame(0);
+    SessionSummary decoded;
+    bool ok = ignored && requested && sent && !comm.summaryRequested() && answer &&
+              WireFormat::decodeSummary(answer->data, answer->length, decoded) &&
+              memcmp(decoded.macAddress, mac, sizeof(mac)) == 0 && decoded.samples == summary.samples &&
+              decoded.durationS == summary.durationS && decoded.binCount == summary.binCount;
+    const float speeds[][2] = {{decoded.mean, summary.mean},     {decoded.stddev, summary.stddev},
+                               {decoded.min, summary.min},       {decoded.max, summary.max},
+                               {decoded.p50, summary.p50},       {decoded.p90, summary.p90},
+                               {decoded.p99, summary.p99},       {decoded.weibullC, summary.weibullC}};
+    for (const auto& speed : speeds) {
+        ok = ok && fabs(speed[0] - speed[1]) <= 0.005f;
+    }
+    ok = ok && fabs(decoded.weibullK - summary.weibullK) <= 0.0005f && decoded.binWidth == summary.binWidth;
+    for (size_t i = 0; ok && i < summary.binCount; i++) {
+        ok = fabs(decoded.histogram[i] - summary.histogram[i]) <= 0.5f / 65535.0f;
+    }
+    printf("Summary frame: %zu bytes, %lu requests for this node, other node's request %s, decoded %s\n",
+           answer ? answer->length : static_cast<size_t>(0), static_cast<unsigned long>(comm.summaryRequests()),
+           ignored ? "ignored" : "ANSWERED", ok ? "OK" : "MISMATCH");
+    return ok;
+}
+
+int runSessionCheck(int argc, char** argv) {
+    uint32_t count = 200000; // 14 h at 4 Hz
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (count < 2 * SessionStatistics::MIN_FIT_SAMPLES) {
+        printf("At least %lu samples needed\n", static_cast<unsigned long>(2 * SessionStatistics::MIN_FIT_SAMPLES));
+        return 1;
+    }
+
+    Random random(seed);
+    std::vector<float> steady(count);
+    for (float& v : steady) {
+        v = weibull(random, 2.2, 6.5);
+    }
+    std::vector<float> bimodal(count);
+    for (float& v : bimodal) {
+        v = random.uniform() < 0.6 ? weibull(random, 3.0, 3.0) : weibull(random, 4.0, 11.0);
+    }
+
+    bool ok = checkSession("Weibull k 2.2 c 6.5", steady);
+    ok = checkSession("Bimodal 3 and 11 m/s", bimodal) && ok;
+    ok = checkReboot(steady) && ok;
+    ok = checkSummaryFrame(steady) && ok;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
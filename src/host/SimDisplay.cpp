@@ -0,0 +1,120 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SimDisplay.cpp
+ * @brief Headless DisplayDevice counting drawing work (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SimDisplay.h"
+#include <stdio.h>
+#include <string.h>
+
+SimDisplay::SimDisplay() : textSize_(1), calls_(0), pixels_(0), frame_() {
+}
+
+int16_t SimDisplay::width() {
+    return WIDTH;
+}
+
+int16_t SimDisplay::height() {
+    return HEIGHT;
+}
+
+void SimDisplay::fillScreen(uint16_t color) {
+    for (size_t i = 0; i < static_cast<size_t>(WIDTH) * HEIGHT; i++) {
+        frame_[i] = color;
+    }
+    calls_++;
+    pixels_ += static_cast<uint32_t>(WIDTH) * HEIGHT;
+}
+
+void SimDisplay::setTextSize(uint8_t size) {
+    textSize_ = size ? size : 1;
+}
+
+void SimDisplay::setTextColor(uint16_t color) {
+    (void)color;
+}
+
+void SimDisplay::setCursor(int16_t x, int16_t y) {
+    (void)x;
+    (void)y;
+}
+
+void SimDisplay::drawText(const char* text) {
+    calls_++;
+    pixels_ += static_cast<uint32_t>(textWidth(text)) * CHAR_HEIGHT * textSize_;
+}
+
+void SimDisplay::print(const char* text) {
+    drawText(text);
+}
+
+void SimDisplay::println(const char* text) {
+    drawText(text);
+}
+
+int16_t SimDisplay::textWidth(const char* text) {
+    return static_cast<int16_t>(strlen(text) * CHAR_WIDTH * textSize_);
+}
+
+void SimDisplay::pushImage(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t* pixels) {
+    calls_++;
+    pixels_ += static_cast<uint32_t>(w) * h;
+    for (int16_t row = 0; row < h; row++) {
+        for (int16_t column = 0; column < w; column++) {
+            int16_t px = x + column;
+            int16_t py = y + row;
+            if (px >= 0 && px < WIDTH && py >= 0 && py < HEIGHT) {
+                frame_[py * WIDTH + px] = pixels[row * w + column];
+            }
+        }
+    }
+}
+
+uint16_t SimDisplay::pixel(int16_t x, int16_t y) const {
+    return frame_[y * WIDTH + x];
+}
+
+bool SimDisplay::writePpm(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+    for (size_t i = 0; i < static_cast<size_t>(WIDTH) * HEIGHT; i++) {
+        uint16_t c = frame_[i];
+        uint8_t rgb[3] = {static_cast<uint8_t>((c >> 11) << 3), static_cast<uint8_t>(((c >> 5) & 0x3F) << 2),
+                          static_cast<uint8_t>((c & 0x1F) << 3)};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    return fclose(file) == 0;
+}
+
+uint32_t SimDisplay::calls() const {
+    return calls_;
+}
+
+uint32_t SimDisplay::pixels() const {
+    return pixels_;
+}
+
+void SimDisplay::reset() {
+    calls_ = 0;
+    pixels_ = 0;
+}
@@ -0,0 +1,152 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SimMuxAdc.cpp
+ * @brief Simulated ADS1115 multiplexer and single-shot timing
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SimMuxAdc.h"
+
+SimMuxAdc::SimMuxAdc(VirtualClock& clock, uint32_t writeUs, uint32_t readUs)
+    : clock_(clock), signal_(nullptr), context_(nullptr), sampleRate_(8), oscillatorError_(0.0f), writeUs_(writeUs),
+      readUs_(readUs), singleShot_(false), converting_(false), input_(0), startUs_(0), endUs_(0), register_(0),
+      conversions_(0), ignoredStarts_(0), busyUs_(0) {
+}
+
+void SimMuxAdc::setSignal(Signal signal, void* context) {
+    signal_ = signal;
+    context_ = context;
+}
+
+void SimMuxAdc::setOscillatorError(float error) {
+    oscillatorError_ = error;
+}
+
+bool SimMuxAdc::begin() {
+    clock_.advanceUs(readUs_);
+    return true;
+}
+
+/**
+ * @brief Select single-shot mode at the closest supported rate (rounding up)
+ */
+bool SimMuxAdc::startSingleShot(uint16_t samplesPerSecond) {
+    static const uint16_t RATES[] = {8, 16, 32, 64, 128, 250, 475, 860};
+    int i = 0;
+    while (i < 7 && RATES[i] < samplesPerSecond) {
+        i++;
+    }
+    sampleRate_ = RATES[i];
+    singleShot_ = true;
+    clock_.advanceUs(writeUs_);
+    return true;
+}
+
+bool SimMuxAdc::startContinuous(uint16_t samplesPerSecond) {
+    (void)samplesPerSecond;
+    return false;   // Only the single-shot multiplexer sequence is modelled
+}
+
+/**
+ * @brief Convert input 0 and wait for the result
+ */
+int16_t SimMuxAdc::readSingle() {
+    int16_t code = 0;
+    if (startConversion(0)) {
+        if (clock_.nowUs() < endUs_) {
+            clock_.advanceUs(endUs_ - clock_.nowUs());
+        }
+        readResult(code);
+    }
+    return code;
+}
+
+bool SimMuxAdc::readConversion(int16_t& code) {
+    (void)code;
+    return false;
+}
+
+uint16_t SimMuxAdc::sampleRate() const {
+    return sampleRate_;
+}
+
+float SimMuxAdc::millivoltsPerCode() const {
+    return VMETER_NOMINAL_MILLIVOLTS_PER_CODE;
+}
+
+uint8_t SimMuxAdc::inputCount() const {
+    return INPUTS;
+}
+
+/**
+ * @brief Config register write: the conversion starts when the write ends
+ */
+bool SimMuxAdc::startConversion(uint8_t input) {
+    if (!singleShot_ || input >= INPUTS) {
+        return false;
+    }
+    clock_.advanceUs(writeUs_);
+    update();
+    if (converting_) {
+        ignoredStarts_++;
+        return true;
+    }
+    uint64_t durationUs = POWER_UP_US + static_cast<uint64_t>(1000000.0f * (1.0f + oscillatorError_) / sampleRate_);
+    converting_ = true;
+    input_ = input;
+    startUs_ = clock_.nowUs();
+    endUs_ = startUs_ + durationUs;
+    busyUs_ += durationUs;
+    return true;
+}
+
+/**
+ * @brief Conversion register read: the value is latched when the data bytes start
+ */
+bool SimMuxAdc::readResult(int16_t& code) {
+    clock_.advanceUs(readUs_ / 2);
+    update();
+    code = register_;
+    clock_.advanceUs(readUs_ - readUs_ / 2);
+    return true;
+}
+
+/**
+ * @brief Latch the running conversion if it ended
+ */
+void SimMuxAdc::update() {
+    if (!converting_ || clock_.nowUs() < endUs_) {
+        return;
+    }
+    uint32_t middleUs = static_cast<uint32_t>(startUs_ + POWER_UP_US + (endUs_ - startUs_ - POWER_UP_US) / 2);
+    register_ = signal_ ? signal_(input_, middleUs, context_) : 0;
+    converting_ = false;
+    conversions_++;
+}
+
+uint32_t SimMuxAdc::conversions() const {
+    return conversions_;
+}
+
+uint32_t SimMuxAdc::ignoredStarts() const {
+    return ignoredStarts_;
+}
+
+uint64_t SimMuxAdc::busyUs() const {
+    return busyUs_;
+}
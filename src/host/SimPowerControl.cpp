@@ -0,0 +1,73 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SimPowerControl.cpp
+ * @brief Simulated PowerControl with a wake-up delay model (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SimPowerControl.h"
+
+SimPowerControl::SimPowerControl(VirtualClock& clock, uint32_t wakeDelayUs, uint32_t jitterUs, uint32_t seed)
+    : clock_(clock), wakeDelayUs_(wakeDelayUs), jitterUs_(jitterUs), seed_(seed ? seed : 1), alertPending_(false),
+      alertAtUs_(0), radioPowerSave_(false), lightSleeps_(0), idles_(0) {
+}
+
+PowerControl::WakeSource SimPowerControl::sleep(SleepMode mode, uint32_t durationUs) {
+    uint64_t now = clock_.nowUs();
+    uint64_t end = now + durationUs;
+    WakeSource source = WakeSource::Timer;
+    if (alertPending_ && alertAtUs_ <= end) {
+        end = alertAtUs_ > now ? alertAtUs_ : now;
+        alertPending_ = false;
+        source = WakeSource::Alert;
+    }
+    if (mode == SleepMode::Light) {
+        lightSleeps_++;
+        // xorshift32: same jitter on every run for a given seed
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        end += wakeDelayUs_ + (jitterUs_ ? seed_ % (jitterUs_ + 1) : 0);
+    } else {
+        idles_++;
+    }
+    clock_.advanceUs(end - now);
+    return source;
+}
+
+bool SimPowerControl::setRadioPowerSave(bool enabled) {
+    radioPowerSave_ = enabled;
+    return true;
+}
+
+void SimPowerControl::scheduleAlert(uint64_t atUs) {
+    alertPending_ = true;
+    alertAtUs_ = atUs;
+}
+
+bool SimPowerControl::radioPowerSave() const {
+    return radioPowerSave_;
+}
+
+uint32_t SimPowerControl::lightSleeps() const {
+    return lightSleeps_;
+}
+
+uint32_t SimPowerControl::idles() const {
+    return idles_;
+}
@@ -0,0 +1,148 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SimRadio.cpp
+ * @brief Simulated RadioTransport with a reproducible loss model (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SimRadio.h"
+#include <string.h>
+
+static const uint8_t DEFAULT_MAC[RadioTransport::MAC_SIZE] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+SimRadio::SimRadio(const uint8_t mac[MAC_SIZE])
+    : lossRate_(0.0f), seed_(1), history_(), sent_(0), lost_(0), handler_(nullptr), context_(nullptr),
+      sendHandler_(nullptr), sendContext_(nullptr), queueDepth_(8), airtimeUs_(800), nowUs_(0), pendingDueUs_(),
+      pendingDelivered_(), pendingHead_(0), pendingTail_(0) {
+    memcpy(mac_, mac ? mac : DEFAULT_MAC, MAC_SIZE);
+}
+
+bool SimRadio::begin() {
+    return true;
+}
+
+SimRadio::SendStatus SimRadio::send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) {
+    if (length == 0 || length > MAX_FRAME) {
+        return SendStatus::Failed;
+    }
+    if (sendHandler_ && pending() >= queueDepth_) {
+        return SendStatus::Busy;
+    }
+    sent_++;
+
+    bool delivered = true;
+    if (lossRate_ > 0.0f) {
+        // xorshift32: same pattern on every run for a given seed
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        if ((seed_ >> 8) * (1.0f / 16777216.0f) < lossRate_) {
+            lost_++;
+            delivered = false; // Accepted by the radio, lost on the air
+        }
+    }
+    if (sendHandler_) {
+        // Frames leave one after the other
+        uint32_t startUs = nowUs_;
+        if (pending() > 0) {
+            uint32_t previousUs = pendingDueUs_[(pendingHead_ - 1) % MAX_QUEUE];
+            startUs = static_cast<int32_t>(previousUs - nowUs_) > 0 ? previousUs : nowUs_;
+        }
+        pendingDueUs_[pendingHead_ % MAX_QUEUE] = startUs + airtimeUs_;
+        pendingDelivered_[pendingHead_ % MAX_QUEUE] = delivered;
+        pendingHead_++;
+    }
+    if (!delivered) {
+        return SendStatus::Queued;
+    }
+
+    Frame& slot = history_[(sent_ - lost_ - 1) % HISTORY_SIZE];
+    memcpy(slot.destination, destination, MAC_SIZE);
+    memcpy(slot.data, data, length);
+    slot.length = length;
+    return SendStatus::Queued;
+}
+
+void SimRadio::macAddress(uint8_t mac[MAC_SIZE]) {
+    memcpy(mac, mac_, MAC_SIZE);
+}
+
+bool SimRadio::setReceiveHandler(ReceiveHandler handler, void* context) {
+    handler_ = handler;
+    context_ = context;
+    return true;
+}
+
+bool SimRadio::receive(const uint8_t source[MAC_SIZE], const uint8_t* data, size_t length, uint32_t rxUs) {
+    if (!handler_) {
+        return false;
+    }
+    handler_(context_, source, data, length, rxUs);
+    return true;
+}
+
+bool SimRadio::setSendHandler(SendHandler handler, void* context) {
+    sendHandler_ = handler;
+    sendContext_ = context;
+    return true;
+}
+
+void SimRadio::setDriver(size_t queueDepth, uint32_t airtimeUs) {
+    queueDepth_ = queueDepth < MAX_QUEUE ? queueDepth : MAX_QUEUE;
+    airtimeUs_ = airtimeUs;
+}
+
+void SimRadio::advance(uint32_t nowUs) {
+    nowUs_ = nowUs;
+    while (pending() > 0 && static_cast<int32_t>(nowUs - pendingDueUs_[pendingTail_ % MAX_QUEUE]) >= 0) {
+        size_t index = pendingTail_ % MAX_QUEUE;
+        pendingTail_++;
+        if (sendHandler_) {
+            sendHandler_(sendContext_, pendingDelivered_[index], pendingDueUs_[index]);
+        }
+    }
+}
+
+size_t SimRadio::pending() const {
+    return pendingHead_ - pendingTail_;
+}
+
+void SimRadio::setLossRate(float lossRate, uint32_t seed) {
+    lossRate_ = lossRate;
+    seed_ = seed ? seed : 1;
+}
+
+uint32_t SimRadio::sent() const {
+    return sent_;
+}
+
+uint32_t SimRadio::lost() const {
+    return lost_;
+}
+
+uint32_t SimRadio::delivered() const {
+    return sent_ - lost_;
+}
+
+const SimRadio::Frame* SimRadio::frame(size_t age) const {
+    uint32_t count = delivered();
+    if (age >= HISTORY_SIZE || age >= count) {
+        return nullptr;
+    }
+    return &history_[(count - 1 - age) % HISTORY_SIZE];
+}
@@ -0,0 +1,149 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file StreamBench.cpp
+ * @brief Raw sample stream written to stdout, for tools/capture_stream.py
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Simulated codes go through Anemometer into a SampleStreamer writing the binary
+ * stream to stdout, exactly as the firmware writes it to the USB serial port. With
+ * --realtime the converter runs in continuous mode at its data rate on the system
+ * clock (the capture tool's pseudo-terminal test); otherwise single-shot codes on a
+ * virtual clock are produced as fast as the writer takes them. The code count and
+ * sum printed on stderr let the receiver check it got every code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "Anemometer.h"
+#include "FakeAdcSource.h"
+#include "HostConsole.h"
+#include "SampleStreamer.h"
+#include "SystemClock.h"
+#include "VirtualClock.h"
+
+static const uint32_t PERIOD_MS = 250;
+
+namespace {
+
+/**
+ * @brief Simulated converter that adds up the codes it hands out
+ */
+class SummingSource : public FakeAdcSource {
+public:
+    uint32_t codes = 0;
+    int64_t sum = 0;
+
+    int16_t readSingle() override {
+        int16_t code = FakeAdcSource::readSingle();
+        codes++;
+        sum += code;
+        return code;
+    }
+
+    bool readConversion(int16_t& code) override {
+        if (!FakeAdcSource::readConversion(code)) {
+            return false;
+        }
+        codes++;
+        sum += code;
+        return true;
+    }
+};
+
+} // namespace
+
+int runStreamBench(int argc, char** argv) {
+    uint32_t seconds = 10;
+    uint16_t rate = 860;
+    bool realtime = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        } else {
+            fprintf(stderr, "Usage: stream [--seconds N] [--rate SPS] [--realtime] > stream.bin\n");
+            return 1;
+        }
+    }
+
+    // Unbuffered, so each batch reaches the reader when the writer task sends it
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    HostConsole console(false);
+    SampleStreamer streamer(console);
+    SummingSource adc;
+    adc.setSignal(300, 250, 7.0f, 12);
+    SystemClock systemClock;
+    VirtualClock virtualClock;
+    Clock& clock = realtime ? static_cast<Clock&>(systemClock) : static_cast<Clock&>(virtualClock);
+    Anemometer anemometer(adc, clock, realtime ? AcquisitionMode::Continuous : AcquisitionMode::SingleShot, rate);
+    anemometer.setup();
+
+    StreamFormat::StreamInfo info = {};
+    static const uint8_t HOST_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(info.macAddress, HOST_MAC, sizeof(HOST_MAC));
+    info.sampleRate = adc.sampleRate();
+    info.millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    if (!streamer.begin(info)) {
+        fprintf(stderr, "Cannot start the streamer\n");
+        return 1;
+    }
+    anemometer.setStreamer(&streamer);
+
+    const uint32_t periods = seconds * 1000 / PERIOD_MS;
+    const uint32_t codesPerPeriod = adc.sampleRate() * PERIOD_MS / 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t period = 0; period < periods; period++) {
+        if (realtime) {
+            RtosTask::sleepMs(PERIOD_MS);
+            anemometer.update();
+            continue;
+        }
+        for (uint32_t i = 0; i < codesPerPeriod; i++) {
+            virtualClock.advanceUs(1000000 / adc.sampleRate());
+            anemometer.update();
+        }
+        // Give the writer room, as the serial port does not go faster than it drains
+        while (streamer.queued() > SampleStreamer::QUEUE_PACKETS / 2) {
+            RtosTask::sleepMs(1);
+        }
+    }
+    // Stop the reader, then stream the codes still in the acquisition ring
+    anemometer.stop();
+    anemometer.update();
+    streamer.stop();
+    fflush(stdout);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(stderr, "stream: %lu codes, sum %lld, %lu dropped, %lu overruns, %lu packets, %lu bytes\n",
+            static_cast<unsigned long>(streamer.codesAppended()), static_cast<long long>(adc.sum),
+            static_cast<unsigned long>(streamer.codesDropped()), static_cast<unsigned long>(anemometer.getOverruns()),
+            static_cast<unsigned long>(streamer.packetsWritten()), static_cast<unsigned long>(streamer.bytesWritten()));
+    fprintf(stderr, "%.2f s: %.0f bytes/s (%.0f at %u SPS), queue high-water %lu/%u, %lu short writes\n", wall,
+            streamer.bytesWritten() / wall, streamer.bytesWritten() / (seconds ? seconds : 1.0),
+            static_cast<unsigned>(adc.sampleRate()), static_cast<unsigned long>(streamer.queueHighWater()),
+            static_cast<unsigned>(SampleStreamer::QUEUE_PACKETS), static_cast<unsigned long>(streamer.shortWrites()));
+    bool ok = streamer.codesDropped() == 0 && streamer.shortWrites() == 0 && adc.codes == streamer.codesAppended();
+    fprintf(stderr, "%s\n", ok ? "OK" : "DROPS");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file SystemClock.cpp
+ * @brief std::chrono implementation of Clock (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "SystemClock.h"
+#include <chrono>
+#include <thread>
+
+static int64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+SystemClock::SystemClock() : startUs_(steadyMicros()) {
+}
+
+uint32_t SystemClock::millis() {
+    return static_cast<uint32_t>((steadyMicros() - startUs_) / 1000);
+}
+
+uint32_t SystemClock::micros() {
+    return static_cast<uint32_t>(steadyMicros() - startUs_);
+}
+
+void SystemClock::delayMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void SystemClock::delayUs(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
@@ -0,0 +1,264 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TimeSyncSim.cpp
+ * @brief Time synchronisation of drifting anemometer clocks to a reference node
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Every node has its own microsecond clock: a random origin (so the 32-bit time
+ * wraps during the run), a fixed drift of up to --drift ppm and a slow random walk
+ * of the rate, like a crystal warming up. The reference queues a beacon every
+ * second; the frame reaches the air after a random queue delay (occasionally a
+ * long one), the reference stamps its departure in the send-completion handler and
+ * each follower stamps its arrival in the receive handler, both after a short random
+ * delay. Beacons go through the wire format encoder and decoder, and may be lost.
+ *
+ * Each follower converts an acquisition time every 250 ms; the error is the
+ * difference with the reference clock at the same instant. With --jump, the
+ * reference clock jumps halfway through (a reboot) and the followers must refit.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "HostCommands.h"
+#include "HostRandom.h"
+#include "TimeSync.h"
+#include "WireFormat.h"
+
+static const double QUEUE_DELAY_US = 450.0;     // Shortest queue-to-air delay of a beacon
+static const double QUEUE_JITTER_US = 250.0;    // Uniform jitter on top of it
+static const double LATE_PROBABILITY = 0.03;    // Beacons held behind other traffic
+static const double LATE_US = 3000.0;           // Extra delay of those, at most
+static const double HANDLER_DELAY_US = 40.0;    // Send-completion and receive handler delay, at most
+static const double WANDER_PPM = 0.02;          // Rate random walk per second
+static const double SAMPLE_PERIOD_US = 250000.0; // Acquisition times converted per follower
+
+namespace {
+
+/**
+ * @brief Free-running clock: local time as a function of the simulation time
+ */
+struct SimClock {
+    double originUs;    // Local time at the last rate change
+    double sinceUs;     // Simulation time of the last rate change
+    double rate;        // Local microseconds per simulation microsecond
+
+    double at(double timeUs) const {
+        return originUs + (timeUs - sinceUs) * rate;
+    }
+
+    uint32_t micros(double timeUs) const {
+        return static_cast<uint32_t>(static_cast<uint64_t>(at(timeUs)));
+    }
+
+    void setRate(double timeUs, double newRate) {
+        originUs = at(timeUs);
+        sinceUs = timeUs;
+        rate = newRate;
+    }
+};
+
+struct Follower {
+    SimClock clock;
+    TimeSync sync;
+    double syncedAtUs;      // First time synced, negative until then
+    double squares;         // Sum of the squared errors once synced
+    uint64_t samples;
+    double maxErrorUs;
+    uint64_t withinEstimate; // Errors within the errorUs() reported with the sample
+};
+
+} // namespace
+
+/**
+ * @brief Random clock: origin anywhere in the 32-bit range, drift within +/- ppm
+ */
+static SimClock randomClock(Random& random, double driftPpm) {
+    SimClock clock;
+    clock.originUs = random.uniform() * 4294967296.0 + 4294967296.0; // Positive after the jumps
+    clock.sinceUs = 0.0;
+    clock.rate = 1.0 + (2.0 * random.uniform() - 1.0) * driftPpm * 1e-6;
+    return clock;
+}
+
+int runTimeSyncSim(int argc, char** argv) {
+    uint32_t nodes = 10;
+    uint32_t seconds = 600;
+    double driftPpm = 40.0;
+    double loss = 0.05;
+    uint32_t seed = 1;
+    bool jump = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodes = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--drift") == 0 && i + 1 < argc) {
+            driftPpm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            loss = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--jump") == 0) {
+            jump = true;
+        } else {
+            fprintf(stderr, "Usage: timesync [--nodes N] [--seconds N] [--drift PPM] [--loss RATE] [--seed N] [--jump]\n");
+            return 1;
+        }
+    }
+    if (nodes < 2 || seconds < 30) {
+        fprintf(stderr, "At least 2 nodes and 30 s\n");
+        return 1;
+    }
+
+    Random random(seed);
+    uint8_t mac[TimeSync::MAC_SIZE] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x00};
+    SimClock referenceClock = randomClock(random, driftPpm);
+    TimeSync reference;
+    reference.begin(mac, TimeSync::Role::Reference);
+    std::vector<Follower> followers(nodes - 1);
+    for (size_t i = 0; i < followers.size(); i++) {
+        Follower& follower = followers[i];
+        mac[5] = static_cast<uint8_t>(i + 1);
+        follower.clock = randomClock(random, driftPpm);
+        follower.sync.begin(mac, TimeSync::Role::Follower);
+        follower.syncedAtUs = -1.0;
+        follower.squares = 0.0;
+        follower.samples = 0;
+        follower.maxErrorUs = 0.0;
+        follower.withinEstimate = 0;
+    }
+
+    const double endUs = seconds * 1e6;
+    double jumpUs = jump ? endUs / 2 : endUs + 1.0;
+    const double settleUs = jump ? jumpUs + 30e6 : 0.0; // Errors counted after the refit
+    bool previousSent = false;
+    uint32_t previousAirUs = 0;
+    uint64_t late = 0;
+    for (double timeUs = 0.0; timeUs < endUs; timeUs += 1000.0) {
+        if (timeUs >= jumpUs) {
+            referenceClock.originUs += 1e9 + random.uniform() * 1e9; // Rebooted with another uptime
+            jumpUs = endUs + 1.0;
+        }
+        if (fmod(timeUs, 1e6) == 0.0) {
+            // Clocks wander once per second
+            referenceClock.setRate(timeUs, referenceClock.rate + (2.0 * random.uniform() - 1.0) * WANDER_PPM * 1e-6);
+            for (Follower& follower : followers) {
+                follower.clock.setRate(timeUs,
+                                       follower.clock.rate + (2.0 * random.uniform() - 1.0) * WANDER_PPM * 1e-6);
+            }
+        }
+        if (reference.beaconDue(referenceClock.micros(timeUs))) {
+            TimeBeacon beacon;
+            reference.makeBeacon(beacon, referenceClock.micros(timeUs), previousSent, previousAirUs);
+            uint8_t frame[WireFormat::TIME_BEACON_SIZE];
+            size_t length = WireFormat::encodeTimeBeacon(beacon, frame, sizeof(frame));
+            double delayUs = QUEUE_DELAY_US + random.uniform() * QUEUE_JITTER_US;
+            if (random.uniform() < LATE_PROBABILITY) {
+                delayUs += random.uniform() * LATE_US;
+                late++;
+            }
+            double airUs = timeUs + delayUs;
+            previousSent = true;
+            previousAirUs = referenceClock.micros(airUs + random.uniform() * HANDLER_DELAY_US);
+            for (Follower& follower : followers) {
+                TimeBeacon decoded;
+                if (random.uniform() < loss || !WireFormat::decodeTimeBeacon(frame, length, decoded)) {
+                    continue;
+                }
+                follower.sync.observe(decoded, follower.clock.micros(airUs + random.uniform() * HANDLER_DELAY_US));
+            }
+        }
+        if (fmod(timeUs, SAMPLE_PERIOD_US) != 0.0) {
+            continue;
+        }
+        for (Follower& follower : followers) {
+            // Acquisition somewhere in the millisecond
+            double sampleUs = timeUs + random.uniform() * 1000.0;
+            uint32_t localUs = follower.clock.micros(sampleUs);
+            if (!follower.sync.synced(localUs)) {
+                continue;
+            }
+            if (follower.syncedAtUs < 0.0) {
+                follower.syncedAtUs = sampleUs;
+            }
+            if (sampleUs < settleUs) {
+                continue;
+            }
+            int32_t error = static_cast<int32_t>(follower.sync.toReference(localUs) - referenceClock.micros(sampleUs));
+            double magnitude = fabs(static_cast<double>(error));
+            follower.squares += magnitude * magnitude;
+            follower.samples++;
+            if (magnitude > follower.maxErrorUs) {
+                follower.maxErrorUs = magnitude;
+            }
+            if (magnitude <= follower.sync.errorUs(localUs)) {
+                follower.withinEstimate++;
+            }
+        }
+    }
+
+    printf("%lu followers, %lu s, drift up to %.0f ppm, %.0f%% beacon loss, %llu late beacons%s\n",
+           static_cast<unsigned long>(followers.size()), static_cast<unsigned long>(seconds), driftPpm,
+           100.0 * loss, static_cast<unsigned long long>(late), jump ? ", reference jump" : "");
+    printf("node  synced after  rms error  max error  within est.  drift true  drift est.  beacons  lost  outliers  "
+           "resets\n");
+    double worstSyncUs = 0.0;
+    double squares = 0.0;
+    uint64_t samples = 0;
+    double maxErrorUs = 0.0;
+    double maxDriftErrorPpm = 0.0;
+    bool allSynced = true;
+    for (size_t i = 0; i < followers.size(); i++) {
+        const Follower& follower = followers[i];
+        // Offset = reference - local, so its slope against local time is rate ratio - 1
+        double truePpm = (referenceClock.rate / follower.clock.rate - 1.0) * 1e6;
+        double estimatedPpm = follower.sync.driftPpm();
+        if (follower.syncedAtUs < 0.0 || follower.samples == 0) {
+            allSynced = false;
+        }
+        if (follower.syncedAtUs > worstSyncUs) {
+            worstSyncUs = follower.syncedAtUs;
+        }
+        squares += follower.squares;
+        samples += follower.samples;
+        if (follower.maxErrorUs > maxErrorUs) {
+            maxErrorUs = follower.maxErrorUs;
+        }
+        if (fabs(estimatedPpm - truePpm) > maxDriftErrorPpm) {
+            maxDriftErrorPpm = fabs(estimatedPpm - truePpm);
+        }
+        double rms = follower.samples ? sqrt(follower.squares / follower.samples) : 0.0;
+        double within = follower.samples ? 100.0 * follower.withinEstimate / follower.samples : 0.0;
+        printf("%4lu  %10.2f s  %6.1f us  %6.0f us  %10.1f%%  %6.2f ppm  %6.2f ppm  %7lu  %4lu  %8lu  %6lu\n",
+               static_cast<unsigned long>(i + 1), follower.syncedAtUs / 1e6, rms, follower.maxErrorUs, within,
+               truePpm, estimatedPpm, static_cast<unsigned long>(follower.sync.beacons()),
+               static_cast<unsigned long>(follower.sync.lostBeacons()),
+               static_cast<unsigned long>(follower.sync.outliers()), static_cast<unsigned long>(follower.sync.resets()));
+    }
+    double rms = samples ? sqrt(squares / samples) : 0.0;
+    printf("All: synced within %.2f s, rms error %.1f us, max error %.0f us, drift error up to %.2f ppm\n",
+           worstSyncUs / 1e6, rms, maxErrorUs, maxDriftErrorPpm);
+
+    // Four consecutive beacons to sync (many more with heavy losses), handler jitter left
+    bool ok = allSynced && worstSyncUs < 20e6 && rms < 25.0 && maxErrorUs < 250.0 && maxDriftErrorPpm < 3.0;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
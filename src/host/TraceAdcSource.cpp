@@ -0,0 +1,288 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TraceAdcSource.cpp
+ * @brief Recorded trace replay as an AdcSource (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "TraceAdcSource.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Anemometer.h"
+#include "RecordingFormat.h"
+#include "StreamFormat.h"
+
+// Rates of the ADS1115: a rate measured from timestamps is snapped to the closest
+static const uint16_t ADS1115_RATES[] = {8, 16, 32, 64, 128, 250, 475, 860};
+
+static uint16_t snapRate(double samplesPerSecond) {
+    uint16_t best = ADS1115_RATES[0];
+    for (uint16_t rate : ADS1115_RATES) {
+        if (fabs(rate - samplesPerSecond) < fabs(best - samplesPerSecond)) {
+            best = rate;
+        }
+    }
+    if (fabs(best - samplesPerSecond) > 0.05 * best) {
+        return static_cast<uint16_t>(samplesPerSecond + 0.5);
+    }
+    return best;
+}
+
+TraceAdcSource::TraceAdcSource()
+    : position_(0), sampleRate_(860), millivoltsPerCode_(VMETER_NOMINAL_MILLIVOLTS_PER_CODE) {
+}
+
+bool TraceAdcSource::load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t start[RecordingFormat::SECTOR_SIZE];
+    size_t length = fread(start, 1, sizeof(start), file);
+    fseek(file, 0, SEEK_SET);
+    size_t before = codes_.size();
+    RecordingFormat::FileInfo info;
+    bool ok;
+    if (length == sizeof(start) && RecordingFormat::decodeFileHeader(start, info)) {
+        ok = loadRecording(file);
+    } else if (memchr(start, StreamFormat::DELIMITER, length)) {
+        ok = loadStream(file);
+    } else {
+        ok = loadCsv(file);
+    }
+    fclose(file);
+    return ok && codes_.size() > before;
+}
+
+/**
+ * @brief Codes of a binary recording, up to the first invalid sector
+ */
+bool TraceAdcSource::loadRecording(FILE* file) {
+    uint8_t sector[RecordingFormat::SECTOR_SIZE];
+    RecordingFormat::FileInfo info;
+    if (fread(sector, 1, sizeof(sector), file) != sizeof(sector) || !RecordingFormat::decodeFileHeader(sector, info)) {
+        return false;
+    }
+    sampleRate_ = info.sampleRate;
+    millivoltsPerCode_ = info.millivoltsPerCode / Anemometer::COEF_CORRECTION;
+    uint16_t count;
+    uint16_t dropped;
+    for (uint32_t index = 1; fread(sector, 1, sizeof(sector), file) == sizeof(sector); index++) {
+        if (!RecordingFormat::checkSector(sector, info.session, index, count, dropped)) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            codes_.push_back(RecordingFormat::getRecord(sector, i).code);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Codes of the valid samples packets of a serial capture
+ */
+bool TraceAdcSource::loadStream(FILE* file) {
+    uint8_t frame[StreamFormat::MAX_FRAME_SIZE];
+    uint8_t packet[StreamFormat::MAX_FRAME_SIZE];
+    int16_t codes[StreamFormat::MAX_CODES];
+    size_t length = 0;
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+        if (c != StreamFormat::DELIMITER) {
+            if (length < sizeof(frame)) {
+                frame[length] = static_cast<uint8_t>(c);
+            }
+            length++;
+            continue;
+        }
+        size_t size = length <= sizeof(frame) ? StreamFormat::cobsDecode(frame, length, packet, sizeof(packet)) : 0;
+        length = 0;
+        StreamFormat::SamplesHeader header;
+        StreamFormat::StreamInfo info;
+        switch (StreamFormat::checkPacket(packet, size)) {
+        case StreamFormat::TYPE_SAMPLES:
+            if (StreamFormat::decodeSamples(packet, size, header, codes)) {
+                codes_.insert(codes_.end(), codes, codes + header.count);
+            }
+            break;
+        case StreamFormat::TYPE_INFO:
+            if (StreamFormat::decodeInfo(packet, size, info)) {
+                sampleRate_ = info.sampleRate;
+                millivoltsPerCode_ = info.millivoltsPerCode / Anemometer::COEF_CORRECTION;
+            }
+            break;
+        default:
+            break; // Damaged packet or text between packets
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Codes of a CSV trace, located by the header names
+ */
+bool TraceAdcSource::loadCsv(FILE* file) {
+    char line[512];
+    int codeColumn = 0;
+    int millivoltsColumn = -1;
+    int voltsColumn = -1;
+    int timeColumn = -1;
+    double timeScale = 1.0;   // To microseconds
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    double millivoltsSum = 0.0;
+    double codeSum = 0.0;
+    size_t rows = 0;
+    bool first = true;
+    while (fgets(line, sizeof(line), file)) {
+        if (first) {
+            first = false;
+            if (!strchr("0123456789.-", line[0])) {
+                codeColumn = -1;
+                int column = 0;
+                for (char* field = strtok(line, ",\r\n"); field; field = strtok(nullptr, ",\r\n"), column++) {
+                    if (strcmp(field, "code") == 0) {
+                        codeColumn = column;
+                    } else if (strcmp(field, "millivolts") == 0) {
+                        millivoltsColumn = column;
+                    } else if (strcmp(field, "voltage") == 0) {
+                        voltsColumn = column;
+                    } else if (strcmp(field, "timestamp_us") == 0) {
+                        timeColumn = column;
+                    } else if (strcmp(field, "timestamp_ms") == 0) {
+                        timeColumn = column;
+                        timeScale = 1e3;
+                    } else if (strcmp(field, "time_s") == 0) {
+                        timeColumn = column;
+                        timeScale = 1e6;
+                    }
+                }
+                if (codeColumn < 0 && millivoltsColumn < 0 && voltsColumn < 0) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        double code = NAN;
+        double millivolts = NAN;
+        double time = NAN;
+        int column = 0;
+        for (char* field = strtok(line, ",\r\n"); field; field = strtok(nullptr, ",\r\n"), column++) {
+            if (column == codeColumn) {
+                code = strtod(field, nullptr);
+            } else if (column == millivoltsColumn) {
+                millivolts = strtod(field, nullptr);
+            } else if (column == voltsColumn) {
+                millivolts = strtod(field, nullptr) * 1000.0;
+            } else if (column == timeColumn) {
+                time = strtod(field, nullptr) * timeScale;
+            }
+        }
+        if (!isnan(code) && !isnan(millivolts) && code != 0.0) {
+            millivoltsSum += fabs(millivolts);
+            codeSum += fabs(code);
+        }
+        if (isnan(code)) {
+            if (isnan(millivolts)) {
+                continue;
+            }
+            code = millivolts / (millivoltsPerCode_ * Anemometer::COEF_CORRECTION);
+        }
+        code = code < -32768.0 ? -32768.0 : (code > 32767.0 ? 32767.0 : code);
+        codes_.push_back(static_cast<int16_t>(lround(code)));
+        if (!isnan(time)) {
+            if (rows == 0) {
+                firstTime = time;
+            }
+            lastTime = time;
+            rows++;
+        }
+    }
+    if (rows > 1 && lastTime > firstTime) {
+        sampleRate_ = snapRate((rows - 1) * 1e6 / (lastTime - firstTime));
+    }
+    if (codeSum > 0.0) {
+        millivoltsPerCode_ = static_cast<float>(millivoltsSum / codeSum) / Anemometer::COEF_CORRECTION;
+    }
+    return true;
+}
+
+void TraceAdcSource::setSampleRate(uint16_t samplesPerSecond) {
+    sampleRate_ = samplesPerSecond;
+}
+
+void TraceAdcSource::rewind() {
+    position_ = 0;
+}
+
+size_t TraceAdcSource::size() const {
+    return codes_.size();
+}
+
+size_t TraceAdcSource::position() const {
+    return position_;
+}
+
+bool TraceAdcSource::finished() const {
+    return position_ >= codes_.size();
+}
+
+int16_t TraceAdcSource::next() {
+    if (codes_.empty()) {
+        return 0;
+    }
+    if (position_ >= codes_.size()) {
+        return codes_.back();
+    }
+    return codes_[position_++];
+}
+
+bool TraceAdcSource::begin() {
+    rewind();
+    return !codes_.empty();
+}
+
+bool TraceAdcSource::startSingleShot(uint16_t samplesPerSecond) {
+    (void)samplesPerSecond; // The trace keeps its own rate
+    return true;
+}
+
+bool TraceAdcSource::startContinuous(uint16_t samplesPerSecond) {
+    (void)samplesPerSecond;
+    return true;
+}
+
+int16_t TraceAdcSource::readSingle() {
+    return next();
+}
+
+bool TraceAdcSource::readConversion(int16_t& code) {
+    if (finished()) {
+        return false;
+    }
+    code = next();
+    return true;
+}
+
+uint16_t TraceAdcSource::sampleRate() const {
+    return sampleRate_;
+}
+
+float TraceAdcSource::millivoltsPerCode() const {
+    return millivoltsPerCode_;
+}
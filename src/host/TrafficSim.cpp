@@ -0,0 +1,433 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TrafficSim.cpp
+ * @brief Fleet traffic generator against the reference receiver, with loss, reordering and an outage
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Every simulated anemometer is the firmware's transmit path: its own VirtualClock
+ * (random origin), SimRadio, Communication with the broadcast policy, TimeSync and
+ * WindStatistics, fed with its own wind trace (a sea breeze with gust cycles and
+ * turbulence, plus a gust front crossing the fleet one node after the other). Node
+ * 0 is the time reference; the others sync to its beacons, so frames carry FIELD_TIME.
+ *
+ * The channel drops frames independently per receiver and holds a few back (reordering).
+ * One node goes silent for --outage seconds a third of the way in. A FleetReceiver
+ * decodes everything; its loss, reordering and timeout counts are checked against
+ * what the channel actually did. The frames delivered are then replayed through
+ * fresh receivers to measure the receiver throughput.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <vector>
+#include "HostCommands.h"
+#include "HostRandom.h"
+#include "Communication.h"
+#include "FleetReceiver.h"
+#include "SimRadio.h"
+#include "TimeSync.h"
+#include "VirtualClock.h"
+#include "WindStatistics.h"
+
+static const uint32_t STEP_US = 250000;         // Measurement period
+static const uint32_t AIRTIME_US = 800;         // Frame on the air
+static const double HOLD_MIN_US = 250000.0;     // Delay of a reordered frame
+static const double HOLD_MAX_US = 1000000.0;
+static const uint32_t OUTAGE_NODE = 1;
+
+namespace {
+
+/**
+ * @brief One simulated anemometer
+ */
+struct TrafficNode {
+    uint64_t originUs;          // Local time at simulation time 0
+    VirtualClock clock;
+    SimRadio radio;
+    Communication comm;
+    TimeSync timeSync;
+    WindStatistics statistics;
+    uint32_t phaseUs;           // Measurement time within the period
+    float offset;               // Local wind offset (m/s)
+    float gustPhase;            // Gust cycle phase (rad)
+    float turbulence;           // Correlated turbulence, unit variance
+    uint32_t seenFrames;        // Radio frames already put on the channel
+    uint32_t sent;              // Anemometer frames sent (index of the next one)
+    std::vector<bool> delivered; // Per frame index, delivered to the receiver
+    uint32_t maxDelivered;      // Highest index delivered + 1
+    uint32_t reordered;         // Frames delivered after a later one
+    uint32_t duplicates;        // Frames delivered twice (none: the channel does not duplicate)
+    uint64_t lastDeliveryUs;    // Simulation time of the last frame delivered
+    uint32_t longSilences;      // Gaps of at least the timeout between deliveries
+    uint32_t certainSilences;   // Gaps of at least the timeout plus one poll period
+
+    TrafficNode(const uint8_t mac[SimRadio::MAC_SIZE], uint64_t origin)
+        : originUs(origin), clock(origin), radio(mac), comm(radio, clock), timeSync(), statistics(), phaseUs(0), offset(0.0f),
+          gustPhase(0.0f), turbulence(0.0f), seenFrames(0), sent(0), delivered(), maxDelivered(0), reordered(0),
+          duplicates(0), lastDeliveryUs(0), longSilences(0), certainSilences(0) {
+    }
+};
+
+/**
+ * @brief Frame on its way to the receiver
+ */
+struct ChannelFrame {
+    uint64_t deliverUs;         // Simulation time of arrival
+    uint32_t order;             // Tie-break, send order
+    int node;                   // Sender, -1 for a beacon
+    uint32_t index;             // Anemometer frame index of the sender
+    uint8_t length;
+    uint8_t data[WireFormat::MAX_FRAME_SIZE];
+
+    bool operator>(const ChannelFrame& other) const {
+        return deliverUs != other.deliverUs ? deliverUs > other.deliverUs : order > other.order;
+    }
+};
+
+/**
+ * @brief Frame as delivered, for the throughput replay
+ */
+struct RecordedFrame {
+    uint32_t rxUs;
+    uint8_t length;
+    uint8_t data[WireFormat::MAX_FRAME_SIZE];
+};
+
+} // namespace
+
+/**
+ * @brief Wind at one node: breeze with gust cycles and turbulence, plus the gust front
+ */
+static float windAt(TrafficNode& node, Random& random, double timeS, double frontS, size_t index) {
+    node.turbulence = 0.9f * node.turbulence + 0.75f * static_cast<float>(2.0 * random.uniform() - 1.0);
+    double front = (timeS - frontS - 2.0 * index) / 30.0; // Reaches one node every 2 s, builds in 30 s
+    front = front < 0.0 ? 0.0 : (front > 1.0 ? 1.0 : front);
+    double speed = 7.0 + node.offset + 1.5 * sin(timeS / 400.0) +
+                   2.0 * sin(timeS / 3.5 + node.gustPhase) * sin(timeS / 25.0 + node.gustPhase) +
+                   (0.8 + 0.6 * front) * node.turbulence + 5.0 * front;
+    return speed > 0.0 ? static_cast<float>(speed) : 0.0f;
+}
+
+/**
+ * @brief Replay the delivered frames through fresh receivers for at least minSeconds
+ * @return Frames per second
+ */
+static double measureThroughput(const std::vector<RecordedFrame>& frames, const uint8_t mac[6], double minSeconds,
+                                uint32_t& checksum) {
+    static FleetReceiver receiver; // Large, kept off the stack
+    uint64_t count = 0;
+    checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < minSeconds) {
+        receiver.begin(mac);
+        for (const RecordedFrame& frame : frames) {
+            receiver.receive(frame.data, frame.length, frame.rxUs);
+        }
+        receiver.poll(frames.back().rxUs);
+        count += frames.size();
+        checksum += receiver.frames() + receiver.online(); // Keeps the work observable
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return count / elapsed;
+}
+
+int runTrafficSim(int argc, char** argv) {
+    uint32_t nodeCount = 30;
+    uint32_t seconds = 600;
+    double loss = 0.05;
+    double reorder = 0.01;
+    uint32_t heartbeatMs = 4000;
+    uint32_t outageS = 8;
+    uint32_t timeoutS = 5;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodeCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            loss = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+            reorder = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--heartbeat") == 0 && i + 1 < argc) {
+            heartbeatMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--outage") == 0 && i + 1 < argc) {
+            outageS = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeoutS = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else {
+            fprintf(stderr, "Usage: traffic [--nodes N] [--seconds N] [--loss RATE] [--reorder RATE] [--heartbeat MS] "
+                            "[--outage S] [--timeout S] [--seed N]\n");
+            return 1;
+        }
+    }
+    if (nodeCount < 2 || seconds < 60 || timeoutS == 0) {
+        fprintf(stderr, "At least 2 nodes, 60 s and a timeout\n");
+        return 1;
+    }
+
+    Random random(seed);
+    BroadcastPolicy::Config policy = BroadcastPolicy::DEFAULT_CONFIG;
+    policy.heartbeatMs = heartbeatMs;
+    std::vector<std::unique_ptr<TrafficNode>> nodes;
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        uint8_t mac[SimRadio::MAC_SIZE] = {0x24, 0x0A, 0xC4, 0x10, static_cast<uint8_t>(i >> 8),
+                                           static_cast<uint8_t>(i)};
+        nodes.emplace_back(new TrafficNode(mac, static_cast<uint64_t>(random.uniform() * 4294967296.0)));
+        TrafficNode& node = *nodes.back();
+        node.comm.setup();
+        node.comm.setPolicy(policy);
+        node.timeSync.begin(mac, i == 0 ? TimeSync::Role::Reference : TimeSync::Role::Follower);
+        node.comm.setTimeSync(node.timeSync);
+        node.phaseUs = static_cast<uint32_t>(random.uniform() * STEP_US);
+        node.offset = static_cast<float>(3.0 * random.uniform() - 1.5);
+        node.gustPhase = static_cast<float>(6.283 * random.uniform());
+    }
+    static const uint8_t RECEIVER_MAC[6] = {0x24, 0x0A, 0xC4, 0xFF, 0x00, 0x01};
+    const uint64_t timeoutUs = timeoutS * 1000000ULL;
+    std::unique_ptr<FleetReceiver> receiverState(new FleetReceiver(static_cast<uint32_t>(timeoutUs)));
+    FleetReceiver& receiver = *receiverState;
+    receiver.begin(RECEIVER_MAC);
+    const uint32_t receiverOriginUs = static_cast<uint32_t>(random.uniform() * 4294967296.0);
+
+    std::priority_queue<ChannelFrame, std::vector<ChannelFrame>, std::greater<ChannelFrame>> channel;
+    std::vector<RecordedFrame> recorded;
+    uint32_t order = 0;
+    uint64_t channelLost = 0;
+    uint64_t held = 0;
+    const uint64_t endUs = seconds * 1000000ULL;
+    const uint64_t outageStartUs = endUs / 3;
+    const uint64_t outageEndUs = outageStartUs + outageS * 1000000ULL;
+    const double frontS = seconds * 0.4;
+    uint64_t outageLastUs = 0;      // Last delivery from the outage node before the outage
+    uint64_t outageDetectedUs = 0;  // Poll that found it silent
+    uint32_t outageTimeouts = 0;    // Timeouts of the outage node before it
+    int outageIndex = -1;           // Its index in the receiver
+
+    for (uint64_t stepUs = 0; stepUs < endUs; stepUs += STEP_US) {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            TrafficNode& node = *nodes[i];
+            uint64_t timeUs = stepUs + node.phaseUs;
+            node.clock.advanceUs(node.originUs + timeUs - node.clock.nowUs());
+            node.radio.advance(node.clock.micros());
+            float speed = windAt(node, random, timeUs / 1e6, frontS, i);
+            node.statistics.addSample(speed, node.clock.millis());
+            bool silent = i == OUTAGE_NODE && timeUs >= outageStartUs && timeUs < outageEndUs;
+            if (!silent) {
+                WindStats stats = node.statistics.get();
+                AnemometerData data = {};
+                node.radio.macAddress(data.macAddress);
+                data.windSpeed = speed;
+                data.fields = WireFormat::FIELD_STATS | WireFormat::FIELD_TIME;
+                data.windGust = stats.gust;
+                data.windLull = stats.lull;
+                data.windMean = stats.mean;
+                data.timestampUs = node.clock.micros() - 1000 - static_cast<uint32_t>(random.uniform() * 2000.0);
+                node.comm.offer(data, node.clock.millis());
+            }
+
+            // Put the frames the radio took on the channel, oldest first
+            uint32_t fresh = node.radio.delivered() - node.seenFrames;
+            node.seenFrames = node.radio.delivered();
+            for (size_t age = fresh; age-- > 0;) {
+                const SimRadio::Frame* frame = node.radio.frame(age);
+                if (!frame) {
+                    continue;
+                }
+                ChannelFrame sent;
+                sent.deliverUs = timeUs + AIRTIME_US;
+                sent.order = order++;
+                sent.node = static_cast<int>(i);
+                sent.index = 0;
+                sent.length = static_cast<uint8_t>(frame->length);
+                memcpy(sent.data, frame->data, frame->length);
+                if (WireFormat::frameType(frame->data, frame->length) == WireFormat::MSG_TIME) {
+                    // The other anemometers hear the beacon at the end of its air time
+                    for (size_t j = 0; j < nodes.size(); j++) {
+                        if (j != i && random.uniform() >= loss) {
+                            uint32_t rxUs = static_cast<uint32_t>(nodes[j]->originUs + sent.deliverUs);
+                            nodes[j]->radio.receive(RECEIVER_MAC, frame->data, frame->length, rxUs);
+                        }
+                    }
+                    sent.node = -1;
+                } else {
+                    sent.index = node.sent++;
+                    node.delivered.push_back(false);
+                }
+                if (random.uniform() < loss) {
+                    channelLost += sent.node >= 0 ? 1 : 0;
+                    continue;
+                }
+                if (random.uniform() < reorder) {
+                    sent.deliverUs += static_cast<uint64_t>(HOLD_MIN_US + random.uniform() * (HOLD_MAX_US - HOLD_MIN_US));
+                    held++;
+                }
+                channel.push(sent);
+            }
+        }
+
+        // Receiver: frames due by the end of the period, then the timeout check
+        uint64_t stepEndUs = stepUs + STEP_US;
+        while (!channel.empty() && channel.top().deliverUs <= stepEndUs) {
+            const ChannelFrame& frame = channel.top();
+            uint32_t rxUs = receiverOriginUs + static_cast<uint32_t>(frame.deliverUs);
+            receiver.receive(frame.data, frame.length, rxUs);
+            RecordedFrame copy;
+            copy.rxUs = rxUs;
+            copy.length = frame.length;
+            memcpy(copy.data, frame.data, frame.length);
+            recorded.push_back(copy);
+            if (frame.node >= 0) {
+                TrafficNode& node = *nodes[frame.node];
+                if (frame.index < node.maxDelivered) {
+                    node.reordered++;
+                } else {
+                    node.maxDelivered = frame.index + 1;
+                }
+                node.duplicates += node.delivered[frame.index] ? 1 : 0;
+                node.delivered[frame.index] = true;
+                uint64_t gapUs = frame.deliverUs - node.lastDeliveryUs;
+                if (node.lastDeliveryUs && gapUs >= timeoutUs) {
+                    node.longSilences++;
+                    node.certainSilences += gapUs >= timeoutUs + STEP_US ? 1 : 0;
+                }
+                node.lastDeliveryUs = frame.deliverUs;
+            }
+            channel.pop();
+        }
+        receiver.poll(receiverOriginUs + static_cast<uint32_t>(stepEndUs));
+        if (outageIndex < 0) {
+            uint8_t mac[SimRadio::MAC_SIZE];
+            nodes[OUTAGE_NODE]->radio.macAddress(mac);
+            outageIndex = receiver.indexOf(mac);
+        }
+        if (outageIndex >= 0 && !outageDetectedUs && stepEndUs > outageStartUs &&
+            receiver.sender(outageIndex).timeouts > outageTimeouts) {
+            outageDetectedUs = stepEndUs;
+            outageLastUs = nodes[OUTAGE_NODE]->lastDeliveryUs;
+        }
+        if (outageIndex >= 0 && stepEndUs <= outageStartUs) {
+            outageTimeouts = receiver.sender(outageIndex).timeouts; // Before the outage
+        }
+    }
+
+    // Silence at the end of the run, as the last polls saw it
+    for (std::unique_ptr<TrafficNode>& node : nodes) {
+        uint64_t gapUs = endUs - node->lastDeliveryUs;
+        node->longSilences += gapUs >= timeoutUs ? 1 : 0;
+        node->certainSilences += gapUs >= timeoutUs + STEP_US ? 1 : 0;
+    }
+
+    printf("%lu anemometers, %lu s, %.0f%% loss, %.1f%% reordered, heartbeat %lu ms, %lu s outage of node %lu, "
+           "timeout %lu s\n",
+           static_cast<unsigned long>(nodeCount), static_cast<unsigned long>(seconds), 100.0 * loss, 100.0 * reorder,
+           static_cast<unsigned long>(heartbeatMs), static_cast<unsigned long>(outageS),
+           static_cast<unsigned long>(OUTAGE_NODE), static_cast<unsigned long>(timeoutS));
+    printf("node  sent  received  lost (true)  reordered (true)  dup  timeouts (expected)  max gap  age avg  age max\n");
+    bool ok = receiver.malformed() == 0;
+    uint64_t sentTotal = 0;
+    uint64_t lostTotal = 0;
+    uint64_t reorderedTotal = 0;
+    double ageSumUs = 0.0;
+    uint64_t ages = 0;
+    uint32_t maxAgeUs = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        TrafficNode& node = *nodes[i];
+        uint8_t mac[SimRadio::MAC_SIZE];
+        node.radio.macAddress(mac);
+        int index = receiver.indexOf(mac);
+        // Losses are only visible between the first and the last frame delivered
+        uint32_t first = 0;
+        while (first < node.maxDelivered && !node.delivered[first]) {
+            first++;
+        }
+        uint32_t distinct = 0;
+        for (uint32_t n = first; n < node.maxDelivered; n++) {
+            distinct += node.delivered[n] ? 1 : 0;
+        }
+        uint32_t trueLost = node.maxDelivered - first - distinct;
+        sentTotal += node.sent;
+        if (index < 0) {
+            ok = ok && (node.maxDelivered == 0 || nodes.size() > FleetReceiver::MAX_SENDERS);
+            printf("%4lu  %4lu  untracked\n", static_cast<unsigned long>(i), static_cast<unsigned long>(node.sent));
+            continue;
+        }
+        const SenderState& sender = receiver.sender(index);
+        bool match = sender.received == distinct && sender.lost == trueLost && sender.reordered == node.reordered &&
+                     sender.duplicates == node.duplicates && sender.restarts == 0 &&
+                     sender.timeouts >= node.certainSilences && sender.timeouts <= node.longSilences;
+        ok = ok && match;
+        lostTotal += sender.lost;
+        reorderedTotal += sender.reordered;
+        ageSumUs += static_cast<double>(sender.ageSumUs);
+        ages += sender.ages;
+        maxAgeUs = sender.maxAgeUs > maxAgeUs ? sender.maxAgeUs : maxAgeUs;
+        printf("%4lu  %4lu  %8lu  %4lu (%4lu)  %9lu (%4lu)  %3lu  %8lu (%lu..%lu)  %5.1f s  %5.1f ms  %5.0f ms%s\n",
+               static_cast<unsigned long>(i), static_cast<unsigned long>(node.sent),
+               static_cast<unsigned long>(sender.received), static_cast<unsigned long>(sender.lost),
+               static_cast<unsigned long>(trueLost), static_cast<unsigned long>(sender.reordered),
+               static_cast<unsigned long>(node.reordered), static_cast<unsigned long>(sender.duplicates),
+               static_cast<unsigned long>(sender.timeouts), static_cast<unsigned long>(node.certainSilences),
+               static_cast<unsigned long>(node.longSilences), sender.maxGapUs / 1e6,
+               sender.ages ? sender.ageSumUs / 1e3 / sender.ages : 0.0, sender.maxAgeUs / 1e3,
+               match ? "" : "  MISMATCH");
+    }
+
+    double detectionS = (outageDetectedUs - outageLastUs) / 1e6;
+    bool checkOutage = outageS * 1000000ULL >= timeoutUs;
+    bool detected = !checkOutage || (outageDetectedUs && outageDetectedUs - outageLastUs >= timeoutUs &&
+                                     outageDetectedUs - outageLastUs <= timeoutUs + STEP_US);
+    ok = ok && detected;
+    printf("Receiver: %lu frames from %lu senders (%lu sent, %lu lost on the channel, %lu held back), %lu beacons, "
+           "%lu malformed, %lu untracked\n",
+           static_cast<unsigned long>(receiver.frames()), static_cast<unsigned long>(receiver.senderCount()),
+           static_cast<unsigned long>(sentTotal), static_cast<unsigned long>(channelLost),
+           static_cast<unsigned long>(held), static_cast<unsigned long>(receiver.beacons()),
+           static_cast<unsigned long>(receiver.malformed()), static_cast<unsigned long>(receiver.untracked()));
+    printf("Receiver: %lu lost, %lu reordered, %lu timeouts, time %s, measurement age %.1f ms avg, %.0f ms max\n",
+           static_cast<unsigned long>(lostTotal), static_cast<unsigned long>(reorderedTotal),
+           static_cast<unsigned long>(receiver.timeouts()),
+           receiver.timeSync().synced(receiverOriginUs + static_cast<uint32_t>(endUs)) ? "synced" : "not synced",
+           ages ? ageSumUs / 1e3 / ages : 0.0, maxAgeUs / 1e3);
+    if (outageS && !checkOutage) {
+        printf("Outage of node %lu: shorter than the timeout, not checked\n", static_cast<unsigned long>(OUTAGE_NODE));
+    } else if (outageS) {
+        printf("Outage of node %lu: %s %.2f s after its last frame\n", static_cast<unsigned long>(OUTAGE_NODE),
+               outageDetectedUs ? "detected" : "NOT detected", outageDetectedUs ? detectionS : 0.0);
+    }
+
+    uint32_t checksum = 0;
+    double fps = measureThroughput(recorded, RECEIVER_MAC, 0.5, checksum);
+    double offered = static_cast<double>(recorded.size()) / seconds;
+    printf("Throughput: %.2f M frames/s (%.0f ns/frame), offered %.0f frames/s: %.0fx headroom, "
+           "%.0f anemometers at 4 frames/s per core\n",
+           fps / 1e6, 1e9 / fps, offered, fps / offered, fps / 4.0);
+    if (checksum == 0) {
+        ok = false;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
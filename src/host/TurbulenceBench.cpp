@@ -0,0 +1,200 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file TurbulenceBench.cpp
+ * @brief Turbulence analyzer against a NumPy reference, and its cost per FFT block
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The reference table comes from tools/turbulence_reference.py, which builds the
+ * same synthetic wind and analyses it with numpy.fft.rfft; the analyzer must match
+ * it within float rounding. The same window then goes through the streaming path
+ * (addSample() at the filter output rate, service()) to check the hand-off and the
+ * hop. The cost is given per analysis (statistics, detrend, window, FFT, split and
+ * peak) in ns and, on x86, TSC cycles, with the share of one core it takes at the
+ * analysis rate.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "HostCommands.h"
+#include "SystemClock.h"
+#include "TurbulenceAnalyzer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+static volatile float sink;
+
+namespace {
+
+struct ReferenceBin {
+    size_t bin;
+    float power; // (m/s)^2/Hz
+};
+
+} // namespace
+
+// Generated by tools/turbulence_reference.py (NumPy 2.4.6)
+static const float REFERENCE_MEAN = 8.588486f;
+static const float REFERENCE_STDDEV = 1.255706f;
+static const float REFERENCE_INTENSITY = 0.1462081f;
+static const float REFERENCE_GUST_HZ = 0.09843879f;
+static const ReferenceBin REFERENCE_BINS[] = {
+    {0, 0.2212877f},
+    {1, 0.07645483f},
+    {2, 0.00290475f},
+    {5, 2.222291f},
+    {6, 38.30114f},
+    {7, 29.28608f},
+    {8, 0.6020655f},
+    {20, 0.009527219f},
+    {22, 11.51804f},
+    {23, 8.849074f},
+    {24, 0.2078514f},
+    {40, 0.01793832f},
+    {100, 0.01031274f},
+    {256, 0.0009074558f},
+};
+
+/**
+ * @brief Synthetic wind of tools/turbulence_reference.py: 8 m/s, slow rise, 0.10 and 0.35 Hz gusts, noise
+ */
+static void referenceSignal(float* samples, size_t count, float sampleRate) {
+    const double twoPi = 6.283185307179586;
+    uint32_t state = 0x2545F491;
+    for (size_t n = 0; n < count; n++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        double noise = state / 4294967296.0 - 0.5;
+        double t = n / sampleRate;
+        samples[n] = static_cast<float>(8.0 + 0.002 * n + 1.5 * sin(twoPi * 0.10 * t) +
+                                        0.8 * sin(twoPi * 0.35 * t + 1.0) + 0.6 * noise);
+    }
+}
+
+/**
+ * @brief Compare with a relative tolerance, and an absolute floor for the near-empty bins
+ */
+static bool close(float value, float expected, float floor) {
+    return fabsf(value - expected) <= 1e-3f * fabsf(expected) + floor;
+}
+
+static bool checkResult(const char* path, const TurbulenceAnalyzer& analyzer, const TurbulenceResult& result) {
+    const float* power = analyzer.spectrum();
+    float floor = 1e-5f * REFERENCE_BINS[4].power; // 1e-5 of the gust peak
+    bool ok = true;
+    size_t mismatches = 0;
+    for (const ReferenceBin& reference : REFERENCE_BINS) {
+        if (!close(power[reference.bin], reference.power, floor)) {
+            printf("    bin %3zu: %.7g, expected %.7g\n", reference.bin, power[reference.bin], reference.power);
+            mismatches++;
+        }
+    }
+    ok = mismatches == 0 && close(result.mean, REFERENCE_MEAN, 0) && close(result.stddev, REFERENCE_STDDEV, 0) &&
+         close(result.intensity, REFERENCE_INTENSITY, 0) && close(result.gustFrequency, REFERENCE_GUST_HZ, 0);
+    printf("  %-9s mean %.4f m/s, intensity %.2f %%, gust %.4f Hz (%.1f s), %zu bins  %s\n", path, result.mean,
+           result.intensity * 100.0f, result.gustFrequency, result.gustPeriod,
+           sizeof(REFERENCE_BINS) / sizeof(REFERENCE_BINS[0]), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+int runTurbulenceBench(int argc, char** argv) {
+    uint32_t blocks = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 20000;
+    if (blocks == 0) {
+        fprintf(stderr, "Usage: turbulence [blocks]\n");
+        return 1;
+    }
+    const size_t size = TurbulenceAnalyzer::FFT_SIZE;
+    const float rate = TurbulenceAnalyzer::ANALYSIS_RATE_HZ;
+    static float samples[TurbulenceAnalyzer::FFT_SIZE];
+    referenceSignal(samples, size, rate);
+    SystemClock clock;
+
+    printf("NumPy reference (%zu samples at %.0f Hz, %.4f Hz per bin):\n", size, rate, rate / size);
+    static TurbulenceAnalyzer direct(clock, rate);
+    TurbulenceResult result;
+    direct.analyzeBlock(samples, result);
+    bool ok = checkResult("block", direct, result);
+
+    // Streaming: 27 filter outputs per analysed sample, each repeated so the averages are exact
+    const uint32_t averaging = 27;
+    static TurbulenceAnalyzer streaming(clock, rate * averaging);
+    uint32_t results = 0;
+    for (size_t n = 0; n < size; n++) {
+        for (uint32_t k = 0; k < averaging; k++) {
+            streaming.addSample(samples[n]);
+        }
+        streaming.service(0);
+        while (streaming.takeResult(result)) {
+            results++;
+        }
+    }
+    bool streamed = results == 1 && streaming.analyses() == 1 && streaming.overruns() == 0;
+    if (!streamed) {
+        printf("  stream    %u results, %u analyses, %u overruns  MISMATCH\n", results, streaming.analyses(),
+               streaming.overruns());
+    } else {
+        ok = checkResult("stream", streaming, result) && ok;
+    }
+    ok = ok && streamed;
+
+    // Next analysis after one hop, not before
+    bool early = false;
+    for (size_t n = 0; n < TurbulenceAnalyzer::HOP * averaging - 1; n++) {
+        streaming.addSample(samples[n % size]);
+        streaming.service(0);
+        early = streaming.takeResult(result) || early;
+    }
+    streaming.addSample(samples[0]);
+    streaming.service(0);
+    bool hop = !early && streaming.takeResult(result) && streaming.analyses() == 2;
+    printf("  hop       new analysis every %zu samples (%.0f s)  %s\n", TurbulenceAnalyzer::HOP,
+           TurbulenceAnalyzer::HOP / rate, hop ? "ok" : "MISMATCH");
+    ok = ok && hop;
+
+    auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+    uint64_t startTsc = __rdtsc();
+#endif
+    float accumulator = 0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        direct.analyzeBlock(samples, result);
+        accumulator += result.gustFrequency;
+    }
+#ifdef HAVE_TSC
+    uint64_t tsc = __rdtsc() - startTsc;
+#endif
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = accumulator;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / blocks;
+    double hopSeconds = TurbulenceAnalyzer::HOP / rate;
+
+    printf("\n%-28s %12s %12s %12s\n", "analysis", "us/block", "cycles", "CPU share");
+    printf("%-28s %12.2f", "512-point real FFT + stats", ns / 1000.0);
+#ifdef HAVE_TSC
+    printf(" %12.0f", static_cast<double>(tsc) / blocks);
+#else
+    printf(" %12s", "-");
+#endif
+    printf(" %11.5f%%\n", ns / (hopSeconds * 1e9) * 100.0);
+    return ok ? 0 : 1;
+}
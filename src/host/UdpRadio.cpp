@@ -0,0 +1,144 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file UdpRadio.cpp
+ * @brief Radio over UDP on the loopback interface (host builds)
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ */
+
+#include "UdpRadio.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * @brief Construct a new UdpRadio object
+ */
+UdpRadio::UdpRadio(Clock& clock, uint16_t localPort, uint16_t peerPort, const uint8_t mac[MAC_SIZE])
+    : clock_(clock), localPort_(localPort), peerPort_(peerPort), mac_(), socket_(-1), handler_(nullptr),
+      context_(nullptr), receiver_("udp_radio", 4096, 1), running_(false) {
+    memcpy(mac_, mac, MAC_SIZE);
+}
+
+UdpRadio::~UdpRadio() {
+    stop();
+}
+
+/**
+ * @brief Bind the local port and start the receive thread
+ */
+bool UdpRadio::begin() {
+    if (socket_ >= 0) {
+        return true;
+    }
+    socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ < 0) {
+        return false;
+    }
+    // Wake up regularly, so stop() does not wait for a datagram
+    timeval timeout = {0, 100000};
+    setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(localPort_);
+    if (bind(socket_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        close(socket_);
+        socket_ = -1;
+        return false;
+    }
+    running_.store(true);
+    if (!receiver_.start(receiveTask, this)) {
+        running_.store(false);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Send one datagram: sender MAC address, then the frame
+ */
+RadioTransport::SendStatus UdpRadio::send(const uint8_t destination[MAC_SIZE], const uint8_t* data, size_t length) {
+    (void)destination; // One peer: every frame is a broadcast
+    if (socket_ < 0 || length > MAX_FRAME) {
+        return SendStatus::Failed;
+    }
+    uint8_t datagram[MAC_SIZE + MAX_FRAME];
+    memcpy(datagram, mac_, MAC_SIZE);
+    memcpy(datagram + MAC_SIZE, data, length);
+    sockaddr_in peer = {};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    peer.sin_port = htons(peerPort_);
+    ssize_t sent = sendto(socket_, datagram, MAC_SIZE + length, 0, reinterpret_cast<sockaddr*>(&peer), sizeof(peer));
+    // Nobody listening on the peer port is not an error: radio frames get lost too
+    return sent >= 0 || errno == ECONNREFUSED ? SendStatus::Queued : SendStatus::Failed;
+}
+
+void UdpRadio::macAddress(uint8_t mac[MAC_SIZE]) {
+    memcpy(mac, mac_, MAC_SIZE);
+}
+
+bool UdpRadio::setReceiveHandler(ReceiveHandler handler, void* context) {
+    context_.store(context);
+    handler_.store(handler);
+    return true;
+}
+
+bool UdpRadio::setSendHandler(SendHandler handler, void* context) {
+    (void)handler;
+    (void)context;
+    return false;
+}
+
+/**
+ * @brief Receive thread: hand each datagram to the receive handler
+ */
+void UdpRadio::receiveTask(void* arg) {
+    UdpRadio* self = static_cast<UdpRadio*>(arg);
+    uint8_t datagram[MAC_SIZE + MAX_FRAME];
+    while (self->running_.load()) {
+        ssize_t length = recv(self->socket_, datagram, sizeof(datagram), 0);
+        if (length <= static_cast<ssize_t>(MAC_SIZE)) {
+            continue; // Time-out, or not a frame
+        }
+        ReceiveHandler handler = self->handler_.load();
+        if (handler) {
+            handler(self->context_.load(), datagram, datagram + MAC_SIZE, static_cast<size_t>(length) - MAC_SIZE,
+                    self->clock_.micros());
+        }
+    }
+}
+
+/**
+ * @brief Stop the receive thread and close the socket
+ */
+void UdpRadio::stop() {
+    if (socket_ < 0) {
+        return;
+    }
+    if (running_.load()) {
+        running_.store(false);
+        receiver_.join();
+    }
+    close(socket_);
+    socket_ = -1;
+}
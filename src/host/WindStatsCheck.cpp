@@ -0,0 +1,284 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file WindStatsCheck.cpp
+ * @brief Rolling wind statistics against a brute-force recomputation
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * Random traces go through WindStatistics: segments at 1 kHz, at the 4 Hz
+ * measurement rate and slower than one sample per tick (single-shot fallback, so
+ * ticks without samples), with jittered and repeated time stamps, short gaps,
+ * gaps longer than the 10 min window (history dropped) and a millis() wrap-around.
+ * Every sample is kept, and at check points the statistics are recomputed from
+ * the samples alone: tick aggregates, 3 s means, then a plain scan of the last
+ * 10 min for the gust, lull, mean, min and max. Sums are double in the reference,
+ * float per tick in the engine, hence the small tolerance on the averages; the
+ * extremes of single samples must match exactly.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "HostCommands.h"
+#include "HostRandom.h"
+#include "WindStatistics.h"
+
+static const float MEAN_TOLERANCE = 2e-3f;       // m/s, per-tick float sums of up to 250 samples
+static const uint32_t CHECK_EVERY = 4000;        // Samples between two check points
+static const uint32_t TRACE_MINUTES = 60;        // Simulated time per trace
+
+namespace {
+
+struct Sample {
+    uint32_t offsetMs;   // Time since the first sample of the history
+    float speed;
+};
+
+/**
+ * @brief Every sample since the history was last dropped, and the naive statistics
+ */
+class Reference {
+private:
+    std::vector<Sample> samples_;
+    uint32_t startMs_;   // Time stamp of the first sample
+
+    static uint32_t tickOf(const Sample& sample) {
+        return sample.offsetMs / WindStatistics::TICK_MS;
+    }
+
+public:
+    Reference() : startMs_(0) {}
+
+    /**
+     * @brief Add a sample; a gap of a whole window after the open tick starts over
+     * @return true if the history was dropped
+     */
+    bool add(float speed, uint32_t timestampMs) {
+        bool dropped = false;
+        if (!samples_.empty()) {
+            uint32_t openTickMs = tickOf(samples_.back()) * WindStatistics::TICK_MS;
+            if (timestampMs - startMs_ - openTickMs >= WindStatistics::WINDOW_MS) {
+                samples_.clear();
+                dropped = true;
+            }
+        }
+        if (samples_.empty()) {
+            startMs_ = timestampMs;
+        }
+        samples_.push_back({timestampMs - startMs_, speed});
+        return dropped;
+    }
+
+    /**
+     * @brief Statistics recomputed from the samples of the ticks that matter
+     */
+    WindStats compute() const {
+        WindStats stats = {};
+        if (samples_.empty()) {
+            return stats;
+        }
+        const uint32_t closed = tickOf(samples_.back());
+        if (closed == 0) {
+            return stats;
+        }
+        const uint32_t first = closed > WindStatistics::WINDOW_TICKS ? closed - WindStatistics::WINDOW_TICKS : 0;
+        const uint32_t from = first >= WindStatistics::GUST_TICKS - 1 ? first - (WindStatistics::GUST_TICKS - 1) : 0;
+
+        // First sample of tick `from`, and the mean of the last tick with samples before it
+        size_t index = std::lower_bound(samples_.begin(), samples_.end(), from * WindStatistics::TICK_MS,
+                                        [](const Sample& s, uint32_t ms) { return s.offsetMs < ms; }) -
+                       samples_.begin();
+        double hold = 0.0;
+        if (index > 0) {
+            uint32_t tick = tickOf(samples_[index - 1]);
+            double sum = 0.0;
+            size_t count = 0;
+            for (size_t i = index; i > 0 && tickOf(samples_[i - 1]) == tick; i--) {
+                sum += samples_[i - 1].speed;
+                count++;
+            }
+            hold = sum / count;
+        }
+
+        std::vector<double> means;
+        std::vector<float> mins;
+        std::vector<float> maxs;
+        for (uint32_t tick = from; tick < closed; tick++) {
+            double sum = 0.0;
+            size_t count = 0;
+            float lo = 0.0f;
+            float hi = 0.0f;
+            for (; index < samples_.size() && tickOf(samples_[index]) == tick; index++) {
+                float v = samples_[index].speed;
+                lo = count == 0 || v < lo ? v : lo;
+                hi = count == 0 || v > hi ? v : hi;
+                sum += v;
+                count++;
+            }
+            if (count > 0) {
+                hold = sum / count;
+            } else {
+                lo = hi = static_cast<float>(hold);
+            }
+            means.push_back(hold);
+            mins.push_back(lo);
+            maxs.push_back(hi);
+        }
+
+        double windowSum = 0.0;
+        for (uint32_t tick = first; tick < closed; tick++) {
+            size_t i = tick - from;
+            uint32_t span = tick + 1 < WindStatistics::GUST_TICKS ? tick + 1 : WindStatistics::GUST_TICKS;
+            double gustSum = 0.0;
+            for (uint32_t k = 0; k < span; k++) {
+                gustSum += means[i - k];
+            }
+            float gustMean = static_cast<float>(gustSum / span);
+            bool firstTick = tick == first;
+            stats.gust = firstTick || gustMean > stats.gust ? gustMean : stats.gust;
+            stats.lull = firstTick || gustMean < stats.lull ? gustMean : stats.lull;
+            stats.min = firstTick || mins[i] < stats.min ? mins[i] : stats.min;
+            stats.max = firstTick || maxs[i] > stats.max ? maxs[i] : stats.max;
+            stats.current = gustMean;
+            windowSum += means[i];
+        }
+        stats.ticks = closed - first;
+        stats.mean = static_cast<float>(windowSum / stats.ticks);
+        return stats;
+    }
+
+    size_t size() const {
+        return samples_.size();
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Compare the engine with the reference, print the first difference
+ */
+static bool matches(const WindStats& got, const WindStats& want, uint32_t sample, uint32_t& mismatches) {
+    bool ok = got.ticks == want.ticks && fabsf(got.current - want.current) <= MEAN_TOLERANCE &&
+              fabsf(got.gust - want.gust) <= MEAN_TOLERANCE && fabsf(got.lull - want.lull) <= MEAN_TOLERANCE &&
+              fabsf(got.mean - want.mean) <= MEAN_TOLERANCE && got.min == want.min && got.max == want.max;
+    if (!ok && mismatches++ == 0) {
+        printf("  sample %lu: got gust %.4f lull %.4f mean %.4f min %.3f max %.3f current %.4f ticks %lu\n",
+               static_cast<unsigned long>(sample), got.gust, got.lull, got.mean, got.min, got.max, got.current,
+               static_cast<unsigned long>(got.ticks));
+        printf("  %*s want gust %.4f lull %.4f mean %.4f min %.3f max %.3f current %.4f ticks %lu\n", 8 + 1, "",
+               want.gust, want.lull, want.mean, want.min, want.max, want.current,
+               static_cast<unsigned long>(want.ticks));
+    }
+    return ok;
+}
+
+/**
+ * @brief One random trace through the engine and the reference
+ */
+static bool checkTrace(uint32_t seed, uint32_t minutes) {
+    Random random(seed);
+    static WindStatistics statistics; // About 40 KB of rings
+    statistics.reset();
+    Reference reference;
+
+    // Start shortly before millis() wraps around
+    uint32_t nowMs = 0xFFFFFFFFu - random.below(30 * 60000);
+    const uint32_t endMs = nowMs + minutes * 60000;
+    float speed = 5.0f;
+    uint32_t samples = 0;
+    uint32_t checks = 0;
+    uint32_t mismatches = 0;
+    uint32_t gaps = 0;
+    uint32_t drops = 0;
+    float worst = 0.0f;
+    while (static_cast<int32_t>(endMs - nowMs) > 0) {
+        // Segment: a rate, a duration, then maybe a gap
+        uint32_t kind = random.below(3);
+        uint32_t intervalMs = kind == 0 ? 1 : kind == 1 ? 250 : 400 + random.below(2600);
+        uint32_t jitterMs = kind == 0 ? 2 : intervalMs / 4;
+        uint32_t segmentEndMs = nowMs + 5000 + random.below(5 * 60000);
+        while (static_cast<int32_t>(segmentEndMs - nowMs) > 0) {
+            speed += static_cast<float>(random.uniform() - 0.5) * 0.4f;
+            speed = speed < 0.0f ? 0.0f : speed > 25.0f ? 25.0f : speed;
+            float sample = speed;
+            if (random.below(500) == 0) {
+                sample += 8.0f * static_cast<float>(random.uniform()); // Gust spike
+            }
+            // Quantised like the converter output, so sums stay comparable
+            sample = roundf(sample * 1024.0f) / 1024.0f;
+            statistics.addSample(sample, nowMs);
+            if (reference.add(sample, nowMs)) {
+                drops++;
+            }
+            samples++;
+            if (samples % CHECK_EVERY == 0 || random.below(CHECK_EVERY) == 0) {
+                WindStats got = statistics.get();
+                WindStats want = reference.compute();
+                checks++;
+                matches(got, want, samples, mismatches);
+                float deviation = fabsf(got.mean - want.mean);
+                if (deviation > worst) {
+                    worst = deviation;
+                }
+            }
+            // Jittered interval, sometimes twice the same time stamp
+            nowMs += intervalMs - jitterMs / 2 + random.below(jitterMs + 1);
+        }
+        uint32_t gap = random.below(20);
+        if (gap < 3) {
+            nowMs += 1000 + random.below(60000);
+            gaps++;
+        } else if (gap == 3) {
+            nowMs += WindStatistics::WINDOW_MS + random.below(WindStatistics::WINDOW_MS);
+            gaps++;
+        }
+        // Check right after each segment too, where the rate changes
+        checks++;
+        matches(statistics.get(), reference.compute(), samples, mismatches);
+    }
+    printf("Trace %lu: %lu samples, %lu gaps (%lu over the window), %lu check points, worst mean error %.1e m/s, "
+           "%lu mismatches %s\n",
+           static_cast<unsigned long>(seed), static_cast<unsigned long>(samples), static_cast<unsigned long>(gaps),
+           static_cast<unsigned long>(drops), static_cast<unsigned long>(checks), worst,
+           static_cast<unsigned long>(mismatches), mismatches == 0 ? "OK" : "FAILED");
+    return mismatches == 0;
+}
+
+int runWindStatsCheck(int argc, char** argv) {
+    uint32_t traces = 4;
+    uint32_t seed = 1;
+    uint32_t minutes = TRACE_MINUTES;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--traces") == 0 && i + 1 < argc) {
+            traces = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    bool ok = true;
+    for (uint32_t t = 0; t < traces; t++) {
+        ok = checkTrace(seed + t, minutes) && ok;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
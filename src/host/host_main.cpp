@@ -0,0 +1,97 @@
+// Copyright (C) 2025 Philippe Hubert
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file host_main.cpp
+ * @brief Entry point of the native (Linux) build
+ * @author Philippe Hubert
+ * @date 2025
+ * @copyright GNU General Public License v3.0
+ *
+ * The firmware modules are built against simulated backends (SystemClock,
+ * VirtualClock, HostConsole, SimDisplay, SimRadio, SimPowerControl,
+ * FakeAdcSource) and driven by subcommands:
+ *
+ *   pio run -e native && .pio/build/native/program bench
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "HostCommands.h"
+
+static const HostCommand COMMANDS[] = {
+    {"bench", "time conversion, statistics, encoding and logging [iterations]", runBenchmarks},
+    {"boot", "time to first frame with a late or missing sensor, calibration cache [--late S] [--seconds N]",
+     runBootSim},
+    {"broadcast", "adaptive broadcast against the fixed schedule [trace.csv] [--deadband M/S] [--loss RATE]",
+     runBroadcastSim},
+    {"calibration", "code to wind speed table against the float conversion, every code, three calibrations",
+     runCalibrationCheck},
+    {"control", "control channel: SipHash, replay, atomic settings changes, persistence", runControlCheck},
+    {"ctl", "send a signed command to a node: get, set, stats, reset [--rate SPS] [--heartbeat MS] ... [--target MAC]",
+     runControlTool},
+    {"display", "renderer bytes and time per frame [image.ppm] [--frames N]", runDisplayBench},
+    {"filter", "ADC filter golden vectors, noise and cost per sample [blocks]", runFilterBench},
+    {"fleet", "delivery ratio of 2 to 50 nodes, free-running and slotted [--nodes N] [--boats N] [--slots]",
+     runFleetSim},
+    {"heap", "heap allocations of the steady-state measurement loop, must be none [--hours H]", runHeapCheck},
+    {"mux", "interleaved ADC inputs, rates, time stamps, vane mean direction [--seconds N] [--wind SPS] [--vane SPS]",
+     runMuxSim},
+    {"node", "real-time node on UDP loopback, tuned with ctl [--key HEX] [--port P] [--peer P] [--seconds N]", runNode},
+    {"pipeline", "SPSC ring and pipeline stages on threads: order, drops, high-water [--values N] [--seconds N]",
+     runPipelineCheck},
+    {"power", "light-sleep duty cycle, wake-up accuracy and charge [--seconds N] [--wake US] [--no-alert]",
+     runPowerSim},
+    {"radio", "send completions, back-pressure and latency [--depth N] [--burst N] [--airtime US] [--loss RATE]",
+     runRadioBench},
+    {"record", "recording throughput and read-back check [dir] [--seconds N] [--durable]", runRecordBench},
+    {"replay", "traces through the measurement chain, samples/s, digest check [trace ...] [--hours H] [--check F]",
+     runReplayBench},
+    {"session", "session statistics against offline results, reboot, summary frame [--samples N] [--seed S]",
+     runSessionCheck},
+    {"stream", "binary raw sample stream on stdout, code count and sum on stderr [--seconds N] [--rate SPS] [--realtime]",
+     runStreamBench},
+    {"timesync", "drifting clocks synchronised to a reference, convergence and error [--nodes N] [--drift PPM] [--jump]",
+     runTimeSyncSim},
+    {"traffic", "fleet frames on a lossy channel, receiver loss/reorder/timeout check, frames/s [--nodes N] [--loss RATE]",
+     runTrafficSim},
+    {"turbulence", "turbulence spectrum against the NumPy reference, cost per FFT block [blocks]",
+     runTurbulenceBench},
+    {"windstats", "rolling wind statistics against a brute-force recomputation [--traces N] [--minutes M] [--seed S]",
+     runWindStatsCheck},
+};
+
+static const size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void usage(const char* program) {
+    printf("Usage: %s <command> [options]\n\nCommands:\n", program);
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        printf("  %-12s %s\n", COMMANDS[i].name, COMMANDS[i].help);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(argv[1], COMMANDS[i].name) == 0) {
+            return COMMANDS[i].run(argc - 1, argv + 1);
+        }
+    }
+    fprintf(stderr, "Unknown command: %s\n", argv[1]);
+    usage(argv[0]);
+    return 1;
+}
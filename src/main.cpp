@@ -26,17 +26,41 @@
  * Key Features:
  * - Real-time wind speed measurement using Anemometer class
  * - Visual display of wind speed on M5Stack Atom S3 screen
- * - Configurable logging to Serial, SD card, and/or screen
+ * - Configurable text logging to Serial and/or screen; raw samples can be recorded
+ *   to SD through SampleRecorder
  * - Wireless data broadcasting with unique device identification
- * - 2-second update interval for measurements
+ * - 250 ms measurement period; frames are broadcast when the wind changes
+ *   (deadband, capped rate) with a slow heartbeat when it is steady
+ * - TDMA transmit slots, so a fleet of anemometers on one channel does not collide
+ * - Measurement times synchronised to a reference anemometer's time beacons
+ * - Turbulence intensity and dominant gust period from an FFT of the recent wind speed
+ * - Optional low-power mode: deadlines instead of tasks, light sleep in between
+ * - Fast boot: radio first, no wait for the USB host or the sensor (retried in the
+ *   background, frames flagged meanwhile), factory calibration cached in RTC memory
+ *   and flash; the time to the first frame on air is reported
+ * - No heap allocation once setup() is done: counted by allocation hooks and
+ *   reported with the heap fragmentation
+ * - Whole-session statistics (mean, spread, percentiles, histogram, Weibull fit),
+ *   kept across reboots and sent to the receivers that ask for them
+ * - Runtime tuning over ESP-NOW: sample rate, filter, transmit policy and log level
+ *   changed by signed commands, applied between two measurements and kept in flash
  * 
- * The main loop performs the following operations:
- * 1. Updates anemometer readings
- * 2. Retrieves current wind speed
- * 3. Logs the measurement
- * 4. Updates the display
- * 5. Broadcasts data via WiFi
- * 6. Waits 2 seconds before next iteration
+ * The work is split into pinned FreeRTOS tasks connected by wait-free SPSC queues:
+ * - Core 1: ADC reader task (continuous conversions into a ring buffer) and the
+ *   measurement producer, which runs Anemometer::update() every 250 ms
+ * - Core 0: transmit (ESP-NOW), log, display and turbulence analysis stages, each
+ *   with its own queue
+ *
+ * A slow display redraw or serial write therefore only delays its own stage and
+ * never shifts the measurement period. loop() periodically reports queue statistics.
+ *
+ * With LOW_POWER_MODE, the pipeline tasks are not started: a PowerScheduler in
+ * loop() runs acquisition (single-shot conversions), transmit, display and report
+ * as periodic deadlines and light-sleeps in between, with the radio in modem sleep.
+ * 
+ * Tracing builds (-DTRACE_ENABLED=1) time the hot paths with the CPU cycle counter:
+ * send 't' on the serial console to log the per-stage histograms, 'c' to clear them.
+ * With BROADCAST_DIAGNOSTICS, a summary also goes out every DIAGNOSTICS_PERIOD_MS.
  * 
  * Hardware Requirements:
  * - M5Stack Atom S3 device
@@ -52,19 +76,407 @@
 #include "Logger.h"
 #include "Anemometer.h"
 #include "Communication.h"
+#include "Pipeline.h"
+#include "Ads1115Source.h"
+#include "ArduinoClock.h"
+#include "SerialConsole.h"
+#include "M5DisplayDevice.h"
+#include "EspNowTransport.h"
+#include "EspCalibrationStore.h"
+#include "EspSessionStore.h"
+#include "EspSettingsStore.h"
+#include "SdBlockStorage.h"
+#include "SampleRecorder.h"
+#include "SampleStreamer.h"
+#include "DisplayRenderer.h"
+#include "SlotScheduler.h"
+#include "TimeSync.h"
+#include "EspPowerControl.h"
+#include "PowerScheduler.h"
+#include "TurbulenceAnalyzer.h"
+#include "HeapMonitor.h"
+#include "SessionStatistics.h"
+#include "AnemometerControl.h"
+#include "ControlChannel.h"
+#include "Trace.h"
+
 
+// Hardware backends (the host build uses simulated ones, see src/host/)
+Ads1115Source adc;
+ArduinoClock systemClock;
+SerialConsole console;
+M5DisplayDevice display;
+EspNowTransport radio;
+EspCalibrationStore calibrationStore;
+EspSessionStore sessionStore;
+EspSettingsStore settingsStore;
 
-// Create a Logger instance (enable SD logging if needed)
-Logger logger(false, true, false); // SD logging disabled, Serial logging enabled, Screen logging disabled
+// Create a Logger instance: text logs go to serial and screen (raw samples go to SD
+// through SampleRecorder, see RECORD_RAW_SAMPLES)
+Logger logger(&console, &display, true, false); // Serial logging enabled, Screen logging disabled
+
+// Low-power mode: one loop runs every deadline and light-sleeps in between (no
+// pipeline tasks, single-shot conversions, radio in modem sleep between frames)
+static const bool LOW_POWER_MODE = false;
 
 // Create an Anemometer instance
-Anemometer anemometer;
+Anemometer anemometer(adc, systemClock, LOW_POWER_MODE ? AcquisitionMode::SingleShot : AcquisitionMode::Continuous);
 
 // Create a Communication instance
-Communication comm;
+Communication comm(radio, systemClock);
+
+// Transmit slot, derived from the MAC address and moved away from the neighbours heard
+static const bool USE_TRANSMIT_SLOTS = true;
+SlotScheduler slots;
+
+// Acquisition times on the clock of a reference node (exactly one node of the fleet
+// is the Reference: it sends the time beacons)
+static const bool USE_TIME_SYNC = true;
+static const TimeSync::Role TIME_SYNC_ROLE = TimeSync::Role::Follower;
+TimeSync timeSync;
+
+// Turbulence spectrum of the filtered wind speed (FFT in its own low-priority stage)
+TurbulenceAnalyzer analyzer(systemClock);
+
+// Session statistics, updated by the transmit stage. Fitted and saved to RTC memory
+// every minute, to flash every 10 min (an NVS write stalls both cores for a few ms)
+SessionStatistics session;
+static const uint32_t SESSION_SAVE_PERIOD_MS = 60000;
+static const uint32_t SESSION_FLASH_EVERY = 10;
+
+// Control channel: commands signed with the fleet key (SipHash-2-4). The key is never
+// in the sources: tools/control_key.py passes it from the ANEMOMETER_CONTROL_KEY
+// environment variable of the build, the one the operator tool (host "ctl") reads.
+// A build without it has the channel off: commands are ignored, settings not restored
+#ifndef CONTROL_KEY_HEX
+#define CONTROL_KEY_HEX ""
+#endif
+AnemometerControl anemometerControl(anemometer, comm, logger, systemClock);
+ControlChannel control(anemometerControl, &settingsStore);
+
+// Wind screen (only changed regions are sent to the LCD)
+DisplayRenderer renderer(display, systemClock);
+
+// Task layout: acquisition on the application core, output next to the WiFi driver
+static const int ACQUISITION_CORE = 1;
+static const int OUTPUT_CORE = 0;
+
+// Raw sample recording to a microSD adapter on SPI (the AtomS3 has no card slot):
+// set the pins to match the wiring before enabling it
+static const bool RECORD_RAW_SAMPLES = false;
+static const int8_t SD_SCK_PIN = 7;
+static const int8_t SD_MISO_PIN = 8;
+static const int8_t SD_MOSI_PIN = 6;
+static const int8_t SD_CS_PIN = 5;
+
+SdBlockStorage sdCard(SD_SCK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_CS_PIN);
+SampleRecorder recorder(sdCard, SampleRecorder::DEFAULT_FILE_SECTORS, OUTPUT_CORE);
+
+// Binary stream of every raw code on the USB serial port (see StreamFormat.h and
+// tools/capture_stream.py); text logging to the serial port stops while it runs
+static const bool STREAM_RAW_SAMPLES = false;
+SampleStreamer streamer(console, OUTPUT_CORE);
+
+// Measurement period (one statistics tick, so a change can be broadcast within
+// 250 ms) and pipeline statistics report period
+static const uint32_t MEASUREMENT_PERIOD_MS = 250;
+static const uint32_t STATS_PERIOD_MS = 30000;
+
+// Low-power mode: display refresh period, and the light-sleep wake-up from the
+// ADS1115 ALERT/RDY pin (GPIO, -1 if not wired: timer wake-up only)
+static const uint32_t DISPLAY_PERIOD_MS = 1000;
+static const uint32_t ANALYSIS_PERIOD_MS = 4000;
+static const int ADC_ALERT_PIN = -1;
+
+EspPowerControl powerControl(ADC_ALERT_PIN);
+PowerScheduler powerScheduler(systemClock, powerControl);
+
+// Tracing builds: console polling period and diagnostics broadcast (MSG_DIAGNOSTICS)
+static const uint32_t CONSOLE_POLL_MS = 100;
+static const bool BROADCAST_DIAGNOSTICS = false;
+static const uint32_t DIAGNOSTICS_PERIOD_MS = 60000;
+
+// The log line and the SD flush keep their former 2 s pace
+static const uint32_t LOG_EVERY = 8;
+static const uint32_t RECORDER_FLUSH_EVERY = 8;
+
+/**
+ * @brief Producer: consumes the accumulated ADC codes and builds a measurement
+ */
+class AnemometerProducer : public MeasurementProducer {
+private:
+  uint32_t lastOverruns_ = 0;
+  uint32_t periods_ = 0;
+
+public:
+  bool produce(Measurement& measurement) override {
+    anemometerControl.applyPending(); // Sample rate and filter changed over the air
+    uint32_t before = anemometer.getSamplesProcessed();
+    anemometer.update();
+    if (++periods_ % RECORDER_FLUSH_EVERY == 0) {
+      recorder.flush(); // Bounds what a power loss can take to about 2 s of samples
+    }
+    uint32_t overruns = anemometer.getOverruns();
+
+    measurement.voltage = anemometer.getVoltage();
+    measurement.windSpeed = anemometer.getWindSpeed();
+    measurement.timestampUs = anemometer.getTimestampUs();
+    WindStats stats = anemometer.getStatistics();
+    measurement.windGust = stats.gust;
+    measurement.windLull = stats.lull;
+    measurement.windMean = stats.mean;
+    measurement.sampleCount = anemometer.getSamplesProcessed() - before;
+    measurement.overruns = overruns - lastOverruns_;
+    measurement.sensorReady = anemometer.isSensorReady();
+    lastOverruns_ = overruns;
+    return true;
+  }
+};
+
+/**
+ * @brief Log stage: writes the wind speed to the configured logger outputs every LOG_EVERY periods
+ */
+class LogSink : public MeasurementSink {
+public:
+  void consume(const Measurement& measurement) override {
+    if (measurement.sequenceNumber % LOG_EVERY != 0) {
+      return;
+    }
+    logger.logf(LogModule::Main, LogLevel::Info, "Wind Speed: %.2f m/s, Gust: %.2f m/s, Lull: %.2f m/s, Mean: %.2f m/s",
+                measurement.windSpeed, measurement.windGust, measurement.windLull, measurement.windMean);
+  }
+};
+
+/**
+ * @brief Display stage: redraws the changed parts of the Atom S3 screen
+ */
+class DisplaySink : public MeasurementSink {
+public:
+  void consume(const Measurement& measurement) override {
+    renderer.render(measurement.windSpeed, measurement.windGust, measurement.windLull);
+  }
+};
+
+/**
+ * @brief Analysis stage: runs the turbulence spectrum once a hop of new samples is in
+ */
+class AnalysisSink : public MeasurementSink {
+public:
+  void consume(const Measurement& measurement) override {
+    analyzer.service(measurement.timestampMs);
+  }
+};
+
+/**
+ * @brief Transmit stage: offers each measurement to the adaptive broadcast policy
+ *
+ * A new turbulence result rides along with every frame offered until one is sent.
+ * The stage also owns the session statistics, and answers the summary requests
+ * in a period without another frame.
+ */
+class TransmitSink : public MeasurementSink {
+private:
+  TurbulenceResult turbulence_ = {};
+  bool turbulencePending_ = false;
+  uint32_t lastDiagnosticsMs_ = 0;
+  uint32_t lastSessionSaveMs_ = 0;
+  uint32_t sessionSaves_ = 0;
+  SessionRecord sessionRecord_ = {};
+
+  /**
+   * @brief Add a measurement to the session; refit and save it when due
+   */
+  void updateSession(const Measurement& measurement) {
+    if (measurement.sensorReady) {
+      session.addSample(measurement.windSpeed, measurement.timestampMs);
+    }
+    if (measurement.timestampMs - lastSessionSaveMs_ < SESSION_SAVE_PERIOD_MS) {
+      return;
+    }
+    lastSessionSaveMs_ = measurement.timestampMs;
+    session.fitWeibull();
+    session.exportRecord(sessionRecord_);
+    bool flash = ++sessionSaves_ % SESSION_FLASH_EVERY == 0;
+    if (!sessionStore.save(sessionRecord_, flash)) {
+      logger.log("Session save failed");
+    }
+  }
+
+  /**
+   * @brief Answer a pending summary request
+   * @return true if a frame was queued
+   */
+  bool sendSummary() {
+    if (!comm.summaryRequested()) {
+      return false;
+    }
+    SessionSummary summary = {};
+    session.summary(summary);
+    return comm.broadcastSummary(summary);
+  }
+
+  /**
+   * @brief Send the trace summary when due, in a period without another frame
+   */
+  void sendDiagnostics(uint32_t nowMs) {
+#if TRACE_ENABLED
+    if (!BROADCAST_DIAGNOSTICS || nowMs - lastDiagnosticsMs_ < DIAGNOSTICS_PERIOD_MS) {
+      return;
+    }
+    DiagnosticsData diagnostics = {};
+    radio.macAddress(diagnostics.macAddress);
+    diagnostics.cyclesPerUs = Trace::cyclesPerMicrosecond();
+    for (size_t i = 0; i < TRACE_STAGE_COUNT && diagnostics.count < WireFormat::MAX_DIAGNOSTICS_ENTRIES; i++) {
+      TraceStage stage = static_cast<TraceStage>(i);
+      uint32_t calls = Trace::count(stage);
+      if (calls == 0) {
+        continue;
+      }
+      DiagnosticsEntry& entry = diagnostics.entries[diagnostics.count++];
+      entry.stage = static_cast<uint8_t>(i);
+      entry.calls = calls > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(calls);
+      entry.p99Bucket = static_cast<uint8_t>(Trace::percentileBucket(stage, 0.99f));
+      entry.averageCycles = Trace::averageCycles(stage);
+      entry.maxCycles = Trace::maxCycles(stage);
+    }
+    if (comm.broadcastDiagnostics(diagnostics)) {
+      lastDiagnosticsMs_ = nowMs;
+    }
+#else
+    (void)nowMs;
+#endif
+  }
+
+public:
+  void consume(const Measurement& measurement) override {
+    updateSession(measurement);
+    if (analyzer.takeResult(turbulence_)) {
+      turbulencePending_ = true;
+      logger.logf(LogModule::Main, LogLevel::Info, "Turbulence: %.1f%% (%.2f +/- %.2f m/s), gust period %.1f s",
+                  100.0f * turbulence_.intensity, turbulence_.mean, turbulence_.stddev, turbulence_.gustPeriod);
+    }
+
+    // Prepare data for broadcast
+    AnemometerData data = {};
+    {
+      TRACE_SCOPE(TraceStage::MacAddress);
+      radio.macAddress(data.macAddress);
+    }
+    data.windSpeed = measurement.windSpeed;
+    data.fields = measurement.sensorReady ? WireFormat::FIELD_STATS : WireFormat::FIELD_NO_SENSOR;
+    data.windGust = measurement.windGust;
+    data.windLull = measurement.windLull;
+    data.windMean = measurement.windMean;
+    if (USE_TIME_SYNC) {
+      data.fields |= WireFormat::FIELD_TIME; // Converted, or dropped while not synchronised
+      data.timestampUs = measurement.timestampUs;
+    }
+    if (turbulencePending_) {
+      data.fields |= WireFormat::FIELD_TURBULENCE;
+      data.turbulenceIntensity = turbulence_.intensity;
+      data.gustFrequency = turbulence_.gustFrequency;
+    }
+
+    // Broadcast the data if it changed enough (sequence number assigned per frame sent)
+    if (comm.offer(data, measurement.timestampMs)) {
+      turbulencePending_ = false;
+    } else if (!sendSummary()) {
+      sendDiagnostics(measurement.timestampMs);
+    }
+  }
+};
+
+AnemometerProducer producer;
+TransmitSink transmitSink;
+LogSink logSink;
+DisplaySink displaySink;
+AnalysisSink analysisSink;
+
+// Output stages (core 0): radio first so it is never starved by the display
+PipelineStage transmitStage("transmit", transmitSink, 3, OUTPUT_CORE);
+PipelineStage logStage("log", logSink, 1, OUTPUT_CORE);
+PipelineStage displayStage("display", displaySink, 1, OUTPUT_CORE);
+PipelineStage analysisStage("analysis", analysisSink, 1, OUTPUT_CORE);
+
+// Measurement producer (core 1)
+Pipeline pipeline(producer, MEASUREMENT_PERIOD_MS, 4, ACQUISITION_CORE);
+
+static void reportStatistics();
+static void pollConsole();
+
+// Boot metrics: end of setup(), since power-on
+static uint32_t setupDoneMs = 0;
+
+/**
+ * @brief Low-power acquisition: builds a measurement and logs it
+ */
+class AcquireTask : public PowerTask {
+private:
+  uint32_t sequence_ = 0;
+
+public:
+  Measurement latest = {};
+
+  void run() override {
+    Measurement measurement = {};
+    producer.produce(measurement);
+    measurement.sequenceNumber = sequence_++;
+    measurement.timestampMs = systemClock.millis();
+    logSink.consume(measurement);
+    latest = measurement;
+  }
+};
+
+AcquireTask acquireTask;
 
-// Sequence number for packet tracking
-uint32_t sequenceNumber = 0;
+/**
+ * @brief Low-power transmit: offers the latest measurement; no light sleep while a frame is in flight
+ */
+class TransmitTask : public PowerTask {
+public:
+  void run() override {
+    transmitSink.consume(acquireTask.latest);
+  }
+
+  bool busy() const override {
+    return comm.transmitter().inFlight() > 0;
+  }
+};
+
+/**
+ * @brief Low-power display refresh
+ */
+class DisplayTask : public PowerTask {
+public:
+  void run() override {
+    displaySink.consume(acquireTask.latest);
+  }
+};
+
+/**
+ * @brief Low-power turbulence analysis (the hand-off ring holds 16 s of samples at 4 Hz)
+ */
+class AnalysisTask : public PowerTask {
+public:
+  void run() override {
+    analysisSink.consume(acquireTask.latest);
+  }
+};
+
+/**
+ * @brief Low-power statistics report
+ */
+class ReportTask : public PowerTask {
+public:
+  void run() override {
+    reportStatistics();
+  }
+};
+
+TransmitTask transmitTask;
+DisplayTask displayTask;
+AnalysisTask analysisTask;
+ReportTask reportTask;
 
 
 /**
@@ -80,128 +492,310 @@ void setup() {
   M5.begin(cfg);
 
   // Set the screen to white and the text color to black
-  M5.Display.fillScreen(WHITE);
-  M5.Display.setTextColor(BLACK);
-  M5.Display.setTextSize(2);
+  display.fillScreen(DisplayDevice::COLOR_WHITE);
+  display.setTextColor(DisplayDevice::COLOR_BLACK);
+  display.setTextSize(2);
 
   // Log a welcome message
   logger.log("Setup started");
 
+#if TRACE_ENABLED
+  Trace::begin();
+#endif
+
   // Set loggers for both classes
   Anemometer::setLogger(logger);
   Communication::setLogger(logger);
 
-  // Anemometer and Communication setup
-  anemometer.setup();
+  // Radio first, so the node is heard even without its sensor; the anemometer does not
+  // wait for the converter (retried by the producer, frames flagged FIELD_NO_SENSOR)
   comm.setup();
+  anemometer.setCalibrationStore(&calibrationStore);
+  if (!anemometer.setup()) {
+    logger.log("Sensor unavailable, starting without it");
+  }
+
+  // Turbulence analysis (single-shot mode gives one filtered sample per measurement)
+  if (LOW_POWER_MODE) {
+    analyzer.setInputRate(1000.0f / MEASUREMENT_PERIOD_MS);
+  }
+  anemometer.setAnalyzer(&analyzer);
+
+  // Resume the session of the previous boot (RTC memory after a soft reset, flash
+  // after a power cycle), and answer the receivers asking for it
+  SessionRecord savedSession;
+  if (sessionStore.load(savedSession) && session.importRecord(savedSession)) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Session resumed: %lu samples", session.samples());
+  }
+  comm.enableSummaryRequests();
 
+  // Control channel: restore the settings changed over the air (before the pipeline
+  // starts, so the producer applies them at its first period), then listen
+  {
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    radio.macAddress(mac);
+    anemometerControl.begin();
+    uint8_t key[WireFormat::CONTROL_KEY_SIZE];
+    if (ControlChannel::parseKey(CONTROL_KEY_HEX, key)) {
+      if (control.begin(key, mac)) {
+        logger.logf(LogModule::Main, LogLevel::Info, "Control: settings restored, counter %lu", control.lastCounter());
+      }
+      comm.setControl(control);
+    } else {
+      logger.logf(LogModule::Main, LogLevel::Warning, "Control: no fleet key in this build, channel off");
+    }
+  }
+
+  // Transmit slots (need the MAC address and a running radio, so after comm.setup())
+  if (USE_TRANSMIT_SLOTS) {
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    radio.macAddress(mac);
+    slots.begin(mac);
+    comm.setScheduler(slots);
+  }
+
+  // Time synchronisation (same requirements as the slots)
+  if (USE_TIME_SYNC) {
+    uint8_t mac[RadioTransport::MAC_SIZE];
+    radio.macAddress(mac);
+    timeSync.begin(mac, TIME_SYNC_ROLE);
+    comm.setTimeSync(timeSync);
+  }
+
+  // Raw sample recording (needs the MAC address, so after comm.setup()). The header
+  // has the nominal scale if the sensor never answered and no calibration is cached
+  if (RECORD_RAW_SAMPLES) {
+    RecordingFormat::FileInfo info = {};
+    info.sampleRate = adc.sampleRate();
+    radio.macAddress(info.macAddress);
+    info.millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    info.curve = anemometer.getCalibrationCurve();
+    if (recorder.begin(info)) {
+      anemometer.setRecorder(&recorder);
+      logger.logf(LogModule::Main, LogLevel::Info, "Recording session %lu", recorder.session());
+    } else {
+      logger.log("SD recording start failed");
+    }
+  }
+
+  // Raw code streaming (needs the MAC address, so after comm.setup())
+  if (STREAM_RAW_SAMPLES) {
+    StreamFormat::StreamInfo info = {};
+    radio.macAddress(info.macAddress);
+    info.sampleRate = adc.sampleRate();
+    info.millivoltsPerCode = anemometer.getMillivoltsPerCode();
+    logger.log("Streaming raw samples, serial logging off");
+    logger.enableSerialLogging(false);
+    if (streamer.begin(info)) {
+      anemometer.setStreamer(&streamer);
+    } else {
+      logger.enableSerialLogging(true);
+      logger.log("Sample streamer start failed");
+    }
+  }
+
+  // From here on, log calls only queue a record; the logger task formats and writes it
+  if (!logger.startAsync()) {
+    logger.log("Logger task start failed, logging stays synchronous");
+  }
+
+  if (LOW_POWER_MODE) {
+    // Same period for acquire and transmit: transmit runs right after, in the same wake-up.
+    // Currents are estimates for the charge ledger.
+    if (!powerControl.begin()) {
+      logger.log("ALERT wake-up setup failed");
+    }
+    if (!powerControl.setRadioPowerSave(true)) {
+      logger.log("Modem sleep not available");
+    }
+    powerScheduler.add("acquire", acquireTask, MEASUREMENT_PERIOD_MS * 1000, 35.0f, ADC_ALERT_PIN >= 0);
+    powerScheduler.add("transmit", transmitTask, MEASUREMENT_PERIOD_MS * 1000, 190.0f);
+    powerScheduler.add("display", displayTask, DISPLAY_PERIOD_MS * 1000, 45.0f);
+    powerScheduler.add("analysis", analysisTask, ANALYSIS_PERIOD_MS * 1000, 35.0f);
+    powerScheduler.add("report", reportTask, STATS_PERIOD_MS * 1000, 35.0f);
+    powerScheduler.start();
+  } else {
+    // Start the output stages then the producer
+    pipeline.addStage(transmitStage);
+    pipeline.addStage(logStage);
+    pipeline.addStage(displayStage);
+    pipeline.addStage(analysisStage);
+    if (!pipeline.start()) {
+      logger.log("Pipeline start failed");
+    }
+  }
+
+  setupDoneMs = systemClock.millis();
   logger.log("Setup complete");
+  // Everything below runs on preallocated buffers: any allocation from here is a bug
+  HeapMonitor::markSteadyState();
 }
 
 /**
- * @brief Display wind speed on the Atom S3 screen
- * 
- * This function displays the wind speed value in large text with "m/s" unit below.
- * It clears the previous value before displaying the new one.
+ * @brief Main application loop: pipeline supervision, or the low-power scheduler
  * 
- * @param windSpeed The wind speed value to display in m/s
+ * Measurement, display, logging and broadcasting all run in their own tasks
+ * (see the Pipeline set up in setup()). The Arduino loop only serves the console
+ * and reports, every STATS_PERIOD_MS, the statistics (see reportStatistics()). In
+ * low-power mode it runs the due deadlines and sleeps until the next one instead.
  */
-void displayWindSpeed(float windSpeed) {
-  // Clear the screen
-  M5.Display.fillScreen(WHITE);
-  
-  // Set large text size for wind speed value
-  M5.Display.setTextSize(3);
-  M5.Display.setTextColor(BLACK);
-  
-  // Convert wind speed to string with 1 decimal place
-  String speedStr = String(windSpeed, 1);
-  
-  // Calculate text width to center it
-  int16_t textWidth = M5.Display.textWidth(speedStr);
-  int16_t x = (M5.Display.width() - textWidth) / 2;
-  int16_t y = M5.Display.height() / 2 - 20;
-  
-  // Display wind speed value
-  M5.Display.setCursor(x, y);
-  M5.Display.print(speedStr);
-  
-  // Set smaller text size for unit
-  M5.Display.setTextSize(2);
-  String unitStr = "m/s";
-  int16_t unitWidth = M5.Display.textWidth(unitStr);
-  int16_t unitX = (M5.Display.width() - unitWidth) / 2;
-  int16_t unitY = y + 35;
-  
-  // Display unit
-  M5.Display.setCursor(unitX, unitY);
-  M5.Display.print(unitStr);
+void loop() {
+  if (LOW_POWER_MODE) {
+    pollConsole();
+    powerScheduler.step();
+    return;
+  }
+  for (uint32_t waited = 0; waited < STATS_PERIOD_MS; waited += CONSOLE_POLL_MS) {
+    pollConsole();
+    delay(CONSOLE_POLL_MS);
+  }
+  reportStatistics();
 }
 
 /**
- * @brief Main application loop for wind speed monitoring and data broadcasting
- * 
- * This function executes continuously after the initial setup is complete. It performs
- * the core functionality of the anemometer system in a cyclical manner with a 2-second
- * interval between iterations.
- * 
- * The loop performs the following sequence of operations:
- * 1. Updates the anemometer sensor readings to get fresh wind speed data
- * 2. Retrieves the current wind speed measurement in m/s
- * 3. Logs the wind speed value with 2 decimal precision to configured outputs
- * 4. Updates the M5Stack Atom S3 display with the current wind speed reading
- * 5. Prepares an AnemometerData structure containing:
- *    - Message type identifier (2 for anemometer)
- *    - Unique anemometer ID (currently set to 1)
- *    - Device MAC address for identification
- *    - Current wind speed measurement
- * 6. Broadcasts the data packet via WiFi to connected clients
- * 7. Waits 2 seconds before starting the next measurement cycle
- * 
- * This continuous operation ensures real-time monitoring and transmission of wind
- * speed data while maintaining a consistent update rate suitable for most sailing
- * and weather monitoring applications.
- * 
- * @note The 2-second delay provides a balance between responsive updates and
- *       system stability while preventing excessive data transmission
+ * @brief Serve the console commands of tracing builds ('t' dumps the trace, 'c' clears it)
  */
-void loop() {
-  
-  // Main code to run repeatedly
-  anemometer.update();
-
-  // Get the current wind speed
-  float windSpeed = anemometer.getWindSpeed();
-
-  // Log the wind speed
-  logger.log("Wind Speed: " + String(windSpeed, 2) + " m/s");
-
-  // Update the display with the current wind speed
-  displayWindSpeed(windSpeed);
-
-  // Prepare data for broadcast
-  AnemometerData data;
-  data.messageType = 2; // 2 = Anemometer
-  
-  // Get MAC address and format as string
-  WiFi.macAddress(data.macAddress);
-  String macString = "";
-  for (int i = 0; i < 6; i++) {
-    if (data.macAddress[i] < 16) macString += "0";
-    macString += String(data.macAddress[i], HEX);
-    if (i < 5) macString += ":";
-  }
-  macString.toUpperCase();
-  strcpy(data.anemometerId, macString.c_str());
-  
-  data.sequenceNumber = sequenceNumber++;
-  data.windSpeed = windSpeed;
-  data.timestamp = 0; // Not used - Display will set it upon reception
-
-  // Broadcast the data
-  comm.broadcast(data);
-
-  // Delay for 2 seconds before the next reading
-  delay(2000); 
+static void pollConsole() {
+#if TRACE_ENABLED
+  for (int c = console.read(); c >= 0; c = console.read()) {
+    if (c == 't') {
+      Trace::dump(logger);
+    } else if (c == 'c') {
+      Trace::reset();
+      logger.log("Trace cleared");
+    }
+  }
+#endif
+}
 
+/**
+ * @brief Log the run-time statistics
+ *
+ * The boot metrics (end of setup, first frame on air, sensor start), the high-water mark, drop count and worst service time of each stage queue and
+ * the number of late producer wake-ups (or, in low-power mode, the sleep ratio and
+ * the per-task charge ledger), the broadcast counters, the radio delivery statistics,
+ * the TDMA slot statistics (latency histogram and per-slot loss estimates at
+ * debug level), the session statistics, the control channel counters and the
+ * turbulence analysis cost.
+ */
+static void reportStatistics() {
+  uint32_t firstFrameUs;
+  if (comm.transmitter().firstSentUs(firstFrameUs)) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Boot: setup done at %lu ms, first frame on air at %lu ms",
+                setupDoneMs, firstFrameUs / 1000);
+  } else {
+    logger.logf(LogModule::Main, LogLevel::Warning, "Boot: setup done at %lu ms, no frame on air yet", setupDoneMs);
+  }
+  if (anemometer.isSensorReady()) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Sensor: ready at %lu ms after %lu attempts, calibration from %s",
+                anemometer.getSensorReadyMs(), anemometer.getSensorAttempts(),
+                calibrationSourceName(anemometer.getCalibrationSource()));
+  } else {
+    logger.logf(LogModule::Main, LogLevel::Warning, "Sensor: unavailable after %lu attempts",
+                anemometer.getSensorAttempts());
+  }
+  HeapInfo heap;
+  if (HeapMonitor::heapInfo(heap)) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Heap: free %lu, largest block %lu, min free %lu, fragmentation %.1f%%",
+                heap.freeBytes, heap.largestFreeBlock, heap.minimumFreeBytes,
+                100.0f * HeapMonitor::fragmentation(heap));
+  }
+  if (HeapMonitor::steadyAllocations()) {
+    logger.logf(LogModule::Main, LogLevel::Warning, "Heap: %lu allocations since setup (%lu bytes, first %lu bytes)",
+                HeapMonitor::steadyAllocations(), HeapMonitor::steadyBytes(), HeapMonitor::firstSteadySize());
+  } else if (HeapMonitor::allocations()) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Heap: no allocation since setup (%lu during setup)",
+                HeapMonitor::allocations());
+  }
+  if (LOW_POWER_MODE) {
+    logger.logf(LogModule::Main, LogLevel::Info,
+                "Power: %.1f%% light sleep, %lu sleeps (%lu on ALERT), wake-up lead %lu us, avg %.1f mA",
+                100.0f * powerScheduler.sleepRatio(), powerScheduler.lightSleeps(), powerScheduler.alertWakes(),
+                powerScheduler.leadUs(), powerScheduler.averageMilliamps());
+    float elapsedUs = powerScheduler.elapsedUs() ? static_cast<float>(powerScheduler.elapsedUs()) : 1.0f;
+    for (size_t i = 0; i < powerScheduler.taskCount(); i++) {
+      const PowerLedger& ledger = powerScheduler.ledger(i);
+      logger.logf(LogModule::Main, LogLevel::Info, "%s: %lu runs, %lu missed, max late %lu us, duty %.3f%%",
+                  ledger.name, ledger.runs, ledger.missed, ledger.maxLatenessUs, 100.0f * ledger.activeUs / elapsedUs);
+    }
+  } else {
+    logger.logf(LogModule::Main, LogLevel::Info, "Pipeline: %lu measurements, %lu late", pipeline.produced(),
+                pipeline.lateWakeups());
+    for (size_t i = 0; i < pipeline.stageCount(); i++) {
+      const PipelineStage& stage = pipeline.stage(i);
+      logger.logf(LogModule::Main, LogLevel::Info, "%s: high-water %lu/%u, dropped %lu, max %lu ms", stage.name(),
+                  stage.highWater(), PipelineStage::QUEUE_SIZE, stage.dropped(), stage.maxServiceMs());
+    }
+  }
+  logger.logf(LogModule::Main, LogLevel::Info, "Display: %lu frames, %lu bytes/frame (full: %lu), last %lu us, max %lu us",
+              renderer.frames(), renderer.averageFrameBytes(), DisplayRenderer::FULL_FRAME_BYTES,
+              renderer.lastFrameUs(), renderer.maxFrameUs());
+  const BroadcastPolicy& policy = comm.policy();
+  logger.logf(LogModule::Main, LogLevel::Info,
+              "Broadcast: %lu frames (%lu changes, %lu heartbeats, %lu rate-limited), fixed schedule %lu, saved %ld",
+              policy.sent(), policy.events(), policy.heartbeats(), policy.rateLimited(), policy.fixedScheduleFrames(),
+              policy.saved());
+  const TransmitEngine& transmitter = comm.transmitter();
+  logger.logf(LogModule::Main, LogLevel::Info,
+              "Radio: %lu queued, %lu sent, %lu failed, %lu busy, latency %lu us avg, %lu us max",
+              transmitter.queued(), transmitter.completed(), transmitter.failed(), transmitter.busy(),
+              transmitter.averageLatencyUs(), transmitter.maxLatencyUs());
+  for (size_t bucket = 0; bucket < TransmitEngine::LATENCY_BUCKETS; bucket++) {
+    uint32_t sent = transmitter.latencyCount(true, bucket);
+    uint32_t failed = transmitter.latencyCount(false, bucket);
+    uint32_t limit = TransmitEngine::bucketLimitUs(bucket);
+    if (!sent && !failed) {
+      continue;
+    }
+    if (limit) {
+      logger.logf(LogModule::Main, LogLevel::Debug, "Radio latency < %lu us: %lu sent, %lu failed", limit, sent, failed);
+    } else {
+      logger.logf(LogModule::Main, LogLevel::Debug, "Radio latency >= %lu us: %lu sent, %lu failed",
+                  TransmitEngine::bucketLimitUs(bucket - 1), sent, failed);
+    }
+  }
+  if (USE_TRANSMIT_SLOTS) {
+    // Read while the transmit stage updates them: good enough for a report
+    logger.logf(LogModule::Main, LogLevel::Info,
+                "TDMA: slot %u, %lu conflicts, %lu reselections, %lu missed slots, lead %lu us, max late %lu us",
+                slots.slot(), slots.conflicts(), slots.reselections(), slots.missedSlots(), slots.leadUs(),
+                slots.maxLatenessUs());
+    uint32_t now = systemClock.micros();
+    for (uint16_t slot = 0; slot < SlotScheduler::SLOT_COUNT; slot++) {
+      SlotStats stats = slots.slotStats(slot, now);
+      if (stats.received > 0) {
+        logger.logf(LogModule::Main, LogLevel::Debug, "Slot %u: %u neighbours, %lu received, %lu missed (%.1f%%)",
+                    slot, stats.occupants, stats.received, stats.missed, 100.0f * slots.lossEstimate(slot));
+      }
+    }
+  }
+  if (USE_TIME_SYNC) {
+    uint32_t now = systemClock.micros();
+    logger.logf(LogModule::Main, LogLevel::Info,
+                "Time sync: %s, offset %ld us, drift %.2f ppm, error %u us, %lu beacons, %lu lost",
+                timeSync.synced(now) ? "synced" : "not synced", timeSync.offsetUs(), timeSync.driftPpm(),
+                timeSync.errorUs(now), timeSync.beacons(), timeSync.lostBeacons());
+    logger.logf(LogModule::Main, LogLevel::Info,
+                "Time sync: %lu outliers, %lu resets, sample to air %lu us avg, to queue %lu us max",
+                timeSync.outliers(), timeSync.resets(), comm.sampleToAirUs(), comm.maxSampleLatencyUs());
+  }
+  logger.logf(LogModule::Main, LogLevel::Info,
+              "Session: %lu samples, mean %.2f m/s, p90 %.2f m/s, Weibull k %.2f, %lu summary requests",
+              session.samples(), session.mean(), session.quantile(1), session.weibullK(), comm.summaryRequests());
+  logger.logf(LogModule::Main, LogLevel::Info,
+              "Control: %lu commands, %lu rejected, %lu dropped, %lu applied, %lu store errors, counter %lu",
+              control.commands(), control.rejected(), comm.droppedControls(), anemometerControl.appliedChanges(),
+              control.storeErrors(), control.lastCounter());
+  logger.logf(LogModule::Main, LogLevel::Info, "Turbulence: %lu analyses at %.2f Hz, %lu overruns, last %lu us, max %lu us",
+              analyzer.analyses(), analyzer.sampleRate(), analyzer.overruns(), analyzer.lastAnalysisUs(),
+              analyzer.maxAnalysisUs());
+  if (RECORD_RAW_SAMPLES) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Recorder: %lu sectors, %lu dropped, %lu errors, max %lu ms",
+                recorder.sectorsWritten(), recorder.recordsDropped(), recorder.writeErrors(), recorder.maxWriteMs());
+  }
+  if (STREAM_RAW_SAMPLES) {
+    logger.logf(LogModule::Main, LogLevel::Info, "Stream: %lu packets, %lu bytes, %lu codes dropped, %lu short writes, max %lu ms",
+                streamer.packetsWritten(), streamer.bytesWritten(), streamer.codesDropped(), streamer.shortWrites(),
+                streamer.maxWriteMs());
+  }
 }
@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+# Copyright (C) 2025 Philippe Hubert
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Capture the binary raw sample stream of an anemometer to CSV.
+
+The device streams when STREAM_RAW_SAMPLES is set in main.cpp; the format is
+described in include/StreamFormat.h. A reader thread only moves bytes from the
+serial port to a queue, so decoding and disk writes never hold the port back.
+Damaged packets (CRC), lost packets (sequence gaps) and codes the device could not
+send (dropped counts) are reported at the end.
+
+    tools/capture_stream.py /dev/ttyACM0 -o wind.csv [--raw wind.bin] [--seconds 600]
+    tools/capture_stream.py --self-test .pio/build/native/program
+"""
+
+import argparse
+import csv
+import os
+import queue
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+import termios
+import threading
+import time
+import tty
+import zlib
+
+VERSION = 1
+TYPE_SAMPLES = 1
+TYPE_INFO = 2
+SAMPLES_HEADER = struct.Struct("<BBHIIIHB")
+INFO = struct.Struct("<BBH6sHf")
+CRC_SIZE = 4
+
+COLUMNS = ["sample_index", "timestamp_us", "code", "millivolts"]
+
+
+def cobs_decode(frame):
+    """Decode one COBS frame (no delimiter), None if malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + (1 if code == 1 else 0):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+class StreamDecoder:
+    """Splits the byte stream into packets, checks them and writes one CSV row per code."""
+
+    def __init__(self, writer):
+        self.writer = writer
+        self.pending = bytearray()
+        self.mv_per_code = None
+        self.sample_rate = None
+        self.mac = None
+        self.next_sequence = None
+        self.next_index = None
+        self.time_base = 0          # Added to the device's 32-bit us clock once it wraps
+        self.last_us = None
+        self.packets = 0
+        self.codes = 0
+        self.code_sum = 0
+        self.crc_errors = 0
+        self.lost_packets = 0       # Sequence gaps: packets missing from the link
+        self.device_drops = 0       # Codes the device could not send
+        self.missing_codes = 0      # Index gaps, whatever the cause
+        self.skipped_bytes = 0      # Text or noise between packets
+
+    def feed(self, data):
+        self.pending += data
+        frames = self.pending.split(b"\0")
+        self.pending = frames.pop()
+        for frame in frames:
+            if frame:
+                self.packet(frame)
+
+    def packet(self, frame):
+        packet = cobs_decode(frame)
+        if packet is None or len(packet) < 2 + CRC_SIZE or packet[1] != VERSION:
+            self.skipped_bytes += len(frame) + 1
+            return
+        if zlib.crc32(packet[:-CRC_SIZE]) != struct.unpack_from("<I", packet, len(packet) - CRC_SIZE)[0]:
+            self.crc_errors += 1
+            return
+        if packet[0] == TYPE_INFO and len(packet) == INFO.size + CRC_SIZE:
+            _, _, _, mac, self.sample_rate, self.mv_per_code = INFO.unpack_from(packet)
+            self.mac = ":".join("%02X" % b for b in mac)
+        elif packet[0] == TYPE_SAMPLES and len(packet) >= SAMPLES_HEADER.size + CRC_SIZE:
+            self.samples(packet)
+        else:
+            self.skipped_bytes += len(frame) + 1
+
+    def samples(self, packet):
+        _, _, sequence, first_index, first_us, last_us, dropped, count = SAMPLES_HEADER.unpack_from(packet)
+        if len(packet) != SAMPLES_HEADER.size + 2 * count + CRC_SIZE or count == 0:
+            self.crc_errors += 1
+            return
+        if self.next_sequence is not None:
+            self.lost_packets += (sequence - self.next_sequence) & 0xFFFF
+            self.missing_codes += (first_index - self.next_index) & 0xFFFFFFFF
+        self.device_drops += dropped
+        self.next_sequence = (sequence + 1) & 0xFFFF
+        self.next_index = (first_index + count) & 0xFFFFFFFF
+
+        if self.last_us is not None and first_us < self.last_us and self.last_us - first_us > 0x80000000:
+            self.time_base += 1 << 32
+        self.last_us = last_us
+        span = (last_us - first_us) & 0xFFFFFFFF
+        start = self.time_base + first_us
+        codes = struct.unpack_from("<%dh" % count, packet, SAMPLES_HEADER.size)
+        scale = self.mv_per_code
+        rows = []
+        for i, code in enumerate(codes):
+            timestamp = start + (span * i // (count - 1) if count > 1 else 0)
+            rows.append((first_index + i, timestamp, code, round(code * scale, 3) if scale else ""))
+        self.writer.writerows(rows)
+        self.packets += 1
+        self.codes += count
+        self.code_sum += sum(codes)
+
+    def summary(self):
+        return ("%d packets, %d codes, %d CRC errors, %d lost packets, %d codes missing (%d dropped on the device), "
+                "%d bytes skipped%s" % (self.packets, self.codes, self.crc_errors, self.lost_packets,
+                                        self.missing_codes, self.device_drops, self.skipped_bytes,
+                                        ", %s at %d SPS" % (self.mac, self.sample_rate) if self.mac else ""))
+
+
+def reader(fd, chunks):
+    """Move bytes from the port to the queue until it closes (None marks the end)."""
+    try:
+        while True:
+            data = os.read(fd, 65536)
+            if not data:
+                break
+            chunks.put(data)
+    except OSError:
+        pass  # EIO: the other end of a pseudo-terminal closed, or the device went away
+    chunks.put(None)
+
+
+def capture(fd, writer, raw, seconds=None):
+    """Decode the stream from fd until it closes or seconds elapse."""
+    decoder = StreamDecoder(writer)
+    chunks = queue.Queue()
+    threading.Thread(target=reader, args=(fd, chunks), daemon=True).start()
+    deadline = time.monotonic() + seconds if seconds else None
+    while True:
+        timeout = max(0.0, deadline - time.monotonic()) if deadline else None
+        try:
+            data = chunks.get(timeout=timeout)
+        except queue.Empty:
+            break
+        if data is None:
+            break
+        if raw:
+            raw.write(data)
+        decoder.feed(data)
+    return decoder
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        attributes = termios.tcgetattr(fd)
+        speed = getattr(termios, "B%d" % baud, None)
+        if speed is not None:
+            attributes[4] = attributes[5] = speed
+            termios.tcsetattr(fd, termios.TCSANOW, attributes)
+    return fd
+
+
+def self_test(program, seconds):
+    """Stream from the host build through a pseudo-terminal and check every code arrived."""
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    process = subprocess.Popen([program, "stream", "--realtime", "--seconds", str(seconds)], stdout=slave,
+                               stderr=subprocess.PIPE)
+    os.close(slave)
+    with tempfile.TemporaryFile("w+", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(COLUMNS)
+        decoder = capture(master, writer, None)
+        out.seek(0)
+        rows = sum(1 for _ in out) - 1
+    os.close(master)
+    report = process.communicate()[1].decode()
+    sys.stderr.write(report)
+    print("capture: " + decoder.summary(), file=sys.stderr)
+    match = re.search(r"stream: (\d+) codes, sum (-?\d+), (\d+) dropped", report)
+    if process.returncode != 0 or match is None:
+        print("FAILED: stream command error", file=sys.stderr)
+        return 1
+    sent, code_sum = int(match.group(1)), int(match.group(2))
+    ok = (decoder.codes == sent == rows and decoder.code_sum == code_sum and decoder.crc_errors == 0 and
+          decoder.lost_packets == 0 and decoder.missing_codes == 0 and decoder.device_drops == 0 and
+          decoder.skipped_bytes == 0 and decoder.mac is not None)
+    print("OK" if ok else "FAILED: %d codes sent, %d received, %d rows" % (sent, decoder.codes, rows),
+          file=sys.stderr)
+    return 0 if ok else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?", help="Serial port (or a file captured with --raw)")
+    parser.add_argument("-o", "--output", help="CSV output (default: stdout)")
+    parser.add_argument("--raw", help="Also keep the undecoded bytes in this file")
+    parser.add_argument("--baud", type=int, default=115200, help="Line speed (ignored by USB serial)")
+    parser.add_argument("--seconds", type=float, help="Stop after this time (default: until the port closes)")
+    parser.add_argument("--self-test", metavar="PROGRAM", help="Check the capture against the host build")
+    args = parser.parse_args()
+
+    if args.self_test:
+        return self_test(args.self_test, int(args.seconds or 3))
+    if not args.port:
+        parser.error("a port is required")
+
+    try:
+        fd = open_port(args.port, args.baud)
+    except OSError as error:
+        print(error, file=sys.stderr)
+        return 1
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    raw = open(args.raw, "wb") if args.raw else None
+    writer = csv.writer(out)
+    writer.writerow(COLUMNS)
+    try:
+        decoder = capture(fd, writer, raw, args.seconds)
+    except KeyboardInterrupt:
+        decoder = None
+    finally:
+        os.close(fd)
+        if raw:
+            raw.close()
+        if args.output:
+            out.close()
+    if decoder:
+        print(decoder.summary(), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
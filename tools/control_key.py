@@ -0,0 +1,37 @@
+# Copyright (C) 2025 Philippe Hubert
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""PlatformIO pre-script: pass the control channel fleet key to the firmware.
+
+The key (32 hex digits) comes from the ANEMOMETER_CONTROL_KEY environment variable
+of the build and is never written in the repository. Without it the firmware is
+built with no key and its control channel stays off. The host "ctl" and "node"
+commands read the same variable.
+
+    export ANEMOMETER_CONTROL_KEY=$(openssl rand -hex 16)
+    pio run -e m5stack-atomsS3
+"""
+
+import os
+import re
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+key = os.environ.get("ANEMOMETER_CONTROL_KEY", "").strip()
+if key and not re.fullmatch(r"[0-9A-Fa-f]{32}", key):
+    raise SystemExit("ANEMOMETER_CONTROL_KEY must be 32 hex digits")
+if key:
+    env.Append(CPPDEFINES=[("CONTROL_KEY_HEX", env.StringifyMacro(key))])  # noqa: F821
+else:
+    print("ANEMOMETER_CONTROL_KEY not set: control channel off in this build")
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# Copyright (C) 2025 Philippe Hubert
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Decode binary sample recordings (RECnnnnn.BIN) to CSV or Parquet.
+
+The format is described in include/RecordingFormat.h. Files of the same session
+are concatenated in part order; decoding of a file stops at the first sector that
+fails its magic, index or CRC check (end of the written data).
+
+    tools/decode_recording.py REC00012.BIN REC00013.BIN -o session12.csv
+    tools/decode_recording.py REC00012.BIN --parquet session12.parquet   (needs pyarrow)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+SECTOR_SIZE = 512
+RECORD_SIZE = 8
+SECTOR_HEADER_SIZE = 16
+RECORDS_PER_SECTOR = (SECTOR_SIZE - SECTOR_HEADER_SIZE) // RECORD_SIZE
+FILE_MAGIC = b"OSRCREC\0"
+SECTOR_MAGIC = 0x4452534F
+VERSION = 1
+
+COLUMNS = ["timestamp_ms", "code", "millivolts", "wind_speed_ms", "dropped_before", "session", "part"]
+
+
+def read_header(sector):
+    """Parse the file header sector, None if invalid."""
+    if sector[:8] != FILE_MAGIC or zlib.crc32(sector[:508]) != struct.unpack_from("<I", sector, 508)[0]:
+        return None
+    version, sector_size, record_size, rate, session, part, start_ms = struct.unpack_from("<HHHHIII", sector, 8)
+    if version != VERSION or sector_size != SECTOR_SIZE or record_size != RECORD_SIZE:
+        return None
+    points = sector[40]
+    return {
+        "sample_rate": rate,
+        "session": session,
+        "part": part,
+        "start_ms": start_ms,
+        "mac": ":".join("%02X" % b for b in sector[28:34]),
+        "mv_per_code": struct.unpack_from("<f", sector, 36)[0],
+        "curve_mv": list(struct.unpack_from("<%df" % points, sector, 44)),
+        "curve_kmh": list(struct.unpack_from("<%df" % points, sector, 108)),
+    }
+
+
+def sector_valid(sector, session, index):
+    magic, sector_index, count = struct.unpack_from("<IIH", sector, 0)
+    if magic != SECTOR_MAGIC or sector_index != index or count > RECORDS_PER_SECTOR:
+        return False
+    crc = zlib.crc32(struct.pack("<I", session))
+    crc = zlib.crc32(sector[:12] + b"\0\0\0\0" + sector[16:], crc)
+    return crc == struct.unpack_from("<I", sector, 12)[0]
+
+
+def decode_file(path):
+    """Decode one file: (header, sector count, rows, trailing drops); rows follow COLUMNS."""
+    with open(path, "rb") as f:
+        header = read_header(f.read(SECTOR_SIZE))
+        if header is None:
+            raise ValueError("%s: not a recording (bad header)" % path)
+        scale = header["mv_per_code"]
+        rows = []
+        carried = 0  # Drops stamped in sectors without records, reported on the next record
+        index = 1
+        while True:
+            sector = f.read(SECTOR_SIZE)
+            if len(sector) < SECTOR_SIZE or not sector_valid(sector, header["session"], index):
+                break
+            count, dropped = struct.unpack_from("<HH", sector, 8)
+            carried += dropped
+            for i in range(count):
+                timestamp, code, speed = struct.unpack_from("<IhH", sector, SECTOR_HEADER_SIZE + i * RECORD_SIZE)
+                rows.append((timestamp, code, round(code * scale, 3), speed / 100.0, carried,
+                             header["session"], header["part"]))
+                carried = 0
+            index += 1
+        return header, index - 1, rows, carried
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+", help="RECnnnnn.BIN files (one session, any order)")
+    parser.add_argument("-o", "--output", help="CSV output (default: stdout)")
+    parser.add_argument("--parquet", help="Parquet output instead of CSV (requires pyarrow)")
+    args = parser.parse_args()
+
+    decoded = []
+    for path in args.files:
+        try:
+            header, sectors, rows, trailing = decode_file(path)
+        except (OSError, ValueError) as error:
+            print(error, file=sys.stderr)
+            return 1
+        print("%s: session %d part %d, %s, %d SPS, %d sectors, %d samples, %d dropped at the end" %
+              (path, header["session"], header["part"], header["mac"], header["sample_rate"], sectors, len(rows),
+               trailing), file=sys.stderr)
+        decoded.append((header["session"], header["part"], rows))
+    decoded.sort(key=lambda item: (item[0], item[1]))
+    rows = [row for _, _, file_rows in decoded for row in file_rows]
+
+    if args.parquet:
+        try:
+            import pyarrow as pa
+            import pyarrow.parquet as pq
+        except ImportError:
+            print("Parquet output needs pyarrow (pip install pyarrow)", file=sys.stderr)
+            return 1
+        table = pa.table({name: [row[i] for row in rows] for i, name in enumerate(COLUMNS)})
+        pq.write_table(table, args.parquet)
+        return 0
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(COLUMNS)
+    writer.writerows(rows)
+    if args.output:
+        out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Copyright (C) 2025 Philippe Hubert
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Reference spectrum for the TurbulenceAnalyzer check of the `turbulence` host command.
+
+Builds the same synthetic wind as src/host/TurbulenceBench.cpp (8 m/s mean, slow
+rise, gusts at 0.10 and 0.35 Hz, xorshift32 noise), analyses it with NumPy the way
+the analyzer does (linear detrend, periodic Hann window, rfft, one-sided PSD,
+parabolic peak in the gust band) and prints the C++ table to paste into the bench.
+
+    tools/turbulence_reference.py > /tmp/reference.inc
+"""
+
+import numpy as np
+
+FFT_SIZE = 512
+SAMPLE_RATE = 8.0
+MIN_FREQUENCY = 0.02
+MAX_FREQUENCY = 1.0
+CHECKED_BINS = [0, 1, 2, 5, 6, 7, 8, 20, 22, 23, 24, 40, 100, 256]
+
+
+def xorshift32(state):
+    state ^= (state << 13) & 0xFFFFFFFF
+    state ^= state >> 17
+    state ^= (state << 5) & 0xFFFFFFFF
+    return state
+
+
+def signal():
+    """Synthetic wind, rounded to float32 as the analyzer receives it."""
+    samples = np.empty(FFT_SIZE)
+    state = 0x2545F491
+    for n in range(FFT_SIZE):
+        state = xorshift32(state)
+        noise = state / 4294967296.0 - 0.5
+        t = n / SAMPLE_RATE
+        samples[n] = (8.0 + 0.002 * n + 1.5 * np.sin(2 * np.pi * 0.10 * t)
+                      + 0.8 * np.sin(2 * np.pi * 0.35 * t + 1.0) + 0.6 * noise)
+    return samples.astype(np.float32).astype(np.float64)
+
+
+def analyse(samples):
+    n = np.arange(FFT_SIZE)
+    mean = samples.mean()
+    stddev = samples.std()
+    slope, intercept = np.polyfit(n, samples, 1)
+    window = 0.5 - 0.5 * np.cos(2 * np.pi * n / FFT_SIZE)
+    spectrum = np.fft.rfft((samples - (slope * n + intercept)) * window)
+    power = np.abs(spectrum) ** 2 / (SAMPLE_RATE * np.sum(window ** 2))
+    power[1:-1] *= 2
+    width = SAMPLE_RATE / FFT_SIZE
+    first = max(1, int(np.ceil(MIN_FREQUENCY / width)))
+    last = min(int(MAX_FREQUENCY / width), len(power) - 2)
+    peak = first + int(np.argmax(power[first:last + 1]))
+    left, centre, right = power[peak - 1:peak + 2]
+    offset = 0.5 * (left - right) / (left - 2 * centre + right)
+    return mean, stddev, power, (peak + offset) * width
+
+
+def main():
+    mean, stddev, power, gust = analyse(signal())
+    print("// Generated by tools/turbulence_reference.py (NumPy %s)" % np.__version__)
+    print("static const float REFERENCE_MEAN = %.7gf;" % mean)
+    print("static const float REFERENCE_STDDEV = %.7gf;" % stddev)
+    print("static const float REFERENCE_INTENSITY = %.7gf;" % (stddev / mean))
+    print("static const float REFERENCE_GUST_HZ = %.7gf;" % gust)
+    print("static const ReferenceBin REFERENCE_BINS[] = {")
+    for k in CHECKED_BINS:
+        print("    {%d, %.7gf}," % (k, power[k]))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()